@@ -80,7 +80,9 @@ void vaBenchmarkTool::Tick( float deltaTime )
 
         for( size_t i = 0; i < m_sampleCache.size(); i++ )
         {
-            m_currentMetricsSampleLog[i].push_back( m_sampleCache[i] );
+            if( m_currentRun.KeepSamples )
+                m_currentMetricsSampleLog[i].push_back( m_sampleCache[i] );
+            m_currentMetricsStatistics[i].Add( m_sampleCache[i] );
         }
 
         m_currentSampleCount++;
@@ -109,8 +111,19 @@ void vaBenchmarkTool::StartNextOrStop( )
 
 
         m_sampleCache.resize( m_currentRun.MetricNames.size() );
-        m_avgMinMaxCache.resize( m_currentRun.MetricNames.size() );
+        m_statisticsCache.resize( m_currentRun.MetricNames.size() );
         m_currentMetricsSampleLog.resize( m_currentRun.MetricNames.size() );
+        m_currentMetricsStatistics.resize( m_currentRun.MetricNames.size() );
+        for( size_t i = 0; i < m_currentMetricsStatistics.size(); i++ )
+        {
+            vaStreamingStatistics::Settings settings;
+            settings.Budget             = ( i < m_currentRun.MetricBudgets.size() )?( m_currentRun.MetricBudgets[i] ):( 0.0 );
+            settings.WarmupSampleCount  = m_currentRun.WarmupSampleCount;
+            settings.WarmupOutlierMADs  = m_currentRun.WarmupOutlierMADs;
+            m_currentMetricsStatistics[i].Reset( settings );
+            if( m_currentRun.KeepSamples )
+                m_currentMetricsSampleLog[i].reserve( m_currentRun.SamplingTotalCount );
+        }
     }
 }
 
@@ -121,31 +134,40 @@ void vaBenchmarkTool::FinishCurrent( )
 
     if( !incorrectSampleCount )
     { 
-        // calculate average/min/mag!
-        for( size_t i = 0; i < m_avgMinMaxCache.size(); i++ )
+        // gather statistics
+        for( size_t i = 0; i < m_statisticsCache.size(); i++ )
         {
-            m_avgMinMaxCache[i].Average = 0.0f;
-            m_avgMinMaxCache[i].Minimum = VA_FLOAT_HIGHEST;
-            m_avgMinMaxCache[i].Maximum = VA_FLOAT_LOWEST;
-            assert( m_currentMetricsSampleLog[i].size() == m_currentSampleCount );
-            if( m_currentMetricsSampleLog[i].size() != m_currentSampleCount )
-            {
-                incorrectSampleCount = true;
-                break;
-            }
-            for( size_t j = 0; j < m_currentMetricsSampleLog[i].size(); j++ )
+            if( m_currentRun.KeepSamples )
             {
-                m_avgMinMaxCache[i].Average += m_currentMetricsSampleLog[i][j];
-                m_avgMinMaxCache[i].Minimum = vaMath::Min( m_avgMinMaxCache[i].Minimum, m_currentMetricsSampleLog[i][j] );
-                m_avgMinMaxCache[i].Maximum = vaMath::Max( m_avgMinMaxCache[i].Maximum, m_currentMetricsSampleLog[i][j] );
+                assert( m_currentMetricsSampleLog[i].size() == m_currentSampleCount );
+                if( m_currentMetricsSampleLog[i].size() != m_currentSampleCount )
+                {
+                    incorrectSampleCount = true;
+                    break;
+                }
             }
-            m_avgMinMaxCache[i].Average /= (float)m_currentSampleCount;
+
+            vaStreamingStatistics & stats = m_currentMetricsStatistics[i];
+            stats.FlushWarmup( );
+
+            MetricStatistics & out = m_statisticsCache[i];
+            out.Average         = (float)stats.GetMean( );
+            out.Minimum         = (float)stats.GetMin( );
+            out.Maximum         = (float)stats.GetMax( );
+            out.StdDev          = (float)stats.GetStdDev( );
+            out.P50             = (float)stats.GetPercentile( vaStreamingStatistics::P50 );
+            out.P90             = (float)stats.GetPercentile( vaStreamingStatistics::P90 );
+            out.P99             = (float)stats.GetPercentile( vaStreamingStatistics::P99 );
+            out.P999            = (float)stats.GetPercentile( vaStreamingStatistics::P999 );
+            out.OverBudgetCount = (int)stats.GetOverBudgetCount( );
+            out.SampleCount     = (int)stats.GetCount( );
+            out.RejectedCount   = (int)stats.GetRejectedCount( );
         }
     }
 
     // report results
     if( !incorrectSampleCount )
-        m_currentRun.FinishedCallback( m_currentRun, m_currentRunIndex, (int)m_benchmarkRuns.size(), m_currentMetricsSampleLog, m_avgMinMaxCache );
+        m_currentRun.FinishedCallback( m_currentRun, m_currentRunIndex, (int)m_benchmarkRuns.size(), m_currentMetricsSampleLog, m_statisticsCache );
 
     m_currentRun            = RunDefinition();
     m_timeFromStart         = 0.0f;
@@ -153,6 +175,7 @@ void vaBenchmarkTool::FinishCurrent( )
     m_currentRunSetupDone   = false;
     m_sampleCache.clear();
     m_currentMetricsSampleLog.clear();
+    m_currentMetricsStatistics.clear();
 }
 
 void vaBenchmarkTool::Stop( )
@@ -168,7 +191,7 @@ void vaBenchmarkTool::Stop( )
     m_active                = false;
 }
 
-void vaBenchmarkTool::WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector<std::vector<float>>& metricsSamples, const std::vector<AverageMinMax>& metricsAverages )
+void vaBenchmarkTool::WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector<std::vector<float>>& metricsSamples, const std::vector<MetricStatistics>& metricsStatistics )
 {
     vaFileStream outFile;
     outFile.Open( fileName, (append)?(FileCreationMode::Append):(FileCreationMode::Create) );
@@ -197,9 +220,9 @@ void vaBenchmarkTool::WriteResultsCSV( const wstring & fileName, bool append, co
     outFile.WriteTXT( "\r\n" );
 
     // all samples
-    if( metricsSamples.size() > 0 )
+    if( metricsSamples.size() > 0 && metricsSamples[0].size() > 0 )
     {
-        for( int j = 0; j < runDef.SamplingTotalCount; j++ )
+        for( int j = 0; j < (int)metricsSamples[0].size(); j++ )
         {
             outFile.WriteTXT( vaStringTools::Format( "%05d,      ", j ) );
             for( size_t i = 0; i < metricsSamples.size(); i++ )
@@ -209,19 +232,27 @@ void vaBenchmarkTool::WriteResultsCSV( const wstring & fileName, bool append, co
         }
     }
 
-    // averages
-    if( metricsAverages.size() > 0 )
+    // statistics
+    if( metricsStatistics.size() > 0 )
     { 
-        outFile.WriteTXT( "averages, " );
-        for( size_t i = 0; i < metricsAverages.size(); i++ )
-            outFile.WriteTXT( vaStringTools::Format( "%.2f, ", metricsAverages[i].Average ) );
-        outFile.WriteTXT( "\r\n minimums, " );
-        for( size_t i = 0; i < metricsAverages.size(); i++ )
-            outFile.WriteTXT( vaStringTools::Format( "%.2f, ", metricsAverages[i].Minimum ) );
-        outFile.WriteTXT( "\r\n maximums, " );
-        for( size_t i = 0; i < metricsAverages.size(); i++ )
-            outFile.WriteTXT( vaStringTools::Format( "%.2f, ", metricsAverages[i].Maximum ) );
-        outFile.WriteTXT( "\r\n" );
+        auto writeRow = [&]( const char * title, const char * format, std::function<float( const MetricStatistics & )> getter )
+        {
+            outFile.WriteTXT( title );
+            for( size_t i = 0; i < metricsStatistics.size(); i++ )
+                outFile.WriteTXT( vaStringTools::Format( format, getter( metricsStatistics[i] ) ) );
+            outFile.WriteTXT( "\r\n" );
+        };
+        writeRow( "averages, ",         "%.2f, ", [ ]( const MetricStatistics & s ) { return s.Average; } );
+        writeRow( " minimums, ",        "%.2f, ", [ ]( const MetricStatistics & s ) { return s.Minimum; } );
+        writeRow( " maximums, ",        "%.2f, ", [ ]( const MetricStatistics & s ) { return s.Maximum; } );
+        writeRow( " std devs, ",        "%.3f, ", [ ]( const MetricStatistics & s ) { return s.StdDev; } );
+        writeRow( " P50, ",             "%.2f, ", [ ]( const MetricStatistics & s ) { return s.P50; } );
+        writeRow( " P90, ",             "%.2f, ", [ ]( const MetricStatistics & s ) { return s.P90; } );
+        writeRow( " P99, ",             "%.2f, ", [ ]( const MetricStatistics & s ) { return s.P99; } );
+        writeRow( " P99.9, ",           "%.2f, ", [ ]( const MetricStatistics & s ) { return s.P999; } );
+        writeRow( " over budget, ",     "%.0f, ", [ ]( const MetricStatistics & s ) { return (float)s.OverBudgetCount; } );
+        writeRow( " samples, ",         "%.0f, ", [ ]( const MetricStatistics & s ) { return (float)s.SampleCount; } );
+        writeRow( " rejected warmup, ", "%.0f, ", [ ]( const MetricStatistics & s ) { return (float)s.RejectedCount; } );
     }
 
     //outFile.WriteTXT( )
@@ -22,6 +22,8 @@
 #include "..\vaCore.h"
 #include "..\vaSingleton.h"
 
+#include "vaStatistics.h"
+
 #include <ctime>
 
 namespace Vanilla
@@ -37,6 +39,19 @@ namespace Vanilla
             float                           Maximum;
         };
 
+        // Everything in here is computed incrementally (see vaStreamingStatistics) so it doesn't require the raw sample log.
+        struct MetricStatistics : AverageMinMax
+        {
+            float                           StdDev;
+            float                           P50;
+            float                           P90;
+            float                           P99;
+            float                           P999;
+            int                             OverBudgetCount;                    // samples above RunDefinition::MetricBudgets[i] (0 if no budget set)
+            int                             SampleCount;                        // samples used, excluding rejected warm-up ones
+            int                             RejectedCount;                      // warm-up samples rejected as outliers (or all warm-up samples if WarmupOutlierMADs <= 0)
+        };
+
         struct RunDefinition
         {
             std::string                                                         Name;
@@ -46,15 +61,25 @@ namespace Vanilla
             int                                                                 SamplingTotalCount;
             float                                                               DelayStartTime;
             std::vector<std::string>                                            MetricNames;
+            std::vector<float>                                                  MetricBudgets;          // optional, per metric; samples above budget are counted in MetricStatistics::OverBudgetCount (<= 0 or missing to disable)
+
+            // the first WarmupSampleCount samples of each metric are checked for outliers (further than WarmupOutlierMADs median
+            // absolute deviations from their median) which are then rejected; WarmupOutlierMADs <= 0 rejects all warm-up samples
+            int                                                                 WarmupSampleCount;
+            float                                                               WarmupOutlierMADs;
+
+            // keep every sample (for the CSV sample dump and FinishedCallback); statistics are computed without them so this
+            // can be disabled for long runs
+            bool                                                                KeepSamples;
 
             std::function< void( const RunDefinition & ) >                      SettingsSetupCallback;
             std::function< void( const RunDefinition &, std::vector<float> & ) >  
                                                                                 CollectSamplesCallback;
-            // finished run info, finished run index, total run count, finished run samples, finished run averaged samples
-            std::function< void( const RunDefinition &, int, int, const std::vector< std::vector<float> > &, const std::vector<AverageMinMax> & ) > 
+            // finished run info, finished run index, total run count, finished run samples (empty if !KeepSamples), finished run statistics
+            std::function< void( const RunDefinition &, int, int, const std::vector< std::vector<float> > &, const std::vector<MetricStatistics> & ) > 
                                                                                 FinishedCallback;
 
-            RunDefinition( ) { SamplingPeriod = 0.0f; SamplingTotalCount = 0; DelayStartTime = 1.0f; }
+            RunDefinition( ) { SamplingPeriod = 0.0f; SamplingTotalCount = 0; DelayStartTime = 1.0f; WarmupSampleCount = 0; WarmupOutlierMADs = 0.0f; KeepSamples = true; }
 
         };
 
@@ -68,7 +93,8 @@ namespace Vanilla
         bool                                m_currentRunSetupDone;
         std::vector< float >                m_sampleCache;
         std::vector< std::vector<float> >   m_currentMetricsSampleLog;
-        std::vector< AverageMinMax >        m_avgMinMaxCache;
+        std::vector< vaStreamingStatistics > m_currentMetricsStatistics;
+        std::vector< MetricStatistics >     m_statisticsCache;
 
         std::time_t                         m_runStartTime;
 
@@ -93,7 +119,7 @@ namespace Vanilla
 
         float                                               GetRemainingBenchmarkTime( )                { return m_currentRun.SamplingPeriod * m_currentRun.SamplingTotalCount - m_timeFromStart; }
 
-        static void                                         WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector< std::vector<float> > & metricsSamples, const std::vector<AverageMinMax> & metricsAverages );
+        static void                                         WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector< std::vector<float> > & metricsSamples, const std::vector<MetricStatistics> & metricsStatistics );
 
     protected:
         void                                                StartNextOrStop( );
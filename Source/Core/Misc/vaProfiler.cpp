@@ -81,6 +81,7 @@ std::mutex                                                              vaTracer
 //std::map< std::thread::id, std::weak_ptr<vaTracer::ThreadContext> >     vaTracer::s_threadContexts;
 std::vector< std::weak_ptr<vaTracer::ThreadContext> >                   vaTracer::s_threadContexts;
 std::weak_ptr<vaTracer::ThreadContext>                                  vaTracer::s_mainThreadContext;
+std::map< string, unique_ptr<vaTracer::Counter> >                       vaTracer::s_counters;
 
 vaTracer::ThreadContext::ThreadContext( const char * name, const std::thread::id & threadID, bool automaticFrameIncrement ) : Name( name ), ThreadID( threadID ), AutomaticFrameIncrement( automaticFrameIncrement )
 {
@@ -116,6 +117,47 @@ void vaTracer::DumpChromeTracingReportToFile( double duration, bool reset )
     VA_LOG_SUCCESS( "Tracing report written to '%s' - to view open Chrome tab, navigate to 'chrome://tracing/' and drag & drop file into it", traceFile.c_str( ) );
 }
 
+struct vaTracer::Counter
+{
+    std::mutex                                          Mutex;
+    std::array<CounterSample, c_counterCapacity>        Samples;            // ring buffer, secured with Mutex
+    int                                                 First   = 0;
+    int                                                 Count   = 0;
+
+    // copy out (oldest first) and optionally clear; caller holds Mutex
+    void                                                Capture( std::deque<CounterSample> & outSamples, bool reset )
+    {
+        for( int i = 0; i < Count; i++ )
+            outSamples.push_back( Samples[(First + i) % c_counterCapacity] );
+        if( reset )
+        { First = 0; Count = 0; }
+    }
+};
+
+vaTracer::Counter * vaTracer::FindOrCreateCounter( const char * name )
+{
+    std::lock_guard<std::mutex> lock( s_globalMutex );
+    unique_ptr<Counter> & counter = s_counters[name];
+    if( counter == nullptr )
+        counter = std::make_unique<Counter>( );
+    return counter.get( );
+}
+
+void vaTracer::AddCounterSample( Counter * counter, double value )
+{
+    assert( counter != nullptr );
+    auto now = vaCore::TimeFromAppStart( );
+
+    std::lock_guard<std::mutex> lock( counter->Mutex );
+    if( counter->Count == c_counterCapacity )
+    {
+        counter->First = ( counter->First + 1 ) % c_counterCapacity;
+        counter->Count--;
+    }
+    counter->Samples[( counter->First + counter->Count ) % c_counterCapacity] = { now, value };
+    counter->Count++;
+}
+
 string vaTracer::CreateChromeTracingReport( double duration, bool reset )
 {
     VA_TRACE_CPU_SCOPE( vaTracer_DumpJSONReport );
@@ -126,10 +168,16 @@ string vaTracer::CreateChromeTracingReport( double duration, bool reset )
         std::deque<Entry>       Timeline;
     };
     std::list<ThreadData> threadsData;
+    std::map< string, std::deque<CounterSample> > countersData;
 
     // collect all threads data
     {
         std::lock_guard<std::mutex> lock( s_globalMutex ); // nobody can create thread contexts anymore
+        for( auto & it : s_counters )
+        {
+            std::lock_guard<std::mutex> counterLock( it.second->Mutex );
+            it.second->Capture( countersData[it.first], reset );
+        }
         for( auto it = s_threadContexts.begin( ); it != s_threadContexts.end( ); )
         {
             std::shared_ptr<ThreadContext> context = it->lock();
@@ -204,6 +252,28 @@ string vaTracer::CreateChromeTracingReport( double duration, bool reset )
                 os << '}';
         }
     }
+
+    // counters go after all threads (they're not tied to any)
+    for( auto counterIt = countersData.begin( ); counterIt != countersData.end( ); counterIt++ )
+    {
+        for( const CounterSample & sample : counterIt->second )
+        {
+            if( sample.Time < oldest )
+                continue;
+            if( nextRequiresSeparator )
+                os << ',';
+            nextRequiresSeparator = true;
+
+            os << '{'
+               << "\"cat\":\"va\","
+               << "\"name\":\"" << counterIt->first << "\","
+               << "\"ph\":\"C\","
+               << "\"pid\":1,"
+               << "\"ts\":" << double( (sample.Time - now)*1000000.0 ) << ','
+               << "\"args\":{\"value\":" << sample.Value << '}'
+               << '}';
+        }
+    }
     os << "]\n";
 
     return os.str();
@@ -253,6 +323,12 @@ void vaTracer::Cleanup( bool soft )
             s_mainThreadContext.reset();
             s_threadContexts.clear( );
             s_threadContexts.shrink_to_fit();
+            // counters are only emptied - whoever looked them up can keep sampling through their pointers
+            for( auto & it : s_counters )
+            {
+                std::lock_guard<std::mutex> counterLock( it.second->Mutex );
+                it.second->First = 0; it.second->Count = 0;
+            }
         }
         m_UI_ProfilingThreadNames.clear( );
         m_UI_ProfilingThreadNames.shrink_to_fit( );
@@ -136,7 +136,20 @@ namespace Vanilla
                std::vector< std::weak_ptr<ThreadContext> >
                                                                 s_threadContexts;
         static weak_ptr<ThreadContext>                          s_mainThreadContext;
+
+    public:
+        // counter track handle (opaque); see FindOrCreateCounter
+        struct Counter;
+
+    private:
+        struct CounterSample
+        {
+            double                                              Time;
+            double                                              Value;
+        };
+        static std::map< string, unique_ptr<Counter> >          s_counters;             // secured with s_globalMutex; never erased from so Counter pointers stay valid
         static constexpr double                                 c_maxCaptureDuration  = 5.0; // 5 seconds
+        static constexpr int                                    c_counterCapacity     = 4096; // samples kept per counter (ring buffer)
 //
 //        static thread_local shared_ptr<Thread>                  s_threads;
 
@@ -186,6 +199,13 @@ namespace Vanilla
             return retContext;
         }
 
+        // look up a counter once and keep the pointer (it's valid until the app exits) - sampling through it doesn't take the global lock or allocate
+        static Counter *                                        FindOrCreateCounter( const char * name );
+
+        // record a value over time (for ex. queue depth) - shows up as a graph in the chrome://tracing report; can be called from any thread
+        static void                                             AddCounterSample( Counter * counter, double value );
+        static void                                             AddCounterSample( const char * name, double value )     { AddCounterSample( FindOrCreateCounter( name ), value ); }
+
         static void                                             DumpChromeTracingReportToFile( double duration = c_maxCaptureDuration, bool reset = true );
         static string                                           CreateChromeTracingReport( double duration = c_maxCaptureDuration, bool reset = true );
         static void                                             ListAllThreadNames( vector<string> & outNames );
@@ -283,6 +283,35 @@ int vaResourceFormatHelpers::GetPixelSizeInBytes( vaResourceFormat val )
     return 0;
 }
 
+int vaResourceFormatHelpers::GetBlockSizeInBytes( vaResourceFormat val )
+{
+    switch( val )
+    {
+    case Vanilla::vaResourceFormat::BC1_TYPELESS:               return 8;
+    case Vanilla::vaResourceFormat::BC1_UNORM:                  return 8;
+    case Vanilla::vaResourceFormat::BC1_UNORM_SRGB:             return 8;
+    case Vanilla::vaResourceFormat::BC2_TYPELESS:               return 16;
+    case Vanilla::vaResourceFormat::BC2_UNORM:                  return 16;
+    case Vanilla::vaResourceFormat::BC2_UNORM_SRGB:             return 16;
+    case Vanilla::vaResourceFormat::BC3_TYPELESS:               return 16;
+    case Vanilla::vaResourceFormat::BC3_UNORM:                  return 16;
+    case Vanilla::vaResourceFormat::BC3_UNORM_SRGB:             return 16;
+    case Vanilla::vaResourceFormat::BC4_TYPELESS:               return 8;
+    case Vanilla::vaResourceFormat::BC4_UNORM:                  return 8;
+    case Vanilla::vaResourceFormat::BC4_SNORM:                  return 8;
+    case Vanilla::vaResourceFormat::BC5_TYPELESS:               return 16;
+    case Vanilla::vaResourceFormat::BC5_UNORM:                  return 16;
+    case Vanilla::vaResourceFormat::BC5_SNORM:                  return 16;
+    case Vanilla::vaResourceFormat::BC6H_TYPELESS:              return 16;
+    case Vanilla::vaResourceFormat::BC6H_UF16:                  return 16;
+    case Vanilla::vaResourceFormat::BC6H_SF16:                  return 16;
+    case Vanilla::vaResourceFormat::BC7_TYPELESS:               return 16;
+    case Vanilla::vaResourceFormat::BC7_UNORM:                  return 16;
+    case Vanilla::vaResourceFormat::BC7_UNORM_SRGB:             return 16;
+    default: return 0; break;
+    }
+}
+
 bool vaResourceFormatHelpers::IsTypeless( vaResourceFormat val )
 {
     switch( val )
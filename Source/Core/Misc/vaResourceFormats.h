@@ -183,6 +183,7 @@ namespace Vanilla
     public:
         static string               EnumToString( vaResourceFormat val );
         static int                  GetPixelSizeInBytes( vaResourceFormat val );
+        static int                  GetBlockSizeInBytes( vaResourceFormat val );     // size of a 4x4 block for block compressed (BCn) formats, 0 for all others
         static int                  GetChannelCount( vaResourceFormat val );
         static bool                 HasAlphaChannel( vaResourceFormat val );
         static bool                 IsTypeless( vaResourceFormat val );
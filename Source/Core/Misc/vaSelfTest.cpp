@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaSelfTest.h"
+
+#include "..\vaCore.h"
+#include "..\vaLog.h"
+
+using namespace Vanilla;
+
+int vaSelfTest::RunAll( const std::vector<Entry> & tests )
+{
+    int failedCount = 0;
+    for( const Entry & entry : tests )
+    {
+        std::string info;
+        if( entry.Test( &info ) )
+            VA_LOG_SUCCESS( "Self test '%s' passed: %s", entry.Name.c_str( ), info.c_str( ) );
+        else
+        {
+            VA_LOG_WARNING( "Self test '%s' FAILED: %s", entry.Name.c_str( ), info.c_str( ) );
+            failedCount++;
+        }
+    }
+    if( failedCount == 0 )
+        VA_LOG_SUCCESS( "All %d self tests passed", (int)tests.size( ) );
+    else
+        VA_LOG_WARNING( "%d of %d self tests failed", failedCount, (int)tests.size( ) );
+    return failedCount;
+}
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// Plumbing shared by the in-app self tests: static functions that run a module on known inputs, check the known answers and
+// return false with the first failure described in outInfo. Like vaStatistics, no dependencies outside of the standard
+// library so that any module can use it; only RunAll (which logs) lives in the .cpp.
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace Vanilla
+{
+    class vaSelfTest
+    {
+    public:
+        typedef std::function<bool( std::string * outInfo )>   Function;
+
+        struct Entry
+        {
+            std::string                         Name;
+            Function                            Test;
+        };
+
+    public:
+        // 'return vaSelfTest::Fail( outInfo, ... );' on the first failed check
+        static bool                             Fail( std::string * outInfo, const std::string & info )                 { if( outInfo != nullptr ) *outInfo = info; return false; }
+
+        // 'return vaSelfTest::Pass( outInfo );' once everything checked out
+        static bool                             Pass( std::string * outInfo, const std::string & info = "all OK" )     { if( outInfo != nullptr ) *outInfo = info; return true; }
+
+        // Runs all tests in order and logs each result; returns the number of failed ones. The list is put together by the
+        // application (which links all modules) so there is only one place to run them from.
+        static int                              RunAll( const std::vector<Entry> & tests );
+    };
+
+}
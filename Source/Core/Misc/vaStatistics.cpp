@@ -0,0 +1,461 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaStatistics.h"
+#include "vaSelfTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <cstdio>
+#include <numeric>
+
+using namespace Vanilla;
+
+void vaStreamingQuantile::Reset( double p )
+{
+    assert( p >= 0.0 && p <= 1.0 );
+    m_p     = p;
+    m_count = 0;
+    for( int i = 0; i < 5; i++ )
+        m_heights[i] = m_positions[i] = m_desired[i] = m_increments[i] = 0.0;
+}
+
+void vaStreamingQuantile::Add( double x )
+{
+    // first 5 samples are just collected
+    if( m_count < 5 )
+    {
+        m_heights[m_count++] = x;
+        if( m_count == 5 )
+        {
+            std::sort( m_heights, m_heights + 5 );
+            for( int i = 0; i < 5; i++ )
+                m_positions[i] = (double)i;
+            m_desired[0] = 0.0;             m_increments[0] = 0.0;
+            m_desired[1] = 2.0 * m_p;       m_increments[1] = m_p * 0.5;
+            m_desired[2] = 4.0 * m_p;       m_increments[2] = m_p;
+            m_desired[3] = 2.0 + 2.0 * m_p; m_increments[3] = ( 1.0 + m_p ) * 0.5;
+            m_desired[4] = 4.0;             m_increments[4] = 1.0;
+        }
+        return;
+    }
+    m_count++;
+
+    // find the cell the sample falls into, adjusting the extreme markers if needed
+    int k;
+    if( x < m_heights[0] )
+    {
+        m_heights[0] = x;
+        k = 0;
+    }
+    else if( x >= m_heights[4] )
+    {
+        m_heights[4] = x;
+        k = 3;
+    }
+    else
+    {
+        k = 0;
+        while( k < 3 && x >= m_heights[k + 1] )
+            k++;
+    }
+
+    for( int i = k + 1; i < 5; i++ )
+        m_positions[i] += 1.0;
+    for( int i = 0; i < 5; i++ )
+        m_desired[i] += m_increments[i];
+
+    // adjust the middle markers if they're off their desired positions
+    for( int i = 1; i < 4; i++ )
+    {
+        const double d = m_desired[i] - m_positions[i];
+        if( ( d >= 1.0 && m_positions[i + 1] - m_positions[i] > 1.0 ) || ( d <= -1.0 && m_positions[i - 1] - m_positions[i] < -1.0 ) )
+        {
+            const int sign = ( d >= 0.0 ) ? ( 1 ) : ( -1 );
+            const double candidate = Parabolic( i, (double)sign );
+            if( m_heights[i - 1] < candidate && candidate < m_heights[i + 1] )
+                m_heights[i] = candidate;
+            else
+                m_heights[i] = Linear( i, sign );
+            m_positions[i] += (double)sign;
+        }
+    }
+}
+
+double vaStreamingQuantile::Parabolic( int i, double d ) const
+{
+    const double * q = m_heights;
+    const double * n = m_positions;
+    return q[i] + d / ( n[i + 1] - n[i - 1] ) * ( ( n[i] - n[i - 1] + d ) * ( q[i + 1] - q[i] ) / ( n[i + 1] - n[i] ) + ( n[i + 1] - n[i] - d ) * ( q[i] - q[i - 1] ) / ( n[i] - n[i - 1] ) );
+}
+
+double vaStreamingQuantile::Linear( int i, int d ) const
+{
+    return m_heights[i] + d * ( m_heights[i + d] - m_heights[i] ) / ( m_positions[i + d] - m_positions[i] );
+}
+
+double vaStreamingQuantile::Get( ) const
+{
+    if( m_count == 0 )
+        return 0.0;
+    if( m_count >= 5 )
+        return m_heights[2];
+
+    // exact (linearly interpolated) for the first few
+    const int count = (int)m_count;
+    double sorted[5];
+    for( int i = 0; i < count; i++ )
+    {
+        // insertion sort, there's at most 4
+        int j = i;
+        for( ; j > 0 && sorted[j - 1] > m_heights[i]; j-- )
+            sorted[j] = sorted[j - 1];
+        sorted[j] = m_heights[i];
+    }
+    const double pos = m_p * (double)( count - 1 );
+    const int lo = (int)std::floor( pos );
+    const int hi = std::min( lo + 1, count - 1 );
+    return sorted[lo] + ( sorted[hi] - sorted[lo] ) * ( pos - (double)lo );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double vaStreamingStatistics::GetPercentileP( Percentile which )
+{
+    static const double c_percentiles[PercentileCount] = { 0.5, 0.9, 0.99, 0.999 };
+    assert( which >= 0 && which < PercentileCount );
+    return c_percentiles[which];
+}
+
+void vaStreamingStatistics::Reset( const Settings & settings )
+{
+    m_settings          = settings;
+    m_count             = 0;
+    m_mean              = 0.0;
+    m_m2                = 0.0;
+    m_min               = 0.0;
+    m_max               = 0.0;
+    m_overBudgetCount   = 0;
+    m_rejectedCount     = 0;
+    for( int i = 0; i < PercentileCount; i++ )
+        m_percentiles[i].Reset( GetPercentileP( (Percentile)i ) );
+    m_warmup.clear( );
+    m_warmup.reserve( std::max( 0, settings.WarmupSampleCount ) );
+    m_warmupDone        = settings.WarmupSampleCount <= 0;
+}
+
+void vaStreamingStatistics::Add( double x )
+{
+    if( !m_warmupDone )
+    {
+        m_warmup.push_back( x );
+        if( (int)m_warmup.size( ) >= m_settings.WarmupSampleCount )
+            FlushWarmup( );
+        return;
+    }
+    AddAccepted( x );
+}
+
+void vaStreamingStatistics::FlushWarmup( )
+{
+    if( m_warmupDone )
+        return;
+    m_warmupDone = true;
+
+    if( m_settings.WarmupOutlierMADs <= 0.0 || m_warmup.size( ) == 0 )
+    {
+        m_rejectedCount += (int64_t)m_warmup.size( );
+    }
+    else
+    {
+        // median and median absolute deviation of the warm-up samples
+        const double warmupMedian = vaABComparison::Median( m_warmup );
+        std::vector<double> deviations( m_warmup.size( ) );
+        for( size_t i = 0; i < m_warmup.size( ); i++ )
+            deviations[i] = std::abs( m_warmup[i] - warmupMedian );
+        const double mad = vaABComparison::Median( std::move( deviations ) );
+
+        // 1.4826 scales MAD to standard deviation for normally distributed data
+        const double threshold = m_settings.WarmupOutlierMADs * 1.4826 * mad;
+        for( double x : m_warmup )
+        {
+            if( std::abs( x - warmupMedian ) <= threshold )
+                AddAccepted( x );
+            else
+                m_rejectedCount++;
+        }
+    }
+    m_warmup.clear( );
+    m_warmup.shrink_to_fit( );
+}
+
+void vaStreamingStatistics::AddAccepted( double x )
+{
+    m_count++;
+    const double delta = x - m_mean;
+    m_mean += delta / (double)m_count;
+    m_m2 += delta * ( x - m_mean );
+
+    if( m_count == 1 )
+        m_min = m_max = x;
+    else
+    {
+        m_min = std::min( m_min, x );
+        m_max = std::max( m_max, x );
+    }
+
+    if( m_settings.Budget > 0.0 && x > m_settings.Budget )
+        m_overBudgetCount++;
+
+    for( int i = 0; i < PercentileCount; i++ )
+        m_percentiles[i].Add( x );
+}
+
+double vaStreamingStatistics::GetStdDev( ) const
+{
+    return std::sqrt( GetVariance( ) );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // median of values[0..count), reorders them
+    double MedianInPlace( double * values, size_t count )
+    {
+        if( count == 0 )
+            return 0.0;
+        const size_t mid = count / 2;
+        std::nth_element( values, values + mid, values + count );
+        double ret = values[mid];
+        if( ( count % 2 ) == 0 )
+            ret = 0.5 * ( ret + *std::max_element( values, values + mid ) );
+        return ret;
+    }
+
+    // SplitMix64 - tiny, fast, and (unlike std:: distributions) gives the same sequence on every compiler
+    struct BootstrapRandom
+    {
+        uint64_t                            State;
+
+        explicit BootstrapRandom( uint64_t seed ) : State( seed ) { }
+
+        uint64_t                            Next( )
+        {
+            uint64_t z = ( State += 0x9E3779B97F4A7C15ull );
+            z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+            z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+            return z ^ ( z >> 31 );
+        }
+
+        // uniform in [0, count)
+        size_t                              NextIndex( size_t count )
+        {
+            const double u = (double)( Next( ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+            return std::min( (size_t)( u * (double)count ), count - 1 );
+        }
+    };
+
+    // linearly interpolated quantile of an already sorted array
+    double SortedQuantile( const std::vector<double> & sorted, double p )
+    {
+        assert( sorted.size( ) > 0 );
+        const double pos = std::max( 0.0, std::min( 1.0, p ) ) * (double)( sorted.size( ) - 1 );
+        const size_t lo = (size_t)std::floor( pos );
+        const size_t hi = std::min( lo + 1, sorted.size( ) - 1 );
+        return sorted[lo] + ( sorted[hi] - sorted[lo] ) * ( pos - (double)lo );
+    }
+}
+
+double vaABComparison::Median( std::vector<double> values )
+{
+    return MedianInPlace( values.data( ), values.size( ) );
+}
+
+void vaABComparison::MannWhitneyU( const std::vector<double> & samplesA, const std::vector<double> & samplesB, double & outU, double & outZ, double & outPValue )
+{
+    outU = 0.0; outZ = 0.0; outPValue = 1.0;
+    const size_t nA = samplesA.size( );
+    const size_t nB = samplesB.size( );
+    if( nA == 0 || nB == 0 )
+        return;
+    const size_t n = nA + nB;
+
+    // ranks over the combined set; index < nA is from A
+    std::vector<size_t> order( n );
+    std::iota( order.begin( ), order.end( ), (size_t)0 );
+    auto value = [&]( size_t i ) { return ( i < nA ) ? ( samplesA[i] ) : ( samplesB[i - nA] ); };
+    std::sort( order.begin( ), order.end( ), [&]( size_t l, size_t r ) { double vl = value( l ), vr = value( r ); return ( vl < vr ) || ( vl == vr && l < r ); } );
+
+    double rankSumA         = 0.0;
+    double tieCorrection    = 0.0;      // sum of (t^3 - t) over tie groups
+    for( size_t i = 0; i < n; )
+    {
+        size_t j = i + 1;
+        while( j < n && value( order[j] ) == value( order[i] ) )
+            j++;
+        // tied ranks i+1 .. j get their average
+        const double averageRank = 0.5 * (double)( i + 1 + j );
+        for( size_t k = i; k < j; k++ )
+            if( order[k] < nA )
+                rankSumA += averageRank;
+        const double t = (double)( j - i );
+        tieCorrection += t * t * t - t;
+        i = j;
+    }
+
+    const double dA = (double)nA, dB = (double)nB, dN = (double)n;
+    outU = rankSumA - dA * ( dA + 1.0 ) * 0.5;
+
+    const double mean = dA * dB * 0.5;
+    const double variance = dA * dB / 12.0 * ( ( dN + 1.0 ) - ( ( n > 1 ) ? ( tieCorrection / ( dN * ( dN - 1.0 ) ) ) : ( 0.0 ) ) );
+    if( variance <= 0.0 )
+        return;     // all samples identical
+
+    const double diff = outU - mean;
+    const double continuity = ( diff > 0.0 ) ? ( -0.5 ) : ( ( diff < 0.0 ) ? ( 0.5 ) : ( 0.0 ) );
+    outZ = ( diff + continuity ) / std::sqrt( variance );
+    outPValue = std::min( 1.0, std::erfc( std::abs( outZ ) / std::sqrt( 2.0 ) ) );
+}
+
+void vaABComparison::BootstrapMedianRatioCI( const std::vector<double> & samplesA, const std::vector<double> & samplesB, double confidenceLevel, int iterations, uint64_t seed, double & outLow, double & outHigh )
+{
+    outLow = outHigh = 0.0;
+    if( samplesA.size( ) == 0 || samplesB.size( ) == 0 || iterations <= 0 )
+        return;
+
+    BootstrapRandom random( seed );
+    std::vector<double> resampleA( samplesA.size( ) );
+    std::vector<double> resampleB( samplesB.size( ) );
+    std::vector<double> ratios;
+    ratios.reserve( iterations );
+    for( int it = 0; it < iterations; it++ )
+    {
+        for( size_t i = 0; i < resampleA.size( ); i++ )
+            resampleA[i] = samplesA[ random.NextIndex( samplesA.size( ) ) ];
+        for( size_t i = 0; i < resampleB.size( ); i++ )
+            resampleB[i] = samplesB[ random.NextIndex( samplesB.size( ) ) ];
+        const double medianB = MedianInPlace( resampleB.data( ), resampleB.size( ) );
+        if( medianB == 0.0 )
+            continue;
+        ratios.push_back( MedianInPlace( resampleA.data( ), resampleA.size( ) ) / medianB );
+    }
+    if( ratios.size( ) == 0 )
+        return;
+
+    std::sort( ratios.begin( ), ratios.end( ) );
+    const double alpha = 1.0 - confidenceLevel;
+    outLow  = SortedQuantile( ratios, alpha * 0.5 );
+    outHigh = SortedQuantile( ratios, 1.0 - alpha * 0.5 );
+}
+
+vaABComparison::Result vaABComparison::Compare( const std::vector<double> & samplesA, const std::vector<double> & samplesB, double confidenceLevel, int bootstrapIterations, uint64_t seed )
+{
+    assert( confidenceLevel > 0.0 && confidenceLevel < 1.0 );
+
+    Result ret;
+    ret.CountA          = (int64_t)samplesA.size( );
+    ret.CountB          = (int64_t)samplesB.size( );
+    ret.ConfidenceLevel = confidenceLevel;
+    if( !ret.Valid( ) )
+        return ret;
+
+    ret.MedianA         = Median( samplesA );
+    ret.MedianB         = Median( samplesB );
+    ret.Speedup         = ( ret.MedianB != 0.0 ) ? ( ret.MedianA / ret.MedianB ) : ( 0.0 );
+
+    MannWhitneyU( samplesA, samplesB, ret.MannWhitneyU, ret.MannWhitneyZ, ret.PValue );
+    ret.ProbabilityAGreater = ret.MannWhitneyU / ( (double)ret.CountA * (double)ret.CountB );
+    ret.Significant     = ret.PValue < ( 1.0 - confidenceLevel );
+
+    BootstrapMedianRatioCI( samplesA, samplesB, confidenceLevel, bootstrapIterations, seed, ret.SpeedupCILow, ret.SpeedupCIHigh );
+
+    return ret;
+}
+
+bool vaABComparison::SelfTest( std::string * outInfo )
+{
+    auto fail = [ outInfo ]( const char * what, double expected, double actual )
+    {
+        char buffer[256];
+        snprintf( buffer, sizeof( buffer ), "%s: expected %.6f, got %.6f", what, expected, actual );
+        return vaSelfTest::Fail( outInfo, buffer );
+    };
+    auto near = [ ]( double a, double b, double eps ) { return std::abs( a - b ) <= eps; };
+
+    double U, z, p;
+
+    // The tortoise and the hare race (finishing places 1..12: T H H H H H T T T T T H), no ties: U = 25 (11 for the hare side),
+    // mean 18, variance 6*6*13/12 = 39, z = ( 25 - 18 - 0.5 ) / sqrt( 39 ) = 1.040833, p = erfc( z / sqrt( 2 ) ) = 0.297953
+    MannWhitneyU( { 1, 7, 8, 9, 10, 11 }, { 2, 3, 4, 5, 6, 12 }, U, z, p );
+    if( !near( U, 25.0, 1e-9 ) )            return fail( "Mann-Whitney U (no ties)", 25.0, U );
+    if( !near( z, 1.040833, 1e-5 ) )        return fail( "Mann-Whitney z (no ties)", 1.040833, z );
+    if( !near( p, 0.297953, 1e-5 ) )        return fail( "Mann-Whitney p (no ties)", 0.297953, p );
+
+    // same with the sides swapped: U = 36 - 25, z and p mirror
+    MannWhitneyU( { 2, 3, 4, 5, 6, 12 }, { 1, 7, 8, 9, 10, 11 }, U, z, p );
+    if( !near( U, 11.0, 1e-9 ) )            return fail( "Mann-Whitney U (no ties, swapped)", 11.0, U );
+    if( !near( z, -1.040833, 1e-5 ) )       return fail( "Mann-Whitney z (no ties, swapped)", -1.040833, z );
+    if( !near( p, 0.297953, 1e-5 ) )        return fail( "Mann-Whitney p (no ties, swapped)", 0.297953, p );
+
+    // with ties (2.3 x3, 3.0 x3, 5.5 x2): U counted pair by pair (ties count 1/2) = 15.5, tie term 24+24+6 = 54,
+    // variance 7*8/12 * ( 16 - 54 / 210 ) = 73.466667, z = ( 15.5 - 28 + 0.5 ) / sqrt( variance ) = -1.400026, p = 0.161506
+    MannWhitneyU( { 1.1, 2.3, 2.3, 3.0, 4.2, 5.5, 6.0 }, { 2.3, 3.0, 3.0, 4.8, 5.5, 7.1, 8.0, 9.4 }, U, z, p );
+    if( !near( U, 15.5, 1e-9 ) )            return fail( "Mann-Whitney U (ties)", 15.5, U );
+    if( !near( z, -1.400026, 1e-5 ) )       return fail( "Mann-Whitney z (ties)", -1.400026, z );
+    if( !near( p, 0.161506, 1e-5 ) )        return fail( "Mann-Whitney p (ties)", 0.161506, p );
+
+    // all identical - no evidence of any difference
+    MannWhitneyU( { 3, 3, 3 }, { 3, 3 }, U, z, p );
+    if( !near( U, 3.0, 1e-9 ) )             return fail( "Mann-Whitney U (identical)", 3.0, U );
+    if( !near( p, 1.0, 1e-12 ) )            return fail( "Mann-Whitney p (identical)", 1.0, p );
+
+    double low, high;
+
+    // constant samples: every resample has the same medians so the interval collapses to the exact ratio
+    BootstrapMedianRatioCI( { 3, 3, 3, 3 }, { 2, 2, 2 }, 0.95, 500, 1, low, high );
+    if( !near( low, 1.5, 1e-12 ) )          return fail( "bootstrap CI low (constant)", 1.5, low );
+    if( !near( high, 1.5, 1e-12 ) )         return fail( "bootstrap CI high (constant)", 1.5, high );
+
+    // synthetic frame times: B is A scaled down by exactly 1.25 (so the true median ratio is 1.25) with A spread 9..11
+    std::vector<double> samplesA, samplesB;
+    {
+        BootstrapRandom random( 12345 );
+        for( int i = 0; i < 400; i++ )
+        {
+            const double x = 9.0 + 2.0 * (double)( random.Next( ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+            samplesA.push_back( x );
+            samplesB.push_back( x / 1.25 );
+        }
+    }
+    const Result result = Compare( samplesA, samplesB, 0.95, 2000, 42 );
+    if( !near( result.Speedup, 1.25, 1e-12 ) )                      return fail( "speedup", 1.25, result.Speedup );
+    if( !( result.SpeedupCILow < 1.25 && result.SpeedupCIHigh > 1.25 ) )
+        return fail( "bootstrap CI contains the true ratio (low)", 1.25, result.SpeedupCILow );
+    if( !( result.SpeedupCIHigh - result.SpeedupCILow < 0.1 ) )     return fail( "bootstrap CI width", 0.1, result.SpeedupCIHigh - result.SpeedupCILow );
+    if( !result.Significant )                                       return fail( "significance", 1.0, 0.0 );
+
+    // same seed, same interval, bit for bit
+    BootstrapMedianRatioCI( samplesA, samplesB, 0.95, 2000, 42, low, high );
+    if( low != result.SpeedupCILow || high != result.SpeedupCIHigh )
+        return fail( "bootstrap CI repeatability", result.SpeedupCILow, low );
+
+    return vaSelfTest::Pass( outInfo );
+}
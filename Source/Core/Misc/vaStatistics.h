@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// Benchmark statistics. Intentionally has no dependencies outside of the standard library (no vaCore) so it can be
+// built and tested on its own, on any platform.
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace Vanilla
+{
+    // Streaming estimate of a single quantile using the P-square algorithm ("The P2 algorithm for dynamic calculation of
+    // quantiles and histograms without storing observations", Jain & Chlamtac, 1985): 5 markers, O(1) memory and time
+    // per sample. Exact for up to 5 samples.
+    class vaStreamingQuantile
+    {
+        double                              m_p             = 0.5;
+        int64_t                             m_count         = 0;
+        double                              m_heights[5]    = { };
+        double                              m_positions[5]  = { };
+        double                              m_desired[5]    = { };
+        double                              m_increments[5] = { };
+
+    public:
+        explicit vaStreamingQuantile( double p = 0.5 )                  { Reset( p ); }
+
+        void                                Reset( double p );
+        void                                Add( double x );
+
+        double                              GetP( ) const               { return m_p; }
+        int64_t                             GetCount( ) const           { return m_count; }
+        double                              Get( ) const;               // 0 if no samples
+
+    private:
+        double                              Parabolic( int i, double d ) const;
+        double                              Linear( int i, int d ) const;
+    };
+
+    // Incremental mean / variance (Welford), min / max, P50 / P90 / P99 / P99.9 and an "over budget" count, with optional
+    // warm-up outlier rejection: the first WarmupSampleCount samples are held back and, once there's all of them, the ones
+    // further than WarmupOutlierMADs median absolute deviations from their median are dropped (all of them are dropped if
+    // WarmupOutlierMADs <= 0). Memory use does not depend on the number of samples (beyond the warm-up buffer).
+    class vaStreamingStatistics
+    {
+    public:
+        enum Percentile : int
+        {
+            P50                             = 0,
+            P90,
+            P99,
+            P999,
+            PercentileCount
+        };
+
+        struct Settings
+        {
+            double                          Budget                  = 0.0;      // samples above this are counted in GetOverBudgetCount; <= 0 to disable
+            int                             WarmupSampleCount       = 0;
+            double                          WarmupOutlierMADs       = 0.0;
+        };
+
+    private:
+        Settings                            m_settings;
+
+        int64_t                             m_count                 = 0;
+        double                              m_mean                  = 0.0;
+        double                              m_m2                    = 0.0;
+        double                              m_min                   = 0.0;
+        double                              m_max                   = 0.0;
+        int64_t                             m_overBudgetCount       = 0;
+        int64_t                             m_rejectedCount         = 0;
+
+        vaStreamingQuantile                 m_percentiles[PercentileCount];
+
+        std::vector<double>                 m_warmup;
+        bool                                m_warmupDone            = false;
+
+    public:
+        vaStreamingStatistics( )                                                { Reset( Settings() ); }
+        explicit vaStreamingStatistics( const Settings & settings )             { Reset( settings ); }
+
+        void                                Reset( const Settings & settings );
+        void                                Add( double x );
+
+        // Processes the warm-up samples held back so far even if there's less than WarmupSampleCount of them; call before
+        // reading results if the run could have been shorter than the warm-up.
+        void                                FlushWarmup( );
+
+        int64_t                             GetCount( ) const                   { return m_count; }            // samples used (excluding rejected and pending warm-up ones)
+        int64_t                             GetRejectedCount( ) const           { return m_rejectedCount; }
+        int64_t                             GetOverBudgetCount( ) const         { return m_overBudgetCount; }
+        double                              GetMean( ) const                    { return m_mean; }
+        double                              GetVariance( ) const                { return ( m_count > 1 ) ? ( m_m2 / (double)( m_count - 1 ) ) : ( 0.0 ); }   // sample (unbiased) variance
+        double                              GetStdDev( ) const;
+        double                              GetMin( ) const                     { return m_min; }
+        double                              GetMax( ) const                     { return m_max; }
+        double                              GetPercentile( Percentile which ) const   { return m_percentiles[which].Get( ); }
+
+        static double                       GetPercentileP( Percentile which );     // 0.5, 0.9, 0.99, 0.999
+
+    private:
+        void                                AddAccepted( double x );
+    };
+
+    // Comparison of two sample sets (A and B, for ex. frame times of two rendering configurations): a two-sided
+    // Mann-Whitney U test (normal approximation with tie and continuity correction) to tell whether the difference is
+    // real, and a bootstrap percentile confidence interval for the ratio of their medians (the "speedup" of B over A if
+    // samples are times). Bootstrap is driven by its own seeded generator so results are reproducible across platforms.
+    class vaABComparison
+    {
+    public:
+        struct Result
+        {
+            int64_t                         CountA                  = 0;
+            int64_t                         CountB                  = 0;
+            double                          MedianA                 = 0.0;
+            double                          MedianB                 = 0.0;
+
+            double                          Speedup                 = 0.0;      // MedianA / MedianB; > 1 means B is smaller (faster)
+            double                          SpeedupCILow            = 0.0;
+            double                          SpeedupCIHigh           = 0.0;
+            double                          ConfidenceLevel         = 0.0;
+
+            double                          MannWhitneyU            = 0.0;      // U statistic for A
+            double                          MannWhitneyZ            = 0.0;
+            double                          PValue                  = 1.0;      // two-sided
+            double                          ProbabilityAGreater     = 0.5;      // P(a > b) + 0.5 * P(a == b), from U
+
+            bool                            Significant             = false;    // PValue < 1 - ConfidenceLevel
+
+            bool                            Valid( ) const                      { return CountA > 0 && CountB > 0; }
+        };
+
+    public:
+        static Result                       Compare( const std::vector<double> & samplesA, const std::vector<double> & samplesB, double confidenceLevel = 0.95, int bootstrapIterations = 2000, uint64_t seed = 0x9E3779B97F4A7C15ull );
+
+        // individual pieces, also usable on their own
+        static void                         MannWhitneyU( const std::vector<double> & samplesA, const std::vector<double> & samplesB, double & outU, double & outZ, double & outPValue );
+        static void                         BootstrapMedianRatioCI( const std::vector<double> & samplesA, const std::vector<double> & samplesB, double confidenceLevel, int iterations, uint64_t seed, double & outLow, double & outHigh );
+        static double                       Median( std::vector<double> values );   // 0 if empty
+
+        // Deterministic known-answer checks of the above (Mann-Whitney U / z / p on small hand-worked sets with and without ties,
+        // bootstrap CI on synthetic samples with a known median ratio); describes the first failure in outInfo (see vaSelfTest).
+        static bool                         SelfTest( std::string * outInfo = nullptr );
+    };
+}
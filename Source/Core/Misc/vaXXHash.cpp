@@ -27,6 +27,7 @@
 #pragma once
 
 #include "vaXXHash.h"
+#define XXH_STATIC_LINKING_ONLY     // for XXH64_state_t size
 #include "xxhash.h"
 
 using namespace Vanilla;
@@ -58,3 +59,30 @@ uint64 vaXXHash64::Compute( const void * dataPtr, int64 length, uint64 seed )
 {
     return XXH64( dataPtr, length, seed );
 }
+
+// second stream's seed is derived from the first so that the two halves are independent
+static const uint64 c_vaXXHash128SeedOffset = 0x9E3779B97F4A7C15ull;
+
+vaXXHash128::vaXXHash128( uint64 seed )
+{
+    static_assert( sizeof( XXH64_state_t ) <= sizeof( m_states[0] ), "m_states too small" );
+    XXH64_reset( (XXH64_state_t*)m_states[0], seed );
+    XXH64_reset( (XXH64_state_t*)m_states[1], seed + c_vaXXHash128SeedOffset );
+}
+
+void vaXXHash128::AddBytes( const void * dataPtr, int64 length )
+{
+    XXH_errorcode const addResultA = XXH64_update( (XXH64_state_t*)m_states[0], dataPtr, (size_t)length );
+    XXH_errorcode const addResultB = XXH64_update( (XXH64_state_t*)m_states[1], dataPtr, (size_t)length );
+    assert( addResultA != XXH_ERROR && addResultB != XXH_ERROR ); addResultA; addResultB;
+}
+
+vaXXHash128::Value vaXXHash128::Digest( ) const
+{
+    return { XXH64_digest( (const XXH64_state_t*)m_states[0] ), XXH64_digest( (const XXH64_state_t*)m_states[1] ) };
+}
+
+vaXXHash128::Value vaXXHash128::Compute( const void * dataPtr, int64 length, uint64 seed )
+{
+    return { XXH64( dataPtr, (size_t)length, seed ), XXH64( dataPtr, (size_t)length, seed + c_vaXXHash128SeedOffset ) };
+}
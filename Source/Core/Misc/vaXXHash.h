@@ -78,4 +78,59 @@ namespace Vanilla
 
     };
 
+    // 128 bit hash built from two differently seeded XXH64 streams (the bundled xxHash predates XXH128). State is kept
+    // inline so it can be used on the stack without any allocations.
+    class vaXXHash128
+    {
+    public:
+        struct Value
+        {
+            uint64              Low;
+            uint64              High;
+
+            bool                operator == ( const Value & other ) const   { return Low == other.Low && High == other.High; }
+            bool                operator != ( const Value & other ) const   { return !( *this == other ); }
+        };
+
+        // for use with unordered containers
+        struct Hasher
+        {
+            size_t              operator( ) ( const Value & value ) const   { return (size_t)value.Low; }
+        };
+
+    private:
+        uint64              m_states[2][12];     // 2 x XXH64_state_t
+
+    public:
+        vaXXHash128( uint64 seed = 0 );
+
+    public:
+        // compute directly from input buffer
+        static Value        Compute( const void * dataPtr, int64 length, uint64 seed = 0 );
+
+        Value               Digest( ) const;
+
+        void                AddBytes( const void * dataPtr, int64 length );
+
+        inline void         AddString( const string & str )
+        {
+            int length = (int)str.length( );
+            AddValue( length );
+            if( length > 0 )  AddBytes( str.c_str( ), length );
+        }
+
+        inline void         AddString( const wstring & str )
+        {
+            int length = (int)str.length( ) * 2;
+            AddValue( length );
+            if( length > 0 )  AddBytes( str.c_str( ), length );
+        }
+
+        template< class ValueType >
+        inline void         AddValue( ValueType val )
+        {
+            AddBytes( &val, sizeof( val ) );
+        }
+    };
+
 }
@@ -29,6 +29,8 @@
 #include "IntegratedExternals/vaImguiIntegration.h"
 #endif
 
+#include <execution>
+
 using namespace Vanilla;
 
 thread_local vaThreading::ThreadLocalProps vaThreading::s_threadLocal;
@@ -77,6 +79,33 @@ const char * vaThreading::GetThreadName( )
     return LocalThreadName().c_str();
 }
 
+void vaThreading::ParallelFor( int itemCount, int minChunkSize, const std::function<void( int begin, int end )> & callback )
+{
+    if( itemCount <= 0 )
+        return;
+    minChunkSize = vaMath::Max( 1, minChunkSize );
+
+    // a few chunks per hardware thread is enough to balance uneven workloads without too much scheduling overhead
+    int maxChunks   = vaMath::Max( 1, (int)std::thread::hardware_concurrency( ) * 4 );
+    int chunkCount  = vaMath::Clamp( ( itemCount + minChunkSize - 1 ) / minChunkSize, 1, maxChunks );
+    if( chunkCount == 1 )
+    {
+        callback( 0, itemCount );
+        return;
+    }
+
+    vector<int> chunks( chunkCount );
+    for( int i = 0; i < chunkCount; i++ )
+        chunks[i] = i;
+
+    std::for_each( std::execution::par, chunks.begin( ), chunks.end( ), [itemCount, chunkCount, &callback]( int chunk )
+    {
+        int begin   = (int)( (int64)itemCount * chunk / chunkCount );
+        int end     = (int)( (int64)itemCount * ( chunk + 1 ) / chunkCount );
+        if( begin < end )
+            callback( begin, end );
+    } );
+}
 
 vaBackgroundTaskManager::vaBackgroundTaskManager( )  
 {
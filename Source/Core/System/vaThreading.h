@@ -50,6 +50,11 @@ namespace Vanilla
 
         static void                         SetSyncedWithMainThread( )                                          { s_threadLocal.MainThreadSynced = true; }
 
+        // Blocking data-parallel helper for CPU-heavy work that has to complete before returning (tools, importers, simulation).
+        // Splits [0, itemCount) into chunks of at least minChunkSize items and runs callback( begin, end ) on them using the
+        // std::execution::par pool; the calling thread participates. Callback must be thread-safe across different chunks.
+        static void                         ParallelFor( int itemCount, int minChunkSize, const std::function<void( int begin, int end )> & callback );
+
     private:
         friend class vaCore;
 
@@ -175,85 +180,157 @@ namespace Vanilla
 
     BITFLAG_ENUM_CLASS_HELPER( vaBackgroundTaskManager::SpawnFlags );
 
-    // Owner thread creates an instance of vaThreadSpecificCallbackQueue and calls Tick( ... )
-    // Any other thread can call 
+    // Order in which queued vaThreadSpecificAsyncCallbackQueue callbacks get invoked; all High ones run before any Normal ones and so on.
+    enum class vaAsyncCallbackPriority : int32
+    {
+        High                        = 0,        // something is waiting on it (for ex. a worker thread blocked on the returned future)
+        Normal                      = 1,
+        Low                         = 2,        // background work that can be spread over many frames
+        MaxValue
+    };
+
+    // Owner thread creates an instance of vaThreadSpecificAsyncCallbackQueue and calls Invoke( ... ) periodically (for ex. once per frame).
+    // Any thread can call Enqueue; it never blocks (lock-free multiple producer / single consumer stack that the owner thread drains 
+    // into per-priority FIFO lists on each Invoke). Invoke runs callbacks in priority order until the provided time budget is used
+    // up and leaves the rest for the next Invoke, so a burst of enqueued work gets spread over several frames instead of causing a hitch.
     template< typename ... ArgsType >
     class vaThreadSpecificAsyncCallbackQueue
     {
-        // struct CallbackEntry
-        // {
-        //     std::function<void( ArgsType... )>  Callback;
-        //     std::tuple<ArgsType...>             Args;
-        // 
-        //     CallbackEntry( std::function<void( ArgsType... )>&& callback, ArgsType&& ... args ) :
-        //         Callback( std::forward<std::function<void( ArgsType... )>>( callback ) ),
-        //         Args( std::forward<ArgsType>( args... ) ) { }
-        // 
-        //     void Invoke( )
-        //     {   // oh my is this ugly
-        //         _invoke( std::make_index_sequence < std::tuple_size< std::tuple< ArgsType... > >{} > {} );
-        //     }
-        // 
-        // private:
-        //     template <size_t... Is>
-        //     constexpr auto              _invoke( std::index_sequence<Is...> )
-        //     {
-        //         Callback( pThisTask, ctx, std::get<Is>( Args )... );
-        //     }
-        // };
+        struct Entry
+        {
+            std::function<bool( ArgsType... )>          Callback;
+            std::promise<bool>                          Promise;
+            vaAsyncCallbackPriority                     Priority;
+            Entry *                                     Next        = nullptr;
+
+            Entry( std::function<bool( ArgsType... )> && callback, vaAsyncCallbackPriority priority ) : Callback( std::move( callback ) ), Priority( priority ) { }
+
+            void                                        Run( ArgsType... args )     { Promise.set_value( Callback( args... ) ); }
+            void                                        Cancel( )                   { Promise.set_value( false ); }
+        };
 
+    public:
+        struct Stats
+        {
+            int                     Invoked             = 0;        // callbacks run during last Invoke
+            int                     Remaining           = 0;        // left queued after last Invoke (carried over to the next one)
+            double                  TimeSpent           = 0.0;      // in seconds
+        };
+
+    private:
         std::thread::id const       m_ownerThreadID = std::this_thread::get_id();
-        
-        std::mutex                  m_mutex;
-        bool                        m_active = true;
 
-        std::deque< std::packaged_task<bool( ArgsType... )> >   
-                                    m_entries;
+        std::atomic<Entry *>        m_incoming          = nullptr;  // pushed to by any thread (so in reverse order), grabbed as a whole by the owner thread
+        std::atomic_bool            m_active            = true;
+        std::atomic_int             m_enqueuesInProgress= 0;        // so that InvokeAndDeactivate doesn't miss an Enqueue that saw m_active == true
+
+        // owner thread only
+        std::deque< Entry * >       m_queued[(int)vaAsyncCallbackPriority::MaxValue];
+        Stats                       m_lastStats;
 
     public:
         vaThreadSpecificAsyncCallbackQueue( )    { }
-        ~vaThreadSpecificAsyncCallbackQueue( )   { }
+        ~vaThreadSpecificAsyncCallbackQueue( )   
+        { 
+            // anything left never runs - cancel it explicitly so that its future reports false instead of broken_promise
+            GrabIncoming( );
+            for( auto & queue : m_queued )
+                for( Entry * entry : queue )
+                {
+                    entry->Cancel( );
+                    delete entry;
+                }
+        }
 
     public:
 
-        template< typename ... ArgsType >
-        std::future<bool>           Enqueue( std::function<bool( ArgsType... )> && callback )
+        std::future<bool>           Enqueue( std::function<bool( ArgsType... )> && callback, vaAsyncCallbackPriority priority = vaAsyncCallbackPriority::Normal )
         {
-            std::unique_lock lock(m_mutex);
+            assert( priority >= vaAsyncCallbackPriority::High && priority < vaAsyncCallbackPriority::MaxValue );
+            m_enqueuesInProgress.fetch_add( 1 );
             if( /*m_ownerThreadID == std::this_thread::get_id() ||*/ !m_active )
             {
+                m_enqueuesInProgress.fetch_sub( 1 );
                 assert( false );
-                std::packaged_task<bool()> dummyTask( [ ]( ) { return false; } );
-                dummyTask();
-                return dummyTask.get_future();
+                std::promise<bool> cancelled;
+                cancelled.set_value( false );
+                return cancelled.get_future();
             }
-            m_entries.push_back( std::move(std::packaged_task<bool( ArgsType... )>(std::forward< decltype(callback) >( callback ))) );
-            // m_entries.push_front( CallbackEntry( std::forward<std::function<void(ArgsType...)>>( callback ), std::forward<ArgsType>( args )... ) );
-            return m_entries.back().get_future();
+            Entry * entry = new Entry( std::move( callback ), priority );
+            std::future<bool> ret = entry->Promise.get_future( );
+
+            entry->Next = m_incoming.load( std::memory_order_relaxed );
+            while( !m_incoming.compare_exchange_weak( entry->Next, entry, std::memory_order_release, std::memory_order_relaxed ) ) { }
+
+            m_enqueuesInProgress.fetch_sub( 1 );
+            return ret;
         }
 
-        void                        Invoke( ArgsType... args )
+        // Invokes queued callbacks (owner thread only), highest priority first and in order of enqueuing within the same priority,
+        // until they're all done or timeBudget (in seconds) runs out; at least one is always invoked so there's progress.
+        // Callbacks enqueued while this runs will be picked up by the next Invoke.
+        void                        Invoke( double timeBudget, ArgsType... args )
         {
             assert( m_ownerThreadID == std::this_thread::get_id( ) );
-            std::scoped_lock<std::mutex> lock( m_mutex );
-            while( !m_entries.empty( ) )
+            GrabIncoming( );
+
+            m_lastStats = Stats( );
+            double startTime = vaCore::TimeFromAppStart( );
+            for( auto & queue : m_queued )
             {
-                m_entries.front()( std::forward<ArgsType>( args )... );
-                m_entries.pop_front();
+                while( !queue.empty( ) )
+                {
+                    if( m_lastStats.Invoked > 0 && ( vaCore::TimeFromAppStart( ) - startTime ) >= timeBudget )
+                        break;
+                    Entry * entry = queue.front( );
+                    queue.pop_front( );
+                    entry->Run( args... );
+                    delete entry;
+                    m_lastStats.Invoked++;
+                }
+                m_lastStats.Remaining += (int)queue.size( );
             }
+            m_lastStats.TimeSpent = vaCore::TimeFromAppStart( ) - startTime;
         }
 
         // invoke all remaining entries and prevent any more from being added
         void                        InvokeAndDeactivate( ArgsType&& ... args )
         {
             assert( m_ownerThreadID == std::this_thread::get_id() );
-            std::scoped_lock<std::mutex> lock( m_mutex );
             m_active = false;
-            while( !m_entries.empty( ) )
+            while( m_enqueuesInProgress.load( ) > 0 )
+                std::this_thread::yield( );
+
+            GrabIncoming( );
+            for( auto & queue : m_queued )
+            {
+                while( !queue.empty( ) )
+                {
+                    Entry * entry = queue.front( );
+                    queue.pop_front( );
+                    entry->Run( args... );
+                    delete entry;
+                }
+            }
+        }
+
+        const Stats &               GetLastStats( ) const           { assert( m_ownerThreadID == std::this_thread::get_id( ) ); return m_lastStats; }
+
+    private:
+        // move everything pushed since the last call into per-priority lists, restoring the order of enqueuing
+        void                        GrabIncoming( )
+        {
+            Entry * head = m_incoming.exchange( nullptr, std::memory_order_acquire );
+            Entry * reversed = nullptr;
+            while( head != nullptr )
             {
-                m_entries.front()( std::forward<ArgsType>( args )... );
-                m_entries.pop_front( );
+                Entry * next = head->Next;
+                head->Next = reversed;
+                reversed = head;
+                head = next;
             }
+            for( ; reversed != nullptr; reversed = reversed->Next )
+                m_queued[(int)reversed->Priority].push_back( reversed );
         }
     };
 
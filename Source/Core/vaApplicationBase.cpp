@@ -250,6 +250,8 @@ void vaApplicationBase::UpdateFramerateStats( float deltaTime )
     float avgFramerate = GetAvgFramerate( );
     float avgFrametimeMs = GetAvgFrametime( ) * 1000.0f;
     m_basicFrameInfo = vaStringTools::Format( L"%.2fms/frame avg (%.2fFPS, %dx%d)", avgFrametimeMs, avgFramerate, m_currentWindowClientSize.x, m_currentWindowClientSize.y );
+    if( m_renderDevice != nullptr && m_renderDevice->GetLastFrameAllocationCount( ) >= 0 )
+        m_basicFrameInfo += vaStringTools::Format( L" %lld allocs/frame", (long long)m_renderDevice->GetLastFrameAllocationCount( ) );
 #ifdef _DEBUG
     m_basicFrameInfo += L" DEBUG";
 #endif
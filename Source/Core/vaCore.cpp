@@ -206,6 +206,7 @@ void vaCore::Error( const wchar_t * messageFormat, ... )
     va_end( args );
 
     VA_LOG_ERROR( L"%s", ret.c_str( ) );
+    vaLog::GetInstance( ).Flush( );
 
     vaPlatformBase::Error( ret.c_str() );
 }
@@ -29,17 +29,111 @@
 #endif
 
 #include <sstream>
+#include <cstdio>
+#include <cwchar>
 
 
 using namespace Vanilla;
 
+namespace
+{
+    // UTF-16 (wchar_t on Windows) to UTF-8; output must have room for 3 bytes per input character; returns bytes written
+    size_t WideToUTF8( const wchar_t * text, size_t length, char * output )
+    {
+        char * out = output;
+        for( size_t i = 0; i < length; i++ )
+        {
+            uint32 cp = (uint32)text[i];
+            if( cp >= 0xD800 && cp <= 0xDBFF && ( i + 1 ) < length && (uint32)text[i + 1] >= 0xDC00 && (uint32)text[i + 1] <= 0xDFFF )
+                cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( (uint32)text[++i] - 0xDC00 );
+            else if( cp >= 0xD800 && cp <= 0xDFFF )
+                cp = 0xFFFD;    // unpaired surrogate
+
+            if( cp < 0x80 )
+                *out++ = (char)cp;
+            else if( cp < 0x800 )
+            {
+                *out++ = (char)( 0xC0 | ( cp >> 6 ) );
+                *out++ = (char)( 0x80 | ( cp & 0x3F ) );
+            }
+            else if( cp < 0x10000 )
+            {
+                *out++ = (char)( 0xE0 | ( cp >> 12 ) );
+                *out++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+                *out++ = (char)( 0x80 | ( cp & 0x3F ) );
+            }
+            else
+            {
+                *out++ = (char)( 0xF0 | ( cp >> 18 ) );
+                *out++ = (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+                *out++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+                *out++ = (char)( 0x80 | ( cp & 0x3F ) );
+            }
+        }
+        return out - output;
+    }
+
+    // UTF-8 to UTF-16 (only used for the debug output)
+    wstring UTF8ToWide( const string & text )
+    {
+        wstring ret;
+        ret.reserve( text.size( ) );
+        for( size_t i = 0; i < text.size( ); )
+        {
+            const uint8 c = (uint8)text[i];
+            uint32 cp; int extra;
+            if( c < 0x80 )                  { cp = c;           extra = 0; }
+            else if( ( c & 0xE0 ) == 0xC0 ) { cp = c & 0x1F;    extra = 1; }
+            else if( ( c & 0xF0 ) == 0xE0 ) { cp = c & 0x0F;    extra = 2; }
+            else if( ( c & 0xF8 ) == 0xF0 ) { cp = c & 0x07;    extra = 3; }
+            else                            { cp = 0xFFFD;      extra = 0; }
+            i++;
+            for( int j = 0; j < extra; j++, i++ )
+            {
+                if( i >= text.size( ) || ( (uint8)text[i] & 0xC0 ) != 0x80 ) { cp = 0xFFFD; break; }
+                cp = ( cp << 6 ) | ( (uint8)text[i] & 0x3F );
+            }
+            if( cp >= 0x10000 )
+            {
+                ret.push_back( (wchar_t)( 0xD800 + ( ( cp - 0x10000 ) >> 10 ) ) );
+                ret.push_back( (wchar_t)( 0xDC00 + ( ( cp - 0x10000 ) & 0x3FF ) ) );
+            }
+            else
+                ret.push_back( (wchar_t)cp );
+        }
+        return ret;
+    }
+
+    // largest length <= maxLength that doesn't split a UTF-8 sequence
+    size_t UTF8SafeSplit( const char * text, size_t length, size_t maxLength )
+    {
+        if( length <= maxLength )
+            return length;
+        size_t split = maxLength;
+        while( split > 0 && ( (uint8)text[split] & 0xC0 ) == 0x80 )
+            split--;
+        return ( split > 0 ) ? ( split ) : ( maxLength );
+    }
+
+    const int c_formatBufferSize    = 2048;
+    const int c_ringFullMaxRetries  = 4096;     // yields before a producer gives up and drops an entry when the ring is full
+}
+
 vaLog::vaLog( )
 {
     m_lastAddedTime = 0;
 
     m_timer.Start();
 
-    if( !m_outStream.Open( vaCore::GetExecutableDirectory( ) + L"log.txt", FileCreationMode::Create, FileAccessMode::Write, FileShareMode::Read ) )
+    m_ring = std::make_unique<RingEntry[]>( c_ringCapacity );
+    for( int i = 0; i < c_ringCapacity; i++ )
+        m_ring[i].Sequence.store( (uint64)i, std::memory_order_relaxed );
+    m_ringEnqueuePos    = 0;
+    m_ringDequeuePos    = 0;
+    m_ringDroppedCount  = 0;
+
+    m_outFilePath = vaCore::GetExecutableDirectory( ) + L"log.txt";
+    if( !m_outStream.Open( m_outFilePath, FileCreationMode::Create, FileAccessMode::Write, FileShareMode::Read ) )
     {
         // where does one log failure to open the log file?
         vaCore::DebugOutput( L"Unable to open log output file" );
@@ -47,13 +141,22 @@ vaLog::vaLog( )
     else
     {
         // Using byte order marks: https://msdn.microsoft.com/en-us/library/windows/desktop/dd374101
-        uint16 utf16LE = 0xFEFF;
-        m_outStream.WriteValue<uint16>(utf16LE);
+        const uint8 utf8BOM[3] = { 0xEF, 0xBB, 0xBF };
+        m_outStream.Write( utf8BOM, sizeof( utf8BOM ) );
     }
+
+    m_sinkStop          = false;
+    m_sinkSleeping      = false;
+    m_sinkThread        = std::thread( &vaLog::SinkThread, this );
 }
 
 vaLog::~vaLog( )
 {
+    m_sinkStop = true;
+    WakeSink( );
+    if( m_sinkThread.joinable( ) )
+        m_sinkThread.join( );
+
     m_timer.Stop();
 
     m_outStream.Close();
@@ -65,83 +168,324 @@ void vaLog::Clear( )
     m_logEntries.clear();
 }
 
-void vaLog::Add( const vaVector4 & color, const std::wstring & text )
+bool vaLog::RingPush( const vaVector4 & color, time_t localTime, double systemTime, const char * text, size_t length )
 {
-    vaRecursiveMutexScopeLock lock( m_mutex );
+    assert( length <= c_ringEntryTextSize );
+    const uint64 mask = (uint64)( c_ringCapacity - 1 );
+
+    // bounded MPMC queue as per Dmitry Vyukov: each entry's sequence tells whether it's free for the producer at 'pos'
+    RingEntry * entry;
+    int fullRetries = 0;
+    uint64 pos = m_ringEnqueuePos.load( std::memory_order_relaxed );
+    for( ;; )
+    {
+        entry = &m_ring[pos & mask];
+        const uint64 sequence = entry->Sequence.load( std::memory_order_acquire );
+        const int64 diff = (int64)sequence - (int64)pos;
+        if( diff == 0 )
+        {
+            if( m_ringEnqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                break;
+        }
+        else if( diff < 0 )
+        {
+            // full: give the sink a (bounded) chance to catch up before dropping; never wait on the sink from the sink itself
+            if( fullRetries++ < c_ringFullMaxRetries && std::this_thread::get_id( ) != m_sinkThread.get_id( ) )
+            {
+                WakeSink( );
+                std::this_thread::yield( );
+                pos = m_ringEnqueuePos.load( std::memory_order_relaxed );
+                continue;
+            }
+            m_ringDroppedCount.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+        }
+        else
+            pos = m_ringEnqueuePos.load( std::memory_order_relaxed );
+    }
 
-    vaCore::DebugOutput( /*L"vaLog: " + */text + L"\n" );
+    entry->Color        = color;
+    entry->LocalTime    = localTime;
+    entry->SystemTime   = systemTime;
+    entry->Length       = (uint32)length;
+    memcpy( entry->Text, text, length );
+    entry->Sequence.store( pos + 1, std::memory_order_release );
+    return true;
+}
 
-#ifdef VA_REMOTERY_INTEGRATION_ENABLED
-    rmt_LogText( vaStringTools::SimpleNarrow(text).c_str() );
-#endif
+void vaLog::AddUTF8( const vaVector4 & color, const char * text, size_t length )
+{
+    const time_t locTime = time( NULL );
+    const double now = m_timer.GetCurrentTimeDouble( );
 
-    std::wstringstream sstext( text );
-    wstring line;
-    //int lineNum = 1;
-    while( std::getline( sstext, line ) )
+    // one entry per line (and longer lines split into several entries)
+    const char * lineStart = text;
+    const char * textEnd = text + length;
+    while( lineStart < textEnd )
     {
-        time_t locTime = time( NULL );
-        double now = m_timer.GetCurrentTimeDouble( );
-        assert( now >= m_lastAddedTime );
-        if( now > m_lastAddedTime )
-            m_lastAddedTime = now;
-        m_logEntries.push_back( Entry( color, line, locTime, m_lastAddedTime ) );
-
-        if( m_logEntries.size( ) > c_maxEntries )
+        const char * lineEnd = (const char *)memchr( lineStart, '\n', textEnd - lineStart );
+        const char * next = ( lineEnd != nullptr ) ? ( lineEnd + 1 ) : ( textEnd );
+        if( lineEnd == nullptr )
+            lineEnd = textEnd;
+        if( lineEnd > lineStart && lineEnd[-1] == '\r' )
+            lineEnd--;
+
+        size_t remaining = lineEnd - lineStart;
+        do
         {
-            const int countToDelete = c_maxEntries / 10;
-            m_logEntries.erase( m_logEntries.begin(), m_logEntries.begin()+countToDelete );
-        }
+            const size_t chunk = UTF8SafeSplit( lineStart, remaining, c_ringEntryTextSize );
+            RingPush( color, locTime, now, lineStart, chunk );
+            lineStart += chunk;
+            remaining -= chunk;
+        } while( remaining > 0 );
 
-        if( m_outStream.IsOpen() )
-        {
-            char buff[64];
-#pragma warning ( suppress: 4996 )
-            strftime( buff, sizeof( buff ), "%H:%M:%S: ", localtime( &locTime ) );
+        lineStart = next;
+    }
 
-            m_outStream.WriteTXT( vaStringTools::SimpleWiden(buff) + line + L"\r\n" );
-        }
+    WakeSink( );
+}
+
+void vaLog::Add( const vaVector4 & color, const std::wstring & text )
+{
+    if( text.size( ) <= c_formatBufferSize )
+    {
+        char utf8[3 * c_formatBufferSize];
+        AddUTF8( color, utf8, WideToUTF8( text.c_str( ), text.size( ), utf8 ) );
+    }
+    else
+    {
+        string utf8( text.size( ) * 3, '\0' );
+        utf8.resize( WideToUTF8( text.c_str( ), text.size( ), &utf8[0] ) );
+        AddUTF8( color, utf8.c_str( ), utf8.size( ) );
     }
 }
 
+void vaLog::AddV( const vaVector4 & color, const char * messageFormat, va_list args )
+{
+    va_list argsCopy;
+    va_copy( argsCopy, args );
+    char buffer[c_formatBufferSize];
+    const int length = vsnprintf( buffer, sizeof( buffer ), messageFormat, args );
+    if( length >= 0 && length < (int)sizeof( buffer ) )
+        AddUTF8( color, buffer, (size_t)length );
+    else
+    {
+        std::string txt = vaStringTools::Format( messageFormat, argsCopy );
+        AddUTF8( color, txt.c_str( ), txt.size( ) );
+    }
+    va_end( argsCopy );
+}
+
+void vaLog::AddV( const vaVector4 & color, const wchar_t * messageFormat, va_list args )
+{
+    va_list argsCopy;
+    va_copy( argsCopy, args );
+    wchar_t buffer[c_formatBufferSize];
+    const int length = vswprintf( buffer, c_formatBufferSize, messageFormat, args );
+    if( length >= 0 && length < c_formatBufferSize )
+    {
+        char utf8[3 * c_formatBufferSize];
+        AddUTF8( color, utf8, WideToUTF8( buffer, (size_t)length, utf8 ) );
+    }
+    else
+        Add( color, vaStringTools::Format( messageFormat, argsCopy ) );
+    va_end( argsCopy );
+}
+
 void vaLog::Add( const char * messageFormat, ... )
 {
     va_list args;
     va_start( args, messageFormat );
-    std::string txt = vaStringTools::Format( messageFormat, args );
+    AddV( LOG_COLORS_NEUTRAL, messageFormat, args );
     va_end( args );
-
-    Add( LOG_COLORS_NEUTRAL, vaStringTools::SimpleWiden(txt) );
 }
 
 void vaLog::Add( const wchar_t * messageFormat, ... )
 {
     va_list args;
     va_start( args, messageFormat );
-    std::wstring txt = vaStringTools::Format( messageFormat, args );
+    AddV( LOG_COLORS_NEUTRAL, messageFormat, args );
     va_end( args );
-
-    Add( LOG_COLORS_NEUTRAL, txt );
 }
 
 void vaLog::Add( const vaVector4 & color, const char * messageFormat, ... )
 {
     va_list args;
     va_start( args, messageFormat );
-    std::string txt = vaStringTools::Format( messageFormat, args );
+    AddV( color, messageFormat, args );
     va_end( args );
-
-    Add( color, vaStringTools::SimpleWiden( txt ) );
 }
 
 void vaLog::Add( const vaVector4 & color, const wchar_t * messageFormat, ... )
 {
     va_list args;
     va_start( args, messageFormat );
-    std::wstring txt = vaStringTools::Format( messageFormat, args );
+    AddV( color, messageFormat, args );
     va_end( args );
+}
+
+void vaLog::WakeSink( )
+{
+    // only bother the OS if the sink is actually waiting; the fence pairs with the one in SinkThread so that either the
+    // sink sees the new entry or we see it sleeping
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if( m_sinkSleeping.load( std::memory_order_relaxed ) )
+    {
+        std::lock_guard<std::mutex> lock( m_sinkWakeMutex );
+        m_sinkWake.notify_one( );
+    }
+}
+
+void vaLog::Flush( )
+{
+    if( !m_sinkThread.joinable( ) || std::this_thread::get_id( ) == m_sinkThread.get_id( ) )
+        return;
+
+    const uint64 target = m_ringEnqueuePos.load( std::memory_order_acquire );
+    while( m_ringDequeuePos.load( std::memory_order_acquire ) < target )
+    {
+        WakeSink( );
+        std::this_thread::yield( );
+    }
+}
+
+void vaLog::SinkThread( )
+{
+    for( ;; )
+    {
+        const bool stop = m_sinkStop.load( );
+        if( SinkDrain( ) > 0 )
+            continue;
+        if( stop )
+            break;
+
+        std::unique_lock<std::mutex> lock( m_sinkWakeMutex );
+        m_sinkSleeping.store( true, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        const uint64 pos = m_ringDequeuePos.load( std::memory_order_relaxed );
+        const bool hasWork = m_ring[pos & (uint64)( c_ringCapacity - 1 )].Sequence.load( std::memory_order_acquire ) == pos + 1 || m_ringDroppedCount.load( std::memory_order_relaxed ) > 0;
+        if( !hasWork && !m_sinkStop.load( ) )
+            m_sinkWake.wait_for( lock, std::chrono::milliseconds( ( m_sinkDeferred.size( ) > 0 ) ? ( 1 ) : ( 100 ) ) );
+        m_sinkSleeping.store( false, std::memory_order_relaxed );
+    }
+}
+
+int vaLog::SinkDrain( )
+{
+    const uint64 mask = (uint64)( c_ringCapacity - 1 );
+    const int maxBatchSize = 256;
+
+    m_sinkBatch.clear( );
+    uint64 pos = m_ringDequeuePos.load( std::memory_order_relaxed );
+    while( (int)m_sinkBatch.size( ) < maxBatchSize )
+    {
+        RingEntry & entry = m_ring[pos & mask];
+        if( entry.Sequence.load( std::memory_order_acquire ) != pos + 1 )
+            break;
+        m_sinkBatch.push_back( Entry( entry.Color, string( entry.Text, entry.Length ), entry.LocalTime, entry.SystemTime ) );
+        entry.Sequence.store( pos + c_ringCapacity, std::memory_order_release );
+        pos++;
+    }
+
+    const uint64 dropped = m_ringDroppedCount.exchange( 0, std::memory_order_relaxed );
+    if( dropped > 0 )
+        m_sinkBatch.push_back( Entry( LOG_COLORS_WARNING, vaStringTools::Format( "vaLog: ring buffer full, %d entries dropped", (int)dropped ), time( NULL ), m_timer.GetCurrentTimeDouble( ) ) );
+
+    if( m_sinkBatch.size( ) == 0 )
+    {
+        SinkPublishDeferred( );
+        return 0;
+    }
+
+    m_sinkFileText.clear( );
+    string debugText;
+    time_t bufferTime = 0;
+    char buff[64] = { 0 };
+    for( const Entry & entry : m_sinkBatch )
+    {
+        if( entry.LocalTime != bufferTime || buff[0] == 0 )
+        {
+            bufferTime = entry.LocalTime;
+#pragma warning ( suppress: 4996 )
+            strftime( buff, sizeof( buff ), "%H:%M:%S: ", localtime( &bufferTime ) );
+        }
+        m_sinkFileText += buff;
+        m_sinkFileText += entry.Text;
+        m_sinkFileText += "\r\n";
+
+        debugText += entry.Text;
+        debugText += "\n";
+
+#ifdef VA_REMOTERY_INTEGRATION_ENABLED
+        rmt_LogText( entry.Text.c_str() );
+#endif
+    }
+    vaCore::DebugOutput( UTF8ToWide( debugText ) );
+
+    for( Entry & entry : m_sinkBatch )
+        m_sinkDeferred.push_back( std::move( entry ) );
+    SinkPublishDeferred( );
+
+    if( m_outStream.IsOpen() )
+    {
+        m_outStream.Write( m_sinkFileText.c_str( ), (int64)m_sinkFileText.size( ) );
+        if( m_outStream.GetPosition( ) > c_logFileRotateSize )
+            SinkRotateFile( );
+    }
+
+    const int count = (int)m_sinkBatch.size( );
+    m_sinkBatch.clear( );
+
+    // only now visible to Flush
+    m_ringDequeuePos.store( pos, std::memory_order_release );
+    return count;
+}
+
+void vaLog::SinkPublishDeferred( )
+{
+    // never block on m_mutex here: the thread holding it could be waiting in Flush (for ex. vaCore::Error called while drawing
+    // the console) - if it's taken, keep the entries for a later drain
+    if( m_sinkDeferred.size( ) == 0 || !m_mutex.try_lock( ) )
+        return;
+
+    for( Entry & entry : m_sinkDeferred )
+    {
+        // producers race so entries can arrive slightly out of order; FindNewest relies on them being sorted
+        if( entry.SystemTime > m_lastAddedTime )
+            m_lastAddedTime = entry.SystemTime;
+        entry.SystemTime = m_lastAddedTime;
+        m_logEntries.push_back( std::move( entry ) );
+    }
+    m_sinkDeferred.clear( );
 
-    Add( color, txt );
+    if( m_logEntries.size( ) > c_maxEntries )
+    {
+        const int countToDelete = c_maxEntries / 10;
+        m_logEntries.erase( m_logEntries.begin(), m_logEntries.begin()+countToDelete );
+    }
+
+    m_mutex.unlock( );
+}
+
+void vaLog::SinkRotateFile( )
+{
+    m_outStream.Close( );
+
+    wstring dir, name, ext;
+    vaFileTools::SplitPath( m_outFilePath, &dir, &name, &ext );
+    auto rotatedPath = [&]( int index ) { return dir + name + vaStringTools::Format( L".%d", index ) + ext; };
+
+    vaFileTools::DeleteFile( rotatedPath( c_logFileRotateCount ) );
+    for( int i = c_logFileRotateCount - 1; i >= 1; i-- )
+        if( vaFileTools::FileExists( rotatedPath( i ) ) )
+            vaFileTools::MoveFile( rotatedPath( i ), rotatedPath( i + 1 ) );
+    vaFileTools::MoveFile( m_outFilePath, rotatedPath( 1 ) );
+
+    if( m_outStream.Open( m_outFilePath, FileCreationMode::Create, FileAccessMode::Write, FileShareMode::Read ) )
+    {
+        const uint8 utf8BOM[3] = { 0xEF, 0xBB, 0xBF };
+        m_outStream.Write( utf8BOM, sizeof( utf8BOM ) );
+    }
 }
 
 int vaLog::FindNewest( float maxAgeSeconds )
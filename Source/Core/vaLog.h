@@ -24,6 +24,8 @@
 #include "vaGeometry.h"
 #include <time.h>
 #include <chrono>
+#include <memory>
+#include <cstdarg>
 
 #include "Core/System/vaSystemTimer.h"
 #include "Core/System/vaFileStream.h"
@@ -38,17 +40,39 @@ namespace Vanilla
 #define LOG_COLORS_WARNING  (vaVector4( 0.8f, 0.8f, 0.1f, 1.0f ) )
 #define LOG_COLORS_ERROR    (vaVector4( 1.0f, 0.1f, 0.1f, 1.0f ) )
 
+    // Logging is non-blocking for the caller: Add formats the text (into a stack buffer where possible) and pushes it, as
+    // preformatted UTF-8 lines with timestamps, into a fixed-capacity lock-free multi-producer ring. A background sink thread
+    // drains the ring into the UI-visible Entries( ) list (capped at c_maxEntries), the debug output and a rotating log file.
+    // If the ring is ever full the producer yields for a bounded while to let the sink catch up and then drops the entry (the
+    // number of dropped entries gets logged once there's space).
     class vaLog : public vaSingletonBase< vaLog >
     {
     public:
         struct Entry
         {
             vaVector4           Color;
-            wstring             Text;
+            string              Text;           // UTF-8
             time_t              LocalTime;
             double              SystemTime;
 
-            Entry( const vaVector4 & color, const std::wstring & text, time_t localTime, double appTime ) : Color( color ), Text( text ), LocalTime( localTime ), SystemTime( appTime ) { }
+            Entry( const vaVector4 & color, const string & text, time_t localTime, double appTime ) : Color( color ), Text( text ), LocalTime( localTime ), SystemTime( appTime ) { }
+        };
+
+        static const int        c_maxEntries            = 100000;
+        static const int        c_ringCapacity          = 4096;                 // must be power of 2
+        static const int        c_ringEntryTextSize     = 472;                  // UTF-8 bytes per ring entry; longer lines are split into several entries
+        static const int64      c_logFileRotateSize     = 16 * 1024 * 1024;     // once log.txt grows above this it gets renamed to log.1.txt (log.1.txt to log.2.txt, etc.)
+        static const int        c_logFileRotateCount    = 3;                    // number of old log files kept
+
+    private:
+        struct RingEntry
+        {
+            std::atomic<uint64> Sequence;
+            vaVector4           Color;
+            time_t              LocalTime;
+            double              SystemTime;
+            uint32              Length;
+            char                Text[c_ringEntryTextSize];
         };
 
         vector<Entry>           m_logEntries;
@@ -58,9 +82,24 @@ namespace Vanilla
 
         vaRecursiveMutex        m_mutex;
 
-        vaFileStream            m_outStream;
+        // ring (multi-producer, single consumer - the sink thread)
+        std::unique_ptr<RingEntry[]>        m_ring;
+        alignas( 64 ) std::atomic<uint64>   m_ringEnqueuePos;
+        alignas( 64 ) std::atomic<uint64>   m_ringDequeuePos;
+        std::atomic<uint64>                 m_ringDroppedCount;
+
+        // sink
+        std::thread                         m_sinkThread;
+        std::atomic_bool                    m_sinkStop;
+        std::atomic_bool                    m_sinkSleeping;
+        std::mutex                          m_sinkWakeMutex;
+        std::condition_variable             m_sinkWake;
+        vector<Entry>                       m_sinkBatch;
+        vector<Entry>                       m_sinkDeferred;         // drained but not yet in m_logEntries because m_mutex was taken
+        string                              m_sinkFileText;
 
-        static const int        c_maxEntries = 100000;
+        vaFileStream            m_outStream;
+        wstring                 m_outFilePath;
         
 
     private:
@@ -76,7 +115,7 @@ namespace Vanilla
         // must lock mutex if using this to have any meaning
         int                     FindNewest( float maxAgeSeconds );
 
-        // these will lock mutex
+        // these don't block (unless the ring is full, see above)
         void                    Add( const char * messageFormat, ... );
         void                    Add( const wchar_t * messageFormat, ... );
 
@@ -85,10 +124,25 @@ namespace Vanilla
 
 #pragma warning ( suppress: 4996 )
         void                    Add( const vaVector4 & color, const std::wstring & text );
+        void                    AddUTF8( const vaVector4 & color, const char * text, size_t length );
+
+        // blocks until everything added before the call has been written out to the debug output and file; used before fatal
+        // errors so nothing gets lost. Safe to call while holding Mutex( ) - the sink never waits on it, so in that case the
+        // entries only show up in Entries( ) once the mutex is released.
+        void                    Flush( );
 
         vaRecursiveMutex &      Mutex( ) { return m_mutex; }
 
     private:
+        void                    AddV( const vaVector4 & color, const char * messageFormat, va_list args );
+        void                    AddV( const vaVector4 & color, const wchar_t * messageFormat, va_list args );
+        bool                    RingPush( const vaVector4 & color, time_t localTime, double systemTime, const char * text, size_t length );
+
+        void                    SinkThread( );
+        int                     SinkDrain( );
+        void                    SinkPublishDeferred( );
+        void                    SinkRotateFile( );
+        void                    WakeSink( );
     };
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -27,6 +27,49 @@ using namespace Vanilla;
 
 _CrtMemState s_memStateStart;
 
+#ifdef VA_MEMORY_ALLOCATION_COUNTING_ENABLED
+
+// Replacements for the global allocation functions that just count calls; nothrow and sized variants end up here too.
+static std::atomic<int64> s_allocationCount( 0 );
+
+static void * vaCountedAlloc( size_t size )
+{
+    s_allocationCount.fetch_add( 1, std::memory_order_relaxed );
+    void * ret = malloc( ( size > 0 ) ? ( size ) : ( 1 ) );
+    if( ret == nullptr )
+        throw std::bad_alloc( );
+    return ret;
+}
+
+static void * vaCountedAlignedAlloc( size_t size, std::align_val_t alignment )
+{
+    s_allocationCount.fetch_add( 1, std::memory_order_relaxed );
+    void * ret = _aligned_malloc( ( size > 0 ) ? ( size ) : ( 1 ), (size_t)alignment );
+    if( ret == nullptr )
+        throw std::bad_alloc( );
+    return ret;
+}
+
+void * operator new( size_t size )                                              { return vaCountedAlloc( size ); }
+void * operator new[]( size_t size )                                            { return vaCountedAlloc( size ); }
+void operator delete( void * ptr ) noexcept                                     { free( ptr ); }
+void operator delete[]( void * ptr ) noexcept                                   { free( ptr ); }
+void * operator new( size_t size, std::align_val_t alignment )                  { return vaCountedAlignedAlloc( size, alignment ); }
+void * operator new[]( size_t size, std::align_val_t alignment )                { return vaCountedAlignedAlloc( size, alignment ); }
+void operator delete( void * ptr, std::align_val_t ) noexcept                   { _aligned_free( ptr ); }
+void operator delete[]( void * ptr, std::align_val_t ) noexcept                 { _aligned_free( ptr ); }
+
+#endif // VA_MEMORY_ALLOCATION_COUNTING_ENABLED
+
+int64 vaMemory::GetAllocationCount( )
+{
+#ifdef VA_MEMORY_ALLOCATION_COUNTING_ENABLED
+    return s_allocationCount.load( std::memory_order_relaxed );
+#else
+    return -1;
+#endif
+}
+
 void vaMemory::Initialize( )
 {
 
@@ -93,4 +136,82 @@ void vaMemory::Deinitialize()
 #endif
 }
 
+std::atomic<int64> vaFrameArena::s_frameIndex( 0 );
+
+vaFrameArena & vaFrameArena::ThreadLocal( )
+{
+    static thread_local vaFrameArena s_arena;
+    return s_arena;
+}
+
+vaFrameArena::~vaFrameArena( )
+{
+    for( const Block & block : m_blocks )
+        delete[] block.Data;
+    m_blocks.clear( );
+}
 
+size_t vaFrameArena::GetCapacity( ) const
+{
+    size_t ret = 0;
+    for( const Block & block : m_blocks )
+        ret += block.Size;
+    return ret;
+}
+
+void vaFrameArena::Reset( int64 frameIndex )
+{
+    m_highWaterMark = GetHighWaterMark( );
+    m_frameIndex    = frameIndex;
+
+    // previous frame didn't fit in one block - replace them all with a single one that fits everything
+    if( m_blocks.size( ) > 1 )
+    {
+        for( const Block & block : m_blocks )
+            delete[] block.Data;
+        m_blocks.clear( );
+
+        const size_t granularity = 64 * 1024;
+        size_t size = ( ( m_highWaterMark + granularity - 1 ) / granularity ) * granularity;
+        m_blocks.push_back( { new uint8[size], size } );
+    }
+
+    m_usedInFullBlocks = 0;
+    if( m_blocks.size( ) == 0 )
+    {
+        m_current   = 0;
+        m_end       = 0;
+        return;
+    }
+
+#if defined(DEBUG) || defined(_DEBUG)
+    // make any use of last frame's allocations stand out
+    memset( m_blocks[0].Data, 0xFD, m_blocks[0].Size );
+#endif
+
+    m_current   = (uintptr_t)m_blocks[0].Data;
+    m_end       = m_current + m_blocks[0].Size;
+}
+
+void * vaFrameArena::AllocateSlow( size_t size, size_t alignment )
+{
+    size_t blockSize = c_defaultBlockSize;
+    if( m_blocks.size( ) > 0 )
+    {
+        m_usedInFullBlocks += (size_t)( m_current - (uintptr_t)m_blocks.back( ).Data );
+        blockSize = m_blocks.back( ).Size * 2;
+    }
+    if( blockSize < m_highWaterMark )
+        blockSize = m_highWaterMark;
+    if( blockSize < size + alignment )
+        blockSize = size + alignment;
+
+    m_blocks.push_back( { new uint8[blockSize], blockSize } );
+    m_current   = (uintptr_t)m_blocks.back( ).Data;
+    m_end       = m_current + blockSize;
+
+    uintptr_t ret = ( m_current + ( alignment - 1 ) ) & ~( (uintptr_t)alignment - 1 );
+    assert( ret + size <= m_end );
+    m_current = ret + size;
+    return (void*)ret;
+}
@@ -33,8 +33,113 @@ namespace Vanilla
 
        static void						Initialize( );
        static void						Deinitialize( );
+
+    public:
+       // Total number of global operator new calls (all variants, all threads) since the start of the app; only tracked
+       // with VA_MEMORY_ALLOCATION_COUNTING_ENABLED (see vaConfig.h), otherwise returns -1. Sample it before and after a
+       // piece of code to check how many heap allocations it does.
+       static int64                     GetAllocationCount( );
     };
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // vaFrameArena
+    //
+    // Per-thread linear (bump) allocator for transient per-frame data (sort keys and distances, scratch arrays, etc.).
+    // All memory allocated from any thread's arena is released in bulk at the next vaFrameArena::NewFrame( ), which is
+    // called from vaRenderDevice::BeginFrame - so nothing allocated from it must be kept (or used) past the end of the
+    // frame. Individual deallocations are no-ops.
+    // Only use it for function locals: a class member container would still hold (and, with MSVC iterator debugging,
+    // write to) arena memory from an earlier frame - persistent storage should be a plain vector that keeps its capacity.
+    // Each thread's arena resets lazily on its first allocation in a new frame; if during the previous frame it had to
+    // grow (allocate additional blocks), it gets consolidated into a single block big enough for the whole frame so
+    // steady-state frames do no heap allocations at all.
+    class vaFrameArena
+    {
+    public:
+        static const size_t             c_defaultBlockSize  = 256 * 1024;
+
+    private:
+        struct Block
+        {
+            uint8 *                     Data;
+            size_t                      Size;
+        };
+        vector<Block>                   m_blocks;
+        uintptr_t                       m_current           = 0;
+        uintptr_t                       m_end               = 0;
+        size_t                          m_usedInFullBlocks  = 0;        // bytes used in all blocks before the current (last) one, this frame
+        size_t                          m_highWaterMark     = 0;        // max bytes used in a single frame
+        int64                           m_frameIndex        = -1;
+
+        static std::atomic<int64>       s_frameIndex;
+
+    private:
+        vaFrameArena( )                 { }
+
+    public:
+        ~vaFrameArena( );
+        vaFrameArena( const vaFrameArena & )                = delete;
+        vaFrameArena & operator = ( const vaFrameArena & )  = delete;
+
+        // arena of the calling thread
+        static vaFrameArena &           ThreadLocal( );
+
+        // invalidates all arena allocations made so far, on all threads
+        static void                     NewFrame( )                     { s_frameIndex.fetch_add( 1, std::memory_order_release ); }
+        static int64                    GetFrameIndex( )                { return s_frameIndex.load( std::memory_order_acquire ); }
+
+        inline void *                   Allocate( size_t size, size_t alignment = alignof(std::max_align_t) );
+
+        size_t                          GetUsedBytes( ) const           { return ( m_blocks.size( ) == 0 ) ? ( 0 ) : ( m_usedInFullBlocks + (size_t)( m_current - (uintptr_t)m_blocks.back( ).Data ) ); }
+        size_t                          GetCapacity( ) const;
+        size_t                          GetHighWaterMark( ) const       { size_t used = GetUsedBytes( ); return ( m_highWaterMark > used ) ? ( m_highWaterMark ) : ( used ); }
+
+    private:
+        void                            Reset( int64 frameIndex );
+        void *                          AllocateSlow( size_t size, size_t alignment );
+    };
+
+    inline void * vaFrameArena::Allocate( size_t size, size_t alignment )
+    {
+        assert( alignment > 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+
+        const int64 frameIndex = GetFrameIndex( );
+        if( frameIndex != m_frameIndex )
+            Reset( frameIndex );
+
+        uintptr_t ret = ( m_current + ( alignment - 1 ) ) & ~( (uintptr_t)alignment - 1 );
+        if( m_current != 0 && ret + size <= m_end )
+        {
+            m_current = ret + size;
+            return (void*)ret;
+        }
+        return AllocateSlow( size, alignment );
+    }
+
+    // Stateless STL allocator on top of vaFrameArena::ThreadLocal( ) - containers using it must not outlive the frame
+    // they were filled in. Growing a container from a different thread than the one that created it is fine (it will
+    // just continue in that thread's arena).
+    template< class T >
+    struct vaFrameArenaAllocator
+    {
+        typedef T                       value_type;
+
+        vaFrameArenaAllocator( ) noexcept                                       { }
+        template< class U >
+        vaFrameArenaAllocator( const vaFrameArenaAllocator<U> & ) noexcept      { }
+
+        T *                             allocate( size_t count )        { return static_cast<T*>( vaFrameArena::ThreadLocal( ).Allocate( count * sizeof( T ), alignof( T ) ) ); }
+        void                            deallocate( T *, size_t )       { }
+
+        template< class U >
+        bool                            operator == ( const vaFrameArenaAllocator<U> & ) const noexcept { return true; }
+        template< class U >
+        bool                            operator != ( const vaFrameArenaAllocator<U> & ) const noexcept { return false; }
+    };
+
+    template< class T >
+    using vaFrameVector = std::vector< T, vaFrameArenaAllocator<T> >;
+
     // Just a simple generic self-contained memory buffer helper class, for passing data as argument, etc.
     class vaMemoryBuffer
     {
@@ -34,6 +34,7 @@
 //#include <memory>
 //#include <algorithm>
 #include <map>
+#include <unordered_map>
 #include <functional>
 #include <queue>
 #include <atomic>
@@ -83,6 +84,13 @@ namespace Vanilla
     class _Alloc = std::allocator<std::pair<const _Kty, _Ty> > >
     using map = std::map< _Kty, _Ty, _Pr, _Alloc >;
 
+    template<class _Kty,
+    class _Ty,
+    class _Hasher = std::hash<_Kty>,
+    class _Keyeq = std::equal_to<_Kty>,
+    class _Alloc = std::allocator<std::pair<const _Kty, _Ty> > >
+    using unordered_map = std::unordered_map< _Kty, _Ty, _Hasher, _Keyeq, _Alloc >;
+
     template<typename T, size_t stack_capacity>
     using vaStackVector = chromium::StackVector<T, stack_capacity>;
 
@@ -1300,7 +1300,7 @@ void vaUIConsole::Draw( int windowWidth, int windowHeight )
 
                         ImGui::SetCursorPosX( timerSeparatorX );
                         ImGui::SetCursorPosY( lineCursorPosY );
-                        ImGui::TextColored( ImFromVA( entry.Color ), vaStringTools::SimpleNarrow( entry.Text ).c_str( ) );
+                        ImGui::TextColored( ImFromVA( entry.Color ), entry.Text.c_str( ) );
                     }
 
                     // ImGui::NextColumn();
@@ -1419,7 +1419,7 @@ void vaUIConsole::Draw( int windowWidth, int windowHeight )
                     ImGui::TextColored( ImVec4( 0.3f, 0.3f, 0.2f, 1.0f ), buff );
 
                     ImGui::SameLine( timerSeparatorX );
-                    ImGui::TextColored( ImFromVA( entry.Color ), vaStringTools::SimpleNarrow( entry.Text ).c_str( ) );
+                    ImGui::TextColored( ImFromVA( entry.Color ), entry.Text.c_str( ) );
                 }
 
                 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -0,0 +1,574 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaXMLSerialization.h"
+
+using namespace Vanilla;
+
+static inline bool vaXMLIsWhitespace( int c )   { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+static inline bool vaXMLIsNameEnd( int c )      { return c == -1 || vaXMLIsWhitespace( c ) || c == '/' || c == '>' || c == '='; }
+
+// appends the decoded entity (without the '&' and ';') and returns true, or returns false if it's not one we know of
+static bool vaXMLDecodeEntity( const char * entity, string & out )
+{
+    if( entity[0] == '#' )
+    {
+        char * end = nullptr;
+        unsigned long codepoint = ( entity[1] == 'x' || entity[1] == 'X' ) ? ( strtoul( entity + 2, &end, 16 ) ) : ( strtoul( entity + 1, &end, 10 ) );
+        if( end == nullptr || *end != 0 || codepoint == 0 || codepoint > 0x10FFFF )
+            return false;
+        // UTF-8
+        if( codepoint < 0x80 )
+            out.push_back( (char)codepoint );
+        else if( codepoint < 0x800 )
+        {
+            out.push_back( (char)( 0xC0 | ( codepoint >> 6 ) ) );
+            out.push_back( (char)( 0x80 | ( codepoint & 0x3F ) ) );
+        }
+        else if( codepoint < 0x10000 )
+        {
+            out.push_back( (char)( 0xE0 | ( codepoint >> 12 ) ) );
+            out.push_back( (char)( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) ) );
+            out.push_back( (char)( 0x80 | ( codepoint & 0x3F ) ) );
+        }
+        else
+        {
+            out.push_back( (char)( 0xF0 | ( codepoint >> 18 ) ) );
+            out.push_back( (char)( 0x80 | ( ( codepoint >> 12 ) & 0x3F ) ) );
+            out.push_back( (char)( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) ) );
+            out.push_back( (char)( 0x80 | ( codepoint & 0x3F ) ) );
+        }
+        return true;
+    }
+    if( strcmp( entity, "lt" ) == 0 )   { out.push_back( '<' ); return true; }
+    if( strcmp( entity, "gt" ) == 0 )   { out.push_back( '>' ); return true; }
+    if( strcmp( entity, "amp" ) == 0 )  { out.push_back( '&' ); return true; }
+    if( strcmp( entity, "quot" ) == 0 ) { out.push_back( '"' ); return true; }
+    if( strcmp( entity, "apos" ) == 0 ) { out.push_back( '\'' ); return true; }
+    return false;
+}
+
+void vaXMLPullParser::Reset( )
+{
+    m_stack.clear( );
+    m_depth         = 0;
+    m_data          = nullptr;
+    m_dataOffset    = 0;
+    m_dataSize      = 0;
+    m_stream        = nullptr;
+    m_streamLength  = 0;
+    m_error         = false;
+}
+
+bool vaXMLPullParser::Open( const char * data, size_t dataSize )
+{
+    Reset( );
+    m_data          = data;
+    m_dataSize      = (int64)dataSize;
+
+    m_stack.resize( 1 );
+    m_stack[0].ScanOffset = ( Match( 0, "\xEF\xBB\xBF" ) ) ? ( 3 ) : ( 0 );    // skip UTF-8 BOM
+    return FindChild( nullptr, 0 ) != -1;
+}
+
+bool vaXMLPullParser::Open( vaStream & stream )
+{
+    Reset( );
+    if( !stream.CanSeek( ) || !stream.CanRead( ) )
+    {
+        assert( false );
+        return false;
+    }
+    m_stream        = &stream;
+    m_streamLength  = stream.GetLength( );
+    m_window.resize( (size_t)c_windowSize );
+
+    m_stack.resize( 1 );
+    m_stack[0].ScanOffset = ( Match( 0, "\xEF\xBB\xBF" ) ) ? ( 3 ) : ( 0 );    // skip UTF-8 BOM
+    return FindChild( nullptr, 0 ) != -1;
+}
+
+void vaXMLPullParser::Close( )
+{
+    Reset( );
+    m_window.clear( );
+    m_window.shrink_to_fit( );
+}
+
+int vaXMLPullParser::Refill( int64 pos )
+{
+    if( m_stream == nullptr || pos < 0 || pos >= m_streamLength )
+        return -1;
+
+    int64 countRead = 0;
+    m_stream->Seek( pos );
+    m_stream->Read( m_window.data( ), std::min( c_windowSize, m_streamLength - pos ), &countRead );
+    if( countRead <= 0 )
+    {
+        assert( false );            // file changed underneath us?
+        m_streamLength = pos;
+        return -1;
+    }
+    m_data          = m_window.data( );
+    m_dataOffset    = pos;
+    m_dataSize      = countRead;
+    return ( m_data[0] != 0 ) ? ( (int)(uint8)m_data[0] ) : ( -1 );
+}
+
+bool vaXMLPullParser::Fail( int64 pos, const char * reason )
+{
+    if( !m_error )
+    {
+        VA_LOG_ERROR( "vaXMLPullParser - %s at offset %lld", reason, (long long)pos );
+        assert( false );
+    }
+    m_error = true;
+    return false;
+}
+
+bool vaXMLPullParser::Match( int64 pos, const char * str )
+{
+    for( ; *str != 0; str++, pos++ )
+        if( Peek( pos ) != (int)(uint8)*str )
+            return false;
+    return true;
+}
+
+bool vaXMLPullParser::SkipPast( int64 & pos, const char * terminator )
+{
+    const int first = (int)(uint8)terminator[0];
+    for( int c; ( c = Peek( pos ) ) != -1; pos++ )
+    {
+        if( c == first && Match( pos, terminator ) )
+        {
+            pos += (int64)strlen( terminator );
+            return true;
+        }
+    }
+    return false;
+}
+
+// declarations, comments, CDATA (outside of the leading text) and DTDs - none of which we care about
+bool vaXMLPullParser::SkipMarkup( int64 & pos )
+{
+    if( Match( pos, "<?" ) )
+        return SkipPast( pos, "?>" );
+    if( Match( pos, "<!--" ) )
+        return SkipPast( pos, "-->" );
+    if( Match( pos, "<![CDATA[" ) )
+        return SkipPast( pos, "]]>" );
+
+    // <!DOCTYPE ...> & co., possibly with an internal subset in []
+    int bracketDepth = 0;
+    for( int c; ( c = Peek( pos ) ) != -1; pos++ )
+    {
+        if( c == '[' )
+            bracketDepth++;
+        else if( c == ']' )
+            bracketDepth--;
+        else if( c == '>' && bracketDepth <= 0 )
+        {
+            pos++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool vaXMLPullParser::ParseName( int64 & pos, string & outName )
+{
+    outName.clear( );
+    for( int c; !vaXMLIsNameEnd( c = Peek( pos ) ); pos++ )
+        outName.push_back( (char)c );
+    return outName.size( ) > 0;
+}
+
+bool vaXMLPullParser::SkipName( int64 & pos )
+{
+    const int64 start = pos;
+    while( !vaXMLIsNameEnd( Peek( pos ) ) )
+        pos++;
+    return pos != start;
+}
+
+// reads up to (not including) terminator, resolving entities and normalizing line endings the same way tinyxml2 does
+bool vaXMLPullParser::ParseCharacters( int64 & pos, int terminator, string & outValue )
+{
+    outValue.clear( );
+    for( ;; )
+    {
+        int c = Peek( pos );
+        if( c == -1 )
+            return false;
+        if( c == terminator )
+            return true;
+        pos++;
+
+        if( c == '\r' )
+        {
+            if( Peek( pos ) == '\n' )
+                pos++;
+            outValue.push_back( '\n' );
+        }
+        else if( c == '&' )
+        {
+            char entity[16];
+            int length = 0;
+            int64 entityPos = pos;
+            for( int e; length < (int)_countof( entity ) - 1 && ( e = Peek( entityPos ) ) != -1 && e != ';' && e != terminator; entityPos++ )
+                entity[length++] = (char)e;
+            entity[length] = 0;
+            if( Peek( entityPos ) == ';' && vaXMLDecodeEntity( entity, outValue ) )
+                pos = entityPos + 1;
+            else
+                outValue.push_back( '&' );      // not an entity we know of - keep as is
+        }
+        else
+            outValue.push_back( (char)c );
+    }
+}
+
+bool vaXMLPullParser::ParseStartTag( int64 offset, Element & outElement )
+{
+    Element & e = outElement;
+    e.Offset            = -1;       // not valid until fully parsed
+    e.AttributeCount    = 0;
+    e.HasText           = false;
+    e.Text.clear( );
+    e.ChildCount        = 0;
+    e.PendingSkip       = false;
+    e.Complete          = false;
+    e.IndexInParent     = -1;
+
+    int64 pos = offset;
+    if( Peek( pos ) != '<' )
+        return Fail( pos, "expected an element" );
+    pos++;
+    if( !ParseName( pos, e.Name ) )
+        return Fail( pos, "invalid element name" );
+
+    for( ;; )
+    {
+        while( vaXMLIsWhitespace( Peek( pos ) ) )
+            pos++;
+
+        int c = Peek( pos );
+        if( c == '/' )
+        {
+            if( Peek( pos + 1 ) != '>' )
+                return Fail( pos, "expected '>'" );
+            e.ScanOffset    = pos + 2;
+            e.Complete      = true;
+            e.Offset        = offset;
+            return true;
+        }
+        if( c == '>' )
+        {
+            pos++;
+            break;
+        }
+
+        if( e.AttributeCount == (int)e.Attributes.size( ) )
+            e.Attributes.emplace_back( );
+        pair<string, string> & attribute = e.Attributes[e.AttributeCount];
+        if( !ParseName( pos, attribute.first ) )
+            return Fail( pos, "invalid attribute name" );
+        while( vaXMLIsWhitespace( Peek( pos ) ) )
+            pos++;
+        if( Peek( pos ) != '=' )
+            return Fail( pos, "expected '='" );
+        pos++;
+        while( vaXMLIsWhitespace( Peek( pos ) ) )
+            pos++;
+        const int quote = Peek( pos );
+        if( quote != '"' && quote != '\'' )
+            return Fail( pos, "expected a quoted attribute value" );
+        pos++;
+        if( !ParseCharacters( pos, quote, attribute.second ) )
+            return Fail( pos, "unterminated attribute value" );
+        pos++;
+        e.AttributeCount++;
+    }
+
+    // leading text; whitespace-only text is not a text node (same as with tinyxml2)
+    const int64 textStart = pos;
+    while( vaXMLIsWhitespace( Peek( pos ) ) )
+        pos++;
+    if( Match( pos, "<![CDATA[" ) )
+    {
+        pos += 9;
+        for( int c; !Match( pos, "]]>" ); pos++ )
+        {
+            if( ( c = Peek( pos ) ) == -1 )
+                return Fail( pos, "unterminated CDATA" );
+            e.Text.push_back( (char)c );
+        }
+        pos += 3;
+        e.HasText = true;
+    }
+    else if( Peek( pos ) != '<' )
+    {
+        pos = textStart;
+        if( !ParseCharacters( pos, '<', e.Text ) )
+            return Fail( pos, "unterminated element" );
+        e.HasText = true;
+    }
+
+    e.ScanOffset    = pos;
+    e.Offset        = offset;
+    return true;
+}
+
+// skips a whole element (pos is at its '<') without storing anything
+bool vaXMLPullParser::SkipElement( int64 & pos )
+{
+    int depth = 0;
+    for( ;; )
+    {
+        const int next = Peek( pos + 1 );
+        if( next == '/' )
+        {
+            pos += 2;
+            if( !SkipName( pos ) )
+                return Fail( pos, "invalid end tag" );
+            while( vaXMLIsWhitespace( Peek( pos ) ) )
+                pos++;
+            if( Peek( pos ) != '>' )
+                return Fail( pos, "expected '>'" );
+            pos++;
+            if( --depth == 0 )
+                return true;
+        }
+        else if( next == '!' || next == '?' )
+        {
+            if( !SkipMarkup( pos ) )
+                return Fail( pos, "unterminated markup" );
+        }
+        else
+        {
+            pos++;
+            if( !SkipName( pos ) )
+                return Fail( pos, "invalid element name" );
+            int prev = 0;
+            for( ;; )
+            {
+                const int c = Peek( pos );
+                if( c == -1 )
+                    return Fail( pos, "unterminated start tag" );
+                if( c == '"' || c == '\'' )
+                {
+                    for( pos++; Peek( pos ) != c; pos++ )
+                        if( Peek( pos ) == -1 )
+                            return Fail( pos, "unterminated attribute value" );
+                }
+                else if( c == '>' )
+                {
+                    pos++;
+                    break;
+                }
+                prev = c;
+                pos++;
+            }
+            if( prev != '/' )
+                depth++;
+            if( depth == 0 )
+                return true;
+        }
+
+        // on to the next markup; text in between is of no interest
+        for( int c; ( c = Peek( pos ) ) != '<'; pos++ )
+            if( c == -1 )
+                return Fail( pos, "unexpected end of data" );
+    }
+}
+
+// scans the element's content up to the next child element and adds it to the index; returns false once the end
+// of the element is reached
+bool vaXMLPullParser::IndexNextChild( Element & element )
+{
+    Element & e = element;
+    if( e.Complete || m_error )
+        return false;
+
+    int64 pos = e.ScanOffset;
+    if( e.PendingSkip )
+    {
+        if( !SkipElement( pos ) )
+            return false;
+        e.PendingSkip   = false;
+        e.ScanOffset    = pos;
+    }
+
+    for( ;; )
+    {
+        const int c = Peek( pos );
+        if( c == -1 )
+        {
+            if( e.Offset != -1 )
+                return Fail( pos, "unexpected end of data" );
+            e.ScanOffset    = pos;
+            e.Complete      = true;
+            return false;
+        }
+        if( c != '<' )
+        {
+            pos++;      // text other than the leading one is ignored
+            continue;
+        }
+
+        const int next = Peek( pos + 1 );
+        if( next == '!' || next == '?' )
+        {
+            if( !SkipMarkup( pos ) )
+                return Fail( pos, "unterminated markup" );
+            continue;
+        }
+        if( next == '/' )
+        {
+            if( e.Offset == -1 )
+                return Fail( pos, "unexpected end tag" );
+            int64 namePos = pos + 2;
+            for( size_t i = 0; i < e.Name.size( ); i++, namePos++ )
+                if( Peek( namePos ) != (int)(uint8)e.Name[i] )
+                    return Fail( pos, "mismatched end tag" );
+            if( !vaXMLIsNameEnd( Peek( namePos ) ) )
+                return Fail( pos, "mismatched end tag" );
+            while( vaXMLIsWhitespace( Peek( namePos ) ) )
+                namePos++;
+            if( Peek( namePos ) != '>' )
+                return Fail( namePos, "expected '>'" );
+            e.ScanOffset    = namePos + 1;
+            e.Complete      = true;
+            return false;
+        }
+
+        // a child - index it, but leave skipping over it for later as it will likely be opened next
+        if( e.ChildCount == (int)e.Children.size( ) )
+            e.Children.emplace_back( );
+        ChildEntry & child = e.Children[e.ChildCount];
+        int64 namePos = pos + 1;
+        if( !ParseName( namePos, child.Name ) )
+            return Fail( pos, "invalid element name" );
+        child.Offset    = pos;
+        e.ChildCount++;
+        e.ScanOffset    = pos;
+        e.PendingSkip   = true;
+        return true;
+    }
+}
+
+int vaXMLPullParser::FindChild( const char * name, int startIndex )
+{
+    Element & e = m_stack[m_depth];
+    for( int i = startIndex; ; i++ )
+    {
+        if( i >= e.ChildCount && !IndexNextChild( e ) )
+            return -1;
+        if( name == nullptr || e.Children[i].Name == name )
+            return i;
+    }
+}
+
+bool vaXMLPullParser::OpenChildAt( int index )
+{
+    const int64 offset = m_stack[m_depth].Children[index].Offset;
+    if( (int)m_stack.size( ) <= m_depth + 1 )
+        m_stack.emplace_back( );
+
+    // if it's what was open at this depth before, everything (including the index of its children) is still valid
+    Element & child = m_stack[m_depth + 1];
+    if( child.Offset != offset && !ParseStartTag( offset, child ) )
+        return false;
+    child.IndexInParent = index;
+    m_depth++;
+    return true;
+}
+
+bool vaXMLPullParser::OpenChild( const char * name )
+{
+    if( !IsOpen( ) || m_error )
+        return false;
+    const int index = FindChild( name, 0 );
+    return index != -1 && OpenChildAt( index );
+}
+
+bool vaXMLPullParser::OpenNextSibling( const char * name )
+{
+    if( m_depth == 0 || m_error )
+        return false;
+    const int currentIndex = m_stack[m_depth].IndexInParent;
+    if( !PopToParent( ) )
+        return false;
+    const int index = FindChild( name, currentIndex + 1 );
+    if( index == -1 )
+    {
+        OpenChildAt( currentIndex );   // stay on the current one, same as tinyxml2
+        return false;
+    }
+    return OpenChildAt( index );
+}
+
+bool vaXMLPullParser::PopToParent( )
+{
+    if( m_depth == 0 )
+        return false;
+
+    // if the parent's scan stopped at this element, finish it here so that the parent can continue past it without
+    // going through it again
+    Element & child     = m_stack[m_depth];
+    Element & parent    = m_stack[m_depth - 1];
+    if( parent.PendingSkip && parent.ChildCount - 1 == child.IndexInParent )
+    {
+        while( IndexNextChild( child ) ) { }
+        if( child.Complete )
+        {
+            parent.ScanOffset   = child.ScanOffset;
+            parent.PendingSkip  = false;
+        }
+    }
+    m_depth--;
+    return true;
+}
+
+int vaXMLPullParser::CountChildren( const char * name )
+{
+    if( !IsOpen( ) || m_error )
+        return -1;
+    Element & e = m_stack[m_depth];
+    while( IndexNextChild( e ) ) { }
+    if( m_error )
+        return -1;
+
+    int count = 0;
+    for( int i = 0; i < e.ChildCount; i++ )
+        if( name == nullptr || e.Children[i].Name == name )
+            count++;
+    return count;
+}
+
+const char * vaXMLPullParser::FindAttribute( const char * name ) const
+{
+    if( m_depth == 0 )
+        return nullptr;
+    const Element & e = m_stack[m_depth];
+    for( int i = 0; i < e.AttributeCount; i++ )
+        if( e.Attributes[i].first == name )
+            return e.Attributes[i].second.c_str( );
+    return nullptr;
+}
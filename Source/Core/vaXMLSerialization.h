@@ -48,6 +48,106 @@ namespace Vanilla
         static const bool has = sizeof(test<T>(0)) == sizeof(YesType);
     };
 
+    // Forward-only (pull) XML reader used by vaXMLSerializer for reading. Instead of building the whole document first, it
+    // tokenizes the input as elements are requested and only keeps the chain of currently open elements; for each of
+    // them, an index (name and input offset) of the child elements scanned so far. Subtrees that are skipped over are
+    // not stored - if they are requested later, the input is re-read from their offset - so memory use depends on the
+    // depth and the width of the tree, not on its size. Input can be a memory buffer (used in-place) or a seekable
+    // stream (read through a small window); either must remain valid for as long as the parser is in use.
+    // Same lookup semantics as tinyxml2 (first child / next sibling element by name); the text of an element is only
+    // its leading text (or CDATA), same as tinyxml2::XMLElement::GetText.
+    class vaXMLPullParser
+    {
+        struct ChildEntry
+        {
+            string                  Name;
+            int64                   Offset;
+        };
+
+        struct Element
+        {
+            int64                   Offset          = -1;       // of the start tag's '<'; -1 for the document itself
+            string                  Name;
+            vector<pair<string, string>>
+                                    Attributes;
+            int                     AttributeCount  = 0;        // Attributes is only ever grown so that the strings can be reused
+            string                  Text;
+            bool                    HasText         = false;
+
+            int64                   ScanOffset      = 0;        // children have been scanned and indexed up to here
+            bool                    PendingSkip     = false;    // ScanOffset points at the last indexed child, which still has to be skipped
+            bool                    Complete        = false;    // end tag reached (ScanOffset is past it)
+            vector<ChildEntry>      Children;
+            int                     ChildCount      = 0;        // Children is only ever grown so that the strings can be reused
+            int                     IndexInParent   = -1;
+        };
+
+        // element stack; [0] is the document and [m_depth] is the current element. Entries above m_depth are what was
+        // open there last and are reused if the same element (same offset) gets opened again.
+        vector<Element>             m_stack;
+        int                         m_depth         = 0;
+
+        // input - either the whole thing in memory or a window into m_stream
+        const char *                m_data          = nullptr;
+        int64                       m_dataOffset    = 0;
+        int64                       m_dataSize      = 0;
+        vaStream *                  m_stream        = nullptr;
+        int64                       m_streamLength  = 0;
+        vector<char>                m_window;
+
+        bool                        m_error         = false;
+
+        static constexpr int64      c_windowSize    = 64 * 1024;
+
+    public:
+        vaXMLPullParser( )          { }
+        vaXMLPullParser( const vaXMLPullParser & ) = delete;
+        vaXMLPullParser & operator = ( const vaXMLPullParser & ) = delete;
+
+        // returns false if there's no root element
+        bool                        Open( const char * data, size_t dataSize );
+        bool                        Open( vaStream & stream );
+        void                        Close( );
+
+        bool                        IsOpen( ) const                 { return m_stack.size( ) > 0; }
+        bool                        HasError( ) const               { return m_error; }
+
+        // 0 means no element is open (document level)
+        int                         GetDepth( ) const               { return m_depth; }
+
+        // first child element of the current element (or the first root element if at document level) with the given
+        // name (or any name if nullptr); becomes the current element
+        bool                        OpenChild( const char * name );
+        // next sibling element of the current element with the given name (or any name if nullptr); replaces the current element
+        bool                        OpenNextSibling( const char * name );
+        bool                        PopToParent( );
+
+        // number of child elements of the current element with the given name (or all if nullptr); scans to the end of it
+        int                         CountChildren( const char * name );
+
+        // current element info; nullptr if not found or at document level
+        const char *                GetName( ) const                { return ( m_depth > 0 ) ? ( m_stack[m_depth].Name.c_str( ) ) : ( nullptr ); }
+        const char *                GetText( ) const                { return ( m_depth > 0 && m_stack[m_depth].HasText ) ? ( m_stack[m_depth].Text.c_str( ) ) : ( nullptr ); }
+        const char *                FindAttribute( const char * name ) const;
+
+    private:
+        void                        Reset( );
+        int                         Peek( int64 pos )               { int64 rel = pos - m_dataOffset; if( rel >= 0 && rel < m_dataSize ) return ( m_data[rel] != 0 ) ? ( (int)(uint8)m_data[rel] ) : ( -1 ); return Refill( pos ); }
+        int                         Refill( int64 pos );
+        bool                        Match( int64 pos, const char * str );
+        bool                        SkipPast( int64 & pos, const char * terminator );
+        bool                        SkipMarkup( int64 & pos );
+        bool                        ParseName( int64 & pos, string & outName );
+        bool                        SkipName( int64 & pos );
+        bool                        ParseCharacters( int64 & pos, int terminator, string & outValue );
+        bool                        ParseStartTag( int64 offset, Element & outElement );
+        bool                        SkipElement( int64 & pos );
+        bool                        IndexNextChild( Element & element );
+        int                         FindChild( const char * name, int startIndex );
+        bool                        OpenChildAt( int index );
+        bool                        Fail( int64 pos, const char * reason );
+    };
+
     class vaXMLSerializer
     {
     private:
@@ -57,8 +157,8 @@ namespace Vanilla
         int                         m_writeElementStackDepth    = 0;
         bool                        m_writeElementPrevWasOpen   = false;    // used to figure out if we just wrote a leaf or another element(s)
 
-        tinyxml2::XMLDocument       m_readDocument;
-        tinyxml2::XMLElement *      m_currentReadElement        = nullptr;
+        vaXMLPullParser             m_reader;
+        shared_ptr<vaFileStream>    m_readFile;                             // only if we opened the file ourselves
 
         bool                        m_isReading                 = false;
         bool                        m_isWriting                 = false;
@@ -73,26 +173,26 @@ namespace Vanilla
                                     m_objectConstructors;
 
     public:
-        // parse data, set to loading mode
+        // set to loading mode; data is parsed as it gets read and is not copied so it must remain valid until done reading
         vaXMLSerializer( const char * inputData, size_t dataSize )
         {
             InitReadingFromBuffer( inputData, dataSize );
         }
 
-        // parse data, set to loading mode
+        // set to loading mode; data is parsed as it gets read so the stream must remain open until done reading
         explicit vaXMLSerializer( vaFileStream & fileStream )
         {
             InitReadingFromFileStream( fileStream );
         }
 
-        // parse data, set to loading mode
+        // set to loading mode
         explicit vaXMLSerializer( const wstring & filePath )
         {
-            vaFileStream inFile;
-            if( !inFile.Open( filePath, FileCreationMode::Open ) )
+            m_readFile = std::make_shared<vaFileStream>( );
+            if( !m_readFile->Open( filePath, FileCreationMode::Open, FileAccessMode::Read ) )
                 VA_LOG_ERROR( L"vaXMLSerializer::WriterSaveToFile(%s) - unable to create file for saving", filePath.c_str( ) );
             else
-                InitReadingFromFileStream( inFile );
+                InitReadingFromFileStream( *m_readFile );
         }
 
         // open printer, set to storing mode
@@ -100,7 +200,6 @@ namespace Vanilla
         {
             m_isWriting = true;
             m_isReading = false;
-            m_currentReadElement = nullptr;
 
             m_writeElementNamesMapStack.push_back( map<string, bool>{ } );
 
@@ -115,7 +214,7 @@ namespace Vanilla
 
         ~vaXMLSerializer( )
         {
-            assert( m_currentReadElement == nullptr );      // forgot to ReadPopToParentElement?
+            assert( m_reader.GetDepth( ) == 0 );            // forgot to ReadPopToParentElement?
             assert( m_writeElementNameStack.size() == 0 );  // forgot to WriteCloseElement?
             if( IsWriting() )
                 { assert( m_writeElementNamesMapStack.size() == 1 ); }
@@ -133,31 +232,38 @@ namespace Vanilla
                 assert( false ); return;
             }
 
-            if( fileStream.GetPosition( ) != 0 )
-                fileStream.Seek( 0 );
-
-            char* buffer = new char[fileLength + 1];
-            if( fileStream.Read( buffer, fileLength ) )
-            {
-                buffer[fileLength] = 0; // null-terminate
-                InitReadingFromBuffer( buffer, fileLength + 1 );
-            }
-            else { assert( false ); } // error reading?
-            delete[] buffer;
+            assert( m_isReading == false );
+            assert( m_isWriting == false );
+            m_isReading = m_reader.Open( fileStream );
+            assert( m_isReading ); // error parsing?
+            InitReadingVersion( );
         }
 
         void InitReadingFromBuffer( const char * inputData, size_t dataSize )
         {
             assert( m_isReading == false );
             assert( m_isWriting == false );
-            assert( m_currentReadElement == nullptr );
-            m_isReading = m_readDocument.Parse( inputData, dataSize ) == tinyxml2::XMLError::XML_SUCCESS;
+            m_isReading = m_reader.Open( inputData, dataSize );
             assert( m_isReading ); // error parsing?
+            InitReadingVersion( );
+        }
+
+        bool                        IsReading( ) const { return m_isReading; }
+        bool                        IsWriting( ) const { return m_isWriting; }
+
+        // reading is done on the fly, so errors in the data might only get detected after IsReading() already returned true
+        bool                        HasReadError( ) const { return m_reader.HasError( ); }
+
+        tinyxml2::XMLPrinter &      GetWritePrinter( ) { assert( m_isWriting ); return m_writePrinter; }
+
+    private:
 
+        void InitReadingVersion( )
+        {
             // version info
-            if( ReaderAdvanceToChildElement( "vaXMLSerializer" ) )
+            if( m_isReading && ReaderAdvanceToChildElement( "vaXMLSerializer" ) )
             {
-                if( m_currentReadElement->QueryIntText( &m_formatVersion ) != tinyxml2::XML_SUCCESS )
+                if( !ReaderQueryText( m_formatVersion ) )
                 { assert( false ); }        // can't read version?
                 if( m_formatVersion < 1 || m_formatVersion > 1 )
                 { assert( false ); }        // unsupported version
@@ -165,16 +271,14 @@ namespace Vanilla
             }
         }
 
-        bool                        IsReading( ) const { return m_isReading; }
-        bool                        IsWriting( ) const { return m_isWriting; }
-
-        tinyxml2::XMLPrinter &      GetWritePrinter( ) { assert( m_isWriting ); return m_writePrinter; }
-
-        tinyxml2::XMLDocument &     GetReadDocument( ) { assert( m_isReading ); return m_readDocument; }
-
-        tinyxml2::XMLElement *      GetCurrentReadElement( );
-
-    private:
+        // text of the current element; same conversions (and failure cases) as tinyxml2::XMLElement::Query*Text
+        const char *                ReaderGetText( ) const                      { return ( m_isReading ) ? ( m_reader.GetText( ) ) : ( nullptr ); }
+        bool                        ReaderQueryText( bool & val ) const         { const char * text = ReaderGetText( ); return text != nullptr && tinyxml2::XMLUtil::ToBool( text, &val ); }
+        bool                        ReaderQueryText( int32 & val ) const        { const char * text = ReaderGetText( ); return text != nullptr && tinyxml2::XMLUtil::ToInt( text, &val ); }
+        bool                        ReaderQueryText( uint32 & val ) const       { const char * text = ReaderGetText( ); return text != nullptr && tinyxml2::XMLUtil::ToUnsigned( text, &val ); }
+        bool                        ReaderQueryText( int64 & val ) const        { const char * text = ReaderGetText( ); return text != nullptr && tinyxml2::XMLUtil::ToInt64( text, &val ); }
+        bool                        ReaderQueryText( float & val ) const        { const char * text = ReaderGetText( ); return text != nullptr && tinyxml2::XMLUtil::ToFloat( text, &val ); }
+        bool                        ReaderQueryText( double & val ) const       { const char * text = ReaderGetText( ); return text != nullptr && tinyxml2::XMLUtil::ToDouble( text, &val ); }
 
         bool                        ReaderAdvanceToChildElement( const char * name );
         bool                        ReaderAdvanceToSiblingElement( const char * name );
@@ -225,20 +329,20 @@ namespace Vanilla
         bool                        WriteAttribute( const char * name, vaOrientedBoundingBox & val );
 
     private:
-        bool                        SerializeInternal( bool & val )                     { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( m_currentReadElement == nullptr || !m_isReading ) return false; return m_currentReadElement->QueryBoolText( &val )  == tinyxml2::XML_SUCCESS; }
-        bool                        SerializeInternal( int32 & val )                    { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( m_currentReadElement == nullptr || !m_isReading ) return false; return m_currentReadElement->QueryIntText( &val )  == tinyxml2::XML_SUCCESS; }
-        bool                        SerializeInternal( uint32 & val )                   { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( m_currentReadElement == nullptr || !m_isReading ) return false; return m_currentReadElement->QueryUnsignedText( &val )  == tinyxml2::XML_SUCCESS; }
-        bool                        SerializeInternal( int64 & val )                    { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( m_currentReadElement == nullptr || !m_isReading ) return false; return m_currentReadElement->QueryInt64Text( &val )  == tinyxml2::XML_SUCCESS; }
-        bool                        SerializeInternal( float & val )                    { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( m_currentReadElement == nullptr || !m_isReading ) return false; return m_currentReadElement->QueryFloatText( &val )  == tinyxml2::XML_SUCCESS; }
-        bool                        SerializeInternal( double & val )                   { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( m_currentReadElement == nullptr || !m_isReading ) return false; return m_currentReadElement->QueryDoubleText( &val )  == tinyxml2::XML_SUCCESS; }
-        bool                        SerializeInternal( string & val )                   { if( m_isWriting ) { m_writePrinter.PushText( val.c_str(), false ); return true; };                    if( m_currentReadElement == nullptr || !m_isReading ) return false; val = (m_currentReadElement->GetText( ) == nullptr)?(""):(m_currentReadElement->GetText( )); return true; }
+        bool                        SerializeInternal( bool & val )                     { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( !m_isReading ) return false; return ReaderQueryText( val ); }
+        bool                        SerializeInternal( int32 & val )                    { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( !m_isReading ) return false; return ReaderQueryText( val ); }
+        bool                        SerializeInternal( uint32 & val )                   { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( !m_isReading ) return false; return ReaderQueryText( val ); }
+        bool                        SerializeInternal( int64 & val )                    { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( !m_isReading ) return false; return ReaderQueryText( val ); }
+        bool                        SerializeInternal( float & val )                    { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( !m_isReading ) return false; return ReaderQueryText( val ); }
+        bool                        SerializeInternal( double & val )                   { if( m_isWriting ) { m_writePrinter.PushText( val ); return true; };                                   if( !m_isReading ) return false; return ReaderQueryText( val ); }
+        bool                        SerializeInternal( string & val )                   { if( m_isWriting ) { m_writePrinter.PushText( val.c_str(), false ); return true; };                    if( !m_isReading || m_reader.GetDepth( ) == 0 ) return false; val = (ReaderGetText( ) == nullptr)?(""):(ReaderGetText( )); return true; }
         bool                        SerializeInternal( pair<string, string> & val )     { return SerializeInternal( "first", val.first, std::false_type() ) && SerializeInternal( "second", val.second, std::false_type() ); }
         bool                        SerializeInternal( pair<string, bool> & val )       { return SerializeInternal( "first", val.first, std::false_type() ) && SerializeInternal( "second", val.second, std::false_type() ); }
-        bool                        SerializeInternal( vaGUID & val )                   { if( m_isWriting ) { m_writePrinter.PushText( vaCore::GUIDToStringA( val ).c_str() ); return true; };  if( m_currentReadElement == nullptr || !m_isReading || m_currentReadElement->GetText( ) == nullptr ) return false; val = vaCore::GUIDFromStringA( m_currentReadElement->GetText() ); return true; }
-        bool                        SerializeInternal( vaVector3 & val )                { if( m_isWriting ) { m_writePrinter.PushText( vaVector3::ToString( val ).c_str() ); return true; };    if( m_currentReadElement == nullptr || !m_isReading || m_currentReadElement->GetText( ) == nullptr ) return false; return vaVector3::FromString( m_currentReadElement->GetText(), val ); }
-        bool                        SerializeInternal( vaVector4 & val )                { if( m_isWriting ) { m_writePrinter.PushText( vaVector4::ToString( val ).c_str() ); return true; };    if( m_currentReadElement == nullptr || !m_isReading || m_currentReadElement->GetText( ) == nullptr ) return false; return vaVector4::FromString( m_currentReadElement->GetText(), val ); }
-        bool                        SerializeInternal( vaMatrix4x4 & val )              { if( m_isWriting ) { m_writePrinter.PushText( vaMatrix4x4::ToString( val ).c_str() ); return true; };    if( m_currentReadElement == nullptr || !m_isReading || m_currentReadElement->GetText( ) == nullptr ) return false; return vaMatrix4x4::FromString( m_currentReadElement->GetText(), val ); }
-        bool                        SerializeInternal( vaOrientedBoundingBox & val )    { if( m_isWriting ) { m_writePrinter.PushText( vaOrientedBoundingBox::ToString( val ).c_str() ); return true; };    if( m_currentReadElement == nullptr || !m_isReading || m_currentReadElement->GetText( ) == nullptr ) return false; return vaOrientedBoundingBox::FromString( m_currentReadElement->GetText(), val ); }
+        bool                        SerializeInternal( vaGUID & val )                   { if( m_isWriting ) { m_writePrinter.PushText( vaCore::GUIDToStringA( val ).c_str() ); return true; };  if( !m_isReading || ReaderGetText( ) == nullptr ) return false; val = vaCore::GUIDFromStringA( ReaderGetText( ) ); return true; }
+        bool                        SerializeInternal( vaVector3 & val )                { if( m_isWriting ) { m_writePrinter.PushText( vaVector3::ToString( val ).c_str() ); return true; };    if( !m_isReading || ReaderGetText( ) == nullptr ) return false; return vaVector3::FromString( ReaderGetText( ), val ); }
+        bool                        SerializeInternal( vaVector4 & val )                { if( m_isWriting ) { m_writePrinter.PushText( vaVector4::ToString( val ).c_str() ); return true; };    if( !m_isReading || ReaderGetText( ) == nullptr ) return false; return vaVector4::FromString( ReaderGetText( ), val ); }
+        bool                        SerializeInternal( vaMatrix4x4 & val )              { if( m_isWriting ) { m_writePrinter.PushText( vaMatrix4x4::ToString( val ).c_str() ); return true; };    if( !m_isReading || ReaderGetText( ) == nullptr ) return false; return vaMatrix4x4::FromString( ReaderGetText( ), val ); }
+        bool                        SerializeInternal( vaOrientedBoundingBox & val )    { if( m_isWriting ) { m_writePrinter.PushText( vaOrientedBoundingBox::ToString( val ).c_str() ); return true; };    if( !m_isReading || ReaderGetText( ) == nullptr ) return false; return vaOrientedBoundingBox::FromString( ReaderGetText( ), val ); }
         bool                        SerializeInternal( vaXMLSerializable & val )        { return val.Serialize( *this ); }
 
         bool                        TypedSerializeInternal( shared_ptr<vaXMLSerializableObject>& object );
@@ -344,81 +448,68 @@ namespace Vanilla
         return it->second( );
     }
 
-    inline tinyxml2::XMLElement * vaXMLSerializer::GetCurrentReadElement( ) { return m_currentReadElement; }
     inline bool                   vaXMLSerializer::ReaderAdvanceToChildElement( const char * name )
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        tinyxml2::XMLElement * e = ( m_currentReadElement != nullptr ) ? ( m_currentReadElement->FirstChildElement( name ) ) : ( m_readDocument.FirstChildElement( name ) );
-        if( e != nullptr ) { m_currentReadElement = e; return true; } return false;
+        return m_reader.OpenChild( name );
     }
     inline bool                   vaXMLSerializer::ReaderAdvanceToSiblingElement( const char * name )
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        tinyxml2::XMLElement * e = ( m_currentReadElement != nullptr ) ? ( m_currentReadElement->NextSiblingElement( name ) ) : ( m_readDocument.NextSiblingElement( name ) );
-        if( e != nullptr )
-        {
-            m_currentReadElement = e; return true;
-        }
-        return false;
+        return m_reader.OpenNextSibling( name );
     }
     inline bool                   vaXMLSerializer::ReaderPopToParentElement( const char * nameToVerify )
     {
         assert( m_isReading ); if( !m_isReading ) return false;
         if( nameToVerify != nullptr )
         {
-            assert( m_currentReadElement != nullptr && strncmp( m_currentReadElement->Name(), nameToVerify, 32768 ) == 0 );
+            assert( m_reader.GetDepth( ) > 0 && strncmp( m_reader.GetName( ), nameToVerify, 32768 ) == 0 );
         }
-
-        if( m_currentReadElement == nullptr )
-            return false;
-        tinyxml2::XMLElement * e = ( m_currentReadElement->Parent( ) != nullptr ) ? ( m_currentReadElement->Parent( )->ToElement( ) ) : ( nullptr );
-        m_currentReadElement = e;
-        return true;
+        return m_reader.PopToParent( );
     }
     inline bool                   vaXMLSerializer::ReadBoolAttribute( const char * name, bool & outVal )   const
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        if( m_currentReadElement == nullptr )   return false;
-        return m_currentReadElement->QueryBoolAttribute( name, &outVal ) == tinyxml2::XML_SUCCESS;
+        const char * value = m_reader.FindAttribute( name );
+        return value != nullptr && tinyxml2::XMLUtil::ToBool( value, &outVal );
     }
     inline bool                   vaXMLSerializer::ReadInt32Attribute( const char * name, int32 & outVal )   const
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        if( m_currentReadElement == nullptr )   return false;
-        return m_currentReadElement->QueryIntAttribute( name, &outVal ) == tinyxml2::XML_SUCCESS;
+        const char * value = m_reader.FindAttribute( name );
+        return value != nullptr && tinyxml2::XMLUtil::ToInt( value, &outVal );
     }
     inline bool                   vaXMLSerializer::ReadUInt32Attribute( const char * name, uint32 & outVal ) const
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        if( m_currentReadElement == nullptr )   return false;
-        return m_currentReadElement->QueryUnsignedAttribute( name, &outVal ) == tinyxml2::XML_SUCCESS;
+        const char * value = m_reader.FindAttribute( name );
+        return value != nullptr && tinyxml2::XMLUtil::ToUnsigned( value, &outVal );
     }
     inline bool                   vaXMLSerializer::ReadInt64Attribute( const char * name, int64 & outVal )   const
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        if( m_currentReadElement == nullptr )   return false;
-        return m_currentReadElement->QueryInt64Attribute( name, &outVal ) == tinyxml2::XML_SUCCESS;
+        const char * value = m_reader.FindAttribute( name );
+        return value != nullptr && tinyxml2::XMLUtil::ToInt64( value, &outVal );
     }
     inline bool                   vaXMLSerializer::ReadFloatAttribute( const char * name, float & outVal )   const
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        if( m_currentReadElement == nullptr )   return false;
-        return m_currentReadElement->QueryFloatAttribute( name, &outVal ) == tinyxml2::XML_SUCCESS;
+        const char * value = m_reader.FindAttribute( name );
+        return value != nullptr && tinyxml2::XMLUtil::ToFloat( value, &outVal );
     }
     inline bool                   vaXMLSerializer::ReadDoubleAttribute( const char * name, double & outVal ) const
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        if( m_currentReadElement == nullptr )   return false;
-        return m_currentReadElement->QueryDoubleAttribute( name, &outVal ) == tinyxml2::XML_SUCCESS;
+        const char * value = m_reader.FindAttribute( name );
+        return value != nullptr && tinyxml2::XMLUtil::ToDouble( value, &outVal );
     }
     inline bool                   vaXMLSerializer::ReadStringAttribute( const char * name, string & outVal ) const
     {
         assert( m_isReading ); if( !m_isReading ) return false;
-        if( m_currentReadElement == nullptr )   return false;
-        const tinyxml2::XMLAttribute * a = ( ( const tinyxml2::XMLElement * )m_currentReadElement )->FindAttribute( name );
-        if( a != nullptr )
+        const char * value = m_reader.FindAttribute( name );
+        if( value != nullptr )
         {
-            outVal = a->Value( );
+            outVal = value;
             return true;
         }
         return false;
@@ -611,15 +702,8 @@ namespace Vanilla
         if( !ReaderAdvanceToChildElement( elementName ) ) 
             return -1;
 
-        int counter = 0;
-        if( ReaderAdvanceToChildElement( childName ) )
-        {
-            do
-            {
-                counter++;
-            } while( ReaderAdvanceToSiblingElement( childName ) );
-            ReaderPopToParentElement( childName );
-        }
+        // this also indexes all children so iterating over them afterwards doesn't need to search again
+        int counter = m_reader.CountChildren( childName );
 
         SerializePopToParentElement( elementName );
         return counter;
@@ -786,7 +870,7 @@ namespace Vanilla
                 return true;    // this is ok, nothing to see here
             }
 
-            typeName = typeNameConv.ToTypeName( m_currentReadElement->Name( ) );
+            typeName = typeNameConv.ToTypeName( m_reader.GetName( ) );
             if( typeName == "" )
             {
                 SerializePopToParentElement( nullptr ); assert( false ); return false;  // this is bad - not a type kind of serializable object
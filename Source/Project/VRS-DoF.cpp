@@ -21,10 +21,13 @@
 
 #include "Core/System/vaFileTools.h"
 #include "Core/Misc/vaProfiler.h"
+#include "Core/Misc/vaStatistics.h"
+#include "Core/Misc/vaSelfTest.h"
 
 #include "Rendering/vaGPUTimer.h"
 
 #include "Rendering/vaRenderMesh.h"
+#include "Rendering/vaStandardShapes.h"
 #include "Rendering/vaRenderMaterial.h"
 #include "Rendering/vaAssetPack.h"
 #include "Rendering/vaRenderGlobals.h"
@@ -211,6 +214,7 @@ VanillaSample::VanillaSample( vaRenderDevice & renderDevice, vaApplicationBase &
 
     m_zoomTool = std::make_shared<vaZoomTool>( GetRenderDevice() );
     m_imageCompareTool = std::make_shared<vaImageCompareTool>(GetRenderDevice());
+    m_textureStreaming = std::make_shared<vaTextureStreamingManager>( GetRenderDevice() );
 
     // create scene objects
     for( int i = 0; i < _countof(m_scenes); i++ )
@@ -490,6 +494,16 @@ void VanillaSample::OnTick( float deltaTime )
         if( m_currentScene != nullptr )
             m_currentScene->Tick( deltaTime );
 
+#ifdef VA_ENABLE_TEXTURE_REDUCTION_TOOL
+        if( m_currentScene != nullptr && vaTextureReductionTestTool::GetInstancePtr( ) != nullptr && vaTextureReductionTestTool::GetInstance( ).IsTexelDensityAnalysisRequested( ) )
+        {
+            // no filtering - the tool does its own culling against each of the camera slots
+            vaRenderSelection allMeshes;
+            m_currentScene->SelectForRendering( &allMeshes, &allMeshes );
+            vaTextureReductionTestTool::GetInstance( ).RunTexelDensityAnalysis( *allMeshes.MeshList, *m_camera );
+        }
+#endif
+
         // custom lights setups
         bool lenabled[16*3] = { 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0,
                                 0, 1, 1, 1, 1, 0, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0,
@@ -547,6 +561,27 @@ void VanillaSample::OnTick( float deltaTime )
 
             m_currentDrawResults |= m_currentScene->SelectForRendering( &m_selectedOpaque, &m_selectedTransparent, vaRenderSelection::FilterSettings::FrustumCull( *m_camera ), sceneObjectFilter );
 
+            // update wanted texture MIPs based on what's selected (also kicks off loads / evictions)
+            m_textureStreaming->Tick( *m_camera, *m_selectedOpaque.MeshList, m_selectedTransparent.MeshList.get( ) );
+            if( m_textureStreaming->IsReplayRequested( ) )
+            {
+                // no filtering - the streaming model does its own culling for each frame of the flythrough
+                vaRenderSelection allMeshes;
+                m_currentScene->SelectForRendering( &allMeshes, &allMeshes );
+                float prevPlayTime = m_cameraFlythroughController->GetPlayTime( );
+                auto report = m_textureStreaming->ReplayCameraPath( *allMeshes.MeshList, *m_camera, [this]( int frameIndex, vaCameraBase & camera )
+                {
+                    float time = frameIndex / 60.0f;
+                    if( time > m_cameraFlythroughController->GetTotalTime( ) )
+                        return false;
+                    m_cameraFlythroughController->SetPlayTime( time );
+                    m_cameraFlythroughController->CameraTick( 0.0f, camera, false );
+                    return true;
+                } );
+                m_cameraFlythroughController->SetPlayTime( prevPlayTime );
+                m_textureStreaming->SetReplayReport( report );
+            }
+
             // This is where we would start the async sorts if we had that implemented - or actually at some point below
             // if we're changing VRS shading rate
             m_sortDepthPrepass  = vaRenderSelection::SortSettings::Standard( *m_camera, true, false );
@@ -572,7 +607,12 @@ void VanillaSample::OnTick( float deltaTime )
 
     }
 
-    // tick lighting
+    // tick lighting (after letting it know which static shadow layers got invalidated and where the moving casters are)
+    if( m_currentScene != nullptr )
+    {
+        m_lighting->UpdateShadowCasters( m_currentScene->GetShadowCasterChanges( ), m_currentScene->GetDynamicShadowCasterBounds( ) );
+        m_currentScene->ClearShadowCasterChanges( );
+    }
     m_lighting->Tick( deltaTime );
 
     // m_mouseCursor3DWorldPosition is one frame old because the update happens later during rendering; this can be fixed but it doesn't really matter in this case
@@ -583,29 +623,45 @@ void VanillaSample::OnTick( float deltaTime )
     {
         VA_TRACE_CPU_SCOPE( Shadowmaps );
 
-        assert( m_queuedShadowmap == nullptr ); // we should have reseted it already
-        m_queuedShadowmap = m_lighting->GetNextHighestPriorityShadowmapForRendering( );
-        m_shadowsStable = m_queuedShadowmap == nullptr;
+        assert( m_queuedShadowmaps.size( ) == 0 ); // we should have reseted it already
+        m_lighting->SelectShadowmapsForRendering( *m_camera, m_queuedShadowmaps );
+        m_shadowsStable = m_queuedShadowmaps.size( ) == 0;
 
         // don't record shadows if assets are still loading - they will be broken
         if( m_currentDrawResults != vaDrawResultFlags::None )
-            m_queuedShadowmap = nullptr;
+            m_queuedShadowmaps.clear( );
 
-        if( m_queuedShadowmap != nullptr )
+        while( m_queuedShadowmapStaticSelections.size( ) < m_queuedShadowmaps.size( ) )
         {
-            // we intend to select meshes, so make sure the list for storage is created
-            assert( m_queuedShadowmapRenderSelection.MeshList->Count( ) == 0 ); // leftovers from before? shouldn't happen!
+            m_queuedShadowmapStaticSelections.push_back( std::make_shared<vaRenderSelection>( ) );
+            m_queuedShadowmapDynamicSelections.push_back( std::make_shared<vaRenderSelection>( ) );
+        }
+
+        auto staticFilter   = [ ]( const vaSceneObject & obj, const vaMatrix4x4 &, const vaOrientedBoundingBox &, const vaRenderMesh &, const vaRenderMaterial &, int &, vaVector4 & ) { return !obj.IsDynamic( ); };
+        auto dynamicFilter  = [ ]( const vaSceneObject & obj, const vaMatrix4x4 &, const vaOrientedBoundingBox &, const vaRenderMesh &, const vaRenderMaterial &, int &, vaVector4 & ) { return obj.IsDynamic( ); };
 
-            // should have a radius-based filter here
-            // vaRenderSelection::FilterSettings selectionFilter( *m_camera );
+        for( int i = 0; i < (int)m_queuedShadowmaps.size( ); i++ )
+        {
+            // we intend to select meshes, so make sure the list for storage is created
+            assert( m_queuedShadowmapStaticSelections[i]->MeshList->Count( ) == 0 && m_queuedShadowmapDynamicSelections[i]->MeshList->Count( ) == 0 ); // leftovers from before? shouldn't happen!
 
             if( m_currentScene != nullptr )
-                m_currentDrawResults |= m_currentScene->SelectForRendering( &m_queuedShadowmapRenderSelection, nullptr, vaRenderSelection::FilterSettings::ShadowmapCull( *m_queuedShadowmap ) );
+            {
+                // static casters are only needed if the cached static layer needs redrawing
+                const vaRenderSelection::FilterSettings filter = vaRenderSelection::FilterSettings::ShadowmapCull( *m_queuedShadowmaps[i] );
+                if( m_queuedShadowmaps[i]->NeedsStaticCasters( ) )
+                    m_currentDrawResults |= m_currentScene->SelectForRendering( m_queuedShadowmapStaticSelections[i].get( ), nullptr, filter, staticFilter );
+                m_currentDrawResults |= m_currentScene->SelectForRendering( m_queuedShadowmapDynamicSelections[i].get( ), nullptr, filter, dynamicFilter );
+            }
         }
         if( m_currentDrawResults != vaDrawResultFlags::None )
         {
-            m_queuedShadowmap = nullptr;
-            m_queuedShadowmapRenderSelection.Reset( );
+            for( int i = 0; i < (int)m_queuedShadowmaps.size( ); i++ )
+            {
+                m_queuedShadowmapStaticSelections[i]->Reset( );
+                m_queuedShadowmapDynamicSelections[i]->Reset( );
+            }
+            m_queuedShadowmaps.clear( );
         }
     }
 
@@ -995,12 +1051,16 @@ vaDrawResultFlags VanillaSample::RenderTick( float deltaTime )
 #endif
 
     // draw shadowmaps if needed
-    if( m_queuedShadowmap != nullptr )
+    if( m_queuedShadowmaps.size( ) > 0 )
     {
         VA_TRACE_CPU_SCOPE( VanillaSample_RenderTick_DrawShadowmaps );
-        drawResults |= m_queuedShadowmap->Draw( mainContext, m_queuedShadowmapRenderSelection );
-        m_queuedShadowmap = nullptr;
-        m_queuedShadowmapRenderSelection.Reset();
+        for( int i = 0; i < (int)m_queuedShadowmaps.size( ); i++ )
+        {
+            drawResults |= m_queuedShadowmaps[i]->Draw( mainContext, *m_queuedShadowmapStaticSelections[i], *m_queuedShadowmapDynamicSelections[i] );
+            m_queuedShadowmapStaticSelections[i]->Reset( );
+            m_queuedShadowmapDynamicSelections[i]->Reset( );
+        }
+        m_queuedShadowmaps.clear( );
     }
 
     if( m_IBLsStable && m_application.GetTickNumber() % 50 == 0 )
@@ -1429,6 +1489,12 @@ void VanillaSample::UIPanelTick( vaApplicationBase & application )
     // ImGuiEx_Combo( "SuperSampling", (int&)m_settings.SuperSamplingOption, { "Disabled", "2x", "4x" } );
     ImGui::Separator();
 
+    if( ImGui::Button( "Run self tests" ) )
+        RunSelfTests( );
+    if( ImGui::IsItemHovered( ) ) ImGui::SetTooltip( "Runs the CPU side known answer checks of all modules, results go to the log" );
+
+    ImGui::Separator();
+
     // Benchmarking/scripting
     // if( m_settings.SceneChoice == VanillaSample::SceneSelectionType::LumberyardBistro )
     {
@@ -1441,6 +1507,21 @@ void VanillaSample::UIPanelTick( vaApplicationBase & application )
 #endif
 }
 
+void VanillaSample::RunSelfTests( )
+{
+    vaSelfTest::RunAll( {
+        { "vaStandardShapes shape cache",       &vaStandardShapes::SelfTest },
+        { "vaTriangleMeshTools LOD chain",      &vaTriangleMeshTools::SelfTestLODChain },
+        { "vaABComparison statistics",          &vaABComparison::SelfTest },
+        { "vaDebugCanvas2D vertices",           &vaDebugCanvas2D::SelfTest },
+        { "vaDebugCanvas3D vertices",           &vaDebugCanvas3D::SelfTest },
+        { "vaIrradianceSHCalculator CPU SH",    &vaIrradianceSHCalculator::ValidateCPU },
+        { "local IBL prefilter tables",         [ this ]( string * outInfo ) { return m_IBLProbeLocal->ValidatePreFilterSampleTables( outInfo ); } },
+        { "distant IBL prefilter tables",       [ this ]( string * outInfo ) { return m_IBLProbeDistant->ValidatePreFilterSampleTables( outInfo ); } },
+        { "static shadow invalidation",         &vaLighting::SelfTestStaticShadowInvalidation },
+        } );
+}
+
 namespace Vanilla
 {
     class AutoBenchTool
@@ -1772,6 +1853,113 @@ void VanillaSample::ScriptedTests( vaApplicationBase & application )
 
     ImGui::Separator( );
 
+    if( !isDebug )
+    {
+        std::vector<string> vals( (int)VariableRateShadingType::MaxValue );
+        for( int i = 0; i < vals.size( ); i++ )
+        {
+            vals[i] = GetVRSOptionName( (VariableRateShadingType)i );
+            if( !GetVRSOptionSupported( (VariableRateShadingType)i ) )
+                vals[i] = "(N/A) " + vals[i];
+        }
+        ImGui::Combo( "A/B option A", (int*)&m_settings.ABCompareOptionA, ImguiEx_VectorOfStringGetter, (void*)&vals, (int)vals.size( ) );
+        ImGui::Combo( "A/B option B", (int*)&m_settings.ABCompareOptionB, ImguiEx_VectorOfStringGetter, (void*)&vals, (int)vals.size( ) );
+
+        if( ImGui::Button( "Run interleaved A/B perf comparison" ) )
+        {
+            m_miniScript.Start( [ thisPtr = this, optionA = m_settings.ABCompareOptionA, optionB = m_settings.ABCompareOptionB ]( vaMiniScriptInterface & msi )
+            {
+                // this sets up some globals and also backups all the sample settings
+                AutoBenchTool autobench( *thisPtr, msi, false, true );
+
+                // A and B alternate in short windows over the same flythrough segment so that thermal and clock drift (and
+                // content) affects both equally; rounds alternate the order (ABBA...) to cancel linear drift within a window pair
+                const float c_framePerSecond    = 10;
+                const float c_frameDeltaTime    = 1.0f / (float)c_framePerSecond;
+                const float c_totalTime         = thisPtr->GetFlythroughCameraController( )->GetTotalTime( );
+                const int   c_totalFrameCount   = vaMath::Max( 1, (int)( c_totalTime / c_frameDeltaTime ) );
+                const int   c_windowFrameCount  = 30;
+                const int   c_roundCount        = 32;
+                thisPtr->SetFlythroughCameraEnabled( true );
+                thisPtr->GetFlythroughCameraController( )->SetPlaySpeed( 0.0f );
+
+                const VariableRateShadingType options[2] = { optionA, optionB };
+                const char * optionNames[2] = { thisPtr->GetVRSOptionName( optionA ), thisPtr->GetVRSOptionName( optionB ) };
+
+                autobench.ReportAddText( vaStringTools::Format( "\r\nInterleaved A/B frame time comparison (milliseconds), %d rounds of %d frames per option\r\n", c_roundCount, c_windowFrameCount ) );
+                autobench.ReportAddText( vaStringTools::Format( "A: %s, B: %s\r\n", optionNames[0], optionNames[1] ) );
+
+                vector<double>          samples[2];
+                vaStreamingStatistics   stats[2];
+                samples[0].reserve( c_roundCount * c_windowFrameCount );
+                samples[1].reserve( c_roundCount * c_windowFrameCount );
+
+                int segmentStart = 0;
+                for( int round = 0; round < c_roundCount; round++ )
+                {
+                    for( int slot = 0; slot < 2; slot++ )
+                    {
+                        const int ab = ( ( round % 2 ) == 0 ) ? ( slot ) : ( 1 - slot );
+                        thisPtr->SetVRSOption( options[ab] );
+                        thisPtr->GetFlythroughCameraController( )->SetPlayTime( ( segmentStart % c_totalFrameCount ) * c_frameDeltaTime );
+
+                        autobench.SetUIStatusInfo( vaStringTools::Format( "round %d of %d, running %c (%s)", round + 1, c_roundCount, 'A' + ab, optionNames[ab] ) );
+
+                        // wait until IsAllLoadedPrecomputedAndStable and then a few more frames so the switch has settled
+                        int startupLoops = 3;
+                        do
+                        { 
+                            if( !thisPtr->IsAllLoadedPrecomputedAndStable( ) )
+                                startupLoops = 3;
+                            startupLoops--;
+                            if( !msi.YieldExecution( ) || autobench.GetShouldStop( ) )
+                                return;
+                        }
+                        while( startupLoops > 0 );
+
+                        using namespace std::chrono;
+                        high_resolution_clock::time_point prevTime = high_resolution_clock::now( );
+                        for( int testFrame = 0; testFrame < c_windowFrameCount; testFrame++ )
+                        {
+                            thisPtr->GetFlythroughCameraController( )->SetPlayTime( ( ( segmentStart + testFrame ) % c_totalFrameCount ) * c_frameDeltaTime );
+                            if( !msi.YieldExecution( ) || autobench.GetShouldStop( ) )
+                                return;
+
+                            high_resolution_clock::time_point currentTime = high_resolution_clock::now( );
+                            const double frameTime = duration_cast<duration<double, std::milli>>( currentTime - prevTime ).count( );
+                            prevTime = currentTime;
+
+                            samples[ab].push_back( frameTime );
+                            stats[ab].Add( frameTime );
+                        }
+                    }
+                    segmentStart += c_windowFrameCount;
+                }
+
+                autobench.ReportAddRowValues( { "", string("A: ") + optionNames[0], string("B: ") + optionNames[1] } );
+                auto addStatRow = [&]( const char * name, std::function<double( const vaStreamingStatistics & )> getter )
+                {
+                    autobench.ReportAddRowValues( { name, vaStringTools::Format( "%.3f", getter( stats[0] ) ), vaStringTools::Format( "%.3f", getter( stats[1] ) ) } );
+                };
+                addStatRow( "Frame count",      [ ]( const vaStreamingStatistics & s ) { return (double)s.GetCount( ); } );
+                addStatRow( "Average",          [ ]( const vaStreamingStatistics & s ) { return s.GetMean( ); } );
+                addStatRow( "Std dev",          [ ]( const vaStreamingStatistics & s ) { return s.GetStdDev( ); } );
+                addStatRow( "P50",              [ ]( const vaStreamingStatistics & s ) { return s.GetPercentile( vaStreamingStatistics::P50 ); } );
+                addStatRow( "P90",              [ ]( const vaStreamingStatistics & s ) { return s.GetPercentile( vaStreamingStatistics::P90 ); } );
+                addStatRow( "P99",              [ ]( const vaStreamingStatistics & s ) { return s.GetPercentile( vaStreamingStatistics::P99 ); } );
+
+                vaABComparison::Result result = vaABComparison::Compare( samples[0], samples[1], 0.95 );
+                string summary = vaStringTools::Format( "Speedup of B over A (median A / median B): %.3fx, %.0f%% CI [%.3f, %.3f]; Mann-Whitney U: %.0f, z: %.2f, p: %.4g - %s",
+                    result.Speedup, result.ConfidenceLevel * 100.0, result.SpeedupCILow, result.SpeedupCIHigh, result.MannWhitneyU, result.MannWhitneyZ, result.PValue,
+                    ( result.Significant ) ? ( "statistically significant difference" ) : ( "no statistically significant difference" ) );
+                autobench.ReportAddText( "\r\n" + summary + "\r\n" );
+                VA_LOG( "%s", summary.c_str( ) );
+            } );
+        }
+    }
+
+    ImGui::Separator( );
+
     // for conversion to mpeg one option is to download ffmpeg and then do 'ffmpeg -r 60 -f image2 -s 1920x1080 -i frame_%05d.png -vcodec libx264 -crf 13  -pix_fmt yuv420p outputvideo.mp4'
     if( ImGui::Button( "Record a flythrough" ) )
     {
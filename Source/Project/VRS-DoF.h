@@ -44,6 +44,7 @@
 #include "Rendering/Effects/vaPostProcessTonemap.h"
 #include "Rendering/Misc/vaZoomTool.h"
 #include "Rendering/Misc/vaImageCompareTool.h"
+#include "Rendering/vaTextureStreaming.h"
 
 #include <optional>
 
@@ -109,6 +110,10 @@ namespace Vanilla
 
             float                                   AutoVRSRateOffsetThreshold      = 0.2f;
 
+            // the two VRS options compared by the interleaved A/B perf comparison script
+            VariableRateShadingType                 ABCompareOptionA                = VariableRateShadingType::None;
+            VariableRateShadingType                 ABCompareOptionB                = VariableRateShadingType::Tier1_DoF_Driven;
+
             void Serialize( vaXMLSerializer & serializer )
             {
                 serializer.Serialize( "ShowWireframe"                   , ShowWireframe                     );
@@ -126,10 +131,12 @@ namespace Vanilla
                 serializer.Serialize( "DoFRange"                        , DoFRange                          );
                 serializer.Serialize( "EnableGradientFilterExtension"   , EnableGradientFilterExtension     );
                 serializer.Serialize( "AutoVRSRateOffsetThreshold"      , AutoVRSRateOffsetThreshold        );
+                serializer.Serialize( "ABCompareOptionA"                , (int&)ABCompareOptionA            );
+                serializer.Serialize( "ABCompareOptionB"                , (int&)ABCompareOptionB            );
 
                 // this here is just to remind you to update serialization when changing the struct
                 size_t dbgSizeOfThis = sizeof(*this); dbgSizeOfThis;
-                assert( dbgSizeOfThis == 52 );
+                assert( dbgSizeOfThis == 60 );
             }
 
             void Validate( )
@@ -141,6 +148,8 @@ namespace Vanilla
                 DoFDrivenVRSMaxRate             = vaMath::Clamp( DoFDrivenVRSMaxRate, 0, 4 );
                 DoFFocalLength                  = vaMath::Clamp( DoFFocalLength,    0.0f, 100.0f );
                 DoFRange                        = vaMath::Clamp( DoFRange,          0.0f, 1.0f );
+                ABCompareOptionA                = (VariableRateShadingType)vaMath::Clamp( (int)ABCompareOptionA, (int)VariableRateShadingType::None, (int)VariableRateShadingType::MaxValue-1 );
+                ABCompareOptionB                = (VariableRateShadingType)vaMath::Clamp( (int)ABCompareOptionB, (int)VariableRateShadingType::None, (int)VariableRateShadingType::MaxValue-1 );
             }
         };
 
@@ -191,8 +200,9 @@ namespace Vanilla
         vaDrawResultFlags                       m_currentDrawResults = vaDrawResultFlags::None;
         bool                                    m_currentSceneChanged = false;
 
-        shared_ptr<vaShadowmap>                 m_queuedShadowmap;
-        vaRenderSelection                       m_queuedShadowmapRenderSelection;
+        vector<shared_ptr<vaShadowmap>>         m_queuedShadowmaps;
+        vector<shared_ptr<vaRenderSelection>>   m_queuedShadowmapStaticSelections;      // [i] is for m_queuedShadowmaps[i]; grows as needed, never shrinks
+        vector<shared_ptr<vaRenderSelection>>   m_queuedShadowmapDynamicSelections;     // same as above
         bool                                    m_shadowsStable = false;
 
         bool                                    m_IBLsStable = false;
@@ -202,6 +212,8 @@ namespace Vanilla
         shared_ptr<vaZoomTool>                  m_zoomTool;
         shared_ptr<vaImageCompareTool>          m_imageCompareTool;
 
+        shared_ptr<vaTextureStreamingManager>   m_textureStreaming;
+
         float                                   m_lastDeltaTime;
 
         vaVector3                               m_mouseCursor3DWorldPosition;
@@ -281,6 +293,9 @@ namespace Vanilla
 
         void                                    ScriptedTests( vaApplicationBase & application ) ;
 
+        // the one place all module self tests are run from (see vaSelfTest)
+        void                                    RunSelfTests( );
+
     private:
         //void                                    RandomizeCurrentPoissonDisk( int count = SSAO_MAX_SAMPLES );
     };
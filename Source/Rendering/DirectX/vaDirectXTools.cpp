@@ -1171,7 +1171,7 @@ int vaDirectXTools11::CalcApproxTextureSizeInMemory( DXGI_FORMAT format, int wid
     return pixels * (int)DirectX::BitsPerPixel( format );
 }
 
-ID3D11Resource * vaDirectXTools11::LoadTextureDDS( ID3D11Device * device, void * dataBuffer, int64 dataSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, uint64 * outCRC )
+ID3D11Resource * vaDirectXTools11::LoadTextureDDS( ID3D11Device * device, void * dataBuffer, int64 dataSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, uint64 * outCRC, int maxDimension )
 {
     outCRC; // unreferenced, not implemented
     assert( outCRC == nullptr ); // not implemented
@@ -1197,14 +1197,14 @@ ID3D11Resource * vaDirectXTools11::LoadTextureDDS( ID3D11Device * device, void *
     HRESULT hr;
     if( dontAutogenerateMIPs )
     {
-        hr = DirectX::CreateDDSTextureFromMemoryEx( device, (const uint8_t *)dataBuffer, (size_t)dataSize, 0, D3D11_USAGE_DEFAULT, dxBindFlags, 0, 0, forceSRGB, &texture, &textureSRV, NULL );
+        hr = DirectX::CreateDDSTextureFromMemoryEx( device, (const uint8_t *)dataBuffer, (size_t)dataSize, (size_t)maxDimension, D3D11_USAGE_DEFAULT, dxBindFlags, 0, 0, forceSRGB, &texture, &textureSRV, NULL );
     }
     else
     {
         assert( vaThreading::IsMainThread() );
         ID3D11DeviceContext * immediateContext = nullptr;
         device->GetImmediateContext( &immediateContext );
-        hr = DirectX::CreateDDSTextureFromMemoryEx( device, immediateContext, (const uint8_t *)dataBuffer, (size_t)dataSize, 0, D3D11_USAGE_DEFAULT, dxBindFlags, 0, 0, forceSRGB, &texture, &textureSRV, NULL );
+        hr = DirectX::CreateDDSTextureFromMemoryEx( device, immediateContext, (const uint8_t *)dataBuffer, (size_t)dataSize, (size_t)maxDimension, D3D11_USAGE_DEFAULT, dxBindFlags, 0, 0, forceSRGB, &texture, &textureSRV, NULL );
         immediateContext->Release();
     }
 
@@ -2322,7 +2322,7 @@ void vaDirectXTools12::FillBlendState( D3D12_BLEND_DESC & outDesc, vaBlendMode b
     }
 }
 
-bool vaDirectXTools12::LoadTexture( ID3D12Device * device, void * dataBuffer, uint64 dataBufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, ID3D12Resource *& outResource, std::vector<D3D12_SUBRESOURCE_DATA> & outSubresources, std::unique_ptr<Vanilla::byte[]> & outDecodedData, bool & outIsCubemap )
+bool vaDirectXTools12::LoadTexture( ID3D12Device * device, void * dataBuffer, uint64 dataBufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, ID3D12Resource *& outResource, std::vector<D3D12_SUBRESOURCE_DATA> & outSubresources, std::unique_ptr<Vanilla::byte[]> & outDecodedData, bool & outIsCubemap, int maxDimension )
 {
     D3D12_RESOURCE_FLAGS resourceFlags = ResourceFlagsDX12FromVA( bindFlags );
 
@@ -2351,7 +2351,7 @@ bool vaDirectXTools12::LoadTexture( ID3D12Device * device, void * dataBuffer, ui
         assert( outDecodedData == nullptr || outDecodedData.get() == dataBuffer );   // loading inplace from provided data
         uint32 dxLoadFlags = 0;
         dxLoadFlags |= ( (loadFlags & vaTextureLoadFlags::PresumeDataIsSRGB) != 0 ) ? ( DirectX::DDS_LOADER_FORCE_SRGB ) : ( 0 );
-        hr = DirectX::LoadDDSTextureFromMemoryEx( device, (const uint8_t *)dataBuffer, (size_t)dataBufferSize, 0, resourceFlags, dxLoadFlags, &outResource, outSubresources, nullptr, &outIsCubemap );
+        hr = DirectX::LoadDDSTextureFromMemoryEx( device, (const uint8_t *)dataBuffer, (size_t)dataBufferSize, (size_t)maxDimension, resourceFlags, dxLoadFlags, &outResource, outSubresources, nullptr, &outIsCubemap );
     }
     else if( (memcmp(dataBuffer, HDRSignature, sizeof(HDRSignature) - 1) == 0) || (memcmp(dataBuffer, HDRSignatureAlt, sizeof(HDRSignatureAlt) - 1) == 0) )
     {
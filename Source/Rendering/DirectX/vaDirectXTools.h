@@ -122,7 +122,7 @@ namespace Vanilla
 
         // Helper texture-related functions
         static int                          CalcApproxTextureSizeInMemory( DXGI_FORMAT format, int width, int height, int mipCount );
-        static ID3D11Resource *             LoadTextureDDS( ID3D11Device * device, void * buffer, int64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, uint64 * outCRC = NULL );
+        static ID3D11Resource *             LoadTextureDDS( ID3D11Device * device, void * buffer, int64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, uint64 * outCRC = NULL, int maxDimension = 0 );
         static ID3D11Resource *             LoadTextureDDS( ID3D11Device * device, const wchar_t * path, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, uint64 * outCRC = NULL );
         static ID3D11Resource *             LoadTextureWIC( ID3D11Device * device, void * buffer, int64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, uint64 * outCRC = NULL );
         static ID3D11Resource *             LoadTextureWIC( ID3D11Device * device, const wchar_t * path, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, uint64 * outCRC = NULL );
@@ -322,7 +322,8 @@ namespace Vanilla
         static void FillBlendState( D3D12_BLEND_DESC & outDesc, vaBlendMode blendMode );
 
         // isDDS==true path will not allocate memory in outData and outSubresources will point into dataBuffer so make sure to keep it alive
-        static bool LoadTexture( ID3D12Device * device, void * dataBuffer, uint64 dataBufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, ID3D12Resource *& outResource, std::vector<D3D12_SUBRESOURCE_DATA> & outSubresources, std::unique_ptr<byte[]> & outData, bool & outIsCubemap ); // ,  uint64 * outCRC
+        // maxDimension != 0 will skip top MIPs that are larger (isDDS==true path only)
+        static bool LoadTexture( ID3D12Device * device, void * dataBuffer, uint64 dataBufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, ID3D12Resource *& outResource, std::vector<D3D12_SUBRESOURCE_DATA> & outSubresources, std::unique_ptr<byte[]> & outData, bool & outIsCubemap, int maxDimension = 0 ); // ,  uint64 * outCRC
         
         // both isDDS paths will allocate memory in outData and outSubresources will point into it so make sure to keep it alive
         static bool LoadTexture( ID3D12Device * device, const wchar_t * filePath, bool isDDS, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, ID3D12Resource *& outResource, std::vector<D3D12_SUBRESOURCE_DATA> & outSubresources, std::unique_ptr<byte[]> & outData, bool & outIsCubemap ); 
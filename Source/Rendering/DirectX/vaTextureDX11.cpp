@@ -187,7 +187,7 @@ void vaTextureDX11::Destroy( )
     SAFE_RELEASE( m_uav );
 }
 
-bool vaTextureDX11::Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags binds, vaTextureContentsType contentsType )
+bool vaTextureDX11::Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags binds, vaTextureContentsType contentsType, int maxDimension )
 {
     if( bufferSize <= 4 )
     {
@@ -209,7 +209,7 @@ bool vaTextureDX11::Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags
     bool isDDS = dwMagicNumber == DDS_MAGIC;
 
     if( isDDS )
-        m_resource = vaDirectXTools11::LoadTextureDDS( GetRenderDevice().SafeCast<vaRenderDeviceDX11*>( )->GetPlatformDevice(), buffer, bufferSize, loadFlags, binds );
+        m_resource = vaDirectXTools11::LoadTextureDDS( GetRenderDevice().SafeCast<vaRenderDeviceDX11*>( )->GetPlatformDevice(), buffer, bufferSize, loadFlags, binds, nullptr, maxDimension );
     else
         m_resource = vaDirectXTools11::LoadTextureWIC( GetRenderDevice().SafeCast<vaRenderDeviceDX11*>( )->GetPlatformDevice(), buffer, bufferSize, loadFlags, binds );
 
@@ -806,6 +806,8 @@ bool vaTextureDX11::LoadAPACK( vaStream & inStream )
     int64 textureDataSize;
     VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int64                     >( textureDataSize ) );
 
+    int64 textureDataOffset = ( inStream.CanSeek( ) ) ? ( inStream.GetPosition( ) ) : ( -1 );
+
     // direct reading from the stream not implemented yet
     byte * buffer = new byte[ textureDataSize ];
     if( !inStream.Read( buffer, textureDataSize ) )
@@ -828,6 +830,8 @@ bool vaTextureDX11::LoadAPACK( vaStream & inStream )
 
     ProcessResource( );
 
+    SetAPACKDataLocation( textureDataOffset, textureDataSize );
+
     return true;
 }
 
@@ -976,6 +980,14 @@ void vaTextureDX11::ResolveSubresource( vaRenderDeviceContext & renderContext, c
     dx11Context->ResolveSubresource( dstResource->SafeCast<vaTextureDX11*>( )->GetResource(), dstSubresource, GetResource(), srcSubresource, DXGIFormatFromVA( format ) );
 }
 
+void vaTextureDX11::CopySubresource( vaRenderDeviceContext & renderContext, const shared_ptr<vaTexture> & dstResource, uint dstSubresource, uint srcSubresource )
+{
+    ID3D11DeviceContext * dx11Context = renderContext.SafeCast<vaRenderDeviceContextDX11*>( )->GetDXContext( );
+
+    // no box - depth/stencil and multisampled resources only support whole subresource copies anyway
+    dx11Context->CopySubresourceRegion( dstResource->SafeCast<vaTextureDX11*>( )->GetResource(), dstSubresource, 0, 0, 0, GetResource(), srcSubresource, nullptr );
+}
+
 void vaTextureDX11::SetToAPISlotSRV( vaRenderDeviceContext & renderContext, int slot, bool assertOnOverwrite )
 {
     ID3D11DeviceContext * dx11Context = renderContext.SafeCast<vaRenderDeviceContextDX11*>( )->GetDXContext();
@@ -86,7 +86,7 @@ void vaTextureDX12::Destroy( )
     }
 }
 
-bool vaTextureDX12::Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, vaTextureContentsType contentsType )
+bool vaTextureDX12::Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags bindFlags, vaTextureContentsType contentsType, int maxDimension )
 {
     if( bufferSize <= 4 )
     {
@@ -108,7 +108,7 @@ bool vaTextureDX12::Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags
     std::unique_ptr<byte[]> outData;
     bool outIsCubemap;
 
-    if( !vaDirectXTools12::LoadTexture( AsDX12(GetRenderDevice()).GetPlatformDevice().Get(), buffer, bufferSize, loadFlags, bindFlags, outResource, outSubresources, outData, outIsCubemap ) )
+    if( !vaDirectXTools12::LoadTexture( AsDX12(GetRenderDevice()).GetPlatformDevice().Get(), buffer, bufferSize, loadFlags, bindFlags, outResource, outSubresources, outData, outIsCubemap, maxDimension ) )
     {
         VA_WARN( L"vaTextureDX12::Import - error loading texture from a buffer!" );
         return false;
@@ -740,6 +740,8 @@ bool vaTextureDX12::LoadAPACK( vaStream & inStream )
     int64 textureDataSize;
     VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int64                     >( textureDataSize ) );
 
+    int64 textureDataOffset = ( inStream.CanSeek( ) ) ? ( inStream.GetPosition( ) ) : ( -1 );
+
     // direct reading from the stream not implemented yet
     byte * buffer = new byte[ textureDataSize ];
     if( !inStream.Read( buffer, textureDataSize ) )
@@ -761,6 +763,8 @@ bool vaTextureDX12::LoadAPACK( vaStream & inStream )
         return false;
     }
 
+    SetAPACKDataLocation( textureDataOffset, textureDataSize );
+
     return true;
 }
 
@@ -951,6 +955,20 @@ void vaTextureDX12::ResolveSubresource( vaRenderDeviceContext & renderContext, c
     AsDX12( renderContext ).GetCommandList()->ResolveSubresource( dstResourceDX12, dstSubresource, GetResource(), srcSubresource, DXGIFormatFromVA( format ) );
 }
 
+void vaTextureDX12::CopySubresource( vaRenderDeviceContext & renderContext, const shared_ptr<vaTexture> & dstResource, uint dstSubresource, uint srcSubresource )
+{
+    assert( GetRenderDevice( ).IsFrameStarted( ) );
+    assert( m_mappableTextureInfo == nullptr && AsDX12(*dstResource).m_mappableTextureInfo == nullptr );   // GPU <-> GPU only
+
+    // transition to proper resource states
+    TransitionResource( AsDX12(renderContext), D3D12_RESOURCE_STATE_COPY_SOURCE );
+    AsDX12(*dstResource).TransitionResource( AsDX12(renderContext), D3D12_RESOURCE_STATE_COPY_DEST );
+
+    CD3DX12_TEXTURE_COPY_LOCATION dst( AsDX12(*dstResource).GetResource(), dstSubresource );
+    CD3DX12_TEXTURE_COPY_LOCATION src( GetResource(), srcSubresource );
+    AsDX12( renderContext ).GetCommandList()->CopyTextureRegion( &dst, 0, 0, 0, &src, nullptr );
+}
+
 // void vaTextureDX12::UpdateSubresource( vaRenderDeviceContext & renderContext, int dstSubresourceIndex, const vaBoxi & dstBox, void * srcData, int srcDataRowPitch, int srcDataDepthPitch )
 // {
 //     assert( false ); // not implemented - probably best to see & upgrade InternalUpdate to make this work
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Core/vaCoreIncludes.h"
+
+#include "Rendering/vaTextureProcessing.h"
+
+#include "Rendering/DirectX/vaDirectXTools.h"
+
+#include "IntegratedExternals/DirectXTex/DirectXTex/DirectXTex.h"
+
+#include "Core/System/vaFileTools.h"
+
+using namespace Vanilla;
+
+// same choices as vaTextureDX11::TryCompress / vaTextureDX12::TryCompress; returns false if there's no known good BCn for the combination
+static bool SelectCompressedFormat( DXGI_FORMAT srcFormat, vaTextureContentsType contentsType, DXGI_FORMAT & outFormat, vaTextureContentsType & outContentsType )
+{
+    outContentsType = contentsType;
+    switch( contentsType )
+    {
+    case( vaTextureContentsType::NormalsXYZ_UNORM ):
+    case( vaTextureContentsType::NormalsXY_UNORM ):
+        if( srcFormat == DXGI_FORMAT_R8G8_UNORM || srcFormat == DXGI_FORMAT_R8G8B8A8_UNORM || srcFormat == DXGI_FORMAT_B8G8R8A8_UNORM || srcFormat == DXGI_FORMAT_B8G8R8X8_UNORM )
+        {
+            outFormat = DXGI_FORMAT_BC5_UNORM;
+            outContentsType = vaTextureContentsType::NormalsXY_UNORM;
+            return true;
+        }
+        break;
+    case( vaTextureContentsType::GenericColor ):
+        if( srcFormat == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || srcFormat == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB )
+        {
+            outFormat = DXGI_FORMAT_BC7_UNORM_SRGB;
+            return true;
+        }
+        break;
+    case( vaTextureContentsType::GenericLinear ):
+        if( srcFormat == DXGI_FORMAT_R8G8B8A8_UNORM || srcFormat == DXGI_FORMAT_B8G8R8A8_UNORM )
+        {
+            outFormat = DXGI_FORMAT_BC7_UNORM;
+            return true;
+        }
+        break;
+    case( vaTextureContentsType::SingleChannelLinearMask ):
+        if( srcFormat == DXGI_FORMAT_R8G8B8A8_UNORM || srcFormat == DXGI_FORMAT_B8G8R8A8_UNORM || srcFormat == DXGI_FORMAT_R8_UNORM )
+        {
+            outFormat = DXGI_FORMAT_BC4_UNORM;
+            return true;
+        }
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+bool vaTextureProcessing::ImportImageFile( const wstring & filePath, const ImportSettings & settings, ImportResult & outResult )
+{
+    outResult = ImportResult( );
+    outResult.ContentsType = settings.ContentsType;
+
+    // WIC needs COM on this thread; it's a no-op if already initialized (for ex. when called from the main thread)
+    HRESULT coInitHR = CoInitializeEx( NULL, COINIT_MULTITHREADED );
+
+    auto finish = [&]( bool success ) -> bool
+    {
+        if( SUCCEEDED( coInitHR ) )
+            CoUninitialize( );
+        return success;
+    };
+
+    wstring outDir, outName, outExt;
+    vaFileTools::SplitPath( filePath, &outDir, &outName, &outExt );
+    outExt = vaStringTools::ToLower( outExt );
+
+    DirectX::TexMetadata    metadata;
+    DirectX::ScratchImage   image;
+    HRESULT hr;
+    if( outExt == L".dds" )
+    {
+        hr = DirectX::LoadFromDDSFile( filePath.c_str( ), DirectX::DDS_FLAGS_NONE, &metadata, image );
+        if( SUCCEEDED( hr ) && ( settings.LoadFlags & vaTextureLoadFlags::PresumeDataIsSRGB ) != 0 && !DirectX::IsSRGB( metadata.format ) && DirectX::MakeSRGB( metadata.format ) != metadata.format )
+        {
+            // same as DDS_LOADER_FORCE_SRGB
+            metadata.format = DirectX::MakeSRGB( metadata.format );
+            image.OverrideFormat( metadata.format );
+        }
+    }
+    else if( outExt == L".hdr" )
+        hr = DirectX::LoadFromHDRFile( filePath.c_str( ), &metadata, image );
+    else if( outExt == L".tga" )
+        hr = DirectX::LoadFromTGAFile( filePath.c_str( ), &metadata, image );
+    else
+    {
+        DWORD wicFlags = DirectX::WIC_FLAGS_NONE;
+        wicFlags |= ( ( settings.LoadFlags & vaTextureLoadFlags::PresumeDataIsSRGB ) != 0 ) ? ( DirectX::WIC_FLAGS_FORCE_SRGB ) : ( 0 );
+        wicFlags |= ( ( settings.LoadFlags & vaTextureLoadFlags::PresumeDataIsLinear ) != 0 ) ? ( DirectX::WIC_FLAGS_IGNORE_SRGB ) : ( 0 );
+        hr = DirectX::LoadFromWICFile( filePath.c_str( ), wicFlags, &metadata, image );
+    }
+    if( FAILED( hr ) )
+    {
+        outResult.Info += vaStringTools::Format( "Error while decoding '%s'\n", vaStringTools::SimpleNarrow( filePath ).c_str( ) );
+        return finish( false );
+    }
+    if( metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.IsCubemap( ) )
+    {
+        // leave anything exotic as it is
+        if( settings.GenerateMIPs || settings.Compress )
+            outResult.Info += "Not a simple 2D texture, skipping MIP generation and compression\n";
+    }
+    else
+    {
+        // drop unnecessary color channels
+        if( settings.ContentsType == vaTextureContentsType::SingleChannelLinearMask && ( metadata.format == DXGI_FORMAT_R8G8B8A8_UNORM || metadata.format == DXGI_FORMAT_B8G8R8A8_UNORM ) )
+        {
+            // RGB -> R conversion defaults to luminance; the mask is in the red channel so copy that as it is
+            DirectX::ScratchImage converted;
+            hr = DirectX::Convert( image.GetImages( ), image.GetImageCount( ), image.GetMetadata( ), DXGI_FORMAT_R8_UNORM, DirectX::TEX_FILTER_DEFAULT | DirectX::TEX_FILTER_RGB_COPY_RED, DirectX::TEX_THRESHOLD_DEFAULT, converted );
+            if( SUCCEEDED( hr ) )
+            {
+                image = std::move( converted );
+                metadata = image.GetMetadata( );
+                outResult.Info += "Successfully removed unnecessary color channels\n";
+            }
+            else
+                outResult.Info += "Error while removing unnecessary color channels\n";
+        }
+
+        if( settings.GenerateMIPs )
+        {
+            if( metadata.mipLevels > 1 )
+                outResult.Info += vaStringTools::Format( "Loaded texture already has %d MIP levels\n", (int)metadata.mipLevels );
+            else if( DirectX::IsCompressed( metadata.format ) )
+                outResult.Info += "Loaded texture is block compressed, unable to create MIPs\n";
+            else
+            {
+                DirectX::ScratchImage mipChain;
+                hr = DirectX::GenerateMipMaps( image.GetImages( ), image.GetImageCount( ), image.GetMetadata( ), DirectX::TEX_FILTER_DEFAULT | DirectX::TEX_FILTER_FORCE_NON_WIC, 0, mipChain );
+                if( SUCCEEDED( hr ) )
+                {
+                    image = std::move( mipChain );
+                    metadata = image.GetMetadata( );
+                    outResult.Info += "Successfully created MIPs\n";
+                }
+                else
+                    outResult.Info += "Error while creating MIPs\n";
+            }
+        }
+
+        if( settings.Compress && !DirectX::IsCompressed( metadata.format ) )
+        {
+            DXGI_FORMAT compressedFormat; vaTextureContentsType compressedContentsType;
+            if( !SelectCompressedFormat( metadata.format, settings.ContentsType, compressedFormat, compressedContentsType ) )
+                outResult.Info += "No suitable compressed format for this format / contents type, compression skipped\n";
+            else
+            {
+                DWORD compressFlags = DirectX::TEX_COMPRESS_DEFAULT;
+#ifdef _OPENMP
+                compressFlags |= DirectX::TEX_COMPRESS_PARALLEL;
+#endif
+                DirectX::ScratchImage compressed;
+                hr = DirectX::Compress( image.GetImages( ), image.GetImageCount( ), image.GetMetadata( ), compressedFormat, compressFlags, DirectX::TEX_THRESHOLD_DEFAULT, compressed );
+                if( SUCCEEDED( hr ) )
+                {
+                    image = std::move( compressed );
+                    metadata = image.GetMetadata( );
+                    outResult.ContentsType = compressedContentsType;
+                    outResult.Info += "Successfully compressed\n";
+                }
+                else
+                    outResult.Info += "Error while compressing\n";
+            }
+        }
+    }
+
+    DirectX::Blob blob;
+    hr = DirectX::SaveToDDSMemory( image.GetImages( ), image.GetImageCount( ), image.GetMetadata( ), DirectX::DDS_FLAGS_NONE, blob );
+    if( FAILED( hr ) )
+    {
+        outResult.Info += "Error while encoding to .dds\n";
+        return finish( false );
+    }
+
+    outResult.DDSData.resize( blob.GetBufferSize( ) );
+    memcpy( outResult.DDSData.data( ), blob.GetBufferPointer( ), blob.GetBufferSize( ) );
+    return finish( true );
+}
@@ -20,6 +20,7 @@
 #include "vaDepthOfField.h"
 
 #include "Rendering/vaRenderDeviceContext.h"
+#include "Rendering/vaTextureHelpers.h"
 
 #include "IntegratedExternals/vaImguiIntegration.h"
 
@@ -64,16 +65,26 @@ vaDrawResultFlags vaDepthOfField::Draw( vaSceneDrawContext & sceneContext, const
     vaVector3i offscreenSize = { (inOutColor->GetSize().x + 1) / 2, (inOutColor->GetSize().y + 1) / 2, (inOutColor->GetSize().z + 1) / 2 };
     if( m_offscreenColorNearA == nullptr || m_offscreenColorNearA->GetSize() != offscreenSize )
     {
+        // these are transient working textures so go through the pool: switching between a few resolutions (or between
+        // several DoF instances) then doesn't keep recreating them
+        vaTexturePool & pool = GetRenderDevice().GetTexturePool();
+        for( shared_ptr<vaTexture> * texture : { &m_offscreenColorNearA, &m_offscreenColorNearB, &m_offscreenColorFarA, &m_offscreenColorFarB, &m_offscreenCoc } )
+        {
+            if( *texture != nullptr )
+                pool.Release( *texture );
+            *texture = nullptr;
+        }
+
         // near hopefully needs less precision so i'm attempting to hold everything in 8 bit per channel color
-        m_offscreenColorNearA   = vaTexture::Create2D( GetRenderDevice(), vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
-        m_offscreenColorNearB   = vaTexture::Create2D( GetRenderDevice(), vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
+        m_offscreenColorNearA   = pool.FindOrCreate2D( vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
+        m_offscreenColorNearB   = pool.FindOrCreate2D( vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
 
         // offscreen color far A needs at least 8 bits of alpha to hold the coc blend
         // offscreen color far b just needs a single bit to maintain blurred/no-blurred
-        m_offscreenColorFarA    = vaTexture::Create2D( GetRenderDevice(), vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
-        m_offscreenColorFarB    = vaTexture::Create2D( GetRenderDevice(), vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
+        m_offscreenColorFarA    = pool.FindOrCreate2D( vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
+        m_offscreenColorFarB    = pool.FindOrCreate2D( vaResourceFormat::R16G16B16A16_FLOAT, offscreenSize.x, offscreenSize.y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
 
-        m_offscreenCoc          = vaTexture::Create2D( GetRenderDevice(), vaResourceFormat::R8_UNORM, inOutColor->GetSize().x, inOutColor->GetSize().y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
+        m_offscreenCoc          = pool.FindOrCreate2D( vaResourceFormat::R8_UNORM, inOutColor->GetSize().x, inOutColor->GetSize().y, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::UnorderedAccess );
     }
 
     float kernelScale = (float)( ( sceneContext.Camera.GetYFOVMain( ) ) ? ( inDepth->GetSizeY( ) / 1080.0f ) : ( inDepth->GetSizeX( ) / 1920.0f ) );
@@ -43,10 +43,209 @@
 #include "IntegratedExternals/vaTaskflowIntegration.h"
 #endif
 
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define USE_SSE_PARTICLES
+#include <emmintrin.h>
+#endif
+
 #include <functional>
 
 using namespace Vanilla;
 
+namespace
+{
+    // fixed chunk sizes (rather than ones based on the thread count) keep the work split - and so the spawn random sequences - deterministic
+    const int c_spawnChunkSize          = 1024;
+    const int c_tickChunkSize           = 8 * 1024;
+    const int c_drawBufferChunkSize     = 8 * 1024;
+
+    // radix sort: distance is quantized to c_sortKeyBits and sorted in two passes of c_sortDigitBits
+    const int c_sortDigitBits           = 11;
+    const int c_sortDigitCount          = 1 << c_sortDigitBits;
+    const int c_sortKeyBits             = c_sortDigitBits * 2;
+    const int c_sortMinChunkSize        = 16 * 1024;
+    const int c_sortMaxChunkCount       = 64;
+
+    // calls callback( chunkIndex ) for all chunkCount chunks, spread over worker threads
+    template< typename CallbackType >
+    void ParticlesParallelForChunks( int chunkCount, CallbackType && callback )
+    {
+        if( chunkCount <= 0 )
+            return;
+        if( chunkCount == 1 )
+        {
+            callback( 0 );
+            return;
+        }
+
+#ifdef USE_MULTITHREADED_PARTICLES_WITH_GTS
+
+        gts::ParallelFor parallelFor( vaGTS::GetInstance().Scheduler() );
+        parallelFor( 0, chunkCount, callback );
+
+#elif defined( USE_MULTITHREADED_PARTICLES_WITH_TF )
+
+        tf::Taskflow taskflow;
+        taskflow.parallel_for( 0, chunkCount, 1, callback );
+        vaTF::GetInstance().Executor().run( taskflow ).wait();
+
+#else
+
+        vaThreading::ParallelFor( chunkCount, 1, [&callback]( int begin, int end ) { for( int i = begin; i < end; i++ ) callback( i ); } );
+
+#endif
+    }
+
+    // calls callback( beginIndex, endIndex ) for consecutive chunkSize ranges covering [0, itemCount), spread over worker threads
+    template< typename CallbackType >
+    void ParticlesParallelForRange( int itemCount, int chunkSize, CallbackType && callback )
+    {
+        const int chunkCount = ( itemCount + chunkSize - 1 ) / chunkSize;
+        ParticlesParallelForChunks( chunkCount, [itemCount, chunkSize, &callback]( int chunk )
+        {
+            callback( chunk * chunkSize, vaMath::Min( itemCount, ( chunk + 1 ) * chunkSize ) );
+        } );
+    }
+
+    // same as vaMath::AngleWrap (within float precision) but matches the SSE version below exactly
+    inline float WrapAngle( float angle )
+    {
+        return angle - ( VA_PIf * 2.0f ) * floorf( ( angle + VA_PIf ) * ( 0.5f / VA_PIf ) );
+    }
+
+#ifdef USE_SSE_PARTICLES
+    inline __m128 FloorSSE( __m128 x )
+    {
+        // SSE2 has no floor; truncate and correct negative non-integers (fine for the range of values we use it on)
+        __m128 truncated = _mm_cvtepi32_ps( _mm_cvttps_epi32( x ) );
+        return _mm_sub_ps( truncated, _mm_and_ps( _mm_cmpgt_ps( truncated, x ), _mm_set1_ps( 1.0f ) ) );
+    }
+
+    inline __m128 WrapAngleSSE( __m128 angle )
+    {
+        __m128 turns = FloorSSE( _mm_mul_ps( _mm_add_ps( angle, _mm_set1_ps( VA_PIf ) ), _mm_set1_ps( 0.5f / VA_PIf ) ) );
+        return _mm_sub_ps( angle, _mm_mul_ps( _mm_set1_ps( VA_PIf * 2.0f ), turns ) );
+    }
+
+    inline float HorizontalMinSSE( __m128 v )
+    {
+        v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+        v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        return _mm_cvtss_f32( v );
+    }
+
+    inline float HorizontalMaxSSE( __m128 v )
+    {
+        v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+        v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        return _mm_cvtss_f32( v );
+    }
+#endif
+}
+
+void vaSimpleParticleStore::Resize( int count )
+{
+    assert( count >= 0 );
+    m_count = count;
+    PositionX.resize( count );
+    PositionY.resize( count );
+    PositionZ.resize( count );
+    VelocityX.resize( count );
+    VelocityY.resize( count );
+    VelocityZ.resize( count );
+    Angle.resize( count );
+    AngularVelocity.resize( count );
+    AffectedByGravityK.resize( count );
+    AffectedByWindK.resize( count );
+    Color.resize( count );
+    LifeStart.resize( count );
+    LifeRemaining.resize( count );
+    Size.resize( count );
+    SizeChange.resize( count );
+    CreationID.resize( count );
+}
+
+void vaSimpleParticleStore::Reserve( int count )
+{
+    PositionX.reserve( count );
+    PositionY.reserve( count );
+    PositionZ.reserve( count );
+    VelocityX.reserve( count );
+    VelocityY.reserve( count );
+    VelocityZ.reserve( count );
+    Angle.reserve( count );
+    AngularVelocity.reserve( count );
+    AffectedByGravityK.reserve( count );
+    AffectedByWindK.reserve( count );
+    Color.reserve( count );
+    LifeStart.reserve( count );
+    LifeRemaining.reserve( count );
+    Size.reserve( count );
+    SizeChange.reserve( count );
+    CreationID.reserve( count );
+}
+
+void vaSimpleParticleStore::Move( int dstIndex, int srcIndex )
+{
+    assert( dstIndex >= 0 && dstIndex < m_count && srcIndex >= 0 && srcIndex < m_count );
+    PositionX[dstIndex]             = PositionX[srcIndex];
+    PositionY[dstIndex]             = PositionY[srcIndex];
+    PositionZ[dstIndex]             = PositionZ[srcIndex];
+    VelocityX[dstIndex]             = VelocityX[srcIndex];
+    VelocityY[dstIndex]             = VelocityY[srcIndex];
+    VelocityZ[dstIndex]             = VelocityZ[srcIndex];
+    Angle[dstIndex]                 = Angle[srcIndex];
+    AngularVelocity[dstIndex]       = AngularVelocity[srcIndex];
+    AffectedByGravityK[dstIndex]    = AffectedByGravityK[srcIndex];
+    AffectedByWindK[dstIndex]       = AffectedByWindK[srcIndex];
+    Color[dstIndex]                 = Color[srcIndex];
+    LifeStart[dstIndex]             = LifeStart[srcIndex];
+    LifeRemaining[dstIndex]         = LifeRemaining[srcIndex];
+    Size[dstIndex]                  = Size[srcIndex];
+    SizeChange[dstIndex]            = SizeChange[srcIndex];
+    CreationID[dstIndex]            = CreationID[srcIndex];
+}
+
+vaSimpleParticle vaSimpleParticleStore::Get( int index ) const
+{
+    assert( index >= 0 && index < m_count );
+    vaSimpleParticle ret;
+    ret.Position            = vaVector3( PositionX[index], PositionY[index], PositionZ[index] );
+    ret.Velocity            = vaVector3( VelocityX[index], VelocityY[index], VelocityZ[index] );
+    ret.Angle               = Angle[index];
+    ret.AngularVelocity     = AngularVelocity[index];
+    ret.AffectedByGravityK  = AffectedByGravityK[index];
+    ret.AffectedByWindK     = AffectedByWindK[index];
+    ret.Color               = Color[index];
+    ret.LifeStart           = LifeStart[index];
+    ret.LifeRemaining       = LifeRemaining[index];
+    ret.Size                = Size[index];
+    ret.SizeChange          = SizeChange[index];
+    ret.CreationID          = CreationID[index];
+    return ret;
+}
+
+void vaSimpleParticleStore::Set( int index, const vaSimpleParticle & particle )
+{
+    assert( index >= 0 && index < m_count );
+    PositionX[index]            = particle.Position.x;
+    PositionY[index]            = particle.Position.y;
+    PositionZ[index]            = particle.Position.z;
+    VelocityX[index]            = particle.Velocity.x;
+    VelocityY[index]            = particle.Velocity.y;
+    VelocityZ[index]            = particle.Velocity.z;
+    Angle[index]                = particle.Angle;
+    AngularVelocity[index]      = particle.AngularVelocity;
+    AffectedByGravityK[index]   = particle.AffectedByGravityK;
+    AffectedByWindK[index]      = particle.AffectedByWindK;
+    Color[index]                = particle.Color;
+    LifeStart[index]            = particle.LifeStart;
+    LifeRemaining[index]        = particle.LifeRemaining;
+    Size[index]                 = particle.Size;
+    SizeChange[index]           = particle.SizeChange;
+    CreationID[index]           = particle.CreationID;
+}
+
 
 //#pragma optimize( "gxy", on )
 
@@ -57,8 +256,8 @@ vaSimpleParticleSystem::vaSimpleParticleSystem( const vaRenderingModuleParams &
     m_shaderConstants( params )
 
 { 
-    delegate_particlesTickShader.AddWithToken( m_aliveToken, this, &vaSimpleParticleSystem::DefaultParticlesTickShader );
-    delegate_drawBufferUpdateShader.AddWithToken( m_aliveToken, this, &vaSimpleParticleSystem::DefaultDrawBufferUpdateShader );
+    delegate_particlesTickShader        = &vaSimpleParticleSystem::DefaultParticlesTickShader;
+    delegate_drawBufferUpdateShader     = &vaSimpleParticleSystem::DefaultDrawBufferUpdateShader;
 
     m_lastTickEmitterCount              = 0;
     m_lastTickParticleCount             = 0;
@@ -112,372 +311,371 @@ void vaSimpleParticleSystem::ReleaseEmitterPtr( std::shared_ptr<vaSimpleParticle
     ptr = NULL;
 }
 
-void vaSimpleParticleEmitter::DefaultEmitterTickShader( vaSimpleParticleSystem & psys, vaSimpleParticleEmitter & emitter, std::vector<vaSimpleParticle> & allParticles, float deltaTime )
+int vaSimpleParticleEmitter::TickSpawnCount( float deltaTime )
 {
-    psys; // unreferenced
-    // Warning: emitter is only allowed to push back new particles in allParticles, never remove or swap them!
-
-    emitter.RemainingEmitterLife -= deltaTime;
+    RemainingEmitterLife -= deltaTime;
 
-    if( emitter.RemainingEmitterLife < 0 )
-        return;
+    if( RemainingEmitterLife < 0 )
+        return 0;
 
-    emitter.TimeAccumulatedSinceLastSpawn += deltaTime;
+    TimeAccumulatedSinceLastSpawn += deltaTime;
 
     const int maxSpawnPerFrame = 512 * 1024;
-    int numberToSpawn = vaMath::Clamp( (int)(emitter.TimeAccumulatedSinceLastSpawn * emitter.Settings.SpawnFrequencyPerSecond), 0, maxSpawnPerFrame );
+    int numberToSpawn = vaMath::Clamp( (int)(TimeAccumulatedSinceLastSpawn * Settings.SpawnFrequencyPerSecond), 0, maxSpawnPerFrame );
 
-    if( (numberToSpawn > 0) && (emitter.Settings.SpawnFrequencyPerSecond > 0.0f) )
-        emitter.TimeAccumulatedSinceLastSpawn -= (float)numberToSpawn / emitter.Settings.SpawnFrequencyPerSecond;
+    if( (numberToSpawn > 0) && (Settings.SpawnFrequencyPerSecond > 0.0f) )
+        TimeAccumulatedSinceLastSpawn -= (float)numberToSpawn / Settings.SpawnFrequencyPerSecond;
 
-    if( emitter.RemainingEmitterParticleCount != INT_MAX )
-        emitter.RemainingEmitterParticleCount -= numberToSpawn;
+    if( RemainingEmitterParticleCount != INT_MAX )
+    {
+        numberToSpawn = vaMath::Min( numberToSpawn, vaMath::Max( 0, RemainingEmitterParticleCount ) );
+        RemainingEmitterParticleCount -= numberToSpawn;
+    }
 
-    for( int j = 0; j < numberToSpawn; j++ )
+    return numberToSpawn;
+}
+
+void vaSimpleParticleEmitter::DefaultEmitterSpawnShader( const vaSimpleParticleSystem & psys, const vaSimpleParticleEmitter & emitter, vaSimpleParticleStore & allParticles, int beginIndex, int endIndex, uint32 firstParticleID, vaRandom & random )
+{
+    psys; // unreferenced
+    // Warning: can run concurrently with other ranges of the same emitter - only write to [beginIndex, endIndex)!
+
+    const EmitterSettings & settings = emitter.Settings;
+
+    // local copies since RandomPointInside isn't const
+    vaOrientedBoundingBox   spawnBox;
+    vaBoundingSphere        spawnSphere;
+    if( settings.SpawnAreaType == vaSimpleParticleEmitter::SAT_BoundingBox )
+        spawnBox    = settings.SpawnAreaBoundingBox;
+    else if( settings.SpawnAreaType == vaSimpleParticleEmitter::SAT_BoundingSphere )
+        spawnSphere = settings.SpawnAreaBoundingSphere;
+    else
     {
-        allParticles.push_back( vaSimpleParticle() );
-        vaSimpleParticle & newParticle = allParticles.back();
+        assert( false );
+    }
 
-        emitter.LastParticleID++;
-        //emitter.LastParticleID &= 0xFFFF;
+    for( int i = beginIndex; i < endIndex; i++ )
+    {
+        allParticles.CreationID[i]          = firstParticleID + (uint32)( i - beginIndex );
 
-        newParticle.CreationID          = emitter.LastParticleID; //(psys.LastParticleID() & 0x00FFFFFF) | ((emitter.CreationID & 0xFF) << 24);
-        newParticle.LifeRemaining       = vaMath::Max( 0.0f, emitter.Settings.SpawnLife + (emitter.Settings.SpawnLifeRandomAddSub )    * vaRandom::Singleton.NextFloatRange( -1.0f, 1.0f ) );
-        newParticle.LifeStart           = newParticle.LifeRemaining;
+        float life                          = vaMath::Max( 0.0f, settings.SpawnLife + (settings.SpawnLifeRandomAddSub )    * random.NextFloatRange( -1.0f, 1.0f ) );
+        allParticles.LifeRemaining[i]       = life;
+        allParticles.LifeStart[i]           = life;
 
-        newParticle.Size                = vaMath::Max( 0.0f, emitter.Settings.SpawnSize + (emitter.Settings.SpawnSizeRandomAddSub)    * vaRandom::Singleton.NextFloatRange( -1.0f, 1.0f ) );
-        newParticle.SizeChange          = emitter.Settings.SpawnSizeChange + (emitter.Settings.SpawnSizeChangeRandomAddSub)           * vaRandom::Singleton.NextFloatRange( -1.0f, 1.0f );
+        allParticles.Size[i]                = vaMath::Max( 0.0f, settings.SpawnSize + (settings.SpawnSizeRandomAddSub)    * random.NextFloatRange( -1.0f, 1.0f ) );
+        allParticles.SizeChange[i]          = settings.SpawnSizeChange + (settings.SpawnSizeChangeRandomAddSub)           * random.NextFloatRange( -1.0f, 1.0f );
 
-        newParticle.Angle               = emitter.Settings.SpawnAngle + (emitter.Settings.SpawnAngleRandomAddSub)                     * vaRandom::Singleton.NextFloatRange( -1.0f, 1.0f );
-        newParticle.AngularVelocity     = emitter.Settings.SpawnAngularVelocity + (emitter.Settings.SpawnAngularVelocityRandomAddSub) * vaRandom::Singleton.NextFloatRange( -1.0f, 1.0f );
+        allParticles.Angle[i]               = settings.SpawnAngle + (settings.SpawnAngleRandomAddSub)                     * random.NextFloatRange( -1.0f, 1.0f );
+        allParticles.AngularVelocity[i]     = settings.SpawnAngularVelocity + (settings.SpawnAngularVelocityRandomAddSub) * random.NextFloatRange( -1.0f, 1.0f );
 
-        newParticle.AffectedByGravityK  = emitter.Settings.SpawnAffectedByGravityK;
-        newParticle.AffectedByWindK     = emitter.Settings.SpawnAffectedByWindK;
+        allParticles.AffectedByGravityK[i]  = settings.SpawnAffectedByGravityK;
+        allParticles.AffectedByWindK[i]     = settings.SpawnAffectedByWindK;
 
-        if( emitter.Settings.SpawnAreaType == vaSimpleParticleEmitter::SAT_BoundingBox )
-        {
-            newParticle.Position        = emitter.Settings.SpawnAreaBoundingBox.RandomPointInside( vaRandom::Singleton );
-        }
-        else if( emitter.Settings.SpawnAreaType == vaSimpleParticleEmitter::SAT_BoundingSphere )
-        {
-            newParticle.Position        = emitter.Settings.SpawnAreaBoundingSphere.RandomPointInside( vaRandom::Singleton );
-        }
-        else
-        {
-            assert( false );
-        }
-        newParticle.Velocity        = emitter.Settings.SpawnVelocity + emitter.Settings.SpawnVelocityRandomAddSub * ( vaVector3::Random() * 2.0f - 1.0f );
-        newParticle.Color           = emitter.Settings.SpawnColor + emitter.Settings.SpawnColorRandomAddSub * ( vaVector4::Random()  * 2.0f - 1.0f );
+        vaVector3 position( 0.0f, 0.0f, 0.0f );
+        if( settings.SpawnAreaType == vaSimpleParticleEmitter::SAT_BoundingBox )
+            position = spawnBox.RandomPointInside( random );
+        else if( settings.SpawnAreaType == vaSimpleParticleEmitter::SAT_BoundingSphere )
+            position = spawnSphere.RandomPointInside( random );
+        allParticles.PositionX[i]           = position.x;
+        allParticles.PositionY[i]           = position.y;
+        allParticles.PositionZ[i]           = position.z;
+
+        vaVector3 velocity                  = settings.SpawnVelocity + settings.SpawnVelocityRandomAddSub * ( vaVector3::Random( random ) * 2.0f - 1.0f );
+        allParticles.VelocityX[i]           = velocity.x;
+        allParticles.VelocityY[i]           = velocity.y;
+        allParticles.VelocityZ[i]           = velocity.z;
+
+        allParticles.Color[i]               = settings.SpawnColor + settings.SpawnColorRandomAddSub * ( vaVector4::Random( random )  * 2.0f - 1.0f );
     }
 }
 
-void vaSimpleParticleSystem::DefaultParticlesTickShader( vaSimpleParticleSystem & psys, std::vector<vaSimpleParticle> & allParticles, float deltaTime )
+void vaSimpleParticleSystem::DefaultParticlesTickShader( const vaSimpleParticleSystem & psys, vaSimpleParticleStore & allParticles, int beginIndex, int endIndex, float deltaTime )
 {
-    psys;
-
-    // Warning: particle shader is NOT allowed to push back new particles to allParticles, remove them or reorder them!
+    // Warning: particle shader is NOT allowed to add new particles, remove them or reorder them!
     if( deltaTime == 0.0f )
         return;
-    
-    const int loopLength = (int)allParticles.size( );
-    if( loopLength == 0 )
-        return;
 
-    auto elementTickProc = [&psys, &deltaTime, &settings = m_settings]( vaSimpleParticle & particle )
-        {
-            particle.LifeRemaining -= deltaTime;
-
-            particle.Position += particle.Velocity * deltaTime;
-            particle.Angle = vaMath::AngleWrap( particle.Angle + particle.AngularVelocity * deltaTime );
-            particle.Size = vaMath::Max( 0.0f, particle.Size + particle.SizeChange * deltaTime );
-
-            particle.Velocity += particle.AffectedByGravityK * settings.Gravity * deltaTime;
-            particle.Velocity += particle.AffectedByWindK * settings.Wind * deltaTime;
-            particle.Velocity = vaMath::Lerp( particle.Velocity, vaVector3( 0.0f, 0.0f, 0.0f ), vaMath::TimeIndependentLerpF( deltaTime, settings.VelocityDamping ) );
-
-            particle.AngularVelocity = vaMath::Lerp( particle.AngularVelocity, 0.0f, vaMath::TimeIndependentLerpF( deltaTime, settings.AngularVelocityDamping ) );
-        };
-
-#ifdef USE_MULTITHREADED_PARTICLES_WITH_GTS
-
-    gts::ParallelFor parallelFor(vaGTS::GetInstance().Scheduler());
-    parallelFor(allParticles.begin(), allParticles.end(),
-        [&elementTickProc](auto particleIter) { elementTickProc( *particleIter ); } );
+    const auto & settings = psys.m_settings;
+
+    // everything that doesn't depend on the particle itself; damping is a lerp towards 0 so it's just a scale
+    const float     velocityScale           = 1.0f - vaMath::TimeIndependentLerpF( deltaTime, settings.VelocityDamping );
+    const float     angularVelocityScale    = 1.0f - vaMath::TimeIndependentLerpF( deltaTime, settings.AngularVelocityDamping );
+    const vaVector3 gravityDelta            = settings.Gravity * deltaTime;
+    const vaVector3 windDelta               = settings.Wind * deltaTime;
+
+    float * const       posX        = allParticles.PositionX.data( );
+    float * const       posY        = allParticles.PositionY.data( );
+    float * const       posZ        = allParticles.PositionZ.data( );
+    float * const       velX        = allParticles.VelocityX.data( );
+    float * const       velY        = allParticles.VelocityY.data( );
+    float * const       velZ        = allParticles.VelocityZ.data( );
+    float * const       angle       = allParticles.Angle.data( );
+    float * const       angVel      = allParticles.AngularVelocity.data( );
+    float * const       life        = allParticles.LifeRemaining.data( );
+    float * const       size        = allParticles.Size.data( );
+    const float * const sizeChange  = allParticles.SizeChange.data( );
+    const float * const gravityK    = allParticles.AffectedByGravityK.data( );
+    const float * const windK       = allParticles.AffectedByWindK.data( );
+
+    int i = beginIndex;
+
+#ifdef USE_SSE_PARTICLES
+    const __m128 dt         = _mm_set1_ps( deltaTime );
+    const __m128 zero       = _mm_setzero_ps( );
+    const __m128 velScale   = _mm_set1_ps( velocityScale );
+    const __m128 angVelScale= _mm_set1_ps( angularVelocityScale );
+    const __m128 gravityX   = _mm_set1_ps( gravityDelta.x );
+    const __m128 gravityY   = _mm_set1_ps( gravityDelta.y );
+    const __m128 gravityZ   = _mm_set1_ps( gravityDelta.z );
+    const __m128 windX      = _mm_set1_ps( windDelta.x );
+    const __m128 windY      = _mm_set1_ps( windDelta.y );
+    const __m128 windZ      = _mm_set1_ps( windDelta.z );
+
+    for( ; i + 4 <= endIndex; i += 4 )
+    {
+        _mm_storeu_ps( life + i, _mm_sub_ps( _mm_loadu_ps( life + i ), dt ) );
+
+        // position integrates the velocity from the start of the step, same as the scalar version
+        __m128 vx = _mm_loadu_ps( velX + i );
+        __m128 vy = _mm_loadu_ps( velY + i );
+        __m128 vz = _mm_loadu_ps( velZ + i );
+        _mm_storeu_ps( posX + i, _mm_add_ps( _mm_loadu_ps( posX + i ), _mm_mul_ps( vx, dt ) ) );
+        _mm_storeu_ps( posY + i, _mm_add_ps( _mm_loadu_ps( posY + i ), _mm_mul_ps( vy, dt ) ) );
+        _mm_storeu_ps( posZ + i, _mm_add_ps( _mm_loadu_ps( posZ + i ), _mm_mul_ps( vz, dt ) ) );
+
+        __m128 av = _mm_loadu_ps( angVel + i );
+        _mm_storeu_ps( angle + i, WrapAngleSSE( _mm_add_ps( _mm_loadu_ps( angle + i ), _mm_mul_ps( av, dt ) ) ) );
+        _mm_storeu_ps( angVel + i, _mm_mul_ps( av, angVelScale ) );
+
+        _mm_storeu_ps( size + i, _mm_max_ps( zero, _mm_add_ps( _mm_loadu_ps( size + i ), _mm_mul_ps( _mm_loadu_ps( sizeChange + i ), dt ) ) ) );
+
+        __m128 gk = _mm_loadu_ps( gravityK + i );
+        __m128 wk = _mm_loadu_ps( windK + i );
+        vx = _mm_add_ps( vx, _mm_add_ps( _mm_mul_ps( gk, gravityX ), _mm_mul_ps( wk, windX ) ) );
+        vy = _mm_add_ps( vy, _mm_add_ps( _mm_mul_ps( gk, gravityY ), _mm_mul_ps( wk, windY ) ) );
+        vz = _mm_add_ps( vz, _mm_add_ps( _mm_mul_ps( gk, gravityZ ), _mm_mul_ps( wk, windZ ) ) );
+        _mm_storeu_ps( velX + i, _mm_mul_ps( vx, velScale ) );
+        _mm_storeu_ps( velY + i, _mm_mul_ps( vy, velScale ) );
+        _mm_storeu_ps( velZ + i, _mm_mul_ps( vz, velScale ) );
+    }
+#endif
 
-#elif defined( USE_MULTITHREADED_PARTICLES_WITH_TF )
+    // remainder (or everything, if no SSE)
+    for( ; i < endIndex; i++ )
+    {
+        life[i] -= deltaTime;
 
-    tf::Taskflow taskflow;
-    taskflow.parallel_for( allParticles.begin(), allParticles.end(), elementTickProc );
-    vaTF::GetInstance().Executor().run( taskflow ).wait();
+        posX[i] += velX[i] * deltaTime;
+        posY[i] += velY[i] * deltaTime;
+        posZ[i] += velZ[i] * deltaTime;
 
-#else
+        angle[i]    = WrapAngle( angle[i] + angVel[i] * deltaTime );
+        angVel[i]   *= angularVelocityScale;
 
-    for( int i = 0; i < loopLength; i++ )
-        elementTickProc( allParticles[i] );
+        size[i]     = vaMath::Max( 0.0f, size[i] + sizeChange[i] * deltaTime );
 
-#endif
+        velX[i]     = ( velX[i] + gravityK[i] * gravityDelta.x + windK[i] * windDelta.x ) * velocityScale;
+        velY[i]     = ( velY[i] + gravityK[i] * gravityDelta.y + windK[i] * windDelta.y ) * velocityScale;
+        velZ[i]     = ( velZ[i] + gravityK[i] * gravityDelta.z + windK[i] * windDelta.z ) * velocityScale;
+    }
 }
 
-void vaSimpleParticleSystem::Sort(const vaVector3& _cameraPos, bool backToFront)
+void vaSimpleParticleSystem::Sort( const vaVector3 & cameraPos, bool backToFront )
 {
     VA_TRACE_CPU_SCOPE( vaSimpleParticleSystem_Sort );
 
     m_sortedAfterTick = true;
 
-    vaVector3 cameraPos = _cameraPos;
+    const int totalParticleCount = m_particles.Count( );
 
-    const std::vector<vaSimpleParticle>& allParticles = m_particles;
-    std::vector< float >& sortValues = m_particleSortValueCache;
-    std::vector< int >& sortedIndices = m_particleSortedIndices;
+    m_particleSortValueCache.resize( totalParticleCount );
+    m_particleSortKeys.resize( totalParticleCount );
+    m_particleSortKeysScratch.resize( totalParticleCount );
+    m_particleSortedIndices.resize( totalParticleCount );
+    m_particleSortedIndicesScratch.resize( totalParticleCount );
 
-    if (allParticles.size() == 0)
+    if( totalParticleCount == 0 )
         return;
 
-    if (allParticles.size() > sortValues.size())
-        sortValues.resize(allParticles.size());
-    if (m_particles.size() > m_particleSortedIndices.size())
-        m_particleSortedIndices.resize(m_particles.size());
-
-    // to disable sort
-#if 0
-    {
-        for( size_t i = 0; i < allParticles.size( ); i++ )
-        {
-            sortedIndices[i] = (int)i;
-        }
-        m_sortedAfterTick = true;
-        return;
-    }
-#endif
+    // Distance to camera gets quantized (over the distance range of this frame) to a c_sortKeyBits integer key, then sorted with an LSD
+    // radix sort: every pass is a parallel per-chunk histogram, a prefix sum over all chunk histograms and a parallel scatter. Each pass
+    // is stable, so particles with the same key stay in index order and the result is the same regardless of the chunking / threading.
+    const int chunkCount = vaMath::Clamp( totalParticleCount / c_sortMinChunkSize, 1, c_sortMaxChunkCount );
+    auto chunkBegin = [totalParticleCount, chunkCount]( int chunk ) { return (int)( (int64)totalParticleCount * chunk / chunkCount ); };
 
+    m_particleSortHistograms.resize( chunkCount * c_sortDigitCount );
 
-    float backToFrontMultiplier = ( backToFront ) ? ( 1.0f ) : ( -1.0f );
+    const float * const posX        = m_particles.PositionX.data( );
+    const float * const posY        = m_particles.PositionY.data( );
+    const float * const posZ        = m_particles.PositionZ.data( );
+    float * const       distances   = m_particleSortValueCache.data( );
+    uint32 * const      histograms  = m_particleSortHistograms.data( );
 
-    struct MySortComparerBackToFront
+    // distances and their range
+    float chunkMinDistance[c_sortMaxChunkCount];
+    float chunkMaxDistance[c_sortMaxChunkCount];
+    ParticlesParallelForChunks( chunkCount, [&]( int chunk )
     {
-        const std::vector< float >& SortValues;
-        MySortComparerBackToFront(const std::vector< float >& sortValues) : SortValues(sortValues)
-        {}
-        bool operator() (int i, int j)
+        const int beginIndex = chunkBegin( chunk );
+        const int endIndex   = chunkBegin( chunk + 1 );
+
+        float minDistance = std::numeric_limits<float>::max( );
+        float maxDistance = 0.0f;
+
+        int i = beginIndex;
+#ifdef USE_SSE_PARTICLES
+        const __m128 camX = _mm_set1_ps( cameraPos.x );
+        const __m128 camY = _mm_set1_ps( cameraPos.y );
+        const __m128 camZ = _mm_set1_ps( cameraPos.z );
+        __m128 minDistanceV = _mm_set1_ps( minDistance );
+        __m128 maxDistanceV = _mm_set1_ps( maxDistance );
+        for( ; i + 4 <= endIndex; i += 4 )
         {
-            return (SortValues[i] > SortValues[j]);
+            __m128 dx = _mm_sub_ps( _mm_loadu_ps( posX + i ), camX );
+            __m128 dy = _mm_sub_ps( _mm_loadu_ps( posY + i ), camY );
+            __m128 dz = _mm_sub_ps( _mm_loadu_ps( posZ + i ), camZ );
+            __m128 distance = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ), _mm_mul_ps( dz, dz ) ) );
+            _mm_storeu_ps( distances + i, distance );
+            // 'distance' first so that a NaN doesn't end up in the range
+            minDistanceV = _mm_min_ps( distance, minDistanceV );
+            maxDistanceV = _mm_max_ps( distance, maxDistanceV );
         }
-    } mySortComparerBackToFront(sortValues);
-
-    const int totalParticleCount = (int)allParticles.size();
-
-    const int recursionDepth    = 5;    // for max 1 << recursionDepth parallel jobs in the beginning
-    const int leafBucketCount   = 1 << recursionDepth;
-    int bucketSize              = ( totalParticleCount + leafBucketCount - 1 ) / leafBucketCount;
-    int     sortBucketBoundaries[leafBucketCount + 1];
-    std::atomic_int32_t readinessFlags[ leafBucketCount * recursionDepth ];
-
-    assert( vaMath::IsPowOf2(leafBucketCount) );
-
-    for( int bucketIndex = 0; bucketIndex <= leafBucketCount; bucketIndex++ )
-    {
-        sortBucketBoundaries[ bucketIndex ] = vaMath::Min( ( bucketIndex ) * bucketSize, totalParticleCount );
-    }
-    for( int level = 0; level < recursionDepth; level++ )
-        for( int bucketIndex = 0; bucketIndex < leafBucketCount; bucketIndex++ )
+        minDistance = HorizontalMinSSE( minDistanceV );
+        maxDistance = HorizontalMaxSSE( maxDistanceV );
+#endif
+        for( ; i < endIndex; i++ )
         {
-            readinessFlags[ level * leafBucketCount + bucketIndex ] = 0;
+            float distance = vaVector3( posX[i] - cameraPos.x, posY[i] - cameraPos.y, posZ[i] - cameraPos.z ).Length( );
+            distances[i] = distance;
+            minDistance = ( distance < minDistance ) ? ( distance ) : ( minDistance );
+            maxDistance = ( distance > maxDistance ) ? ( distance ) : ( maxDistance );
         }
+        chunkMinDistance[chunk] = minDistance;
+        chunkMaxDistance[chunk] = maxDistance;
+    } );
 
-    std::function< void(int, int) > mergeArea = [&](int level, int bucketID)
+    float minDistance = chunkMinDistance[0];
+    float maxDistance = chunkMaxDistance[0];
+    for( int chunk = 1; chunk < chunkCount; chunk++ )
     {
-        int currentStep = 1 << level;
-        //int currentCount = leafBucketCount / currentStep;
-
-        int left        = bucketID * currentStep;
-        int middle      = left + currentStep/2;
-        int right       = left + currentStep;
-        int indexLeft   = sortBucketBoundaries[left];
-        int indexMiddle = sortBucketBoundaries[middle];
-        int indexRight  = sortBucketBoundaries[right];
-
-        std::inplace_merge( sortedIndices.begin( ) + indexLeft, sortedIndices.begin( ) + indexMiddle, sortedIndices.begin( ) + indexRight, mySortComparerBackToFront );
-
-        if( level == recursionDepth )
-            return;
-
-        // no need to spawn further tasks recursively since only one out of two will result in new compute we can just reuse this one 
-        if( readinessFlags[level * leafBucketCount + bucketID / 2].fetch_add(1) == 1 )
-        {
-            //int level = 0;
-            mergeArea(level + 1, bucketID / 2);
-        }
+        minDistance = vaMath::Min( minDistance, chunkMinDistance[chunk] );
+        maxDistance = vaMath::Max( maxDistance, chunkMaxDistance[chunk] );
+    }
 
-    };
+    const uint32 maxKey     = ( 1u << c_sortKeyBits ) - 1;
+    const float  keyScale   = ( maxDistance > minDistance ) ? ( (float)maxKey / ( maxDistance - minDistance ) ) : ( 0.0f );
+    const uint32 digitMask  = c_sortDigitCount - 1;
 
-    auto doChunk = [&](int bucketIndex)
+    // quantize to keys (radix sort is ascending, so for back-to-front the farthest get the smallest key) & histogram of the first digit
+    ParticlesParallelForChunks( chunkCount, [&]( int chunk )
     {
-        const int startFrom = sortBucketBoundaries[bucketIndex];
-        const int stopAt    = sortBucketBoundaries[bucketIndex + 1];
-        for (int i = startFrom; i < stopAt; i++)
-        {
-            sortValues[i] = backToFrontMultiplier * (allParticles[i].Position - cameraPos).Length();
-            sortedIndices[i] = (int)i;
-        }
-        std::sort(sortedIndices.begin() + startFrom, sortedIndices.begin() + stopAt, mySortComparerBackToFront);
+        const int beginIndex = chunkBegin( chunk );
+        const int endIndex   = chunkBegin( chunk + 1 );
 
-        int level = 0;
+        uint32 * histogram  = histograms + chunk * c_sortDigitCount;
+        uint32 * keys       = m_particleSortKeys.data( );
+        int * indices       = m_particleSortedIndices.data( );
+        memset( histogram, 0, sizeof( uint32 ) * c_sortDigitCount );
 
-        if (readinessFlags[level * leafBucketCount + bucketIndex / 2].fetch_add(1) == 1)
+        for( int i = beginIndex; i < endIndex; i++ )
         {
-            //int level = 0;
-            mergeArea(1, bucketIndex / 2);
+            float quantized = ( distances[i] - minDistance ) * keyScale;
+            uint32 key = ( quantized >= 0.0f ) ? ( (uint32)vaMath::Min( quantized, (float)maxKey ) ) : ( 0 );   // also catches NaN-s
+            if( backToFront )
+                key = maxKey - key;
+            keys[i]     = key;
+            indices[i]  = i;
+            histogram[key & digitMask]++;
         }
-    };
-
-#ifdef USE_MULTITHREADED_PARTICLES_WITH_GTS
-    
-    gts::ParallelFor parallelFor(vaGTS::GetInstance().Scheduler());
+    } );
 
-    parallelFor(0, leafBucketCount, doChunk );
-
-#elif defined( USE_MULTITHREADED_PARTICLES_WITH_TF )
-
-    tf::Taskflow taskflow("parallel_sort");
-
-#if 0
-    taskflow.parallel_for( 0, leafBucketCount, 1, doChunk );
-    vaTF::GetInstance().Executor().run( taskflow ).wait();
-#else
-    // this version should in theory schedule better but leave it unused for closer GTS vs TF comparison
-    std::function< tf::Task(int, int) > recursiveTaskMaker = [&]( int beginIndex, int endIndex )
+    uint32 * keysIn         = m_particleSortKeys.data( );
+    uint32 * keysOut        = m_particleSortKeysScratch.data( );
+    int *    indicesIn      = m_particleSortedIndices.data( );
+    int *    indicesOut     = m_particleSortedIndicesScratch.data( );
+    for( int pass = 0; pass < c_sortKeyBits / c_sortDigitBits; pass++ )
     {
-        const int leafSizeMax = 1024;
-        const int count = endIndex-beginIndex;
-        if( count < 2 )
-            return taskflow.placeholder().name("empty");
+        const int shift = pass * c_sortDigitBits;
 
-        // if the count is smaller than x, just compute distances & sort directly
-        if( count < leafSizeMax )
+        if( pass > 0 )
         {
-            return taskflow.emplace( [beginIndex, endIndex, &allParticles, backToFrontMultiplier, cameraPos, &sortValues, &sortedIndices, &mySortComparerBackToFront]()
-            { // lambda that does the actual distance compute and sort on other threads
-                for( int i = beginIndex; i < endIndex; i++ )
-                {
-                    sortValues[i] = backToFrontMultiplier * ( allParticles[i].Position - cameraPos ).Length( );
-                    sortedIndices[i] = (int)i;
-                }
-                std::sort( sortedIndices.begin( ) + beginIndex, sortedIndices.begin( ) + endIndex, mySortComparerBackToFront );
-            } ).name( "sort" );
-        }
-        else // divide into halves, let them each (L, R) sort their parts and then merge-sort them
-        {
-            int halfWay = beginIndex + (count+1)/2;
-            tf::Task L = recursiveTaskMaker( beginIndex, halfWay );
-            tf::Task R = recursiveTaskMaker( halfWay, endIndex );
-            tf::Task M = taskflow.emplace( [ beginIndex, halfWay, endIndex, &sortedIndices, &mySortComparerBackToFront ]( )
-            { // lambda that does the actual sort on other threads
-                std::inplace_merge( sortedIndices.begin( ) + beginIndex, 
-                    sortedIndices.begin( ) + halfWay, sortedIndices.begin( ) + endIndex, mySortComparerBackToFront );
+            ParticlesParallelForChunks( chunkCount, [&]( int chunk )
+            {
+                uint32 * histogram = histograms + chunk * c_sortDigitCount;
+                memset( histogram, 0, sizeof( uint32 ) * c_sortDigitCount );
+                for( int i = chunkBegin( chunk ), endIndex = chunkBegin( chunk + 1 ); i < endIndex; i++ )
+                    histogram[( keysIn[i] >> shift ) & digitMask]++;
             } );
-            M.succeed( L, R ).name( "merge" );
-            return M;
         }
-    };
-    auto finalTask = recursiveTaskMaker( 0, totalParticleCount );
-    finalTask.name( "final_merge" );
-//    string dump = taskflow.dump();
-    vaTF::GetInstance( ).Executor( ).run( taskflow ).wait( );
-#endif
 
-#else
-
-    for (int t = 0; t < leafBucketCount; t++)
-        doChunk( t );
-
-#endif
+        // histograms to output offsets: digit-major, so within the same digit lower chunks (lower input positions) go first
+        uint32 offset = 0;
+        for( int digit = 0; digit < c_sortDigitCount; digit++ )
+            for( int chunk = 0; chunk < chunkCount; chunk++ )
+            {
+                uint32 & entry  = histograms[chunk * c_sortDigitCount + digit];
+                uint32 count    = entry;
+                entry           = offset;
+                offset          += count;
+            }
+        assert( offset == (uint32)totalParticleCount );
 
-    // just plain old sort for testing the correctness of above
-#if 0
-    std::vector< int > testParticleSortedIndices;
-    testParticleSortedIndices.resize( m_particles.size( ) );
-    {
-        //float distMax = VA_FLOAT_LOWEST;
-        //float distMin = VA_FLOAT_HIGHEST;
-        for( size_t i = 0; i < allParticles.size( ); i++ )
+        ParticlesParallelForChunks( chunkCount, [&]( int chunk )
         {
-            sortValues[i] = backToFrontMultiplier * ( allParticles[i].Position - cameraPos ).Length( );
-            testParticleSortedIndices[i] = (int)i;
-            //distMax = vaMath::Max( distMax, sortValues[i] );
-            //distMin = vaMath::Min( distMin, sortValues[i] );
-        }
+            uint32 * offsets = histograms + chunk * c_sortDigitCount;
+            for( int i = chunkBegin( chunk ), endIndex = chunkBegin( chunk + 1 ); i < endIndex; i++ )
+            {
+                const uint32 key = keysIn[i];
+                const uint32 dst = offsets[( key >> shift ) & digitMask]++;
+                keysOut[dst]    = key;
+                indicesOut[dst] = indicesIn[i];
+            }
+        } );
 
-        std::sort( testParticleSortedIndices.begin( ), testParticleSortedIndices.begin() + allParticles.size(), mySortComparerBackToFront );
-        m_sortedAfterTick = true;
+        std::swap( keysIn, keysOut );
+        std::swap( indicesIn, indicesOut );
     }
-    for( size_t i = 0; i < testParticleSortedIndices.size(); i++ )
+    // even number of passes so the result is back where we started
+    assert( indicesIn == m_particleSortedIndices.data( ) );
+
+    // for testing the correctness of above
+#if 0
+    for( int i = 1; i < totalParticleCount; i++ )
     {
-        if( m_particleSortedIndices[i] != testParticleSortedIndices[i] )
-        {
-            float l = sortValues[m_particleSortedIndices[i]];
-            float r = sortValues[testParticleSortedIndices[i]];
-            assert( l == r );
-        }
+        assert( m_particleSortKeys[i-1] <= m_particleSortKeys[i] );
+        assert( m_particleSortKeys[i-1] != m_particleSortKeys[i] || m_particleSortedIndices[i-1] < m_particleSortedIndices[i] );
     }
-    m_particleSortedIndices = testParticleSortedIndices;
 #endif
 }
 
-void vaSimpleParticleSystem::DefaultDrawBufferUpdateShader( const vaSimpleParticleSystem &, const std::vector<vaSimpleParticle> & allParticles, const std::vector< int > & sortedIndices, void * outDestinationBuffer, size_t inDestinationBufferSize )
+void vaSimpleParticleSystem::DefaultDrawBufferUpdateShader( const vaSimpleParticleSystem & psys, const vaSimpleParticleStore & allParticles, const std::vector< int > & sortedIndices, int beginIndex, int endIndex, vaBillboardSprite * outDestinationBuffer )
 {
-    vaBillboardSprite * particleBuffer = (vaBillboardSprite *)outDestinationBuffer;
+    const float fadeAlphaFrom = psys.m_settings.FadeAlphaFrom;
 
-    if( inDestinationBufferSize != sizeof(vaBillboardSprite) * allParticles.size() )
+    for( int i = beginIndex; i < endIndex; i++ )
     {
-        // buffer size mismatch? something is wrong
-        assert( false );
-        return;
-    }
-    
-    const int loopLength = (int)allParticles.size( );
-    if( loopLength == 0 )
-        return;
+        const int index = sortedIndices[i];
+        vaBillboardSprite & outVertex = outDestinationBuffer[i];
 
-    auto elementTickProc = [&allParticles, &sortedIndices, particleBuffer, this](int i)
-        {
-            const vaSimpleParticle & particle = allParticles[sortedIndices[i]];
-            vaBillboardSprite & outVertex = particleBuffer[i];
-
-            outVertex.Position_CreationID = vaVector4( particle.Position, *((float*)&particle.CreationID) );
-
-            vaVector4 color = particle.Color;
+        const uint32 creationID = allParticles.CreationID[index];
+        outVertex.Position_CreationID = vaVector4( allParticles.PositionX[index], allParticles.PositionY[index], allParticles.PositionZ[index], *((float*)&creationID) );
 
-            color.w *= vaMath::Saturate( 1.0f - ( ( 1.0f - particle.LifeRemaining / particle.LifeStart ) - m_settings.FadeAlphaFrom ) / ( 1.0f - m_settings.FadeAlphaFrom ) );
+        vaVector4 color = allParticles.Color[index];
 
-            // outVertex.Color = vaVector4::ToRGBA( color );
-            outVertex.Color = color;
+        color.w *= vaMath::Saturate( 1.0f - ( ( 1.0f - allParticles.LifeRemaining[index] / allParticles.LifeStart[index] ) - fadeAlphaFrom ) / ( 1.0f - fadeAlphaFrom ) );
 
-            float ca = vaMath::Cos( particle.Angle );
-            float sa = vaMath::Sin( particle.Angle );
-
-            outVertex.Transform2D.x =  ca * particle.Size;
-            outVertex.Transform2D.y = -sa * particle.Size;
-            outVertex.Transform2D.z =  sa * particle.Size;
-            outVertex.Transform2D.w =  ca * particle.Size;
-        };
-
-#ifdef USE_MULTITHREADED_PARTICLES_WITH_GTS
+        // outVertex.Color = vaVector4::ToRGBA( color );
+        outVertex.Color = color;
 
-    gts::ParallelFor parallelFor(vaGTS::GetInstance().Scheduler());
-    parallelFor( 0, (int)allParticles.size(), elementTickProc );
+        const float size = allParticles.Size[index];
+        float ca = vaMath::Cos( allParticles.Angle[index] );
+        float sa = vaMath::Sin( allParticles.Angle[index] );
 
-#elif defined( USE_MULTITHREADED_PARTICLES_WITH_TF )
-
-    tf::Taskflow taskflow;
-    taskflow.parallel_for( 0, loopLength, 1, elementTickProc );
-    vaTF::GetInstance().Executor().run( taskflow ).wait();
-
-#else
-
-    for( int i = 0; i < loopLength; i++ )
-        elementTickProc( i );
-
-#endif
+        outVertex.Transform2D.x =  ca * size;
+        outVertex.Transform2D.y = -sa * size;
+        outVertex.Transform2D.z =  sa * size;
+        outVertex.Transform2D.w =  ca * size;
+    }
 }
 
 void vaSimpleParticleSystem::DrawDebugBoxes( )
@@ -509,12 +707,13 @@ void vaSimpleParticleSystem::DrawDebugBoxes( )
     }
     if( dbgShowParticles )
     {
-        for( uint32 i = 0; i < m_particles.size( ); i++ )
+        for( int i = 0; i < m_particles.Count( ); i++ )
         {
-            vaVector3 halfSize = vaVector3( m_particles[i].Size * 0.5f, m_particles[i].Size * 0.5f, m_particles[i].Size * 0.5f );
-            vaBoundingBox aabb( m_particles[i].Position - halfSize, halfSize * 2 );
+            vaSimpleParticle particle = m_particles.Get( i );
+            vaVector3 halfSize = vaVector3( particle.Size * 0.5f, particle.Size * 0.5f, particle.Size * 0.5f );
+            vaBoundingBox aabb( particle.Position - halfSize, halfSize * 2 );
             vaOrientedBoundingBox obb( aabb, this->GetTransform( ) );
-            canvas3D->DrawBox( aabb, 0x00000000, vaVector4::ToBGRA( m_particles[i].Color ) );
+            canvas3D->DrawBox( aabb, 0x00000000, vaVector4::ToBGRA( particle.Color ) );
         }
     }
 #endif
@@ -527,7 +726,10 @@ void vaSimpleParticleSystem::Tick( float deltaTime )
 
     {
         VA_TRACE_CPU_SCOPE( Emitters );
-        const size_t particlesBeforeEmitterShaders = m_particles.size( );
+
+        // emitter bookkeeping is cheap and done serially: it decides how many particles each emitter spawns and where in the store they go
+        m_spawnJobs.clear( );
+        int totalParticleCount = m_particles.Count( );
         for( size_t i = 0; i < m_emitters.size( ); i++ )
         {
             vaSimpleParticleEmitter & emitter = *m_emitters[i].get( );
@@ -538,80 +740,125 @@ void vaSimpleParticleSystem::Tick( float deltaTime )
                 if( m_emitters[i].use_count() == 1 ) // this assert is not entirely correct for multithreaded scenarios so beware
                 {
                     ReleaseEmitterPtr( m_emitters[i] ); // WARNING: this makes "emitter" variable a zero pointer from now on!!
-                    if( m_emitters.size( ) == (i-1) )
-                    {
-                        m_emitters.pop_back( );
-                    }
-                    else
-                    {
-                        m_emitters[i] = m_emitters.back( );
-                        m_emitters.pop_back( );
-                        i--;
-                    }
+                    m_emitters[i] = m_emitters.back( );
+                    m_emitters.pop_back( );
+                    i--;
                 }
                 continue;
             }
 
-            // emitter is only allowed to push back new particles, never remove or swap them!
-            m_emitters[i]->delegate_emitterTickShader.Invoke( *this, *m_emitters[i].get(), m_particles, deltaTime );
+            const int spawnCount = emitter.TickSpawnCount( deltaTime );
+            for( int offset = 0; offset < spawnCount; offset += c_spawnChunkSize )
+                m_spawnJobs.push_back( { &emitter, totalParticleCount + offset, totalParticleCount + vaMath::Min( spawnCount, offset + c_spawnChunkSize ), emitter.LastParticleID + 1 + (uint32)offset } );
+            emitter.LastParticleID  += (uint32)spawnCount;
+            totalParticleCount      += spawnCount;
 
             // emitter no longer active?
             if( ( ( emitter.RemainingEmitterLife <= 0 ) || ( emitter.RemainingEmitterParticleCount <= 0 ) ) )
-            {
                 emitter.Active = false;
-                continue;
-            }
         }
+
+        // ...and the actual spawning is spread over threads (emitters stay alive until the next Tick at least, so the pointers are safe)
+        m_particles.Resize( totalParticleCount );
+        ParticlesParallelForChunks( (int)m_spawnJobs.size( ), [this]( int jobIndex )
+        {
+            const SpawnJob & job = m_spawnJobs[jobIndex];
+            // seeded only from emitter & particle IDs so the results don't depend on which thread runs the job or when
+            vaRandom random( (int)( ( job.Emitter->CreationID * 0x9E3779B1u ) ^ job.FirstParticleID ) );
+            job.Emitter->delegate_emitterSpawnShader( *this, *job.Emitter, m_particles, job.BeginIndex, job.EndIndex, job.FirstParticleID, random );
+        } );
     }
 
     {
         VA_TRACE_CPU_SCOPE( TickShader );
-        const size_t particlesBeforeParticleShader = m_particles.size( );
-        delegate_particlesTickShader.Invoke( *this, m_particles, deltaTime );
-        assert( particlesBeforeParticleShader == m_particles.size( ) );
+        ParticlesParallelForRange( m_particles.Count( ), c_tickChunkSize, [this, deltaTime]( int beginIndex, int endIndex )
+        {
+            delegate_particlesTickShader( *this, m_particles, beginIndex, endIndex, deltaTime );
+        } );
     }
 
-
-    // update bounding box and remove dead particles
-    // TODO: !!! multithread this - also rework dead particle strategy !!!
+    // remove dead particles and update bounding box
     {
         VA_TRACE_CPU_SCOPE( UpdateBBAndDelete );
 
-        m_boundingBox = vaBoundingBox::Degenerate;
-
-        if( m_particles.size( ) > 0 )
+        // replace each dead particle with the last one; going backwards means the one moved in was already checked
+        int aliveCount = m_particles.Count( );
+        const float * lifeRemaining = m_particles.LifeRemaining.data( );
+        for( int i = aliveCount - 1; i >= 0; i-- )
         {
-            vaVector3 bsize = vaVector3( m_particles[0].Size, m_particles[0].Size, m_particles[0].Size );
-            m_boundingBox = vaBoundingBox( m_particles[0].Position - bsize * 0.5f, bsize );
+            if( lifeRemaining[i] < 0 )
+            {
+                aliveCount--;
+                if( i != aliveCount )
+                    m_particles.Move( i, aliveCount );
+            }
         }
+        m_particles.Resize( aliveCount );
+
+        m_boundingBox = vaBoundingBox::Degenerate;
 
-        for( int i = (int)m_particles.size( )-1; i >= 0; i-- )
+        if( aliveCount > 0 )
         {
-            vaSimpleParticle & particle = m_particles[i];
+            const int chunkCount = ( aliveCount + c_tickChunkSize - 1 ) / c_tickChunkSize;
+            std::vector< vaVector3 > chunkBounds( chunkCount * 2 );     // min, max
 
-            if( particle.LifeRemaining < 0 )
+            ParticlesParallelForRange( aliveCount, c_tickChunkSize, [&]( int beginIndex, int endIndex )
             {
-                if( (m_particles.size( )-1) == i )
+                const float * posX = m_particles.PositionX.data( );
+                const float * posY = m_particles.PositionY.data( );
+                const float * posZ = m_particles.PositionZ.data( );
+                const float * size = m_particles.Size.data( );
+
+                vaVector3 bmin( std::numeric_limits<float>::max( ), std::numeric_limits<float>::max( ), std::numeric_limits<float>::max( ) );
+                vaVector3 bmax = -bmin;
+
+                int i = beginIndex;
+#ifdef USE_SSE_PARTICLES
+                const __m128 half = _mm_set1_ps( 0.5f );
+                __m128 minX = _mm_set1_ps( bmin.x ), minY = minX, minZ = minX;
+                __m128 maxX = _mm_set1_ps( bmax.x ), maxY = maxX, maxZ = maxX;
+                for( ; i + 4 <= endIndex; i += 4 )
                 {
-                    m_particles.pop_back( );
-                    return;
+                    __m128 halfSize = _mm_mul_ps( _mm_loadu_ps( size + i ), half );
+                    __m128 px = _mm_loadu_ps( posX + i );
+                    __m128 py = _mm_loadu_ps( posY + i );
+                    __m128 pz = _mm_loadu_ps( posZ + i );
+                    minX = _mm_min_ps( minX, _mm_sub_ps( px, halfSize ) );
+                    minY = _mm_min_ps( minY, _mm_sub_ps( py, halfSize ) );
+                    minZ = _mm_min_ps( minZ, _mm_sub_ps( pz, halfSize ) );
+                    maxX = _mm_max_ps( maxX, _mm_add_ps( px, halfSize ) );
+                    maxY = _mm_max_ps( maxY, _mm_add_ps( py, halfSize ) );
+                    maxZ = _mm_max_ps( maxZ, _mm_add_ps( pz, halfSize ) );
                 }
-                else
+                bmin = vaVector3( HorizontalMinSSE( minX ), HorizontalMinSSE( minY ), HorizontalMinSSE( minZ ) );
+                bmax = vaVector3( HorizontalMaxSSE( maxX ), HorizontalMaxSSE( maxY ), HorizontalMaxSSE( maxZ ) );
+#endif
+                for( ; i < endIndex; i++ )
                 {
-                    m_particles[i] = m_particles.back( );
-                    m_particles.pop_back( );
-                    i--;
-                    continue;
+                    vaVector3 pos( posX[i], posY[i], posZ[i] );
+                    vaVector3 halfSize( size[i] * 0.5f, size[i] * 0.5f, size[i] * 0.5f );
+                    bmin = vaVector3::ComponentMin( bmin, pos - halfSize );
+                    bmax = vaVector3::ComponentMax( bmax, pos + halfSize );
                 }
-            }
 
-            vaVector3 bsize = vaVector3( m_particles[i].Size, m_particles[i].Size, m_particles[i].Size );
-            m_boundingBox = vaBoundingBox::Combine( m_boundingBox, vaBoundingBox( m_particles[i].Position - bsize * 0.5f, bsize ) );
+                const int chunk = beginIndex / c_tickChunkSize;
+                chunkBounds[chunk * 2 + 0] = bmin;
+                chunkBounds[chunk * 2 + 1] = bmax;
+            } );
+
+            vaVector3 bmin = chunkBounds[0];
+            vaVector3 bmax = chunkBounds[1];
+            for( int chunk = 1; chunk < chunkCount; chunk++ )
+            {
+                bmin = vaVector3::ComponentMin( bmin, chunkBounds[chunk * 2 + 0] );
+                bmax = vaVector3::ComponentMax( bmax, chunkBounds[chunk * 2 + 1] );
+            }
+            m_boundingBox = vaBoundingBox( bmin, bmax - bmin );
         }
     }
     
     m_lastTickEmitterCount  = (int)m_emitters.size();
-    m_lastTickParticleCount = (int)m_particles.size();
+    m_lastTickParticleCount = m_particles.Count();
 
     m_sortedAfterTick = false;
 }
@@ -656,14 +903,22 @@ vaDrawResultFlags vaSimpleParticleSystem::Draw( vaSceneDrawContext & drawContext
         m_vertexShader->CreateShaderAndILFromBuffer( shaderCode, "vs_5_0", "SimpleParticleVS", inputElements, m_staticShaderMacros, true );
     }
 
-    if( m_particles.size() == 0 )
+    if( m_particles.Count() == 0 )
         return vaDrawResultFlags::None;
 
     if( m_buffersLastUpdateTickID != GetLastTickID() )
     {
-        const std::vector<vaSimpleParticle> & particles = GetParticles( );
+        const vaSimpleParticleStore & particles = GetParticles( );
+        const std::vector< int > & sortedIndices = GetSortedIndices( );
+
+        m_buffersLastCountToDraw = particles.Count( );
 
-        m_buffersLastCountToDraw = (int)particles.size( );
+        if( (int)sortedIndices.size( ) != m_buffersLastCountToDraw )
+        {
+            // not sorted since last Tick? something is wrong
+            assert( false );
+            return vaDrawResultFlags::UnspecifiedError;
+        }
 
         if( m_buffersLastCountToDraw > m_dynamicBufferMaxElementCount )
         {
@@ -702,7 +957,10 @@ vaDrawResultFlags vaSimpleParticleSystem::Draw( vaSceneDrawContext & drawContext
 
         {
             VA_TRACE_CPU_SCOPE( DrawBufferUpdate );
-            delegate_drawBufferUpdateShader.Invoke( *this, particles, GetSortedIndices(), destinationBuffer, m_buffersLastCountToDraw * sizeof(vaBillboardSprite) );
+            ParticlesParallelForRange( m_buffersLastCountToDraw, c_drawBufferChunkSize, [&]( int beginIndex, int endIndex )
+            {
+                delegate_drawBufferUpdateShader( *this, particles, sortedIndices, beginIndex, endIndex, destinationBuffer );
+            } );
         }
 
         m_dynamicBuffer.Unmap( drawContext.RenderDeviceContext );
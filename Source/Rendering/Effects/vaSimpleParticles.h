@@ -64,6 +64,54 @@ namespace Vanilla
         uint32                  CreationID;
     };
 
+    // Structure-of-arrays storage for all particles of a vaSimpleParticleSystem: every attribute of vaSimpleParticle has its own
+    // tightly packed array (element i of each array belongs to particle i) so that the tick, sort and draw buffer update only pull
+    // in what they use and can process 4 particles at a time with SSE. Get/Set are there for convenient (but slow) per-particle access.
+    class vaSimpleParticleStore
+    {
+    public:
+        std::vector<float>      PositionX;
+        std::vector<float>      PositionY;
+        std::vector<float>      PositionZ;
+
+        std::vector<float>      VelocityX;
+        std::vector<float>      VelocityY;
+        std::vector<float>      VelocityZ;
+
+        std::vector<float>      Angle;
+        std::vector<float>      AngularVelocity;
+
+        std::vector<float>      AffectedByGravityK;
+        std::vector<float>      AffectedByWindK;
+
+        std::vector<vaVector4>  Color;                  // only read when filling the draw buffer so no need to split it further
+
+        std::vector<float>      LifeStart;
+        std::vector<float>      LifeRemaining;
+
+        std::vector<float>      Size;
+        std::vector<float>      SizeChange;
+
+        std::vector<uint32>     CreationID;
+
+    private:
+        int                     m_count         = 0;
+
+    public:
+        int                     Count( ) const                                      { return m_count; }
+
+        // new particles (when growing) are left uninitialized - whoever resizes is responsible for filling them in
+        void                    Resize( int count );
+        void                    Reserve( int count );
+        void                    Clear( )                                            { Resize( 0 ); }
+
+        // copy particle srcIndex over dstIndex (for ex. for swap-with-last removal)
+        void                    Move( int dstIndex, int srcIndex );
+
+        vaSimpleParticle        Get( int index ) const;
+        void                    Set( int index, const vaSimpleParticle & particle );
+    };
+
     struct vaSimpleParticleEmitter
     {
         enum SpawnAreaTypeEnum
@@ -177,12 +225,15 @@ namespace Vanilla
 
         float                       TimeAccumulatedSinceLastSpawn;
 
-        // TODO: change these to std::function
-        // These delegates are same as function pointers; if using, make absolutely sure you don't leave them dangling
-        // Warning: emitter shader is only allowed to push back new particles to allParticles, never remove or reorder them!
-        // vaSimpleParticleSystem & psys, const std::shared_ptr<vaSimpleParticleEmitter> & emitter, float deltaTime
-        vaEvent<void(vaSimpleParticleSystem &, vaSimpleParticleEmitter &, std::vector<vaSimpleParticle> &, float)>
-                                    delegate_emitterTickShader;
+        // Initializes newly spawned particles [beginIndex, endIndex) - they are already allocated in the store by the particle
+        // system, which also does the emitter time / count bookkeeping (see TickSpawnCount). firstParticleID is the CreationID
+        // for the particle at beginIndex; each following one gets the next ID.
+        // Warning: gets called concurrently for different (non-overlapping) ranges of the same emitter so it must not write to
+        // anything but its range of the store; use the provided random generator (seeded from the emitter and particle IDs so
+        // that the results don't depend on threading) for any randomness.
+        // const vaSimpleParticleSystem & psys, const vaSimpleParticleEmitter & emitter, vaSimpleParticleStore & allParticles, int beginIndex, int endIndex, uint32 firstParticleID, vaRandom & random
+        std::function<void( const vaSimpleParticleSystem &, const vaSimpleParticleEmitter &, vaSimpleParticleStore &, int, int, uint32, vaRandom & )>
+                                    delegate_emitterSpawnShader;
 
         // set at creation
         std::wstring                Name;
@@ -195,7 +246,6 @@ namespace Vanilla
 
     private:
         //bool                        AutoRemove;     // automatically remove from vaSimpleParticleSystem on lifetime end; set to false if you're manually enabling/disabling/restarting the emitter!
-        shared_ptr<int>             AliveToken      = std::make_shared<int>(42);
 
         friend vaSimpleParticleSystem;
                                     vaSimpleParticleEmitter( ) { Reset(); }
@@ -216,12 +266,14 @@ namespace Vanilla
 
             TimeAccumulatedSinceLastSpawn   = 0.0f;
 
-            delegate_emitterTickShader.AddWithToken( AliveToken, &vaSimpleParticleEmitter::DefaultEmitterTickShader );
+            delegate_emitterSpawnShader     = &vaSimpleParticleEmitter::DefaultEmitterSpawnShader;
         }
 
+        // advances emitter life & spawn accumulator and returns the number of particles to spawn this tick
+        int                         TickSpawnCount( float deltaTime );
 
         public:
-            static void             DefaultEmitterTickShader( vaSimpleParticleSystem & psys, vaSimpleParticleEmitter & emitter, std::vector<vaSimpleParticle> & allParticles, float deltaTime );
+            static void             DefaultEmitterSpawnShader( const vaSimpleParticleSystem & psys, const vaSimpleParticleEmitter & emitter, vaSimpleParticleStore & allParticles, int beginIndex, int endIndex, uint32 firstParticleID, vaRandom & random );
 
         
     };
@@ -257,13 +309,27 @@ namespace Vanilla
         //std::shared_ptr<vaTexture>                      m_texture;
         shared_ptr<vaRenderMaterial>                    m_material;
 
-        std::vector<vaSimpleParticle>                   m_particles;
+        vaSimpleParticleStore                           m_particles;
 //        uint32                                          m_lastParticleID;
         uint32                                          m_lastEmitterID;
 
-        // used for sorting by the default DefaultDrawBufferUpdateShader function. Obviously not thread safe.
+        // emitter spawn work for the current tick, split into fixed size ranges so it can be spread over threads
+        struct SpawnJob
+        {
+            vaSimpleParticleEmitter *                   Emitter;
+            int                                         BeginIndex;
+            int                                         EndIndex;
+            uint32                                      FirstParticleID;
+        };
+        std::vector< SpawnJob >                         m_spawnJobs;
+
+        // used by Sort (radix sort on quantized distance to camera). Obviously not thread safe.
         std::vector< float >                            m_particleSortValueCache;
+        std::vector< uint32 >                           m_particleSortKeys;
+        std::vector< uint32 >                           m_particleSortKeysScratch;
         std::vector< int >                              m_particleSortedIndices;
+        std::vector< int >                              m_particleSortedIndicesScratch;
+        std::vector< uint32 >                           m_particleSortHistograms;
 
         std::vector< std::shared_ptr<vaSimpleParticleEmitter> >
                                                         m_emitters;
@@ -281,8 +347,6 @@ namespace Vanilla
     protected:
         int                                             m_debugParticleDrawCountLimit;
 
-        shared_ptr<int>                                 m_aliveToken      = std::make_shared<int>(42);
-
     protected:
         //////////////////////////////////////////////////////////////////////////
         // rendering stuff
@@ -311,17 +375,16 @@ namespace Vanilla
         int                                     m_buffersLastOffsetInVertices       = 0;
         //////////////////////////////////////////////////////////////////////////
     public:
-        // TODO: change these to std::function
-        // These delegates are same as function pointers; if using, make absolutely sure you don't leave them dangling
-        // Warning: particle shader is NOT allowed to push back new particles to allParticles, remove them or reorder them!
-        // vaSimpleParticleSystem & psys, std::vector<vaSimpleParticle> & allParticles, float deltaTime
-        vaEvent<void( vaSimpleParticleSystem &, std::vector<vaSimpleParticle> &, float )>
+        // Gets called for [beginIndex, endIndex) ranges of the particle store, concurrently from multiple threads, so it must only
+        // touch particles in its range.
+        // Warning: particle shader is NOT allowed to add new particles, remove them or reorder them!
+        // const vaSimpleParticleSystem & psys, vaSimpleParticleStore & allParticles, int beginIndex, int endIndex, float deltaTime
+        std::function<void( const vaSimpleParticleSystem &, vaSimpleParticleStore &, int, int, float )>
                                                         delegate_particlesTickShader;
 
-        // TODO: change these to std::function
-        // These delegates are same as function pointers; if using, make absolutely sure you don't leave them dangling
-        // vaSimpleParticleSystem & psys, std::vector<vaSimpleParticle> & allParticles, const std::vector< int > & sortedIndices, void * outDestinationBuffer, size_t inDestinationBufferSize )
-        vaEvent<void( const vaSimpleParticleSystem &, const std::vector<vaSimpleParticle> &, const std::vector< int > & , void *, size_t )>
+        // Same threading rules as above: fills outDestinationBuffer[i] for i in [beginIndex, endIndex) from allParticles[sortedIndices[i]].
+        // const vaSimpleParticleSystem & psys, const vaSimpleParticleStore & allParticles, const std::vector< int > & sortedIndices, int beginIndex, int endIndex, vaBillboardSprite * outDestinationBuffer
+        std::function<void( const vaSimpleParticleSystem &, const vaSimpleParticleStore &, const std::vector< int > &, int, int, vaBillboardSprite * )>
                                                         delegate_drawBufferUpdateShader;
 
     public:
@@ -349,7 +412,7 @@ namespace Vanilla
 
         void                                        DrawDebugBoxes( );
 
-        const std::vector<vaSimpleParticle> &       GetParticles( ) const                                                   { return m_particles; }
+        const vaSimpleParticleStore &               GetParticles( ) const                                                   { return m_particles; }
         const std::vector< int > &                  GetSortedIndices( ) const                                               { assert( m_sortedAfterTick ); return m_particleSortedIndices; }
 
         const std::shared_ptr<vaRenderMaterial> &   GetMaterial( ) const                                                    { return m_material; }
@@ -365,8 +428,8 @@ namespace Vanilla
         bool                                        IsSortedAfterTick( )                                                    { return m_sortedAfterTick; }
 
     private:
-        void                                        DefaultParticlesTickShader( vaSimpleParticleSystem & psys, std::vector<vaSimpleParticle> & allParticles, float deltaTime );
-        void                                        DefaultDrawBufferUpdateShader( const vaSimpleParticleSystem & psys, const std::vector<vaSimpleParticle> & allParticles, const std::vector< int > & sortedIndices, void * outDestinationBuffer, size_t inDestinationBufferSize );
+        static void                                 DefaultParticlesTickShader( const vaSimpleParticleSystem & psys, vaSimpleParticleStore & allParticles, int beginIndex, int endIndex, float deltaTime );
+        static void                                 DefaultDrawBufferUpdateShader( const vaSimpleParticleSystem & psys, const vaSimpleParticleStore & allParticles, const std::vector< int > & sortedIndices, int beginIndex, int endIndex, vaBillboardSprite * outDestinationBuffer );
         // at the moment does nothing but release the shared_ptr; in the future will be used to pool disposed emitters, to reduce dynamic allocation; there's no other need to call ReleaseEmitterPtr, you can safely just let the reference go out of scope
         void                                        ReleaseEmitterPtr( std::shared_ptr<vaSimpleParticleEmitter> & ptr );
 
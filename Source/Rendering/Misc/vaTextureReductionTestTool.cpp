@@ -226,10 +226,11 @@ void vaTextureReductionTestTool::TickGPU( vaRenderDeviceContext & renderContext,
     // we've just started - init and loop
     if( m_currentTexture == -1 )
     {
-        m_currentTexture    = 0;
+        m_currentTexture    = SkipConclusiveTextures( 0 );
         m_currentCamera     = 0;
         m_cameraSlotSelectedIndex = 0;
-        m_texturesMaxFoundReduction[m_currentTexture] = vaMath::Clamp( m_maxLevelsToDrop, 0, m_textures[m_currentTexture].first->GetMipLevels( ) - 3 );
+        if( m_currentTexture < (int)m_textures.size( ) )
+            m_texturesMaxFoundReduction[m_currentTexture] = GetMaxTestedReduction( m_currentTexture );
         m_currentSearchReductionCount = 0;
         ResetTextureOverrides( );
         return;
@@ -255,7 +256,7 @@ void vaTextureReductionTestTool::TickGPU( vaRenderDeviceContext & renderContext,
         if( m_currentCamera == 0 )
         {
             // we've just started? start with max and work down
-            m_texturesMaxFoundReduction[m_currentTexture] = vaMath::Clamp( m_maxLevelsToDrop, 0, m_textures[m_currentTexture].first->GetMipLevels( ) - 3 );
+            m_texturesMaxFoundReduction[m_currentTexture] = GetMaxTestedReduction( m_currentTexture );
         }
         return;
     }
@@ -287,7 +288,11 @@ void vaTextureReductionTestTool::TickGPU( vaRenderDeviceContext & renderContext,
         
         if( !timeToEndThisCamera )
         {
-            m_currentSearchReductionCount++;
+            // levels up to the analytical safe reduction are never sampled from this camera, so there's no need to render & compare them
+            if( m_currentSearchReductionCount == 0 )
+                m_currentSearchReductionCount = GetAnalyticalSafeReduction( m_currentTexture ) + 1;
+            else
+                m_currentSearchReductionCount++;
 
             // set next reduction level (MIP)
             // assert( m_currentlyOverriddenTexture == nullptr );
@@ -316,7 +321,7 @@ void vaTextureReductionTestTool::TickGPU( vaRenderDeviceContext & renderContext,
         if( m_currentCamera == c_cameraSlotCount )
         {
             // next texture
-            m_currentTexture++;
+            m_currentTexture = SkipConclusiveTextures( m_currentTexture + 1 );
             if( m_currentTexture == (int)m_textures.size( ) )
             {
                 // finished all? exit
@@ -331,7 +336,7 @@ void vaTextureReductionTestTool::TickGPU( vaRenderDeviceContext & renderContext,
                 // run next
                 m_currentCamera = 0;
                 m_cameraSlotSelectedIndex = 0;
-                m_texturesMaxFoundReduction[m_currentTexture] = vaMath::Clamp( m_maxLevelsToDrop, 0, m_textures[m_currentTexture].first->GetMipLevels( ) - 3 );
+                m_texturesMaxFoundReduction[m_currentTexture] = GetMaxTestedReduction( m_currentTexture );
                 m_currentSearchReductionCount = 0;
                 ResetTextureOverrides( );
             }
@@ -369,6 +374,8 @@ void vaTextureReductionTestTool::ResetData( )
     for( size_t i = 0; i < m_textures.size( ); i++ )
         m_texturesSorted[i] = (int)i;
 
+    m_texelDensityEstimates.clear( );
+
     m_runningTests      = false;
     m_currentTexture    = -1;
     m_currentCamera     = -1;
@@ -415,6 +422,215 @@ void vaTextureReductionTestTool::ResetData( )
 //        [ this ]( int a, int b ) { return m_avgPSNR[b] > m_avgPSNR[a]; } );
 //}
 
+int vaTextureReductionTestTool::GetMaxTestedReduction( int textureIndex ) const
+{
+    return vaMath::Clamp( m_maxLevelsToDrop, 0, m_textures[textureIndex].first->GetMipLevels( ) - 3 );
+}
+
+int vaTextureReductionTestTool::GetAnalyticalSafeReduction( int textureIndex ) const
+{
+    if( m_texelDensityEstimates.size( ) != m_textures.size( ) )
+        return 0;
+    return m_texelDensityEstimates[textureIndex].SafeReduction;
+}
+
+int vaTextureReductionTestTool::SkipConclusiveTextures( int fromIndex )
+{
+    int i = fromIndex;
+    for( ; i < (int)m_textures.size( ); i++ )
+    {
+        int maxTested = GetMaxTestedReduction( i );
+        if( GetAnalyticalSafeReduction( i ) < maxTested )
+            break;
+        m_texturesMaxFoundReduction[i] = maxTested;
+    }
+    return i;
+}
+
+void vaTextureReductionTestTool::RunTexelDensityAnalysis( const vaRenderMeshDrawList & sceneMeshes, const vaCameraBase & referenceCamera )
+{
+    m_texelDensityAnalysisRequested = false;
+
+    assert( !m_runningTests );
+    if( m_runningTests )
+        return;
+
+    vaSimpleScopeTimerLog timer( "vaTextureReductionTestTool texel density analysis" );
+
+    // camera slots - these don't store viewport so take it from the reference camera
+    struct SlotCamera
+    {
+        vaVector3       Position;
+        vaPlane         FrustumPlanes[6];
+        float           NearPlane;
+        float           PixelSizeAtUnitDistance;        // world-space size of one pixel at distance of 1
+    };
+    vector<SlotCamera> cameras;
+    for( int i = 0; i < c_cameraSlotCount; i++ )
+    {
+        if( m_cameraSlots[i] == nullptr )
+            continue;
+        vaCameraBase camera( referenceCamera );
+        m_cameraSlots[i]->Seek( 0 );
+        if( !camera.Load( *m_cameraSlots[i] ) )
+        {
+            assert( false );
+            continue;
+        }
+        camera.Tick( 0.0f, false );
+
+        SlotCamera slot;
+        slot.Position                   = camera.GetPosition( );
+        camera.CalcFrustumPlanes( slot.FrustumPlanes );
+        slot.NearPlane                  = camera.GetNearPlaneDistance( );
+        slot.PixelSizeAtUnitDistance    = 2.0f * std::tan( camera.GetYFOV( ) * 0.5f ) / (float)vaMath::Max( 1, camera.GetViewportHeight( ) );
+        cameras.push_back( slot );
+    }
+    if( cameras.size( ) == 0 )
+    {
+        VA_LOG_WARNING( "vaTextureReductionTestTool - no camera slots captured, texel density analysis skipped" );
+        return;
+    }
+
+    unordered_map<const vaTexture *, int> textureIndices;
+    for( int i = 0; i < (int)m_textures.size( ); i++ )
+        textureIndices.insert( std::make_pair( m_textures[i].first.get( ), i ) );
+
+    // one work item per draw list entry and UV channel, holding all of our textures that the entry's material samples with it
+    struct WorkItem
+    {
+        int             DrawListIndex;
+        int             UVIndex;
+        vector<int>     TextureIndices;
+        float           MinUVPerPixel   = std::numeric_limits<float>::infinity( );     // result: smallest UV-space footprint of a pixel (in UV units) 
+        float           MinUVPerWorld   = std::numeric_limits<float>::infinity( );     // result: UV-to-world density range (for reporting)
+        float           MaxUVPerWorld   = 0.0f;
+    };
+    vector<WorkItem> workItems;
+
+    m_texelDensityEstimates.clear( );
+    m_texelDensityEstimates.resize( m_textures.size( ) );
+
+    for( int i = 0; i < sceneMeshes.Count( ); i++ )
+    {
+        const vaRenderMeshDrawList::Entry & entry = sceneMeshes[i];
+        if( entry.Mesh == nullptr || entry.Material == nullptr || entry.Mesh->GetTriangleMesh( ) == nullptr )
+            continue;
+        WorkItem perUV[2] = { { i, 0 }, { i, 1 } };
+        entry.Material->EnumerateTextureNodes( [&]( const vaRenderMaterial::TextureNode & node )
+        {
+            auto texture = node.GetTexture( );
+            if( texture == nullptr )
+                return;
+            auto it = textureIndices.find( texture.get( ) );
+            if( it == textureIndices.end( ) )
+                return;
+            m_texelDensityEstimates[it->second].Referenced = true;
+            vector<int> & list = perUV[ vaMath::Clamp( node.GetUVIndex( ), 0, 1 ) ].TextureIndices;
+            if( std::find( list.begin( ), list.end( ), it->second ) == list.end( ) )
+                list.push_back( it->second );
+        } );
+        for( int uv = 0; uv < 2; uv++ )
+            if( perUV[uv].TextureIndices.size( ) > 0 )
+                workItems.push_back( perUV[uv] );
+    }
+
+    vaThreading::ParallelFor( (int)workItems.size( ), 1, [&]( int begin, int end )
+    {
+        for( int w = begin; w < end; w++ )
+        {
+            WorkItem & item = workItems[w];
+            const vaRenderMeshDrawList::Entry & entry = sceneMeshes[item.DrawListIndex];
+            const auto & vertices   = entry.Mesh->GetTriangleMesh( )->Vertices( );
+            const auto & indices    = entry.Mesh->GetTriangleMesh( )->Indices( );
+            
+            for( size_t t = 0; t+2 < indices.size( ); t += 3 )
+            {
+                const vaRenderMesh::StandardVertex & v0 = vertices[indices[t+0]];
+                const vaRenderMesh::StandardVertex & v1 = vertices[indices[t+1]];
+                const vaRenderMesh::StandardVertex & v2 = vertices[indices[t+2]];
+
+                vaVector3 p0 = vaVector3::TransformCoord( v0.Position, entry.Transform );
+                vaVector3 p1 = vaVector3::TransformCoord( v1.Position, entry.Transform );
+                vaVector3 p2 = vaVector3::TransformCoord( v2.Position, entry.Transform );
+
+                const vaVector2 & uv0 = ( item.UVIndex == 0 ) ? ( v0.TexCoord0 ) : ( v0.TexCoord1 );
+                const vaVector2 & uv1 = ( item.UVIndex == 0 ) ? ( v1.TexCoord0 ) : ( v1.TexCoord1 );
+                const vaVector2 & uv2 = ( item.UVIndex == 0 ) ? ( v2.TexCoord0 ) : ( v2.TexCoord1 );
+
+                // both areas are doubled but that cancels out
+                float worldArea = vaVector3::Cross( p1 - p0, p2 - p0 ).Length( );
+                float uvArea    = std::abs( vaVector2::Cross( uv1 - uv0, uv2 - uv0 ) );
+                if( worldArea < VA_EPSf * VA_EPSf || uvArea <= 0.0f )
+                    continue;
+
+                // linear UV units per world unit
+                float uvPerWorld = std::sqrt( uvArea / worldArea );
+                item.MinUVPerWorld = vaMath::Min( item.MinUVPerWorld, uvPerWorld );
+                item.MaxUVPerWorld = vaMath::Max( item.MaxUVPerWorld, uvPerWorld );
+
+                vaVector3 center = ( p0 + p1 + p2 ) / 3.0f;
+                float radius = std::sqrt( vaMath::Max( ( p0 - center ).LengthSq( ), ( p1 - center ).LengthSq( ), ( p2 - center ).LengthSq( ) ) );
+
+                for( const SlotCamera & camera : cameras )
+                {
+                    bool outside = false;
+                    for( int p = 0; p < 6 && !outside; p++ )
+                        outside = vaPlane::DotCoord( camera.FrustumPlanes[p], center ) < -radius;
+                    if( outside )
+                        continue;
+
+                    // nearest possible point and facing the camera - gives the smallest possible footprint
+                    float distance = vaMath::Max( ( center - camera.Position ).Length( ) - radius, camera.NearPlane );
+                    item.MinUVPerPixel = vaMath::Min( item.MinUVPerPixel, uvPerWorld * distance * camera.PixelSizeAtUnitDistance );
+                }
+            }
+        }
+    } );
+
+    // per-material density report & per-texture reduction
+    unordered_map<vaRenderMaterial *, pair<float, float>> materialDensities;
+    for( const WorkItem & item : workItems )
+    {
+        const vaRenderMeshDrawList::Entry & entry = sceneMeshes[item.DrawListIndex];
+        auto it = materialDensities.insert( std::make_pair( entry.Material.get( ), std::make_pair( item.MinUVPerWorld, item.MaxUVPerWorld ) ) ).first;
+        it->second.first    = vaMath::Min( it->second.first, item.MinUVPerWorld );
+        it->second.second   = vaMath::Max( it->second.second, item.MaxUVPerWorld );
+
+        for( int textureIndex : item.TextureIndices )
+        {
+            const shared_ptr<vaTexture> & texture = m_textures[textureIndex].first;
+            float texelsPerUV = std::sqrt( (float)texture->GetSizeX( ) * (float)texture->GetSizeY( ) );
+            m_texelDensityEstimates[textureIndex].MinTexelsPerPixel = vaMath::Min( m_texelDensityEstimates[textureIndex].MinTexelsPerPixel, item.MinUVPerPixel * texelsPerUV );
+        }
+    }
+    for( const auto & md : materialDensities )
+    {
+        const char * name = ( md.first->GetParentAsset( ) != nullptr ) ? ( md.first->GetParentAsset( )->Name( ).c_str( ) ) : ( "<no asset>" );
+        VA_LOG( "  material '%s' - UV density from %.4f to %.4f UV units per world unit", name, md.second.first, md.second.second );
+    }
+
+    int conclusiveCount = 0;
+    for( int i = 0; i < (int)m_textures.size( ); i++ )
+    {
+        TexelDensityEstimate & estimate = m_texelDensityEstimates[i];
+        int maxLevels = m_textures[i].first->GetMipLevels( ) - 1;
+        if( estimate.MinTexelsPerPixel == std::numeric_limits<float>::infinity( ) )
+            estimate.SafeReduction = maxLevels;  // not referenced or never in view
+        else
+        {
+            // trilinear filtering samples MIP floor(lod) and the one below it, so all levels above floor(lod) are unused
+            float lod = std::log2( vaMath::Max( estimate.MinTexelsPerPixel, VA_EPSf ) ) - m_texelDensitySafetyMargin;
+            estimate.SafeReduction = vaMath::Clamp( (int)std::floor( lod ), 0, maxLevels );
+        }
+        m_texturesMaxFoundReduction[i] = vaMath::Min( estimate.SafeReduction, GetMaxTestedReduction( i ) );
+        if( estimate.SafeReduction >= GetMaxTestedReduction( i ) )
+            conclusiveCount++;
+    }
+    VA_LOG( "vaTextureReductionTestTool - analyzed %d textures against %d camera slots; %d conclusive, %d left for render & compare verification", 
+        (int)m_textures.size( ), (int)cameras.size( ), conclusiveCount, (int)m_textures.size( ) - conclusiveCount );
+}
+
 void vaTextureReductionTestTool::ResetCamera( const shared_ptr<vaRenderCamera> & camera )
 {
     if( m_userCameraBackup != nullptr )
@@ -540,7 +756,7 @@ void vaTextureReductionTestTool::TickUI( vaRenderDevice & device, const shared_p
         {
             //float availableWidth = ImGui::GetContentRegionAvailWidth( ) - ImGui::GetStyle().ScrollbarSize;
 
-            int columnCount = 2;
+            int columnCount = 3;
 
             ImGui::Columns( columnCount, "TextureListColumns", true );
 
@@ -554,6 +770,7 @@ void vaTextureReductionTestTool::TickUI( vaRenderDevice & device, const shared_p
             ImGui::Separator( );
             ImGui::Text( "Texture name" );  ImGui::NextColumn();
             ImGui::Text( "Levels to drop and still stay over threshold" );      ImGui::NextColumn();
+            ImGui::Text( "Analytical safe levels (min texels per pixel)" );     ImGui::NextColumn();
             ImGui::Separator();
 
             for( size_t i = 0; i < m_textures.size(); i++ )
@@ -584,6 +801,16 @@ void vaTextureReductionTestTool::TickUI( vaRenderDevice & device, const shared_p
             {
                 ImGui::Text( "%d", m_texturesMaxFoundReduction[orderVector[i]] );
             }
+            ImGui::NextColumn();
+            for( size_t i = 0; i < m_textures.size( ); i++ )
+            {
+                if( m_texelDensityEstimates.size( ) != m_textures.size( ) )
+                    ImGui::Text( "-" );
+                else if( !m_texelDensityEstimates[orderVector[i]].Referenced )
+                    ImGui::Text( "%d (not referenced)", m_texelDensityEstimates[orderVector[i]].SafeReduction );
+                else
+                    ImGui::Text( "%d (%.2f)", m_texelDensityEstimates[orderVector[i]].SafeReduction, m_texelDensityEstimates[orderVector[i]].MinTexelsPerPixel );
+            }
         }
         ImGui::EndChild( );
 
@@ -603,6 +830,17 @@ void vaTextureReductionTestTool::TickUI( vaRenderDevice & device, const shared_p
                 m_targetPSNRThreshold = vaMath::Clamp( m_targetPSNRThreshold, 10.0f, 90.0f );
                 ImGui::InputInt( "Max levels to drop", &m_maxLevelsToDrop, 1 );
                 m_maxLevelsToDrop = vaMath::Clamp( m_maxLevelsToDrop, 1, 15 );
+                ImGui::InputFloat( "Analytical safety margin (MIP levels)", &m_texelDensitySafetyMargin, 0.25f );
+                m_texelDensitySafetyMargin = vaMath::Clamp( m_texelDensitySafetyMargin, 0.0f, 4.0f );
+
+                if( ImGui::Button( "Run texel density analysis (no rendering)" ) )
+                {
+                    m_texelDensityAnalysisRequested = true;
+                    m_downscaleTextureButtonClicks = 2;
+                }
+                if( ImGui::IsItemHovered( ) )
+                    ImGui::SetTooltip( "Estimates texel-to-pixel density of all scene meshes against the captured camera slots; 'Run tests' will then\nonly render & compare textures that the analysis could not rule out and skip levels known to be unused" );
+                ImGui::SameLine( );
 
                 vaVector4 col = vaVector4( 0.0f, 0.0f, 0.4f, 1.0f );
                 ImGui::PushStyleColor( ImGuiCol_Button, ImFromVA( col ) );
@@ -45,6 +45,14 @@ namespace Vanilla
 
         //struct Camera
 
+        // Output of the analytical (no rendering) texel density pre-pass, one per texture
+        struct TexelDensityEstimate
+        {
+            float                           MinTexelsPerPixel               = std::numeric_limits<float>::infinity();   // smallest MIP 0 texel-to-pixel ratio seen from any camera slot; infinity if never in view
+            int                             SafeReduction                   = 0;                                        // number of top MIP levels never sampled from any of the camera slots
+            bool                            Referenced                      = false;                                    // used by a material of at least one of the analyzed meshes
+        };
+
     protected:
         vector<TestItemType>                m_textures;
         vector<shared_ptr<vaAssetTexture>>  m_textureAssets;
@@ -85,6 +93,12 @@ namespace Vanilla
 
         bool                                m_overrideAll                   = false;
 
+        // analytical pre-pass results; empty if not run (or invalidated by ResetData) - when available, TickGPU only renders & 
+        // compares textures for which the estimate is not conclusive, and starts the search above the safe reduction level
+        vector<TexelDensityEstimate>        m_texelDensityEstimates;
+        float                               m_texelDensitySafetyMargin      = 0.5f;         // in MIP levels; covers the UV area approximation (non-square textures, anisotropic UV mapping)
+        bool                                m_texelDensityAnalysisRequested = false;
+
         static bool                         s_supportedByApp;
 
     public:
@@ -110,9 +124,22 @@ namespace Vanilla
 
         void                        DownscaleAll( vaRenderDeviceContext & renderContext );
 
+        // The app should call RunTexelDensityAnalysis (from the main thread, after the scene tick) when this is set by the UI
+        bool                        IsTexelDensityAnalysisRequested( ) const    { return m_texelDensityAnalysisRequested; }
+
+        // Walks triangles, UVs and world transforms of all sceneMeshes and, for each material texture, computes the finest texel-to-pixel 
+        // ratio seen from any captured camera slot (no occlusion, surfaces assumed to face the camera - so conservative). Slots do not 
+        // store the viewport so it is taken from referenceCamera. 
+        void                        RunTexelDensityAnalysis( const vaRenderMeshDrawList & sceneMeshes, const vaCameraBase & referenceCamera );
+
     private:
         void                        SaveAsReference( vaRenderDeviceContext & renderContext, const shared_ptr<vaTexture> & colorBuffer );
 
+        int                         GetMaxTestedReduction( int textureIndex ) const;
+        int                         GetAnalyticalSafeReduction( int textureIndex ) const;
+        // returns the first texture index, starting from fromIndex, that needs the render-and-compare verification; all skipped ones get their final result
+        int                         SkipConclusiveTextures( int fromIndex );
+
         void                        ResetData( );
         void                        ResetTextureOverrides( );
         //void                        ComputeAveragesAndSort( );
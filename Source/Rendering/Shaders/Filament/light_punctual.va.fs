@@ -152,9 +152,9 @@ LightParams setupPunctualLight( const RenderMaterialInterpolants vertex, const S
  * The light parameters used to compute the Light structure are fetched from the
  * lightsUniforms uniform buffer.
  */
-LightParams getSpotLight( const RenderMaterialInterpolants vertex, const ShadingParams shading, const uint lightIndex )//uint index ) 
+LightParams getSpotLight( const RenderMaterialInterpolants vertex, const ShadingParams shading, const LightClusterRange lightRange, const uint i )//uint index ) 
 {
-    const ShaderLightSpot lightIn = g_Lighting.LightsSpotAndPoint[lightIndex];
+    const ShaderLightSpot lightIn = LoadSpotAndPointLight( lightRange, i );
 
     LightParams light = setupPunctualLight( vertex, shading, lightIn );
 
@@ -222,10 +222,11 @@ void evaluatePunctualLights( const RenderMaterialInterpolants vertex, const Shad
     // Iterate point lights
     // for ( ; index < end; index++) 
     // {
-    for( uint i = 0; i < g_Lighting.LightCountSpotAndPoint; i++ )
+    LightClusterRange lightRange = GetLightClusterRange( vertex.WorldspacePos.xyz );
+    for( uint i = 0; i < lightRange.Count; i++ )
     {
         // Light light = getPointLight(index);
-        LightParams light = getSpotLight( vertex, shading, i );
+        LightParams light = getSpotLight( vertex, shading, lightRange, i );
 
         // this is only a property of punctual lights: add it directly to diffuse here!
         SpecialEmissiveLight( shading, light, diffuseColor );
@@ -37,6 +37,10 @@ TextureCube         g_DistantIBLIrradianceMap   : register( T_CONCATENATER( LIGH
 
 Texture2D           g_AOMap                     : register( T_CONCATENATER( SHADERGLOBAL_AOMAP_TEXTURESLOT_V ) );
 
+Texture2D<float4>   g_LightClusterLights        : register( T_CONCATENATER( LIGHTINGGLOBAL_CLUSTER_LIGHTS_TEXTURESLOT_V ) );
+Texture2D<uint2>    g_LightClusterGrid          : register( T_CONCATENATER( LIGHTINGGLOBAL_CLUSTER_GRID_TEXTURESLOT_V ) );
+Texture2D<uint>     g_LightClusterIndices       : register( T_CONCATENATER( LIGHTINGGLOBAL_CLUSTER_INDICES_TEXTURESLOT_V ) );
+
 cbuffer LightingConstantsBuffer                 : register( B_CONCATENATER( LIGHTINGGLOBAL_CONSTANTSBUFFERSLOT_V ) )
 {
     LightingShaderConstants     g_Lighting;
@@ -100,6 +104,76 @@ float SampleAO( float2 svpos )
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Point & spot lights (clustered or not)
+//
+
+// Point/spot lights that can affect a position; use with LoadSpotAndPointLight( range, i ) for i in [0, range.Count)
+struct LightClusterRange
+{
+    uint    Offset;
+    uint    Count;
+};
+
+// worldspacePos is relative to g_Global.GlobalWorldBase (same as interpolants.WorldspacePos)
+LightClusterRange GetLightClusterRange( const float3 worldspacePos )
+{
+    LightClusterRange ret;
+    [branch]
+    if( g_Lighting.LightClustersEnabled )
+    {
+        // same mapping as vaLightClusters::GridParams
+        float3 viewspacePos = mul( (float3x3)g_Global.View, worldspacePos - g_Global.CameraWorldPosition.xyz );
+        float viewZ         = max( viewspacePos.z, 1e-6 );
+        float2 tile         = viewspacePos.xy / viewZ * g_Lighting.LightClusterTileScale + g_Lighting.LightClusterTileBias;
+        float slice         = log2( viewZ ) * g_Lighting.LightClusterDepthScale + g_Lighting.LightClusterDepthBias;
+        uint2 tileXY        = (uint2)clamp( floor( tile ), 0, float2( g_Lighting.LightClusterCountX, g_Lighting.LightClusterCountY ) - 1 );
+        uint sliceZ         = (uint)clamp( floor( slice ), 0, (float)g_Lighting.LightClusterCountZ - 1 );
+        uint2 offsetCount   = g_LightClusterGrid.Load( int3( tileXY.x + tileXY.y * g_Lighting.LightClusterCountX, sliceZ, 0 ) );
+        ret.Offset          = offsetCount.x;
+        ret.Count           = offsetCount.y;
+    }
+    else
+    {
+        ret.Offset          = 0;
+        ret.Count           = g_Lighting.LightCountSpotAndPoint;
+    }
+    return ret;
+}
+
+ShaderLightSpot LoadSpotAndPointLight( const LightClusterRange range, const uint i )
+{
+    [branch]
+    if( g_Lighting.LightClustersEnabled )
+    {
+        uint index          = range.Offset + i;
+        uint lightIndex     = g_LightClusterIndices.Load( int3( index % LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH, index / LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH, 0 ) );
+        float4 data0        = g_LightClusterLights.Load( int3( 0, lightIndex, 0 ) );
+        float4 data1        = g_LightClusterLights.Load( int3( 1, lightIndex, 0 ) );
+        float4 data2        = g_LightClusterLights.Load( int3( 2, lightIndex, 0 ) );
+        float4 data3        = g_LightClusterLights.Load( int3( 3, lightIndex, 0 ) );
+
+        ShaderLightSpot light;
+        light.Color             = data0.xyz;
+        light.Intensity         = data0.w;
+        light.Position          = data1.xyz;
+        light.Range             = data1.w;
+        light.Direction         = data2.xyz;
+        light.Size              = data2.w;
+        light.SpotInnerAngle    = data3.x;
+        light.SpotOuterAngle    = data3.y;
+        light.CubeShadowIndex   = data3.z;
+        light.Dummy1            = data3.w;
+        return light;
+    }
+    else
+        return g_Lighting.LightsSpotAndPoint[range.Offset + i];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // IBL
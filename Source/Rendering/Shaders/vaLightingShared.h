@@ -35,6 +35,9 @@
 
 #define IBL_IRRADIANCE_SOURCE                       IBL_IRRADIANCE_CUBEMAP
 
+// clustered lights index list texture is 2D (R32_UINT) with this width; index i is at ( i % width, i / width )
+#define LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH         4096
+
 
 #ifndef VA_COMPILED_AS_SHADER_CODE
 namespace Vanilla
@@ -64,7 +67,7 @@ struct ShaderLightDirectional
 //};
 struct ShaderLightSpot
 {
-    static const int    MaxLights                       = 32;
+    static const int    MaxLights                       = 32;           // only for the constant buffer array - there's no limit with clustered lighting (see LightingShaderConstants::LightClustersEnabled)
 
     vaVector3           Color;							// stored as linear, tools should show srgb though
     float               Intensity;                      // premultiplied by exposure
@@ -132,6 +135,21 @@ struct LightingShaderConstants
     int                     AOMapEnabled;
     int                     Padding0;
 
+    // Clustered point/spot lights (see vaLightClusters); if LightClustersEnabled is 0, all LightCountSpotAndPoint lights from
+    // LightsSpotAndPoint apply everywhere. Cluster mapping from view space: tile = pos.xy / pos.z * TileScale + TileBias, slice = log2( pos.z ) * DepthScale + DepthBias
+    uint                    LightClustersEnabled;
+    uint                    LightClusterCountX;
+    uint                    LightClusterCountY;
+    uint                    LightClusterCountZ;
+
+    vaVector2               LightClusterTileScale;
+    vaVector2               LightClusterTileBias;
+
+    float                   LightClusterDepthScale;
+    float                   LightClusterDepthBias;
+    uint                    LightClusterLightCount;             // total number of lights in the cluster lights texture
+    uint                    LightClusterPadding0;
+
 
     ShaderLightDirectional  LightsDirectional[ShaderLightDirectional::MaxLights];
     //ShaderLightPoint        LightsPoint[ShaderLightPoint::MaxLights];
@@ -280,10 +280,11 @@ void BasicMaterialAccumulateLights( float3 worldspacePos, SurfaceValues material
     }
 
     // point & spot lights combined
+    LightClusterRange lightRange = GetLightClusterRange( worldspacePos );
     [loop]
-    for( i = 0; i < g_Lighting.LightCountSpotAndPoint; i++ )
+    for( i = 0; i < lightRange.Count; i++ )
     {
-        ShaderLightSpot light = g_Lighting.LightsSpotAndPoint[i];
+        ShaderLightSpot light = LoadSpotAndPointLight( lightRange, i );
 
         float3 pixelToLight = light.Position - worldspacePos;
         float pixelToLightLength = length( pixelToLight );
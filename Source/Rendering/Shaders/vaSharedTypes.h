@@ -106,6 +106,9 @@ namespace Vanilla
 #define LIGHTINGGLOBAL_DISTANTIBL_REFROUGHMAP_TEXTURESLOT   (SHADERGLOBAL_SRV_SLOT_BASE + 6)        // <- this is 'modern' reflection map
 #define LIGHTINGGLOBAL_DISTANTIBL_IRRADIANCEMAP_TEXTURESLOT (SHADERGLOBAL_SRV_SLOT_BASE + 7)        // <- this is 'modern' irradiance map (using either this or SH)
 #define SHADERGLOBAL_AOMAP_TEXTURESLOT                      (SHADERGLOBAL_SRV_SLOT_BASE + 8)        // <- this is the SSAO (for now)
+#define LIGHTINGGLOBAL_CLUSTER_LIGHTS_TEXTURESLOT           (SHADERGLOBAL_SRV_SLOT_BASE + 9)        // <- clustered point/spot lights: ShaderLightSpot data, one per row (see vaLightClusters)
+#define LIGHTINGGLOBAL_CLUSTER_GRID_TEXTURESLOT             (SHADERGLOBAL_SRV_SLOT_BASE + 10)       // <- clustered point/spot lights: per-cluster (offset, count)
+#define LIGHTINGGLOBAL_CLUSTER_INDICES_TEXTURESLOT          (SHADERGLOBAL_SRV_SLOT_BASE + 11)       // <- clustered point/spot lights: light index lists
 
 // this is so annoying but I don't know how to resolve it - in order to be used in 'T_CONCATENATER', it has to be a number string token or something like that so "(base+n)" doesn't work
 #define SHADERGLOBAL_MATERIAL_DFG_LOOKUPTABLE_V                 32
@@ -116,6 +119,9 @@ namespace Vanilla
 #define LIGHTINGGLOBAL_DISTANTIBL_REFROUGHMAP_TEXTURESLOT_V     38
 #define LIGHTINGGLOBAL_DISTANTIBL_IRRADIANCEMAP_TEXTURESLOT_V   39
 #define SHADERGLOBAL_AOMAP_TEXTURESLOT_V                        40
+#define LIGHTINGGLOBAL_CLUSTER_LIGHTS_TEXTURESLOT_V             41
+#define LIGHTINGGLOBAL_CLUSTER_GRID_TEXTURESLOT_V               42
+#define LIGHTINGGLOBAL_CLUSTER_INDICES_TEXTURESLOT_V            43
 #if (   SHADERGLOBAL_MATERIAL_DFG_LOOKUPTABLE               != SHADERGLOBAL_MATERIAL_DFG_LOOKUPTABLE_V                  \
     ||  SHADERGLOBAL_LIGHTING_CUBE_SHADOW_TEXTURESLOT       != SHADERGLOBAL_LIGHTING_CUBE_SHADOW_TEXTURESLOT_V          \
     ||  LIGHTINGGLOBAL_LOCALIBL_REFROUGHMAP_TEXTURESLOT     != LIGHTINGGLOBAL_LOCALIBL_REFROUGHMAP_TEXTURESLOT_V        \
@@ -123,6 +129,9 @@ namespace Vanilla
     ||  LIGHTINGGLOBAL_DISTANTIBL_REFROUGHMAP_TEXTURESLOT   != LIGHTINGGLOBAL_DISTANTIBL_REFROUGHMAP_TEXTURESLOT_V      \
     ||  LIGHTINGGLOBAL_DISTANTIBL_IRRADIANCEMAP_TEXTURESLOT != LIGHTINGGLOBAL_DISTANTIBL_IRRADIANCEMAP_TEXTURESLOT_V    \
     ||  SHADERGLOBAL_AOMAP_TEXTURESLOT                      != SHADERGLOBAL_AOMAP_TEXTURESLOT_V    \
+    ||  LIGHTINGGLOBAL_CLUSTER_LIGHTS_TEXTURESLOT           != LIGHTINGGLOBAL_CLUSTER_LIGHTS_TEXTURESLOT_V              \
+    ||  LIGHTINGGLOBAL_CLUSTER_GRID_TEXTURESLOT             != LIGHTINGGLOBAL_CLUSTER_GRID_TEXTURESLOT_V                \
+    ||  LIGHTINGGLOBAL_CLUSTER_INDICES_TEXTURESLOT          != LIGHTINGGLOBAL_CLUSTER_INDICES_TEXTURESLOT_V             \
         )
     #error _V values above not in sync, just fix them up please
 #endif
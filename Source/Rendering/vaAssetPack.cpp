@@ -33,6 +33,7 @@
 #include "IntegratedExternals/vaImguiIntegration.h"
 
 #include "Rendering/vaTextureHelpers.h"
+#include "Rendering/vaTextureProcessing.h"
 
 using namespace Vanilla;
 
@@ -59,6 +60,10 @@ vaAssetPack::~vaAssetPack( )
 {
     assert( vaThreading::IsMainThread() );
 
+    for( const auto & task : m_importTasks )
+        vaBackgroundTaskManager::GetInstance( ).WaitUntilFinished( task );
+    m_importTasks.clear( );
+
     WaitUntilIOTaskFinished( );
     RemoveAll( true );
 }
@@ -298,6 +303,7 @@ void vaAssetPack::RemoveAll( bool lockMutex )
 
     assert( m_ioTask == nullptr || vaBackgroundTaskManager::GetInstance().IsFinished(m_ioTask) );
     m_storageMode = vaAssetPack::StorageMode::Unknown;
+    m_apackStoragePath.clear( );
 
     // untrack the asset resources so no one can find them anymore using vaUIDObjectRegistrar
     for( int i = 0; i < m_assetList.size( ); i++ )
@@ -344,11 +350,63 @@ void vaAssetPack::WaitUntilIOTaskFinished( bool breakIfSafe )
     }
 }
 
+bool vaAssetPack::RestoreStreamedTextures( )
+{
+    m_assetStorageMutex.assert_locked_by_caller();
+
+    for( const auto & asset : m_assetList )
+    {
+        if( asset->Type != vaAssetType::Texture )
+            continue;
+        vaAssetTexture & assetTexture = static_cast<vaAssetTexture &>( *asset );
+        shared_ptr<vaTexture> texture = assetTexture.GetTexture( );
+        if( texture == nullptr || texture->GetAPACKDroppedMips( ) == 0 )
+            continue;
+
+        if( m_apackStoragePath.empty( ) || texture->GetAPACKDataOffset( ) < 0 )
+        {
+            VA_LOG_ERROR( "vaAssetPack - texture '%s' has streamed-out MIPs that can no longer be re-read; refusing to save", asset->Name( ).c_str( ) );
+            return false;
+        }
+
+        vector<uint8> data( (size_t)texture->GetAPACKDataSize( ) );
+        vaFileStream file;
+        bool readOk = file.Open( m_apackStoragePath, FileCreationMode::Open, FileAccessMode::Read, FileShareMode::Read );
+        if( readOk )
+        {
+            file.Seek( texture->GetAPACKDataOffset( ) );
+            readOk = file.Read( data.data( ), data.size( ) );
+        }
+        if( !readOk )
+        {
+            VA_LOG_ERROR( L"vaAssetPack - unable to re-read full MIP chain of a streamed texture from '%s'; refusing to save", m_apackStoragePath.c_str( ) );
+            return false;
+        }
+        file.Close( );
+
+        shared_ptr<vaTexture> fullTexture = vaTexture::CreateFromImageBuffer( GetRenderDevice( ), data.data( ), data.size( ), vaTextureLoadFlags::Default, texture->GetBindSupportFlags( ), texture->GetContentsType( ) );
+        if( fullTexture == nullptr )
+        {
+            VA_LOG_ERROR( "vaAssetPack - unable to recreate full MIP chain of texture '%s'; refusing to save", asset->Name( ).c_str( ) );
+            return false;
+        }
+        fullTexture->SetAPACKDataLocation( texture->GetAPACKDataOffset( ), texture->GetAPACKDataSize( ) );
+        assetTexture.ReplaceTexture( fullTexture );
+    }
+    return true;
+}
+
 bool vaAssetPack::SaveAPACK( const wstring & fileName, bool lockMutex )
 {
     WaitUntilIOTaskFinished( );
 
     std::unique_lock<mutex> apackStorageLock(m_apackStorageMutex);
+    std::unique_lock<mutex> assetStorageMutexLock(m_assetStorageMutex, std::defer_lock );    if( lockMutex ) assetStorageMutexLock.lock(); else m_assetStorageMutex.assert_locked_by_caller();
+
+    // has to happen before the file gets (re)created as it might be the one the data is re-read from
+    if( !RestoreStreamedTextures( ) )
+        return false;
+
     if( !m_apackStorage.Open( fileName, FileCreationMode::Create ) )
     {
         VA_LOG_ERROR( L"vaAssetPack::SaveAPACK(%s) - unable to create file for saving", fileName.c_str() );
@@ -357,8 +415,6 @@ bool vaAssetPack::SaveAPACK( const wstring & fileName, bool lockMutex )
 
     vaStream & outStream = m_apackStorage;
 
-    std::unique_lock<mutex> assetStorageMutexLock(m_assetStorageMutex, std::defer_lock );    if( lockMutex ) assetStorageMutexLock.lock(); else m_assetStorageMutex.assert_locked_by_caller();
-
     VERIFY_TRUE_RETURN_ON_FALSE( outStream.CanSeek( ) );
 
     int64 posOfSize = outStream.GetPosition( );
@@ -415,6 +471,7 @@ bool vaAssetPack::SaveAPACK( const wstring & fileName, bool lockMutex )
 
     m_apackStorage.Close();
     m_storageMode = StorageMode::APACK;
+    m_apackStoragePath.clear( );    // loaded textures' data locations refer to the previous contents
 
     return true;
 }
@@ -524,6 +581,9 @@ bool vaAssetPack::LoadAPACK( const wstring & fileName, bool async, bool lockMute
         VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<bool>( useWholeFileCompression ) );
     }
 
+    // texture data can only be re-read later (for streaming) if it's stored uncompressed
+    m_apackStoragePath = ( useWholeFileCompression ) ? ( L"" ) : ( fileName );
+
     // ok let the loading thread grab the locks again before continuing with file access 
     // if( lockMutex )
     //     assetStorageMutexLock.unlock();
@@ -579,6 +639,9 @@ bool vaAssetPack::SaveUnpacked( const wstring & folderRoot, bool lockMutex )
 
     std::unique_lock<mutex> assetStorageMutexLock(m_assetStorageMutex, std::defer_lock );    if( lockMutex ) assetStorageMutexLock.lock(); else m_assetStorageMutex.assert_locked_by_caller();
 
+    if( !RestoreStreamedTextures( ) )
+        return false;
+
     if( vaFileTools::DirectoryExists(folderRoot) && !vaFileTools::DeleteDirectory( folderRoot ) )
     {
         VA_LOG_ERROR( L"vaAssetPack::SaveUnpacked - Unable to delete current contents of the folder '%s'", folderRoot.c_str( ) );
@@ -664,6 +727,7 @@ bool vaAssetPack::SaveUnpacked( const wstring & folderRoot, bool lockMutex )
     headerFile.Close();
 
     m_storageMode = StorageMode::Unpacked;
+    m_apackStoragePath.clear( );
 
     return !hadError;
 }
@@ -683,7 +747,6 @@ bool vaAssetPack::LoadUnpacked( const wstring & folderRoot, bool lockMutex )
 
     vaXMLSerializer serializer( headerFile );
     GetRenderDevice( ).GetMaterialManager( ).RegisterSerializationTypeConstructors( serializer );
-    headerFile.Close();
 
     bool oldFormat = serializer.SerializeOpenChildElement( "VertexAsylumAssetPack" );
 
@@ -742,7 +805,6 @@ bool vaAssetPack::LoadUnpacked( const wstring & folderRoot, bool lockMutex )
             }
             vaXMLSerializer assetSerializer( assetHeaderFile );
             GetRenderDevice().GetMaterialManager().RegisterSerializationTypeConstructors( assetSerializer ); 
-            assetHeaderFile.Close();
 
             string suitableName = FindSuitableAssetName( assetName, false );
             if( suitableName != assetName )
@@ -800,6 +862,7 @@ bool vaAssetPack::LoadUnpacked( const wstring & folderRoot, bool lockMutex )
     if( !hadError )
     {
         m_storageMode = StorageMode::Unpacked;
+        m_apackStoragePath.clear( );
         return true;
     }
     else
@@ -1034,7 +1097,7 @@ void vaAsset::UIPropertiesItemTick( vaApplicationBase & application )
 
 
 #pragma warning ( suppress: 4505 ) // unreferenced local function has been removed
-void vaAssetPack::SingleTextureImport( string _filePath, string assetName, vaTextureLoadFlags textureLoadFlags, vaTextureContentsType textureContentsType, bool generateMIPs, shared_ptr<string> & importedInfo )
+void vaAssetPack::SingleTextureImport( string _filePath, string assetName, vaTextureLoadFlags textureLoadFlags, vaTextureContentsType textureContentsType, bool generateMIPs, bool compress, shared_ptr<string> & importedInfo )
 {
     wstring filePath = vaStringTools::SimpleWiden( _filePath );
 
@@ -1051,97 +1114,72 @@ void vaAssetPack::SingleTextureImport( string _filePath, string assetName, vaTex
     importedInfo = std::make_shared<string>("");
     std::weak_ptr<string> importedInfoWeak = importedInfo;
     std::weak_ptr<vaAssetPack> assetPackWeak = GetSharedPtr();
-    
-    shared_ptr<vaAssetTexture> textureAssetOut;
 
     VA_LOG( L"Importing texture asset from '%s'.", filePath.c_str( ) );
 
-    GetRenderDevice().AsyncInvokeAtBeginFrame( [importedInfoWeak, assetPackWeak, filePath, assetName, textureLoadFlags, textureContentsType, generateMIPs] ( vaRenderDevice & renderDevice, float )
-    {
-        auto importedInfo   = importedInfoWeak.lock();
-        auto assetPack      = assetPackWeak.lock();
-        if( importedInfo == nullptr || assetPack == nullptr )
-        {
-            assert( false ); // shouldn't happen
-            return false;
-        }
-        string filePathA = vaStringTools::SimpleNarrow( filePath );
-
-        shared_ptr<vaTexture> textureOut = vaTexture::CreateFromImageFile( renderDevice, filePath, textureLoadFlags, vaResourceBindSupportFlags::ShaderResource, textureContentsType );
-
-        if( textureOut == nullptr )
-        {
-            ( *importedInfo ) += vaStringTools::Format( "Error while loading '%s'\n", filePathA.c_str( ) );
-            VA_LOG( L"vaAssetPack::SingleTextureImport - Error while loading '%s'", filePath.c_str( ) );
-            return false;
-        }
+    vaTextureProcessing::ImportSettings importSettings;
+    importSettings.LoadFlags    = textureLoadFlags;
+    importSettings.ContentsType = textureContentsType;
+    importSettings.GenerateMIPs = generateMIPs;
+    importSettings.Compress     = compress;
 
-        // this is valid because all of this happens after BeginFrame was called on the device but before main application/sample starts rendering anything
-        vaRenderDeviceContext& renderContext = *renderDevice.GetMainContext( );
+    // decoding, conversion, MIP generation and compression all happen on a worker thread (so multiple imports run in parallel
+    // and don't stall the frame); only the GPU resource creation and adding to the asset pack is done on the render thread
+    // (the render device outlives the asset pack and the pack waits for all of its import tasks before going away)
+    vaRenderDevice & renderDeviceRef = GetRenderDevice();
+    auto task = vaBackgroundTaskManager::GetInstance( ).Spawn( "TextureImport", vaBackgroundTaskManager::SpawnFlags::UseThreadPool, 
+        [importedInfoWeak, assetPackWeak, filePath, assetName, importSettings, &renderDeviceRef]( vaBackgroundTaskManager::TaskContext & )
+    {
+        auto importResult = std::make_shared<vaTextureProcessing::ImportResult>( );
+        bool importSuccess = vaTextureProcessing::ImportImageFile( filePath, importSettings, *importResult );
 
-        if( textureContentsType == vaTextureContentsType::SingleChannelLinearMask && vaResourceFormatHelpers::GetChannelCount( textureOut->GetResourceFormat( ) ) > 1 )
+        renderDeviceRef.AsyncInvokeAtBeginFrame( [importedInfoWeak, assetPackWeak, filePath, assetName, importSettings, importSuccess, importResult] ( vaRenderDevice & renderDevice, float )
         {
-            vaResourceFormat outFormat = vaResourceFormat::Unknown;
-            switch( textureOut->GetResourceFormat( ) )
+            auto importedInfo   = importedInfoWeak.lock();
+            auto assetPack      = assetPackWeak.lock();
+            if( importedInfo == nullptr || assetPack == nullptr )
+                return false;   // asset pack (or the UI) went away while we were busy
+            string filePathA = vaStringTools::SimpleNarrow( filePath );
+
+            ( *importedInfo ) += importResult->Info;
+            if( !importResult->Info.empty( ) )
             {
-            case( vaResourceFormat::R8G8B8A8_UNORM ):
-            case( vaResourceFormat::B8G8R8A8_UNORM ):
-                outFormat = vaResourceFormat::R8_UNORM; break;
+                string info = importResult->Info;
+                vaStringTools::ReplaceAll( info, "\n", "; " );
+                VA_LOG( "vaAssetPack::SingleTextureImport - '%s': %s", filePathA.c_str( ), info.c_str( ) );
             }
 
-            shared_ptr<vaTexture> singleChannelTextureOut = ( outFormat == vaResourceFormat::Unknown ) ? ( nullptr ) : ( vaTexture::Create2D( renderDevice, outFormat, textureOut->GetWidth( ), textureOut->GetHeight( ), 1, 1, 1,
-                vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::RenderTarget, vaResourceAccessFlags::Default, outFormat, vaResourceFormat::Automatic, vaResourceFormat::Automatic, vaResourceFormat::Automatic,
-                textureOut->GetFlags( ), textureOut->GetContentsType( ) ) );
+            shared_ptr<vaTexture> textureOut = ( !importSuccess ) ? ( nullptr ) : 
+                ( vaTexture::CreateFromImageBuffer( renderDevice, importResult->DDSData.data( ), importResult->DDSData.size( ), importSettings.LoadFlags, vaResourceBindSupportFlags::ShaderResource, importResult->ContentsType ) );
 
-            if( singleChannelTextureOut != nullptr && renderDevice.GetPostProcess( ).MergeTextures( renderContext, singleChannelTextureOut, textureOut, nullptr, nullptr, "float4( srcA.x, 0, 0, 0 )" ) == vaDrawResultFlags::None )
+            if( textureOut == nullptr )
             {
-                ( *importedInfo ) += "Successfully removed unnecessary color channels\n";
-                VA_LOG( L"vaAssetPack::SingleTextureImport - Successfully removed unnecessary color channels for '%s' texture", filePath.c_str( ) );
-                textureOut = singleChannelTextureOut;
-            }
-        }
-
-        if( generateMIPs )
-        {
-            if( textureOut->GetMipLevels() > 1 )
-            {
-                string info = vaStringTools::Format("Loaded texture already has %d MIP levels", textureOut->GetMipLevels() );
-                ( *importedInfo ) += info + "\n";
-                VA_LOG( "vaAssetPack::SingleTextureImport - %s", info.c_str() );
-            }
-            else
-            {
-                auto mipmappedTexture = vaTexture::TryCreateMIPs( renderContext, textureOut );
-                if( mipmappedTexture != nullptr )
-                {
-                    ( *importedInfo ) += "Successfully created MIPs\n";
-                    VA_LOG( L"vaAssetPack::SingleTextureImport - Successfully created MIPs for '%s' texture", filePath.c_str( ) );
-                    textureOut = mipmappedTexture;
-                }
-                else
-                {
-                    ( *importedInfo ) += "Error while creating MIPs\n";
-                    VA_LOG( L"vaAssetPack::SingleTextureImport - Error while creating MIPs for '%s'", filePath.c_str( ) );
-                }
+                ( *importedInfo ) += vaStringTools::Format( "Error while loading '%s'\n", filePathA.c_str( ) );
+                VA_LOG( L"vaAssetPack::SingleTextureImport - Error while loading '%s'", filePath.c_str( ) );
+                return false;
             }
-        }
 
-        if( textureOut == nullptr )
-        {
-            ( *importedInfo ) += vaStringTools::Format( "Error while loading '%s'\n", filePathA.c_str( ) );
-            VA_LOG( L"vaAssetPack::SingleTextureImport - Error while loading '%s'", filePath.c_str( ) );
-            return false;
-        }
+            assert( vaThreading::IsMainThread( ) ); // remember to lock asset global mutex and switch these to 'false'
+            auto newAsset = assetPack->Add( textureOut, assetPack->FindSuitableAssetName( assetName, true ), true );
 
-        assert( vaThreading::IsMainThread( ) ); // remember to lock asset global mutex and switch these to 'false'
-        auto newAsset = assetPack->Add( textureOut, assetPack->FindSuitableAssetName( assetName, true ), true );
+            (*importedInfo) += vaStringTools::Format("Texture '%s' loaded ok.\n", filePathA.c_str( ) );
+            VA_LOG_SUCCESS( L"vaAssetPack::SingleTextureImport - Texture '%s' loaded ok.", filePath.c_str( ) );
 
-        (*importedInfo) += vaStringTools::Format("Texture '%s' loaded ok.\n", filePath.c_str( ) );
-        VA_LOG_SUCCESS( L"vaAssetPack::SingleTextureImport - Texture '%s' loaded ok.", filePath.c_str( ) );
+            return true;
+        } );
 
-        return true;
+        return importSuccess;
     } );
 
+    if( task == nullptr )
+    {
+        ( *importedInfo ) += vaStringTools::Format( "Unable to start import of '%s'\n", _filePath.c_str( ) );
+        VA_LOG_ERROR( L"vaAssetPack::SingleTextureImport - Unable to start import of '%s'", filePath.c_str( ) );
+        return;
+    }
+
+    m_importTasks.erase( std::remove_if( m_importTasks.begin( ), m_importTasks.end( ), [ ]( const shared_ptr<vaBackgroundTaskManager::Task> & t ) { return vaBackgroundTaskManager::GetInstance( ).IsFinished( t ); } ), m_importTasks.end( ) );
+    m_importTasks.push_back( task );
 }
 
 const char* GetDNDAssetTypeName( vaAssetType assetType )
@@ -1417,6 +1455,7 @@ void vaAssetPack::UIPanelTick( vaApplicationBase & )
                     }
 
                     ImGui::Checkbox( "Generate MIPs", &m_ui_teximport_generateMIPs );
+                    ImGui::Checkbox( "Compress", &m_ui_teximport_compress );
 
                     if( !vaFileTools::FileExists( m_ui_teximport_textureFilePath ) )
                     {
@@ -1430,7 +1469,7 @@ void vaAssetPack::UIPanelTick( vaApplicationBase & )
                     {
                         if( ImGui::Button( "Import texture!", ImVec2( -1.0f, 0.0f ) ) )
                         {
-                            SingleTextureImport( m_ui_teximport_textureFilePath, m_ui_teximport_assetName, m_ui_teximport_textureLoadFlags, m_ui_teximport_textureContentsType, m_ui_teximport_generateMIPs, m_ui_teximport_lastImportedInfo );
+                            SingleTextureImport( m_ui_teximport_textureFilePath, m_ui_teximport_assetName, m_ui_teximport_textureLoadFlags, m_ui_teximport_textureContentsType, m_ui_teximport_generateMIPs, m_ui_teximport_compress, m_ui_teximport_lastImportedInfo );
                         }
                     }
                 }
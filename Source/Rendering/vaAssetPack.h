@@ -162,8 +162,10 @@ namespace Vanilla
         bool                                                m_dirty                 = false;
         vaFileStream                                        m_apackStorage;
         mutex                                               m_apackStorageMutex;
+        wstring                                             m_apackStoragePath;     // only set if loaded from an uncompressed .apack (so vaTexture::GetAPACKDataOffset can be used to re-read from it)
 
         shared_ptr<vaBackgroundTaskManager::Task>           m_ioTask;
+        vector<shared_ptr<vaBackgroundTaskManager::Task>>   m_importTasks;          // texture imports in progress; waited on in the destructor as they use the render device
 
         string                                              m_uiNameFilter          = "";
         bool                                                m_uiShowMeshes          = true;
@@ -175,6 +177,7 @@ namespace Vanilla
         vaTextureLoadFlags                                  m_ui_teximport_textureLoadFlags     = vaTextureLoadFlags::Default;
         vaTextureContentsType                               m_ui_teximport_textureContentsType  = vaTextureContentsType::GenericColor;
         bool                                                m_ui_teximport_generateMIPs         = true;
+        bool                                                m_ui_teximport_compress             = false;
         shared_ptr<string>                                  m_ui_teximport_lastImportedInfo;
 
     private:
@@ -210,6 +213,9 @@ namespace Vanilla
 
         vaRenderDevice &                                    GetRenderDevice( );
 
+        // empty unless loaded from an .apack that allows re-reading individual asset data (see vaTexture::GetAPACKDataOffset)
+        const wstring &                                     GetAPACKStoragePath( ) const                { assert(vaThreading::IsMainThread()); return m_apackStoragePath; }
+
     public:
         shared_ptr<vaAssetTexture>                          Add( const shared_ptr<vaTexture> & texture, const string & name, bool lockMutex );
         shared_ptr<vaAssetRenderMesh>                       Add( const shared_ptr<vaRenderMesh> & mesh, const string & name, bool lockMutex );
@@ -244,8 +250,11 @@ namespace Vanilla
 
         bool                                                LoadAPACKInner( vaStream & inStream, vector< shared_ptr<vaAsset> > & loadedAssets, vaBackgroundTaskManager::TaskContext & taskContext );
 
+        // textures with top MIPs dropped by vaTextureStreamingManager get their full MIP chain re-read from the .apack so saving doesn't lose it
+        bool                                                RestoreStreamedTextures( );
+
     protected:
-        void                                                SingleTextureImport( string _filePath, string assetName, vaTextureLoadFlags textureLoadFlags, vaTextureContentsType textureContentsType, bool generateMIPs, shared_ptr<string> & outImportedInfo );
+        void                                                SingleTextureImport( string _filePath, string assetName, vaTextureLoadFlags textureLoadFlags, vaTextureContentsType textureContentsType, bool generateMIPs, bool compress, shared_ptr<string> & outImportedInfo );
     };
 
     class vaAssetImporter;
@@ -23,14 +23,72 @@
 
 #include "Rendering/vaRenderDeviceContext.h"
 
+#include "Core/Misc/vaSelfTest.h"
+
 //#include "Rendering/DirectX/vaDirectXIncludes.h"
 //#include "Rendering/DirectX/vaRenderBuffersDX11.h"
 //#include "Rendering/DirectX/vaRenderDeviceContextDX11.h"
 
 using namespace Vanilla;
 
+namespace
+{
+    // unique per canvas instance so that per-thread queue pointers cached by a thread never outlive the canvas they came from
+    static std::atomic<uint64>  s_nextCanvasID( 1 );
+
+    // Worker queue a thread claimed from a canvas. Only a weak reference is kept so that on thread exit the queue can be
+    // handed back for reuse without touching the canvas, which might be gone by then; whatever the thread queued before
+    // exiting still gets drawn since the canvas goes through all of its queues, claimed or not.
+    template< typename QueueType >
+    struct WorkerQueueSlot
+    {
+        uint64                      CanvasID    = 0;
+        QueueType *                 Ptr         = nullptr;
+        std::weak_ptr<QueueType>    Owner;
+
+        ~WorkerQueueSlot( )         { Release( ); }
+
+        void Release( )
+        {
+            if( auto queue = Owner.lock( ) )
+                queue->Claimed.store( false );
+            Owner.reset( );
+            CanvasID    = 0;
+            Ptr         = nullptr;
+        }
+
+        // takes over a queue released by an exited thread or adds a new one; queues mutex must be held by the caller
+        void Claim( uint64 canvasID, std::vector<std::shared_ptr<QueueType>> & queues )
+        {
+            Release( );
+
+            std::shared_ptr<QueueType> queue;
+            for( const auto & candidate : queues )
+            {
+                if( !candidate->Claimed.load( ) )
+                {
+                    queue = candidate;
+                    break;
+                }
+            }
+            if( queue == nullptr )
+            {
+                queue = std::make_shared<QueueType>( );
+                queues.push_back( queue );
+            }
+            queue->Claimed.store( true );
+
+            CanvasID    = canvasID;
+            Ptr         = queue.get( );
+            Owner       = queue;
+        }
+    };
+}
+
 vaDebugCanvas2D::vaDebugCanvas2D( const vaRenderingModuleParams & params )
-    : m_vertexBuffer( params, m_vertexBufferSize, nullptr, true ),
+    : m_ownerThreadID( std::this_thread::get_id( ) ),
+      m_canvasID( s_nextCanvasID++ ),
+      m_vertexBuffer( params, m_vertexBufferSize, nullptr, true ),
       m_pixelShader( params ),
       m_vertexShader( params )
 {
@@ -53,6 +111,18 @@ vaDebugCanvas2D::~vaDebugCanvas2D( )
 {
 }
 
+vaDebugCanvas2D::Queue & vaDebugCanvas2D::GetWorkerQueue( )
+{
+    static thread_local WorkerQueueSlot<Queue> s_local;
+
+    if( s_local.CanvasID != m_canvasID )
+    {
+        std::lock_guard<mutex> lock( m_workerQueuesMutex );
+        s_local.Claim( m_canvasID, m_workerQueues );
+    }
+    return *s_local.Ptr;
+}
+
 #define vaDirectXCanvas2D_FORMAT_WSTR() \
    va_list args; \
    va_start(args, text); \
@@ -72,58 +142,76 @@ vaDebugCanvas2D::~vaDebugCanvas2D( )
    va_end(args); \
 
 
+void vaDebugCanvas2D::QueueString( int x, int y, unsigned int penColor, unsigned int shadowColor, const wchar_t * text )
+{
+    Queue & queue = GetQueue( );
+    const size_t length = wcslen( text );
+    queue.StringLines.push_back( DrawStringItem( x, y, penColor, shadowColor, (uint32)queue.Text.size( ), (uint32)length ) );
+    queue.Text.insert( queue.Text.end( ), text, text + length );
+}
+//
+void vaDebugCanvas2D::QueueString( int x, int y, unsigned int penColor, unsigned int shadowColor, const char * text )
+{
+    // same as vaStringTools::SimpleWiden but straight into the queue's text storage
+    Queue & queue = GetQueue( );
+    const size_t length = strlen( text );
+    queue.StringLines.push_back( DrawStringItem( x, y, penColor, shadowColor, (uint32)queue.Text.size( ), (uint32)length ) );
+    queue.Text.insert( queue.Text.end( ), text, text + length );
+}
+//
 void vaDebugCanvas2D::DrawString( int x, int y, const wchar_t * text, ... )
 {
     vaDirectXCanvas2D_FORMAT_WSTR( );
-    m_drawStringLines.push_back( DrawStringItem( x, y, 0xFF000000, 0x00000000, szBuffer ) );
+    QueueString( x, y, 0xFF000000, 0x00000000, szBuffer );
 }
 //
 void vaDebugCanvas2D::DrawString( int x, int y, unsigned int penColor, const wchar_t * text, ... )
 {
     vaDirectXCanvas2D_FORMAT_WSTR( );
-    m_drawStringLines.push_back( DrawStringItem( x, y, penColor, 0x00000000, szBuffer ) );
+    QueueString( x, y, penColor, 0x00000000, szBuffer );
 }
 //
 void vaDebugCanvas2D::DrawString( int x, int y, unsigned int penColor, unsigned int shadowColor, const wchar_t * text, ... )
 {
     vaDirectXCanvas2D_FORMAT_WSTR( );
-    m_drawStringLines.push_back( DrawStringItem( x, y, penColor, shadowColor, szBuffer ) );
+    QueueString( x, y, penColor, shadowColor, szBuffer );
 }
 //
 void vaDebugCanvas2D::DrawString( int x, int y, const char * text, ... )
 {
     vaDirectXCanvas2D_FORMAT_STR( );
-    m_drawStringLines.push_back( DrawStringItem( x, y, 0xFF000000, 0x00000000, vaStringTools::SimpleWiden( std::string( szBuffer ) ).c_str( ) ) );
+    QueueString( x, y, 0xFF000000, 0x00000000, szBuffer );
 }
 //
 void vaDebugCanvas2D::DrawString( int x, int y, unsigned int penColor, const char * text, ... )
 {
     vaDirectXCanvas2D_FORMAT_STR( );
-    m_drawStringLines.push_back( DrawStringItem( x, y, penColor, 0x00000000, vaStringTools::SimpleWiden( std::string( szBuffer ) ).c_str( ) ) );
+    QueueString( x, y, penColor, 0x00000000, szBuffer );
 }
 //
 void vaDebugCanvas2D::DrawString( int x, int y, unsigned int penColor, unsigned int shadowColor, const char * text, ... )
 {
     vaDirectXCanvas2D_FORMAT_STR( );
-    m_drawStringLines.push_back( DrawStringItem( x, y, penColor, shadowColor, vaStringTools::SimpleWiden( std::string( szBuffer ) ).c_str( ) ) );
+    QueueString( x, y, penColor, shadowColor, szBuffer );
 }
 //
 void vaDebugCanvas2D::DrawLine( float x0, float y0, float x1, float y1, unsigned int penColor )
 {
-    m_drawLines.push_back( DrawLineItem( x0, y0, x1, y1, penColor ) );
+    GetQueue( ).Lines.push_back( DrawLineItem( x0, y0, x1, y1, penColor ) );
 }
 //
 void vaDebugCanvas2D::DrawRectangle( float x0, float y0, float width, float height, unsigned int penColor )
 {
-    DrawLine( x0 - 0.5f, y0, x0 + width, y0, penColor );
-    DrawLine( x0 + width, y0, x0 + width, y0 + height, penColor );
-    DrawLine( x0 + width, y0 + height, x0, y0 + height, penColor );
-    DrawLine( x0, y0 + height, x0, y0, penColor );
+    Queue & queue = GetQueue( );
+    queue.Lines.push_back( DrawLineItem( x0 - 0.5f, y0, x0 + width, y0, penColor ) );
+    queue.Lines.push_back( DrawLineItem( x0 + width, y0, x0 + width, y0 + height, penColor ) );
+    queue.Lines.push_back( DrawLineItem( x0 + width, y0 + height, x0, y0 + height, penColor ) );
+    queue.Lines.push_back( DrawLineItem( x0, y0 + height, x0, y0, penColor ) );
 }
 //
 void vaDebugCanvas2D::FillRectangle( float x0, float y0, float width, float height, unsigned int brushColor )
 {
-    m_drawRectangles.push_back( DrawRectangleItem( x0, y0, width, height, brushColor ) );
+    GetQueue( ).Rectangles.push_back( DrawRectangleItem( x0, y0, width, height, brushColor ) );
 }
 //
 void vaDebugCanvas2D::DrawCircle( float x, float y, float radius, unsigned int penColor, float tess )
@@ -134,6 +222,8 @@ void vaDebugCanvas2D::DrawCircle( float x, float y, float radius, unsigned int p
     int steps = (int)( circumference / 4.0f * tess );
     steps = vaMath::Clamp( steps, 5, 32768 );
 
+    Queue & queue = GetQueue( );
+
     float cxp = x + cos( 0 * 2 * VA_PIf ) * radius;
     float cyp = y + sin( 0 * 2 * VA_PIf ) * radius;
 
@@ -143,7 +233,7 @@ void vaDebugCanvas2D::DrawCircle( float x, float y, float radius, unsigned int p
         float cx = x + cos( p * 2 * VA_PIf ) * radius;
         float cy = y + sin( p * 2 * VA_PIf ) * radius;
 
-        DrawLine( cxp, cyp, cx, cy, penColor );
+        queue.Lines.push_back( DrawLineItem( cxp, cyp, cx, cy, penColor ) );
 
         cxp = cx;
         cyp = cy;
@@ -152,121 +242,160 @@ void vaDebugCanvas2D::DrawCircle( float x, float y, float radius, unsigned int p
 
 void vaDebugCanvas2D::CleanQueued( )
 {
-    m_drawRectangles.clear( );
-    m_drawLines.clear( );
-    m_drawStringLines.clear( );
+    m_mainQueue.Clear( );
+    std::lock_guard<mutex> lock( m_workerQueuesMutex );
+    for( const auto & queue : m_workerQueues )
+        queue->Clear( );
 }
 
-void vaDebugCanvas2D::Render( vaRenderDeviceContext & renderContext, int canvasWidth, int canvasHeight, bool bJustClearData )
+void vaDebugCanvas2D::BuildVertices( int canvasWidth, int canvasHeight )
 {
-    //ID3D11DeviceContext * context = renderContext.SafeCast<vaRenderDeviceContextDX11*>( )->GetDXContext();
+    m_triangleVertices.clear( );
+    m_lineVertices.clear( );
 
-    // Fill shapes first
-    if( !bJustClearData )
+    BuildVertices( m_mainQueue, canvasWidth, canvasHeight, m_triangleVertices, m_lineVertices );
+    std::lock_guard<mutex> lock( m_workerQueuesMutex );
+    for( const auto & queue : m_workerQueues )
+        BuildVertices( *queue, canvasWidth, canvasHeight, m_triangleVertices, m_lineVertices );
+}
+
+void vaDebugCanvas2D::BuildVertices( const Queue & queue, int canvasWidth, int canvasHeight, std::vector<CanvasVertex2D> & outTriangleVertices, std::vector<CanvasVertex2D> & outLineVertices )
+{
+    for( const DrawRectangleItem & rect : queue.Rectangles )
     {
-        uint32 rectsDrawn = 0;
-        while( rectsDrawn < m_drawRectangles.size( ) )
-        {
-            if( ( m_vertexBufferCurrentlyUsed + 6 ) >= m_vertexBufferSize )
-            {
-                m_vertexBufferCurrentlyUsed = 0;
-            }
+        outTriangleVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x, rect.y ), rect.color ) );
+        outTriangleVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x + rect.width, rect.y ), rect.color ) );
+        outTriangleVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x, rect.y + rect.height ), rect.color ) );
+        outTriangleVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x, rect.y + rect.height ), rect.color ) );
+        outTriangleVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x + rect.width, rect.y ), rect.color ) );
+        outTriangleVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x + rect.width, rect.y + rect.height ), rect.color ) );
+    }
+    for( const DrawLineItem & line : queue.Lines )
+    {
+        outLineVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( line.x0, line.y0 ), line.penColor ) );
+        outLineVertices.push_back( CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( line.x1, line.y1 ), line.penColor ) );
+    }
+}
 
-            vaResourceMapType mapType = ( m_vertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
-            if( m_vertexBuffer.Map( renderContext, mapType ) )
-            {
-                CanvasVertex2D * vertices = m_vertexBuffer.GetMappedData( );
-                int drawFromVertex = m_vertexBufferCurrentlyUsed;
+bool vaDebugCanvas2D::SelfTest( std::string * outInfo )
+{
+    // 200x100 canvas: clip space x = ( sx + 0.5 ) / 100 - 1, y = 1 - ( sy + 0.5 ) / 50
+    const int width = 200, height = 100;
 
-                while( ( rectsDrawn < m_drawRectangles.size( ) ) && ( ( m_vertexBufferCurrentlyUsed + 6 ) < m_vertexBufferSize ) )
-                {
-                    const int index = m_vertexBufferCurrentlyUsed;
+    Queue queue;
+    queue.Rectangles.push_back( DrawRectangleItem( 10.0f, 20.0f, 30.0f, 40.0f, 0xFF102030 ) );
+    queue.Lines.push_back( DrawLineItem( 0.0f, 0.0f, 199.0f, 99.0f, 0x80FFFFFF ) );
 
-                    const DrawRectangleItem & rect = m_drawRectangles[rectsDrawn];
+    std::vector<CanvasVertex2D> triangleVertices, lineVertices;
+    BuildVertices( queue, width, height, triangleVertices, lineVertices );
 
-                    vertices[index + 0] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x, rect.y ), rect.color );
-                    vertices[index + 1] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x + rect.width, rect.y ), rect.color );
-                    vertices[index + 2] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x, rect.y + rect.height ), rect.color );
-                    vertices[index + 3] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x, rect.y + rect.height ), rect.color );
-                    vertices[index + 4] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x + rect.width, rect.y ), rect.color );
-                    vertices[index + 5] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( rect.x + rect.width, rect.y + rect.height ), rect.color );
+    if( triangleVertices.size( ) != 6 || lineVertices.size( ) != 2 )
+        return vaSelfTest::Fail( outInfo, vaStringTools::Format( "expected 6 triangle and 2 line vertices, got %d and %d", (int)triangleVertices.size( ), (int)lineVertices.size( ) ) );
 
-                    m_vertexBufferCurrentlyUsed += 6;
-                    rectsDrawn++;
-                }
-                int drawVertexCount = m_vertexBufferCurrentlyUsed - drawFromVertex;
-                m_vertexBuffer.Unmap( renderContext );
+    struct Expected
+    {
+        float       ScreenX, ScreenY;
+        float       ClipX, ClipY;
+        uint32      Color;
+    };
+    const Expected expectedTriangles[] = {
+        { 10.0f, 20.0f, -0.895f,  0.59f, 0xFF102030 },
+        { 40.0f, 20.0f, -0.595f,  0.59f, 0xFF102030 },
+        { 10.0f, 60.0f, -0.895f, -0.21f, 0xFF102030 },
+        { 10.0f, 60.0f, -0.895f, -0.21f, 0xFF102030 },
+        { 40.0f, 20.0f, -0.595f,  0.59f, 0xFF102030 },
+        { 40.0f, 60.0f, -0.595f, -0.21f, 0xFF102030 },
+    };
+    const Expected expectedLines[] = {
+        {   0.0f,  0.0f, -0.995f,  0.99f, 0x80FFFFFF },
+        { 199.0f, 99.0f,  0.995f, -0.99f, 0x80FFFFFF },
+    };
+
+    auto check = [ & ]( const char * what, const std::vector<CanvasVertex2D> & actual, const Expected * expected, size_t count ) -> bool
+    {
+        for( size_t i = 0; i < count; i++ )
+        {
+            const CanvasVertex2D & v = actual[i];
+            const Expected & e = expected[i];
+            if( vaMath::Abs( v.pos.x - e.ClipX ) > 1e-5f || vaMath::Abs( v.pos.y - e.ClipY ) > 1e-5f || v.pos.z != 0.5f || v.pos.w != 1.0f )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s vertex %d at (%.4f, %.4f, %.4f, %.4f), expected (%.4f, %.4f, 0.5, 1)", what, (int)i, v.pos.x, v.pos.y, v.pos.z, v.pos.w, e.ClipX, e.ClipY ) );
+            if( v.screenPos.x != e.ScreenX || v.screenPos.y != e.ScreenY )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s vertex %d screen position (%.1f, %.1f), expected (%.1f, %.1f)", what, (int)i, v.screenPos.x, v.screenPos.y, e.ScreenX, e.ScreenY ) );
+            if( v.color != e.Color )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s vertex %d color 0x%08x, expected 0x%08x", what, (int)i, v.color, e.Color ) );
+        }
+        return true;
+    };
 
-                vaGraphicsItem renderItem;
+    if( !check( "triangle", triangleVertices, expectedTriangles, _countof( expectedTriangles ) ) || !check( "line", lineVertices, expectedLines, _countof( expectedLines ) ) )
+        return false;
+    return vaSelfTest::Pass( outInfo );
+}
 
-                renderItem.CullMode     = vaFaceCull::None;
-                renderItem.BlendMode    = vaBlendMode::AlphaBlend;
-                renderItem.VertexShader = m_vertexShader;
-                renderItem.VertexBuffer = m_vertexBuffer.GetBuffer();
-                renderItem.Topology     = vaPrimitiveTopology::TriangleList;
-                renderItem.PixelShader  = m_pixelShader;
-                renderItem.SetDrawSimple( drawVertexCount, drawFromVertex );
+void vaDebugCanvas2D::UploadAndDraw( vaRenderDeviceContext & renderContext, const std::vector<CanvasVertex2D> & vertices, vaPrimitiveTopology topology )
+{
+    // whole primitives only, in as few Map/draw calls as the ring buffer allows
+    const uint32 primitiveSize  = ( topology == vaPrimitiveTopology::LineList ) ? ( 2 ) : ( 3 );
+    const uint32 maxChunk       = ( m_vertexBufferSize / primitiveSize ) * primitiveSize;
 
-                renderContext.ExecuteSingleItem( renderItem, nullptr );
-            }
-            else
-            {
-                assert( false );
-            }
+    uint32 verticesDrawn = 0;
+    while( verticesDrawn < (uint32)vertices.size( ) )
+    {
+        if( ( m_vertexBufferCurrentlyUsed + primitiveSize ) >= m_vertexBufferSize )
+        {
+            m_vertexBufferCurrentlyUsed = 0;
         }
-    }
 
-    // Lines
-    if( !bJustClearData )
-    {
-        uint32 linesDrawn = 0;
-        while( linesDrawn < m_drawLines.size( ) )
+        uint32 available    = ( ( m_vertexBufferSize - m_vertexBufferCurrentlyUsed ) / primitiveSize ) * primitiveSize;
+        uint32 count        = vaMath::Min( vaMath::Min( available, maxChunk ), (uint32)vertices.size( ) - verticesDrawn );
+
+        vaResourceMapType mapType = ( m_vertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
+        if( !m_vertexBuffer.Map( renderContext, mapType ) )
         {
-            if( ( m_vertexBufferCurrentlyUsed + 2 ) >= m_vertexBufferSize )
-            {
-                m_vertexBufferCurrentlyUsed = 0;
-            }
+            assert( false );
+            return;
+        }
+        memcpy( m_vertexBuffer.GetMappedData( ) + m_vertexBufferCurrentlyUsed, vertices.data( ) + verticesDrawn, sizeof( CanvasVertex2D ) * count );
+        m_vertexBuffer.Unmap( renderContext );
 
-            vaResourceMapType mapType = ( m_vertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
-            if( m_vertexBuffer.Map( renderContext, mapType ) )
-            {
-                CanvasVertex2D * vertices = m_vertexBuffer.GetMappedData( );
-                int drawFromVertex = m_vertexBufferCurrentlyUsed;
+        vaGraphicsItem renderItem;
 
-                while( ( linesDrawn < m_drawLines.size( ) ) && ( ( m_vertexBufferCurrentlyUsed + 2 ) < m_vertexBufferSize ) )
-                {
-                    const int index = m_vertexBufferCurrentlyUsed;
+        renderItem.CullMode     = vaFaceCull::None;
+        renderItem.BlendMode    = vaBlendMode::AlphaBlend;
+        renderItem.VertexShader = m_vertexShader;
+        renderItem.VertexBuffer = m_vertexBuffer.GetBuffer();
+        renderItem.Topology     = topology;
+        renderItem.PixelShader  = m_pixelShader;
+        renderItem.SetDrawSimple( count, m_vertexBufferCurrentlyUsed );
 
-                    vertices[index + 0] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( m_drawLines[linesDrawn].x0, m_drawLines[linesDrawn].y0 ), m_drawLines[linesDrawn].penColor );
-                    vertices[index + 1] = CanvasVertex2D( canvasWidth, canvasHeight, vaVector2( m_drawLines[linesDrawn].x1, m_drawLines[linesDrawn].y1 ), m_drawLines[linesDrawn].penColor );
+        renderContext.ExecuteSingleItem( renderItem, nullptr );
 
-                    m_vertexBufferCurrentlyUsed += 2;
-                    linesDrawn++;
-                }
-                int drawVertexCount = m_vertexBufferCurrentlyUsed - drawFromVertex;
-                m_vertexBuffer.Unmap( renderContext );
+        m_vertexBufferCurrentlyUsed += count;
+        verticesDrawn               += count;
+    }
+}
 
-                vaGraphicsItem renderItem;
+void vaDebugCanvas2D::Render( vaRenderDeviceContext & renderContext, int canvasWidth, int canvasHeight, bool bJustClearData )
+{
+    //ID3D11DeviceContext * context = renderContext.SafeCast<vaRenderDeviceContextDX11*>( )->GetDXContext();
 
-                renderItem.CullMode     = vaFaceCull::None;
-                renderItem.BlendMode    = vaBlendMode::AlphaBlend;
-                renderItem.VertexShader = m_vertexShader;
-                renderItem.VertexBuffer = m_vertexBuffer.GetBuffer();
-                renderItem.Topology     = vaPrimitiveTopology::LineList;
-                renderItem.PixelShader  = m_pixelShader;
-                renderItem.SetDrawSimple( drawVertexCount, drawFromVertex );
+    if( !bJustClearData )
+    {
+        BuildVertices( canvasWidth, canvasHeight );
 
-                renderContext.ExecuteSingleItem( renderItem, nullptr );
-            }
-            else
-            {
-                assert( false );
-            }
-        }
+        // Fill shapes first, then lines
+        UploadAndDraw( renderContext, m_triangleVertices, vaPrimitiveTopology::TriangleList );
+        UploadAndDraw( renderContext, m_lineVertices, vaPrimitiveTopology::LineList );
     }
 
     // Text
-    if( !bJustClearData && m_drawStringLines.size( ) > 0 )
+    size_t stringLineCount = m_mainQueue.StringLines.size( );
+    {
+        std::lock_guard<mutex> lock( m_workerQueuesMutex );
+        for( const auto & queue : m_workerQueues )
+            stringLineCount += queue->StringLines.size( );
+    }
+    if( !bJustClearData && stringLineCount > 0 )
     {
         assert( false ); // not implemented for DX12 so remove it for now :(
 
@@ -583,12 +712,12 @@ technique LineAA
 */
 
 
-#include "Rendering/vaStandardShapes.h"
-
 using namespace Vanilla;
 
 vaDebugCanvas3D::vaDebugCanvas3D( const vaRenderingModuleParams & params )
-    :   m_triVertexBuffer( params, m_triVertexBufferSizeInVerts, nullptr, true ),
+    :   m_ownerThreadID( std::this_thread::get_id( ) ),
+        m_canvasID( s_nextCanvasID++ ),
+        m_triVertexBuffer( params, m_triVertexBufferSizeInVerts, nullptr, true ),
         m_lineVertexBuffer( params, m_lineVertexBufferSizeInVerts, nullptr, true ),
     m_vertexShader( params ),
     m_pixelShader( params )
@@ -601,17 +730,9 @@ vaDebugCanvas3D::vaDebugCanvas3D( const vaRenderingModuleParams & params )
     m_pixelShader->CreateShaderFromFile( L"vaCanvas.hlsl", "ps_5_0", "PS_Canvas3D", vaShaderMacroContaner{}, false );
 
     m_triVertexBufferCurrentlyUsed = 0;
-    m_triVertexBufferStart = 0;
-
     m_lineVertexBufferCurrentlyUsed = 0;
-    m_lineVertexBufferStart = 0;
-
-    vaStandardShapes::CreateSphere( m_sphereVertices, m_sphereIndices, 2, true );
 
-    m_triVertexBufferCurrentlyUsed = 0;
-    m_triVertexBufferStart = 0;
-    m_lineVertexBufferCurrentlyUsed = 0;
-    m_lineVertexBufferStart = 0;
+    m_sphere = vaStandardShapes::CachedSphere( 2, true );
 }
 
 vaDebugCanvas3D::~vaDebugCanvas3D( )
@@ -619,72 +740,58 @@ vaDebugCanvas3D::~vaDebugCanvas3D( )
     //m_triVertexBuffer.Destroy( );
     m_triVertexBufferCurrentlyUsed = 0;
     //m_triVertexBufferSizeInVerts = 0;
-    m_triVertexBufferStart = 0;
 
     //m_lineVertexBuffer.Destroy( );
     m_lineVertexBufferCurrentlyUsed = 0;
     //m_lineVertexBufferSizeInVerts = 0;
-    m_lineVertexBufferStart = 0;
 }
 
-void vaDebugCanvas3D::CleanQueued( )
+vaDebugCanvas3D::Queue & vaDebugCanvas3D::GetWorkerQueue( )
 {
-    m_drawItems.clear( );
-    m_drawItemsTransforms.clear( );
-    m_drawLines.clear( );
-    m_drawLinesTransformed.clear( );
-    m_drawTrianglesTransformed.clear( );
-}
+    static thread_local WorkerQueueSlot<Queue> s_local;
 
-void vaDebugCanvas3D::RenderLine( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, const CanvasVertex3D & a, const CanvasVertex3D & b )
-{
-    if( ( m_lineVertexBufferCurrentlyUsed + 2 ) >= m_lineVertexBufferSizeInVerts )
+    if( s_local.CanvasID != m_canvasID )
     {
-        FlushLines( renderContext, camera );
-        m_lineVertexBufferCurrentlyUsed = 0;
-        m_lineVertexBufferStart = 0;
+        std::lock_guard<mutex> lock( m_workerQueuesMutex );
+        s_local.Claim( m_canvasID, m_workerQueues );
     }
+    return *s_local.Ptr;
+}
 
-    vaResourceMapType mapType = ( m_lineVertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
-    if( m_lineVertexBuffer.Map( renderContext, mapType ) )
-    {
-        CanvasVertex3D * vertices = m_lineVertexBuffer.GetMappedData( );
-        vertices[m_lineVertexBufferCurrentlyUsed++] = a;
-        vertices[m_lineVertexBufferCurrentlyUsed++] = b;
-        m_lineVertexBuffer.Unmap( renderContext );
-    }
+void vaDebugCanvas3D::CleanQueued( )
+{
+    m_mainQueue.Clear( );
+    std::lock_guard<mutex> lock( m_workerQueuesMutex );
+    for( const auto & queue : m_workerQueues )
+        queue->Clear( );
 }
 
-void vaDebugCanvas3D::RenderLineBatch( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, DrawLineTransformed * itemFrom, size_t count )
+void vaDebugCanvas3D::UploadAndDraw( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, vaTypedVertexBufferWrapper<CanvasVertex3D> & vertexBuffer, uint32 & vertexBufferCurrentlyUsed, uint32 vertexBufferSize, const vector<CanvasVertex3D> & vertices, vaPrimitiveTopology topology )
 {
-    if( ( m_lineVertexBufferCurrentlyUsed + count * 2 ) >= m_lineVertexBufferSizeInVerts )
-    {
-        FlushLines( renderContext, camera );
-        m_lineVertexBufferCurrentlyUsed = 0;
-        m_lineVertexBufferStart = 0;
-    }
+    // whole primitives only, in as few Map/draw calls as the ring buffer allows
+    const uint32 primitiveSize  = ( topology == vaPrimitiveTopology::LineList ) ? ( 2 ) : ( 3 );
+    const uint32 maxChunk       = ( vertexBufferSize / primitiveSize ) * primitiveSize;
 
-    vaResourceMapType mapType = ( m_lineVertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
-    if( m_lineVertexBuffer.Map( renderContext, mapType ) )
+    uint32 verticesDrawn = 0;
+    while( verticesDrawn < (uint32)vertices.size( ) )
     {
-        CanvasVertex3D * vertices = m_lineVertexBuffer.GetMappedData( );
-        for( size_t i = 0; i < count; i++ )
+        if( ( vertexBufferCurrentlyUsed + primitiveSize ) >= vertexBufferSize )
         {
-            DrawLineTransformed & line = itemFrom[i];
-
-            vertices[m_lineVertexBufferCurrentlyUsed++] = line.v0;
-            vertices[m_lineVertexBufferCurrentlyUsed++] = line.v1;
+            vertexBufferCurrentlyUsed = 0;
         }
-        m_lineVertexBuffer.Unmap( renderContext );
-    }
-}
 
-void vaDebugCanvas3D::FlushLines( vaRenderDeviceContext & renderContext, const vaCameraBase & camera )
-{
-    int verticesToRender = m_lineVertexBufferCurrentlyUsed - m_lineVertexBufferStart;
+        uint32 available    = ( ( vertexBufferSize - vertexBufferCurrentlyUsed ) / primitiveSize ) * primitiveSize;
+        uint32 count        = vaMath::Min( vaMath::Min( available, maxChunk ), (uint32)vertices.size( ) - verticesDrawn );
+
+        vaResourceMapType mapType = ( vertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
+        if( !vertexBuffer.Map( renderContext, mapType ) )
+        {
+            assert( false );
+            return;
+        }
+        memcpy( vertexBuffer.GetMappedData( ) + vertexBufferCurrentlyUsed, vertices.data( ) + verticesDrawn, sizeof( CanvasVertex3D ) * count );
+        vertexBuffer.Unmap( renderContext );
 
-    if( verticesToRender > 0 )
-    {
         vaGraphicsItem renderItem;
 
         renderItem.DepthEnable      = true;
@@ -693,254 +800,311 @@ void vaDebugCanvas3D::FlushLines( vaRenderDeviceContext & renderContext, const v
         renderItem.CullMode         = vaFaceCull::None;
         renderItem.BlendMode        = vaBlendMode::AlphaBlend;
         renderItem.VertexShader     = m_vertexShader;
-        renderItem.VertexBuffer     = m_lineVertexBuffer.GetBuffer();
-        renderItem.Topology         = vaPrimitiveTopology::LineList;
+        renderItem.VertexBuffer     = vertexBuffer.GetBuffer();
+        renderItem.Topology         = topology;
         renderItem.PixelShader      = m_pixelShader;
-        renderItem.SetDrawSimple( verticesToRender, m_lineVertexBufferStart );
+        renderItem.SetDrawSimple( count, vertexBufferCurrentlyUsed );
 
         renderContext.ExecuteSingleItem( renderItem, nullptr );
-    }
-    m_lineVertexBufferStart = m_lineVertexBufferCurrentlyUsed;
-}
-
-void vaDebugCanvas3D::RenderTriangle( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, const CanvasVertex3D & a, const CanvasVertex3D & b, const CanvasVertex3D & c )
-{
-    if( ( m_triVertexBufferCurrentlyUsed + 3 ) >= m_triVertexBufferSizeInVerts )
-    {
-        FlushTriangles( renderContext, camera );
-        m_triVertexBufferCurrentlyUsed = 0;
-        m_triVertexBufferStart = 0;
-    }
 
-    vaResourceMapType mapType = ( m_triVertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
-    if( m_triVertexBuffer.Map( renderContext, mapType ) )
-    {
-        CanvasVertex3D * vertices = m_triVertexBuffer.GetMappedData( );
-        vertices[m_triVertexBufferCurrentlyUsed++] = a;
-        vertices[m_triVertexBufferCurrentlyUsed++] = b;
-        vertices[m_triVertexBufferCurrentlyUsed++] = c;
-        m_triVertexBuffer.Unmap( renderContext );
+        vertexBufferCurrentlyUsed   += count;
+        verticesDrawn               += count;
     }
 }
 
-void vaDebugCanvas3D::RenderTrianglesBatch( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, DrawTriangleTransformed * itemFrom, size_t count )
+void vaDebugCanvas3D::BuildVertices( const vaMatrix4x4 & viewProj )
 {
-    if( ( m_triVertexBufferCurrentlyUsed + count * 3 ) >= m_triVertexBufferSizeInVerts )
-    {
-        FlushTriangles( renderContext, camera );
-        m_triVertexBufferCurrentlyUsed = 0;
-        m_triVertexBufferStart = 0;
-    }
+    m_triVertices.clear( );
+    m_lineVertices.clear( );
 
-    vaResourceMapType mapType = ( m_triVertexBufferCurrentlyUsed == 0 ) ? ( vaResourceMapType::WriteDiscard ) : ( vaResourceMapType::WriteNoOverwrite );
-    if( m_triVertexBuffer.Map( renderContext, mapType ) )
-    {
-        CanvasVertex3D * vertices = m_triVertexBuffer.GetMappedData( );
-        for( size_t i = 0; i < count; i++ )
-        {
-            DrawTriangleTransformed & triangle = itemFrom[i];
-
-            vertices[m_triVertexBufferCurrentlyUsed++] = triangle.v0;
-            vertices[m_triVertexBufferCurrentlyUsed++] = triangle.v1;
-            vertices[m_triVertexBufferCurrentlyUsed++] = triangle.v2;
-        }
-        m_triVertexBuffer.Unmap( renderContext );
-    }
+    BuildVertices( m_mainQueue, viewProj, *m_sphere, m_triVertices, m_lineVertices );
+    std::lock_guard<mutex> lock( m_workerQueuesMutex );
+    for( const auto & queue : m_workerQueues )
+        BuildVertices( *queue, viewProj, *m_sphere, m_triVertices, m_lineVertices );
 }
 
-void vaDebugCanvas3D::FlushTriangles( vaRenderDeviceContext & renderContext, const vaCameraBase & camera )
+void vaDebugCanvas3D::BuildVertices( const Queue & queue, const vaMatrix4x4 & viewProj, const vaStandardShapes::Geometry & sphere, vector<CanvasVertex3D> & outTriVertices, vector<CanvasVertex3D> & outLineVertices )
 {
-    int verticesToRender = m_triVertexBufferCurrentlyUsed - m_triVertexBufferStart;
+    vaMatrix4x4 tempMat;
 
-    if( verticesToRender > 0 )
+    // first do triangles
+    for( size_t i = 0; i < queue.Items.size( ); i++ )
     {
-        vaGraphicsItem renderItem;
-
-        renderItem.DepthEnable      = true;
-        renderItem.DepthWriteEnable = false;
-        renderItem.DepthFunc        = ( camera.GetUseReversedZ() )?( vaComparisonFunc::GreaterEqual ):( vaComparisonFunc::LessEqual );
-        renderItem.CullMode         = vaFaceCull::None;
-        renderItem.BlendMode        = vaBlendMode::AlphaBlend;
-        renderItem.VertexShader     = m_vertexShader;
-        renderItem.VertexBuffer     = m_triVertexBuffer.GetBuffer();
-        renderItem.Topology         = vaPrimitiveTopology::TriangleList;
-        renderItem.PixelShader      = m_pixelShader;
-        renderItem.SetDrawSimple( verticesToRender, m_triVertexBufferStart );
-
-        renderContext.ExecuteSingleItem( renderItem, nullptr );
-    }
-    m_triVertexBufferStart = m_triVertexBufferCurrentlyUsed;
-}
-
-void vaDebugCanvas3D::Render( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, bool bJustClearData )
-{
-    vaMatrix4x4 viewProj = camera.GetViewMatrix( ) * camera.GetProjMatrix( );
+        const DrawItem & item = queue.Items[i];
 
-    if( !bJustClearData )
-    {
-        vaMatrix4x4 tempMat;
+        // use viewProj by default
+        const vaMatrix4x4 * trans = &viewProj;
 
-        // first do triangles
-        for( size_t i = 0; i < m_drawItems.size( ); i++ )
+        // or if the object has its own transform matrix, 'add' it to the viewProj
+        if( item.transformIndex != -1 )
         {
-            DrawItem & item = m_drawItems[i];
+            //assert( false ); // this is broken; lines are different from triangles; add InternalDrawLine that accepts already transformed lines...
+            const vaMatrix4x4 &local = queue.Transforms[item.transformIndex];
+            tempMat = local * viewProj;
+            trans = &tempMat;
+        }
 
-            // use viewProj by default
-            const vaMatrix4x4 * trans = &viewProj;
+        if( item.type == Triangle )
+        {
+            CanvasVertex3D a0( item.v0, item.brushColor, trans );
+            CanvasVertex3D a1( item.v1, item.brushColor, trans );
+            CanvasVertex3D a2( item.v2, item.brushColor, trans );
 
-            // or if the object has its own transform matrix, 'add' it to the viewProj
-            if( item.transformIndex != -1 )
+            if( ( item.brushColor & 0xFF000000 ) != 0 )
             {
-                //assert( false ); // this is broken; lines are different from triangles; add InternalDrawLine that accepts already transformed lines...
-                vaMatrix4x4 &local = m_drawItemsTransforms[item.transformIndex];
-                tempMat = local * viewProj;
-                trans = &tempMat;
+                InternalDrawTriangle( outTriVertices, a0, a1, a2 );
             }
 
-            if( item.type == Triangle )
+            if( ( item.penColor & 0xFF000000 ) != 0 )
             {
-                CanvasVertex3D a0( item.v0, item.brushColor, trans );
-                CanvasVertex3D a1( item.v1, item.brushColor, trans );
-                CanvasVertex3D a2( item.v2, item.brushColor, trans );
+                a0.color = item.penColor;
+                a1.color = item.penColor;
+                a2.color = item.penColor;
 
-                if( ( item.brushColor & 0xFF000000 ) != 0 )
-                {
-                    InternalDrawTriangle( a0, a1, a2 );
-                }
-
-                if( ( item.penColor & 0xFF000000 ) != 0 )
-                {
-                    a0.color = item.penColor;
-                    a1.color = item.penColor;
-                    a2.color = item.penColor;
-
-                    InternalDrawLine( a0, a1 );
-                    InternalDrawLine( a1, a2 );
-                    InternalDrawLine( a2, a0 );
-                }
+                InternalDrawLine( outLineVertices, a0, a1 );
+                InternalDrawLine( outLineVertices, a1, a2 );
+                InternalDrawLine( outLineVertices, a2, a0 );
             }
+        }
 
-            if( item.type == Box )
-            {
+        if( item.type == Box )
+        {
 
-                const vaVector3 & boxMin = item.v0;
-                const vaVector3 & boxMax = item.v1;
-
-                vaVector3 va0( boxMin.x, boxMin.y, boxMin.z );
-                vaVector3 va1( boxMax.x, boxMin.y, boxMin.z );
-                vaVector3 va2( boxMax.x, boxMax.y, boxMin.z );
-                vaVector3 va3( boxMin.x, boxMax.y, boxMin.z );
-                vaVector3 vb0( boxMin.x, boxMin.y, boxMax.z );
-                vaVector3 vb1( boxMax.x, boxMin.y, boxMax.z );
-                vaVector3 vb2( boxMax.x, boxMax.y, boxMax.z );
-                vaVector3 vb3( boxMin.x, boxMax.y, boxMax.z );
-
-                CanvasVertex3D a0( va0, item.brushColor, trans );
-                CanvasVertex3D a1( va1, item.brushColor, trans );
-                CanvasVertex3D a2( va2, item.brushColor, trans );
-                CanvasVertex3D a3( va3, item.brushColor, trans );
-                CanvasVertex3D b0( vb0, item.brushColor, trans );
-                CanvasVertex3D b1( vb1, item.brushColor, trans );
-                CanvasVertex3D b2( vb2, item.brushColor, trans );
-                CanvasVertex3D b3( vb3, item.brushColor, trans );
-
-                if( ( item.brushColor & 0xFF000000 ) != 0 )
-                {
-                    InternalDrawTriangle( a0, a2, a1 );
-                    InternalDrawTriangle( a2, a0, a3 );
+            const vaVector3 & boxMin = item.v0;
+            const vaVector3 & boxMax = item.v1;
+
+            vaVector3 va0( boxMin.x, boxMin.y, boxMin.z );
+            vaVector3 va1( boxMax.x, boxMin.y, boxMin.z );
+            vaVector3 va2( boxMax.x, boxMax.y, boxMin.z );
+            vaVector3 va3( boxMin.x, boxMax.y, boxMin.z );
+            vaVector3 vb0( boxMin.x, boxMin.y, boxMax.z );
+            vaVector3 vb1( boxMax.x, boxMin.y, boxMax.z );
+            vaVector3 vb2( boxMax.x, boxMax.y, boxMax.z );
+            vaVector3 vb3( boxMin.x, boxMax.y, boxMax.z );
+
+            CanvasVertex3D a0( va0, item.brushColor, trans );
+            CanvasVertex3D a1( va1, item.brushColor, trans );
+            CanvasVertex3D a2( va2, item.brushColor, trans );
+            CanvasVertex3D a3( va3, item.brushColor, trans );
+            CanvasVertex3D b0( vb0, item.brushColor, trans );
+            CanvasVertex3D b1( vb1, item.brushColor, trans );
+            CanvasVertex3D b2( vb2, item.brushColor, trans );
+            CanvasVertex3D b3( vb3, item.brushColor, trans );
+
+            if( ( item.brushColor & 0xFF000000 ) != 0 )
+            {
+                InternalDrawTriangle( outTriVertices, a0, a2, a1 );
+                InternalDrawTriangle( outTriVertices, a2, a0, a3 );
 
-                    InternalDrawTriangle( b0, b1, b2 );
-                    InternalDrawTriangle( b2, b3, b0 );
+                InternalDrawTriangle( outTriVertices, b0, b1, b2 );
+                InternalDrawTriangle( outTriVertices, b2, b3, b0 );
 
-                    InternalDrawTriangle( a0, a1, b1 );
-                    InternalDrawTriangle( b1, b0, a0 );
+                InternalDrawTriangle( outTriVertices, a0, a1, b1 );
+                InternalDrawTriangle( outTriVertices, b1, b0, a0 );
 
-                    InternalDrawTriangle( a1, a2, b2 );
-                    InternalDrawTriangle( b1, a1, b2 );
+                InternalDrawTriangle( outTriVertices, a1, a2, b2 );
+                InternalDrawTriangle( outTriVertices, b1, a1, b2 );
 
-                    InternalDrawTriangle( a2, a3, b3 );
-                    InternalDrawTriangle( b3, b2, a2 );
+                InternalDrawTriangle( outTriVertices, a2, a3, b3 );
+                InternalDrawTriangle( outTriVertices, b3, b2, a2 );
 
-                    InternalDrawTriangle( a3, a0, b0 );
-                    InternalDrawTriangle( b0, b3, a3 );
-                }
+                InternalDrawTriangle( outTriVertices, a3, a0, b0 );
+                InternalDrawTriangle( outTriVertices, b0, b3, a3 );
+            }
 
-                if( ( item.penColor & 0xFF000000 ) != 0 )
-                {
-                    a0.color = item.penColor;
-                    a1.color = item.penColor;
-                    a2.color = item.penColor;
-                    a3.color = item.penColor;
-                    b0.color = item.penColor;
-                    b1.color = item.penColor;
-                    b2.color = item.penColor;
-                    b3.color = item.penColor;
-
-                    InternalDrawLine( a0, a1 );
-                    InternalDrawLine( a1, a2 );
-                    InternalDrawLine( a2, a3 );
-                    InternalDrawLine( a3, a0 );
-                    InternalDrawLine( a0, b0 );
-                    InternalDrawLine( a1, b1 );
-                    InternalDrawLine( a2, b2 );
-                    InternalDrawLine( a3, b3 );
-                    InternalDrawLine( b0, b1 );
-                    InternalDrawLine( b1, b2 );
-                    InternalDrawLine( b2, b3 );
-                    InternalDrawLine( b3, b0 );
-                }
+            if( ( item.penColor & 0xFF000000 ) != 0 )
+            {
+                a0.color = item.penColor;
+                a1.color = item.penColor;
+                a2.color = item.penColor;
+                a3.color = item.penColor;
+                b0.color = item.penColor;
+                b1.color = item.penColor;
+                b2.color = item.penColor;
+                b3.color = item.penColor;
+
+                InternalDrawLine( outLineVertices, a0, a1 );
+                InternalDrawLine( outLineVertices, a1, a2 );
+                InternalDrawLine( outLineVertices, a2, a3 );
+                InternalDrawLine( outLineVertices, a3, a0 );
+                InternalDrawLine( outLineVertices, a0, b0 );
+                InternalDrawLine( outLineVertices, a1, b1 );
+                InternalDrawLine( outLineVertices, a2, b2 );
+                InternalDrawLine( outLineVertices, a3, b3 );
+                InternalDrawLine( outLineVertices, b0, b1 );
+                InternalDrawLine( outLineVertices, b1, b2 );
+                InternalDrawLine( outLineVertices, b2, b3 );
+                InternalDrawLine( outLineVertices, b3, b0 );
             }
+        }
+
+        if( item.type == Sphere )
+        {
+            const std::vector<vaVector3> &  sphereVertices  = sphere.Vertices;
+            const std::vector<uint32> &     sphereIndices   = sphere.Indices;
 
-            if( item.type == Sphere )
+            if( ( item.brushColor & 0xFF000000 ) != 0 )
             {
-                if( ( item.brushColor & 0xFF000000 ) != 0 )
+                for( size_t j = 0; j < sphereIndices.size( ); j += 3 )
                 {
-                    for( size_t j = 0; j < m_sphereIndices.size( ); j += 3 )
-                    {
-                        vaVector3 sCenter = item.v0;
-                        float sRadius = item.v1.x;
+                    vaVector3 sCenter = item.v0;
+                    float sRadius = item.v1.x;
 
-                        CanvasVertex3D a0( m_sphereVertices[m_sphereIndices[j + 0]] * sRadius + sCenter, item.brushColor, trans );
-                        CanvasVertex3D a1( m_sphereVertices[m_sphereIndices[j + 1]] * sRadius + sCenter, item.brushColor, trans );
-                        CanvasVertex3D a2( m_sphereVertices[m_sphereIndices[j + 2]] * sRadius + sCenter, item.brushColor, trans );
+                    CanvasVertex3D a0( sphereVertices[sphereIndices[j + 0]] * sRadius + sCenter, item.brushColor, trans );
+                    CanvasVertex3D a1( sphereVertices[sphereIndices[j + 1]] * sRadius + sCenter, item.brushColor, trans );
+                    CanvasVertex3D a2( sphereVertices[sphereIndices[j + 2]] * sRadius + sCenter, item.brushColor, trans );
 
-                        InternalDrawTriangle( a0, a1, a2 );
-                    }
+                    InternalDrawTriangle( outTriVertices, a0, a1, a2 );
                 }
+            }
 
-                if( ( item.penColor & 0xFF000000 ) != 0 )
+            if( ( item.penColor & 0xFF000000 ) != 0 )
+            {
+                for( size_t j = 0; j < sphereIndices.size( ); j += 3 )
                 {
-                    for( size_t j = 0; j < m_sphereIndices.size( ); j += 3 )
-                    {
-                        vaVector3 sCenter = item.v0;
-                        float sRadius = item.v1.x;
-
-                        CanvasVertex3D a0( m_sphereVertices[m_sphereIndices[j + 0]] * sRadius + sCenter, item.penColor, trans );
-                        CanvasVertex3D a1( m_sphereVertices[m_sphereIndices[j + 1]] * sRadius + sCenter, item.penColor, trans );
-                        CanvasVertex3D a2( m_sphereVertices[m_sphereIndices[j + 2]] * sRadius + sCenter, item.penColor, trans );
-
-                        InternalDrawLine( a0, a1 );
-                        InternalDrawLine( a1, a2 );
-                        InternalDrawLine( a2, a0 );
-                    }
+                    vaVector3 sCenter = item.v0;
+                    float sRadius = item.v1.x;
+
+                    CanvasVertex3D a0( sphereVertices[sphereIndices[j + 0]] * sRadius + sCenter, item.penColor, trans );
+                    CanvasVertex3D a1( sphereVertices[sphereIndices[j + 1]] * sRadius + sCenter, item.penColor, trans );
+                    CanvasVertex3D a2( sphereVertices[sphereIndices[j + 2]] * sRadius + sCenter, item.penColor, trans );
+
+                    InternalDrawLine( outLineVertices, a0, a1 );
+                    InternalDrawLine( outLineVertices, a1, a2 );
+                    InternalDrawLine( outLineVertices, a2, a0 );
                 }
             }
         }
-        size_t batchSize = 512;
-        for( size_t i = 0; i < m_drawTrianglesTransformed.size( ); i += batchSize )
-            RenderTrianglesBatch( renderContext, camera, m_drawTrianglesTransformed.data( ) + i, vaMath::Min( batchSize, m_drawTrianglesTransformed.size( ) - i ) );
+    }
+
+    // then add the lines (non-transformed to transformed)
+    for( const DrawLineItem & line : queue.Lines )
+        InternalDrawLine( outLineVertices, CanvasVertex3D( line.v0, line.penColor0, &viewProj ), CanvasVertex3D( line.v1, line.penColor1, &viewProj ) );
+}
+
+bool vaDebugCanvas3D::SelfTest( std::string * outInfo )
+{
+    const vaVector3     boxMin( -1.0f, -2.0f, -3.0f );
+    const vaVector3     boxMax(  1.0f,  2.0f,  3.0f );
+    const vaVector3     offset( 10.0f, 0.0f, 0.0f );
+    const vaVector3     sphereCenter( 0.0f, 0.0f, 5.0f );
+    const float         sphereRadius = 2.0f;
+    const uint32        penColor    = 0xFF00FF00;
+    const uint32        brushColor  = 0x80FF0000;
+
+    vaStandardShapes::Geometry sphere;
+    vaStandardShapes::CreateSphere( sphere.Vertices, sphere.Indices, 1, true );
+
+    // identity viewProj, so clip space positions are the world space ones with w == 1
+    Queue queue;
+    vaMatrix4x4 translation = vaMatrix4x4::Translation( offset );
+    queue.Items.push_back( DrawItem( boxMin, boxMax, vaVector3( 0.0f, 0.0f, 0.0f ), penColor, brushColor, Box ) );
+    queue.Items.push_back( DrawItem( boxMin, boxMax, vaVector3( 0.0f, 0.0f, 0.0f ), penColor, 0, Box, queue.AddTransform( &translation ) ) );
+    queue.Items.push_back( DrawItem( sphereCenter, vaVector3( sphereRadius, 0.0f, 0.0f ), vaVector3( 0.0f, 0.0f, 0.0f ), 0, brushColor, Sphere ) );
+    queue.Lines.push_back( DrawLineItem( vaVector3( 1.0f, 2.0f, 3.0f ), vaVector3( 4.0f, 5.0f, 6.0f ), 0xFF0000FF, 0xFFFF0000 ) );
+
+    vector<CanvasVertex3D> triVertices, lineVertices;
+    BuildVertices( queue, vaMatrix4x4::Identity, sphere, triVertices, lineVertices );
+
+    // filled box: 12 triangles; outlined boxes: 12 edges each; then the sphere triangles and the line
+    const size_t expectedTriangleVerts  = 36 + sphere.Indices.size( );
+    const size_t expectedLineVerts      = 24 + 24 + 2;
+    if( triVertices.size( ) != expectedTriangleVerts || lineVertices.size( ) != expectedLineVerts )
+        return vaSelfTest::Fail( outInfo, vaStringTools::Format( "expected %d triangle and %d line vertices, got %d and %d", (int)expectedTriangleVerts, (int)expectedLineVerts, (int)triVertices.size( ), (int)lineVertices.size( ) ) );
+
+    auto nearEqual = [ ]( float a, float b ) { return vaMath::Abs( a - b ) <= 1e-5f; };
+
+    // box corner as a bit per axis (set for max), -1 if the vertex isn't on one of the corners
+    auto cornerIndex = [ & ]( const CanvasVertex3D & v, const vaVector3 & bmin, const vaVector3 & bmax ) -> int
+    {
+        if( !nearEqual( v.pos.w, 1.0f ) )
+            return -1;
+        const float p[3] = { v.pos.x, v.pos.y, v.pos.z }, lo[3] = { bmin.x, bmin.y, bmin.z }, hi[3] = { bmax.x, bmax.y, bmax.z };
+        int index = 0;
+        for( int axis = 0; axis < 3; axis++ )
+        {
+            if( nearEqual( p[axis], hi[axis] ) )
+                index |= 1 << axis;
+            else if( !nearEqual( p[axis], lo[axis] ) )
+                return -1;
+        }
+        return index;
+    };
+
+    // filled box: every triangle is half of a face and each of the 6 faces is covered by exactly two
+    int faceTriangles[6] = { };
+    for( size_t i = 0; i < 36; i += 3 )
+    {
+        int c[3];
+        for( int k = 0; k < 3; k++ )
+        {
+            const CanvasVertex3D & v = triVertices[i + k];
+            c[k] = cornerIndex( v, boxMin, boxMax );
+            if( c[k] < 0 || v.color != brushColor )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "box triangle vertex %d at (%.3f, %.3f, %.3f, %.3f) color 0x%08x is not a box corner with brush color", (int)( i + k ), v.pos.x, v.pos.y, v.pos.z, v.pos.w, v.color ) );
+        }
+        const int sharedAxes = ~( ( c[0] ^ c[1] ) | ( c[0] ^ c[2] ) ) & 7;
+        if( c[0] == c[1] || c[1] == c[2] || c[2] == c[0] || sharedAxes == 0 || ( sharedAxes & ( sharedAxes - 1 ) ) != 0 )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "box triangle %d (corners %d, %d, %d) is not half of a box face", (int)( i / 3 ), c[0], c[1], c[2] ) );
+        const int axis = ( sharedAxes == 1 ) ? ( 0 ) : ( ( sharedAxes == 2 ) ? ( 1 ) : ( 2 ) );
+        faceTriangles[axis * 2 + ( ( c[0] >> axis ) & 1 )]++;
+    }
+    for( int face = 0; face < 6; face++ )
+        if( faceTriangles[face] != 2 )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "box face %d covered by %d triangles, expected 2", face, faceTriangles[face] ) );
+
+    // outlined boxes: the 12 distinct edges, the second one moved by its transform
+    for( int box = 0; box < 2; box++ )
+    {
+        const vaVector3 bmin = ( box == 0 ) ? ( boxMin ) : ( boxMin + offset );
+        const vaVector3 bmax = ( box == 0 ) ? ( boxMax ) : ( boxMax + offset );
+        uint32 edgesSeen = 0;
+        for( size_t i = 0; i < 24; i += 2 )
+        {
+            const CanvasVertex3D & v0 = lineVertices[box * 24 + i + 0];
+            const CanvasVertex3D & v1 = lineVertices[box * 24 + i + 1];
+            const int c0 = cornerIndex( v0, bmin, bmax ), c1 = cornerIndex( v1, bmin, bmax );
+            const int diff = c0 ^ c1;
+            if( c0 < 0 || c1 < 0 || diff == 0 || ( diff & ( diff - 1 ) ) != 0 || v0.color != penColor || v1.color != penColor )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "box %d line %d from (%.3f, %.3f, %.3f) to (%.3f, %.3f, %.3f) is not a box edge with pen color", box, (int)( i / 2 ), v0.pos.x, v0.pos.y, v0.pos.z, v1.pos.x, v1.pos.y, v1.pos.z ) );
+            // edge id: axis it runs along and the corner it starts from with that axis cleared
+            const int axis = ( diff == 1 ) ? ( 0 ) : ( ( diff == 2 ) ? ( 1 ) : ( 2 ) );
+            edgesSeen |= 1u << ( axis * 8 + ( std::min( c0, c1 ) ) );
+        }
+        int edgeCount = 0;
+        for( int bit = 0; bit < 32; bit++ )
+            edgeCount += ( edgesSeen >> bit ) & 1;
+        if( edgeCount != 12 )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "box %d outline has %d distinct edges, expected 12", box, edgeCount ) );
+    }
 
-        FlushTriangles( renderContext, camera );
+    // sphere: all vertices on its surface
+    for( size_t i = 36; i < triVertices.size( ); i++ )
+    {
+        const CanvasVertex3D & v = triVertices[i];
+        const float distance = ( vaVector3( v.pos.x, v.pos.y, v.pos.z ) - sphereCenter ).Length( );
+        if( vaMath::Abs( distance - sphereRadius ) > 1e-4f || !nearEqual( v.pos.w, 1.0f ) || v.color != brushColor )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "sphere vertex %d at distance %.5f from the center, expected %.5f", (int)( i - 36 ), distance, sphereRadius ) );
+    }
 
-        // then add the lines (non-transformed to transformed)
-        for( size_t i = 0; i < m_drawLines.size( ); i++ )
-            m_drawLinesTransformed.push_back( DrawLineTransformed( CanvasVertex3D(m_drawLines[i].v0, m_drawLines[i].penColor0, &viewProj), CanvasVertex3D(m_drawLines[i].v1, m_drawLines[i].penColor1, &viewProj) ) );
+    // line: both ends where given, each with its own color
+    const CanvasVertex3D & l0 = lineVertices[48];
+    const CanvasVertex3D & l1 = lineVertices[49];
+    if( !nearEqual( l0.pos.x, 1.0f ) || !nearEqual( l0.pos.y, 2.0f ) || !nearEqual( l0.pos.z, 3.0f ) || !nearEqual( l0.pos.w, 1.0f ) || l0.color != 0xFF0000FF
+        || !nearEqual( l1.pos.x, 4.0f ) || !nearEqual( l1.pos.y, 5.0f ) || !nearEqual( l1.pos.z, 6.0f ) || !nearEqual( l1.pos.w, 1.0f ) || l1.color != 0xFFFF0000 )
+        return vaSelfTest::Fail( outInfo, vaStringTools::Format( "line from (%.3f, %.3f, %.3f, %.3f) to (%.3f, %.3f, %.3f, %.3f), expected (1, 2, 3, 1) to (4, 5, 6, 1)", l0.pos.x, l0.pos.y, l0.pos.z, l0.pos.w, l1.pos.x, l1.pos.y, l1.pos.z, l1.pos.w ) );
 
-        for( size_t i = 0; i < m_drawLinesTransformed.size( ); i += batchSize )
-            RenderLineBatch( renderContext, camera, m_drawLinesTransformed.data( ) + i, vaMath::Min( batchSize, m_drawLinesTransformed.size( ) - i ) );
+    return vaSelfTest::Pass( outInfo );
+}
 
-        FlushLines( renderContext, camera );
+void vaDebugCanvas3D::Render( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, bool bJustClearData )
+{
+    if( !bJustClearData )
+    {
+        BuildVertices( camera.GetViewMatrix( ) * camera.GetProjMatrix( ) );
 
+        UploadAndDraw( renderContext, camera, m_triVertexBuffer, m_triVertexBufferCurrentlyUsed, m_triVertexBufferSizeInVerts, m_triVertices, vaPrimitiveTopology::TriangleList );
+        UploadAndDraw( renderContext, camera, m_lineVertexBuffer, m_lineVertexBufferCurrentlyUsed, m_lineVertexBufferSizeInVerts, m_lineVertices, vaPrimitiveTopology::LineList );
     }
     CleanQueued( );
 }
@@ -23,15 +23,23 @@
 
 #include "Rendering/vaShader.h"
 #include "Rendering/vaRenderBuffers.h"
+#include "Rendering/vaStandardShapes.h"
 
 namespace Vanilla
 {
     // FS: Decided to make these two singletons as I can't think of a use where they wouldn't be at the moment. If need
     // arises, one option is to split vaDebugCanvas2D into ICanvas2D interface and then inherit vaCanvas2DSingleton from it.
 
+    // Draw calls can come from any thread: the thread that created the canvas (main) appends directly, all other threads
+    // append into their own per-thread queue (no locking after the first call on a thread). A thread hands its queue back
+    // when it exits and the next new thread reuses it, so there are only as many queues as threads drawing concurrently.
+    // All queues get merged in BuildVertices/Render, so draw calls from other threads must be finished before Render is
+    // called (as is the case for anything running within vaThreading::ParallelFor, for example).
+    // Queues and vertex arrays keep their capacity across frames so steady-state frames do no heap allocations.
+
     class vaDebugCanvas2D : public vaSingletonBase<vaDebugCanvas2D> // maybe better to use vaMultitonBase?
     {
-    protected:
+    public:
         // Types
         struct CanvasVertex2D
         {
@@ -58,6 +66,7 @@ namespace Vanilla
             }
         };
         //
+    protected:
         struct DrawRectangleItem
         {
             float x, y, width, height;
@@ -72,9 +81,10 @@ namespace Vanilla
             int            x, y;
             unsigned int   penColor;
             unsigned int   shadowColor;
-            std::wstring   text;
-            DrawStringItem( int x, int y, unsigned int penColor, unsigned int shadowColor, const wchar_t * text )
-                : x( x ), y( y ), penColor( penColor ), shadowColor( shadowColor ), text( text ) {}
+            uint32         textOffset;      // into Queue::Text
+            uint32         textLength;
+            DrawStringItem( int x, int y, unsigned int penColor, unsigned int shadowColor, uint32 textOffset, uint32 textLength )
+                : x( x ), y( y ), penColor( penColor ), shadowColor( shadowColor ), textOffset( textOffset ), textLength( textLength ) {}
         };
         //
         struct DrawLineItem
@@ -88,12 +98,31 @@ namespace Vanilla
             DrawLineItem( float x0, float y0, float x1, float y1, unsigned int penColor )
                 : x0( x0 ), y0( y0 ), x1( x1 ), y1( y1 ), penColor( penColor ) { }
         };
+        //
+        // queued render calls from one thread
+        struct Queue
+        {
+            std::vector<DrawStringItem>     StringLines;
+            std::vector<wchar_t>            Text;           // all StringLines texts, not null-terminated
+            std::vector<DrawLineItem>       Lines;
+            std::vector<DrawRectangleItem>  Rectangles;
+            std::atomic<bool>               Claimed         { false };  // worker queues only: in use by a live thread
+
+            void                            Clear( )        { StringLines.clear( ); Text.clear( ); Lines.clear( ); Rectangles.clear( ); }
+        };
 
     protected:
         // buffers for queued render calls
-        std::vector<DrawStringItem>     m_drawStringLines;
-        std::vector<DrawLineItem>       m_drawLines;
-        std::vector<DrawRectangleItem>  m_drawRectangles;
+        Queue                           m_mainQueue;
+        std::vector<std::shared_ptr<Queue>>
+                                        m_workerQueues;     // reused once the thread that claimed them exits, see GetWorkerQueue
+        mutex                           m_workerQueuesMutex;
+        const std::thread::id           m_ownerThreadID;
+        const uint64                    m_canvasID;
+
+        // vertices built from all queues, ready for upload
+        std::vector<CanvasVertex2D>     m_triangleVertices;
+        std::vector<CanvasVertex2D>     m_lineVertices;
 
         // GPU buffers
         vaTypedVertexBufferWrapper< CanvasVertex2D >
@@ -115,6 +144,16 @@ namespace Vanilla
         void                 CleanQueued( );
         void                 Render( vaRenderDeviceContext & renderContext, int canvasWidth, int canvasHeight, bool bJustClearData = false );
         //
+        // Converts everything queued so far (from all threads) into triangle and line list vertices; no GPU access so it
+        // can be used (and inspected) without rendering. Render calls this and then only uploads the results.
+        void                 BuildVertices( int canvasWidth, int canvasHeight );
+        const std::vector<CanvasVertex2D> & GetTriangleVertices( ) const  { return m_triangleVertices; }
+        const std::vector<CanvasVertex2D> & GetLineVertices( ) const      { return m_lineVertices; }
+        //
+        // Builds vertices for a known line and filled rectangle and checks counts, clip space positions and colors;
+        // describes the first failure in outInfo (see vaSelfTest).
+        static bool          SelfTest( std::string * outInfo = nullptr );
+        //
     public:
         // would've used DrawText but thats #defined somewhere in windows.h or related headers :/
         virtual void        DrawString( int x, int y, const wchar_t * text, ... );
@@ -133,11 +172,19 @@ namespace Vanilla
         //
         inline void         DrawLine( const vaVector2 & a, vaVector2 & b, unsigned int penColor )                                                   { DrawLine( a.x, a.y, b.x, b.y, penColor ); }
         inline void         DrawLineArrowhead( const vaVector2 & a, vaVector2 & b, float arrowHeadSize, unsigned int penColor )                     { DrawLineArrowhead( a.x, a.y, b.x, b.y, arrowHeadSize, penColor ); }
+
+    protected:
+        Queue &             GetQueue( )                                                                                                             { return ( std::this_thread::get_id( ) == m_ownerThreadID ) ? ( m_mainQueue ) : ( GetWorkerQueue( ) ); }
+        Queue &             GetWorkerQueue( );
+        static void         BuildVertices( const Queue & queue, int canvasWidth, int canvasHeight, std::vector<CanvasVertex2D> & outTriangleVertices, std::vector<CanvasVertex2D> & outLineVertices );
+        void                QueueString( int x, int y, unsigned int penColor, unsigned int shadowColor, const wchar_t * text );
+        void                QueueString( int x, int y, unsigned int penColor, unsigned int shadowColor, const char * text );
+        void                UploadAndDraw( vaRenderDeviceContext & renderContext, const std::vector<CanvasVertex2D> & vertices, vaPrimitiveTopology topology );
     };
 
     class vaDebugCanvas3D : public vaSingletonBase<vaDebugCanvas3D> // maybe better to use vaMultitonBase?
     {
-     protected:
+     public:
         // Types
         struct CanvasVertex3D
         {
@@ -175,6 +222,7 @@ namespace Vanilla
             }
         };
         //
+     protected:
         enum DrawItemType
         {
             Triangle,
@@ -204,21 +252,18 @@ namespace Vanilla
 
             DrawLineItem( const vaVector3 &v0, const vaVector3 &v1, unsigned int penColor0, unsigned int penColor1 ) : v0( v0 ), v1( v1 ), penColor0( penColor0 ), penColor1( penColor1 ) { }
         };
-        struct DrawTriangleTransformed
+        //
+        // queued render calls from one thread (see vaDebugCanvas2D comments); DrawItem::transformIndex points into the same queue's Transforms
+        struct Queue
         {
-            CanvasVertex3D    v0;
-            CanvasVertex3D    v1;
-            CanvasVertex3D    v2;
+            vector<DrawItem>              Items;
+            vector<vaMatrix4x4>           Transforms;
+            vector<DrawLineItem>          Lines;
+            std::atomic<bool>             Claimed         { false };  // worker queues only: in use by a live thread
 
-            DrawTriangleTransformed( const CanvasVertex3D &v0, const CanvasVertex3D &v1, const CanvasVertex3D &v2 ) : v0( v0 ), v1( v1 ), v2( v2 ) { }
+            void                          Clear( )        { Items.clear( ); Transforms.clear( ); Lines.clear( ); }
+            int                           AddTransform( const vaMatrix4x4 * transform )    { if( transform == nullptr ) return -1; Transforms.push_back( *transform ); return (int)Transforms.size( ) - 1; }
         };
-        struct DrawLineTransformed
-        {
-            CanvasVertex3D    v0;
-            CanvasVertex3D    v1;
-
-            DrawLineTransformed( const CanvasVertex3D &v0, const CanvasVertex3D &v1 ) : v0( v0 ), v1( v1 ) { }
-        };      
         //
      protected:
         // 
@@ -227,23 +272,23 @@ namespace Vanilla
         //int                              m_height;
 
         // buffers for queued render calls
-        vector<DrawItem>                  m_drawItems;
-        vector<vaMatrix4x4>               m_drawItemsTransforms;
-        vector<DrawLineItem>              m_drawLines;
+        Queue                             m_mainQueue;
+        vector<std::shared_ptr<Queue>>    m_workerQueues;     // reused once the thread that claimed them exits, see GetWorkerQueue
+        mutex                             m_workerQueuesMutex;
+        const std::thread::id             m_ownerThreadID;
+        const uint64                      m_canvasID;
         //
-        // buffers for transformed data ready for rendering
-        vector<DrawLineTransformed>       m_drawLinesTransformed;
-        vector<DrawTriangleTransformed>   m_drawTrianglesTransformed;
+        // transformed vertices ready for upload
+        vector<CanvasVertex3D>            m_triVertices;
+        vector<CanvasVertex3D>            m_lineVertices;
         //
         // GPU buffers
         vaTypedVertexBufferWrapper<CanvasVertex3D>
             m_triVertexBuffer;
-        uint32				            m_triVertexBufferStart;
         uint32				            m_triVertexBufferCurrentlyUsed;
         static const uint32				m_triVertexBufferSizeInVerts = 1024 * 1024 * 2;
         vaTypedVertexBufferWrapper<CanvasVertex3D>
             m_lineVertexBuffer;
-        uint32				            m_lineVertexBufferStart;
         uint32				            m_lineVertexBufferCurrentlyUsed;
         static const uint32               m_lineVertexBufferSizeInVerts = 1024 * 1024 * 2;
 
@@ -251,8 +296,7 @@ namespace Vanilla
         vaAutoRMI<vaPixelShader>            m_pixelShader;
         vaAutoRMI<vaVertexShader>           m_vertexShader;
 
-        std::vector<vaVector3>            m_sphereVertices;
-        std::vector<uint32>               m_sphereIndices;
+        shared_ptr<const vaStandardShapes::Geometry>    m_sphere;
 
     public:
         vaDebugCanvas3D( const vaRenderingModuleParams & params );
@@ -276,22 +320,33 @@ namespace Vanilla
         virtual void        CleanQueued( );
         virtual void        Render( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, bool bJustClearData = false );
         //
+        // Transforms everything queued so far (from all threads) into triangle and line list vertices; no GPU access so it
+        // can be used (and inspected) without rendering. Render calls this and then only uploads the results.
+        void                BuildVertices( const vaMatrix4x4 & viewProj );
+        const vector<CanvasVertex3D> & GetTriangleVertices( ) const    { return m_triVertices; }
+        const vector<CanvasVertex3D> & GetLineVertices( ) const        { return m_lineVertices; }
+        //
+        // Builds vertices for a known filled and outlined box (with and without a transform), a sphere and a line and
+        // checks counts, positions and colors; describes the first failure in outInfo (see vaSelfTest).
+        static bool         SelfTest( std::string * outInfo = nullptr );
+        //
     private:
-        void RenderTriangle( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, const CanvasVertex3D & a, const CanvasVertex3D & b, const CanvasVertex3D & c );
-        void FlushTriangles( vaRenderDeviceContext & renderContext, const vaCameraBase & camera );
+        Queue &             GetQueue( )                                 { return ( std::this_thread::get_id( ) == m_ownerThreadID ) ? ( m_mainQueue ) : ( GetWorkerQueue( ) ); }
+        Queue &             GetWorkerQueue( );
+        static void         BuildVertices( const Queue & queue, const vaMatrix4x4 & viewProj, const vaStandardShapes::Geometry & sphere, vector<CanvasVertex3D> & outTriVertices, vector<CanvasVertex3D> & outLineVertices );
 
-        void RenderLine( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, const CanvasVertex3D & a, const CanvasVertex3D & b );
-        void RenderLineBatch( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, DrawLineTransformed * itemFrom, size_t count );
-        void RenderTrianglesBatch( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, DrawTriangleTransformed * itemFrom, size_t count );
-        void FlushLines( vaRenderDeviceContext & renderContext, const vaCameraBase & camera );
+        void UploadAndDraw( vaRenderDeviceContext & renderContext, const vaCameraBase & camera, vaTypedVertexBufferWrapper<CanvasVertex3D> & vertexBuffer, uint32 & vertexBufferCurrentlyUsed, uint32 vertexBufferSize, const vector<CanvasVertex3D> & vertices, vaPrimitiveTopology topology );
 
-        void InternalDrawTriangle( const CanvasVertex3D & v0, const CanvasVertex3D & v1, const CanvasVertex3D & v2 )
+        static void InternalDrawTriangle( vector<CanvasVertex3D> & outTriVertices, const CanvasVertex3D & v0, const CanvasVertex3D & v1, const CanvasVertex3D & v2 )
         {
-            m_drawTrianglesTransformed.push_back( DrawTriangleTransformed( v0, v1, v2 ) );
+            outTriVertices.push_back( v0 );
+            outTriVertices.push_back( v1 );
+            outTriVertices.push_back( v2 );
         }
-        void InternalDrawLine( const CanvasVertex3D & v0, const CanvasVertex3D & v1 )
+        static void InternalDrawLine( vector<CanvasVertex3D> & outLineVertices, const CanvasVertex3D & v0, const CanvasVertex3D & v1 )
         {
-            m_drawLinesTransformed.push_back( DrawLineTransformed( v0, v1 ) );
+            outLineVertices.push_back( v0 );
+            outLineVertices.push_back( v1 );
         }
     };
 
@@ -340,7 +395,7 @@ namespace Vanilla
     // vaDebugCanvas3D
     inline void vaDebugCanvas3D::DrawLine( const vaVector3 & v0, const vaVector3 & v1, unsigned int penColor )
     {
-        m_drawLines.push_back( DrawLineItem( v0, v1, penColor, penColor ) );
+        GetQueue( ).Lines.push_back( DrawLineItem( v0, v1, penColor, penColor ) );
     }
     inline void vaDebugCanvas3D::DrawAxis( const vaVector3 & _v0, float size, const vaMatrix4x4 * transform, float alpha )
     {
@@ -366,41 +421,29 @@ namespace Vanilla
     }
     inline void vaDebugCanvas3D::DrawBox( const vaVector3 & v0, const vaVector3 & v1, unsigned int penColor, unsigned int brushColor, const vaMatrix4x4 * transform )
     {
-        int transformIndex = -1;
-        if( transform != NULL )
-        {
-            transformIndex = (int)m_drawItemsTransforms.size( );
-            m_drawItemsTransforms.push_back( *transform );
-        }
-        m_drawItems.push_back( DrawItem( v0, v1, vaVector3( 0.0f, 0.0f, 0.0f ), penColor, brushColor, Box, transformIndex ) );
+        Queue & queue = GetQueue( );
+        int transformIndex = queue.AddTransform( transform );
+        queue.Items.push_back( DrawItem( v0, v1, vaVector3( 0.0f, 0.0f, 0.0f ), penColor, brushColor, Box, transformIndex ) );
     }
     inline void vaDebugCanvas3D::DrawTriangle( const vaVector3 & v0, const vaVector3 & v1, const vaVector3 & v2, unsigned int penColor, unsigned int brushColor, const vaMatrix4x4 * transform )
     {
-        int transformIndex = -1;
-        if( transform != NULL )
-        {
-            transformIndex = (int)m_drawItemsTransforms.size( );
-            m_drawItemsTransforms.push_back( *transform );
-        }
+        Queue & queue = GetQueue( );
+        int transformIndex = queue.AddTransform( transform );
 
-        m_drawItems.push_back( DrawItem( v0, v1, v2, penColor, brushColor, Triangle, transformIndex ) );
+        queue.Items.push_back( DrawItem( v0, v1, v2, penColor, brushColor, Triangle, transformIndex ) );
     }
     //
     inline void vaDebugCanvas3D::DrawQuad( const vaVector3 & v0, const vaVector3 & v1, const vaVector3 & v2, const vaVector3 & v3, unsigned int penColor, unsigned int brushColor, const vaMatrix4x4 * transform )
     {
-        int transformIndex = -1;
-        if( transform != NULL )
-        {
-            transformIndex = (int)m_drawItemsTransforms.size( );
-            m_drawItemsTransforms.push_back( *transform );
-        }
+        Queue & queue = GetQueue( );
+        int transformIndex = queue.AddTransform( transform );
 
-        m_drawItems.push_back( DrawItem( v0, v1, v2, penColor, brushColor, Triangle, transformIndex ) );
-        m_drawItems.push_back( DrawItem( v2, v1, v3, penColor, brushColor, Triangle, transformIndex ) );
+        queue.Items.push_back( DrawItem( v0, v1, v2, penColor, brushColor, Triangle, transformIndex ) );
+        queue.Items.push_back( DrawItem( v2, v1, v3, penColor, brushColor, Triangle, transformIndex ) );
     }
     inline void vaDebugCanvas3D::DrawSphere( const vaVector3 & center, float radius, unsigned int penColor, unsigned int brushColor )
     {
-        m_drawItems.push_back( DrawItem( center, vaVector3( radius, 0.0f, 0.0f ), vaVector3( 0.0f, 0.0f, 0.0f ), penColor, brushColor, Sphere ) );
+        GetQueue( ).Items.push_back( DrawItem( center, vaVector3( radius, 0.0f, 0.0f ), vaVector3( 0.0f, 0.0f, 0.0f ), penColor, brushColor, Sphere ) );
     }
     inline void vaDebugCanvas3D::DrawPlane( const vaPlane & plane, unsigned int brushColor, float extents )
     {
@@ -21,6 +21,7 @@
 
 #include "Core/System/vaFileTools.h"
 #include "Core/vaApplicationBase.h"
+#include "Core/Misc/vaSelfTest.h"
 
 #include "Rendering/Shaders/vaSharedTypes.h"
 
@@ -36,6 +37,11 @@
 
 #include <fstream>
 
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define USE_SSE_IBL_SH
+#include <emmintrin.h>
+#endif
+
 using namespace Vanilla;
 
 
@@ -406,6 +412,20 @@ void vaIBLProbe::UIPanelTick( vaApplicationBase& application )
 #endif // VA_IMGUI_INTEGRATION_ENABLED
 }
 
+bool vaIBLProbe::ValidatePreFilterSampleTables( string * outInfo ) const
+{
+    // the tables are only built when the probe gets imported or captured
+    if( !HasContents( ) )
+        return vaSelfTest::Pass( outInfo, "probe has no contents, nothing to check" );
+
+    string reflectionsInfo, irradianceInfo;
+    if( !m_reflectionsPreFilter->ValidateSampleTables( &reflectionsInfo ) )
+        return vaSelfTest::Fail( outInfo, "reflections: " + reflectionsInfo );
+    if( !m_irradiancePreFilter->ValidateSampleTables( &irradianceInfo ) )
+        return vaSelfTest::Fail( outInfo, "irradiance: " + irradianceInfo );
+    return vaSelfTest::Pass( outInfo, "reflections " + reflectionsInfo + ", irradiance " + irradianceInfo );
+}
+
 vaDrawResultFlags vaIBLProbe::Capture( vaRenderDeviceContext & renderContext, const vaIBLProbeData & captureData, const CubeFaceCaptureCallback & faceCapture, int cubeFaceResolution )
 {
     Reset( );
@@ -568,94 +588,128 @@ static vaVector3 hemisphereCosSample( vaVector2 u )
     return { sinTheta * std::cos( phi ), sinTheta * std::sin( phi ), cosTheta };
 }
 
-void vaIBLCubemapPreFilter::Init( uint32 outputBaseSize, uint32 outputMinSize, uint32 samplesPerTexel, vaIBLCubemapPreFilter::FilterType filterType )
+// from "filament\libs\ibl\src\CubemapUtils.cpp"
+static inline float CubeSphereQuadrantArea( float x, float y )
 {
-    assert( filterType != vaIBLCubemapPreFilter::FilterType::Unknown );
+    return std::atan2( x * y, std::sqrt( x * x + y * y + 1.0f ) );
+}
 
-    if( m_outputBaseSize == outputBaseSize && m_numSamples == samplesPerTexel && m_filterType == filterType )
-        return; // all good, no need to re-init
+// same as CubemapSolidAngle
+static inline float CubeTexelSolidAngle( int cubeDim, int ux, int uy )
+{
+    const float iDim = 1.0f / (float)cubeDim;
+    float s = ( ( ux + 0.5f ) * 2 * iDim ) - 1;
+    float t = ( ( uy + 0.5f ) * 2 * iDim ) - 1;
+    const float x0 = s - iDim;
+    const float y0 = t - iDim;
+    const float x1 = s + iDim;
+    const float y1 = t + iDim;
+    return  CubeSphereQuadrantArea( x0, y0 ) - CubeSphereQuadrantArea( x0, y1 ) - CubeSphereQuadrantArea( x1, y0 ) + CubeSphereQuadrantArea( x1, y1 );
+}
 
-    VA_LOG( "vaIBLCubemapPreFilter::Init( outputBaseSize == %d, samplesPerPixel == %d ) - this shouldn't be called every frame", outputBaseSize, samplesPerTexel );
+// face local (px, py, pz) = normalize( cx, cy, 1 ) to cube direction, see CubemapGetDirectionFor
+static inline void CubeFaceDirection( int face, float px, float py, float pz, float & x, float & y, float & z )
+{
+    switch( face )
+    {
+    case 0:  x =  pz; y =  py; z = -px; break;  // PX
+    case 1:  x = -pz; y =  py; z =  px; break;  // NX
+    case 2:  x =  px; y =  pz; z = -py; break;  // PY
+    case 3:  x =  px; y = -pz; z =  py; break;  // NY
+    case 4:  x =  px; y =  py; z =  pz; break;  // PZ
+    default: x = -px; y =  py; z = -pz; break;  // NZ
+    }
+}
 
-    Reset();
+// from shaders, but a bit more relaxed
+// #define MIN_PERCEPTUAL_ROUGHNESS 0.045
+static const float c_IBLPreFilterMinRoughness = (float)( 0.002025 * 0.33 );
 
-    if( !vaMath::IsPowOf2( outputBaseSize ) )
-        { assert( false ); VA_ERROR( "vaIBLCubemapPreFilter::Init( outputBaseSize == %d, samplesPerPixel == %d ) - outputBaseSize must be power of 2", outputBaseSize, samplesPerTexel ); }
-    if( outputBaseSize < 4 || outputBaseSize > 4096 || samplesPerTexel < 1 || samplesPerTexel > 32768 )
-        { assert( false ); VA_ERROR( "vaIBLCubemapPreFilter::Init( outputBaseSize == %d, samplesPerPixel == %d ) - params out of range (outputBaseSize < 4 || outputBaseSize > 4096 || samplesPerTexel < 1 || samplesPerTexel > 32768)", outputBaseSize, samplesPerTexel ); }
+float vaIBLCubemapPreFilter::LevelLinearRoughness( uint32 level, uint32 numMIPLevels )
+{
+    // see perceptualRoughnessToRoughness - linear_roughness = perceptual_roughness^2
+    const float lod = vaMath::Saturate( level / ( (float)numMIPLevels - 1.0f ) );
 
-    m_filterType    = filterType;
+    // map the lod to a linear_roughness,  here we're using ^2, but other mappings are possible.
+    // ==> lod = sqrt(linear_roughness)
+    // (if this changes, change c_roughnessMapping too so cached tables get rebuilt)
+    return std::max( lod * lod, c_IBLPreFilterMinRoughness );
+}
 
-    m_outputBaseSize= outputBaseSize;
-    m_numSamples    = samplesPerTexel;
-    
-    m_numMIPLevels = vaMath::FloorLog2( m_outputBaseSize / outputMinSize )+1;
+void vaIBLCubemapPreFilter::GenerateSampleTables( const SampleTablesKey & key, vector<vector<SampleInfo>> & outLevelSamples )
+{
+    VA_TRACE_CPU_SCOPE( IBLPreFilterGenerateSampleTables );
 
-    m_levels.resize( m_numMIPLevels );
+    const uint32 numMIPLevels = key.NumMIPLevels;
+    const FilterType filterType = key.Type;
 
-    const size_t dim0 = m_outputBaseSize;
+    const size_t dim0 = key.OutputBaseSize;
     const float omegaP = ( 4.0f * (float)F_PI ) / float( 6 * dim0 * dim0 );
+    const uint32 maxSampleMIPLevel = vaMath::FloorLog2( key.OutputBaseSize ); // this is for sampling part; in this case outputBaseSize is also inputBaseSize
 
-    uint32 numSamples = m_numSamples;
-    uint32 maxSampleMIPLevel = vaMath::FloorLog2( m_outputBaseSize ); // this is for sampling part; in this case outputBaseSize is also inputBaseSize
-    for( uint32 level = 0; level < m_numMIPLevels; level++ ) 
+    if( filterType == vaIBLCubemapPreFilter::FilterType::ReflectionsRoughness )
+    {
+        assert( numMIPLevels > 2 );   // doesn't really make sense to pre-filter for only 1 or 2 levels
+    }
+    else if( filterType != vaIBLCubemapPreFilter::FilterType::Irradiance )
     {
-        const uint32 dim    = m_outputBaseSize >> level;
+        assert( false ); // unsupported filter type?
+    }
 
+    vector<uint32> levelNumSamples( numMIPLevels );
+    uint32 numSamples = key.SamplesPerTexel;
+    for( uint32 level = 0; level < numMIPLevels; level++ )
+    {
         // we do a very mild min-roughness pass on the first level for reflections - it doesn't
         // need many samples so start with m_numSamples/4
         if( level == 0 && filterType == vaIBLCubemapPreFilter::FilterType::ReflectionsRoughness )
-            numSamples = m_numSamples/4;
-        
+            numSamples = key.SamplesPerTexel/4;
+
         // level 1 always uses full sample count
         if( level == 1 )
-            numSamples = m_numSamples;
+            numSamples = key.SamplesPerTexel;
 
         // starting at level 2, we increase the number of samples per level
         // this helps as the filter gets wider, and since there are 4x less work
         // per level, this doesn't slow things down a lot.
-        if( level >= 2 ) 
+        if( level >= 2 )
             numSamples *= 2;
 
         // limit the number of samples to a max sane value
         numSamples = std::min( numSamples, 16384U );
 
-        LevelInfo & levelInfo = m_levels[level];
-        levelInfo.Samples.clear( );
+        levelNumSamples[level] = numSamples;
+    }
 
-        levelInfo.Size = dim;
+    // Every candidate sample gets its own slot so they can be generated in any order and on any thread; invalid ones
+    // (NoL <= 0) get Weight 0 and are compacted out afterwards, keeping the original sample index order.
+    const uint32 c_chunkSize = 512;
+    struct WorkItem { uint32 Level; uint32 Begin; uint32 End; };
+    vector<WorkItem> workItems;
+    vector<vector<SampleInfo>> candidates( numMIPLevels );
+    for( uint32 level = 0; level < numMIPLevels; level++ )
+    {
+        candidates[level].resize( levelNumSamples[level] );
+        for( uint32 begin = 0; begin < levelNumSamples[level]; begin += c_chunkSize )
+            workItems.push_back( { level, begin, std::min( begin + c_chunkSize, levelNumSamples[level] ) } );
+    }
 
-        if( filterType == vaIBLCubemapPreFilter::FilterType::ReflectionsRoughness )
+    vaThreading::ParallelFor( (int)workItems.size( ), 1, [&]( int begin, int end )
+    {
+        for( int w = begin; w < end; w++ )
         {
-            const float lod = vaMath::Saturate( level / ( (float)m_numMIPLevels - 1.0f ) );
-
-            // see perceptualRoughnessToRoughness - linear_roughness = perceptual_roughness^2
-            
-            // from shaders, but a bit more relaxed
-            // #define MIN_PERCEPTUAL_ROUGHNESS 0.045
-            #define MIN_ROUGHNESS            (0.002025 * 0.33)
-
-            // map the lod to a linear_roughness,  here we're using ^2, but other mappings are possible.
-            // ==> lod = sqrt(linear_roughness)
-            const float linearRoughness = std::max( lod * lod, (float)MIN_ROUGHNESS );
-
-            assert( m_numMIPLevels > 2 );   // doesn't really make sense to pre-filter for only 1 or 2 levels
-            
-#if 0       // old approach was to do no pre-filter for level 0; new approach does some minimal pre-filtering for L0 to match min roughness
-            // no pre-filtering for level 0
-            if( level == 0 )
-                levelInfo.Samples.push_back( { {0, 0, 1}, 1, 0 } ); // vector up, weight 1, mip level 0
-            else
-#endif
+            const WorkItem & item = workItems[w];
+            const uint32 numSamples = levelNumSamples[item.Level];
+            vector<SampleInfo> & levelCandidates = candidates[item.Level];
+
+            if( filterType == vaIBLCubemapPreFilter::FilterType::ReflectionsRoughness )
             {
-                levelInfo.Samples.reserve( numSamples );
+                const float linearRoughness = LevelLinearRoughness( item.Level, numMIPLevels );
 
-                // index of the sample to use
-                // our goal is to use maxNumSamples for which NoL is > 0
-                // to achieve this, we might have to try more samples than
-                // maxNumSamples
-                for( size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++ ) 
+                for( uint32 sampleIndex = item.Begin; sampleIndex < item.End; sampleIndex++ )
                 {
+                    SampleInfo & out = levelCandidates[sampleIndex];
+                    out = { { 0, 0, 0 }, 0, 0 };
 
                     // get Hammersley distribution for the half-sphere
                     const vaVector2 u = Hammersley( uint32_t( sampleIndex ), 1.0f / (float)numSamples );
@@ -663,25 +717,13 @@ void vaIBLCubemapPreFilter::Init( uint32 outputBaseSize, uint32 outputMinSize, u
                     // Importance sampling GGX - Trowbridge-Reitz
                     const vaVector3 H = HemisphereImportanceSampleDggx( u, linearRoughness );
 
-        #if 0
-                    // This produces the same result that the code below using the the non-simplified
-                    // equation. This let's us see that N == V and that L = -reflect(V, H)
-                    // Keep this for reference.
-                    const float3 N = { 0, 0, 1 };
-                    const float3 V = N;
-                    const float3 L = 2 * dot( H, V ) * H - V;
-                    const float NoL = dot( N, L );
-                    const float NoH = dot( N, H );
-                    const float NoH2 = NoH * NoH;
-                    const float NoV = dot( N, V );
-        #else
+                    // N == V, L = -reflect(V, H)
                     const float NoH = H.z;
                     const float NoH2 = H.z * H.z;
                     const float NoL = 2 * NoH2 - 1;
                     const vaVector3 L( 2 * NoH * H.x, 2 * NoH * H.y, NoL );
-        #endif
 
-                    if( NoL > 0 ) 
+                    if( NoL > 0 )
                     {
                         const float pdf = DistributionGGX( NoH, linearRoughness ) / 4;
 
@@ -693,59 +735,187 @@ void vaIBLCubemapPreFilter::Init( uint32 outputBaseSize, uint32 outputMinSize, u
 
                         const float brdf_NoL = float( NoL );
 
-                        levelInfo.Samples.push_back( { L, brdf_NoL, mipLevel } );
+                        out = { L, brdf_NoL, mipLevel };
                     }
                 }
             }
-        }
-        else if( filterType == vaIBLCubemapPreFilter::FilterType::Irradiance )
-        {
-            levelInfo.Samples.reserve( numSamples );
-
-            // index of the sample to use
-            // our goal is to use maxNumSamples for which NoL is > 0
-            // to achieve this, we might have to try more samples than
-            // maxNumSamples
-            for( size_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++ )
+            else if( filterType == vaIBLCubemapPreFilter::FilterType::Irradiance )
             {
-                // get Hammersley distribution for the half-sphere
-                const vaVector2 u = Hammersley( uint32_t( sampleIndex ), 1.0f / (float)numSamples );
-                const vaVector3 L = hemisphereCosSample( u );
-                const vaVector3 N = { 0, 0, 1 };
-                const float NoL = vaVector3::Dot( N, L );
-
-                if( NoL > 0 ) 
+                for( uint32 sampleIndex = item.Begin; sampleIndex < item.End; sampleIndex++ )
                 {
-                    constexpr const double F_1_PI = 0.318309886183790671537767526745028724;
-                    float pdf = NoL * (float)F_1_PI;
+                    SampleInfo & out = levelCandidates[sampleIndex];
+                    out = { { 0, 0, 0 }, 0, 0 };
 
-                    constexpr float K = 4;
-                    const float omegaS = 1.0f / ( numSamples * pdf );
-                    const float l = float( log4( omegaS ) - log4( omegaP ) + log4( K ) );
-                    const float mipLevel = vaMath::Clamp( float( l ), 0.0f, (float)maxSampleMIPLevel );
+                    // get Hammersley distribution for the half-sphere
+                    const vaVector2 u = Hammersley( uint32_t( sampleIndex ), 1.0f / (float)numSamples );
+                    const vaVector3 L = hemisphereCosSample( u );
+                    const vaVector3 N = { 0, 0, 1 };
+                    const float NoL = vaVector3::Dot( N, L );
 
-                    levelInfo.Samples.push_back( { L, 1.0f, mipLevel } );
-                }
-                else
-                {
-                    assert( false );
+                    if( NoL > 0 )
+                    {
+                        constexpr const double F_1_PI = 0.318309886183790671537767526745028724;
+                        float pdf = NoL * (float)F_1_PI;
+
+                        constexpr float K = 4;
+                        const float omegaS = 1.0f / ( numSamples * pdf );
+                        const float l = float( log4( omegaS ) - log4( omegaP ) + log4( K ) );
+                        const float mipLevel = vaMath::Clamp( float( l ), 0.0f, (float)maxSampleMIPLevel );
+
+                        out = { L, 1.0f, mipLevel };
+                    }
+                    else
+                    {
+                        assert( false );
+                    }
                 }
             }
         }
-        else
-        {
-            assert( false ); // unsupported filter type?
-        }
+    } );
 
+    outLevelSamples.resize( numMIPLevels );
+    vaThreading::ParallelFor( (int)numMIPLevels, 1, [&]( int begin, int end )
+    {
+        for( int level = begin; level < end; level++ )
         {
-            float weightSum = 0;
-            for( auto& entry : levelInfo.Samples )
+            vector<SampleInfo> & samples = outLevelSamples[level];
+            samples.clear( );
+            samples.reserve( candidates[level].size( ) );
+            for( const SampleInfo & candidate : candidates[level] )
+                if( candidate.Weight > 0 )
+                    samples.push_back( candidate );
+
+            double weightSum = 0;
+            for( auto & entry : samples )
                 weightSum += entry.Weight;
-            for( auto& entry : levelInfo.Samples )
-                entry.Weight /= weightSum;
-            // we can sample the cubemap in any order, sort by the weight, it could improve fp precision
-            std::sort( levelInfo.Samples.begin( ), levelInfo.Samples.end( ), [ ]( SampleInfo const& lhs, SampleInfo const& rhs ) { return lhs.Weight < rhs.Weight; } );
+            for( auto & entry : samples )
+                entry.Weight = float( entry.Weight / weightSum );
+
+            // we can sample the cubemap in any order, sort by the weight, it could improve fp precision; ties are broken by the
+            // remaining members so that the order (and therefore the GPU summation order) is fully defined
+            std::sort( samples.begin( ), samples.end( ), [ ]( SampleInfo const& lhs, SampleInfo const& rhs )
+            {
+                if( lhs.Weight != rhs.Weight )      return lhs.Weight < rhs.Weight;
+                if( lhs.MIPLevel != rhs.MIPLevel )  return lhs.MIPLevel < rhs.MIPLevel;
+                if( lhs.L.x != rhs.L.x )            return lhs.L.x < rhs.L.x;
+                if( lhs.L.y != rhs.L.y )            return lhs.L.y < rhs.L.y;
+                return lhs.L.z < rhs.L.z;
+            } );
         }
+    } );
+}
+
+wstring vaIBLCubemapPreFilter::SampleTablesCachePath( const SampleTablesKey & key )
+{
+    // same place as the shader cache
+    return vaCore::GetExecutableDirectory( ) + L".cache\\" + vaStringTools::Format( L"ibl_prefilter_samples_%d_%d_%d_%d_%d.bin",
+        (int)key.Type, (int)key.OutputBaseSize, (int)key.NumMIPLevels, (int)key.SamplesPerTexel, (int)key.RoughnessMapping );
+}
+
+bool vaIBLCubemapPreFilter::LoadSampleTables( const wstring & filePath, const SampleTablesKey & key, vector<vector<SampleInfo>> & outLevelSamples )
+{
+    outLevelSamples.clear( );
+
+    if( !vaFileTools::FileExists( filePath ) )
+        return false;
+
+    vaFileStream inFile;
+    if( !inFile.Open( filePath, FileCreationMode::Open, FileAccessMode::Read ) )
+        return false;
+
+    int32 version = -1;
+    if( !inFile.ReadValue<int32>( version ) || version != c_sampleTablesCacheVersion )
+        return false;
+
+    SampleTablesKey fileKey;
+    if( !inFile.ReadValue<SampleTablesKey>( fileKey ) || !( fileKey == key ) )
+        return false;
+
+    int32 levelCount = 0;
+    if( !inFile.ReadValue<int32>( levelCount ) || levelCount != (int32)key.NumMIPLevels )
+        return false;
+
+    outLevelSamples.resize( levelCount );
+    for( int32 level = 0; level < levelCount; level++ )
+    {
+        if( !inFile.ReadValueVector<SampleInfo>( outLevelSamples[level] ) || outLevelSamples[level].size( ) == 0 )
+            { outLevelSamples.clear( ); return false; }
+    }
+
+    int32 terminator = 0;
+    if( !inFile.ReadValue<int32>( terminator ) || terminator != 0xFF )
+        { outLevelSamples.clear( ); return false; }
+
+    return true;
+}
+
+bool vaIBLCubemapPreFilter::SaveSampleTables( const wstring & filePath, const SampleTablesKey & key, const vector<vector<SampleInfo>> & levelSamples )
+{
+    wstring cacheDir;
+    vaFileTools::SplitPath( filePath, &cacheDir, nullptr, nullptr );
+    vaFileTools::EnsureDirectoryExists( cacheDir.c_str( ) );
+
+    vaFileStream outFile;
+    if( !outFile.Open( filePath, FileCreationMode::Create ) )
+        return false;
+
+    bool ok = true;
+    ok &= outFile.WriteValue<int32>( c_sampleTablesCacheVersion );
+    ok &= outFile.WriteValue<SampleTablesKey>( key );
+    ok &= outFile.WriteValue<int32>( (int32)levelSamples.size( ) );
+    for( const vector<SampleInfo> & samples : levelSamples )
+        ok &= outFile.WriteValueVector<SampleInfo>( samples );
+    ok &= outFile.WriteValue<int32>( 0xFF );            // EOF terminator
+    return ok;
+}
+
+void vaIBLCubemapPreFilter::Init( uint32 outputBaseSize, uint32 outputMinSize, uint32 samplesPerTexel, vaIBLCubemapPreFilter::FilterType filterType )
+{
+    assert( filterType != vaIBLCubemapPreFilter::FilterType::Unknown );
+
+    if( m_outputBaseSize == outputBaseSize && m_numSamples == samplesPerTexel && m_filterType == filterType )
+        return; // all good, no need to re-init
+
+    VA_LOG( "vaIBLCubemapPreFilter::Init( outputBaseSize == %d, samplesPerPixel == %d ) - this shouldn't be called every frame", outputBaseSize, samplesPerTexel );
+
+    Reset();
+
+    if( !vaMath::IsPowOf2( outputBaseSize ) )
+        { assert( false ); VA_ERROR( "vaIBLCubemapPreFilter::Init( outputBaseSize == %d, samplesPerPixel == %d ) - outputBaseSize must be power of 2", outputBaseSize, samplesPerTexel ); }
+    if( outputBaseSize < 4 || outputBaseSize > 4096 || samplesPerTexel < 1 || samplesPerTexel > 32768 )
+        { assert( false ); VA_ERROR( "vaIBLCubemapPreFilter::Init( outputBaseSize == %d, samplesPerPixel == %d ) - params out of range (outputBaseSize < 4 || outputBaseSize > 4096 || samplesPerTexel < 1 || samplesPerTexel > 32768)", outputBaseSize, samplesPerTexel ); }
+
+    m_filterType    = filterType;
+
+    m_outputBaseSize= outputBaseSize;
+    m_numSamples    = samplesPerTexel;
+
+    m_numMIPLevels = vaMath::FloorLog2( m_outputBaseSize / outputMinSize )+1;
+
+    m_levels.resize( m_numMIPLevels );
+
+    SampleTablesKey key;
+    key.OutputBaseSize  = m_outputBaseSize;
+    key.NumMIPLevels    = m_numMIPLevels;
+    key.SamplesPerTexel = m_numSamples;
+    key.Type            = m_filterType;
+
+    vector<vector<SampleInfo>> levelSamples;
+    const wstring cachePath = SampleTablesCachePath( key );
+    if( !LoadSampleTables( cachePath, key, levelSamples ) )
+    {
+        GenerateSampleTables( key, levelSamples );
+        if( !SaveSampleTables( cachePath, key, levelSamples ) )
+            VA_WARN( L"vaIBLCubemapPreFilter::Init - unable to save sample tables to '%s'", cachePath.c_str( ) );
+    }
+    assert( levelSamples.size( ) == m_numMIPLevels );
+
+    for( uint32 level = 0; level < m_numMIPLevels; level++ )
+    {
+        LevelInfo & levelInfo = m_levels[level];
+        levelInfo.Samples = std::move( levelSamples[level] );
+
+        levelInfo.Size = m_outputBaseSize >> level;
 
         std::vector<vaVector4> packedSamples;
         packedSamples.resize( levelInfo.Samples.size( ) );
@@ -837,6 +1007,104 @@ void vaIBLCubemapPreFilter::Reset( )
     m_levels.clear();
 }
 
+vaVector3 vaIBLCubemapPreFilter::PreFilterTexelReference( const std::function<vaVector3( const vaVector3 & )> & environment, const vaVector3 & N, FilterType filterType, float linearRoughness, int quadratureDim )
+{
+    // With N == V, the sample tables converge to  Integral( env(l) * NoL * D(h) ) / Integral( NoL * D(h) )  for the GGX lobe, with
+    // h = normalize( N + l ), and to  Integral( env(l) * NoL ) / Integral( NoL )  for irradiance; here those integrals are just
+    // evaluated over every texel of a cube.
+    double sum[3] = { 0, 0, 0 };
+    double weightSum = 0;
+    for( int face = 0; face < 6; face++ )
+        for( int uy = 0; uy < quadratureDim; uy++ )
+            for( int ux = 0; ux < quadratureDim; ux++ )
+            {
+                const float cx = ( ( ux + 0.5f ) / (float)quadratureDim ) * 2.0f - 1.0f;
+                const float cy = 1.0f - ( ( uy + 0.5f ) / (float)quadratureDim ) * 2.0f;
+                const float pz = 1.0f / std::sqrt( cx * cx + cy * cy + 1.0f );
+                vaVector3 l;
+                CubeFaceDirection( face, cx * pz, cy * pz, pz, l.x, l.y, l.z );
+
+                const float NoL = vaVector3::Dot( N, l );
+                if( NoL <= 0 )
+                    continue;
+
+                double weight = NoL * CubeTexelSolidAngle( quadratureDim, ux, uy );
+                if( filterType == FilterType::ReflectionsRoughness )
+                {
+                    const float NoH = vaVector3::Dot( N, ( N + l ).Normalized( ) );
+                    weight *= DistributionGGX( NoH, linearRoughness );
+                }
+
+                const vaVector3 color = environment( l );
+                sum[0] += color.x * weight; sum[1] += color.y * weight; sum[2] += color.z * weight;
+                weightSum += weight;
+            }
+    if( weightSum <= 0 )
+        return { 0, 0, 0 };
+    return vaVector3( float( sum[0] / weightSum ), float( sum[1] / weightSum ), float( sum[2] / weightSum ) );
+}
+
+vaVector3 vaIBLCubemapPreFilter::PreFilterTexelFromSamples( const std::function<vaVector3( const vaVector3 & )> & environment, const vaVector3 & N, const vector<SampleInfo> & samples )
+{
+    // center the cone around the normal (handle case of normal close to up) - same as CSCubePreFilter
+    const vaVector3 up = ( std::abs( N.z ) < 0.999f ) ? vaVector3( 0, 0, 1 ) : vaVector3( 1, 0, 0 );
+    const vaVector3 R0 = vaVector3::Cross( up, N ).Normalized( );
+    const vaVector3 R1 = vaVector3::Cross( N, R0 );
+
+    vaVector3 color = { 0, 0, 0 };
+    for( const SampleInfo & sample : samples )
+        color += environment( R0 * sample.L.x + R1 * sample.L.y + N * sample.L.z ) * sample.Weight;
+    return color;
+}
+
+bool vaIBLCubemapPreFilter::ValidateSampleTables( string * outInfo ) const
+{
+    if( m_levels.size( ) == 0 )
+        return vaSelfTest::Fail( outInfo, "not initialized" );
+
+    // smooth, non-negative and with enough structure for the lobe width to matter
+    const vaVector3 lobeDir = vaVector3( 0.3f, 0.5f, -0.8f ).Normalized( );
+    auto environment = [ &lobeDir ]( const vaVector3 & d ) -> vaVector3
+    {
+        const float lobe = 4.0f * std::exp( 6.0f * ( vaVector3::Dot( d, lobeDir ) - 1.0f ) );
+        return vaVector3( 1.0f + 0.5f * d.x + lobe, 0.7f + 0.3f * d.y * d.z, 0.5f + 0.4f * d.z * d.z + 0.5f * lobe );
+    };
+    const vaVector3 directions[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, 
+        vaVector3( 1, 1, 1 ).Normalized( ), vaVector3( -1, 2, -3 ).Normalized( ), lobeDir };
+
+    const uint32 maxSampleMIPLevel = vaMath::FloorLog2( m_outputBaseSize );
+
+    for( uint32 level = 0; level < m_numMIPLevels; level++ )
+    {
+        const vector<SampleInfo> & samples = m_levels[level].Samples;
+        if( samples.size( ) == 0 )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "level %d: no samples", level ) );
+
+        double weightSum = 0;
+        for( const SampleInfo & sample : samples )
+        {
+            if( !( sample.Weight > 0 ) || sample.L.z <= 0 || !vaMath::NearEqual( sample.L.Length( ), 1.0f, 1e-4f ) || sample.MIPLevel < 0 || sample.MIPLevel > (float)maxSampleMIPLevel )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "level %d: invalid sample (L = %f, %f, %f, weight %f, MIP %f)", level, sample.L.x, sample.L.y, sample.L.z, sample.Weight, sample.MIPLevel ) );
+            weightSum += sample.Weight;
+        }
+        // normalized weights - a constant environment is reproduced exactly, no energy gained or lost
+        if( std::abs( weightSum - 1.0 ) > 1e-4 )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "level %d: weights sum to %f, should be 1", level, (float)weightSum ) );
+
+        const float linearRoughness = LevelLinearRoughness( level, m_numMIPLevels );
+        for( const vaVector3 & N : directions )
+        {
+            const vaVector3 expected    = PreFilterTexelReference( environment, N, m_filterType, linearRoughness );
+            const vaVector3 actual      = PreFilterTexelFromSamples( environment, N, samples );
+            if( ( actual - expected ).Length( ) > 0.02f * expected.Length( ) )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "level %d (linear roughness %.3f), direction (%.3f, %.3f, %.3f): reference (%f, %f, %f), from samples (%f, %f, %f)", level, linearRoughness,
+                    N.x, N.y, N.z, expected.x, expected.y, expected.z, actual.x, actual.y, actual.z ) );
+        }
+    }
+
+    return vaSelfTest::Pass( outInfo, vaStringTools::Format( "all OK (%d levels)", m_numMIPLevels ) );
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -951,6 +1219,652 @@ std::array<vaVector3, 9> vaIrradianceSHCalculator::GetSH( vaRenderDeviceContext&
     return SH;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CPU path - mirrors CSComputeSH / CSPostProcessSH in vaIBL.hlsl (which in turn come from filament's CubemapSH.cpp)
+
+namespace
+{
+    static_assert( vaIrradianceSHCalculator::c_numSHBands == 3, "CPU SH path is only written for 3 bands, same as the shaders" );
+
+    const float c_SHHDRClampMax     = 64512.0f;     // see CubeHDRClamp
+    const float c_SHSqrtPI          = 1.7724538509f;
+    const float c_SHSqrt3           = 1.7320508076f;
+    const float c_SHSqrt5           = 2.2360679775f;
+    const float c_SHSqrt15          = 3.8729833462f;
+    const float c_SHSqrt2           = 1.4142135624f;
+    const float c_SHSqrt1_2         = 0.7071067812f;
+
+    // Polynomial form coefficients ("Stupid Spherical Harmonics (SH)" by Peter-Pike Sloan), see PreprocessSHForShader / WindowSH_SHMin
+    const float c_SHPolyA[9] = {
+                   1.0f / ( 2.0f * c_SHSqrtPI ),    // 0: 0  0
+            -c_SHSqrt3  / ( 2.0f * c_SHSqrtPI ),    // 1: 1 -1
+             c_SHSqrt3  / ( 2.0f * c_SHSqrtPI ),    // 2: 1  0
+            -c_SHSqrt3  / ( 2.0f * c_SHSqrtPI ),    // 3: 1  1
+             c_SHSqrt15 / ( 2.0f * c_SHSqrtPI ),    // 4: 2 -2
+            -c_SHSqrt15 / ( 2.0f * c_SHSqrtPI ),    // 5: 2 -1
+             c_SHSqrt5  / ( 4.0f * c_SHSqrtPI ),    // 6: 2  0
+            -c_SHSqrt15 / ( 2.0f * c_SHSqrtPI ),    // 7: 2  1
+             c_SHSqrt15 / ( 4.0f * c_SHSqrtPI )     // 8: 2  2
+    };
+
+    inline int SHIndex( int m, int l )
+    {
+        return l * ( l + 1 ) + m;
+    }
+
+    // ComputeShBasis unrolled for 3 bands: non-normalized bases (the K scaling is applied in the post-process)
+    inline void SHBasis( float x, float y, float z, float outB[9] )
+    {
+        outB[0] = 1.0f;
+        outB[1] = -y;
+        outB[2] = z;
+        outB[3] = -x;
+        outB[4] = 6.0f * x * y;
+        outB[5] = -3.0f * y * z;
+        outB[6] = 0.5f * ( 3.0f * z * z - 1.0f );
+        outB[7] = -3.0f * x * z;
+        outB[8] = 3.0f * ( x * x - y * y );
+    }
+
+    inline float SHHDRClamp( float v )
+    {
+        return ( v > 0.0f ) ? ( ( v < c_SHHDRClampMax ) ? ( v ) : ( c_SHHDRClampMax ) ) : ( 0.0f );    // also takes care of NaNs
+    }
+
+    // Accumulates one row of one face into outAcc[coeff*3+channel]; cxs are face local x coords of texel centers, solidAngles for this row
+    void SHProjectRow( const vaIrradianceSHCalculator::CPUCubeFaces & cube, int rowPitch, int face, int uy, const float * cxs, const float * solidAngles, double outAcc[27] )
+    {
+        const int dim       = cube.Dim;
+        const int stride    = cube.TexelStride;
+        const float * src   = reinterpret_cast<const float *>( reinterpret_cast<const uint8 *>( cube.Faces[face] ) + (size_t)uy * rowPitch );
+        const float cy      = 1.0f - ( ( uy + 0.5f ) / (float)dim ) * 2.0f;
+
+        float acc[27];
+        for( int i = 0; i < 27; i++ )
+            acc[i] = 0.0f;
+
+        int ux = 0;
+
+#ifdef USE_SSE_IBL_SH
+        {
+            const __m128 zero       = _mm_setzero_ps( );
+            const __m128 one        = _mm_set1_ps( 1.0f );
+            const __m128 half       = _mm_set1_ps( 0.5f );
+            const __m128 three      = _mm_set1_ps( 3.0f );
+            const __m128 six        = _mm_set1_ps( 6.0f );
+            const __m128 signMask   = _mm_set1_ps( -0.0f );
+            const __m128 hdrMax     = _mm_set1_ps( c_SHHDRClampMax );
+            const __m128 cyv        = _mm_set1_ps( cy );
+            const __m128 cySqP1     = _mm_set1_ps( cy * cy + 1.0f );
+
+            __m128 vacc[27];
+            for( int i = 0; i < 27; i++ )
+                vacc[i] = zero;
+
+            for( ; ux + 4 <= dim; ux += 4 )
+            {
+                const __m128 cx     = _mm_loadu_ps( cxs + ux );
+                const __m128 pz     = _mm_div_ps( one, _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( cx, cx ), cySqP1 ) ) );
+                const __m128 px     = _mm_mul_ps( cx, pz );
+                const __m128 py     = _mm_mul_ps( cyv, pz );
+                __m128 x, y, z;
+                switch( face )
+                {
+                case 0:  x = pz;                            y = py;                             z = _mm_xor_ps( px, signMask ); break;
+                case 1:  x = _mm_xor_ps( pz, signMask );    y = py;                             z = px;                         break;
+                case 2:  x = px;                            y = pz;                             z = _mm_xor_ps( py, signMask ); break;
+                case 3:  x = px;                            y = _mm_xor_ps( pz, signMask );     z = py;                         break;
+                case 4:  x = px;                            y = py;                             z = pz;                         break;
+                default: x = _mm_xor_ps( px, signMask );    y = py;                             z = _mm_xor_ps( pz, signMask ); break;
+                }
+
+                const float * t0 = src + ( ux + 0 ) * stride;
+                const float * t1 = src + ( ux + 1 ) * stride;
+                const float * t2 = src + ( ux + 2 ) * stride;
+                const float * t3 = src + ( ux + 3 ) * stride;
+                // _mm_max_ps returns the second operand if the first one is a NaN, so NaNs end up as 0 like in SHHDRClamp
+                const __m128 r = _mm_min_ps( _mm_max_ps( _mm_set_ps( t3[0], t2[0], t1[0], t0[0] ), zero ), hdrMax );
+                const __m128 g = _mm_min_ps( _mm_max_ps( _mm_set_ps( t3[1], t2[1], t1[1], t0[1] ), zero ), hdrMax );
+                const __m128 b = _mm_min_ps( _mm_max_ps( _mm_set_ps( t3[2], t2[2], t1[2], t0[2] ), zero ), hdrMax );
+
+                const __m128 sa = _mm_loadu_ps( solidAngles + ux );
+
+                // same as SHBasis, premultiplied by the solid angle
+                __m128 w[9];
+                w[0] = sa;
+                w[1] = _mm_xor_ps( _mm_mul_ps( y, sa ), signMask );
+                w[2] = _mm_mul_ps( z, sa );
+                w[3] = _mm_xor_ps( _mm_mul_ps( x, sa ), signMask );
+                w[4] = _mm_mul_ps( _mm_mul_ps( six, _mm_mul_ps( x, y ) ), sa );
+                w[5] = _mm_xor_ps( _mm_mul_ps( _mm_mul_ps( three, _mm_mul_ps( y, z ) ), sa ), signMask );
+                w[6] = _mm_mul_ps( _mm_mul_ps( half, _mm_sub_ps( _mm_mul_ps( three, _mm_mul_ps( z, z ) ), one ) ), sa );
+                w[7] = _mm_xor_ps( _mm_mul_ps( _mm_mul_ps( three, _mm_mul_ps( x, z ) ), sa ), signMask );
+                w[8] = _mm_mul_ps( _mm_mul_ps( three, _mm_sub_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ) ), sa );
+
+                for( int i = 0; i < 9; i++ )
+                {
+                    vacc[i * 3 + 0] = _mm_add_ps( vacc[i * 3 + 0], _mm_mul_ps( r, w[i] ) );
+                    vacc[i * 3 + 1] = _mm_add_ps( vacc[i * 3 + 1], _mm_mul_ps( g, w[i] ) );
+                    vacc[i * 3 + 2] = _mm_add_ps( vacc[i * 3 + 2], _mm_mul_ps( b, w[i] ) );
+                }
+            }
+
+            for( int i = 0; i < 27; i++ )
+            {
+                alignas( 16 ) float lanes[4];
+                _mm_store_ps( lanes, vacc[i] );
+                acc[i] = ( lanes[0] + lanes[1] ) + ( lanes[2] + lanes[3] );
+            }
+        }
+#endif
+
+        // remainder (or everything if no SSE)
+        for( ; ux < dim; ux++ )
+        {
+            const float cx = cxs[ux];
+            const float pz = 1.0f / std::sqrt( cx * cx + cy * cy + 1.0f );
+            float x, y, z;
+            CubeFaceDirection( face, cx * pz, cy * pz, pz, x, y, z );
+
+            const float * texel = src + ux * stride;
+            const float r = SHHDRClamp( texel[0] );
+            const float g = SHHDRClamp( texel[1] );
+            const float b = SHHDRClamp( texel[2] );
+
+            float basis[9];
+            SHBasis( x, y, z, basis );
+            for( int i = 0; i < 9; i++ )
+            {
+                const float w = basis[i] * solidAngles[ux];
+                acc[i * 3 + 0] += r * w;
+                acc[i * 3 + 1] += g * w;
+                acc[i * 3 + 2] += b * w;
+            }
+        }
+
+        for( int i = 0; i < 27; i++ )
+            outAcc[i] = acc[i];
+    }
+
+    // returns n! / d!
+    float SHFactorial( int n, int d )
+    {
+        d = std::max( 1, d );
+        n = std::max( 1, n );
+        float r = 1.0f;
+        if( n > d )
+        {
+            for( ; n > d; n-- )
+                r *= n;
+        }
+        else if( d > n )
+        {
+            for( ; d > n; d-- )
+                r *= d;
+            r = 1.0f / r;
+        }
+        return r;
+    }
+
+    // sqrt((2*l + 1) / 4*pi) * sqrt( (l-|m|)! / (l+|m|)! )
+    float SHKml( int m, int l )
+    {
+        m = ( m < 0 ) ? ( -m ) : ( m );
+        const float K = ( 2 * l + 1 ) * SHFactorial( l - m, l + m );
+        return std::sqrt( K ) * ( 1.0f / ( 2.0f * c_SHSqrtPI ) );
+    }
+
+    // < cos(theta) > SH coefficients pre-multiplied by 1 / K(0,l)
+    float SHTruncatedCos( int l )
+    {
+        if( l == 0 )
+            return VA_PIf;
+        else if( l == 1 )
+            return 2.0f * VA_PIf / 3.0f;
+        else if( l & 1 )
+            return 0.0f;
+        const int l_2 = l / 2;
+        float A0 = ( ( l_2 & 1 ) ? 1.0f : -1.0f ) / (float)( ( l + 2 ) * ( l - 1 ) );
+        float A1 = SHFactorial( l, l_2 ) / ( SHFactorial( l_2, 1 ) * (float)( 1 << l ) );
+        return 2.0f * VA_PIf * A0 * A1;
+    }
+
+    // Ki() with the truncated cos (irradiance) scaling applied, same as at the start of CSPostProcessSH
+    void SHIrradianceScalingK( float outK[9] )
+    {
+        for( int l = 0; l < vaIrradianceSHCalculator::c_numSHBands; l++ )
+        {
+            const float truncatedCosSh = SHTruncatedCos( l );
+            outK[SHIndex( 0, l )] = SHKml( 0, l ) * truncatedCosSh;
+            for( int m = 1; m <= l; m++ )
+                outK[SHIndex( -m, l )] = outK[SHIndex( m, l )] = c_SHSqrt2 * SHKml( m, l ) * truncatedCosSh;
+        }
+    }
+
+    float SHSincWindow( int l, float w )
+    {
+        if( l == 0 )
+            return 1.0f;
+        else if( (float)l >= w )
+            return 0.0f;
+        float x = ( VA_PIf * l ) / w;
+        x = std::sin( x ) / ( x + 0.000000001f );
+        return x * x * x * x;
+    }
+
+    void SHApplyWindow( float sh[9], float cutoff )
+    {
+        for( int l = 0; l < vaIrradianceSHCalculator::c_numSHBands; l++ )
+        {
+            const float w = SHSincWindow( l, cutoff );
+            sh[SHIndex( 0, l )] *= w;
+            for( int m = 1; m <= l; m++ )
+            {
+                sh[SHIndex( -m, l )] *= w;
+                sh[SHIndex( m, l )] *= w;
+            }
+        }
+    }
+
+    void SHMultiply3( float result[3], const float M[3][3], const float x[3] )
+    {
+        for( int j = 0; j < 3; j++ )
+            result[j] = M[0][j] * x[0] + M[1][j] * x[1] + M[2][j] * x[2];
+    }
+
+    void SHMultiply5( float result[5], const float M[5][5], const float x[5] )
+    {
+        for( int j = 0; j < 5; j++ )
+            result[j] = M[0][j] * x[0] + M[1][j] * x[1] + M[2][j] * x[2] + M[3][j] * x[3] + M[4][j] * x[4];
+    }
+
+    void SHProject5( float result[5], const float s[3] )
+    {
+        result[0] = ( s[1] * s[0] );
+        result[1] = -( s[1] * s[2] );
+        result[2] = 1 / ( 2 * c_SHSqrt3 ) * ( ( 3 * s[2] * s[2] - 1 ) );
+        result[3] = -( s[2] * s[0] );
+        result[4] = 0.5f * ( ( s[0] * s[0] - s[1] * s[1] ) );
+    }
+
+    // see WindowSH_RotateSh3Bands (and RotateSphericalHarmonicBand1/2) for comments
+    void SHRotate3Bands( float sh[9], const float M[3][3] )
+    {
+        const float invA1TimesK[3][3] = {
+                {  0, -1,  0 },
+                {  0,  0,  1 },
+                { -1,  0,  0 } };
+        const float R1OverK[3][3] = {
+                { -M[0][1], M[0][2], -M[0][0] },
+                { -M[1][1], M[1][2], -M[1][0] },
+                { -M[2][1], M[2][2], -M[2][0] } };
+        const float band1[3] = { sh[1], sh[2], sh[3] };
+        float temp1[3], b1[3];
+        SHMultiply3( temp1, invA1TimesK, band1 );
+        SHMultiply3( b1, R1OverK, temp1 );
+
+        const float n = c_SHSqrt1_2;
+        const float invATimesK[5][5] = {
+                {    0,        1,   2,   0,  0 },
+                {   -1,        0,   0,   0, -2 },
+                {    0, c_SHSqrt3,  0,   0,  0 },
+                {    1,        1,   0,  -2,  0 },
+                {    2,        1,   0,   0,  0 } };
+        const float band2[5] = { sh[4], sh[5], sh[6], sh[7], sh[8] };
+        float temp2[5], b2[5];
+        SHMultiply5( temp2, invATimesK, band2 );
+
+        float ROverK[5][5];
+        const float k0[3] = { n * ( M[0][0] + M[1][0] ), n * ( M[0][1] + M[1][1] ), n * ( M[0][2] + M[1][2] ) };
+        const float k1[3] = { n * ( M[0][0] + M[2][0] ), n * ( M[0][1] + M[2][1] ), n * ( M[0][2] + M[2][2] ) };
+        const float k2[3] = { n * ( M[1][0] + M[2][0] ), n * ( M[1][1] + M[2][1] ), n * ( M[1][2] + M[2][2] ) };
+        SHProject5( ROverK[0], M[0] );
+        SHProject5( ROverK[1], M[2] );
+        SHProject5( ROverK[2], k0 );
+        SHProject5( ROverK[3], k1 );
+        SHProject5( ROverK[4], k2 );
+        SHMultiply5( b2, ROverK, temp2 );
+
+        sh[1] = b1[0]; sh[2] = b1[1]; sh[3] = b1[2];
+        sh[4] = b2[0]; sh[5] = b2[1]; sh[6] = b2[2]; sh[7] = b2[3]; sh[8] = b2[4];
+    }
+
+    inline float SHWindowFunc( float a, float b, float c, float d, float x )
+    {
+        return ( a * x * x + b * x + c ) + ( d * x * std::sqrt( 1 - x * x ) );
+    }
+
+    inline float SHWindowIncrement( float a, float b, float d, float x )
+    {
+        return ( x * x - 1 ) * ( d - 2 * d * x * x + ( b + 2 * a * x ) * std::sqrt( 1 - x * x ) )
+            / ( 3 * d * x - 2 * d * x * x * x - 2 * a * std::pow( std::max( 0.0f, 1 - x * x ), 1.5f ) );
+    }
+
+    // Minimum of the reconstructed function - see WindowSH_SHMin and "Deringing Spherical Harmonics" by Peter-Pike Sloan
+    float SHMin( const float shIn[9] )
+    {
+        const float * A = c_SHPolyA;
+        float f[9];
+        for( int i = 0; i < 9; i++ )
+            f[i] = shIn[i];
+
+        // rotate to align Z with the optimal linear direction (M is the transposed { x_axis, y_axis, -z_axis } as in the shader)
+        const vaVector3 dir     = vaVector3( -f[3], -f[1], f[2] ).Normalized( );
+        const vaVector3 zAxis   = -dir;
+        const vaVector3 xAxis   = vaVector3::Cross( zAxis, vaVector3( 0, 1, 0 ) ).Normalized( );
+        const vaVector3 yAxis   = vaVector3::Cross( xAxis, zAxis );
+        const float M[3][3] = {
+                { xAxis.x, yAxis.x, -zAxis.x },
+                { xAxis.y, yAxis.y, -zAxis.y },
+                { xAxis.z, yAxis.z, -zAxis.z } };
+        SHRotate3Bands( f, M );
+
+        // |m| = 2 folded into the ZH min
+        const float m2max = A[8] * std::sqrt( f[8] * f[8] + f[4] * f[4] );
+
+        const float a = 3 * A[6] * f[6] + m2max;
+        const float b = A[2] * f[2];
+        const float c = A[0] * f[0] - A[6] * f[6] - m2max;
+
+        const float zmin    = -b / ( 2.0f * a );
+        const float m0min_z = a * zmin * zmin + b * zmin + c;
+        const float m0min_b = std::min( a + b + c, a - b + c );
+
+        const float m0min = ( a > 0 && zmin >= -1 && zmin <= 1 ) ? m0min_z : m0min_b;
+
+        // l = 2, |m| = 1
+        const float d = A[4] * std::sqrt( f[5] * f[5] + f[7] * f[7] );
+
+        float minimum = m0min - 0.5f * d;
+        if( minimum < 0 )
+        {
+            // Newton's method
+            float dz;
+            float z = -c_SHSqrt1_2;
+            int loopCount = 0;
+            do
+            {
+                minimum = SHWindowFunc( a, b, c, d, z );
+                dz = SHWindowIncrement( a, b, d, z );
+                z = z - dz;
+                loopCount++;
+            } while( ( std::abs( z ) <= 1 ) && ( std::abs( dz ) > 1e-5f ) && ( loopCount < 16 ) );
+
+            if( std::abs( z ) > 1 )
+                minimum = std::min( SHWindowFunc( a, b, c, d, 1 ), SHWindowFunc( a, b, c, d, -1 ) );
+        }
+        return minimum;
+    }
+}
+
+bool vaIrradianceSHCalculator::ProjectSHCPU( const CPUCubeFaces & cube, std::array<vaVector3, 9> & outRawSH )
+{
+    VA_TRACE_CPU_SCOPE( IrradianceSHProjectCPU );
+
+    for( int i = 0; i < 9; i++ )
+        outRawSH[i] = vaVector3( 0, 0, 0 );
+
+    const int dim = cube.Dim;
+    if( dim <= 0 || ( cube.TexelStride != 3 && cube.TexelStride != 4 ) )
+        { assert( false ); return false; }
+    for( int face = 0; face < 6; face++ )
+        if( cube.Faces[face] == nullptr )
+            { assert( false ); return false; }
+    const int rowPitch = ( cube.RowPitch != 0 ) ? ( cube.RowPitch ) : ( dim * cube.TexelStride * (int)sizeof( float ) );
+
+    // face local x for each column and the solid angle of each texel are the same for all 6 faces
+    vector<float> cxs( dim );
+    for( int ux = 0; ux < dim; ux++ )
+        cxs[ux] = ( ( ux + 0.5f ) / (float)dim ) * 2.0f - 1.0f;
+    vector<float> solidAngles( (size_t)dim * dim );
+    vaThreading::ParallelFor( dim, 16, [&]( int begin, int end )
+    {
+        for( int uy = begin; uy < end; uy++ )
+            for( int ux = 0; ux < dim; ux++ )
+                solidAngles[(size_t)uy * dim + ux] = CubeTexelSolidAngle( dim, ux, uy );
+    } );
+
+    // every row gets its own partial sum and they're all added up in order at the end, so the result doesn't depend on threading
+    const int rowCount = 6 * dim;
+    vector<double> rowSums( (size_t)rowCount * 27 );
+    vaThreading::ParallelFor( rowCount, 8, [&]( int begin, int end )
+    {
+        for( int row = begin; row < end; row++ )
+        {
+            const int face = row / dim;
+            const int uy   = row % dim;
+            SHProjectRow( cube, rowPitch, face, uy, cxs.data( ), &solidAngles[(size_t)uy * dim], &rowSums[(size_t)row * 27] );
+        }
+    } );
+
+    double total[27] = { };
+    for( int row = 0; row < rowCount; row++ )
+        for( int i = 0; i < 27; i++ )
+            total[i] += rowSums[(size_t)row * 27 + i];
+
+    for( int i = 0; i < 9; i++ )
+        outRawSH[i] = vaVector3( (float)total[i * 3 + 0], (float)total[i * 3 + 1], (float)total[i * 3 + 2] );
+    return true;
+}
+
+void vaIrradianceSHCalculator::PostProcessSHCPU( std::array<vaVector3, 9> & inOutSH, bool windowing )
+{
+    float scalingK[9];
+    SHIrradianceScalingK( scalingK );
+
+    // find a cut-off band that works for each channel and use the smallest one for all (same as CSPostProcessSH)
+    float cutoff = (float)c_numSHBands * 4 + 1;
+    if( windowing )
+    {
+        float channelCutoff[3];
+        for( int channel = 0; channel < 3; channel++ )
+        {
+            float SH[9];
+            for( int i = 0; i < 9; i++ )
+                SH[i] = inOutSH[i][channel] * scalingK[i];
+
+            float l = (float)c_numSHBands;
+            float r = cutoff;
+            for( int i = 0; i < 16 && l + 0.1f < r; i++ )
+            {
+                float m = 0.5f * ( l + r );
+                float SHTemp[9];
+                for( int j = 0; j < 9; j++ )
+                    SHTemp[j] = SH[j];
+                SHApplyWindow( SHTemp, m );
+                if( SHMin( SHTemp ) < 0 )
+                    r = m;
+                else
+                    l = m;
+            }
+            channelCutoff[channel] = std::min( cutoff, l );
+        }
+        cutoff = std::min( std::min( channelCutoff[0], channelCutoff[1] ), channelCutoff[2] );
+    }
+
+    for( int channel = 0; channel < 3; channel++ )
+    {
+        float SH[9];
+        for( int i = 0; i < 9; i++ )
+            SH[i] = inOutSH[i][channel] * scalingK[i];
+
+        if( windowing )
+            SHApplyWindow( SH, cutoff );
+
+        // PreprocessSHForShader: polynomial form factors and the lambertian 1/pi
+        for( int i = 0; i < 9; i++ )
+            inOutSH[i][channel] = SH[i] * ( c_SHPolyA[i] * ( 1.0f / VA_PIf ) );
+    }
+}
+
+bool vaIrradianceSHCalculator::ComputeSHCPU( const CPUCubeFaces & cube, std::array<vaVector3, 9> & outSH, bool windowing )
+{
+    if( !ProjectSHCPU( cube, outSH ) )
+        return false;
+    PostProcessSHCPU( outSH, windowing );
+    return true;
+}
+
+vaVector3 vaIrradianceSHCalculator::EvaluateSH( const std::array<vaVector3, 9> & SH, const vaVector3 & n )
+{
+    vaVector3 ret = SH[0]
+        + SH[1] * n.y
+        + SH[2] * n.z
+        + SH[3] * n.x
+        + SH[4] * ( n.y * n.x )
+        + SH[5] * ( n.y * n.z )
+        + SH[6] * ( 3.0f * n.z * n.z - 1.0f )
+        + SH[7] * ( n.z * n.x )
+        + SH[8] * ( n.x * n.x - n.y * n.y );
+    return vaVector3::ComponentMax( ret, vaVector3( 0, 0, 0 ) );
+}
+
+bool vaIrradianceSHCalculator::ValidateCPU( string * outInfo )
+{
+    // Environments of the form L(s) = Constant + Gradient * dot( s, Dir ) (per channel) - their irradiance / PI is exactly
+    // Constant + 2/3 * Gradient * dot( n, Dir ), which the 3-band SH represents without error. Windowing attenuates band 1 so
+    // it is only enabled for the constant case.
+    struct Environment
+    {
+        const char *    Name;
+        vaVector3       Constant;
+        vaVector3       Gradient;
+        vaVector3       Dir;
+        bool            Windowing;
+    };
+    const Environment environments[] = {
+        { "constant",           vaVector3( 0.25f, 0.5f, 1.0f ),     vaVector3( 0.0f, 0.0f, 0.0f ),      vaVector3( 0, 0, 1 ),                       true  },
+        { "constant, bright",   vaVector3( 900.0f, 20.0f, 0.0f ),   vaVector3( 0.0f, 0.0f, 0.0f ),      vaVector3( 0, 0, 1 ),                       true  },
+        { "gradient +X",        vaVector3( 1.0f, 1.0f, 1.0f ),      vaVector3( 0.75f, 0.5f, 0.0f ),     vaVector3( 1, 0, 0 ),                       false },
+        { "gradient -Y",        vaVector3( 2.0f, 1.0f, 0.5f ),      vaVector3( 1.5f, 0.25f, 0.5f ),     vaVector3( 0, -1, 0 ),                      false },
+        { "gradient +Z",        vaVector3( 1.0f, 2.0f, 3.0f ),      vaVector3( 1.0f, 2.0f, 3.0f ),      vaVector3( 0, 0, 1 ),                       false },
+        { "gradient diagonal",  vaVector3( 1.0f, 1.0f, 1.0f ),      vaVector3( 0.5f, 0.9f, 0.1f ),      vaVector3( 1, -2, 3 ).Normalized( ),        false },
+    };
+
+    const int dim = 64;
+    vector<float> faceData[6];
+    CPUCubeFaces cube;
+    cube.Dim            = dim;
+    cube.TexelStride    = 4;
+    for( int face = 0; face < 6; face++ )
+    {
+        faceData[face].resize( (size_t)dim * dim * 4 );
+        cube.Faces[face] = faceData[face].data( );
+    }
+
+    // a constant 1 environment projects to the total solid angle
+    for( int face = 0; face < 6; face++ )
+        std::fill( faceData[face].begin( ), faceData[face].end( ), 1.0f );
+    std::array<vaVector3, 9> SH;
+    ProjectSHCPU( cube, SH );
+    if( !vaMath::NearEqual( SH[0].x, 4.0f * VA_PIf, 1e-3f ) )
+        return vaSelfTest::Fail( outInfo, vaStringTools::Format( "total solid angle is %f, expected %f", SH[0].x, 4.0f * VA_PIf ) );
+
+    auto fillCube = [ & ]( const std::function<vaVector3( const vaVector3 & )> & radiance )
+    {
+        for( int face = 0; face < 6; face++ )
+            for( int uy = 0; uy < dim; uy++ )
+                for( int ux = 0; ux < dim; ux++ )
+                {
+                    const float cx = ( ( ux + 0.5f ) / (float)dim ) * 2.0f - 1.0f;
+                    const float cy = 1.0f - ( ( uy + 0.5f ) / (float)dim ) * 2.0f;
+                    const float pz = 1.0f / std::sqrt( cx * cx + cy * cy + 1.0f );
+                    vaVector3 s;
+                    CubeFaceDirection( face, cx * pz, cy * pz, pz, s.x, s.y, s.z );
+                    const vaVector3 color = radiance( s );
+                    float * texel = &faceData[face][( (size_t)uy * dim + ux ) * 4];
+                    texel[0] = color.x; texel[1] = color.y; texel[2] = color.z; texel[3] = 1.0f;
+                }
+    };
+
+    // check on a spread of directions (axes, edge midpoints and cube corners)
+    auto testNormal = [ ]( int i ) { return vaVector3( (float)( i % 3 - 1 ), (float)( ( i / 3 ) % 3 - 1 ), (float)( i / 9 - 1 ) ).Normalized( ); };
+
+    for( const Environment & env : environments )
+    {
+        fillCube( [ &env ]( const vaVector3 & s ) { return env.Constant + env.Gradient * vaVector3::Dot( s, env.Dir ); } );
+
+        ComputeSHCPU( cube, SH, env.Windowing );
+
+        for( int i = 0; i < 27; i++ )
+        {
+            if( i == 13 )
+                continue;   // (0, 0, 0)
+            const vaVector3 n = testNormal( i );
+
+            const vaVector3 expected    = env.Constant + env.Gradient * ( 2.0f / 3.0f * vaVector3::Dot( n, env.Dir ) );
+            const vaVector3 actual      = EvaluateSH( SH, n );
+            const float tolerance       = 2e-3f * vaMath::Max( 1.0f, expected.Length( ) );
+            if( ( actual - expected ).Length( ) > tolerance )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "environment '%s', normal (%.3f, %.3f, %.3f): expected (%f, %f, %f), got (%f, %f, %f)", env.Name,
+                    n.x, n.y, n.z, expected.x, expected.y, expected.z, actual.x, actual.y, actual.z ) );
+        }
+    }
+
+    // Windowed, directional: a clamped cosine lobe L(s) = Color * max( 0, dot( s, Dir ) ). Its 3-band irradiance / PI along the lobe axis
+    // is Color * ( 1/4 + w1 * 1/3 * mu + w2 * 5/64 * P2( mu ) ), mu = dot( n, Dir ), which dips below zero at mu = -1 for w1 = w2 = 1
+    // so the windowing has to kick in. w1 is recovered from the result and must give the cutoff that w2 was computed with; the result
+    // must be non-negative and the window no stronger than needed (a slightly larger cutoff has to ring again).
+    {
+        const vaVector3 color   = vaVector3( 1.0f, 0.5f, 2.0f );
+        const vaVector3 dir     = vaVector3( 1, -2, 3 ).Normalized( );
+        const float b0 = 1.0f / 4.0f, b1 = 1.0f / 3.0f, b2 = 5.0f / 64.0f;
+
+        fillCube( [ & ]( const vaVector3 & s ) { return color * vaMath::Max( 0.0f, vaVector3::Dot( s, dir ) ); } );
+        ComputeSHCPU( cube, SH, true );
+
+        // unclamped, so that ringing isn't hidden
+        auto evaluate = [ & ]( const vaVector3 & n ) { return SH[0] + SH[1] * n.y + SH[2] * n.z + SH[3] * n.x + SH[4] * ( n.y * n.x ) + SH[5] * ( n.y * n.z )
+                                                        + SH[6] * ( 3.0f * n.z * n.z - 1.0f ) + SH[7] * ( n.z * n.x ) + SH[8] * ( n.x * n.x - n.y * n.y ); };
+        auto lobeMin = [ & ]( float cutoff )
+        {
+            float ret = FLT_MAX;
+            for( int i = 0; i <= 200; i++ )
+            {
+                const float mu = i / 100.0f - 1.0f;
+                ret = vaMath::Min( ret, b0 + SHSincWindow( 1, cutoff ) * b1 * mu + SHSincWindow( 2, cutoff ) * b2 * 0.5f * ( 3.0f * mu * mu - 1.0f ) );
+            }
+            return ret;
+        };
+
+        const float w1 = ( evaluate( dir ).x - evaluate( -dir ).x ) / ( 2.0f * b1 * color.x );
+        if( !( w1 > 0.5f && w1 < 1.0f ) )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "environment 'windowed lobe': band 1 window is %f, expected to be in (0.5, 1)", w1 ) );
+
+        // SHSincWindow( 1, cutoff ) is monotonic in cutoff
+        float cl = (float)c_numSHBands, cr = (float)c_numSHBands * 4 + 1;
+        for( int i = 0; i < 32; i++ )
+        {
+            const float cm = 0.5f * ( cl + cr );
+            ( ( SHSincWindow( 1, cm ) < w1 ) ? ( cl ) : ( cr ) ) = cm;
+        }
+        const float cutoff  = 0.5f * ( cl + cr );
+        const float w2      = SHSincWindow( 2, cutoff );
+
+        if( lobeMin( cutoff ) < -2e-4f )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "environment 'windowed lobe': cutoff %f still rings (minimum %f)", cutoff, lobeMin( cutoff ) ) );
+        if( lobeMin( cutoff + 1.0f ) >= 0.0f )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "environment 'windowed lobe': cutoff %f is lower than needed", cutoff ) );
+
+        for( int i = 0; i < 27; i++ )
+        {
+            if( i == 13 )
+                continue;
+            const vaVector3 n   = testNormal( i );
+            const float mu      = vaVector3::Dot( n, dir );
+
+            const vaVector3 expected    = color * ( b0 + w1 * b1 * mu + w2 * b2 * 0.5f * ( 3.0f * mu * mu - 1.0f ) );
+            const vaVector3 actual      = evaluate( n );
+            const float tolerance       = 2e-3f * vaMath::Max( 1.0f, expected.Length( ) );
+            if( ( actual - expected ).Length( ) > tolerance )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "environment 'windowed lobe', normal (%.3f, %.3f, %.3f): expected (%f, %f, %f), got (%f, %f, %f)",
+                    n.x, n.y, n.z, expected.x, expected.y, expected.z, actual.x, actual.y, actual.z ) );
+        }
+    }
+
+    return vaSelfTest::Pass( outInfo );
+}
+
 
 
 
@@ -76,6 +76,31 @@ namespace Vanilla
     public:
         void                                            Reset( );
 
+    public:
+        // Linear float cube data already on the CPU (mapped readback, or an image decoded at import time).
+        struct CPUCubeFaces
+        {
+            const float *                               Faces[6]                = { };      // +X, -X, +Y, -Y, +Z, -Z - same as the GPU cube array slices
+            int                                         Dim                     = 0;
+            int                                         TexelStride             = 4;        // in floats, 3 (RGB) or 4 (RGBA; alpha ignored)
+            int                                         RowPitch                = 0;        // in bytes; 0 means Dim * TexelStride * sizeof(float)
+        };
+
+        // CPU (multithreaded, SSE) equivalent of ComputeSH + GetSH: same solid angle weighted projection as CSComputeSH followed by the
+        // same scaling, windowing and shader preprocessing as CSPostProcessSH, so the output can be used as IBLProbeConstants::DiffuseSH
+        // directly. No render device needed, so it can be used to bake SH at import time or to validate against analytic environments.
+        static bool                                     ComputeSHCPU( const CPUCubeFaces & cube, std::array<vaVector3, 9> & outSH, bool windowing = true );
+
+        // The two halves of the above: raw projection onto the (non-normalized) basis and the CSPostProcessSH part.
+        static bool                                     ProjectSHCPU( const CPUCubeFaces & cube, std::array<vaVector3, 9> & outRawSH );
+        static void                                     PostProcessSHCPU( std::array<vaVector3, 9> & inOutSH, bool windowing = true );
+
+        // Evaluates postprocessed SH the same way the shaders do (see Irradiance_SphericalHarmonics); returns irradiance / PI.
+        static vaVector3                                EvaluateSH( const std::array<vaVector3, 9> & SH, const vaVector3 & normal );
+
+        // Projects a set of analytic environments (constant and linear gradients, for which irradiance has a closed form, and a windowed
+        // clamped cosine lobe) through the CPU path and compares against expected values; describes the first failure in outInfo (see vaSelfTest).
+        static bool                                     ValidateCPU( string * outInfo = nullptr );
     };
 
     class vaIBLCubemapPreFilter : public vaRenderingModule
@@ -130,6 +155,23 @@ namespace Vanilla
             uint32                                      Size;
         };
 
+        // everything the sample tables depend on; stored in the cache file header and compared on load
+        struct SampleTablesKey
+        {
+            uint32                                      OutputBaseSize      = 0;
+            uint32                                      NumMIPLevels        = 0;
+            uint32                                      SamplesPerTexel     = 0;
+            FilterType                                  Type                = FilterType::Unknown;
+            uint32                                      RoughnessMapping    = c_roughnessMapping;
+
+            bool                                        operator == ( const SampleTablesKey & other ) const     { return OutputBaseSize == other.OutputBaseSize && NumMIPLevels == other.NumMIPLevels && SamplesPerTexel == other.SamplesPerTexel && Type == other.Type && RoughnessMapping == other.RoughnessMapping; }
+        };
+
+        // bump if the sample generation changes in any way that would make existing cache files wrong
+        static const int32                              c_sampleTablesCacheVersion          = 1;
+        // identifies the MIP level -> roughness mapping (see LevelLinearRoughness) - change if the mapping changes
+        static const uint32                             c_roughnessMapping                  = 0;
+
         std::vector<LevelInfo>                          m_levels;
 
         uint32                                          m_outputBaseSize    = 0;
@@ -142,9 +184,32 @@ namespace Vanilla
         virtual ~vaIBLCubemapPreFilter( )                                                                      { }
 
     public:
+        // Sample tables are loaded from the cache (see SampleTablesCachePath) if there, otherwise generated and saved.
         void                                            Init( uint32 outputBaseSize, uint32 outputMinSize, uint32 samplesPerTexel, FilterType filterType );
         void                                            Process( vaRenderDeviceContext& renderContext, vector<shared_ptr<vaTexture>> destCubeMIPLevels, shared_ptr<vaTexture> & sourceCube );
         void                                            Reset( );
+
+        // Linear roughness each ReflectionsRoughness MIP level gets prefiltered for.
+        static float                                    LevelLinearRoughness( uint32 level, uint32 numMIPLevels );
+
+        // CPU reference for a single output texel with direction N: brute force convolution of 'environment' with the GGX lobe (N == V == R,
+        // same as the sample tables assume; linearRoughness ignored for Irradiance which uses the cosine lobe), integrated over all texels
+        // of a quadratureDim sized cube. Slow, for validation only.
+        static vaVector3                                PreFilterTexelReference( const std::function<vaVector3( const vaVector3 & )> & environment, const vaVector3 & N, FilterType filterType, float linearRoughness, int quadratureDim = 128 );
+
+        // Checks the tables of the current Init: weights sum to 1 (a constant environment comes out unchanged - no energy gained or lost),
+        // samples are valid, and filtering a smooth analytic environment with them matches PreFilterTexelReference (see vaSelfTest).
+        bool                                            ValidateSampleTables( string * outInfo = nullptr ) const;
+
+    protected:
+        // Builds all levels' tables; parallel over levels and samples, results do not depend on the thread count or scheduling.
+        static void                                     GenerateSampleTables( const SampleTablesKey & key, vector<vector<SampleInfo>> & outLevelSamples );
+        static wstring                                  SampleTablesCachePath( const SampleTablesKey & key );
+        static bool                                     LoadSampleTables( const wstring & filePath, const SampleTablesKey & key, vector<vector<SampleInfo>> & outLevelSamples );
+        static bool                                     SaveSampleTables( const wstring & filePath, const SampleTablesKey & key, const vector<vector<SampleInfo>> & levelSamples );
+
+        // Same as CSCubePreFilter does with the table, except that 'environment' is evaluated directly (MIPLevel is ignored).
+        static vaVector3                                PreFilterTexelFromSamples( const std::function<vaVector3( const vaVector3 & )> & environment, const vaVector3 & N, const vector<SampleInfo> & samples );
     };
 
     typedef std::function< vaDrawResultFlags( vaRenderDeviceContext & renderContext, const vaCameraBase & faceCamera, const shared_ptr<vaTexture> & faceDepth, const shared_ptr<vaTexture> & faceColor ) >   CubeFaceCaptureCallback;
@@ -266,6 +331,9 @@ namespace Vanilla
         bool                                            HasSkybox( ) const                              { return m_hasContents && m_skyboxTexture != nullptr; }
         void                                            SetToSkybox( class vaSkybox & skybox );
 
+        // vaIBLCubemapPreFilter::ValidateSampleTables for both prefilters (passes with nothing checked if the probe has no contents)
+        bool                                            ValidatePreFilterSampleTables( string * outInfo = nullptr ) const;
+
     private:
         virtual void                                    UIPanelTick( vaApplicationBase & application ) override;
 
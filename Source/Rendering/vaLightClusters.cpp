@@ -0,0 +1,462 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaLightClusters.h"
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define USE_SSE_LIGHT_CLUSTERS
+#include <emmintrin.h>
+#endif
+
+using namespace Vanilla;
+
+namespace
+{
+    // view space cluster bounds: AABB for the sphere test and its bounding sphere for the cone test
+    struct ClusterBounds
+    {
+        float   MinX, MinY, MinZ;
+        float   MaxX, MaxY, MaxZ;
+        float   CenterX, CenterY, CenterZ;
+        float   Radius;
+    };
+
+    // same semantics as _mm_max_ps so that the scalar and the SSE paths produce identical results
+    inline float MaxF( float a, float b )                           { return ( a > b ) ? ( a ) : ( b ); }
+
+    inline void ComputeClusterBounds( const vaLightClusters::GridParams & grid, int x, int y, int z, ClusterBounds & out )
+    {
+        const float zn = grid.SliceNearZ( z );
+        const float zf = grid.SliceNearZ( z + 1 );
+
+        // tile edges as view space x/z (y/z) slopes
+        const float sx0 = ( (float)x - grid.TileBiasX ) / grid.TileScaleX;
+        const float sx1 = ( (float)( x + 1 ) - grid.TileBiasX ) / grid.TileScaleX;
+        const float sy0 = ( (float)y - grid.TileBiasY ) / grid.TileScaleY;
+        const float sy1 = ( (float)( y + 1 ) - grid.TileBiasY ) / grid.TileScaleY;
+
+        out.MinX = std::min( { sx0 * zn, sx1 * zn, sx0 * zf, sx1 * zf } );
+        out.MaxX = std::max( { sx0 * zn, sx1 * zn, sx0 * zf, sx1 * zf } );
+        out.MinY = std::min( { sy0 * zn, sy1 * zn, sy0 * zf, sy1 * zf } );
+        out.MaxY = std::max( { sy0 * zn, sy1 * zn, sy0 * zf, sy1 * zf } );
+        out.MinZ = zn;
+        out.MaxZ = zf;
+
+        out.CenterX = ( out.MinX + out.MaxX ) * 0.5f;
+        out.CenterY = ( out.MinY + out.MaxY ) * 0.5f;
+        out.CenterZ = ( out.MinZ + out.MaxZ ) * 0.5f;
+        const float hx = ( out.MaxX - out.MinX ) * 0.5f;
+        const float hy = ( out.MaxY - out.MinY ) * 0.5f;
+        const float hz = ( out.MaxZ - out.MinZ ) * 0.5f;
+        out.Radius = std::sqrt( hx * hx + hy * hy + hz * hz );
+    }
+
+    // Partial (per axis) squared distances from a light center to cluster bounds; the full sphere test is
+    // distX + (distY + distZ) <= radiusSq, so rejection with any subset of terms is exact (used for slice/row pre-culling).
+    inline float AxisDistance( float c, float bmin, float bmax )     { float d = MaxF( MaxF( bmin - c, c - bmax ), 0.0f ); return d * d; }
+
+    // The reference test; the SSE path in BinSlice must do exactly the same operations in the same order
+    inline bool LightTouchesCluster( const float lx, const float ly, const float lz, const float radiusSq, const float range, const float dirX, const float dirY, const float dirZ,
+                                        const float coneCos, const float coneSin, const float isCone, const ClusterBounds & b )
+    {
+        const float distSq = AxisDistance( lx, b.MinX, b.MaxX ) + ( AxisDistance( ly, b.MinY, b.MaxY ) + AxisDistance( lz, b.MinZ, b.MaxZ ) );
+        if( !( distSq <= radiusSq ) )
+            return false;
+        if( isCone == 0.0f )
+            return true;
+
+        // cone vs cluster bounding sphere, see https://bartwronski.com/2017/04/13/cull-that-cone/
+        const float vx = b.CenterX - lx;
+        const float vy = b.CenterY - ly;
+        const float vz = b.CenterZ - lz;
+        const float vLenSq  = ( vx * vx + vy * vy ) + vz * vz;
+        const float v1Len   = ( vx * dirX + vy * dirY ) + vz * dirZ;
+        const float closest = coneCos * std::sqrt( MaxF( vLenSq - v1Len * v1Len, 0.0f ) ) - v1Len * coneSin;
+        const bool  culled  = ( closest > b.Radius ) || ( v1Len > b.Radius + range ) || ( v1Len < -b.Radius );
+        return !culled;
+    }
+}
+
+void vaLightClusters::Settings::Clamp( )
+{
+    CountX = vaMath::Clamp( CountX, 1, c_maxCount );
+    CountY = vaMath::Clamp( CountY, 1, vaMath::Min( c_maxCount, c_maxTilesPerSlice / CountX ) );
+    CountZ = vaMath::Clamp( CountZ, 1, c_maxCount );
+}
+
+float vaLightClusters::GridParams::SliceNearZ( int z ) const
+{
+    if( z <= 0 )
+        return NearZ;
+    if( z >= CountZ )
+        return FarZ;
+    return NearZ * std::pow( FarZ / NearZ, (float)z / (float)CountZ );
+}
+
+void vaLightClusters::LightsSoA::Resize( int count )
+{
+    Count = count;
+    const size_t paddedCount = (size_t)( ( count + 3 ) & ~3 );
+    X.resize( paddedCount );
+    Y.resize( paddedCount );
+    Z.resize( paddedCount );
+    RadiusSq.resize( paddedCount );
+    Range.resize( paddedCount );
+    DirX.resize( paddedCount );
+    DirY.resize( paddedCount );
+    DirZ.resize( paddedCount );
+    ConeCos.resize( paddedCount );
+    ConeSin.resize( paddedCount );
+    IsCone.resize( paddedCount );
+    Index.resize( paddedCount );
+    for( size_t i = (size_t)count; i < paddedCount; i++ )
+    {
+        X[i] = Y[i] = Z[i] = 0.0f;
+        RadiusSq[i]     = -1.0f;        // squared distance is never negative so these never pass
+        Range[i]        = 0.0f;
+        DirX[i] = DirY[i] = DirZ[i] = 0.0f;
+        ConeCos[i]      = 1.0f;
+        ConeSin[i]      = 0.0f;
+        IsCone[i]       = 0.0f;
+        Index[i]        = 0xFFFFFFFF;
+    }
+}
+
+void vaLightClusters::LightsSoA::CopyFrom( const LightsSoA & other, int srcIndex, int dstIndex )
+{
+    X[dstIndex]         = other.X[srcIndex];
+    Y[dstIndex]         = other.Y[srcIndex];
+    Z[dstIndex]         = other.Z[srcIndex];
+    RadiusSq[dstIndex]  = other.RadiusSq[srcIndex];
+    Range[dstIndex]     = other.Range[srcIndex];
+    DirX[dstIndex]      = other.DirX[srcIndex];
+    DirY[dstIndex]      = other.DirY[srcIndex];
+    DirZ[dstIndex]      = other.DirZ[srcIndex];
+    ConeCos[dstIndex]   = other.ConeCos[srcIndex];
+    ConeSin[dstIndex]   = other.ConeSin[srcIndex];
+    IsCone[dstIndex]    = other.IsCone[srcIndex];
+    Index[dstIndex]     = other.Index[srcIndex];
+}
+
+bool vaLightClusters::SetupGrid( const vaCameraBase & camera, GridParams & outGrid ) const
+{
+    outGrid = GridParams( );
+
+    const vaMatrix4x4 & proj = camera.GetProjMatrix( );
+
+    // only perspective projections (clip.w == view z) with no x/y skew are supported
+    if( !vaMath::NearEqual( proj.m[2][3], 1.0f ) || !vaMath::NearEqual( proj.m[3][3], 0.0f ) || proj.m[1][0] != 0.0f || proj.m[0][1] != 0.0f || proj.m[3][0] != 0.0f || proj.m[3][1] != 0.0f )
+        return false;
+    if( proj.m[0][0] == 0.0f || proj.m[1][1] == 0.0f )
+        return false;
+
+    const float nearZ = camera.GetNearPlaneDistance( );
+    const float farZ  = camera.GetFarPlaneDistance( );
+    if( !( nearZ > 0.0f ) || !( farZ > nearZ ) )
+        return false;
+
+    auto settings = m_settings;
+    settings.Clamp( );
+    outGrid.CountX      = settings.CountX;
+    outGrid.CountY      = settings.CountY;
+    outGrid.CountZ      = settings.CountZ;
+
+    // ndc.x = view.x / view.z * m[0][0] + m[2][0] (the latter is non-zero with subpixel jitter); tile = ( ndc * 0.5 + 0.5 ) * count
+    outGrid.TileScaleX  = 0.5f * proj.m[0][0] * (float)outGrid.CountX;
+    outGrid.TileBiasX   = ( 0.5f * proj.m[2][0] + 0.5f ) * (float)outGrid.CountX;
+    outGrid.TileScaleY  = 0.5f * proj.m[1][1] * (float)outGrid.CountY;
+    outGrid.TileBiasY   = ( 0.5f * proj.m[2][1] + 0.5f ) * (float)outGrid.CountY;
+
+    outGrid.NearZ       = nearZ;
+    outGrid.FarZ        = farZ;
+    outGrid.DepthScale  = (float)outGrid.CountZ / std::log2( farZ / nearZ );
+    outGrid.DepthBias   = -std::log2( nearZ ) * outGrid.DepthScale;
+    return true;
+}
+
+void vaLightClusters::SetupLights( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights )
+{
+    const vaMatrix4x4 & view = camera.GetViewMatrix( );
+    // lights are relative to worldBase; rotate the camera-relative position instead of transforming the absolute one for precision
+    const vaVector3 baseToCamera = worldBase - camera.GetPosition( );
+
+    m_lights.Resize( (int)lights.size( ) );
+    for( int i = 0; i < (int)lights.size( ); i++ )
+    {
+        const ShaderLightSpot & light = lights[i];
+        const vaVector3 pos = vaVector3::TransformNormal( light.Position + baseToCamera, view );
+        const vaVector3 dir = vaVector3::TransformNormal( light.Direction, view );
+        const float range   = vaMath::Max( 0.0f, light.Range );
+
+        m_lights.X[i]           = pos.x;
+        m_lights.Y[i]           = pos.y;
+        m_lights.Z[i]           = pos.z;
+        m_lights.RadiusSq[i]    = range * range;
+        m_lights.Range[i]       = range;
+        m_lights.DirX[i]        = dir.x;
+        m_lights.DirY[i]        = dir.y;
+        m_lights.DirZ[i]        = dir.z;
+        // cone test is only valid (and useful) for cones narrower than a hemisphere; point lights have SpotOuterAngle > PI
+        const bool isCone       = light.SpotOuterAngle > 0.0f && light.SpotOuterAngle < VA_PIf * 0.5f;
+        m_lights.ConeCos[i]     = std::cos( light.SpotOuterAngle );
+        m_lights.ConeSin[i]     = std::sin( light.SpotOuterAngle );
+        m_lights.IsCone[i]      = ( isCone ) ? ( 1.0f ) : ( 0.0f );
+        m_lights.Index[i]       = (uint32)i;
+    }
+}
+
+void vaLightClusters::BinSlice( const GridParams & grid, int z )
+{
+    SliceScratch & scratch = m_sliceScratch[z];
+    const int tilesPerSlice = grid.CountX * grid.CountY;
+    scratch.Counts.resize( tilesPerSlice );
+    scratch.Indices.clear( );
+
+    ClusterBounds bounds;
+    ComputeClusterBounds( grid, 0, 0, z, bounds );
+
+    // lights touching the depth slab of the slice
+    scratch.Candidates.clear( );
+    for( int i = 0; i < m_lights.Count; i++ )
+        if( AxisDistance( m_lights.Z[i], bounds.MinZ, bounds.MaxZ ) <= m_lights.RadiusSq[i] )
+            scratch.Candidates.push_back( i );
+
+    LightsSoA & row = scratch.RowLights;
+    for( int y = 0; y < grid.CountY; y++ )
+    {
+        // all tiles in a row share the y and z extents
+        ComputeClusterBounds( grid, 0, y, z, bounds );
+
+        int rowCount = 0;
+        for( int i : scratch.Candidates )
+            if( ( AxisDistance( m_lights.Y[i], bounds.MinY, bounds.MaxY ) + AxisDistance( m_lights.Z[i], bounds.MinZ, bounds.MaxZ ) ) <= m_lights.RadiusSq[i] )
+                rowCount++;
+        row.Resize( rowCount );
+        rowCount = 0;
+        for( int i : scratch.Candidates )
+            if( ( AxisDistance( m_lights.Y[i], bounds.MinY, bounds.MaxY ) + AxisDistance( m_lights.Z[i], bounds.MinZ, bounds.MaxZ ) ) <= m_lights.RadiusSq[i] )
+                row.CopyFrom( m_lights, i, rowCount++ );
+        const int paddedRowCount = ( rowCount + 3 ) & ~3;
+
+        for( int x = 0; x < grid.CountX; x++ )
+        {
+            ComputeClusterBounds( grid, x, y, z, bounds );
+            const size_t indicesBefore = scratch.Indices.size( );
+
+#ifdef USE_SSE_LIGHT_CLUSTERS
+            const __m128 zero       = _mm_setzero_ps( );
+            const __m128 minX       = _mm_set1_ps( bounds.MinX );
+            const __m128 minY       = _mm_set1_ps( bounds.MinY );
+            const __m128 minZ       = _mm_set1_ps( bounds.MinZ );
+            const __m128 maxX       = _mm_set1_ps( bounds.MaxX );
+            const __m128 maxY       = _mm_set1_ps( bounds.MaxY );
+            const __m128 maxZ       = _mm_set1_ps( bounds.MaxZ );
+            const __m128 centerX    = _mm_set1_ps( bounds.CenterX );
+            const __m128 centerY    = _mm_set1_ps( bounds.CenterY );
+            const __m128 centerZ    = _mm_set1_ps( bounds.CenterZ );
+            const __m128 radius     = _mm_set1_ps( bounds.Radius );
+            const __m128 negRadius  = _mm_set1_ps( -bounds.Radius );
+
+            for( int j = 0; j < paddedRowCount; j += 4 )
+            {
+                const __m128 lx     = _mm_loadu_ps( &row.X[j] );
+                const __m128 ly     = _mm_loadu_ps( &row.Y[j] );
+                const __m128 lz     = _mm_loadu_ps( &row.Z[j] );
+
+                __m128 dx = _mm_max_ps( _mm_max_ps( _mm_sub_ps( minX, lx ), _mm_sub_ps( lx, maxX ) ), zero );
+                __m128 dy = _mm_max_ps( _mm_max_ps( _mm_sub_ps( minY, ly ), _mm_sub_ps( ly, maxY ) ), zero );
+                __m128 dz = _mm_max_ps( _mm_max_ps( _mm_sub_ps( minZ, lz ), _mm_sub_ps( lz, maxZ ) ), zero );
+                __m128 distSq = _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_add_ps( _mm_mul_ps( dy, dy ), _mm_mul_ps( dz, dz ) ) );
+                __m128 pass = _mm_cmple_ps( distSq, _mm_loadu_ps( &row.RadiusSq[j] ) );
+                if( _mm_movemask_ps( pass ) == 0 )
+                    continue;
+
+                const __m128 vx     = _mm_sub_ps( centerX, lx );
+                const __m128 vy     = _mm_sub_ps( centerY, ly );
+                const __m128 vz     = _mm_sub_ps( centerZ, lz );
+                const __m128 vLenSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vx, vx ), _mm_mul_ps( vy, vy ) ), _mm_mul_ps( vz, vz ) );
+                const __m128 v1Len  = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vx, _mm_loadu_ps( &row.DirX[j] ) ), _mm_mul_ps( vy, _mm_loadu_ps( &row.DirY[j] ) ) ), _mm_mul_ps( vz, _mm_loadu_ps( &row.DirZ[j] ) ) );
+                const __m128 perp   = _mm_sqrt_ps( _mm_max_ps( _mm_sub_ps( vLenSq, _mm_mul_ps( v1Len, v1Len ) ), zero ) );
+                const __m128 closest= _mm_sub_ps( _mm_mul_ps( _mm_loadu_ps( &row.ConeCos[j] ), perp ), _mm_mul_ps( v1Len, _mm_loadu_ps( &row.ConeSin[j] ) ) );
+                __m128 culled       = _mm_cmpgt_ps( closest, radius );
+                culled              = _mm_or_ps( culled, _mm_cmpgt_ps( v1Len, _mm_add_ps( radius, _mm_loadu_ps( &row.Range[j] ) ) ) );
+                culled              = _mm_or_ps( culled, _mm_cmplt_ps( v1Len, negRadius ) );
+                culled              = _mm_and_ps( culled, _mm_cmpneq_ps( _mm_loadu_ps( &row.IsCone[j] ), zero ) );
+                pass                = _mm_andnot_ps( culled, pass );
+
+                int mask = _mm_movemask_ps( pass );
+                for( int k = 0; mask != 0; k++, mask >>= 1 )
+                    if( mask & 1 )
+                        scratch.Indices.push_back( row.Index[j + k] );
+            }
+#else
+            for( int j = 0; j < rowCount; j++ )
+                if( LightTouchesCluster( row.X[j], row.Y[j], row.Z[j], row.RadiusSq[j], row.Range[j], row.DirX[j], row.DirY[j], row.DirZ[j], row.ConeCos[j], row.ConeSin[j], row.IsCone[j], bounds ) )
+                    scratch.Indices.push_back( row.Index[j] );
+#endif
+            scratch.Counts[ y * grid.CountX + x ] = (uint32)( scratch.Indices.size( ) - indicesBefore );
+        }
+    }
+}
+
+bool vaLightClusters::Bin( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights, Output & out )
+{
+    VA_TRACE_CPU_SCOPE( vaLightClusters_Bin );
+
+    out.Clusters.clear( );
+    out.LightIndices.clear( );
+    out.MaxLightsPerCluster = 0;
+    if( !SetupGrid( camera, out.Grid ) )
+        return false;
+
+    const GridParams & grid = out.Grid;
+    SetupLights( camera, worldBase, lights );
+
+    if( (int)m_sliceScratch.size( ) < grid.CountZ )
+        m_sliceScratch.resize( grid.CountZ );
+
+    // slices are independent; each fills its own scratch so the compaction below is deterministic
+    vaThreading::ParallelFor( grid.CountZ, 1, [ this, &grid ]( int begin, int end )
+    {
+        for( int z = begin; z < end; z++ )
+            BinSlice( grid, z );
+    } );
+
+    const int tilesPerSlice = grid.CountX * grid.CountY;
+    size_t totalIndices = 0;
+    for( int z = 0; z < grid.CountZ; z++ )
+        totalIndices += m_sliceScratch[z].Indices.size( );
+
+    out.Clusters.resize( grid.ClusterCount( ) );
+    out.LightIndices.resize( totalIndices );
+
+    uint32 offset = 0;
+    for( int z = 0; z < grid.CountZ; z++ )
+    {
+        const SliceScratch & scratch = m_sliceScratch[z];
+        if( !scratch.Indices.empty( ) )
+            memcpy( &out.LightIndices[offset], scratch.Indices.data( ), scratch.Indices.size( ) * sizeof( uint32 ) );
+        for( int i = 0; i < tilesPerSlice; i++ )
+        {
+            Cluster & cluster = out.Clusters[ z * tilesPerSlice + i ];
+            cluster.Offset  = offset;
+            cluster.Count   = scratch.Counts[i];
+            offset         += cluster.Count;
+            out.MaxLightsPerCluster = vaMath::Max( out.MaxLightsPerCluster, (int)cluster.Count );
+        }
+    }
+    assert( offset == (uint32)totalIndices );
+
+    return true;
+}
+
+bool vaLightClusters::BinReference( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights, Output & out )
+{
+    out.Clusters.clear( );
+    out.LightIndices.clear( );
+    out.MaxLightsPerCluster = 0;
+    if( !SetupGrid( camera, out.Grid ) )
+        return false;
+
+    const GridParams & grid = out.Grid;
+    SetupLights( camera, worldBase, lights );
+
+    out.Clusters.resize( grid.ClusterCount( ) );
+    ClusterBounds bounds;
+    for( int z = 0; z < grid.CountZ; z++ )
+        for( int y = 0; y < grid.CountY; y++ )
+            for( int x = 0; x < grid.CountX; x++ )
+            {
+                ComputeClusterBounds( grid, x, y, z, bounds );
+                Cluster & cluster = out.Clusters[ grid.ClusterIndex( x, y, z ) ];
+                cluster.Offset = (uint32)out.LightIndices.size( );
+                for( int i = 0; i < m_lights.Count; i++ )
+                    if( LightTouchesCluster( m_lights.X[i], m_lights.Y[i], m_lights.Z[i], m_lights.RadiusSq[i], m_lights.Range[i], m_lights.DirX[i], m_lights.DirY[i], m_lights.DirZ[i],
+                                                m_lights.ConeCos[i], m_lights.ConeSin[i], m_lights.IsCone[i], bounds ) )
+                        out.LightIndices.push_back( (uint32)i );
+                cluster.Count = (uint32)out.LightIndices.size( ) - cluster.Offset;
+                out.MaxLightsPerCluster = vaMath::Max( out.MaxLightsPerCluster, (int)cluster.Count );
+            }
+    return true;
+}
+
+bool vaLightClusters::Compare( const Output & a, const Output & b, string * outInfo )
+{
+    string info;
+    const int maxReported = 8;
+    int differences = 0;
+
+    const GridParams & ga = a.Grid;
+    const GridParams & gb = b.Grid;
+    if( ga.CountX != gb.CountX || ga.CountY != gb.CountY || ga.CountZ != gb.CountZ || ga.TileScaleX != gb.TileScaleX || ga.TileScaleY != gb.TileScaleY
+        || ga.TileBiasX != gb.TileBiasX || ga.TileBiasY != gb.TileBiasY || ga.DepthScale != gb.DepthScale || ga.DepthBias != gb.DepthBias || ga.NearZ != gb.NearZ || ga.FarZ != gb.FarZ )
+    {
+        if( outInfo != nullptr )
+            *outInfo = "Cluster grids differ";
+        return false;
+    }
+    if( a.Clusters.size( ) != b.Clusters.size( ) || (int)a.Clusters.size( ) != ga.ClusterCount( ) )
+    {
+        if( outInfo != nullptr )
+            *outInfo = "Cluster counts differ";
+        return false;
+    }
+
+    for( int i = 0; i < (int)a.Clusters.size( ); i++ )
+    {
+        const Cluster & ca = a.Clusters[i];
+        const Cluster & cb = b.Clusters[i];
+        bool same = ca.Count == cb.Count;
+        for( uint32 j = 0; same && j < ca.Count; j++ )
+            same = a.LightIndices[ca.Offset + j] == b.LightIndices[cb.Offset + j];
+        if( same )
+            continue;
+
+        if( differences < maxReported )
+        {
+            const int x = i % ga.CountX;
+            const int y = ( i / ga.CountX ) % ga.CountY;
+            const int z = i / ( ga.CountX * ga.CountY );
+            info += vaStringTools::Format( "Cluster (%d, %d, %d): %u vs %u lights\n", x, y, z, ca.Count, cb.Count );
+        }
+        differences++;
+    }
+
+    if( outInfo != nullptr )
+    {
+        if( differences > maxReported )
+            info += vaStringTools::Format( "... %d differing clusters in total\n", differences );
+        *outInfo = info;
+    }
+    return differences == 0;
+}
+
+bool vaLightClusters::Validate( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights, string * outInfo )
+{
+    Output binned, reference;
+    const bool binnedOK     = Bin( camera, worldBase, lights, binned );
+    const bool referenceOK  = BinReference( camera, worldBase, lights, reference );
+    if( binnedOK != referenceOK )
+    {
+        if( outInfo != nullptr )
+            *outInfo = "Bin and BinReference disagree on whether the camera can be clustered";
+        return false;
+    }
+    return Compare( binned, reference, outInfo );
+}
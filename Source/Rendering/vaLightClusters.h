@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+#include "Scene/vaCameraBase.h"
+
+#include "Rendering/Shaders/vaLightingShared.h"
+
+namespace Vanilla
+{
+    // CPU froxel ("clustered") light binning. The view frustum is split into CountX x CountY screen tiles and CountZ depth
+    // slices (exponentially distributed between the near and far plane) and each point/spot light gets assigned to every
+    // cluster its sphere (and, for spot lights, cone) can touch. The result is a per-cluster (offset, count) range into a
+    // compact light index list, so shading cost depends on the local light density and not on the total light count.
+    //
+    // There are no render device dependencies: Bin / BinReference / Compare can be used (and validated) headlessly.
+    class vaLightClusters
+    {
+    public:
+        // vaLighting stores each depth slice in one row of a Texture2D, so CountX * CountY can't exceed its width limit
+        static constexpr int                    c_maxCount              = 256;
+        static constexpr int                    c_maxTilesPerSlice      = 16384;
+
+        struct Settings
+        {
+            int                                 CountX                  = 16;
+            int                                 CountY                  = 8;
+            int                                 CountZ                  = 24;
+
+            // each count to [1, c_maxCount] and CountY down so that CountX * CountY <= c_maxTilesPerSlice
+            void                                Clamp( );
+        };
+
+        // all that is needed to map a view space position to a cluster (same math is in the shaders, see vaLighting.hlsl)
+        //  tileX = viewPos.x / viewPos.z * TileScaleX + TileBiasX
+        //  tileY = viewPos.y / viewPos.z * TileScaleY + TileBiasY
+        //  slice = log2( viewPos.z ) * DepthScale + DepthBias
+        struct GridParams
+        {
+            int                                 CountX                  = 0;
+            int                                 CountY                  = 0;
+            int                                 CountZ                  = 0;
+            float                               TileScaleX              = 0.0f;
+            float                               TileScaleY              = 0.0f;
+            float                               TileBiasX               = 0.0f;
+            float                               TileBiasY               = 0.0f;
+            float                               DepthScale              = 0.0f;
+            float                               DepthBias               = 0.0f;
+            float                               NearZ                   = 0.0f;
+            float                               FarZ                    = 0.0f;
+
+            int                                 ClusterCount( ) const                               { return CountX * CountY * CountZ; }
+            int                                 ClusterIndex( int x, int y, int z ) const           { return ( z * CountY + y ) * CountX + x; }
+            float                               SliceNearZ( int z ) const;
+        };
+
+        // layout matches a R32G32_UINT texel
+        struct Cluster
+        {
+            uint32                              Offset;                 // into Output::LightIndices
+            uint32                              Count;
+        };
+
+        struct Output
+        {
+            GridParams                          Grid;
+            vector<Cluster>                     Clusters;               // Grid.ClusterCount() of them, see GridParams::ClusterIndex
+            vector<uint32>                      LightIndices;           // indices into the lights array passed to Bin; sorted within each cluster
+            int                                 MaxLightsPerCluster     = 0;
+        };
+
+    private:
+        Settings                                m_settings;
+
+        // view space light data in SoA form, padded to a multiple of 4 with lights that never pass
+        struct LightsSoA
+        {
+            vector<float>                       X;
+            vector<float>                       Y;
+            vector<float>                       Z;
+            vector<float>                       RadiusSq;               // negative for padding
+            vector<float>                       Range;
+            vector<float>                       DirX;
+            vector<float>                       DirY;
+            vector<float>                       DirZ;
+            vector<float>                       ConeCos;                // of the outer angle
+            vector<float>                       ConeSin;
+            vector<float>                       IsCone;                 // 1 for spot lights narrow enough for the cone test, 0 otherwise
+            vector<uint32>                      Index;                  // into the original lights array
+            int                                 Count                   = 0;    // not including padding
+
+            void                                Resize( int count );    // count rounded up to multiple of 4, padding initialized
+            void                                CopyFrom( const LightsSoA & other, int srcIndex, int dstIndex );
+        };
+        LightsSoA                               m_lights;
+
+        // per-slice working data so slices can be binned on separate threads and then compacted in order
+        struct SliceScratch
+        {
+            vector<int>                         Candidates;             // lights touching the slice
+            LightsSoA                           RowLights;              // lights touching the current row of tiles
+            vector<uint32>                      Counts;                 // per cluster in the slice
+            vector<uint32>                      Indices;                // lights for all clusters in the slice, in cluster order
+        };
+        vector<SliceScratch>                    m_sliceScratch;
+
+    public:
+        vaLightClusters( )                      { }
+        ~vaLightClusters( )                     { }
+
+    public:
+        Settings &                              Settings( )                                         { return m_settings; }
+
+        // Lights are ShaderLightSpot as packed by vaLighting (positions relative to worldBase); points are the ones with SpotOuterAngle >= PI.
+        // Returns false (and leaves an empty grid) if the camera projection can't be clustered (not a perspective one).
+        bool                                    Bin( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights, Output & out );
+
+        // Brute force (every light vs every cluster, no SIMD, single threaded) version of Bin with identical results; for validation only.
+        bool                                    BinReference( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights, Output & out );
+
+        // Returns true if both contain the same grid and the same light sets in each cluster; describes the first few differences in outInfo.
+        static bool                             Compare( const Output & a, const Output & b, string * outInfo = nullptr );
+
+        // Runs both Bin and BinReference and compares them.
+        bool                                    Validate( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights, string * outInfo = nullptr );
+
+    private:
+        bool                                    SetupGrid( const vaCameraBase & camera, GridParams & outGrid ) const;
+        void                                    SetupLights( const vaCameraBase & camera, const vaVector3 & worldBase, const vector<ShaderLightSpot> & lights );
+        void                                    BinSlice( const GridParams & grid, int slice );
+    };
+}
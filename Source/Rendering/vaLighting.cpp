@@ -27,6 +27,8 @@
 #include "Rendering/vaRenderMesh.h"
 #include "Rendering/vaRenderMaterial.h"
 
+#include "Core/Misc/vaSelfTest.h"
+
 using namespace Vanilla;
 
 static void NormalizeLightColorIntensity( vaVector3 & color, float & intensity )
@@ -373,6 +375,8 @@ void vaLighting::UpdateShaderConstants( vaSceneDrawContext & drawContext )
 
     consts.AmbientLightIntensity    = vaVector4( 0.0f, 0.0f, 0.0f, 0.0f );
 
+    // all spot lights first, then all point lights (no limit here, see UpdateLightClusters)
+    vector<ShaderLightSpot> spotLights;
     vector<ShaderLightSpot> pointLights;
 
     float preExposureMultiplier = drawContext.Camera.GetPreExposureMultiplier( true );
@@ -448,7 +452,6 @@ void vaLighting::UpdateShaderConstants( vaSceneDrawContext & drawContext )
             break;
         case( vaLight::Type::Spot ):
             assert( light.Size > 0 );
-            if( consts.LightCountSpotAndPoint + 1 < ShaderLightSpot::MaxLights )
             {
                 ShaderLightSpot shLight;
                 shLight.Color               = light.Color;
@@ -462,32 +465,40 @@ void vaLighting::UpdateShaderConstants( vaSceneDrawContext & drawContext )
                 shLight.SpotOuterAngle      = light.SpotOuterAngle;
                 shLight.CubeShadowIndex     = (float)((shadowmap != nullptr)?(shadowmap->GetStorageTextureIndex()):(-1));
                 shLight.Dummy1              = 0.0f;
-                consts.LightsSpotAndPoint[consts.LightCountSpotAndPoint] = shLight;
-                consts.LightCountSpotAndPoint++;
+                spotLights.push_back( shLight );
             }
-            else { VA_WARN( "vaLighting - requested more than the max number of spot lights (%d)", ShaderLightSpot::MaxLights ); }
             break;
         default: assert( false ); // error or not implemented
         }
     }
 
-    // so far we've only added spot lights above, points went to a separate array to be added below
-    consts.LightCountSpotOnly = consts.LightCountSpotAndPoint;
-
     // since sin(x) is close to x for very small x values then this actually works good enough
     consts.ShadowCubeDepthBiasScale             = m_shadowCubeDepthBiasScale / (float)m_shadowCubeResolution;
     consts.ShadowCubeFilterKernelSize           = m_shadowCubeFilterKernelSize / (float)m_shadowCubeResolution * 2.0f; // is this correct? basically approx cube sampling direction in .xy (if face is z) that moves by 1 pixel, roughly?
     consts.ShadowCubeFilterKernelSizeUnscaled   = m_shadowCubeFilterKernelSize;
 
-    for( int i = 0; i < pointLights.size( ); i++ )
+    const int spotCount = (int)spotLights.size( );
+    spotLights.insert( spotLights.end( ), pointLights.begin( ), pointLights.end( ) );
+    const vector<ShaderLightSpot> & spotAndPointLights = spotLights;
+
+    m_lightClustersActive = UpdateLightClusters( drawContext, spotAndPointLights, consts );
+
+    // the constant buffer array is all that non-clustered shading sees (and it's still used by shaders that don't support clusters)
+    for( int i = 0; i < (int)spotAndPointLights.size( ); i++ )
     {
         if( consts.LightCountSpotAndPoint + 1 < ShaderLightSpot::MaxLights )
         {
-            consts.LightsSpotAndPoint[consts.LightCountSpotAndPoint] = pointLights[i];
+            consts.LightsSpotAndPoint[consts.LightCountSpotAndPoint] = spotAndPointLights[i];
             consts.LightCountSpotAndPoint++;
         }
-        else { VA_WARN( "vaLighting - requested more than the max number of spot/point lights (%d)", ShaderLightSpot::MaxLights ); }
+        else 
+        {
+            if( !m_lightClustersActive )
+                VA_WARN( "vaLighting - requested more than the max number of spot/point lights (%d) with light clustering disabled", ShaderLightSpot::MaxLights );
+            break;
+        }
     }
+    consts.LightCountSpotOnly = vaMath::Min( (uint)spotCount, consts.LightCountSpotAndPoint );
 
     memset( &consts.LocalIBL, 0, sizeof( consts.LocalIBL ) );
     memset( &consts.DistantIBL, 0, sizeof( consts.DistantIBL ) );
@@ -502,6 +513,114 @@ void vaLighting::UpdateShaderConstants( vaSceneDrawContext & drawContext )
     m_constantsBuffer.Update( drawContext.RenderDeviceContext, consts );
 }
 
+static int RoundUpToPowerOf2( int value )
+{
+    int ret = 1;
+    while( ret < value )
+        ret <<= 1;
+    return ret;
+}
+
+bool vaLighting::UpdateLightClusters( vaSceneDrawContext & drawContext, const vector<ShaderLightSpot> & lights, LightingShaderConstants & consts )
+{
+    VA_TRACE_CPU_SCOPE( vaLighting_UpdateLightClusters );
+
+    consts.LightClustersEnabled     = 0;
+    consts.LightClusterCountX       = 0;
+    consts.LightClusterCountY       = 0;
+    consts.LightClusterCountZ       = 0;
+    consts.LightClusterTileScale    = { 0, 0 };
+    consts.LightClusterTileBias     = { 0, 0 };
+    consts.LightClusterDepthScale   = 0.0f;
+    consts.LightClusterDepthBias    = 0.0f;
+    consts.LightClusterLightCount   = 0;
+    consts.LightClusterPadding0     = 0;
+
+    if( !m_lightClustersEnabled )
+    {
+        m_lightClustersLastLightCount = -1;
+        return false;
+    }
+
+    const vaCameraBase & camera = drawContext.Camera;
+    const vaVector3 & worldBase = drawContext.Settings.WorldBase;
+
+    if( m_lightClustersValidateNext )
+    {
+        m_lightClustersValidateNext = false;
+        string info;
+        bool ok = m_lightClusters.Validate( camera, worldBase, lights, &info );
+        m_lightClustersValidateInfo = vaStringTools::Format( "%s (%d lights)\n", (ok)?("Binning matches the brute force reference"):("Binning DOES NOT match the brute force reference"), (int)lights.size() ) + info;
+        if( ok )
+            VA_LOG( "vaLighting - %s", m_lightClustersValidateInfo.c_str() );
+        else
+            VA_WARN( "vaLighting - %s", m_lightClustersValidateInfo.c_str() );
+    }
+
+    // UpdateShaderConstants gets called for every pass; only re-bin and re-upload when the camera, the lights or the cluster settings changed
+    auto settings = m_lightClusters.Settings( );
+    settings.Clamp( );
+    const vaLightClusters::GridParams & lastGrid = m_lightClustersOutput.Grid;
+    bool upToDate = m_lightClustersLastLightCount == (int)lights.size( ) && m_lightClustersLastView == camera.GetViewMatrix( ) && m_lightClustersLastProj == camera.GetProjMatrix( )
+        && m_lightClustersLastWorldBase == worldBase && lastGrid.CountX == settings.CountX && lastGrid.CountY == settings.CountY && lastGrid.CountZ == settings.CountZ
+        && ( lights.size( ) == 0 || memcmp( m_lightClustersLights.data( ), lights.data( ), lights.size( ) * sizeof( ShaderLightSpot ) ) == 0 );
+
+    if( !upToDate )
+    {
+        m_lightClustersLastLightCount = -1;
+        if( !m_lightClusters.Bin( camera, worldBase, lights, m_lightClustersOutput ) )
+            return false;
+
+        const vaLightClusters::GridParams & grid = m_lightClustersOutput.Grid;
+
+        // (re)create textures if needed; lights & indices only grow (in powers of 2) to avoid thrashing
+        const int lightRows     = RoundUpToPowerOf2( vaMath::Max( 64, (int)lights.size( ) ) );
+        const int indexRows     = RoundUpToPowerOf2( vaMath::Max( 1, ( (int)m_lightClustersOutput.LightIndices.size( ) + LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH - 1 ) / LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH ) );
+        if( m_lightClusterLightsTexture == nullptr || m_lightClusterLightsTexture->GetHeight( ) < lightRows )
+            m_lightClusterLightsTexture = vaTexture::Create2D( GetRenderDevice( ), vaResourceFormat::R32G32B32A32_FLOAT, 4, lightRows, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource );
+        if( m_lightClusterGridTexture == nullptr || m_lightClusterGridTexture->GetWidth( ) != grid.CountX * grid.CountY || m_lightClusterGridTexture->GetHeight( ) != grid.CountZ )
+            m_lightClusterGridTexture = vaTexture::Create2D( GetRenderDevice( ), vaResourceFormat::R32G32_UINT, grid.CountX * grid.CountY, grid.CountZ, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource );
+        if( m_lightClusterIndicesTexture == nullptr || m_lightClusterIndicesTexture->GetHeight( ) < indexRows )
+            m_lightClusterIndicesTexture = vaTexture::Create2D( GetRenderDevice( ), vaResourceFormat::R32_UINT, LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH, indexRows, 1, 1, 1, vaResourceBindSupportFlags::ShaderResource );
+        if( m_lightClusterLightsTexture == nullptr || m_lightClusterGridTexture == nullptr || m_lightClusterIndicesTexture == nullptr )
+            { assert( false ); return false; }
+
+        // uploads are always for the whole subresource so staging is padded to the texture size
+        m_lightClustersLights.resize( m_lightClusterLightsTexture->GetHeight( ) );
+        if( lights.size( ) > 0 )
+            memcpy( m_lightClustersLights.data( ), lights.data( ), lights.size( ) * sizeof( ShaderLightSpot ) );
+        m_lightClustersIndicesStaging.resize( (size_t)LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH * m_lightClusterIndicesTexture->GetHeight( ) );
+        if( m_lightClustersOutput.LightIndices.size( ) > 0 )
+            memcpy( m_lightClustersIndicesStaging.data( ), m_lightClustersOutput.LightIndices.data( ), m_lightClustersOutput.LightIndices.size( ) * sizeof( uint32 ) );
+
+        static_assert( sizeof( ShaderLightSpot ) == 4 * sizeof( vaVector4 ), "ShaderLightSpot is expected to be 4 RGBA32F texels" );
+        static_assert( sizeof( vaLightClusters::Cluster ) == 2 * sizeof( uint32 ), "vaLightClusters::Cluster is expected to be a R32G32_UINT texel" );
+        vector<vaTextureSubresourceData> lightsData   = { { m_lightClustersLights.data( ), (int64)sizeof( ShaderLightSpot ), (int64)( sizeof( ShaderLightSpot ) * m_lightClustersLights.size( ) ) } };
+        vector<vaTextureSubresourceData> gridData     = { { m_lightClustersOutput.Clusters.data( ), (int64)( sizeof( vaLightClusters::Cluster ) * grid.CountX * grid.CountY ), (int64)( sizeof( vaLightClusters::Cluster ) * m_lightClustersOutput.Clusters.size( ) ) } };
+        vector<vaTextureSubresourceData> indicesData  = { { m_lightClustersIndicesStaging.data( ), (int64)( sizeof( uint32 ) * LIGHT_CLUSTER_INDICES_TEXTURE_WIDTH ), (int64)( sizeof( uint32 ) * m_lightClustersIndicesStaging.size( ) ) } };
+        m_lightClusterLightsTexture->UpdateSubresources( drawContext.RenderDeviceContext, 0, lightsData );
+        m_lightClusterGridTexture->UpdateSubresources( drawContext.RenderDeviceContext, 0, gridData );
+        m_lightClusterIndicesTexture->UpdateSubresources( drawContext.RenderDeviceContext, 0, indicesData );
+
+        m_lightClustersLastView         = camera.GetViewMatrix( );
+        m_lightClustersLastProj         = camera.GetProjMatrix( );
+        m_lightClustersLastWorldBase    = worldBase;
+        m_lightClustersLastLightCount   = (int)lights.size( );
+    }
+
+    const vaLightClusters::GridParams & grid = m_lightClustersOutput.Grid;
+    consts.LightClustersEnabled     = 1;
+    consts.LightClusterCountX       = (uint)grid.CountX;
+    consts.LightClusterCountY       = (uint)grid.CountY;
+    consts.LightClusterCountZ       = (uint)grid.CountZ;
+    consts.LightClusterTileScale    = { grid.TileScaleX, grid.TileScaleY };
+    consts.LightClusterTileBias     = { grid.TileBiasX, grid.TileBiasY };
+    consts.LightClusterDepthScale   = grid.DepthScale;
+    consts.LightClusterDepthBias    = grid.DepthBias;
+    consts.LightClusterLightCount   = (uint)lights.size( );
+    return true;
+}
+
 void vaLighting::UpdateAndSetToGlobals( vaSceneDrawContext & drawContext, vaShaderItemGlobals & shaderItemGlobals )
 {
     assert( drawContext.Lighting == this );
@@ -520,6 +639,16 @@ void vaLighting::UpdateAndSetToGlobals( vaSceneDrawContext & drawContext, vaShad
     assert( shaderItemGlobals.ShaderResourceViews[SHADERGLOBAL_AOMAP_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] == nullptr );
     shaderItemGlobals.ShaderResourceViews[SHADERGLOBAL_AOMAP_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] = m_AOTexture;
 
+    if( m_lightClustersActive )
+    {
+        assert( shaderItemGlobals.ShaderResourceViews[LIGHTINGGLOBAL_CLUSTER_LIGHTS_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] == nullptr );
+        shaderItemGlobals.ShaderResourceViews[LIGHTINGGLOBAL_CLUSTER_LIGHTS_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] = m_lightClusterLightsTexture;
+        assert( shaderItemGlobals.ShaderResourceViews[LIGHTINGGLOBAL_CLUSTER_GRID_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] == nullptr );
+        shaderItemGlobals.ShaderResourceViews[LIGHTINGGLOBAL_CLUSTER_GRID_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] = m_lightClusterGridTexture;
+        assert( shaderItemGlobals.ShaderResourceViews[LIGHTINGGLOBAL_CLUSTER_INDICES_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] == nullptr );
+        shaderItemGlobals.ShaderResourceViews[LIGHTINGGLOBAL_CLUSTER_INDICES_TEXTURESLOT - vaShaderItemGlobals::ShaderResourceViewsShaderSlotBase] = m_lightClusterIndicesTexture;
+    }
+
     if( !drawContext.Settings.DisableGI )
     {
         if( m_localIBL != nullptr )
@@ -534,20 +663,180 @@ void vaLighting::SetLights( const vector<shared_ptr<vaLight>> & lights )
     m_lights = lights;
 }
 
-shared_ptr<vaShadowmap> vaLighting::GetNextHighestPriorityShadowmapForRendering( )
+void vaLighting::SelectShadowmapsForRendering( const vaCameraBase & mainCamera, vector<shared_ptr<vaShadowmap>> & outShadowmaps )
 {
-    shared_ptr<vaShadowmap> ret = nullptr;
-    float highestFoundAge       = 0.0f;
+    VA_TRACE_CPU_SCOPE( vaLighting_SelectShadowmaps );
 
-    for( int i = 0; i < m_shadowmaps.size( ); i++ )
-    {
-        if( m_shadowmaps[i]->GetDataAge( ) > highestFoundAge )
+    outShadowmaps.clear( );
+    m_shadowmapSchedulerStats = ShadowmapSchedulerStats( );
+
+    const ShadowmapSchedulerSettings & settings = m_shadowmapScheduler;
+
+    vaPlane frustumPlanes[6];
+    mainCamera.CalcFrustumPlanes( frustumPlanes );
+    const vaVector3 cameraPos   = mainCamera.GetPosition( );
+    const float tanHalfYFOV     = vaMath::Max( VA_EPSf, tanf( mainCamera.GetYFOV( ) * 0.5f ) );
+
+    // average cost of the ones drawn so far is the estimate for the ones never drawn and also the reference for the cost weighting
+    int64 knownCostSum = 0;
+    int knownCostCount = 0;
+    for( const shared_ptr<vaShadowmap> & shadowmap : m_shadowmaps )
+        if( shadowmap->GetEstimatedDrawCallCount( ) >= 0 )
         {
-            ret             = m_shadowmaps[i];
-            highestFoundAge = m_shadowmaps[i]->GetDataAge( );
+            knownCostSum += shadowmap->GetEstimatedDrawCallCount( );
+            knownCostCount++;
         }
+    const float averageCost = ( knownCostCount > 0 ) ? ( vaMath::Max( 1.0f, (float)knownCostSum / (float)knownCostCount ) ) : ( 1.0f );
+
+    m_shadowmapSchedulerCandidates.clear( );
+    for( int i = 0; i < m_shadowmaps.size( ); i++ )
+    {
+        vaShadowmap & shadowmap = *m_shadowmaps[i];
+        shadowmap.m_lastSchedulingPriority = 0.0f;
+
+        // up to date, or no storage to draw into
+        if( shadowmap.GetDataAge( ) <= 0.0f || shadowmap.GetStorageTextureIndex( ) == -1 )
+            continue;
+
+        shared_ptr<vaLight> light = shadowmap.GetLight( ).lock( );
+        if( light == nullptr )
+            continue;
+
+        const float range       = vaMath::Max( VA_EPSf, light->Range );
+        const float distance    = ( light->Position - cameraPos ).Length( );
+
+        // roughly the fraction of the screen height covered by the light's sphere of influence; 0 if it's outside of the view frustum
+        bool inView = true;
+        for( int p = 0; p < 6 && inView; p++ )
+            inView = frustumPlanes[p].DotCoord( light->Position ) >= -range;
+        float screenInfluence = 0.0f;
+        if( inView )
+            screenInfluence = ( distance <= range ) ? ( 1.0f ) : ( vaMath::Saturate( range / ( distance * tanHalfYFOV ) ) );
+
+        // 1 at the camera, 0.5 at one range away, etc.
+        const float distanceFactor = range / ( range + distance );
+
+        const float weight  = 1.0f + settings.ScreenInfluenceWeight * screenInfluence + settings.DistanceWeight * distanceFactor + settings.CasterMotionWeight * shadowmap.GetRecentCasterMotion( );
+        const float cost    = ( shadowmap.GetEstimatedDrawCallCount( ) >= 0 ) ? ( vaMath::Max( 1.0f, (float)shadowmap.GetEstimatedDrawCallCount( ) ) ) : ( averageCost );
+
+        // ages of never drawn shadowmaps are VA_FLOAT_HIGHEST - keep them on top but finite
+        const float age     = vaMath::Min( shadowmap.GetDataAge( ), 1e6f );
+
+        shadowmap.m_lastSchedulingPriority = age * weight / vaMath::Pow( cost / averageCost, settings.CostExponent );
+        m_shadowmapSchedulerCandidates.push_back( { shadowmap.m_lastSchedulingPriority, cost, i } );
+    }
+    m_shadowmapSchedulerStats.Candidates = (int)m_shadowmapSchedulerCandidates.size( );
+
+    std::sort( m_shadowmapSchedulerCandidates.begin( ), m_shadowmapSchedulerCandidates.end( ), [ ]( const ShadowmapCandidate & a, const ShadowmapCandidate & b ) { return a.Priority > b.Priority; } );
+
+    float budgetLeft = (float)settings.DrawCallBudget;
+    for( const ShadowmapCandidate & candidate : m_shadowmapSchedulerCandidates )
+    {
+        if( (int)outShadowmaps.size( ) >= settings.MaxUpdatesPerFrame )
+            break;
+
+        // the top one always goes through (or expensive ones would never get updated); after that only what fits, but keep looking since cheaper ones further down might
+        if( outShadowmaps.size( ) > 0 && candidate.Cost > budgetLeft )
+            continue;
+
+        outShadowmaps.push_back( m_shadowmaps[candidate.Index] );
+        budgetLeft -= candidate.Cost;
+        m_shadowmapSchedulerStats.Selected++;
+        m_shadowmapSchedulerStats.EstimatedDrawCalls += (int)candidate.Cost;
+    }
+}
+
+bool vaLighting::IsStaticShadowAffected( const vaBoundingSphere & lightVolume, const vaShadowCasterChange & change )
+{
+    if( change.WasStatic && change.BoundsBefore.NearestDistanceToPoint( lightVolume.Center ) <= lightVolume.Radius )
+        return true;
+    if( change.IsStatic && change.BoundsAfter.NearestDistanceToPoint( lightVolume.Center ) <= lightVolume.Radius )
+        return true;
+    return false;
+}
+
+void vaLighting::ComputeStaticShadowInvalidation( const vector<vaBoundingSphere> & lightVolumes, const vector<vaShadowCasterChange> & changes, vector<bool> & outNeedsStaticRedraw )
+{
+    outNeedsStaticRedraw.assign( lightVolumes.size( ), false );
+    for( int i = 0; i < (int)lightVolumes.size( ); i++ )
+    {
+        for( int j = 0; j < (int)changes.size( ) && !outNeedsStaticRedraw[i]; j++ )
+            outNeedsStaticRedraw[i] = IsStaticShadowAffected( lightVolumes[i], changes[j] );
+    }
+}
+
+bool vaLighting::SelfTestStaticShadowInvalidation( string * outInfo )
+{
+    // light 0 and 1 are 20 apart with range 5, light 2 has no light behind it (see UpdateShadowCasters)
+    const vector<vaBoundingSphere> lights = { vaBoundingSphere( vaVector3( 0, 0, 0 ), 5.0f ), vaBoundingSphere( vaVector3( 20, 0, 0 ), 5.0f ), vaBoundingSphere::Degenerate };
+
+    auto box = [ ]( float x, float y, float z ) { return vaBoundingBox( vaVector3( x - 0.5f, y - 0.5f, z - 0.5f ), vaVector3( 1, 1, 1 ) ); };
+    auto change = [ ]( bool wasStatic, const vaBoundingBox & before, bool isStatic, const vaBoundingBox & after )
+    {
+        vaShadowCasterChange ret;
+        ret.WasStatic = wasStatic; ret.BoundsBefore = before; ret.IsStatic = isStatic; ret.BoundsAfter = after;
+        return ret;
+    };
+    const vaBoundingBox none = vaBoundingBox::Degenerate;
+
+    vector<bool> needsRedraw;
+    auto check = [ & ]( const char * name, const vector<vaShadowCasterChange> & changes, bool expected0, bool expected1 ) -> bool
+    {
+        ComputeStaticShadowInvalidation( lights, changes, needsRedraw );
+        const bool expected[3] = { expected0, expected1, false };
+        if( needsRedraw.size( ) != lights.size( ) )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "'%s': %d results for %d lights", name, (int)needsRedraw.size( ), (int)lights.size( ) ) );
+        for( int i = 0; i < (int)lights.size( ); i++ )
+            if( needsRedraw[i] != expected[i] )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "'%s': light %d %s, expected the opposite", name, i, ( needsRedraw[i] ) ? ( "invalidated" ) : ( "not invalidated" ) ) );
+        return true;
+    };
+
+    // the records vaSceneObject::UpdateShadowCasterState and vaScene::DestroyObjectImmediate produce; bounds only count on the static side
+    if( !check( "static caster added",                  { change( false, none, true, box( 1, 0, 0 ) ) },                true,   false ) )   return false;
+    if( !check( "static caster moved between lights",   { change( true, box( 1, 0, 0 ), true, box( 19, 0, 0 ) ) },      true,   true  ) )   return false;
+    if( !check( "static caster became dynamic",         { change( true, box( 21, 0, 0 ), false, none ) },               false,  true  ) )   return false;
+    if( !check( "dynamic caster became static",         { change( false, none, true, box( 0, 3, 0 ) ) },                true,   false ) )   return false;
+    if( !check( "dynamic caster moved",                 { change( false, box( 1, 0, 0 ), false, box( 19, 0, 0 ) ) },   false,  false ) )   return false;
+    if( !check( "static caster moved out of range",     { change( true, box( 10, 0, 0 ), true, box( 10, 10, 0 ) ) },    false,  false ) )   return false;
+    if( !check( "static caster touching the range",     { change( false, none, true, box( 5.5f, 0, 0 ) ) },             true,   false ) )   return false;
+    if( !check( "static caster destroyed",              { change( true, box( 0, 0, 4.8f ), false, none ) },             true,   false ) )   return false;
+
+    // vaScene keeps the changes until ClearShadowCasterChanges: a destruction from outside of Tick (vaScene::Clear) and the next
+    // Tick's changes reach UpdateShadowCasters together, and after clearing the next call gets nothing and must invalidate nothing
+    if( !check( "destroyed outside of Tick + next Tick", { change( true, box( 1, 1, 1 ), false, none ), change( false, none, true, box( 20, 2, 0 ) ) }, true, true ) )
+        return false;
+    if( !check( "after ClearShadowCasterChanges",       { },                                                            false,  false ) )   return false;
+
+    return vaSelfTest::Pass( outInfo );
+}
+
+void vaLighting::UpdateShadowCasters( const vector<vaShadowCasterChange> & changes, const vector<vaBoundingBox> & dynamicCasterBounds )
+{
+    VA_TRACE_CPU_SCOPE( vaLighting_UpdateShadowCasters );
+
+    vector<vaBoundingSphere> lightVolumes( m_shadowmaps.size( ), vaBoundingSphere::Degenerate );
+    for( int i = 0; i < (int)m_shadowmaps.size( ); i++ )
+    {
+        shared_ptr<vaLight> light = m_shadowmaps[i]->GetLight( ).lock( );
+        if( light != nullptr )
+            lightVolumes[i] = vaBoundingSphere( light->Position, light->Range );
+    }
+
+    vector<bool> needsStaticRedraw;
+    if( changes.size( ) > 0 )
+        ComputeStaticShadowInvalidation( lightVolumes, changes, needsStaticRedraw );
+
+    for( int i = 0; i < (int)m_shadowmaps.size( ); i++ )
+    {
+        if( needsStaticRedraw.size( ) > 0 && needsStaticRedraw[i] )
+            m_shadowmaps[i]->InvalidateStaticLayer( );
+
+        bool hasDynamicCasters = false;
+        for( int j = 0; j < (int)dynamicCasterBounds.size( ) && !hasDynamicCasters; j++ )
+            hasDynamicCasters = dynamicCasterBounds[j].NearestDistanceToPoint( lightVolumes[i].Center ) <= lightVolumes[i].Radius;
+        m_shadowmaps[i]->SetIncludeDynamicObjects( hasDynamicCasters );
     }
-    return ret;
 }
 
 void vaLighting::DestroyShadowmapTextures( )
@@ -557,6 +846,7 @@ void vaLighting::DestroyShadowmapTextures( )
 
     //m_shadowCubeDepthTexture = nullptr;
     m_shadowCubeArrayTexture = nullptr;
+    m_shadowCubeStaticArrayTexture = nullptr;
     
     m_shadowmapTexturesCreated = false;
 }
@@ -587,6 +877,14 @@ void vaLighting::CreateShadowmapTextures( )
     m_shadowCubeArrayTexture = vaTexture::Create2D( GetRenderDevice(), cubeResFormat, m_shadowCubeResolution, m_shadowCubeResolution, 1, 6*m_shadowCubeMapCount, 1, vaResourceBindSupportFlags::ShaderResource | vaResourceBindSupportFlags::DepthStencil,
         vaResourceAccessFlags::Default, cubeSRVFormat, vaResourceFormat::Unknown, cubeDSVFormat, vaResourceFormat::Unknown, vaTextureFlags::Cubemap, vaTextureContentsType::DepthBuffer );
 
+    if( m_shadowCubeStaticCacheEnabled )
+    {
+        // never sampled, only rendered into and copied from
+        vaTexture::SetNextCreateFastClearDSV( cubeDSVFormat, 0.0f, 0 );
+        m_shadowCubeStaticArrayTexture = vaTexture::Create2D( GetRenderDevice(), cubeResFormat, m_shadowCubeResolution, m_shadowCubeResolution, 1, 6*m_shadowCubeMapCount, 1, vaResourceBindSupportFlags::DepthStencil,
+            vaResourceAccessFlags::Default, vaResourceFormat::Unknown, vaResourceFormat::Unknown, cubeDSVFormat, vaResourceFormat::Unknown, vaTextureFlags::None, vaTextureContentsType::DepthBuffer );
+    }
+
     m_shadowmapTexturesCreated = true;
 }
 
@@ -655,15 +953,39 @@ void vaShadowmap::Tick( float deltaTime )
    
     vaVector3 newLightPos = light->Position;
 
-    bool hasChanges = m_includeDynamicObjects;
     if( !m_lastLightState.NearEqual( *light ) )
     {
         m_lastLightState = *light;
-        hasChanges = true;
+        m_staticLayerDirty = true;
     }
 
+    bool hasChanges = m_includeDynamicObjects || m_hadDynamicCasters || m_staticLayerDirty;
+
     if( hasChanges ) 
         m_dataAge += deltaTime; 
+
+    // caster motion 'memory' halves every second
+    m_recentCasterMotion *= vaMath::Pow( 0.5f, deltaTime );
+}
+
+void vaShadowmap::UpdateCasterStats( const vaRenderMeshDrawList & casters, int drawCallCount )
+{
+    // Cheap signature of where the casters are: a moved caster changes the sum by its displacement. It can miss motion that cancels
+    // out, but it only feeds the update priority so that's fine.
+    vaVector3 signature( 0, 0, 0 );
+    for( int i = 0; i < casters.Count( ); i++ )
+        signature += casters[i].Transform.GetTranslation( );
+
+    if( m_lastCasterCount >= 0 )
+    {
+        const float range = vaMath::Max( VA_EPSf, m_lastLightState.Range );
+        float motion = ( m_lastCasterCount != casters.Count( ) ) ? ( 1.0f ) : ( vaMath::Saturate( ( signature - m_lastCasterSignature ).Length( ) / range ) );
+        m_recentCasterMotion = vaMath::Max( m_recentCasterMotion, motion );
+    }
+
+    m_lastCasterSignature   = signature;
+    m_lastCasterCount       = casters.Count( );
+    m_lastDrawCallCount     = drawCallCount;
 }
 
 void vaCubeShadowmap::Tick( float deltaTime )
@@ -697,6 +1019,15 @@ void vaCubeShadowmap::Tick( float deltaTime )
                 //     vaTextureFlags::Cubemap, 0, -1, i, 1 );
             }
 
+            const shared_ptr<vaTexture> & staticTextureArray = lighting->GetShadowCubeStaticArrayTexture( );
+            for( int i = 0; i < 6; i++ )
+            {
+                m_staticSliceDSVs[i] = ( staticTextureArray == nullptr ) ? ( nullptr ) : ( vaTexture::CreateView( staticTextureArray, vaResourceBindSupportFlags::DepthStencil, vaResourceFormat::Unknown, vaResourceFormat::Unknown, staticTextureArray->GetDSVFormat(), vaResourceFormat::Unknown, 
+                    vaTextureFlags::None, 0, 1, outTextureIndex*6+i, 1 ) );
+            }
+            m_staticLayerCached = m_staticSliceDSVs[0] != nullptr;
+            m_staticLayerDirty  = true;
+
         }
         else
         {
@@ -742,6 +1073,44 @@ void vaLighting::UIPanelTick( vaApplicationBase & application )
             shadowmap->Invalidate();
         }
     }
+
+    if( ImGui::CollapsingHeader( "Shadowmap update scheduling", ImGuiTreeNodeFlags_Framed ) )
+    {
+        ShadowmapSchedulerSettings & settings = m_shadowmapScheduler;
+        ImGui::InputInt( "DrawCallBudget", &settings.DrawCallBudget, 500 );
+        ImGui::InputInt( "MaxUpdatesPerFrame", &settings.MaxUpdatesPerFrame );
+        ImGui::SliderFloat( "ScreenInfluenceWeight", &settings.ScreenInfluenceWeight, 0.0f, 16.0f );
+        ImGui::SliderFloat( "DistanceWeight", &settings.DistanceWeight, 0.0f, 16.0f );
+        ImGui::SliderFloat( "CasterMotionWeight", &settings.CasterMotionWeight, 0.0f, 16.0f );
+        ImGui::SliderFloat( "CostExponent", &settings.CostExponent, 0.0f, 2.0f );
+        settings.DrawCallBudget     = vaMath::Max( 0, settings.DrawCallBudget );
+        settings.MaxUpdatesPerFrame = vaMath::Max( 1, settings.MaxUpdatesPerFrame );
+
+        ImGui::Text( "Last frame: %d stale, %d updated, ~%d draw calls", m_shadowmapSchedulerStats.Candidates, m_shadowmapSchedulerStats.Selected, m_shadowmapSchedulerStats.EstimatedDrawCalls );
+    }
+
+    if( ImGui::CollapsingHeader( "Clustered point & spot lights", ImGuiTreeNodeFlags_Framed ) )
+    {
+        ImGui::Checkbox( "Enabled", &m_lightClustersEnabled );
+        auto & settings = m_lightClusters.Settings( );
+        ImGui::InputInt( "CountX", &settings.CountX );
+        ImGui::InputInt( "CountY", &settings.CountY );
+        ImGui::InputInt( "CountZ", &settings.CountZ );
+        settings.Clamp( );
+
+        if( m_lightClustersActive )
+        {
+            const vaLightClusters::Output & output = m_lightClustersOutput;
+            ImGui::Text( "Last: %d lights, %d clusters, %d indices, max %d per cluster", m_lightClustersLastLightCount, output.Grid.ClusterCount( ), (int)output.LightIndices.size( ), output.MaxLightsPerCluster );
+        }
+        else
+            ImGui::Text( "Not active" );
+
+        if( ImGui::Button( "Validate against brute force reference" ) )
+            m_lightClustersValidateNext = true;
+        if( m_lightClustersValidateInfo != "" )
+            ImGui::TextWrapped( "%s", m_lightClustersValidateInfo.c_str( ) );
+    }
 #endif
 }
 
@@ -762,6 +1131,8 @@ void vaCubeShadowmap::UIPanelTick( vaApplicationBase & )
     {
         ImGui::Text( "Corresponding light: %s", light->Name.c_str( ) );
     }
+    ImGui::Text( "Estimated draw calls: %d, caster motion: %.2f, priority: %.3f", m_lastDrawCallCount, m_recentCasterMotion, m_lastSchedulingPriority );
+    ImGui::Text( "Static layer: %s, dynamic casters: %s", ( !m_staticLayerCached ) ? ( "not cached" ) : ( ( m_staticLayerDirty ) ? ( "dirty" ) : ( "cached" ) ), ( m_includeDynamicObjects ) ? ( "yes" ) : ( "no" ) );
 
     GetRenderDevice().GetTextureTools().UITickImGui( m_cubemapArraySRV );
 #endif
@@ -800,13 +1171,54 @@ void vaCubeShadowmap::SetToRenderSelectionFilter( vaRenderSelection::FilterSetti
     if( light == nullptr )
         return;
 
-    filter;
-    // make a frustum cube based on
-    // Position
-    // ClipFar
+    // only casters within the light range can affect the shadowmap; splitting them per cube face happens in Draw
+    filter.BoundingSphereTo = vaBoundingSphere( light->Position, light->Range );
+}
+
+vaDrawResultFlags vaCubeShadowmap::DrawFaces( vaRenderDeviceContext & renderContext, const vaCameraBase (&faceCameras)[6], const vaRenderMeshDrawList & casters, shared_ptr<vaTexture> (&destinationDSVs)[6], bool clear, int & outDrawCallCount )
+{
+    vaDrawResultFlags drawResults = vaDrawResultFlags::None;
+
+    m_casterBounds.resize( casters.Count( ) );
+    for( int j = 0; j < casters.Count( ); j++ )
+        m_casterBounds[j] = vaOrientedBoundingBox::FromAABBAndTransform( casters[j].Mesh->GetAABB( ), casters[j].Transform );
+
+    // draw all 6 faces - this should get optimized to GS in the future
+    for( int i = 0; i < 6; i++ )
+    {
+        // I hope this clears just the single slice on all HW
+        if( clear )
+            destinationDSVs[i]->ClearDSV( renderContext, true, faceCameras[i].GetUseReversedZ( ) ? ( 0.0f ) : ( 1.0f ), false, 0 );
+
+        // bin casters into this face's frustum
+        vaPlane facePlanes[6];
+        faceCameras[i].CalcFrustumPlanes( facePlanes );
+        m_faceCasters.Reset( );
+        for( int j = 0; j < casters.Count( ); j++ )
+        {
+            if( m_casterBounds[j].IntersectFrustum( facePlanes, _countof( facePlanes ) ) == vaIntersectType::Outside )
+                continue;
+            const vaRenderMeshDrawList::Entry & entry = casters[j];
+            m_faceCasters.Insert( entry.Mesh, entry.Material, entry.Transform, entry.ShadingRate, entry.CustomColor );
+        }
+        outDrawCallCount += m_faceCasters.Count( );
+        if( m_faceCasters.Count( ) == 0 )
+            continue;
+
+        vaSceneDrawContext drawContext( renderContext, faceCameras[i], vaDrawContextOutputType::DepthOnly, vaDrawContextFlags::None );
+        //drawContext.ViewspaceDepthOffsets = lightingSystem->GetShadowCubeViewspaceDepthOffsets();
+
+        renderContext.SetRenderTarget( nullptr, destinationDSVs[i], true );
+
+        drawResults |= GetRenderDevice().GetMeshManager().Draw( drawContext, m_faceCasters, vaBlendMode::Opaque, vaRenderMeshDrawFlags::EnableDepthTest | vaRenderMeshDrawFlags::EnableDepthWrite | vaRenderMeshDrawFlags::SkipNonShadowCasters );
+    }
+    // don't hold on to mesh/material references until the next update
+    m_faceCasters.Reset( );
+
+    return drawResults;
 }
 
-vaDrawResultFlags vaCubeShadowmap::Draw( vaRenderDeviceContext & renderContext, vaRenderSelection & renderSelection )
+vaDrawResultFlags vaCubeShadowmap::Draw( vaRenderDeviceContext & renderContext, vaRenderSelection & staticCasters, vaRenderSelection & dynamicCasters )
 {
     if( m_storageTextureIndex == -1 )
         return vaDrawResultFlags::UnspecifiedError;
@@ -833,73 +1245,85 @@ vaDrawResultFlags vaCubeShadowmap::Draw( vaRenderDeviceContext & renderContext,
     // cameraFrontCubeFace.SetOrientation( vaQuaternion::FromYawPitchRoll( 0.0f, 0.0f, 0.0f ) );
     // cameraFrontCubeFace.Tick( 0.0f, false );
 
+    vaVector3 position = cameraFrontCubeFace.GetPosition( );
+    vaCameraBase faceCameras[6] = { cameraFrontCubeFace, cameraFrontCubeFace, cameraFrontCubeFace, cameraFrontCubeFace, cameraFrontCubeFace, cameraFrontCubeFace };
+    for( int i = 0; i < 6; i++ )
+    {
+        vaVector3 lookAtDir, upVec;
+
+        // see https://msdn.microsoft.com/en-us/library/windows/desktop/bb204881(v=vs.85).aspx
+        switch( i )
+        {
+        case 0: // positive x (+y up)
+            lookAtDir   = vaVector3( 1.0f, 0.0f, 0.0f );
+            upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
+            break;
+        case 1: // negative x (+y up)
+            lookAtDir   = vaVector3( -1.0f, 0.0f, 0.0f );
+            upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
+            break;
+        case 2: // positive y (-z up)
+            lookAtDir   = vaVector3( 0.0f, 1.0f, 0.0f );
+            upVec       = vaVector3( 0.0f, 0.0f, -1.0f );
+            break;
+        case 3: // negative y (z up)
+            lookAtDir   = vaVector3( 0.0f, -1.0f, 0.0f );
+            upVec       = vaVector3( 0.0f, 0.0f, 1.0f );
+            break;
+        case 4: // positive z (y up)
+            lookAtDir   = vaVector3( 0.0f, 0.0f, 1.0f );
+            upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
+            break;
+        case 5: // negative z (y up)
+            lookAtDir   = vaVector3( 0.0f, 0.0f, -1.0f );
+            upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
+            break;
+        }
+
+        faceCameras[i].SetOrientationLookAt( position + lookAtDir, upVec );
+        faceCameras[i].Tick( 0, false );
+    }
+
     vaDrawResultFlags drawResults = vaDrawResultFlags::None;
+    int drawCallCount = 0;
+    const bool staticCached = m_staticLayerCached;
 
-    shared_ptr<vaTexture> * destinationCubeDSVs = m_cubemapSliceDSVs;
     //shared_ptr<vaTexture> * destinationCubeRTVs = m_cubemapArrayRTVs;
     {
         VA_TRACE_CPUGPU_SCOPE( CubemapDepthOnly, renderContext );
 
         vaRenderDeviceContext::RenderOutputsState outputs = renderContext.GetOutputs();
 
-        vaVector3 position = cameraFrontCubeFace.GetPosition( );
-        vaCameraBase tempCamera = cameraFrontCubeFace;
-
-        // draw all 6 faces - this should get optimized to GS in the future
-        for( int i = 0; i < 6; i++ )
+        if( !staticCached )
         {
-            // I hope this clears just the single slice on all HW
-            destinationCubeDSVs[i]->ClearDSV( renderContext, true, cameraFrontCubeFace.GetUseReversedZ( ) ? ( 0.0f ) : ( 1.0f ), false, 0 );
-            // destinationCubeRTVs[i]->ClearRTV( renderContext, vaVector4( 10000.0f, 10000.0f, 10000.0f, 10000.0f ) );
-
-            vaVector3 lookAtDir, upVec;
-
-            // see https://msdn.microsoft.com/en-us/library/windows/desktop/bb204881(v=vs.85).aspx
-            switch( i )
-            {
-            case 0: // positive x (+y up)
-                lookAtDir   = vaVector3( 1.0f, 0.0f, 0.0f );
-                upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
-                break;
-            case 1: // negative x (+y up)
-                lookAtDir   = vaVector3( -1.0f, 0.0f, 0.0f );
-                upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
-                break;
-            case 2: // positive y (-z up)
-                lookAtDir   = vaVector3( 0.0f, 1.0f, 0.0f );
-                upVec       = vaVector3( 0.0f, 0.0f, -1.0f );
-                break;
-            case 3: // negative y (z up)
-                lookAtDir   = vaVector3( 0.0f, -1.0f, 0.0f );
-                upVec       = vaVector3( 0.0f, 0.0f, 1.0f );
-                break;
-            case 4: // positive z (y up)
-                lookAtDir   = vaVector3( 0.0f, 0.0f, 1.0f );
-                upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
-                break;
-            case 5: // negative z (y up)
-                lookAtDir   = vaVector3( 0.0f, 0.0f, -1.0f );
-                upVec       = vaVector3( 0.0f, 1.0f, 0.0f );
-                break;
-            }
-
-            tempCamera.SetOrientationLookAt( position + lookAtDir, upVec );
-            tempCamera.Tick( 0, false );
-        
-            vaSceneDrawContext drawContext( renderContext, tempCamera, vaDrawContextOutputType::DepthOnly, vaDrawContextFlags::None );
-            //drawContext.ViewspaceDepthOffsets = lightingSystem->GetShadowCubeViewspaceDepthOffsets();
+            // no static layer: everything, every time
+            drawResults |= DrawFaces( renderContext, faceCameras, *staticCasters.MeshList, m_cubemapSliceDSVs, true, drawCallCount );
+            drawResults |= DrawFaces( renderContext, faceCameras, *dynamicCasters.MeshList, m_cubemapSliceDSVs, false, drawCallCount );
+        }
+        else
+        {
+            if( m_staticLayerDirty )
+                drawResults |= DrawFaces( renderContext, faceCameras, *staticCasters.MeshList, m_staticSliceDSVs, true, drawCallCount );
 
-            //renderContext.SetRenderTarget( nullptr, destinationCubeDepth, true );
-            renderContext.SetRenderTarget( nullptr, destinationCubeDSVs[i], true );
+            // start from the static layer (both arrays have a single MIP so the subresource index is the slice index)
+            const shared_ptr<vaTexture> & staticTextureArray = lightingSystem->GetShadowCubeStaticArrayTexture( );
+            const shared_ptr<vaTexture> & storageTextureArray = m_cubemapSliceDSVs[0]->GetViewedOriginal( );
+            for( int i = 0; i < 6; i++ )
+                staticTextureArray->CopySubresource( renderContext, storageTextureArray, m_storageTextureIndex*6+i, m_storageTextureIndex*6+i );
 
-            drawResults |= GetRenderDevice().GetMeshManager().Draw( drawContext, *renderSelection.MeshList, vaBlendMode::Opaque, vaRenderMeshDrawFlags::EnableDepthTest | vaRenderMeshDrawFlags::EnableDepthWrite | vaRenderMeshDrawFlags::SkipNonShadowCasters );
+            drawResults |= DrawFaces( renderContext, faceCameras, *dynamicCasters.MeshList, m_cubemapSliceDSVs, false, drawCallCount );
         }
 
         renderContext.SetOutputs(outputs);
     }
 
     if( drawResults == vaDrawResultFlags::None )
+    {
+        UpdateCasterStats( *dynamicCasters.MeshList, drawCallCount );
+        m_staticLayerDirty      = false;
+        m_hadDynamicCasters     = dynamicCasters.MeshList->Count( ) > 0;
         SetUpToDate();
+    }
     return drawResults;
 }
 
@@ -37,12 +37,25 @@
 
 #include "vaIBL.h"
 
+#include "vaLightClusters.h"
+
 namespace Vanilla
 {
     class vaGBuffer;
 
     class vaShadowmap;
 
+    // A change in the set of static shadow casters, as reported by the scene each tick: a caster becoming static (came to rest or
+    // got added), stopping being static (started moving or got removed) or a static caster's bounds changing. Moves of casters
+    // that are already dynamic are not reported - they get drawn on top of the cached static shadow layer every update anyway.
+    struct vaShadowCasterChange
+    {
+        vaBoundingBox                                   BoundsBefore            = vaBoundingBox::Degenerate;    // world space; only used if WasStatic
+        vaBoundingBox                                   BoundsAfter             = vaBoundingBox::Degenerate;    // world space; only used if IsStatic
+        bool                                            WasStatic               = false;
+        bool                                            IsStatic                = false;
+    };
+
     // this isn't optimized for size/efficiency
     struct vaLight : public vaXMLSerializable, public vaUIPropertiesItem
     {
@@ -161,6 +174,25 @@ namespace Vanilla
     class vaLighting : public vaRenderingModule, public vaUIPanel, public std::enable_shared_from_this<vaLighting>
     {
     public:
+        // Stale shadowmaps get picked for update each frame by priority (data age x weight, see SelectShadowmapsForRendering), as many
+        // as fit into the budget. The weight favors lights covering more of the screen, closer lights and lights with recently moving
+        // casters; dividing by the relative cost lets cheap lights refresh more often than expensive ones.
+        struct ShadowmapSchedulerSettings
+        {
+            int                                         DrawCallBudget          = 6000;     // estimated draw calls (casters x faces) per frame; the top priority shadowmap always goes through even if over
+            int                                         MaxUpdatesPerFrame      = 4;
+            float                                       ScreenInfluenceWeight   = 4.0f;     // extra weight for a light covering the whole screen vs. one outside of the view
+            float                                       DistanceWeight          = 1.0f;     // extra weight for a light at the camera, dropping off with distance (in light ranges)
+            float                                       CasterMotionWeight      = 4.0f;     // extra weight for a light whose casters recently moved by about its range
+            float                                       CostExponent            = 0.5f;     // priority gets divided by (cost / average cost) ^ CostExponent; 0 ignores cost
+        };
+
+        struct ShadowmapSchedulerStats
+        {
+            int                                         Candidates              = 0;        // stale shadowmaps this frame
+            int                                         Selected                = 0;
+            int                                         EstimatedDrawCalls      = 0;        // sum over selected
+        };
 
     protected:
         string                                          m_debugInfo;
@@ -193,14 +225,44 @@ namespace Vanilla
         //vaResourceFormat                                m_shadowCubeFormat          = vaResourceFormat::R16_UNORM;  // R16_FLOAT not supported for compare sampler!!! not sure about R32_FLOAT?
         shared_ptr<vaTexture>                           m_shadowCubeArrayTexture;
         weak_ptr<vaShadowmap>                           m_shadowCubeArrayCurrentUsers[m_shadowCubeMapCount];
+        const bool                                      m_shadowCubeStaticCacheEnabled  = true; // doubles the cube shadow memory but static casters only get redrawn when they (or the light) change
+        shared_ptr<vaTexture>                           m_shadowCubeStaticArrayTexture;         // same layout as m_shadowCubeArrayTexture, static casters only
         //shared_ptr<vaTexture>                           m_shadowCubeDepthTexture;
 
+        ShadowmapSchedulerSettings                      m_shadowmapScheduler;
+        ShadowmapSchedulerStats                         m_shadowmapSchedulerStats;
+        struct ShadowmapCandidate
+        {
+            float                                       Priority;
+            float                                       Cost;
+            int                                         Index;
+        };
+        vector<ShadowmapCandidate>                      m_shadowmapSchedulerCandidates;
+
         float                                           m_shadowCubeDepthBiasScale  = 1.2f;
         float                                           m_shadowCubeFilterKernelSize= 1.5f;
 
         vaTypedConstantBufferWrapper< LightingShaderConstants >
                                                         m_constantsBuffer;
 
+        // Clustered point & spot lights (see vaLightClusters): all of them go into m_lightClusterLightsTexture, binned for the draw context's camera.
+        // The LightsSpotAndPoint constant array still gets the first ShaderLightSpot::MaxLights for shaders that don't use clusters (particles).
+        bool                                            m_lightClustersEnabled      = true;
+        bool                                            m_lightClustersActive       = false;    // clusters were set up for the last UpdateShaderConstants
+        vaLightClusters                                 m_lightClusters;
+        vaLightClusters::Output                         m_lightClustersOutput;
+        vector<ShaderLightSpot>                         m_lightClustersLights;                  // lights used for the current binning (and upload staging, padded to texture height)
+        vector<uint32>                                  m_lightClustersIndicesStaging;
+        vaMatrix4x4                                     m_lightClustersLastView;                // skip re-binning if called again for the same camera & lights (multiple passes per frame)
+        vaMatrix4x4                                     m_lightClustersLastProj;
+        vaVector3                                       m_lightClustersLastWorldBase;
+        int                                             m_lightClustersLastLightCount = -1;
+        bool                                            m_lightClustersValidateNext = false;
+        string                                          m_lightClustersValidateInfo;
+        shared_ptr<vaTexture>                           m_lightClusterLightsTexture;
+        shared_ptr<vaTexture>                           m_lightClusterGridTexture;
+        shared_ptr<vaTexture>                           m_lightClusterIndicesTexture;
+
 //        shared_ptr<vaLight>
 
         // vaAutoRMI<vaPixelShader>                        m_applyDirectionalAmbientPS;
@@ -219,6 +281,8 @@ namespace Vanilla
 
     protected:
         void                                            UpdateShaderConstants( vaSceneDrawContext & drawContext );
+        // bins & uploads lights (already in shader form) and fills the cluster part of consts; returns false if clustering isn't used
+        bool                                            UpdateLightClusters( vaSceneDrawContext & drawContext, const vector<ShaderLightSpot> & lights, LightingShaderConstants & consts );
         //const shared_ptr<vaConstantBuffer> &            GetConstantsBuffer( ) const                                                             { return m_constantsBuffer.GetBuffer(); };
         //const shared_ptr<vaTexture> &                   GetEnvmapTexture( ) const                                                               { return m_envmapTexture; }
         //const shared_ptr<vaTexture> &                   GetShadowCubeArrayTexture( ) const                                                      { return m_shadowCubeArrayTexture; }
@@ -245,8 +309,25 @@ namespace Vanilla
 
         void                                            Tick( float deltaTime );
 
-        // call vaShadowmap::SetUpToDate() to make 'fresh' - 'fresh' ones will not get returned by this function, and if there's no dirty ones left it will return nullptr
-        shared_ptr<vaShadowmap>                         GetNextHighestPriorityShadowmapForRendering( );
+        // Fills outShadowmaps with the stale shadowmaps to draw this frame, highest priority first, within the ShadowmapScheduler( ) budget.
+        // Drawing calls vaShadowmap::SetUpToDate() to make them 'fresh' - 'fresh' ones are never returned so outShadowmaps is empty once all are up to date.
+        void                                            SelectShadowmapsForRendering( const vaCameraBase & mainCamera, vector<shared_ptr<vaShadowmap>> & outShadowmaps );
+
+        ShadowmapSchedulerSettings &                    ShadowmapScheduler( )                                                                   { return m_shadowmapScheduler; }
+        const ShadowmapSchedulerStats &                 GetShadowmapSchedulerStats( ) const                                                     { return m_shadowmapSchedulerStats; }
+
+        // Call once per frame before Tick with the scene's caster changes and the current bounds of all dynamic casters (see vaScene::GetShadowCasterChanges);
+        // invalidates cached static shadow layers affected by the changes and flags shadowmaps with dynamic casters in range for regular updates.
+        void                                            UpdateShadowCasters( const vector<vaShadowCasterChange> & changes, const vector<vaBoundingBox> & dynamicCasterBounds );
+
+        // The static shadow layer invalidation model, with no dependency on the render device or the scene. A change affects a light if the
+        // static caster it describes overlapped the light volume before or overlaps it after; outNeedsStaticRedraw[i] is for lightVolumes[i].
+        static bool                                     IsStaticShadowAffected( const vaBoundingSphere & lightVolume, const vaShadowCasterChange & change );
+        static void                                     ComputeStaticShadowInvalidation( const vector<vaBoundingSphere> & lightVolumes, const vector<vaShadowCasterChange> & changes, vector<bool> & outNeedsStaticRedraw );
+
+        // Known answers for the above: static vs dynamic caster changes, range edges, lights without a volume and the accumulate
+        // until cleared contract of vaScene::GetShadowCasterChanges; describes the first failure in outInfo (see vaSelfTest).
+        static bool                                     SelfTestStaticShadowInvalidation( string * outInfo = nullptr );
 
         // vaVector4                                       GetShadowCubeViewspaceDepthOffsets( ) const                                             { return vaVector4( m_shadowCubeFlatOffsetAdd / (float)m_shadowCubeResolution, m_shadowCubeFlatOffsetScale / (float)m_shadowCubeResolution, m_shadowCubeSlopeOffsetAdd / (float)m_shadowCubeResolution, m_shadowCubeSlopeOffsetScale / (float)m_shadowCubeResolution ); }
 
@@ -264,6 +345,9 @@ namespace Vanilla
         // could add a 'deallocate' if vaShadowmap wants to detach for any reason, but not sure that's needed - they get destroyed anyway when not needed and that removes them from this list
         bool                                            AllocateShadowStorageTextureIndex( const shared_ptr<vaShadowmap> & shadowmap, int & outTextureIndex, shared_ptr<vaTexture> & outTextureArray );
 
+        // nullptr if static shadow caching is disabled
+        const shared_ptr<vaTexture> &                   GetShadowCubeStaticArrayTexture( ) const                                                { return m_shadowCubeStaticArrayTexture; }
+
         // // if using cubemap shadows this is one depth buffer used for rendering all of them
         // const shared_ptr<vaTexture> &                   GetCubemapDepthTexture( )                                              { return m_shadowCubeDepthTexture; }
 
@@ -285,6 +369,18 @@ namespace Vanilla
         bool                                            m_includeDynamicObjects = false;
         float                                           m_dataAge = VA_FLOAT_HIGHEST;
 
+        // static casters are cached in a separate layer (if the shadowmap type and vaLighting support it), redrawn only when invalidated; dynamic casters go on top of a copy of it
+        bool                                            m_staticLayerCached     = false;    // set by the implementation if it has storage for the static layer
+        bool                                            m_staticLayerDirty      = true;
+        bool                                            m_hadDynamicCasters     = false;    // last Draw included dynamic casters - one more update is needed to remove them once they're gone
+
+        // scheduling inputs, updated on Draw through UpdateCasterStats (see vaLighting::SelectShadowmapsForRendering)
+        int                                             m_lastDrawCallCount     = -1;       // -1 if never drawn
+        int                                             m_lastCasterCount       = -1;
+        vaVector3                                       m_lastCasterSignature   = vaVector3( 0, 0, 0 );
+        float                                           m_recentCasterMotion    = 0.0f;     // 0 - static, 1 - casters moved by about the light range; decays over time
+        float                                           m_lastSchedulingPriority= 0.0f;
+
     protected:
         vaShadowmap( ) = delete;
         vaShadowmap( vaRenderDevice & device, const shared_ptr<vaLighting> & lightingSystem, const shared_ptr<vaLight> & light ) : vaRenderingModule( vaRenderingModuleParams(device) ), vaUIPanel("SM", 0, false, vaUIPanel::DockLocation::DockedLeftBottom, "ShadowMaps" ), m_lightingSystem( lightingSystem ), m_light( light ) { }
@@ -297,6 +393,9 @@ namespace Vanilla
         const weak_ptr<vaLight> &                       GetLight( ) const { return m_light; }
         int                                             GetStorageTextureIndex( ) const { return m_storageTextureIndex; }
         const float                                     GetDataAge( ) const { return m_dataAge; }
+        int                                             GetEstimatedDrawCallCount( ) const { return m_lastDrawCallCount; }
+        float                                           GetRecentCasterMotion( ) const { return m_recentCasterMotion; }
+        float                                           GetLastSchedulingPriority( ) const { return m_lastSchedulingPriority; }
 
         const vaLight &                                 GetLastLightState( ) const { return m_lastLightState; }
 
@@ -305,16 +404,25 @@ namespace Vanilla
         virtual void                                    Tick( float deltaTime );
 
         void                                            Invalidate( )                                       { m_lastLightState.Reset( ); }
+        void                                            InvalidateStaticLayer( )                            { m_staticLayerDirty = true; }
+        bool                                            NeedsStaticCasters( ) const                         { return m_staticLayerDirty || !m_staticLayerCached; }
         void                                            SetUpToDate( )                                      { m_dataAge = 0; }
         void                                            SetIncludeDynamicObjects( bool includeDynamic )     { m_includeDynamicObjects = includeDynamic; }
 
         // create draw filter
         virtual void                                    SetToRenderSelectionFilter( vaRenderSelection::FilterSettings & filter ) const = 0 ;
-        // draw
-        virtual vaDrawResultFlags                       Draw( vaRenderDeviceContext & renderContext, vaRenderSelection & renderSelection ) = 0;
+        // draw; staticCasters are only used (and only need to be selected) if NeedsStaticCasters( )
+        virtual vaDrawResultFlags                       Draw( vaRenderDeviceContext & renderContext, vaRenderSelection & staticCasters, vaRenderSelection & dynamicCasters ) = 0;
 
         virtual string                                  UIPropertiesItemGetDisplayName( ) const override    { return UIPanelGetDisplayName(); }
         virtual void                                    UIPropertiesItemTick( vaApplicationBase & ) override                    { assert( false ); } //return UIPanelTick(); }
+
+    protected:
+        // call from Draw with the casters that got drawn - updates the cost estimate and detects caster motion since the last draw
+        void                                            UpdateCasterStats( const vaRenderMeshDrawList & casters, int drawCallCount );
+
+    private:
+        friend class vaLighting;
     };
 
     // for point/spot lights
@@ -324,6 +432,11 @@ namespace Vanilla
         std::shared_ptr<vaTexture>                      m_cubemapArraySRV;      // array SRV into the big cube texture pointing to the beginning and of size of 6
         //std::shared_ptr<vaTexture>                      m_cubemapArrayRTVs[6];  // RTVs each pointing at the beginning + n (n goes from 0 to 5)
         std::shared_ptr<vaTexture>                      m_cubemapSliceDSVs[6];  // temp DSVs used to render the cubemap
+        std::shared_ptr<vaTexture>                      m_staticSliceDSVs[6];   // same for the static caster layer (nullptr if not cached)
+
+        // Draw bins casters from the (light range culled) render selection into per-face lists; kept around to avoid reallocations
+        vector<vaOrientedBoundingBox>                   m_casterBounds;         // world space bounds of each renderSelection.MeshList entry
+        vaRenderMeshDrawList                            m_faceCasters;          // casters overlapping the cube face currently being drawn
 
     protected:
         friend class vaShadowmap;
@@ -335,9 +448,12 @@ namespace Vanilla
 
     protected:
         virtual void                                    SetToRenderSelectionFilter( vaRenderSelection::FilterSettings & filter ) const;
-        virtual vaDrawResultFlags                       Draw( vaRenderDeviceContext & renderContext, vaRenderSelection & renderSelection );
+        virtual vaDrawResultFlags                       Draw( vaRenderDeviceContext & renderContext, vaRenderSelection & staticCasters, vaRenderSelection & dynamicCasters );
         virtual void                                    Tick( float deltaTime );
 
+        // draws casters (binned per face) into all 6 destination faces; clears them first if clear is set
+        vaDrawResultFlags                               DrawFaces( vaRenderDeviceContext & renderContext, const vaCameraBase (&faceCameras)[6], const vaRenderMeshDrawList & casters, shared_ptr<vaTexture> (&destinationDSVs)[6], bool clear, int & outDrawCallCount );
+
     protected:
         virtual string                                  UIPanelGetDisplayName( ) const override { return vaStringTools::Format( "Cubemap [%s]", m_lastLightState.Name.c_str() ); }
         virtual void                                    UIPanelTick( vaApplicationBase & application ) override;
@@ -25,6 +25,7 @@
 #include "vaAssetPack.h"
 
 #include "Rendering/vaRenderMesh.h"
+#include "Rendering/vaStandardShapes.h"
 #include "Rendering/vaRenderMaterial.h"
 
 #include "Rendering/vaDebugCanvas.h"
@@ -75,6 +76,7 @@ void vaRenderDevice::InitializeBase( )
     m_canvas3D  = shared_ptr< vaDebugCanvas3D >( new vaDebugCanvas3D( vaRenderingModuleParams( *this ) ) );
 
     m_textureTools = std::make_shared<vaTextureTools>( *this );
+    m_texturePool = std::make_shared<vaTexturePool>( *this );
     m_renderMaterialManager = std::make_shared<vaRenderMaterialManager>( *this ); // shared_ptr<vaRenderMaterialManager>( VA_RENDERING_MODULE_CREATE( vaRenderMaterialManager, *this ) );
     m_renderMeshManager = shared_ptr<vaRenderMeshManager>( VA_RENDERING_MODULE_CREATE( vaRenderMeshManager, *this ) );
     m_assetPackManager = std::make_shared<vaAssetPackManager>( *this );//shared_ptr<vaAssetPackManager>( VA_RENDERING_MODULE_CREATE( vaAssetPackManager, *this ) );
@@ -170,10 +172,12 @@ void vaRenderDevice::DeinitializeBase( )
     m_canvas3D                      = nullptr;
     m_assetPackManager              = nullptr;
     m_textureTools                  = nullptr;
+    m_texturePool                   = nullptr;
     m_postProcess                   = nullptr;
     m_renderMaterialManager         = nullptr;
     m_renderMeshManager             = nullptr;
     m_shaderManager                 = nullptr;
+    vaStandardShapes::ClearCache( );
     vaBackgroundTaskManager::GetInstancePtr()->ClearAndRestart();
 }
 
@@ -187,7 +191,19 @@ vaRenderDevice::~vaRenderDevice( )
 
 void vaRenderDevice::ExecuteAsyncBeginFrameCallbacks( float deltaTime )
 {
-    m_asyncBeginFrameCallbacks.Invoke( *this, deltaTime );
+    {
+        VA_TRACE_CPU_SCOPE( AsyncBeginFrameCallbacks );
+        m_asyncBeginFrameCallbacks.Invoke( m_asyncBeginFrameCallbacksTimeBudget, *this, deltaTime );
+    }
+
+    static vaTracer::Counter * const counterInvoked     = vaTracer::FindOrCreateCounter( "AsyncBeginFrameCallbacks_Invoked" );
+    static vaTracer::Counter * const counterRemaining   = vaTracer::FindOrCreateCounter( "AsyncBeginFrameCallbacks_Remaining" );
+    static vaTracer::Counter * const counterTimeMS      = vaTracer::FindOrCreateCounter( "AsyncBeginFrameCallbacks_TimeMS" );
+
+    const auto & stats = m_asyncBeginFrameCallbacks.GetLastStats( );
+    vaTracer::AddCounterSample( counterInvoked, stats.Invoked );
+    vaTracer::AddCounterSample( counterRemaining, stats.Remaining );
+    vaTracer::AddCounterSample( counterTimeMS, stats.TimeSpent * 1000.0 );
 }
 
 vaTextureTools & vaRenderDevice::GetTextureTools( )
@@ -197,6 +213,12 @@ vaTextureTools & vaRenderDevice::GetTextureTools( )
     return *m_textureTools;
 }
 
+vaTexturePool & vaRenderDevice::GetTexturePool( )
+{
+    assert( m_texturePool != nullptr );
+    return *m_texturePool;
+}
+
 vaRenderMaterialManager & vaRenderDevice::GetMaterialManager( )
 {
     assert( m_renderMaterialManager != nullptr );
@@ -241,6 +263,32 @@ void vaRenderDevice::BeginFrame( float deltaTime )
     m_frameStarted = true;
     m_currentFrameIndex++;
 
+    // everything allocated from vaFrameArena-s during the previous frame is now invalid
+    vaFrameArena::NewFrame( );
+
+    {
+        int64 allocationCount = vaMemory::GetAllocationCount( );
+        if( allocationCount >= 0 && m_frameStartAllocationCount >= 0 )
+        {
+            static vaTracer::Counter * const counterHeapAllocations = vaTracer::FindOrCreateCounter( "FrameHeapAllocations" );
+            m_lastFrameAllocationCount = allocationCount - m_frameStartAllocationCount;
+            vaTracer::AddCounterSample( counterHeapAllocations, (double)m_lastFrameAllocationCount );
+        }
+        m_frameStartAllocationCount = allocationCount;
+    }
+
+    if( m_texturePool != nullptr )
+    {
+        static vaTracer::Counter * const counterHitRate     = vaTracer::FindOrCreateCounter( "TexturePool_HitRate" );
+        static vaTracer::Counter * const counterPooledMB    = vaTracer::FindOrCreateCounter( "TexturePool_PooledMB" );
+        static vaTracer::Counter * const counterEvictedMB   = vaTracer::FindOrCreateCounter( "TexturePool_EvictedMB" );
+
+        const vaTexturePool::Statistics poolStats = m_texturePool->GetStatistics( );
+        vaTracer::AddCounterSample( counterHitRate, poolStats.HitRate( ) );
+        vaTracer::AddCounterSample( counterPooledMB, poolStats.PooledBytes / ( 1024.0 * 1024.0 ) );
+        vaTracer::AddCounterSample( counterEvictedMB, poolStats.EvictedBytes / ( 1024.0 * 1024.0 ) );
+    }
+
     if( m_mainDeviceContext != nullptr )
         m_mainDeviceContext->SetRenderTarget( GetCurrentBackbuffer(), nullptr, true );
 
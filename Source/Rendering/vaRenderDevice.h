@@ -38,6 +38,7 @@ namespace Vanilla
     struct vaSceneDrawContext;
 
     class vaTextureTools;
+    class vaTexturePool;
     class vaRenderMaterialManager;
     class vaRenderMeshManager;
     class vaAssetPackManager;
@@ -75,6 +76,7 @@ namespace Vanilla
     {
         vaThreadSpecificAsyncCallbackQueue< vaRenderDevice &, float >
                                                 m_asyncBeginFrameCallbacks;
+        double                                  m_asyncBeginFrameCallbacksTimeBudget    = 0.004;    // in seconds; whatever doesn't fit waits for the next frame
 
     public:
         vaEvent<void(vaRenderDevice &)>         e_DeviceFullyInitialized;
@@ -106,6 +108,9 @@ namespace Vanilla
 
         int64                                   m_currentFrameIndex            = 0;
 
+        int64                                   m_frameStartAllocationCount    = -1;
+        int64                                   m_lastFrameAllocationCount     = -1;
+
         shared_ptr<vaDebugCanvas2D>             m_canvas2D;
         shared_ptr<vaDebugCanvas3D>             m_canvas3D;
 
@@ -115,6 +120,7 @@ namespace Vanilla
 
         // maybe do https://en.cppreference.com/w/cpp/memory/shared_ptr/atomic2 for the future...
         shared_ptr<vaTextureTools>              m_textureTools;
+        shared_ptr<vaTexturePool>               m_texturePool;
         shared_ptr<vaRenderGlobals>             m_renderGlobals;
         shared_ptr<vaRenderMaterialManager>     m_renderMaterialManager;
         shared_ptr<vaRenderMeshManager>         m_renderMeshManager;
@@ -194,6 +200,9 @@ namespace Vanilla
         double                              GetTotalTime( ) const                                                       { return m_totalTime; }
         int64                               GetCurrentFrameIndex( ) const                                               { return m_currentFrameIndex; }
 
+        // number of heap allocations (on all threads) between the last two BeginFrame calls; -1 unless VA_MEMORY_ALLOCATION_COUNTING_ENABLED
+        int64                               GetLastFrameAllocationCount( ) const                                        { return m_lastFrameAllocationCount; }
+
         vaRenderDeviceContext *             GetMainContext( ) const                                                     { assert( IsRenderThread() ); return m_mainDeviceContext.get(); }
                 
         vaDebugCanvas2D &                   GetCanvas2D( )                                                              { return *m_canvas2D; }
@@ -225,7 +234,12 @@ namespace Vanilla
         //  2.) if it is added from the render thread and you call .wait() before it executed, it will deadlock
         //  3.) otherwise feel free to .get()/.wait() on the future
         //  4.) if device gets destroyed with some callbacks enqueued, they will get called during destruction but with deltaTime set to std::numeric_limits<float>::lowest() and no more callbacks will be allowed to get added
-        std::future<bool>                   AsyncInvokeAtBeginFrame( std::function<bool( vaRenderDevice &, float deltaTime )> && callback )  { return m_asyncBeginFrameCallbacks.Enqueue( std::forward<decltype(callback)>(callback) ); }
+        //  5.) callbacks run in priority order and only for as long as the per-frame time budget allows (at least one per frame), so there's no guarantee they run in the next frame;
+        //      use vaAsyncCallbackPriority::High when something is blocked waiting on the result
+        std::future<bool>                   AsyncInvokeAtBeginFrame( std::function<bool( vaRenderDevice &, float deltaTime )> && callback, vaAsyncCallbackPriority priority = vaAsyncCallbackPriority::Normal )  { return m_asyncBeginFrameCallbacks.Enqueue( std::forward<decltype(callback)>(callback), priority ); }
+
+        double                              GetAsyncBeginFrameCallbacksTimeBudget( ) const          { return m_asyncBeginFrameCallbacksTimeBudget; }
+        void                                SetAsyncBeginFrameCallbacksTimeBudget( double seconds ) { assert( IsRenderThread() ); m_asyncBeginFrameCallbacksTimeBudget = vaMath::Max( 0.0, seconds ); }
 
 
     protected:
@@ -241,6 +255,7 @@ namespace Vanilla
     public:
         // These are essentially API dependencies - they require graphics API to be initialized so there's no point setting them up separately
         vaTextureTools &                    GetTextureTools( );
+        vaTexturePool &                     GetTexturePool( );
         vaRenderMaterialManager &           GetMaterialManager( );
         vaRenderMeshManager &               GetMeshManager( );
         vaAssetPackManager &                GetAssetPackManager( );
@@ -454,6 +454,7 @@ bool vaRenderMaterial::SetupFromOther( const vaRenderMaterial & other )
             assert( false );
         }
     }
+    RebuildNameHashes( );
 
     return true;
 }
@@ -589,6 +590,7 @@ void vaRenderMaterial::RemoveAllNodes( )
 {
     assert( !m_immutable );
     m_nodes.clear();
+    m_nodeNameHashes.clear();
     m_inputsDirty = true;
 }
 
@@ -596,9 +598,62 @@ void vaRenderMaterial::RemoveAllInputSlots( )
 {
     assert( !m_immutable );
     m_inputSlots.clear( );
+    m_inputSlotNameHashes.clear( );
     m_inputsDirty = true;
 }
 
+uint64 vaRenderMaterial::FoldedNameHash( const string & name )
+{
+    // FNV-1a of the lowercase name
+    uint64 hash = 0xcbf29ce484222325ull;
+    for( char c : name )
+    {
+        hash ^= (uint64)(uint8)::tolower( (uint8)c );
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool vaRenderMaterial::FoldedNamesEqual( const string & left, const string & right )
+{
+    if( left.size( ) != right.size( ) )
+        return false;
+    for( size_t i = 0; i < left.size( ); i++ )
+        if( ::tolower( (uint8)left[i] ) != ::tolower( (uint8)right[i] ) )
+            return false;
+    return true;
+}
+
+void vaRenderMaterial::RebuildNameHashes( )
+{
+    m_nodeNameHashes.resize( m_nodes.size( ) );
+    for( size_t i = 0; i < m_nodes.size( ); i++ )
+        m_nodeNameHashes[i] = FoldedNameHash( m_nodes[i]->Name );
+    m_inputSlotNameHashes.resize( m_inputSlots.size( ) );
+    for( size_t i = 0; i < m_inputSlots.size( ); i++ )
+        m_inputSlotNameHashes[i] = FoldedNameHash( m_inputSlots[i].Name );
+}
+
+int vaRenderMaterial::FindNodeIndex( const string & name ) const
+{
+    assert( m_nodeNameHashes.size( ) == m_nodes.size( ) );  // m_nodes changed without updating m_nodeNameHashes?
+    const uint64 hash = FoldedNameHash( name );
+    for( int i = 0; i < (int)m_nodeNameHashes.size( ); i++ )
+        if( m_nodeNameHashes[i] == hash && FoldedNamesEqual( m_nodes[i]->Name, name ) )
+            return i;
+    return -1;
+}
+
+int vaRenderMaterial::FindInputSlotIndex( const string & name ) const
+{
+    assert( m_inputSlotNameHashes.size( ) == m_inputSlots.size( ) );  // m_inputSlots changed without updating m_inputSlotNameHashes?
+    const uint64 hash = FoldedNameHash( name );
+    for( int i = 0; i < (int)m_inputSlotNameHashes.size( ); i++ )
+        if( m_inputSlotNameHashes[i] == hash && FoldedNamesEqual( m_inputSlots[i].Name, name ) )
+            return i;
+    return -1;
+}
+
 bool vaRenderMaterial::SaveAPACK( vaStream & outStream )
 {
     // Just using SerializeUnpacked to implement this - not a lot of binary data; can be upgraded later
@@ -773,6 +828,9 @@ bool vaRenderMaterial::SerializeUnpacked( vaXMLSerializer & serializer, const ws
         VERIFY_TRUE_RETURN_ON_FALSE( serializer.TypedSerializeArray( "TextureNodes", m_nodes ) );
     }
 
+    if( serializer.IsReading( ) )
+        RebuildNameHashes( );
+
 #if 0
     for( size_t i = 0; i < m_inputSlots.size(); i++ )
     {
@@ -827,8 +885,12 @@ bool vaRenderMaterial::RemoveNode( const string & name, bool assertIfNotFound )
 
     // replace with last and pop last (order doesn't matter)
     if( index < ( m_nodes.size( ) - 1 ) )
+    {
         m_nodes[index] = m_nodes.back( );
+        m_nodeNameHashes[index] = m_nodeNameHashes.back( );
+    }
     m_nodes.pop_back( );
+    m_nodeNameHashes.pop_back( );
 
     m_inputsDirty = true;
     return true;
@@ -865,9 +927,12 @@ bool vaRenderMaterial::SetNode( const shared_ptr<vaRenderMaterial::Node> & node
     assert( !m_immutable );
     int index = FindNodeIndex( node->GetName() );
     if( index == -1 )
+    {
         m_nodes.push_back( node );
+        m_nodeNameHashes.push_back( FoldedNameHash( node->GetName() ) );
+    }
     else
-        m_nodes[index] = node;
+        m_nodes[index] = node;      // same name (up to case) so the hash stays the same
 
     m_inputsDirty = true;
     return true;
@@ -902,8 +967,12 @@ bool vaRenderMaterial::RemoveInputSlot( const string & name, bool assertIfNotFou
 
     // replace with last and pop last (order doesn't matter)
     if( index < ( m_inputSlots.size( ) - 1 ) )
+    {
         m_inputSlots[index] = m_inputSlots.back( );
+        m_inputSlotNameHashes[index] = m_inputSlotNameHashes.back( );
+    }
     m_inputSlots.pop_back( );
+    m_inputSlotNameHashes.pop_back( );
 
     m_inputsDirty = true;
     return true;
@@ -914,9 +983,12 @@ bool vaRenderMaterial::SetInputSlot( const vaRenderMaterial::InputSlot & inputSl
     assert( !m_immutable );
     int index = FindInputSlotIndex( inputSlot.GetName( ) );
     if( index == -1 )
+    {
         m_inputSlots.push_back( inputSlot );
+        m_inputSlotNameHashes.push_back( FoldedNameHash( inputSlot.GetName( ) ) );
+    }
     else
-        m_inputSlots[index] = inputSlot;
+        m_inputSlots[index] = inputSlot;    // same name (up to case) so the hash stays the same
 
     m_inputsDirty = true;
     return true;
@@ -981,14 +1053,8 @@ void vaRenderMaterial::VerifyNames( )
     for( int i = 0; i < m_inputSlots.size(); i++ )
     {
         // must find itself but must have no other inputs with the same name
-        int foundIndex = -1;
-        for( int j = 0; j < m_inputSlots.size(); j++ ) 
-            if( vaStringTools::ToLower( m_inputSlots[j].Name ) == vaStringTools::ToLower( m_inputSlots[i].Name ) ) 
-            {
-                foundIndex = j;
-                break;
-            }
-        assert( foundIndex == i );
+        assert( FindInputSlotIndex( m_inputSlots[i].Name ) == i );
+        assert( m_inputSlotNameHashes[i] == FoldedNameHash( m_inputSlots[i].Name ) );
     }
 
     for( int i = 0; i < m_nodes.size( ); i++ )
@@ -1711,12 +1777,20 @@ void vaRenderMaterialManager::UIPanelTick( vaApplicationBase & )
 shared_ptr<vaRenderMaterialCachedShaders>
 vaRenderMaterialManager::FindOrCreateShaders( bool alphaTest, const vaRenderMaterial::ShaderSettings & shaderSettings, const vector< pair< string, string > > & shaderMacros )
 {
-    vaRenderMaterialCachedShaders::Key cacheKey( alphaTest, shaderSettings, shaderMacros );
+    const vaXXHash128::Value cacheHash = vaRenderMaterialCachedShaders::Key::Hash( alphaTest, shaderSettings, shaderMacros );
 
-    auto it = m_cachedShaders.find( cacheKey );
+    // there's only more than one entry per hash on (extremely unlikely) collision
+    auto it = m_cachedShaders.end( );
+    auto range = m_cachedShaders.equal_range( cacheHash );
+    for( auto candidate = range.first; candidate != range.second; candidate++ )
+        if( candidate->second.Key.Equals( alphaTest, shaderSettings, shaderMacros ) )
+        {
+            it = candidate;
+            break;
+        }
     
     // in cache but no longer used by anyone so it was destroyed
-    if( (it != m_cachedShaders.end()) && it->second.expired() )
+    if( (it != m_cachedShaders.end()) && it->second.Shaders.expired() )
     {
         m_cachedShaders.erase( it );
         it = m_cachedShaders.end();
@@ -1770,13 +1844,13 @@ vaRenderMaterialManager::FindOrCreateShaders( bool alphaTest, const vaRenderMate
         if( shaderSettings.PS_CustomShadow.first != "" && shaderSettings.PS_CustomShadow.second != "" )
             newShaders->PS_CustomShadow->CreateShaderFromFile( shaderSettings.PS_CustomShadow.first,    "ps_5_0", shaderSettings.PS_CustomShadow.second.c_str( ), shaderMacros, false );
         
-        m_cachedShaders.insert( std::make_pair( cacheKey, newShaders ) );
+        m_cachedShaders.insert( std::make_pair( cacheHash, CachedShadersEntry{ vaRenderMaterialCachedShaders::Key( alphaTest, shaderSettings, shaderMacros ), newShaders } ) );
 
         return newShaders;
     }
     else
     {
-        return it->second.lock();
+        return it->second.Shaders.lock();
     }
 }
 
@@ -2144,6 +2218,16 @@ void vaRenderMaterial::EnumerateUsedAssets( const std::function<void( vaAsset *
     }
 }
 
+void vaRenderMaterial::EnumerateTextureNodes( const std::function<void( const TextureNode & node )> & callback ) const
+{
+    for( int i = 0; i < m_nodes.size( ); i++ )
+    {
+        auto snode = std::dynamic_pointer_cast<TextureNode, Node>( m_nodes[i] );
+        if( snode != nullptr )
+            callback( *snode );
+    }
+}
+
 vaShadingRate vaRenderMaterial::ComputeShadingRate( int baseShadingRate ) const
 {
     baseShadingRate += m_materialSettings.VRSRateOffset;
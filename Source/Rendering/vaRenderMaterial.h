@@ -33,6 +33,7 @@
 #include "Rendering/vaShader.h"
 
 #include "Core/vaXMLSerialization.h"
+#include "Core/Misc/vaXXHash.h"
 
 #include <optional>
 
@@ -188,6 +189,7 @@ namespace Vanilla
 
             shared_ptr<vaTexture>       GetTexture( ) const;
             const vaGUID &              GetTextureUID( ) const                          { return UID; };
+            int                         GetUVIndex( ) const                             { return UVIndex; }
         };
 
         // for editing defaults to an input slot a constant value node
@@ -327,6 +329,10 @@ namespace Vanilla
         std::vector<shared_ptr<Node>>                   m_nodes;
         std::vector<InputSlot>                          m_inputSlots;
 
+        // case-folded hashes of m_nodes / m_inputSlots names (same order), so that name lookups don't need to allocate
+        std::vector<uint64>                             m_nodeNameHashes;
+        std::vector<uint64>                             m_inputSlotNameHashes;
+
         vector< pair< string, string > >                m_shaderMacros;
         bool                                            m_shaderMacrosDirty;
         bool                                            m_shadersDirty;
@@ -385,7 +391,7 @@ namespace Vanilla
         vaShadingRate                                   ComputeShadingRate( int baseShadingRate ) const;
 
         template< typename NodeType = Node >
-        shared_ptr<const NodeType>                      FindNode( const string & name )                             { for( int i = 0; i < m_nodes.size(); i++ ) if( vaStringTools::ToLower( m_nodes[i]->Name ) == vaStringTools::ToLower( name ) ) return std::dynamic_pointer_cast<NodeType, Node>(m_nodes[i]); return nullptr; }
+        shared_ptr<const NodeType>                      FindNode( const string & name )                             { int index = FindNodeIndex( name ); return ( index == -1 ) ? ( nullptr ) : ( std::dynamic_pointer_cast<NodeType, Node>( m_nodes[index] ) ); }
         bool                                            RemoveNode( const string & name, bool assertIfNotFound );
         string                                          FindAvailableNodeName( const string & name );
         bool                                            SetNode( const shared_ptr<Node> & node );
@@ -401,7 +407,7 @@ namespace Vanilla
         bool                                            ReplaceTextureOnNode( const string & name, const shared_ptr<vaTexture> & texture )
                                                                                                                         { return ReplaceTextureOnNode( name, texture->UIDObject_GetUID() ); }
 
-        std::optional<const InputSlot>                  FindInputSlot( const string & name )                        { for( int i = 0; i < m_inputSlots.size(); i++ ) if( vaStringTools::ToLower( m_inputSlots[i].Name ) == vaStringTools::ToLower( name ) ) return m_inputSlots[i]; return std::nullopt; }
+        std::optional<const InputSlot>                  FindInputSlot( const string & name )                        { int index = FindInputSlotIndex( name ); if( index == -1 ) return std::nullopt; return m_inputSlots[index]; }
         bool                                            RemoveInputSlot( const string & name, bool assertIfNotFound );
         bool                                            SetInputSlot( const InputSlot & newValue );
         bool                                            SetInputSlot( const string & name, const ValueType & default, bool defaultIsMultiplier, bool isColor );
@@ -454,9 +460,13 @@ namespace Vanilla
 
     private:
         const std::vector<InputSlot> &                  GetInputSlots( ) const                                      { return m_inputSlots; }
-        int                                             FindInputSlotIndex( const string & name ) const             { for( int i = 0; i < m_inputSlots.size(); i++ ) if( vaStringTools::ToLower( m_inputSlots[i].Name ) == vaStringTools::ToLower( name ) ) return i; return -1; }
+        int                                             FindInputSlotIndex( const string & name ) const;
         const std::vector<shared_ptr<Node>> &           GetNodes( ) const                                           { return m_nodes; }
-        int                                             FindNodeIndex( const string & name ) const                  { for( int i = 0; i < m_nodes.size(); i++ ) if( vaStringTools::ToLower( m_nodes[i]->Name ) == vaStringTools::ToLower( name ) ) return i; return -1; }
+        int                                             FindNodeIndex( const string & name ) const;
+
+        static uint64                                   FoldedNameHash( const string & name );
+        static bool                                     FoldedNamesEqual( const string & left, const string & right );
+        void                                            RebuildNameHashes( );
 
     public:
         static vector<string>                           GetPresetMaterials( );
@@ -465,6 +475,9 @@ namespace Vanilla
 
         void                                            EnumerateUsedAssets( const std::function<void(vaAsset * asset)> & callback );
 
+        // all texture nodes, regardless of whether they're connected to any input slot or not
+        void                                            EnumerateTextureNodes( const std::function<void( const TextureNode & node )> & callback ) const;
+
     public:
         bool                                            UIPropertiesDraw( vaApplicationBase & application ) override;
 
@@ -473,30 +486,46 @@ namespace Vanilla
 
     struct vaRenderMaterialCachedShaders
     {
+        // Cache is looked up by Hash( ) only; the full key is stored with each entry to compare against on hash match, so
+        // a collision can never return wrong shaders.
         struct Key
         {
-            //wstring                     WStringPart;
-            string                      AStringPart;
-
-            bool                        operator == ( const Key & cmp ) const { return this->AStringPart == cmp.AStringPart; }
-            bool                        operator >( const Key & cmp ) const { return this->AStringPart > cmp.AStringPart; }
-            bool                        operator < ( const Key & cmp ) const { return this->AStringPart < cmp.AStringPart; }
-
             // alphaTest is part of the key because it determines whether PS_DepthOnly is needed at all; all other shader parameters are contained in shaderMacros
+            bool                                AlphaTest;
+            pair< string, string >              VS_Standard;
+            pair< string, string >              GS_Standard;
+            pair< string, string >              PS_DepthOnly;
+            pair< string, string >              PS_Forward;
+            pair< string, string >              PS_CustomShadow;
+            vector< pair< string, string > >    ShaderMacros;
+
             Key( bool alphaTest, const vaRenderMaterial::ShaderSettings & shaderSettings, const vector< pair< string, string > > & shaderMacros )
+                : AlphaTest( alphaTest ), VS_Standard( shaderSettings.VS_Standard ), GS_Standard( shaderSettings.GS_Standard ), PS_DepthOnly( shaderSettings.PS_DepthOnly ), 
+                PS_Forward( shaderSettings.PS_Forward ), PS_CustomShadow( shaderSettings.PS_CustomShadow ), ShaderMacros( shaderMacros ) { }
+
+            bool                                Equals( bool alphaTest, const vaRenderMaterial::ShaderSettings & shaderSettings, const vector< pair< string, string > > & shaderMacros ) const
+            {
+                return AlphaTest == alphaTest && VS_Standard == shaderSettings.VS_Standard && GS_Standard == shaderSettings.GS_Standard && PS_DepthOnly == shaderSettings.PS_DepthOnly
+                    && PS_Forward == shaderSettings.PS_Forward && PS_CustomShadow == shaderSettings.PS_CustomShadow && ShaderMacros == shaderMacros;
+            }
+
+            // computed directly from the inputs, without building the Key
+            static vaXXHash128::Value           Hash( bool alphaTest, const vaRenderMaterial::ShaderSettings & shaderSettings, const vector< pair< string, string > > & shaderMacros )
             {
-                //WStringPart = fileName;
-                AStringPart = "";
-                AStringPart += "&" + shaderSettings.VS_Standard.first       + "&" + shaderSettings.VS_Standard.second;
-                AStringPart += "&" + shaderSettings.PS_DepthOnly.first      + "&" + shaderSettings.PS_DepthOnly.second;
-                AStringPart += "&" + shaderSettings.PS_Forward.first        + "&" + shaderSettings.PS_Forward.second;
-                // AStringPart += "&" + shaderSettings.PS_Deferred.first       + "&" + shaderSettings.PS_Deferred.second;
-                AStringPart += "&" + shaderSettings.PS_CustomShadow.first   + "&" + shaderSettings.PS_CustomShadow.second;
-                AStringPart += "&" + shaderSettings.GS_Standard.first       + "&" + shaderSettings.GS_Standard.second;
-
-                AStringPart += ((alphaTest)?("a&"):("b&"));
-                for( int i = 0; i < shaderMacros.size(); i++ )
-                    AStringPart += shaderMacros[i].first + "&" + shaderMacros[i].second + "&";
+                vaXXHash128 hash;
+                hash.AddValue( alphaTest );
+                hash.AddString( shaderSettings.VS_Standard.first );     hash.AddString( shaderSettings.VS_Standard.second );
+                hash.AddString( shaderSettings.GS_Standard.first );     hash.AddString( shaderSettings.GS_Standard.second );
+                hash.AddString( shaderSettings.PS_DepthOnly.first );    hash.AddString( shaderSettings.PS_DepthOnly.second );
+                hash.AddString( shaderSettings.PS_Forward.first );      hash.AddString( shaderSettings.PS_Forward.second );
+                hash.AddString( shaderSettings.PS_CustomShadow.first ); hash.AddString( shaderSettings.PS_CustomShadow.second );
+                hash.AddValue( (int)shaderMacros.size( ) );
+                for( const auto & macro : shaderMacros )
+                {
+                    hash.AddString( macro.first );
+                    hash.AddString( macro.second );
+                }
+                return hash.Digest( );
             }
         };
 
@@ -524,7 +553,12 @@ namespace Vanilla
 
         bool                                            m_texturingDisabled;
 
-        map< vaRenderMaterialCachedShaders::Key, weak_ptr<vaRenderMaterialCachedShaders> >
+        struct CachedShadersEntry
+        {
+            vaRenderMaterialCachedShaders::Key          Key;
+            weak_ptr<vaRenderMaterialCachedShaders>     Shaders;
+        };
+        std::unordered_multimap< vaXXHash128::Value, CachedShadersEntry, vaXXHash128::Hasher >
                                                         m_cachedShaders;
 
         vector< pair< string, string > >                m_globalShaderMacros;
@@ -37,7 +37,7 @@ using namespace Vanilla;
 
 //vaRenderMeshManager & renderMeshManager, const vaGUID & uid
 
-const int c_renderMeshFileVersion = 3;
+const int c_renderMeshFileVersion = 4;     // 4 adds LODs
 
 
 vaRenderMesh::vaRenderMesh( vaRenderMeshManager & renderMeshManager, const vaGUID & uid ) : vaAssetResource(uid), m_trackee(renderMeshManager.GetRenderMeshTracker(), this), m_renderMeshManager( renderMeshManager )
@@ -79,9 +79,72 @@ void vaRenderMesh::SetMaterial( const shared_ptr<vaRenderMaterial>& m )
 void vaRenderMesh::SetTriangleMesh( const shared_ptr<StandardTriangleMesh> & mesh )
 {
     m_triangleMesh = mesh;
+    m_LODs.clear( );    // index ranges refer to the old mesh
     UpdateAABB( );
 }
 
+void vaRenderMesh::GetLODIndexRange( int lodLevel, int & outIndexStart, int & outIndexCount ) const
+{
+    lodLevel = vaMath::Clamp( lodLevel, 0, (int)m_LODs.size( ) );
+    if( lodLevel == 0 )
+    {
+        outIndexStart   = m_part.IndexStart;
+        outIndexCount   = m_part.IndexCount;
+    }
+    else
+    {
+        outIndexStart   = m_LODs[lodLevel-1].IndexStart;
+        outIndexCount   = m_LODs[lodLevel-1].IndexCount;
+    }
+}
+
+bool vaRenderMesh::IsTriangleMeshShared( ) const
+{
+    return m_triangleMesh != nullptr && m_triangleMesh.use_count( ) > 1;
+}
+
+bool vaRenderMesh::GenerateLODs( const vaTriangleMeshTools::LODChainSettings & settings )
+{
+    if( !RemoveLODs( ) )
+        return false;
+    if( m_triangleMesh == nullptr || m_triangleMesh->Vertices( ).size( ) == 0 || m_part.IndexCount == 0 )
+        return true;
+
+    const vector<StandardVertex> & vertices = m_triangleMesh->Vertices( );
+    vaTriangleMeshTools::GenerateLODChain( m_triangleMesh->Indices( ), m_part.IndexStart, m_part.IndexCount, m_LODs, &vertices[0].Position, sizeof( StandardVertex ), (int)vertices.size( ), settings );
+    m_triangleMesh->SetDataDirty( );
+    return true;
+}
+
+bool vaRenderMesh::RemoveLODs( )
+{
+    // LOD index ranges live in this render mesh but their indices in the triangle mesh - changing them under another
+    // render mesh (for ex. a shallow copy) would leave its ranges pointing at someone else's (or no) indices
+    if( IsTriangleMeshShared( ) )
+    {
+        VA_LOG_WARNING( "vaRenderMesh - can't change LODs, the triangle mesh is shared with another render mesh" );
+        return false;
+    }
+    if( m_LODs.size( ) == 0 )
+        return true;
+
+    // LOD indices are always at the end of the index buffer
+    assert( m_LODs[0].IndexStart >= m_part.IndexStart + m_part.IndexCount );
+    m_triangleMesh->Indices( ).resize( m_LODs[0].IndexStart );
+    m_triangleMesh->SetDataDirty( );
+    m_LODs.clear( );
+    return true;
+}
+
+int vaRenderMesh::SelectLOD( float pixelsPerUnit, float errorThresholdPixels ) const
+{
+    // errors only grow with each level
+    int lodLevel = 0;
+    while( lodLevel < (int)m_LODs.size( ) && m_LODs[lodLevel].Error * pixelsPerUnit <= errorThresholdPixels )
+        lodLevel++;
+    return lodLevel;
+}
+
 void vaRenderMesh::CreateTriangleMesh( vaRenderDevice & device, const vector<StandardVertex> & vertices, const vector<uint32> & indices )
 {
     shared_ptr<StandardTriangleMesh> mesh = std::make_shared< vaRenderMesh::StandardTriangleMesh> ( device );
@@ -228,6 +291,8 @@ bool vaRenderMesh::SaveAPACK( vaStream & outStream )
 
     VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<vaBoundingBox>( m_boundingBox ) );
 
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValueVector<vaTriangleMeshTools::LODRange>( m_LODs ) );
+
     return true;
 }
 
@@ -277,6 +342,13 @@ bool vaRenderMesh::LoadAPACK( vaStream & inStream )
 
     VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<vaBoundingBox>( m_boundingBox ) );
 
+    if( fileVersion >= 4 )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValueVector<vaTriangleMeshTools::LODRange>( m_LODs ) );
+        for( const auto & lod : m_LODs )
+            VERIFY_TRUE_RETURN_ON_FALSE( lod.IndexStart >= 0 && lod.IndexCount >= 0 && ( lod.IndexStart + lod.IndexCount ) <= (int)m_triangleMesh->Indices( ).size( ) );
+    }
+
     return true;
 }
 
@@ -285,7 +357,7 @@ bool vaRenderMesh::SerializeUnpacked( vaXMLSerializer & serializer, const wstrin
     assetFolder;
     int32 fileVersion = c_renderMeshFileVersion;
     VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<int32>( "FileVersion", fileVersion ) );
-    VERIFY_TRUE_RETURN_ON_FALSE( fileVersion == c_renderMeshFileVersion );
+    VERIFY_TRUE_RETURN_ON_FALSE( fileVersion >= 3 && fileVersion <= c_renderMeshFileVersion );
 
 
     VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<int32>( "FrontFaceWinding", reinterpret_cast<int32&>(m_frontFaceWinding) ) );
@@ -354,6 +426,31 @@ bool vaRenderMesh::SerializeUnpacked( vaXMLSerializer & serializer, const wstrin
 
         //VERIFY_TRUE_RETURN_ON_FALSE( serializer.SerializePopToParentElement( partName.c_str() ) );
     }
+
+    if( fileVersion >= 4 )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( serializer.SerializeArrayGeneric<vector<vaTriangleMeshTools::LODRange>>( "LODs", m_LODs,
+            [ ] ( bool isReading, vector<vaTriangleMeshTools::LODRange> & container, int & itemCount )
+            { 
+                if( isReading )
+                    container.resize( itemCount );
+                else
+                    itemCount = (int)container.size();
+            }, 
+            [ ] ( vaXMLSerializer & serializer, vector<vaTriangleMeshTools::LODRange> & container, int index ) 
+            { 
+                bool allOk = true;
+                allOk &= serializer.Serialize<int32>( "IndexStart", container[index].IndexStart );
+                allOk &= serializer.Serialize<int32>( "IndexCount", container[index].IndexCount );
+                allOk &= serializer.Serialize<float>( "Error", container[index].Error );
+                return allOk;
+            } ) );
+        if( serializer.IsReading( ) )
+        {
+            for( const auto & lod : m_LODs )
+                VERIFY_TRUE_RETURN_ON_FALSE( lod.IndexStart >= 0 && lod.IndexCount >= 0 && ( lod.IndexStart + lod.IndexCount ) <= (int)m_triangleMesh->Indices( ).size( ) );
+        }
+    }
     return true;
 }
 
@@ -435,6 +532,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateShallowCopy( const vaRenderMesh & c
     mesh->SetTriangleMesh( copy.GetTriangleMesh() );
     mesh->SetFrontFaceWindingOrder( copy.GetFrontFaceWindingOrder() );
     mesh->SetPart( copy.GetPart() );
+    mesh->SetLODs( copy.GetLODs() );
 
     if( startTrackingUIDObject )
     {
@@ -496,7 +594,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreatePlane( vaRenderDevice & device, con
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreatePlane( vertices, indices, sizeX, sizeY, doubleSided );
+    vaStandardShapes::CachedPlane( sizeX, sizeY, doubleSided )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::CounterClockwise;
 
     RMC_RESIZE_NTTT;
@@ -516,7 +614,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateGrid( vaRenderDevice & device, cons
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateGrid( vertices, indices, dimX, dimY, sizeX, sizeY );
+    vaStandardShapes::CachedGrid( dimX, dimY, sizeX, sizeY )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::CounterClockwise;
 
     RMC_RESIZE_NTTT;
@@ -549,7 +647,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateTetrahedron( vaRenderDevice & devic
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateTetrahedron( vertices, indices, shareVertices );
+    vaStandardShapes::CachedTetrahedron( shareVertices )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     RMC_RESIZE_NTTT;
@@ -565,7 +663,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateCube( vaRenderDevice & device, cons
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateCube( vertices, indices, shareVertices, edgeHalfLength );
+    vaStandardShapes::CachedCube( shareVertices, edgeHalfLength )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     RMC_RESIZE_NTTT;
@@ -581,7 +679,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateOctahedron( vaRenderDevice & device
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateOctahedron( vertices, indices, shareVertices );
+    vaStandardShapes::CachedOctahedron( shareVertices )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     RMC_RESIZE_NTTT;
@@ -597,7 +695,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateIcosahedron( vaRenderDevice & devic
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateIcosahedron( vertices, indices, shareVertices );
+    vaStandardShapes::CachedIcosahedron( shareVertices )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     RMC_RESIZE_NTTT;
@@ -613,7 +711,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateDodecahedron( vaRenderDevice & devi
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateDodecahedron( vertices, indices, shareVertices );
+    vaStandardShapes::CachedDodecahedron( shareVertices )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     RMC_RESIZE_NTTT;
@@ -629,7 +727,9 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateSphere( vaRenderDevice & device, co
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateSphereUVWrapped( vertices, indices, texcoords0, tessellationLevel, shareVertices );
+    auto sphere = vaStandardShapes::CachedSphereUVWrapped( tessellationLevel, shareVertices );
+    sphere->CopyTo( vertices, indices );
+    texcoords0 = sphere->TextureCoords;
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     normals.resize( vertices.size() );  // RMC_RESIZE_NTTT;
@@ -649,7 +749,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateCylinder( vaRenderDevice & device,
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateCylinder( vertices, indices, height, radiusBottom, radiusTop, tessellation, openTopBottom, shareVertices );
+    vaStandardShapes::CachedCylinder( height, radiusBottom, radiusTop, tessellation, openTopBottom, shareVertices )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     RMC_RESIZE_NTTT;
@@ -665,7 +765,7 @@ shared_ptr<vaRenderMesh> vaRenderMesh::CreateTeapot( vaRenderDevice & device, co
 {
     RMC_DEFINE_DATA;
 
-    vaStandardShapes::CreateTeapot( vertices, indices );
+    vaStandardShapes::CachedTeapot( )->CopyTo( vertices, indices );
     vaWindingOrder windingOrder = vaWindingOrder::Clockwise;
 
     RMC_RESIZE_NTTT;
@@ -705,6 +805,23 @@ bool vaRenderMesh::UIPropertiesDraw( vaApplicationBase & application )
         hadChanges = true;
     }
 
+    ImGui::Text( "LODs: %d", GetLODCount( ) );
+    for( int i = 0; i < (int)m_LODs.size( ); i++ )
+        ImGui::Text( "  LOD %d: %d triangles, error %.4f", i+1, m_LODs[i].IndexCount / 3, m_LODs[i].Error );
+    if( IsTriangleMeshShared( ) )
+        ImGui::TextDisabled( "(triangle mesh is shared with another render mesh - LODs are read-only)" );
+    else
+    {
+        if( ImGui::Button( "Generate LODs" ) )
+            hadChanges |= GenerateLODs( );
+        if( m_LODs.size( ) > 0 )
+        {
+            ImGui::SameLine( );
+            if( ImGui::Button( "Remove LODs" ) )
+                hadChanges |= RemoveLODs( );
+        }
+    }
+
     string materialName = (m_part.MaterialID == vaGUID::Null)?("None"):("Unknown");
     
     vaGUID materialID = m_part.MaterialID;
@@ -761,8 +878,8 @@ void vaRenderMeshDrawList::Insert( const std::shared_ptr<vaRenderMesh>& mesh, co
     Insert( mesh, renderMaterial, transform, shadingRate, customColor );
 }
 
-vaRenderMeshDrawList::Entry::Entry( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate, const vaVector4 & customColor ) 
-    : Mesh( mesh ), Material( material ), Transform( transform ), ShadingRate( shadingRate ), CustomColor( customColor )
+vaRenderMeshDrawList::Entry::Entry( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate, const vaVector4 & customColor, int lodLevel ) 
+    : Mesh( mesh ), Material( material ), Transform( transform ), ShadingRate( shadingRate ), CustomColor( customColor ), LODLevel( lodLevel )
 {
     assert( material != nullptr );
 }
@@ -773,29 +890,23 @@ void vaRenderMeshDrawList::StartSort( const vaRenderSelection::SortSettings& sor
     {
         assert( false ); // you haven't updated sortSettings.ReferencePoint
         m_sortState.Enabled = false;
-        m_sortState.Sorted  = false;
         return;
     }
 
     m_sortState.Enabled         = sortSettings.SortByDistanceToPoint || sortSettings.SortByVRSType;
-    m_sortState.Sorted          = !m_sortState.Enabled;
     m_sortState.SortSettings    = sortSettings;
-
-    m_sortState.SortDistances.resize( m_drawList.size( ) );
-    m_sortState.SortedIndices.resize( m_drawList.size( ) );
 }
 
-void vaRenderMeshDrawList::FinalizeSort( const vaRenderSelection::SortSettings & sortSettings ) const
+void vaRenderMeshDrawList::FinalizeSort( const vaRenderSelection::SortSettings & sortSettings, vaFrameVector<int> & outSortedIndices ) const
 {
-    // all good, we're sorted
-    if( m_sortState.Sorted )
-        return;
+    outSortedIndices.clear( );
     if( !m_sortState.Enabled )
         return;
 
     assert( m_sortState.SortSettings == sortSettings ); sortSettings;
-    assert( m_sortState.SortDistances.size() == m_drawList.size( ) );
-    assert( m_sortState.SortedIndices.size() == m_drawList.size( ) );
+
+    vaFrameVector<pair<int,float>> sortDistances( m_drawList.size( ) );     // first is a sort group - items first get sorted by it and then by distance
+    outSortedIndices.resize( m_drawList.size( ) );
 
     for( int i = 0; i < m_drawList.size( ); i++ )
     {
@@ -814,12 +925,12 @@ void vaRenderMeshDrawList::FinalizeSort( const vaRenderSelection::SortSettings &
         else if( m_sortState.SortSettings.SortByVRSType )
             sortGroup = (int)m_drawList[i].ShadingRate;
 
-        m_sortState.SortDistances[i] = { sortGroup, ( vaVector3::TransformCoord( m_drawList[i].Mesh->GetAABB( ).Center( ), m_drawList[i].Transform ) - m_sortState.SortSettings.ReferencePoint ).Length( ) };
-        m_sortState.SortedIndices[i] = i;
+        sortDistances[i] = { sortGroup, ( vaVector3::TransformCoord( m_drawList[i].Mesh->GetAABB( ).Center( ), m_drawList[i].Transform ) - m_sortState.SortSettings.ReferencePoint ).Length( ) };
+        outSortedIndices[i] = i;
     }
 
-    std::sort( m_sortState.SortedIndices.begin( ), m_sortState.SortedIndices.end( ),
-        [&sortedIndices = m_sortState.SortedIndices, &sortDistances = m_sortState.SortDistances, frontToBack = m_sortState.SortSettings.FrontToBack]( const int ia, const int ib ) -> bool
+    std::sort( outSortedIndices.begin( ), outSortedIndices.end( ),
+        [&sortDistances, frontToBack = m_sortState.SortSettings.FrontToBack]( const int ia, const int ib ) -> bool
     {
         // first sort by special type
         if( sortDistances[ia].first != sortDistances[ib].first )
@@ -827,11 +938,10 @@ void vaRenderMeshDrawList::FinalizeSort( const vaRenderSelection::SortSettings &
         else // then by distance
             return (frontToBack)?(sortDistances[ia].second < sortDistances[ib].second):(sortDistances[ia].second > sortDistances[ib].second);
     } );
-    m_sortState.Sorted = true;
 }
 
 vaDrawResultFlags vaRenderMeshManager::Draw( vaSceneDrawContext & drawContext, const vaRenderMeshDrawList & list, vaBlendMode blendMode, vaRenderMeshDrawFlags drawFlags, 
-    const vaRenderSelection::SortSettings & sortSettings, std::function< void( const vaRenderMeshDrawList::Entry & entry, const vaRenderMaterial & material, vaGraphicsItem & renderItem ) > globalCustomizer )
+    const vaRenderSelection::SortSettings & sortSettings, const std::function< void( const vaRenderMeshDrawList::Entry & entry, const vaRenderMaterial & material, vaGraphicsItem & renderItem ) > & globalCustomizer )
 {
     vaDrawResultFlags drawResults = vaDrawResultFlags::None;
 
@@ -890,23 +1000,19 @@ vaDrawResultFlags vaRenderMeshManager::Draw( vaSceneDrawContext & drawContext, c
         commonRenderItem.DepthWriteEnable = enableDepthWrite;
     }
 
+    // sort order is per-call scratch - keep it on the frame arena
+    vaFrameVector<int> sortedIndices;
     list.StartSort( sortSettings );
-    list.FinalizeSort( sortSettings );
-
-    auto const & listSortState = list.SortState();
-    if( listSortState.Enabled ) 
-    {
-        assert( listSortState.Sorted );
-        assert( listSortState.SortDistances.size() == list.Count() && listSortState.SortedIndices.size() == list.Count() );
-    }
+    list.FinalizeSort( sortSettings, sortedIndices );
+    assert( !list.SortState().Enabled || sortedIndices.size() == list.Count() );
 
     drawContext.RenderDeviceContext.BeginItems( vaRenderTypeFlags::Graphics, &drawContext );
     vaGraphicsItem renderItem;
     for( int i = 0; i < list.Count(); i++ )
     {
         int ii = i;
-        if( list.m_sortState.Enabled )
-            ii = listSortState.SortedIndices[(reverseOrder)?(list.Count()-1-i):(i)];
+        if( sortedIndices.size( ) > 0 )
+            ii = sortedIndices[(reverseOrder)?(list.Count()-1-i):(i)];
         const vaRenderMeshDrawList::Entry & entry = list[ii];
 
         if( entry.Mesh == nullptr ) 
@@ -927,7 +1033,8 @@ vaDrawResultFlags vaRenderMeshManager::Draw( vaSceneDrawContext & drawContext, c
         if( subPart.IndexCount == 0 )
             continue;
 
-        shared_ptr<vaRenderMaterial> material = entry.Material;
+        // no need to touch the refcount, the list keeps the material alive for the duration of the call
+        vaRenderMaterial * material = entry.Material.get( );
 
         // at this point material must be valid
         assert( material != nullptr  );
@@ -1000,7 +1107,9 @@ vaDrawResultFlags vaRenderMeshManager::Draw( vaSceneDrawContext & drawContext, c
             ////instanceConsts.ShadingRate = vaVector4( vaShadingRateToVector2( renderItem.ShadingRate ), 0, 0 );
         }
 
-        assert( (subPart.IndexStart + subPart.IndexCount) <= (int)triangleMesh->Indices().size() );
+        int indexStart, indexCount;
+        mesh.GetLODIndexRange( entry.LODLevel, indexStart, indexCount );
+        assert( (indexStart + indexCount) <= (int)triangleMesh->Indices().size() );
 
         bool showMaterialSelected = mesh.GetUIShowSelectedFrameIndex( ) >= GetRenderDevice().GetCurrentFrameIndex() || material->GetUIShowSelectedFrameIndex( ) >= GetRenderDevice().GetCurrentFrameIndex();
         if( isWireframe )
@@ -1030,7 +1139,7 @@ vaDrawResultFlags vaRenderMeshManager::Draw( vaSceneDrawContext & drawContext, c
         renderItem.CullMode                 = materialSettings.FaceCull;
         renderItem.FrontCounterClockwise    = mesh.GetFrontFaceWindingOrder() == vaWindingOrder::CounterClockwise;
 
-        renderItem.SetDrawIndexed( subPart.IndexCount, subPart.IndexStart, 0 );
+        renderItem.SetDrawIndexed( indexCount, indexStart, 0 );
 
         // apply overrides, if any
         if( entry.CustomHandler != nullptr )
@@ -138,6 +138,9 @@ namespace Vanilla
         // Note: if ever desperately needing vertex/index buffer reuse (the main reason for multiple parts), add "alternate vertex buffer source" reference mesh ID and simply reuse that way
         SubPart                                         m_part;
 
+        // LOD 1 and onward: their indices are appended after m_part's in the same index buffer and use the same vertices
+        vector<vaTriangleMeshTools::LODRange>           m_LODs;
+
         vaBoundingBox                                   m_boundingBox;      // local bounding box around the mesh
 
     protected:
@@ -159,6 +162,22 @@ namespace Vanilla
         const SubPart &                                 GetPart( ) const                                    { return m_part; }
         void                                            SetPart( const SubPart & subPart )                  { m_part = subPart; }
 
+        // LOD 0 is the part itself; the rest are simplified versions (see vaTriangleMeshTools::GenerateLODChain)
+        int                                             GetLODCount( ) const                                { return 1 + (int)m_LODs.size( ); }
+        const vector<vaTriangleMeshTools::LODRange> &   GetLODs( ) const                                    { return m_LODs; }
+        void                                            SetLODs( const vector<vaTriangleMeshTools::LODRange> & lods )   { m_LODs = lods; }
+        void                                            GetLODIndexRange( int lodLevel, int & outIndexStart, int & outIndexCount ) const;
+        // both refuse (and return false) if the triangle mesh is shared with another render mesh, see IsTriangleMeshShared
+        bool                                            GenerateLODs( const vaTriangleMeshTools::LODChainSettings & settings = vaTriangleMeshTools::LODChainSettings() );
+        bool                                            RemoveLODs( );
+        bool                                            IsTriangleMeshShared( ) const;
+        //
+        // Picks the coarsest LOD whose error, projected to the screen, stays within errorThresholdPixels. Deterministic:
+        // only depends on the arguments and on the LOD errors stored in the mesh. 
+        // pixelsPerUnit is the size in pixels of a unit-size object-space feature: viewport height / ( 2 * tan( yfov / 2 ) ),
+        // multiplied by the mesh world scale and divided by the distance to the camera.
+        int                                             SelectLOD( float pixelsPerUnit, float errorThresholdPixels ) const;
+
         shared_ptr<vaRenderMaterial>                    GetMaterial( ) const;
         void                                            SetMaterial( const shared_ptr<vaRenderMaterial> & m);
 
@@ -195,6 +214,8 @@ namespace Vanilla
         static shared_ptr<vaRenderMesh>                 CreateShallowCopy( const vaRenderMesh & copy, const vaGUID & uid = vaCore::GUIDCreate( ), bool startTrackingUIDObject = true );
 
         // these use vaStandardShapes::Create* functions and create shapes with center in (0, 0, 0) and each vertex magnitude of 1 (normalized), except where specified otherwise, and then transformed by the provided transform
+        // Only the source geometry comes from the vaStandardShapes cache: each call still creates its own (UID tracked, editable) mesh with its own
+        // GPU buffers since the transform is baked into the vertices; to draw the same shape many times, create it once and use CreateShallowCopy.
         static shared_ptr<vaRenderMesh>                 CreatePlane( vaRenderDevice & device, const vaMatrix4x4 & transform, float sizeX = 1.0f, float sizeY = 1.0f, bool doubleSided = false, const vaGUID & uid = vaCore::GUIDCreate() );
         static shared_ptr<vaRenderMesh>                 CreateGrid( vaRenderDevice & device, const vaMatrix4x4 & transform, int dimX, int dimY, float sizeX = 1.0f, float sizeY = 1.0f, const vaVector2 & uvOffsetMul = vaVector2( 1, 1 ), const vaVector2 & uvOffsetAdd = vaVector2( 0, 0 ), const vaGUID & uid = vaCore::GUIDCreate() );
         static shared_ptr<vaRenderMesh>                 CreateTetrahedron( vaRenderDevice & device, const vaMatrix4x4 & transform, bool shareVertices, const vaGUID & uid = vaCore::GUIDCreate() );
@@ -234,9 +255,11 @@ namespace Vanilla
             vaShadingRate                               ShadingRate     = vaShadingRate::ShadingRate1X1;
             vaVector4                                   CustomColor     = vaVector4( 0.0f, 0.0f, 0.0f, 0.0f );  // for debugging visualization (default means "do not override")
 
-            Entry( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate = vaShadingRate::ShadingRate1X1, const vaVector4 & customColor = vaVector4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+            int                                         LODLevel        = 0;        // see vaRenderMesh::SelectLOD
 
-            Entry( const Entry & copy ) : Mesh( copy.Mesh ), Material( copy.Material ), Transform( copy.Transform ), CustomHandler( copy.CustomHandler ), CustomPayload( copy.CustomPayload ), ShadingRate( copy.ShadingRate ), CustomColor( copy.CustomColor ) { }
+            Entry( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate = vaShadingRate::ShadingRate1X1, const vaVector4 & customColor = vaVector4( 0.0f, 0.0f, 0.0f, 0.0f ), int lodLevel = 0 );
+
+            Entry( const Entry & copy ) : Mesh( copy.Mesh ), Material( copy.Material ), Transform( copy.Transform ), CustomHandler( copy.CustomHandler ), CustomPayload( copy.CustomPayload ), ShadingRate( copy.ShadingRate ), CustomColor( copy.CustomColor ), LODLevel( copy.LODLevel ) { }
         };
 
     private:
@@ -247,9 +270,6 @@ namespace Vanilla
         {
             vaRenderSelection::SortSettings             SortSettings;
             bool                                        Enabled             = false;
-            bool                                        Sorted              = false;
-            vector<pair<int,float>>                     SortDistances;      // first is a sort group - items first get sorted by it and then by distance
-            vector<int>                                 SortedIndices;
         } mutable                                       m_sortState;
 
     public:
@@ -268,7 +288,7 @@ namespace Vanilla
         int                                             Count( ) const                      { return (int)m_drawList.size(); }
         
         // shadingRateOffset gets combined with material shading rate offset and, based on material horizontal/vertical preference converted into actual shading rate 
-        void                                            Insert( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate, const vaVector4 & customColor );
+        void                                            Insert( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate, const vaVector4 & customColor, int lodLevel = 0 );
 
         // version that takes the material off the mesh, if possible, and has defaults for everything else - super-simple
         void                                            Insert( const std::shared_ptr<vaRenderMesh> & mesh, const vaMatrix4x4 & transform, vaShadingRate shadingRate = vaShadingRate::ShadingRate1X1, const vaVector4 & customColor = vaVector4( 0.0f, 0.0f, 0.0f, 0.0f ) );
@@ -282,7 +302,8 @@ namespace Vanilla
         friend class vaRenderMeshManager;
         const SortState &                               SortState( ) const                  { return m_sortState; }
         void                                            StartSort( const vaRenderSelection::SortSettings & sortSettings ) const;
-        void                                            FinalizeSort( const vaRenderSelection::SortSettings & sortSettings ) const;
+        // outSortedIndices is left empty if sorting is not enabled; sort scratch lives in the caller's vaFrameArena so nothing here outlives the frame
+        void                                            FinalizeSort( const vaRenderSelection::SortSettings & sortSettings, vaFrameVector<int> & outSortedIndices ) const;
     };
 
     struct vaRenderMeshCustomHandler
@@ -336,7 +357,7 @@ namespace Vanilla
 
     public:
         virtual vaDrawResultFlags                       Draw( vaSceneDrawContext & drawContext, const vaRenderMeshDrawList & list, vaBlendMode blendMode, vaRenderMeshDrawFlags drawFlags, const vaRenderSelection::SortSettings & sortSettings = vaRenderSelection::SortSettings(),
-                                                                std::function< void( const vaRenderMeshDrawList::Entry & entry, const vaRenderMaterial & material, vaGraphicsItem & renderItem ) > globalCustomizer = nullptr );
+                                                                const std::function< void( const vaRenderMeshDrawList::Entry & entry, const vaRenderMaterial & material, vaGraphicsItem & renderItem ) > & globalCustomizer = nullptr );
 
         vaTT_Tracker< vaRenderMesh * > *                GetRenderMeshTracker( )                                                     { return &m_renderMeshes; }
 
@@ -347,7 +368,7 @@ namespace Vanilla
         virtual void                                    UIPanelTick( vaApplicationBase & application ) override;
     };
 
-    inline void vaRenderMeshDrawList::Insert( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate, const vaVector4 & customColor )
+    inline void vaRenderMeshDrawList::Insert( const std::shared_ptr<vaRenderMesh> & mesh, const std::shared_ptr<vaRenderMaterial> & material, const vaMatrix4x4 & transform, vaShadingRate shadingRate, const vaVector4 & customColor, int lodLevel )
     {
         if( mesh == nullptr )
         {
@@ -359,9 +380,7 @@ namespace Vanilla
             VA_WARN( "vaRenderMeshDrawList::Insert - trying to add nullptr material, ignoring" );
             return;
         }
-        m_sortState.Sorted = false;
-        
-        m_drawList.push_back( Entry( mesh, material, transform, shadingRate, customColor ) );
+        m_drawList.push_back( Entry( mesh, material, transform, shadingRate, customColor, lodLevel ) );
     }
 
 }
\ No newline at end of file
@@ -93,6 +93,19 @@ void vaRenderSelection::Reset( )
 //{ 
 //}
 
+vaRenderSelection::FilterSettings vaRenderSelection::FilterSettings::FrustumCull( const vaCameraBase & camera )
+{
+    FilterSettings ret; 
+    ret.FrustumPlanes.resize( 6 ); 
+    camera.CalcFrustumPlanes( &ret.FrustumPlanes[0] ); 
+
+    float XFOV, YFOV;
+    camera.GetFOVs( XFOV, YFOV );
+    ret.LODReferencePoint   = camera.GetPosition( );
+    ret.LODPixelScale       = (float)camera.GetViewportHeight( ) / ( 2.0f * std::tan( YFOV * 0.5f ) );
+    return ret;
+}
+
 // depends on the shadowmap type
 vaRenderSelection::FilterSettings vaRenderSelection::FilterSettings::ShadowmapCull( const vaShadowmap & shadowmap )
 {
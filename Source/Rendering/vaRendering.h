@@ -369,13 +369,19 @@ namespace Vanilla
         struct FilterSettings
         {
             vaBoundingSphere                    BoundingSphereFrom      = vaBoundingSphere::Degenerate; //( { 0, 0, 0 }, 0.0f );
-            vaBoundingSphere                    BoundingSphereTo        = vaBoundingSphere::Degenerate; //( { 0, 0, 0 }, 0.0f );
+            vaBoundingSphere                    BoundingSphereTo        = vaBoundingSphere::Degenerate; //( { 0, 0, 0 }, 0.0f );     // if not degenerate, only items whose bounds intersect it are selected (for ex. light range for shadow casters)
             vector<vaPlane>                     FrustumPlanes;
 
+            // screen space error based LOD selection (see vaRenderMesh::SelectLOD); LODPixelScale is viewport height / ( 2 * tan( yfov / 2 ) ) 
+            // and LODs are disabled (always LOD 0) if it's 0
+            vaVector3                           LODReferencePoint       = vaVector3( 0, 0, 0 );
+            float                               LODPixelScale           = 0.0f;
+            float                               LODErrorThreshold       = 1.0f;     // in pixels
+
             FilterSettings( ) { }
 
             // settings for frustum culling for a regular draw based on a given camera
-            static FilterSettings               FrustumCull( const vaCameraBase & camera ) { FilterSettings ret; ret.FrustumPlanes.resize( 6 ); camera.CalcFrustumPlanes( &ret.FrustumPlanes[0] ); return ret; }
+            static FilterSettings               FrustumCull( const vaCameraBase & camera );
             static FilterSettings               ShadowmapCull( const vaShadowmap & shadowmap );
             static FilterSettings               EnvironmentProbeCull( const vaIBLProbeData & probeData );
         };
@@ -26,6 +26,13 @@
 
 #include "vaStandardShapes.h"
 
+#include "Core/Misc/vaSelfTest.h"
+
+#include <map>
+#include <tuple>
+#include <cstring>
+#include <array>
+
 using namespace Vanilla;
 
 void vaStandardShapes::CreatePlane( std::vector<vaVector3> & outVertices, std::vector<uint32> & outIndices, float sizeX, float sizeY, bool doubleSided )
@@ -5240,6 +5247,240 @@ void vaStandardShapes::CreateTeapot( std::vector<vaVector3> & outVertices, std::
 }
 
 
+namespace
+{
+    enum class CachedShapeType : int32
+    {
+        Plane,
+        Grid,
+        Tetrahedron,
+        Cube,
+        Octahedron,
+        Icosahedron,
+        Dodecahedron,
+        Sphere,
+        Cylinder,
+        Teapot,
+        SphereUVWrapped,
+    };
+
+    // shape type + all of the parameters of the matching Create* function; floats are keyed by their bit pattern so that
+    // the ordering stays strict (NaN-s) and only bit-identical parameters share geometry
+    struct CachedShapeKey
+    {
+        CachedShapeType                 Type;
+        int32                           Ints[2]     = { 0, 0 };
+        uint32                          Floats[3]   = { 0, 0, 0 };
+        bool                            Bools[2]    = { false, false };
+
+        explicit CachedShapeKey( CachedShapeType type ) : Type( type ) { }
+
+        void SetFloat( int index, float value )     { static_assert( sizeof( float ) == sizeof( uint32 ), "" ); std::memcpy( &Floats[index], &value, sizeof( float ) ); }
+
+        bool operator < ( const CachedShapeKey & other ) const
+        {
+            return std::tie( Type, Ints[0], Ints[1], Floats[0], Floats[1], Floats[2], Bools[0], Bools[1] ) 
+                < std::tie( other.Type, other.Ints[0], other.Ints[1], other.Floats[0], other.Floats[1], other.Floats[2], other.Bools[0], other.Bools[1] );
+        }
+    };
+
+    struct ShapeCache
+    {
+        mutex                                                                       Mutex;
+        std::map<CachedShapeKey, shared_ptr<const vaStandardShapes::Geometry>>      Entries;
+
+        void                                                                        Clear( )            { std::lock_guard<mutex> lock( Mutex ); Entries.clear( ); }
+        int                                                                         Count( )            { std::lock_guard<mutex> lock( Mutex ); return (int)Entries.size( ); }
+    };
+
+    // the one behind the Cached* functions; SelfTest uses its own so it doesn't disturb this one
+    static ShapeCache                                                               s_shapeCache;
+
+    static shared_ptr<const vaStandardShapes::Geometry> FindOrCreateCachedShape( ShapeCache & cache, const CachedShapeKey & key, const std::function<void( vaStandardShapes::Geometry & )> & generator )
+    {
+        {
+            std::lock_guard<mutex> lock( cache.Mutex );
+            auto it = cache.Entries.find( key );
+            if( it != cache.Entries.end( ) )
+                return it->second;
+        }
+
+        // generate outside of the lock - some of these (shared vertex spheres) are slow; if another thread was faster,
+        // its version is kept and this one dropped
+        shared_ptr<vaStandardShapes::Geometry> geometry = std::make_shared<vaStandardShapes::Geometry>( );
+        generator( *geometry );
+
+        // keeps the source order if it's already better (teapot)
+        vaTriangleMeshTools::OptimizeVertexCache( geometry->Indices, 0, geometry->Indices.size( ), (int)geometry->Vertices.size( ) );
+
+        std::lock_guard<mutex> lock( cache.Mutex );
+        auto it = cache.Entries.find( key );
+        if( it != cache.Entries.end( ) )
+            return it->second;
+        if( (int)cache.Entries.size( ) >= vaStandardShapes::c_maxCachedShapes )
+        {
+            for( auto cit = cache.Entries.begin( ); cit != cache.Entries.end( ); )
+                cit = ( cit->second.use_count( ) == 1 ) ? ( cache.Entries.erase( cit ) ) : ( std::next( cit ) );
+            if( (int)cache.Entries.size( ) >= vaStandardShapes::c_maxCachedShapes )
+                return geometry;
+        }
+        return cache.Entries.insert( std::make_pair( key, shared_ptr<const vaStandardShapes::Geometry>( geometry ) ) ).first->second;
+    }
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedPlane( float sizeX, float sizeY, bool doubleSided )
+{
+    CachedShapeKey key( CachedShapeType::Plane );
+    key.SetFloat( 0, sizeX ); key.SetFloat( 1, sizeY ); key.Bools[0] = doubleSided;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreatePlane( g.Vertices, g.Indices, sizeX, sizeY, doubleSided ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedGrid( int dimX, int dimY, float sizeX, float sizeY )
+{
+    CachedShapeKey key( CachedShapeType::Grid );
+    key.Ints[0] = dimX; key.Ints[1] = dimY; key.SetFloat( 0, sizeX ); key.SetFloat( 1, sizeY );
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateGrid( g.Vertices, g.Indices, dimX, dimY, sizeX, sizeY ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedTetrahedron( bool shareVertices )
+{
+    CachedShapeKey key( CachedShapeType::Tetrahedron );
+    key.Bools[0] = shareVertices;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateTetrahedron( g.Vertices, g.Indices, shareVertices ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedCube( bool shareVertices, float edgeHalfLength )
+{
+    CachedShapeKey key( CachedShapeType::Cube );
+    key.Bools[0] = shareVertices; key.SetFloat( 0, edgeHalfLength );
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateCube( g.Vertices, g.Indices, shareVertices, edgeHalfLength ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedOctahedron( bool shareVertices )
+{
+    CachedShapeKey key( CachedShapeType::Octahedron );
+    key.Bools[0] = shareVertices;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateOctahedron( g.Vertices, g.Indices, shareVertices ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedIcosahedron( bool shareVertices )
+{
+    CachedShapeKey key( CachedShapeType::Icosahedron );
+    key.Bools[0] = shareVertices;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateIcosahedron( g.Vertices, g.Indices, shareVertices ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedDodecahedron( bool shareVertices )
+{
+    CachedShapeKey key( CachedShapeType::Dodecahedron );
+    key.Bools[0] = shareVertices;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateDodecahedron( g.Vertices, g.Indices, shareVertices ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedSphere( int tessellationLevel, bool shareVertices )
+{
+    CachedShapeKey key( CachedShapeType::Sphere );
+    key.Ints[0] = tessellationLevel; key.Bools[0] = shareVertices;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateSphere( g.Vertices, g.Indices, tessellationLevel, shareVertices ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedCylinder( float height, float radiusBottom, float radiusTop, int tessellation, bool openTopBottom, bool shareVertices )
+{
+    CachedShapeKey key( CachedShapeType::Cylinder );
+    key.SetFloat( 0, height ); key.SetFloat( 1, radiusBottom ); key.SetFloat( 2, radiusTop ); key.Ints[0] = tessellation; key.Bools[0] = openTopBottom; key.Bools[1] = shareVertices;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateCylinder( g.Vertices, g.Indices, height, radiusBottom, radiusTop, tessellation, openTopBottom, shareVertices ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedTeapot( )
+{
+    return FindOrCreateCachedShape( s_shapeCache, CachedShapeKey( CachedShapeType::Teapot ), [&]( Geometry & g ) { CreateTeapot( g.Vertices, g.Indices ); } );
+}
+
+shared_ptr<const vaStandardShapes::Geometry> vaStandardShapes::CachedSphereUVWrapped( int tessellationLevel, bool shareVertices )
+{
+    CachedShapeKey key( CachedShapeType::SphereUVWrapped );
+    key.Ints[0] = tessellationLevel; key.Bools[0] = shareVertices;
+    return FindOrCreateCachedShape( s_shapeCache, key, [&]( Geometry & g ) { CreateSphereUVWrapped( g.Vertices, g.Indices, g.TextureCoords, tessellationLevel, shareVertices ); } );
+}
+
+void vaStandardShapes::ClearCache( )
+{
+    s_shapeCache.Clear( );
+}
+
+int vaStandardShapes::GetCachedCount( )
+{
+    return s_shapeCache.Count( );
+}
+
+bool vaStandardShapes::SelfTest( std::string * outInfo )
+{
+
+    // triangles as rotation-invariant tuples (winding preserved), sorted - equal if the index buffers draw the same thing
+    auto canonicalTriangles = [ ]( const std::vector<uint32> & indices )
+    {
+        std::vector<std::array<uint32, 3>> triangles;
+        triangles.reserve( indices.size( ) / 3 );
+        for( size_t i = 0; i + 2 < indices.size( ); i += 3 )
+        {
+            std::array<uint32, 3> t = { indices[i + 0], indices[i + 1], indices[i + 2] };
+            while( t[0] > t[1] || t[0] > t[2] )
+                t = { t[1], t[2], t[0] };
+            triangles.push_back( t );
+        }
+        std::sort( triangles.begin( ), triangles.end( ) );
+        return triangles;
+    };
+
+    ShapeCache cache;
+
+    struct TestShape
+    {
+        const char *                                                Name;
+        bool                                                        MustImprove;    // teapot source data is already in a good order
+        CachedShapeKey                                              Key;
+        std::function<void( Geometry & )>                           Create;
+    };
+    CachedShapeKey sphereKey( CachedShapeType::Sphere );
+    sphereKey.Ints[0] = 3; sphereKey.Bools[0] = true;
+    const TestShape shapes[] = {
+        { "teapot", false,  CachedShapeKey( CachedShapeType::Teapot ), [ ]( Geometry & g ) { CreateTeapot( g.Vertices, g.Indices ); } },
+        { "sphere", true,   sphereKey,                                  [ ]( Geometry & g ) { CreateSphere( g.Vertices, g.Indices, 3, true ); } },
+    };
+
+    for( const TestShape & shape : shapes )
+    {
+        shared_ptr<const Geometry> cached = FindOrCreateCachedShape( cache, shape.Key, shape.Create );
+        if( cached == nullptr || cached != FindOrCreateCachedShape( cache, shape.Key, shape.Create ) )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: repeated lookup didn't return the cached geometry", shape.Name ) );
+
+        Geometry original;
+        shape.Create( original );
+        if( original.Vertices != cached->Vertices )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: cached vertices differ from the generated ones", shape.Name ) );
+        if( canonicalTriangles( original.Indices ) != canonicalTriangles( cached->Indices ) )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: vertex cache optimization changed the set of triangles", shape.Name ) );
+
+        const float acmrBefore  = vaTriangleMeshTools::ComputeACMR( original.Indices, 0, original.Indices.size( ) );
+        const float acmrAfter   = vaTriangleMeshTools::ComputeACMR( cached->Indices, 0, cached->Indices.size( ) );
+        if( acmrAfter > acmrBefore || ( shape.MustImprove && !( acmrAfter < acmrBefore ) ) )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: ACMR %s by vertex cache optimization (%.3f before, %.3f after)", shape.Name, ( acmrAfter > acmrBefore ) ? ( "made worse" ) : ( "not improved" ), acmrBefore, acmrAfter ) );
+
+        // held onto geometry must survive clearing the cache and a new lookup must regenerate identical data
+        cache.Clear( );
+        if( cache.Count( ) != 0 )
+            return vaSelfTest::Fail( outInfo, "clearing the cache left entries behind" );
+        shared_ptr<const Geometry> regenerated = FindOrCreateCachedShape( cache, shape.Key, shape.Create );
+        if( regenerated == cached || regenerated->Indices != cached->Indices || regenerated->Vertices != cached->Vertices )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: geometry regenerated after ClearCache differs (or wasn't regenerated)", shape.Name ) );
+        if( cache.Count( ) != 1 )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: expected 1 cached shape, got %d", shape.Name, cache.Count( ) ) );
+        cache.Clear( );
+    }
+    return vaSelfTest::Pass( outInfo );
+}
+
+
 // 750 //---------------------------------------------------------------------
 //  751 // MakeTorus helper
 //  752 //---------------------------------------------------------------------
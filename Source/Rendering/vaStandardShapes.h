@@ -53,6 +53,42 @@ namespace Vanilla
         // versions with UVs
         static void CreateSphereUVWrapped( std::vector<vaVector3> & outVertices, std::vector<uint32> & outIndices, std::vector<vaVector2> & outTextureCoords, int tessellationLevel, bool shareVertices );
 
+    public:
+        struct Geometry
+        {
+            std::vector<vaVector3>              Vertices;
+            std::vector<uint32>                 Indices;
+            std::vector<vaVector2>              TextureCoords;      // only for the UVWrapped shapes
+
+            void                                CopyTo( std::vector<vaVector3> & outVertices, std::vector<uint32> & outIndices ) const   { outVertices = Vertices; outIndices = Indices; }
+        };
+
+        // Cached versions of the above: each unique shape type + parameters combination is generated once (with index order
+        // optimized for the post-transform vertex cache) and then shared. The returned geometry is immutable and can be
+        // held onto for as long as needed, even after ClearCache. Thread-safe.
+        static shared_ptr<const Geometry>       CachedPlane( float sizeX, float sizeY, bool doubleSided );
+        static shared_ptr<const Geometry>       CachedGrid( int dimX, int dimY, float sizeX, float sizeY );
+        static shared_ptr<const Geometry>       CachedTetrahedron( bool shareVertices );
+        static shared_ptr<const Geometry>       CachedCube( bool shareVertices, float edgeHalfLength = 0.7071067811865475f );
+        static shared_ptr<const Geometry>       CachedOctahedron( bool shareVertices );
+        static shared_ptr<const Geometry>       CachedIcosahedron( bool shareVertices );
+        static shared_ptr<const Geometry>       CachedDodecahedron( bool shareVertices );
+        static shared_ptr<const Geometry>       CachedSphere( int tessellationLevel, bool shareVertices );
+        static shared_ptr<const Geometry>       CachedCylinder( float height, float radiusBottom, float radiusTop, int tessellation, bool openTopBottom, bool shareVertices );
+        static shared_ptr<const Geometry>       CachedTeapot( );
+        static shared_ptr<const Geometry>       CachedSphereUVWrapped( int tessellationLevel, bool shareVertices );
+
+        // At most c_maxCachedShapes are kept; when full, entries no longer referenced from outside get dropped first and
+        // if that doesn't free anything the new shape is returned uncached. vaRenderDevice::DeinitializeBase clears it.
+        static const int                        c_maxCachedShapes   = 128;
+        static void                             ClearCache( );
+        static int                              GetCachedCount( );
+
+        // Checks the cache and its vertex cache optimization on the teapot and a shared vertex sphere: repeated lookups return
+        // the same geometry, ACMR is lower than for the original index order while the set of triangles is unchanged, and
+        // geometry held onto stays valid across clearing. Uses a private cache so the shared one is left alone; describes the first
+        // failure in outInfo (see vaSelfTest).
+        static bool                             SelfTest( std::string * outInfo = nullptr );
     };
 
 }
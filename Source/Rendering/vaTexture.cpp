@@ -117,6 +117,9 @@ void vaTexture::InitializePreLoadDefaults( )
     m_arrayCount        = 0;
     m_sampleCount       = 0;
     m_mipLevels         = 0;
+    m_apackDataOffset   = -1;
+    m_apackDataSize     = 0;
+    m_apackDroppedMips  = 0;
 }
 
 shared_ptr<vaTexture> vaTexture::CreateFromImageFile( vaRenderDevice & device, const wstring & storagePath, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags binds, vaTextureContentsType contentsType )
@@ -138,14 +141,14 @@ shared_ptr<vaTexture> vaTexture::CreateFromImageFile( vaRenderDevice & device, c
     }
 }
 
-shared_ptr<vaTexture> vaTexture::CreateFromImageBuffer( vaRenderDevice & device, void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags binds, vaTextureContentsType contentsType )
+shared_ptr<vaTexture> vaTexture::CreateFromImageBuffer( vaRenderDevice & device, void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags binds, vaTextureContentsType contentsType, int maxDimension )
 {
     assert( (binds & (vaResourceBindSupportFlags::RenderTarget | vaResourceBindSupportFlags::UnorderedAccess | vaResourceBindSupportFlags::DepthStencil )) == 0 );
 
     shared_ptr<vaTexture> texture = VA_RENDERING_MODULE_CREATE_SHARED( vaTexture, vaTextureConstructorParams( device, vaCore::GUIDCreate( ) ) );
     texture->Initialize( binds, vaResourceAccessFlags::Default, vaResourceFormat::Automatic, vaResourceFormat::Automatic, vaResourceFormat::Automatic, vaResourceFormat::Automatic, vaResourceFormat::Automatic, vaTextureFlags::None, 0, -1, 0, -1, vaTextureContentsType::GenericColor );
 
-    if( texture->Import( buffer, bufferSize, loadFlags, binds, contentsType ) )
+    if( texture->Import( buffer, bufferSize, loadFlags, binds, contentsType, maxDimension ) )
     {
         texture->UIDObject_Track( );    // safe to start tracking, texture loaded
         return texture;
@@ -178,6 +178,12 @@ namespace Vanilla
 		// * warning, the m_smartThis gets 'refreshed' in Destroy
         shared_ptr< vaTexture* >            m_smartThis                       = std::make_shared<vaTexture*>(this);
 
+        // where the image data is within the .apack file this texture was loaded from (-1 if not loaded from a seekable stream) - used 
+        // by vaTextureStreamingManager to re-read the data with a different number of MIPs
+        int64                               m_apackDataOffset       = -1;
+        int64                               m_apackDataSize         = 0;
+        int                                 m_apackDroppedMips      = 0;    // number of top MIPs skipped when created from the above data (the .apack has them all)
+
     protected:
         static const int                    c_fileVersion           = 3;
 
@@ -195,7 +201,8 @@ namespace Vanilla
         // loading from file / buffer
         static shared_ptr<vaTexture>        CreateFromImageFile( vaRenderDevice & device, const wstring & storagePath, vaTextureLoadFlags loadFlags = vaTextureLoadFlags::Default, vaResourceBindSupportFlags binds = vaResourceBindSupportFlags::ShaderResource, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor );
         static shared_ptr<vaTexture>        CreateFromImageFile( vaRenderDevice & device, const string & storagePath, vaTextureLoadFlags loadFlags = vaTextureLoadFlags::Default, vaResourceBindSupportFlags binds = vaResourceBindSupportFlags::ShaderResource, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor )       { return CreateFromImageFile( device, vaStringTools::SimpleWiden(storagePath), loadFlags, binds, contentsType ); }
-        static shared_ptr<vaTexture>        CreateFromImageBuffer( vaRenderDevice & device, void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags = vaTextureLoadFlags::Default, vaResourceBindSupportFlags binds = vaResourceBindSupportFlags::ShaderResource, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor );
+        // maxDimension != 0 will skip top MIP levels larger than maxDimension (only supported for .dds data with MIPs)
+        static shared_ptr<vaTexture>        CreateFromImageBuffer( vaRenderDevice & device, void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags = vaTextureLoadFlags::Default, vaResourceBindSupportFlags binds = vaResourceBindSupportFlags::ShaderResource, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor, int maxDimension = 0 );
         
         // 1D textures (regular, array)
         static shared_ptr<vaTexture>        Create1D( vaRenderDevice & device, vaResourceFormat format, int width, int mipLevels, int arraySize, vaResourceBindSupportFlags bindFlags, vaResourceAccessFlags accessFlags = vaResourceAccessFlags::Default, vaResourceFormat srvFormat = vaResourceFormat::Automatic, vaResourceFormat rtvFormat = vaResourceFormat::Automatic, vaResourceFormat dsvFormat = vaResourceFormat::Automatic, vaResourceFormat uavFormat = vaResourceFormat::Automatic, vaTextureFlags flags = vaTextureFlags::None, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor, void * initialData = nullptr );
@@ -253,6 +260,11 @@ namespace Vanilla
         void                                SetOverrideView( const shared_ptr<vaTexture> & overrideView )   { m_overrideView = overrideView; }
         const shared_ptr<vaTexture> &       GetOverrideView( )                                              { return m_overrideView; }
 
+        int64                               GetAPACKDataOffset( ) const                                     { return m_apackDataOffset; }
+        int64                               GetAPACKDataSize( ) const                                       { return m_apackDataSize; }
+        int                                 GetAPACKDroppedMips( ) const                                    { return m_apackDroppedMips; }
+        void                                SetAPACKDataLocation( int64 offset, int64 size, int droppedMips = 0 ) { m_apackDataOffset = offset; m_apackDataSize = size; m_apackDroppedMips = droppedMips; }
+
         // these can only happen on the main thread and require main render device context to be created - limitations for simplicity
         virtual void                        UpdateSubresources( vaRenderDeviceContext & renderContext, uint32 firstSubresource, /*const*/ std::vector<vaTextureSubresourceData> & subresources ) = 0;
         virtual bool                        TryMap( vaRenderDeviceContext & renderContext, vaResourceMapType mapType, bool doNotWait = false )                             = 0;
@@ -270,6 +282,8 @@ namespace Vanilla
 
         // virtual void                        UpdateSubresource( vaRenderDeviceContext & renderContext, int dstSubresourceIndex, const vaBoxi & dstBox, void * srcData, int srcDataRowPitch, int srcDataDepthPitch = 0 ) = 0;
         virtual void                        ResolveSubresource( vaRenderDeviceContext & renderContext, const shared_ptr<vaTexture> & dstResource, uint dstSubresource, uint srcSubresource, vaResourceFormat format = vaResourceFormat::Automatic ) = 0;
+        // copies a whole subresource (subresource index is mipSlice + arraySlice * mipLevels, same as D3D) of this texture into one of dstResource; sizes and formats must be compatible
+        virtual void                        CopySubresource( vaRenderDeviceContext & renderContext, const shared_ptr<vaTexture> & dstResource, uint dstSubresource, uint srcSubresource ) = 0;
 
         // Will try to create a BC5-6-7 compressed copy of the texture to the best of its abilities or if it can't then return nullptr; very rudimentary at the moment, future upgrades required.
         virtual shared_ptr<vaTexture>       TryCompress( )                                                                                                              = 0;
@@ -285,7 +299,7 @@ namespace Vanilla
 
     protected:
         virtual bool                        Import( const wstring & storageFilePath, vaTextureLoadFlags loadFlags, vaResourceBindSupportFlags binds, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor ) = 0;
-        virtual bool                        Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags = vaTextureLoadFlags::Default, vaResourceBindSupportFlags binds = vaResourceBindSupportFlags::ShaderResource, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor ) = 0;
+        virtual bool                        Import( void * buffer, uint64 bufferSize, vaTextureLoadFlags loadFlags = vaTextureLoadFlags::Default, vaResourceBindSupportFlags binds = vaResourceBindSupportFlags::ShaderResource, vaTextureContentsType contentsType = vaTextureContentsType::GenericColor, int maxDimension = 0 ) = 0;
         virtual void                        Destroy( ) = 0;
 
         virtual shared_ptr<vaTexture>       CreateViewInternal( const shared_ptr<vaTexture> & thisTexture, vaResourceBindSupportFlags bindFlags, vaResourceFormat srvFormat, vaResourceFormat rtvFormat, vaResourceFormat dsvFormat, vaResourceFormat uavFormat, vaTextureFlags flags, int viewedMipSliceMin, int viewedMipSliceCount, int viewedArraySliceMin, int viewedArraySliceCount ) = 0;
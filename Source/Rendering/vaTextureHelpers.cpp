@@ -29,6 +29,60 @@
 
 using namespace Vanilla;
 
+// hashing & comparison work on the raw bytes so there must be no padding
+static_assert( sizeof( vaTexturePool::ItemDesc ) == 14 * 4, "vaTexturePool::ItemDesc must have no padding" );
+
+size_t vaTexturePool::ItemDescHasher::operator()( const ItemDesc & desc ) const
+{
+    // FNV-1a
+    uint64 hash = 0xcbf29ce484222325ull;
+    const uint8 * bytes = reinterpret_cast<const uint8 *>( &desc );
+    for( size_t i = 0; i < sizeof( ItemDesc ); i++ )
+        hash = ( hash ^ bytes[i] ) * 0x100000001b3ull;
+    return (size_t)hash;
+}
+
+int vaTexturePool::ComputeFullMIPChainLevels( int sizeX, int sizeY, int sizeZ )
+{
+    int largest = vaMath::Max( sizeX, vaMath::Max( sizeY, sizeZ ) );
+    int mipLevels;
+    for( mipLevels = 1; largest > 1; largest >>= 1 )
+        mipLevels++;
+    return mipLevels;
+}
+
+int64 vaTexturePool::ComputeSizeInBytes( const ItemDesc & desc )
+{
+    const int blockSize = vaResourceFormatHelpers::GetBlockSizeInBytes( desc.ResourceFormat );
+    const int pixelSize = vaResourceFormatHelpers::GetPixelSizeInBytes( desc.ResourceFormat );
+    assert( blockSize > 0 || pixelSize > 0 );
+
+    int sizeX = vaMath::Max( 1, desc.SizeX );
+    int sizeY = vaMath::Max( 1, desc.SizeY );
+    int sizeZ = vaMath::Max( 1, desc.SizeZ );
+    // SizeZ is depth for 3D textures (halves with each MIP) and array size for the rest
+    const bool isVolume = desc.Type == vaTextureType::Texture3D;
+
+    int mipLevels = desc.MIPLevels;
+    if( mipLevels == 0 )    // full MIP chain
+        mipLevels = ComputeFullMIPChainLevels( sizeX, sizeY, ( isVolume ) ? ( sizeZ ) : ( 1 ) );
+
+    int64 total = 0;
+    for( int mip = 0; mip < mipLevels; mip++ )
+    {
+        const int64 mipX = vaMath::Max( 1, sizeX >> mip );
+        const int64 mipY = vaMath::Max( 1, sizeY >> mip );
+        const int64 mipZ = ( isVolume ) ? ( vaMath::Max( 1, sizeZ >> mip ) ) : ( 1 );
+        if( blockSize > 0 )
+            total += ( ( mipX + 3 ) / 4 ) * ( ( mipY + 3 ) / 4 ) * mipZ * blockSize;
+        else
+            total += mipX * mipY * mipZ * pixelSize;
+    }
+    if( !isVolume )
+        total *= sizeZ;
+    return total * vaMath::Max( 1, desc.SampleCount );
+}
+
 void vaTexturePool::FillDesc( ItemDesc & desc, const shared_ptr< vaTexture > texture )
 {
     desc.Flags              = texture->GetFlags();
@@ -47,10 +101,14 @@ void vaTexturePool::FillDesc( ItemDesc & desc, const shared_ptr< vaTexture > tex
     desc.MIPLevels          = texture->GetMipLevels();
 }
 
-shared_ptr< vaTexture > vaTexturePool::FindOrCreate2D( vaRenderDevice & device, vaResourceFormat format, int width, int height, int mipLevels, int arraySize, int sampleCount, vaResourceBindSupportFlags bindFlags, vaResourceAccessFlags accessFlags, void * initialData, int initialDataRowPitch, vaResourceFormat srvFormat, vaResourceFormat rtvFormat, vaResourceFormat dsvFormat, vaResourceFormat uavFormat, vaTextureFlags flags )
+shared_ptr< vaTexture > vaTexturePool::FindOrCreate2D( vaResourceFormat format, int width, int height, int mipLevels, int arraySize, int sampleCount, vaResourceBindSupportFlags bindFlags, vaResourceAccessFlags accessFlags, void * initialData, int initialDataRowPitch, vaResourceFormat srvFormat, vaResourceFormat rtvFormat, vaResourceFormat dsvFormat, vaResourceFormat uavFormat, vaTextureFlags flags )
 {
     std::unique_lock<std::mutex> lock( m_mutex );
 
+    // 0 means full MIP chain on creation, but Release records the actual count (FillDesc) - resolve it so both hash the same
+    if( mipLevels == 0 )
+        mipLevels = ComputeFullMIPChainLevels( width, height );
+
     ItemDesc desc;
     desc.Type = vaTextureType::Texture2D;
 
@@ -63,7 +121,6 @@ shared_ptr< vaTexture > vaTexturePool::FindOrCreate2D( vaRenderDevice & device,
     if( (uavFormat == vaResourceFormat::Automatic) && ((bindFlags & vaResourceBindSupportFlags::UnorderedAccess) != 0) )
         uavFormat = format;
 
-    desc.Device             = &device;
     desc.Flags              = flags;
     desc.AccessFlags        = accessFlags;
     desc.BindSupportFlags   = bindFlags;
@@ -78,57 +135,130 @@ shared_ptr< vaTexture > vaTexturePool::FindOrCreate2D( vaRenderDevice & device,
     desc.SampleCount        = sampleCount;
     desc.MIPLevels          = mipLevels;
 
-    shared_ptr< vaTexture > retTexture;
+    m_stats.Requests++;
 
-    auto it = m_items.find( desc );
-    if( it != m_items.end( ) )
+    // pooled textures have undefined contents so they can't be used if initial data was provided
+    if( initialData == nullptr )
     {
-        retTexture = it->second;
-        m_items.erase( it );
+        // if there's more than one match, take the most recently released one so that the choice only depends on the 
+        // order of Release calls
+        auto range = m_lookup.equal_range( desc );
+        auto best = m_lookup.end( );
+        for( auto it = range.first; it != range.second; it++ )
+            if( best == m_lookup.end( ) || it->second->ReleaseIndex > best->second->ReleaseIndex )
+                best = it;
+
+        if( best != m_lookup.end( ) )
+        {
+            shared_ptr< vaTexture > retTexture = best->second->Texture;
+            m_stats.Hits++;
+            m_stats.PooledBytes -= best->second->SizeInBytes;
+            m_stats.PooledCount--;
+            m_items.erase( best->second );
+            m_lookup.erase( best );
+            return retTexture;
+        }
     }
-    else
-    {
-        retTexture = vaTexture::Create2D( device, format, width, height, mipLevels, arraySize, sampleCount, bindFlags, accessFlags, srvFormat, rtvFormat, dsvFormat, uavFormat, flags, vaTextureContentsType::GenericColor, initialData, initialDataRowPitch );
+    lock.unlock( );
+
+    shared_ptr< vaTexture > retTexture = vaTexture::Create2D( m_device, format, width, height, mipLevels, arraySize, sampleCount, bindFlags, accessFlags, srvFormat, rtvFormat, dsvFormat, uavFormat, flags, vaTextureContentsType::GenericColor, initialData, initialDataRowPitch );
 
 #ifdef _DEBUG
-        ItemDesc testDesc;
-        FillDesc( testDesc, retTexture );
-        if( memcmp( &testDesc, &desc, sizeof(desc) ) )
-        {
-            // there's a mismatch in desc creation above and actual texture desc : you need to find and correct it; if it's platform/API dependent then add a platform dependent implementation
-            assert( false );
-        }
-#endif
+    ItemDesc testDesc;
+    FillDesc( testDesc, retTexture );
+    if( !( testDesc == desc ) )
+    {
+        // there's a mismatch in desc creation above and actual texture desc : you need to find and correct it; if it's platform/API dependent then add a platform dependent implementation
+        assert( false );
     }
+#endif
 
     return retTexture;
 }
 
 void vaTexturePool::Release( const shared_ptr< vaTexture > texture )
 {
-    std::unique_lock<std::mutex> lock( m_mutex );
-
     assert( texture != nullptr );
     if( texture == nullptr )
         return;
 
-    ItemDesc desc;
-    FillDesc( desc, texture );
+    PooledItem item;
+    FillDesc( item.Desc, texture );
+    item.Texture        = texture;
+    item.SizeInBytes    = ComputeSizeInBytes( item.Desc );
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+    item.ReleaseIndex   = m_releaseCounter++;
 
-    if( m_items.size( ) > m_maxPooledTextureCount )
+    // would never fit
+    if( item.SizeInBytes > m_memoryBudget || m_maxPooledTextureCount <= 0 )
     {
-        //assert( false );
-        // need to track memory use and start dropping 'oldest' (or just random one?) when over the limit
-//        return;
-        m_items.erase( m_items.begin() );
+        m_stats.Evictions++;
+        m_stats.EvictedBytes += item.SizeInBytes;
+        return;
     }
 
-    m_items.insert( std::make_pair( desc, texture ) );
+    m_items.push_front( std::move( item ) );
+    m_lookup.insert( std::make_pair( m_items.front( ).Desc, m_items.begin( ) ) );
+    m_stats.PooledBytes += m_items.front( ).SizeInBytes;
+    m_stats.PooledCount++;
+
+    EvictToBudget( );
+}
+
+void vaTexturePool::EvictToBudget( )
+{
+    while( m_items.size( ) > 0 && ( m_stats.PooledBytes > m_memoryBudget || m_stats.PooledCount > m_maxPooledTextureCount ) )
+    {
+        auto oldest = std::prev( m_items.end( ) );
+
+        auto range = m_lookup.equal_range( oldest->Desc );
+        for( auto it = range.first; it != range.second; it++ )
+            if( it->second == oldest )
+            {
+                m_lookup.erase( it );
+                break;
+            }
+
+        m_stats.Evictions++;
+        m_stats.EvictedBytes += oldest->SizeInBytes;
+        m_stats.PooledBytes  -= oldest->SizeInBytes;
+        m_stats.PooledCount--;
+        m_items.erase( oldest );
+    }
+    assert( m_items.size( ) == m_lookup.size( ) && (int)m_items.size( ) == m_stats.PooledCount );
 }
 
 void vaTexturePool::ClearAll( )
 { 
-    m_items.clear(); 
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_lookup.clear( );
+    m_items.clear( ); 
+    m_stats.PooledBytes = 0;
+    m_stats.PooledCount = 0;
+}
+
+void vaTexturePool::SetBudget( int64 memoryBudget, int maxPooledTextureCount )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_memoryBudget          = vaMath::Max( (int64)0, memoryBudget );
+    m_maxPooledTextureCount = vaMath::Max( 0, maxPooledTextureCount );
+    EvictToBudget( );
+}
+
+vaTexturePool::Statistics vaTexturePool::GetStatistics( )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_stats;
+}
+
+void vaTexturePool::ResetStatistics( )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    Statistics fresh;
+    fresh.PooledBytes = m_stats.PooledBytes;
+    fresh.PooledCount = m_stats.PooledCount;
+    m_stats = fresh;
 }
 
 vaTextureCPU2GPU::vaTextureCPU2GPU( const vaRenderingModuleParams & params ) : vaRenderingModule( params )
@@ -33,17 +33,15 @@ namespace Vanilla
 {
 
     //////////////////////////////////////////////////////////////////////////
-    // intended to provide reuse of textures but not very flexible yet
+    // Reuse of transient textures (render targets & similar): textures released to the pool are kept (up to a budget, 
+    // based on actual texture sizes) and returned by FindOrCreateXX when a matching one is requested. When over the 
+    // budget, the least recently released textures are dropped first. One per vaRenderDevice.
     //////////////////////////////////////////////////////////////////////////
-    class vaTexturePool : public vaSingletonBase<vaTexturePool>
+    class vaTexturePool
     {
     public:
-        int                                     m_maxPooledTextureCount;
-        int                                     m_maxMemoryUse;    
-
         struct ItemDesc
         {
-            vaRenderDevice *                    Device;
             vaTextureFlags                      Flags;
             vaResourceAccessFlags               AccessFlags;
             vaTextureType                       Type;
@@ -58,36 +56,78 @@ namespace Vanilla
             int                                 SizeZ;
             int                                 SampleCount;
             int                                 MIPLevels;
+
+            bool                                operator == ( const ItemDesc & other ) const    { return memcmp( this, &other, sizeof( ItemDesc ) ) == 0; }
+        };
+
+        struct ItemDescHasher
+        {
+            size_t                              operator()( const ItemDesc & desc ) const;
         };
 
-        struct ItemComparer
+        struct Statistics
         {
-            bool operator()( const ItemDesc & Left, const ItemDesc & Right ) const
-            {
-                // comparison logic goes here
-                return memcmp( &Left, &Right, sizeof( Right ) ) < 0;
-            }
+            int64                               Requests            = 0;
+            int64                               Hits                = 0;
+            int64                               Evictions           = 0;
+            int64                               EvictedBytes        = 0;
+            int64                               PooledBytes         = 0;
+            int                                 PooledCount         = 0;
+
+            float                               HitRate( ) const    { return ( Requests == 0 ) ? ( 0.0f ) : ( (float)Hits / (float)Requests ); }
         };
 
-        std::multimap< ItemDesc, shared_ptr<vaTexture>, ItemComparer >
-                                                m_items;
+    protected:
+        struct PooledItem
+        {
+            ItemDesc                            Desc;
+            shared_ptr<vaTexture>               Texture;
+            int64                               SizeInBytes;
+            uint64                              ReleaseIndex;
+        };
+
+        vaRenderDevice &                        m_device;
+
+        int                                     m_maxPooledTextureCount     = 64;
+        int64                                   m_memoryBudget              = 64 * 1024 * 1024;
+
+        // front is the most recently released
+        std::list<PooledItem>                   m_items;
+        std::unordered_multimap< ItemDesc, std::list<PooledItem>::iterator, ItemDescHasher >
+                                                m_lookup;
+
+        Statistics                              m_stats;
+        uint64                                  m_releaseCounter            = 0;
 
         std::mutex                              m_mutex;
 
     public:
-        vaTexturePool( ) : m_maxPooledTextureCount( 64 ), m_maxMemoryUse( 64 * 1024 * 1024 ) { }
+        vaTexturePool( vaRenderDevice & device ) : m_device( device ) { }
         virtual ~vaTexturePool( )               { }
 
     protected:
         void                                    FillDesc( ItemDesc & desc, const shared_ptr< vaTexture > texture );
+        void                                    EvictToBudget( );
 
     public:
-        shared_ptr< vaTexture >                 FindOrCreate2D( vaRenderDevice & device, vaResourceFormat format, int width, int height, int mipLevels, int arraySize, int sampleCount, vaResourceBindSupportFlags bindFlags, vaResourceAccessFlags accessFlags = vaResourceAccessFlags::Default, void * initialData = NULL, int initialDataRowPitch = 0, vaResourceFormat srvFormat = vaResourceFormat::Automatic, vaResourceFormat rtvFormat = vaResourceFormat::Automatic, vaResourceFormat dsvFormat = vaResourceFormat::Automatic, vaResourceFormat uavFormat = vaResourceFormat::Automatic, vaTextureFlags flags = vaTextureFlags::None );
+        // exact size of the texture contents (all MIPs, array slices and samples) - doesn't include API/driver padding
+        static int64                            ComputeSizeInBytes( const ItemDesc & desc );
+        // MIP count of a full chain (what a MIPLevels of 0 on creation resolves to); sizeZ only counts for volumes
+        static int                              ComputeFullMIPChainLevels( int sizeX, int sizeY, int sizeZ = 1 );
+
+        shared_ptr< vaTexture >                 FindOrCreate2D( vaResourceFormat format, int width, int height, int mipLevels, int arraySize, int sampleCount, vaResourceBindSupportFlags bindFlags, vaResourceAccessFlags accessFlags = vaResourceAccessFlags::Default, void * initialData = NULL, int initialDataRowPitch = 0, vaResourceFormat srvFormat = vaResourceFormat::Automatic, vaResourceFormat rtvFormat = vaResourceFormat::Automatic, vaResourceFormat dsvFormat = vaResourceFormat::Automatic, vaResourceFormat uavFormat = vaResourceFormat::Automatic, vaTextureFlags flags = vaTextureFlags::None );
         
-        // releases a texture into the pool so it can be returned by FindOrCreateXX
+        // releases a texture into the pool so it can be returned by FindOrCreateXX; the caller must not use it after that
         void                                    Release( const shared_ptr< vaTexture > texture );
 
         void                                    ClearAll( );
+
+        void                                    SetBudget( int64 memoryBudget, int maxPooledTextureCount );
+        int64                                   GetMemoryBudget( ) const                { return m_memoryBudget; }
+        int                                     GetMaxPooledTextureCount( ) const       { return m_maxPooledTextureCount; }
+
+        Statistics                              GetStatistics( );
+        void                                    ResetStatistics( );
     };
 
 
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+#include "vaTexture.h"
+
+namespace Vanilla
+{
+    // CPU-only texture processing: decode, format conversion, MIP generation and block compression with no render device
+    // involved, so it is safe to run on any (worker) thread. The output is a .dds image in memory that can be uploaded
+    // with vaTexture::CreateFromImageBuffer on the render thread.
+    // Implemented per platform (see vaTextureProcessingDX.cpp).
+    class vaTextureProcessing final
+    {
+    public:
+        struct ImportSettings
+        {
+            vaTextureLoadFlags          LoadFlags               = vaTextureLoadFlags::Default;
+            vaTextureContentsType       ContentsType            = vaTextureContentsType::GenericColor;
+            bool                        GenerateMIPs            = true;
+            bool                        Compress                = false;    // to BCn format suitable for ContentsType (if known)
+        };
+
+        struct ImportResult
+        {
+            vector<uint8>               DDSData;
+            vaTextureContentsType       ContentsType            = vaTextureContentsType::GenericColor;     // can differ from ImportSettings::ContentsType after compression (for ex. normals to XY only)
+            string                      Info;                               // human readable log of the steps done (or skipped)
+        };
+
+    private:
+        vaTextureProcessing( )          = delete;
+
+    public:
+        // .dds, .hdr, .tga and anything WIC can decode; returns false (with the reason in outResult.Info) on failure
+        static bool                     ImportImageFile( const wstring & filePath, const ImportSettings & settings, ImportResult & outResult );
+    };
+}
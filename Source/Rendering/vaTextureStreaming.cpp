@@ -0,0 +1,723 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaTextureStreaming.h"
+
+#include "Rendering/vaAssetPack.h"
+#include "Rendering/vaRenderMesh.h"
+#include "Rendering/vaRenderMaterial.h"
+
+#include "Scene/vaCameraBase.h"
+
+#include "Core/System/vaFileStream.h"
+
+#include "IntegratedExternals/vaImguiIntegration.h"
+
+using namespace Vanilla;
+
+int64 vaTextureStreamingModel::CalcMIPChainBytes( const TextureDesc & desc, int fromMip )
+{
+    int blockSize = vaResourceFormatHelpers::GetBlockSizeInBytes( desc.Format );
+    int pixelSize = ( blockSize == 0 ) ? ( vaResourceFormatHelpers::GetPixelSizeInBytes( desc.Format ) ) : ( 0 );
+
+    int64 total = 0;
+    for( int mip = fromMip; mip < desc.MipLevels; mip++ )
+    {
+        int64 sizeX = vaMath::Max( 1, desc.SizeX >> mip );
+        int64 sizeY = vaMath::Max( 1, desc.SizeY >> mip );
+        if( blockSize != 0 )
+            total += ( ( sizeX + 3 ) / 4 ) * ( ( sizeY + 3 ) / 4 ) * blockSize;
+        else
+            total += sizeX * sizeY * pixelSize;
+    }
+    return total;
+}
+
+int vaTextureStreamingModel::CalcMIPLevel( float texelsPerPixel, float mipBias )
+{
+    // trilinear filtering samples from floor(lod) and the one below it, so floor(lod) is the most detailed one we need
+    float lod = std::log2( vaMath::Max( texelsPerPixel, VA_EPSf ) ) + mipBias;
+    return vaMath::Max( 0, (int)std::floor( lod ) );
+}
+
+void vaTextureStreamingModel::UpdateMaxDroppedMip( Entry & entry ) const
+{
+    const TextureDesc & desc = entry.Desc;
+    bool blockCompressed = vaResourceFormatHelpers::GetBlockSizeInBytes( desc.Format ) != 0;
+
+    entry.MaxDroppedMip = 0;
+    while( entry.MaxDroppedMip + 1 < desc.MipLevels )
+    {
+        int sizeX = desc.SizeX >> ( entry.MaxDroppedMip + 1 );
+        int sizeY = desc.SizeY >> ( entry.MaxDroppedMip + 1 );
+        if( vaMath::Max( sizeX, sizeY ) < m_settings.MinResidentDimension )
+            break;
+        // top level of a block compressed texture has to be block aligned
+        if( blockCompressed && ( ( sizeX % 4 ) != 0 || ( sizeY % 4 ) != 0 ) )
+            break;
+        entry.MaxDroppedMip++;
+    }
+}
+
+float vaTextureStreamingModel::GetEffectivePriority( const Entry & entry ) const
+{
+    if( entry.LastRequestedFrame < 0 )
+        return 0.0f;
+    // not requested recently? fades with time so it gets reduced before anything that's currently visible
+    int64 framesUnused = m_frameIndex - entry.LastRequestedFrame;
+    return entry.Priority / (float)( 1 + framesUnused );
+}
+
+int vaTextureStreamingModel::Register( const TextureDesc & desc, int residentMip )
+{
+    assert( desc.MipLevels > 0 && desc.SizeX > 0 && desc.SizeY > 0 );
+
+    int handle;
+    if( m_freeHandles.size( ) > 0 )
+    {
+        handle = m_freeHandles.back( );
+        m_freeHandles.pop_back( );
+    }
+    else
+    {
+        handle = (int)m_entries.size( );
+        m_entries.push_back( Entry( ) );
+    }
+
+    Entry & entry = m_entries[handle];
+    entry = Entry( );
+    entry.Alive = true;
+    entry.Desc  = desc;
+    entry.ChainBytes.resize( desc.MipLevels + 1 );
+    for( int mip = 0; mip <= desc.MipLevels; mip++ )
+        entry.ChainBytes[mip] = CalcMIPChainBytes( desc, mip );
+    UpdateMaxDroppedMip( entry );
+    entry.ResidentMip   = vaMath::Clamp( residentMip, 0, entry.MaxDroppedMip );
+    entry.WantedMip     = entry.ResidentMip;
+    entry.TargetMip     = entry.ResidentMip;
+    return handle;
+}
+
+void vaTextureStreamingModel::Unregister( int handle )
+{
+    assert( IsRegistered( handle ) );
+    assert( m_entries[handle].PendingMip == -1 );   // finish (or fail) the action first
+    m_entries[handle] = Entry( );
+    m_freeHandles.push_back( handle );
+}
+
+void vaTextureStreamingModel::Request( int handle, float texelsPerPixel, float priority )
+{
+    RequestMip( handle, CalcMIPLevel( texelsPerPixel, m_settings.MIPBias ), priority );
+}
+
+void vaTextureStreamingModel::RequestMip( int handle, int mip, float priority )
+{
+    assert( IsRegistered( handle ) );
+    Entry & entry = m_entries[handle];
+
+    // first request this frame resets the previous one
+    if( entry.LastRequestedFrame != m_frameIndex )
+    {
+        entry.LastRequestedFrame    = m_frameIndex;
+        entry.WantedMip             = entry.MaxDroppedMip;
+        entry.Priority              = 0.0f;
+    }
+    entry.WantedMip = vaMath::Min( entry.WantedMip, vaMath::Clamp( mip, 0, entry.MaxDroppedMip ) );
+    entry.Priority  = vaMath::Max( entry.Priority, priority );
+}
+
+void vaTextureStreamingModel::Update( vector<Action> & outActions )
+{
+    outActions.clear( );
+    m_stats = Stats( );
+
+    if( m_lastMinResidentDimension != m_settings.MinResidentDimension )
+    {
+        m_lastMinResidentDimension = m_settings.MinResidentDimension;
+        for( Entry & entry : m_entries )
+            if( entry.Alive )
+            {
+                UpdateMaxDroppedMip( entry );
+                entry.WantedMip = vaMath::Min( entry.WantedMip, entry.MaxDroppedMip );
+            }
+    }
+
+    // start with what's wanted and, if that doesn't fit, keep dropping a MIP from the least important texture; each drop doubles the
+    // texture's cost of dropping further, so the reduction gets spread around instead of one texture losing all detail first
+    typedef pair<float, int> DropCandidate;
+    vector<DropCandidate> dropHeap;
+    auto heapCompare = [ ]( const DropCandidate & a, const DropCandidate & b ) { return a.first > b.first; };
+
+    int64 targetBytes = 0;
+    for( int handle = 0; handle < (int)m_entries.size( ); handle++ )
+    {
+        Entry & entry = m_entries[handle];
+        if( !entry.Alive )
+            continue;
+        m_stats.TrackedCount++;
+
+        bool requested = entry.LastRequestedFrame == m_frameIndex;
+        if( requested )
+        {
+            m_stats.RequestedCount++;
+            m_stats.MissingMIPCount += vaMath::Max( 0, entry.ResidentMip - entry.WantedMip );
+        }
+        else if( m_frameIndex - entry.LastRequestedFrame > m_settings.KeepUnusedFrames )
+            entry.WantedMip = entry.MaxDroppedMip;
+
+        entry.TargetMip = entry.WantedMip;
+        targetBytes += entry.ChainBytes[entry.TargetMip];
+        if( entry.TargetMip < entry.MaxDroppedMip )
+            dropHeap.push_back( std::make_pair( GetEffectivePriority( entry ), handle ) );
+    }
+    m_stats.WantedBytes = targetBytes;
+
+    if( targetBytes > m_settings.BudgetBytes )
+    {
+        std::make_heap( dropHeap.begin( ), dropHeap.end( ), heapCompare );
+        while( targetBytes > m_settings.BudgetBytes && dropHeap.size( ) > 0 )
+        {
+            std::pop_heap( dropHeap.begin( ), dropHeap.end( ), heapCompare );
+            DropCandidate candidate = dropHeap.back( );
+            dropHeap.pop_back( );
+
+            Entry & entry = m_entries[candidate.second];
+            targetBytes -= entry.ChainBytes[entry.TargetMip] - entry.ChainBytes[entry.TargetMip + 1];
+            entry.TargetMip++;
+            if( entry.TargetMip < entry.MaxDroppedMip )
+            {
+                dropHeap.push_back( std::make_pair( vaMath::Max( candidate.first, VA_EPSf ) * 2.0f, candidate.second ) );
+                std::push_heap( dropHeap.begin( ), dropHeap.end( ), heapCompare );
+            }
+        }
+    }
+    m_stats.TargetBytes = targetBytes;
+
+    // memory accounting: 'projected' is what will be resident once in-flight actions are done
+    int64 projectedBytes = 0;
+    for( const Entry & entry : m_entries )
+    {
+        if( !entry.Alive )
+            continue;
+        m_stats.ResidentBytes += entry.ChainBytes[entry.ResidentMip];
+        if( entry.PendingMip != -1 )
+            m_stats.InFlightBytes += entry.ChainBytes[entry.PendingMip];
+        projectedBytes += entry.ChainBytes[( entry.PendingMip != -1 ) ? ( entry.PendingMip ) : ( entry.ResidentMip )];
+    }
+
+    // evictions first (biggest savings first) as they make room, then loads (most important first) for as long as they fit
+    vector<pair<float, int>> evictions;
+    vector<pair<float, int>> loads;
+    for( int handle = 0; handle < (int)m_entries.size( ); handle++ )
+    {
+        const Entry & entry = m_entries[handle];
+        if( !entry.Alive || entry.PendingMip != -1 )
+            continue;
+        if( entry.TargetMip > entry.ResidentMip )
+            evictions.push_back( std::make_pair( (float)( entry.ChainBytes[entry.ResidentMip] - entry.ChainBytes[entry.TargetMip] ), handle ) );
+        else if( entry.TargetMip < entry.ResidentMip )
+            loads.push_back( std::make_pair( GetEffectivePriority( entry ), handle ) );
+    }
+    std::sort( evictions.begin( ), evictions.end( ), [ ]( const pair<float, int> & a, const pair<float, int> & b ) { return a.first > b.first; } );
+    std::sort( loads.begin( ), loads.end( ), [ ]( const pair<float, int> & a, const pair<float, int> & b ) { return a.first > b.first; } );
+
+    auto issue = [ & ]( int handle )
+    {
+        Entry & entry = m_entries[handle];
+        outActions.push_back( { handle, entry.ResidentMip, entry.TargetMip } );
+        projectedBytes += entry.ChainBytes[entry.TargetMip] - entry.ChainBytes[entry.ResidentMip];
+        m_stats.InFlightBytes += entry.ChainBytes[entry.TargetMip];
+        entry.PendingMip = entry.TargetMip;
+    };
+
+    for( const auto & eviction : evictions )
+    {
+        if( (int)outActions.size( ) >= m_settings.MaxActionsPerFrame )
+            break;
+        issue( eviction.second );
+    }
+    for( const auto & load : loads )
+    {
+        if( (int)outActions.size( ) >= m_settings.MaxActionsPerFrame )
+            break;
+        const Entry & entry = m_entries[load.second];
+        if( projectedBytes + entry.ChainBytes[entry.TargetMip] - entry.ChainBytes[entry.ResidentMip] > m_settings.BudgetBytes )
+            continue;
+        issue( load.second );
+    }
+}
+
+void vaTextureStreamingModel::OnActionFinished( int handle, bool success )
+{
+    assert( IsRegistered( handle ) );
+    Entry & entry = m_entries[handle];
+    assert( entry.PendingMip != -1 );
+    if( success )
+        entry.ResidentMip = entry.PendingMip;
+    entry.PendingMip = -1;
+}
+
+vaTextureStreamingManager::vaTextureStreamingManager( const vaRenderingModuleParams & params ) :
+    vaRenderingModule( params ),
+    vaUIPanel( "Texture streaming", 0, false, vaUIPanel::DockLocation::DockedLeftBottom )
+{
+}
+
+vaTextureStreamingManager::~vaTextureStreamingManager( )
+{
+    FinishPendingReads( true );
+}
+
+void vaTextureStreamingManager::ApplySettings( vaTextureStreamingModel & model ) const
+{
+    model.Settings( ).BudgetBytes           = (int64)vaMath::Max( 1, m_settings.BudgetMB ) * 1024 * 1024;
+    model.Settings( ).MinResidentDimension  = m_settings.MinResidentDimension;
+    model.Settings( ).MIPBias               = m_settings.MIPBias;
+    model.Settings( ).MaxActionsPerFrame    = m_settings.MaxActionsPerFrame;
+}
+
+void vaTextureStreamingManager::Reset( )
+{
+    assert( m_pendingReads.size( ) == 0 );
+    m_model = vaTextureStreamingModel( );
+    m_textures.clear( );
+    m_textureHandles.clear( );
+    m_meshUVDensities.clear( );
+}
+
+void vaTextureStreamingManager::Tick( const vaCameraBase & camera, const vaRenderMeshDrawList & opaque, const vaRenderMeshDrawList * transparent )
+{
+    assert( vaThreading::IsMainThread( ) );
+    VA_TRACE_CPU_SCOPE( TextureStreaming );
+
+    FinishPendingReads( false );
+
+    ApplySettings( m_model );
+
+    vector<vaTextureStreamingModel::Action> actions;
+    if( !m_settings.Enabled )
+    {
+        if( m_textures.size( ) == 0 )
+            return;
+
+        // bring everything back to full resolution and then stop tracking
+        bool allRestored = m_pendingReads.size( ) == 0;
+        m_model.Settings( ).BudgetBytes = std::numeric_limits<int64>::max( );
+        m_model.BeginFrame( );
+        for( int handle = 0; handle < m_model.GetHandleCount( ); handle++ )
+            if( m_model.IsRegistered( handle ) )
+            {
+                m_model.RequestMip( handle, 0, 1.0f );
+                allRestored &= m_model.GetResidentMip( handle ) == 0;
+            }
+        if( allRestored )
+        {
+            Reset( );
+            return;
+        }
+        m_model.Update( actions );
+    }
+    else
+    {
+        RegisterTextures( opaque );
+        if( transparent != nullptr )
+            RegisterTextures( *transparent );
+
+        m_model.BeginFrame( );
+        GatherRequests( m_model, opaque, camera );
+        if( transparent != nullptr )
+            GatherRequests( m_model, *transparent, camera );
+
+        m_model.Update( actions );
+    }
+
+    for( const auto & action : actions )
+        StartAction( action );
+}
+
+void vaTextureStreamingManager::RegisterTextures( const vaRenderMeshDrawList & drawList )
+{
+    for( int i = 0; i < drawList.Count( ); i++ )
+    {
+        const vaRenderMeshDrawList::Entry & entry = drawList[i];
+        if( entry.Material == nullptr )
+            continue;
+
+        entry.Material->EnumerateTextureNodes( [&]( const vaRenderMaterial::TextureNode & node )
+        {
+            if( node.GetTextureUID( ) == vaCore::GUIDNull( ) || m_textureHandles.find( node.GetTextureUID( ) ) != m_textureHandles.end( ) )
+                return;
+
+            // only plain 2D textures that know where they came from in an .apack we can re-read
+            int handle = -1;
+            shared_ptr<vaTexture> texture = node.GetTexture( );
+            vaAssetTexture * asset = ( texture != nullptr ) ? ( texture->GetParentAsset<vaAssetTexture>( ) ) : ( nullptr );
+            if( asset != nullptr && !asset->GetAssetPack( ).GetAPACKStoragePath( ).empty( ) && texture->GetAPACKDataOffset( ) >= 0
+                && texture->GetType( ) == vaTextureType::Texture2D && !texture->IsCubemap( ) && !texture->IsView( ) && texture->GetArrayCount( ) == 1 && texture->GetMipLevels( ) > 1
+                && texture->GetBindSupportFlags( ) == vaResourceBindSupportFlags::ShaderResource )
+            {
+                // it might already have top MIPs dropped if it was forgotten and is now being picked up again
+                const int droppedMips = texture->GetAPACKDroppedMips( );
+                vaTextureStreamingModel::TextureDesc desc;
+                desc.Format     = texture->GetResourceFormat( );
+                desc.SizeX      = texture->GetSizeX( ) << droppedMips;
+                desc.SizeY      = texture->GetSizeY( ) << droppedMips;
+                desc.MipLevels  = texture->GetMipLevels( ) + droppedMips;
+
+                if( vaResourceFormatHelpers::GetBlockSizeInBytes( desc.Format ) != 0 || vaResourceFormatHelpers::GetPixelSizeInBytes( desc.Format ) != 0 )
+                {
+                    handle = m_model.Register( desc, droppedMips );
+                    if( m_model.GetResidentMip( handle ) != droppedMips )
+                    {
+                        // more dropped than current settings allow - leave it as it is
+                        m_model.Unregister( handle );
+                        handle = -1;
+                    }
+                }
+                if( handle != -1 )
+                {
+                    if( handle >= (int)m_textures.size( ) )
+                        m_textures.resize( handle + 1 );
+                    StreamedTexture & streamed = m_textures[handle];
+                    streamed.Valid          = true;
+                    streamed.UID            = node.GetTextureUID( );
+                    streamed.ContentsType   = texture->GetContentsType( );
+                    streamed.BindFlags      = texture->GetBindSupportFlags( );
+                }
+            }
+            m_textureHandles.insert( std::make_pair( node.GetTextureUID( ), handle ) );
+        } );
+    }
+}
+
+const vaTextureStreamingManager::MeshUVDensity & vaTextureStreamingManager::GetMeshUVDensity( const shared_ptr<vaRenderMesh> & mesh )
+{
+    MeshUVDensity & density = m_meshUVDensities[mesh.get( )];
+    if( density.Mesh.lock( ) == mesh )
+        return density;
+
+    density = MeshUVDensity( );
+    density.Mesh = mesh;
+    if( mesh->GetTriangleMesh( ) == nullptr )
+        return density;
+
+    const auto & vertices   = mesh->GetTriangleMesh( )->Vertices( );
+    const auto & indices    = mesh->GetTriangleMesh( )->Indices( );
+
+    // area-weighted average gives the density the mesh is mostly textured at without outliers (slivers, degenerate UVs) dominating
+    double localArea    = 0.0;
+    double uvArea[2]    = { 0.0, 0.0 };
+    for( size_t t = 0; t+2 < indices.size( ); t += 3 )
+    {
+        const vaRenderMesh::StandardVertex & v0 = vertices[indices[t+0]];
+        const vaRenderMesh::StandardVertex & v1 = vertices[indices[t+1]];
+        const vaRenderMesh::StandardVertex & v2 = vertices[indices[t+2]];
+
+        // all doubled but that cancels out
+        localArea += vaVector3::Cross( v1.Position - v0.Position, v2.Position - v0.Position ).Length( );
+        uvArea[0] += std::abs( vaVector2::Cross( v1.TexCoord0 - v0.TexCoord0, v2.TexCoord0 - v0.TexCoord0 ) );
+        uvArea[1] += std::abs( vaVector2::Cross( v1.TexCoord1 - v0.TexCoord1, v2.TexCoord1 - v0.TexCoord1 ) );
+    }
+    if( localArea > 0.0 )
+    {
+        density.UVPerUnit[0] = (float)std::sqrt( uvArea[0] / localArea );
+        density.UVPerUnit[1] = (float)std::sqrt( uvArea[1] / localArea );
+    }
+    return density;
+}
+
+void vaTextureStreamingManager::GatherRequests( vaTextureStreamingModel & model, const vaRenderMeshDrawList & drawList, const vaCameraBase & camera )
+{
+    vaPlane frustumPlanes[6];
+    camera.CalcFrustumPlanes( frustumPlanes );
+    const vaVector3 cameraPos           = camera.GetPosition( );
+    const float nearPlane               = camera.GetNearPlaneDistance( );
+    const float pixelSizeAtUnitDistance = 2.0f * std::tan( camera.GetYFOV( ) * 0.5f ) / (float)vaMath::Max( 1, camera.GetViewportHeight( ) );
+
+    for( int i = 0; i < drawList.Count( ); i++ )
+    {
+        const vaRenderMeshDrawList::Entry & entry = drawList[i];
+        if( entry.Mesh == nullptr || entry.Material == nullptr )
+            continue;
+
+        const MeshUVDensity & density = GetMeshUVDensity( entry.Mesh );
+
+        // bounding sphere of the instance
+        const vaMatrix4x4 & transform = entry.Transform;
+        float scaleX = vaVector3( transform._11, transform._12, transform._13 ).Length( );
+        float scaleY = vaVector3( transform._21, transform._22, transform._23 ).Length( );
+        float scaleZ = vaVector3( transform._31, transform._32, transform._33 ).Length( );
+        float averageScale = std::cbrt( scaleX * scaleY * scaleZ );
+        if( averageScale <= VA_EPSf )
+            continue;
+
+        const vaBoundingBox & localBox = entry.Mesh->GetAABB( );
+        vaVector3 center    = vaVector3::TransformCoord( localBox.Min + localBox.Size * 0.5f, transform );
+        float radius        = ( localBox.Size * 0.5f ).Length( ) * vaMath::Max( scaleX, scaleY, scaleZ );
+
+        bool outside = false;
+        for( int p = 0; p < 6 && !outside; p++ )
+            outside = vaPlane::DotCoord( frustumPlanes[p], center ) < -radius;
+        if( outside )
+            continue;
+
+        // nearest point facing the camera gives the smallest footprint, which is what the most detailed MIP has to cover
+        float distance      = vaMath::Max( ( center - cameraPos ).Length( ) - radius, nearPlane );
+        float worldPerPixel = distance * pixelSizeAtUnitDistance;
+        float screenRadius  = radius / vaMath::Max( worldPerPixel, VA_EPSf );
+        float priority      = vaMath::Max( 1.0f, screenRadius * screenRadius );
+
+        entry.Material->EnumerateTextureNodes( [&]( const vaRenderMaterial::TextureNode & node )
+        {
+            auto it = m_textureHandles.find( node.GetTextureUID( ) );
+            if( it == m_textureHandles.end( ) || it->second == -1 || !model.IsRegistered( it->second ) )
+                return;
+            float uvPerUnit = density.UVPerUnit[ vaMath::Clamp( node.GetUVIndex( ), 0, 1 ) ];
+            if( uvPerUnit <= 0.0f )
+                return;
+
+            const vaTextureStreamingModel::TextureDesc & desc = model.GetDesc( it->second );
+            float uvPerPixel        = uvPerUnit / averageScale * worldPerPixel;
+            float texelsPerPixel    = uvPerPixel * std::sqrt( (float)desc.SizeX * (float)desc.SizeY );
+            model.Request( it->second, texelsPerPixel, priority );
+        } );
+    }
+}
+
+shared_ptr<vaTexture> vaTextureStreamingManager::FindCurrentTexture( int handle, int residentMip ) const
+{
+    shared_ptr<vaTexture> current = vaUIDObjectRegistrar::Find<vaTexture>( m_textures[handle].UID );
+    vaAssetTexture * asset = ( current != nullptr ) ? ( current->GetParentAsset<vaAssetTexture>( ) ) : ( nullptr );
+    if( asset == nullptr || asset->GetAssetPack( ).GetAPACKStoragePath( ).empty( ) || current->GetAPACKDataOffset( ) < 0 )
+        return nullptr;
+    if( current->GetAPACKDroppedMips( ) != residentMip || current->GetMipLevels( ) != m_model.GetDesc( handle ).MipLevels - residentMip )
+        return nullptr;
+    return current;
+}
+
+void vaTextureStreamingManager::ForgetTexture( int handle, bool allowReRegister )
+{
+    m_model.Unregister( handle );
+    if( allowReRegister )
+        m_textureHandles.erase( m_textures[handle].UID );
+    else
+        m_textureHandles[m_textures[handle].UID] = -1;
+    m_textures[handle] = StreamedTexture( );
+}
+
+void vaTextureStreamingManager::StartAction( const vaTextureStreamingModel::Action & action )
+{
+    // asset pack saved or reloaded since the texture was registered? 
+    shared_ptr<vaTexture> current = FindCurrentTexture( action.Handle, action.FromMip );
+    if( current == nullptr )
+    {
+        m_model.OnActionFinished( action.Handle, false );
+        ForgetTexture( action.Handle, true );
+        return;
+    }
+
+    PendingRead read;
+    read.Handle     = action.Handle;
+    read.FromMip    = action.FromMip;
+    read.ToMip      = action.ToMip;
+    read.DataOffset = current->GetAPACKDataOffset( );
+    read.DataSize   = current->GetAPACKDataSize( );
+    read.Data       = std::make_shared<vector<uint8>>( );
+
+    wstring                     path    = current->GetParentAsset<vaAssetTexture>( )->GetAssetPack( ).GetAPACKStoragePath( );
+    int64                       offset  = read.DataOffset;
+    int64                       size    = read.DataSize;
+    shared_ptr<vector<uint8>>   data    = read.Data;
+    read.Task = vaBackgroundTaskManager::GetInstance( ).Spawn( "TextureStreamingRead", vaBackgroundTaskManager::SpawnFlags::UseThreadPool,
+        [path, offset, size, data]( vaBackgroundTaskManager::TaskContext & )
+    {
+        vaFileStream file;
+        if( !file.Open( path, FileCreationMode::Open, FileAccessMode::Read, FileShareMode::Read ) )
+            return false;
+        file.Seek( offset );
+        data->resize( (size_t)size );
+        return file.Read( data->data( ), size );
+    } );
+
+    if( read.Task == nullptr )
+    {
+        m_model.OnActionFinished( action.Handle, false );
+        return;
+    }
+    m_pendingReads.push_back( read );
+}
+
+bool vaTextureStreamingManager::ApplyRead( const PendingRead & read, bool & outStale )
+{
+    const StreamedTexture & streamed = m_textures[read.Handle];
+
+    // replaced (pack saved/reloaded) while reading - the data read might be from a previous version of the file
+    shared_ptr<vaTexture> current = FindCurrentTexture( read.Handle, read.FromMip );
+    outStale = current == nullptr || current->GetAPACKDataOffset( ) != read.DataOffset || current->GetAPACKDataSize( ) != read.DataSize;
+    if( outStale )
+        return false;
+    vaAssetTexture * asset = current->GetParentAsset<vaAssetTexture>( );
+
+    const vaTextureStreamingModel::TextureDesc & desc = m_model.GetDesc( read.Handle );
+    int maxDimension = ( read.ToMip == 0 ) ? ( 0 ) : ( vaMath::Max( desc.SizeX, desc.SizeY ) >> read.ToMip );
+
+    shared_ptr<vaTexture> newTexture = vaTexture::CreateFromImageBuffer( GetRenderDevice( ), read.Data->data( ), read.Data->size( ), vaTextureLoadFlags::Default, streamed.BindFlags, streamed.ContentsType, maxDimension );
+    if( newTexture == nullptr )
+        return false;
+    assert( newTexture->GetMipLevels( ) == desc.MipLevels - read.ToMip );
+    newTexture->SetAPACKDataLocation( read.DataOffset, read.DataSize, read.ToMip );
+
+    asset->ReplaceTexture( newTexture );
+    return true;
+}
+
+void vaTextureStreamingManager::FinishPendingReads( bool waitForAll )
+{
+    for( int i = (int)m_pendingReads.size( ) - 1; i >= 0; i-- )
+    {
+        PendingRead & read = m_pendingReads[i];
+        if( waitForAll )
+            vaBackgroundTaskManager::GetInstance( ).WaitUntilFinished( read.Task );
+        else if( !vaBackgroundTaskManager::GetInstance( ).IsFinished( read.Task ) )
+            continue;
+
+        bool stale = false;
+        bool success = read.Task->Result && ApplyRead( read, stale );
+        if( !success && !stale )
+            VA_LOG_WARNING( "vaTextureStreamingManager - unable to stream texture MIPs, texture will no longer be streamed" );
+        m_model.OnActionFinished( read.Handle, success );
+        if( !success )
+            ForgetTexture( read.Handle, stale );
+        m_pendingReads.erase( m_pendingReads.begin( ) + i );
+    }
+}
+
+vaTextureStreamingManager::ReplayReport vaTextureStreamingManager::ReplayCameraPath( const vaRenderMeshDrawList & sceneMeshes, const vaCameraBase & referenceCamera, const std::function<bool( int frameIndex, vaCameraBase & camera )> & cameraPath, bool coldStart, int actionLatencyFrames )
+{
+    vaSimpleScopeTimerLog timer( "vaTextureStreamingManager camera path replay" );
+
+    RegisterTextures( sceneMeshes );
+
+    // same handles as m_model as long as all are registered in order
+    vaTextureStreamingModel model;
+    ApplySettings( model );
+    for( int handle = 0; handle < m_model.GetHandleCount( ); handle++ )
+    {
+        if( m_model.IsRegistered( handle ) )
+        {
+            int newHandle = model.Register( m_model.GetDesc( handle ), ( coldStart ) ? ( std::numeric_limits<int>::max( ) ) : ( 0 ) );
+            assert( newHandle == handle ); newHandle;
+        }
+        else
+        {
+            // placeholder to keep the handles matching
+            vaTextureStreamingModel::TextureDesc dummy; dummy.Format = vaResourceFormat::R8_UNORM; dummy.SizeX = dummy.SizeY = dummy.MipLevels = 1;
+            model.Register( dummy, 0 );
+        }
+    }
+    for( int handle = 0; handle < m_model.GetHandleCount( ); handle++ )
+        if( !m_model.IsRegistered( handle ) )
+            model.Unregister( handle );
+
+    ReplayReport report;
+    vector<pair<int, int>> inFlight;    // frame when finished, handle
+    vector<vaTextureStreamingModel::Action> actions;
+    int64 missingMIPsSum = 0;
+
+    vaCameraBase camera( referenceCamera );
+    for( int frame = 0; cameraPath( frame, camera ); frame++ )
+    {
+        camera.Tick( 0.0f, false );
+
+        for( int i = (int)inFlight.size( ) - 1; i >= 0; i-- )
+            if( inFlight[i].first <= frame )
+            {
+                model.OnActionFinished( inFlight[i].second, true );
+                inFlight.erase( inFlight.begin( ) + i );
+            }
+
+        model.BeginFrame( );
+        GatherRequests( model, sceneMeshes, camera );
+        model.Update( actions );
+
+        for( const auto & action : actions )
+        {
+            inFlight.push_back( std::make_pair( frame + actionLatencyFrames, action.Handle ) );
+            if( action.ToMip < action.FromMip )
+                report.Loads++;
+            else
+                report.Evictions++;
+        }
+
+        const vaTextureStreamingModel::Stats & stats = model.GetStats( );
+        report.FrameCount++;
+        report.PeakResidentBytes    = vaMath::Max( report.PeakResidentBytes, stats.ResidentBytes );
+        report.PeakInFlightBytes    = vaMath::Max( report.PeakInFlightBytes, stats.InFlightBytes );
+        if( stats.ResidentBytes + stats.InFlightBytes > model.Settings( ).BudgetBytes )
+            report.FramesOverBudget++;
+        missingMIPsSum += stats.MissingMIPCount;
+    }
+    report.AvgMissingMIPs = ( report.FrameCount > 0 ) ? ( (float)missingMIPsSum / (float)report.FrameCount ) : ( 0.0f );
+
+    VA_LOG( "vaTextureStreamingManager - replayed %d frames: peak resident %.1f MB (budget %d MB), peak in-flight %.1f MB, %d frames over budget, %d loads, %d evictions, %.2f missing MIPs per frame on average",
+        report.FrameCount, report.PeakResidentBytes / ( 1024.0 * 1024.0 ), m_settings.BudgetMB, report.PeakInFlightBytes / ( 1024.0 * 1024.0 ), report.FramesOverBudget, report.Loads, report.Evictions, report.AvgMissingMIPs );
+
+    return report;
+}
+
+void vaTextureStreamingManager::UIPanelTick( vaApplicationBase & application )
+{
+    application;
+#ifdef VA_IMGUI_INTEGRATION_ENABLED
+    ImGui::PushItemWidth( 120.0f );
+
+    ImGui::Checkbox( "Enabled", &m_settings.Enabled );
+    if( ImGui::IsItemHovered( ) )
+        ImGui::SetTooltip( "Only textures from uncompressed .apack files are streamed; disabling restores full resolution" );
+    ImGui::InputInt( "Budget (MB)", &m_settings.BudgetMB, 16 );
+    m_settings.BudgetMB = vaMath::Clamp( m_settings.BudgetMB, 16, 16 * 1024 );
+    ImGui::InputInt( "Min resident dimension", &m_settings.MinResidentDimension, 16 );
+    m_settings.MinResidentDimension = vaMath::Clamp( m_settings.MinResidentDimension, 4, 16 * 1024 );
+    ImGui::InputFloat( "MIP bias", &m_settings.MIPBias, 0.25f );
+    m_settings.MIPBias = vaMath::Clamp( m_settings.MIPBias, -2.0f, 4.0f );
+    ImGui::InputInt( "Max actions per frame", &m_settings.MaxActionsPerFrame, 1 );
+    m_settings.MaxActionsPerFrame = vaMath::Clamp( m_settings.MaxActionsPerFrame, 1, 64 );
+
+    ImGui::PopItemWidth( );
+
+    const vaTextureStreamingModel::Stats & stats = m_model.GetStats( );
+    ImGui::Separator( );
+    ImGui::Text( "Tracked textures: %d (%d requested last frame)", stats.TrackedCount, stats.RequestedCount );
+    ImGui::Text( "Resident: %.1f MB, in flight: %.1f MB", stats.ResidentBytes / ( 1024.0 * 1024.0 ), stats.InFlightBytes / ( 1024.0 * 1024.0 ) );
+    ImGui::Text( "Wanted: %.1f MB, target: %.1f MB", stats.WantedBytes / ( 1024.0 * 1024.0 ), stats.TargetBytes / ( 1024.0 * 1024.0 ) );
+    ImGui::Text( "Missing MIP levels: %d, pending reads: %d", stats.MissingMIPCount, (int)m_pendingReads.size( ) );
+
+    ImGui::Separator( );
+    if( ImGui::Button( "Replay camera path (no rendering)" ) )
+        m_replayRequested = true;
+    if( ImGui::IsItemHovered( ) )
+        ImGui::SetTooltip( "Runs the streaming model over the recorded camera path with current settings, without any IO or GPU work" );
+    if( m_lastReplayReport.FrameCount > 0 )
+    {
+        ImGui::Text( "Last replay: %d frames, peak resident %.1f MB, %d over budget", m_lastReplayReport.FrameCount, m_lastReplayReport.PeakResidentBytes / ( 1024.0 * 1024.0 ), m_lastReplayReport.FramesOverBudget );
+        ImGui::Text( "  %d loads, %d evictions, %.2f missing MIPs/frame", m_lastReplayReport.Loads, m_lastReplayReport.Evictions, m_lastReplayReport.AvgMissingMIPs );
+    }
+#endif
+}
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Texture MIP streaming: only keep the MIP levels of .apack-loaded textures that the current view actually samples,
+// within a memory budget.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+#include "Core/vaUI.h"
+
+#include "vaRendering.h"
+#include "vaTexture.h"
+
+namespace Vanilla
+{
+    class vaRenderMesh;
+    class vaRenderMeshDrawList;
+    class vaCameraBase;
+
+    // Device and IO independent part of texture streaming: tracks wanted / target / resident MIP levels for each texture, does
+    // the memory accounting and decides (based on priority and budget) which textures get more or fewer MIPs. Nothing in here
+    // touches the GPU or the disk so it can be driven headless (see vaTextureStreamingManager::ReplayCameraPath).
+    // "MIP" in here always refers to the most detailed MIP level resident, so a higher number means less memory.
+    class vaTextureStreamingModel
+    {
+    public:
+        struct Settings
+        {
+            int64                   BudgetBytes             = 512ll * 1024 * 1024;
+            int                     MinResidentDimension    = 128;      // textures never get reduced below this size (or below their full size if smaller)
+            float                   MIPBias                 = 0.0f;     // added to the computed MIP level; positive means less detail (same as sampler MIP LOD bias)
+            int                     MaxActionsPerFrame      = 4;        // max number of loads + evictions started per Update
+            int                     KeepUnusedFrames        = 120;      // textures no longer requested keep their MIPs for this long (in frames) before getting dropped to minimum
+        };
+
+        struct TextureDesc
+        {
+            vaResourceFormat        Format                  = vaResourceFormat::Unknown;
+            int                     SizeX                   = 0;        // full size (MIP 0)
+            int                     SizeY                   = 0;
+            int                     MipLevels               = 0;
+        };
+
+        // Change of the resident MIP: ToMip < FromMip is a load, ToMip > FromMip an eviction. Once issued the texture is considered
+        // in-flight until the caller reports back with OnActionFinished.
+        struct Action
+        {
+            int                     Handle;
+            int                     FromMip;
+            int                     ToMip;
+        };
+
+        struct Stats
+        {
+            int64                   ResidentBytes           = 0;        // sum of all currently resident MIP chains
+            int64                   InFlightBytes           = 0;        // MIP chains being created by in-flight actions (they co-exist with the resident ones until finished)
+            int64                   WantedBytes             = 0;        // what would be resident with an unlimited budget
+            int64                   TargetBytes             = 0;        // what will be resident once everything settles (only over budget if minimum MIPs alone don't fit)
+            int                     TrackedCount            = 0;
+            int                     RequestedCount          = 0;        // textures requested this frame
+            int                     MissingMIPCount         = 0;        // sum over requested textures of MIP levels wanted but not yet resident
+        };
+
+    private:
+        struct Entry
+        {
+            bool                    Alive                   = false;
+            TextureDesc             Desc;
+            vector<int64>           ChainBytes;                         // [i] is the size of MIPs i ... MipLevels-1, in bytes
+            int                     MaxDroppedMip           = 0;        // least detailed level allowed to be resident, based on Settings::MinResidentDimension
+            int                     ResidentMip             = 0;
+            int                     PendingMip              = -1;       // ResidentMip after the in-flight action finishes, -1 if there is none
+            int                     WantedMip               = 0;
+            int                     TargetMip               = 0;
+            float                   Priority                = 0.0f;
+            int64                   LastRequestedFrame      = -1;
+        };
+
+        Settings                    m_settings;
+        int                         m_lastMinResidentDimension  = -1;
+
+        vector<Entry>               m_entries;
+        vector<int>                 m_freeHandles;
+        int64                       m_frameIndex            = 0;
+
+        Stats                       m_stats;
+
+    public:
+        vaTextureStreamingModel( )  { }
+
+    public:
+        Settings &                  Settings( )                                         { return m_settings; }
+
+        // returns handle; residentMip gets clamped to what's allowed
+        int                         Register( const TextureDesc & desc, int residentMip );
+        void                        Unregister( int handle );
+        bool                        IsRegistered( int handle ) const                    { return handle >= 0 && handle < (int)m_entries.size( ) && m_entries[handle].Alive; }
+
+        void                        BeginFrame( )                                       { m_frameIndex++; }
+
+        // texelsPerPixel: how many MIP 0 texels one screen pixel covers (smallest over all uses this frame); priority: relative importance, for ex. screen coverage
+        void                        Request( int handle, float texelsPerPixel, float priority );
+        void                        RequestMip( int handle, int mip, float priority );
+
+        // fits targets into the budget, updates stats and outputs actions to start (those are marked in-flight)
+        void                        Update( vector<Action> & outActions );
+        void                        OnActionFinished( int handle, bool success );
+
+        const TextureDesc &         GetDesc( int handle ) const                         { assert( IsRegistered( handle ) ); return m_entries[handle].Desc; }
+        int                         GetResidentMip( int handle ) const                  { assert( IsRegistered( handle ) ); return m_entries[handle].ResidentMip; }
+        int                         GetWantedMip( int handle ) const                    { assert( IsRegistered( handle ) ); return m_entries[handle].WantedMip; }
+        int                         GetTargetMip( int handle ) const                    { assert( IsRegistered( handle ) ); return m_entries[handle].TargetMip; }
+        bool                        IsInFlight( int handle ) const                      { assert( IsRegistered( handle ) ); return m_entries[handle].PendingMip != -1; }
+        int64                       GetResidentBytes( int handle ) const                { assert( IsRegistered( handle ) ); return m_entries[handle].ChainBytes[m_entries[handle].ResidentMip]; }
+        int                         GetHandleCount( ) const                             { return (int)m_entries.size( ); }
+
+        const Stats &               GetStats( ) const                                   { return m_stats; }
+
+        static int64                CalcMIPChainBytes( const TextureDesc & desc, int fromMip );
+        // most detailed MIP trilinear filtering samples from for the given footprint
+        static int                  CalcMIPLevel( float texelsPerPixel, float mipBias );
+
+    private:
+        void                        UpdateMaxDroppedMip( Entry & entry ) const;
+        float                       GetEffectivePriority( const Entry & entry ) const;
+    };
+
+    // Keeps only the MIPs of .apack-loaded textures that the current view needs. Screen size and UV density of meshes selected for
+    // rendering give a wanted MIP for every texture their materials use; vaTextureStreamingModel fits that into the budget and missing
+    // (or surplus) MIPs are handled by re-reading the texture data from the .apack on a background thread and swapping the asset's
+    // texture for one created with the new number of MIPs (vaAssetTexture::ReplaceTexture keeps the UID so materials pick it up).
+    // Only uncompressed (no whole-file compression) .apack-s can be streamed from.
+    class vaTextureStreamingManager : public vaRenderingModule, public vaUIPanel
+    {
+    public:
+        struct Settings
+        {
+            bool                    Enabled                 = false;
+            int                     BudgetMB                = 512;
+            int                     MinResidentDimension    = 128;
+            float                   MIPBias                 = 0.0f;
+            int                     MaxActionsPerFrame      = 4;
+        };
+
+        struct ReplayReport
+        {
+            int                     FrameCount              = 0;
+            int64                   PeakResidentBytes       = 0;
+            int64                   PeakInFlightBytes       = 0;
+            int                     FramesOverBudget        = 0;        // frames where resident + in-flight exceeded the budget
+            int                     Loads                   = 0;
+            int                     Evictions               = 0;
+            float                   AvgMissingMIPs          = 0.0f;     // per frame, summed over requested textures
+        };
+
+    protected:
+        struct StreamedTexture
+        {
+            bool                        Valid               = false;
+            vaGUID                      UID;                            // stays the same when textures get swapped
+            vaTextureContentsType       ContentsType        = vaTextureContentsType::GenericColor;
+            vaResourceBindSupportFlags  BindFlags           = vaResourceBindSupportFlags::ShaderResource;
+        };
+
+        // area-weighted UV units per (mesh local space) unit, for both UV channels
+        struct MeshUVDensity
+        {
+            weak_ptr<vaRenderMesh>      Mesh;
+            float                       UVPerUnit[2]        = { 0.0f, 0.0f };
+        };
+
+        // .apack path and data location are looked up from the current texture when the read starts (and re-checked when it finishes)
+        // as saving or reloading the asset pack moves the data and replaces the texture
+        struct PendingRead
+        {
+            int                         Handle;
+            int                         FromMip;
+            int                         ToMip;
+            int64                       DataOffset;
+            int64                       DataSize;
+            shared_ptr<vector<uint8>>    Data;
+            shared_ptr<vaBackgroundTaskManager::Task>
+                                        Task;
+        };
+
+        Settings                        m_settings;
+        vaTextureStreamingModel         m_model;
+
+        vector<StreamedTexture>         m_textures;                     // indexed by m_model handle
+        map<vaGUID, int, vaGUIDComparer>
+                                        m_textureHandles;               // -1 for textures that were checked and can't be streamed
+        unordered_map<const vaRenderMesh *, MeshUVDensity>
+                                        m_meshUVDensities;
+
+        vector<PendingRead>             m_pendingReads;
+
+        bool                            m_replayRequested           = false;
+        ReplayReport                    m_lastReplayReport;
+
+    public:
+        vaTextureStreamingManager( const vaRenderingModuleParams & params );
+        virtual ~vaTextureStreamingManager( );
+
+    public:
+        Settings &                      Settings( )                                                 { return m_settings; }
+        const vaTextureStreamingModel & GetModel( ) const                                           { return m_model; }
+
+        // call once per frame (main thread) with what's selected for rendering from the main camera
+        void                            Tick( const vaCameraBase & camera, const vaRenderMeshDrawList & opaque, const vaRenderMeshDrawList * transparent = nullptr );
+
+        // Runs the streaming model over a recorded camera path against the (unculled) scene draw list, with no IO or GPU work:
+        // actions complete 'actionLatencyFrames' after they're issued. cameraPath sets up the camera for the given frame and
+        // returns false when the path ends. Useful for validating budget & priority settings.
+        ReplayReport                    ReplayCameraPath( const vaRenderMeshDrawList & sceneMeshes, const vaCameraBase & referenceCamera, const std::function<bool( int frameIndex, vaCameraBase & camera )> & cameraPath, bool coldStart = true, int actionLatencyFrames = 2 );
+
+        bool                            IsReplayRequested( ) const                                  { return m_replayRequested; }
+        void                            SetReplayReport( const ReplayReport & report )              { m_replayRequested = false; m_lastReplayReport = report; }
+
+    protected:
+        void                            ApplySettings( vaTextureStreamingModel & model ) const;
+        void                            RegisterTextures( const vaRenderMeshDrawList & drawList );
+        void                            GatherRequests( vaTextureStreamingModel & model, const vaRenderMeshDrawList & drawList, const vaCameraBase & camera );
+        const MeshUVDensity &           GetMeshUVDensity( const shared_ptr<vaRenderMesh> & mesh );
+
+        void                            StartAction( const vaTextureStreamingModel::Action & action );
+        void                            FinishPendingReads( bool waitForAll );
+        bool                            ApplyRead( const PendingRead & read, bool & outStale );
+        // stop tracking; if allowReRegister it gets picked up again (with its current state) next time it's used, otherwise it's marked as not streamable
+        void                            ForgetTexture( int handle, bool allowReRegister );
+        // the asset's current texture, if it's still the one the model thinks it is (same data location and MIPs resident)
+        shared_ptr<vaTexture>           FindCurrentTexture( int handle, int residentMip ) const;
+        void                            Reset( );
+
+    private:
+        virtual void                    UIPanelTick( vaApplicationBase & application ) override;
+    };
+
+}
@@ -0,0 +1,512 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019, Intel Corporation
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+// the Software.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaTriangleMesh.h"
+
+#include "vaStandardShapes.h"
+
+#include "Core/Misc/vaSelfTest.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Vanilla;
+
+namespace
+{
+    // symmetric 4x4 matrix (upper triangle only) - sum of squared distances to a set of planes
+    struct Quadric
+    {
+        double                          A2 = 0, AB = 0, AC = 0, AD = 0, B2 = 0, BC = 0, BD = 0, C2 = 0, CD = 0, D2 = 0;
+
+        void AddPlane( double a, double b, double c, double d )
+        {
+            A2 += a * a; AB += a * b; AC += a * c; AD += a * d;
+            B2 += b * b; BC += b * c; BD += b * d;
+            C2 += c * c; CD += c * d;
+            D2 += d * d;
+        }
+
+        void Add( const Quadric & other )
+        {
+            A2 += other.A2; AB += other.AB; AC += other.AC; AD += other.AD;
+            B2 += other.B2; BC += other.BC; BD += other.BD;
+            C2 += other.C2; CD += other.CD;
+            D2 += other.D2;
+        }
+
+        double Evaluate( const vaVector3 & p ) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            double r = A2 * x * x + B2 * y * y + C2 * z * z + D2
+                + 2.0 * ( AB * x * y + AC * x * z + AD * x + BC * y * z + BD * y + CD * z );
+            return ( r > 0.0 ) ? ( r ) : ( 0.0 );     // can go slightly negative due to precision
+        }
+    };
+
+    struct Collapse
+    {
+        uint32                          From;
+        uint32                          To;
+        double                          Cost;
+    };
+
+    inline uint64 EdgeKey( uint32 a, uint32 b )        { return ( (uint64)a << 32 ) | (uint64)b; }
+}
+
+float vaTriangleMeshTools::Simplify( std::vector<uint32> & outIndices, const std::vector<uint32> & indices, const vaVector3 * positions, size_t positionStride, int vertexCount, int targetTriangleCount, float maxError )
+{
+    assert( &outIndices != &indices );
+    assert( ( indices.size( ) % 3 ) == 0 );
+    outIndices = indices;
+
+    if( vertexCount <= 0 || indices.size( ) == 0 || (int)( indices.size( ) / 3 ) <= targetTriangleCount )
+        return 0.0f;
+
+    // work in a normalized space (bounding box diagonal of 1) so that costs and maxError don't depend on the mesh scale
+    vector<vaVector3> pos( vertexCount );
+    vaVector3 bmin( VA_FLOAT_HIGHEST, VA_FLOAT_HIGHEST, VA_FLOAT_HIGHEST ), bmax( VA_FLOAT_LOWEST, VA_FLOAT_LOWEST, VA_FLOAT_LOWEST );
+    for( int i = 0; i < vertexCount; i++ )
+    {
+        pos[i] = *reinterpret_cast<const vaVector3 *>( reinterpret_cast<const uint8 *>( positions ) + positionStride * i );
+        bmin = vaVector3::ComponentMin( bmin, pos[i] );
+        bmax = vaVector3::ComponentMax( bmax, pos[i] );
+    }
+    const float diagonal = ( bmax - bmin ).Length( );
+    if( !( diagonal > 0.0f ) )
+        return 0.0f;
+    for( int i = 0; i < vertexCount; i++ )
+        pos[i] = ( pos[i] - bmin ) / diagonal;
+
+    // Vertices on edges without exactly one opposite half-edge (borders, attribute seams, non-manifold) are locked
+    vector<uint64> halfEdges;
+    halfEdges.reserve( indices.size( ) );
+    for( size_t t = 0; t < indices.size( ); t += 3 )
+        for( int e = 0; e < 3; e++ )
+            halfEdges.push_back( EdgeKey( indices[t + e], indices[t + ( e + 1 ) % 3] ) );
+    std::sort( halfEdges.begin( ), halfEdges.end( ) );
+
+    auto halfEdgeCount = [ &halfEdges ]( uint64 key ) { auto range = std::equal_range( halfEdges.begin( ), halfEdges.end( ), key ); return (int)( range.second - range.first ); };
+
+    vector<uint8> locked( vertexCount, 0 );
+    for( size_t t = 0; t < indices.size( ); t += 3 )
+        for( int e = 0; e < 3; e++ )
+        {
+            const uint32 a = indices[t + e], b = indices[t + ( e + 1 ) % 3];
+            if( halfEdgeCount( EdgeKey( a, b ) ) != 1 || halfEdgeCount( EdgeKey( b, a ) ) != 1 )
+                locked[a] = locked[b] = 1;
+        }
+
+    // plane quadrics of all triangles around each vertex
+    vector<Quadric> quadrics( vertexCount );
+    for( size_t t = 0; t < indices.size( ); t += 3 )
+    {
+        const vaVector3 & p0 = pos[indices[t + 0]];
+        const vaVector3 & p1 = pos[indices[t + 1]];
+        const vaVector3 & p2 = pos[indices[t + 2]];
+        vaVector3 normal = vaVector3::Cross( p1 - p0, p2 - p0 );
+        const float length = normal.Length( );
+        if( !( length > 0.0f ) )
+            continue;
+        normal /= length;
+        const double d = -(double)vaVector3::Dot( normal, p0 );
+        for( int k = 0; k < 3; k++ )
+            quadrics[indices[t + k]].AddPlane( normal.x, normal.y, normal.z, d );
+    }
+
+    const double maxCost = (double)maxError * (double)maxError;
+    double largestCost = 0.0;
+
+    vector<uint32>      remap( vertexCount );
+    vector<uint8>       touched( vertexCount );
+    vector<int>         adjacencyOffsets( vertexCount + 1 );
+    vector<int>         adjacency;
+    vector<Collapse>    collapses;
+
+    for( ;; )
+    {
+        const int triangleCount = (int)( outIndices.size( ) / 3 );
+        if( triangleCount <= targetTriangleCount )
+            break;
+
+        // vertex -> triangle adjacency
+        std::fill( adjacencyOffsets.begin( ), adjacencyOffsets.end( ), 0 );
+        for( uint32 index : outIndices )
+            adjacencyOffsets[index + 1]++;
+        for( int i = 0; i < vertexCount; i++ )
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        adjacency.resize( outIndices.size( ) );
+        {
+            vector<int> fill( adjacencyOffsets.begin( ), adjacencyOffsets.end( ) - 1 );
+            for( int t = 0; t < triangleCount; t++ )
+                for( int k = 0; k < 3; k++ )
+                    adjacency[fill[outIndices[t * 3 + k]]++] = t;
+        }
+
+        // candidates: every interior edge once (a < b), in both directions unless the source is locked
+        collapses.clear( );
+        for( int t = 0; t < triangleCount; t++ )
+            for( int e = 0; e < 3; e++ )
+            {
+                const uint32 a = outIndices[t * 3 + e], b = outIndices[t * 3 + ( e + 1 ) % 3];
+                if( a >= b )
+                    continue;
+                if( !locked[a] )
+                {
+                    Quadric q = quadrics[a]; q.Add( quadrics[b] );
+                    collapses.push_back( { a, b, q.Evaluate( pos[b] ) } );
+                }
+                if( !locked[b] )
+                {
+                    Quadric q = quadrics[b]; q.Add( quadrics[a] );
+                    collapses.push_back( { b, a, q.Evaluate( pos[a] ) } );
+                }
+            }
+        if( collapses.size( ) == 0 )
+            break;
+
+        std::sort( collapses.begin( ), collapses.end( ), [ ]( const Collapse & l, const Collapse & r )
+        {
+            if( l.Cost != r.Cost ) return l.Cost < r.Cost;
+            if( l.From != r.From ) return l.From < r.From;
+            return l.To < r.To;
+        } );
+
+        // Greedily apply the cheapest ones; everything around a collapsed vertex is off limits until the next pass so
+        // the adjacency and the flip checks stay valid.
+        for( int i = 0; i < vertexCount; i++ )
+            remap[i] = (uint32)i;
+        std::fill( touched.begin( ), touched.end( ), (uint8)0 );
+        int removedTriangles = 0;
+        int appliedCollapses = 0;
+        for( const Collapse & collapse : collapses )
+        {
+            if( collapse.Cost > maxCost || triangleCount - removedTriangles <= targetTriangleCount )
+                break;
+            if( touched[collapse.From] || touched[collapse.To] )
+                continue;
+
+            // reject if any triangle that survives the collapse would flip or become a sliver
+            bool valid = true;
+            int degenerate = 0;
+            for( int k = adjacencyOffsets[collapse.From]; k < adjacencyOffsets[collapse.From + 1] && valid; k++ )
+            {
+                const uint32 * tri = &outIndices[adjacency[k] * 3];
+                if( tri[0] == collapse.To || tri[1] == collapse.To || tri[2] == collapse.To )
+                {
+                    degenerate++;
+                    continue;
+                }
+                vaVector3 p[3], q[3];
+                for( int v = 0; v < 3; v++ )
+                {
+                    p[v] = pos[tri[v]];
+                    q[v] = ( tri[v] == collapse.From ) ? ( pos[collapse.To] ) : ( p[v] );
+                }
+                const vaVector3 before  = vaVector3::Cross( p[1] - p[0], p[2] - p[0] );
+                const vaVector3 after   = vaVector3::Cross( q[1] - q[0], q[2] - q[0] );
+                valid = vaVector3::Dot( before, after ) > 0.25f * before.Length( ) * after.Length( );
+            }
+            if( !valid )
+                continue;
+
+            remap[collapse.From] = collapse.To;
+            quadrics[collapse.To].Add( quadrics[collapse.From] );
+            for( int k = adjacencyOffsets[collapse.From]; k < adjacencyOffsets[collapse.From + 1]; k++ )
+                for( int v = 0; v < 3; v++ )
+                    touched[outIndices[adjacency[k] * 3 + v]] = 1;
+
+            largestCost = std::max( largestCost, collapse.Cost );
+            removedTriangles += degenerate;
+            appliedCollapses++;
+        }
+        if( appliedCollapses == 0 )
+            break;
+
+        // remap and drop the triangles that collapsed
+        size_t writeIndex = 0;
+        for( size_t t = 0; t < outIndices.size( ); t += 3 )
+        {
+            const uint32 a = remap[outIndices[t + 0]], b = remap[outIndices[t + 1]], c = remap[outIndices[t + 2]];
+            if( a == b || b == c || a == c )
+                continue;
+            outIndices[writeIndex++] = a;
+            outIndices[writeIndex++] = b;
+            outIndices[writeIndex++] = c;
+        }
+        outIndices.resize( writeIndex );
+    }
+
+    return (float)std::sqrt( largestCost ) * diagonal;
+}
+
+void vaTriangleMeshTools::GenerateLODChain( std::vector<uint32> & inOutIndices, int indexStart, int indexCount, std::vector<LODRange> & outLODs, const vaVector3 * positions, size_t positionStride, int vertexCount, const LODChainSettings & settings )
+{
+    assert( indexStart >= 0 && indexStart + indexCount <= (int)inOutIndices.size( ) );
+
+    std::vector<uint32> current( inOutIndices.begin( ) + indexStart, inOutIndices.begin( ) + indexStart + indexCount );
+    std::vector<uint32> next;
+    float accumulatedError = 0.0f;
+
+    for( int level = 1; level < settings.MaxLevels; level++ )
+    {
+        const int currentTriangleCount = (int)( current.size( ) / 3 );
+        if( currentTriangleCount <= settings.MinTriangleCount )
+            break;
+
+        const int targetTriangleCount = std::max( settings.MinTriangleCount, (int)( currentTriangleCount * settings.TriangleRatio ) );
+        float error = Simplify( next, current, positions, positionStride, vertexCount, targetTriangleCount, settings.MaxError );
+
+        // not worth another level (everything left is locked or over the error budget)
+        if( next.size( ) * 10 > current.size( ) * 9 )
+            break;
+
+        // each level is simplified from the previous one so errors add up
+        accumulatedError += error;
+        OptimizeVertexCache( next, 0, next.size( ), vertexCount );     // only reorders if that lowers ACMR
+        outLODs.push_back( { (int)inOutIndices.size( ), (int)next.size( ), accumulatedError } );
+        inOutIndices.insert( inOutIndices.end( ), next.begin( ), next.end( ) );
+        std::swap( current, next );
+    }
+}
+
+bool vaTriangleMeshTools::SelfTestLODChain( std::string * outInfo )
+{
+    struct TestShape
+    {
+        const char *                    Name;
+        std::vector<vaVector3>          Vertices;
+        std::vector<uint32>             Indices;
+    };
+    TestShape shapes[2] = { { "sphere" }, { "teapot" } };
+    vaStandardShapes::CreateSphere( shapes[0].Vertices, shapes[0].Indices, 4, true );
+    vaStandardShapes::CreateTeapot( shapes[1].Vertices, shapes[1].Indices );
+
+    const LODChainSettings settings;
+    for( const TestShape & shape : shapes )
+    {
+        const int vertexCount = (int)shape.Vertices.size( );
+        const int indexCount  = (int)shape.Indices.size( );
+
+        std::vector<uint32>     indices[2];
+        std::vector<LODRange>   lods[2];
+        for( int run = 0; run < 2; run++ )
+        {
+            indices[run] = shape.Indices;
+            GenerateLODChain( indices[run], 0, indexCount, lods[run], shape.Vertices.data( ), sizeof( vaVector3 ), vertexCount, settings );
+        }
+
+        if( lods[0].size( ) == 0 )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: no LODs generated", shape.Name ) );
+        if( indices[0] != indices[1] )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: index buffers differ between runs", shape.Name ) );
+        if( lods[0].size( ) != lods[1].size( ) )
+            return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: LOD counts differ between runs (%d vs %d)", shape.Name, (int)lods[0].size( ), (int)lods[1].size( ) ) );
+
+        int previousIndexCount  = indexCount;
+        float previousError     = 0.0f;
+        for( size_t i = 0; i < lods[0].size( ); i++ )
+        {
+            const LODRange & a = lods[0][i], & b = lods[1][i];
+            if( a.IndexStart != b.IndexStart || a.IndexCount != b.IndexCount || std::memcmp( &a.Error, &b.Error, sizeof( float ) ) != 0 )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: LOD %d range or error differs between runs (error %.9g vs %.9g)", shape.Name, (int)i + 1, a.Error, b.Error ) );
+            if( a.IndexCount <= 0 || ( a.IndexCount % 3 ) != 0 || a.IndexCount >= previousIndexCount )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: LOD %d has %d indices, previous level %d", shape.Name, (int)i + 1, a.IndexCount, previousIndexCount ) );
+            if( !( a.Error >= previousError ) )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: LOD %d error %g smaller than the previous level's %g", shape.Name, (int)i + 1, a.Error, previousError ) );
+            if( a.IndexStart < indexCount || a.IndexStart + a.IndexCount > (int)indices[0].size( ) )
+                return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: LOD %d range [%d, %d) outside of the appended indices", shape.Name, (int)i + 1, a.IndexStart, a.IndexStart + a.IndexCount ) );
+            for( int t = a.IndexStart; t < a.IndexStart + a.IndexCount; t += 3 )
+            {
+                const uint32 i0 = indices[0][t + 0], i1 = indices[0][t + 1], i2 = indices[0][t + 2];
+                if( (int)i0 >= vertexCount || (int)i1 >= vertexCount || (int)i2 >= vertexCount )
+                    return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: LOD %d index out of range", shape.Name, (int)i + 1 ) );
+                if( i0 == i1 || i1 == i2 || i0 == i2 )
+                    return vaSelfTest::Fail( outInfo, vaStringTools::Format( "%s: LOD %d has a degenerate triangle", shape.Name, (int)i + 1 ) );
+            }
+            previousIndexCount  = a.IndexCount;
+            previousError       = a.Error;
+        }
+    }
+    return vaSelfTest::Pass( outInfo );
+}
+
+namespace
+{
+    // Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" scoring (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+    static const int                    c_vcoCacheSize              = 32;
+    static const float                  c_vcoCacheDecayPower        = 1.5f;
+    static const float                  c_vcoLastTriangleScore      = 0.75f;
+    static const float                  c_vcoValenceBoostScale      = 2.0f;
+    static const float                  c_vcoValenceBoostPower      = 0.5f;
+
+    static float VertexCacheScore( int cachePosition, int remainingTriangles )
+    {
+        if( remainingTriangles == 0 )
+            return -1.0f;
+
+        float score = 0.0f;
+        if( cachePosition >= 0 )
+        {
+            if( cachePosition < 3 )
+                score = c_vcoLastTriangleScore;     // used by the last triangle: fixed score so it doesn't matter which of the 3 it was
+            else
+                score = std::pow( 1.0f - ( cachePosition - 3 ) / (float)( c_vcoCacheSize - 3 ), c_vcoCacheDecayPower );
+        }
+        // boost vertices with few triangles left so they get finished off instead of lingering
+        return score + c_vcoValenceBoostScale * std::pow( (float)remainingTriangles, -c_vcoValenceBoostPower );
+    }
+}
+
+bool vaTriangleMeshTools::OptimizeVertexCache( std::vector<uint32> & inOutIndices, size_t indexStart, size_t indexCount, int vertexCount )
+{
+    assert( indexStart + indexCount <= inOutIndices.size( ) && ( indexCount % 3 ) == 0 );
+    const int triangleCount = (int)( indexCount / 3 );
+    if( triangleCount < 2 )
+        return false;
+    const uint32 * indices = inOutIndices.data( ) + indexStart;
+
+    // vertex -> triangles adjacency; the active (not yet emitted) triangles of each vertex are kept at the front of its range
+    std::vector<int> remaining( vertexCount, 0 );
+    for( size_t i = 0; i < indexCount; i++ )
+    {
+        assert( indices[i] < (uint32)vertexCount );
+        remaining[indices[i]]++;
+    }
+    std::vector<int> adjacencyStart( vertexCount + 1, 0 );
+    for( int v = 0; v < vertexCount; v++ )
+        adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+    std::vector<int> adjacency( indexCount );
+    {
+        std::vector<int> cursor( adjacencyStart.begin( ), adjacencyStart.end( ) - 1 );
+        for( size_t i = 0; i < indexCount; i++ )
+            adjacency[cursor[indices[i]]++] = (int)( i / 3 );
+    }
+
+    std::vector<int>    cachePosition( vertexCount, -1 );
+    std::vector<float>  vertexScore( vertexCount );
+    for( int v = 0; v < vertexCount; v++ )
+        vertexScore[v] = VertexCacheScore( -1, remaining[v] );
+
+    std::vector<float>  triangleScore( triangleCount );
+    std::vector<uint8>  triangleEmitted( triangleCount, 0 );
+    int bestTriangle = 0;
+    for( int t = 0; t < triangleCount; t++ )
+    {
+        triangleScore[t] = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if( triangleScore[t] > triangleScore[bestTriangle] )
+            bestTriangle = t;
+    }
+
+    std::vector<uint32> output;
+    output.reserve( indexCount );
+    int cache[c_vcoCacheSize + 3];
+    int cacheCount = 0;
+    int scanCursor = 0;
+
+    for( int emitted = 0; emitted < triangleCount; emitted++ )
+    {
+        // nothing in the cache has triangles left - continue with the next triangle not yet emitted (in original order)
+        if( bestTriangle == -1 )
+        {
+            while( triangleEmitted[scanCursor] )
+                scanCursor++;
+            bestTriangle = scanCursor;
+        }
+        triangleEmitted[bestTriangle] = 1;
+
+        // emit, and move the triangle's vertices to the front of the cache
+        int newCache[c_vcoCacheSize + 3];
+        int newCacheCount = 0;
+        for( int k = 0; k < 3; k++ )
+        {
+            const int v = indices[bestTriangle * 3 + k];
+            output.push_back( v );
+
+            int * first = &adjacency[adjacencyStart[v]];
+            int * last  = first + remaining[v] - 1;
+            int * found = std::find( first, last + 1, bestTriangle );
+            assert( found <= last );
+            std::swap( *found, *last );
+            remaining[v]--;
+
+            if( std::find( newCache, newCache + newCacheCount, v ) == newCache + newCacheCount )
+                newCache[newCacheCount++] = v;
+        }
+        const int triangleVertexCount = newCacheCount;
+        for( int i = 0; i < cacheCount; i++ )
+            if( std::find( newCache, newCache + triangleVertexCount, cache[i] ) == newCache + triangleVertexCount )
+                newCache[newCacheCount++] = cache[i];
+
+        // rescore everything that was or is in the cache (the ones that fell out too), and the triangles they're used by
+        for( int i = 0; i < newCacheCount; i++ )
+        {
+            const int v = newCache[i];
+            cachePosition[v] = ( i < c_vcoCacheSize ) ? ( i ) : ( -1 );
+            vertexScore[v] = VertexCacheScore( cachePosition[v], remaining[v] );
+        }
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for( int i = 0; i < newCacheCount; i++ )
+        {
+            const int v = newCache[i];
+            for( int a = adjacencyStart[v]; a < adjacencyStart[v] + remaining[v]; a++ )
+            {
+                const int t = adjacency[a];
+                triangleScore[t] = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if( triangleScore[t] > bestScore )
+                {
+                    bestScore       = triangleScore[t];
+                    bestTriangle    = t;
+                }
+            }
+        }
+
+        cacheCount = std::min( newCacheCount, c_vcoCacheSize );
+        std::copy( newCache, newCache + cacheCount, cache );
+    }
+
+    // Forsyth's LRU scoring doesn't always beat an already cache friendly source order (the teapot, for ex.) on a FIFO
+    // cache - only keep the new order if it's actually better
+    if( !( ComputeACMR( output, 0, output.size( ) ) < ComputeACMR( inOutIndices, indexStart, indexCount ) ) )
+        return false;
+
+    std::copy( output.begin( ), output.end( ), inOutIndices.begin( ) + indexStart );
+    return true;
+}
+
+float vaTriangleMeshTools::ComputeACMR( const std::vector<uint32> & indices, size_t indexStart, size_t indexCount, int cacheSize )
+{
+    if( indexCount < 3 )
+        return 0.0f;
+
+    // simple FIFO post-transform cache model
+    std::vector<uint32> fifo( cacheSize, 0xFFFFFFFF );
+    int fifoHead = 0;
+    int misses = 0;
+    for( size_t i = indexStart; i < indexStart + indexCount; i++ )
+    {
+        if( std::find( fifo.begin( ), fifo.end( ), indices[i] ) != fifo.end( ) )
+            continue;
+        fifo[fifoHead] = indices[i];
+        fifoHead = ( fifoHead + 1 ) % cacheSize;
+        misses++;
+    }
+    return misses / (float)( indexCount / 3 );
+}
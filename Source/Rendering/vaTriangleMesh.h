@@ -363,6 +363,47 @@ namespace Vanilla
                 outIndices.push_back( inIndices[i] + startingVertex );
         }
 
+        // Quadric error metric edge collapse simplification (Garland & Heckbert, "Surface Simplification Using Quadric Error
+        // Metrics", 1997), half-edge variant: vertices only ever collapse onto other existing vertices so the output indexes
+        // the same vertex buffer as the input. Vertices on open edges - mesh borders and attribute seams (vertices that share
+        // a position but not normals / UVs don't share edges either) - never move. Stops at targetTriangleCount or when the
+        // next collapse would exceed maxError (relative to the bounding box diagonal), whichever comes first. Results only
+        // depend on the inputs (no hashing of pointers, stable tie-breaking) so they're the same on every run.
+        // Returns the largest error introduced, in the same units as positions. outIndices must not alias indices.
+        static float Simplify( std::vector<uint32> & outIndices, const std::vector<uint32> & indices, const vaVector3 * positions, size_t positionStride, int vertexCount, int targetTriangleCount, float maxError );
+
+        struct LODChainSettings
+        {
+            int                                 MaxLevels           = 4;        // including LOD 0
+            float                               TriangleRatio       = 0.5f;     // target triangle count of each level relative to the previous one
+            float                               MaxError            = 0.02f;    // per level, relative to the bounding box diagonal
+            int                                 MinTriangleCount    = 32;       // don't simplify below this
+        };
+
+        struct LODRange
+        {
+            int                                 IndexStart;
+            int                                 IndexCount;
+            float                               Error;                          // upper bound of the geometric error vs LOD 0, in the same units as positions
+        };
+
+        // Builds a chain of LODs from [indexStart, indexStart+indexCount) by repeated Simplify calls, appends their indices
+        // to inOutIndices and their ranges (LOD 1 and onward) to outLODs. Stops early when simplification stalls.
+        static void GenerateLODChain( std::vector<uint32> & inOutIndices, int indexStart, int indexCount, std::vector<LODRange> & outLODs, const vaVector3 * positions, size_t positionStride, int vertexCount, const LODChainSettings & settings );
+
+        // Headless regression check of the above: builds LOD chains for a few standard shapes twice and checks that index
+        // buffers and errors match bit for bit, that levels shrink while errors grow and that no LOD triangle is degenerate
+        // or indexes outside the vertex buffer; describes the first failure in outInfo (see vaSelfTest).
+        static bool SelfTestLODChain( std::string * outInfo = nullptr );
+
+        // Reorders triangles in [indexStart, indexStart+indexCount) for post-transform vertex cache reuse (Forsyth's
+        // linear-speed algorithm). Winding and the set of triangles are unchanged; deterministic. The new order is only
+        // applied if its ACMR is lower than the existing one; returns true if it was.
+        static bool OptimizeVertexCache( std::vector<uint32> & inOutIndices, size_t indexStart, size_t indexCount, int vertexCount );
+
+        // Average cache miss ratio (transformed vertices per triangle) for a FIFO cache of cacheSize - 0.5 is ideal, 3 worst.
+        static float ComputeACMR( const std::vector<uint32> & indices, size_t indexStart, size_t indexCount, int cacheSize = 16 );
+
     };
 
     template< class VertexType >
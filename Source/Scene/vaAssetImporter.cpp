@@ -153,6 +153,7 @@ void vaAssetImporter::UIPanelTick( vaApplicationBase & application )
         ImGui::Checkbox( "Assimp: FindInstances", &m_settings.AIFindInstances );
         ImGui::Checkbox( "Assimp: OptimizeMeshes", &m_settings.AIOptimizeMeshes );
         ImGui::Checkbox( "Assimp: OptimizeGraph", &m_settings.AIOptimizeGraph );
+        ImGui::Checkbox( "Meshes: GenerateLODs", &m_settings.GenerateLODs );
         ImGui::Separator( );
         ImGui::Checkbox( "Textures: GenerateMIPs", &m_settings.TextureGenerateMIPs );
         ImGui::Separator( );
@@ -48,6 +48,8 @@ namespace Vanilla
             bool                        AIOptimizeMeshes                    = true;        // aiProcess_OptimizeMeshes
             bool                        AIOptimizeGraph                     = true;        // aiProcess_OptimizeGraph
 
+            bool                        GenerateLODs                        = false;       // see vaTriangleMeshTools::GenerateLODChain
+
             bool                        EnableLogInfo                       = true;
             bool                        EnableLogWarning                    = true;
             bool                        EnableLogError                      = true;
@@ -109,13 +111,14 @@ namespace Vanilla
                 }
                 else
                 {
+                    // importer thread blocks until this is done so it goes ahead of any other queued work
                     if( ! Device.AsyncInvokeAtBeginFrame( [ importerContext=this, asyncCallback ]( vaRenderDevice& renderDevice, float deltaTime ) -> bool
                     {
                         if( importerContext->IsAborted( ) || deltaTime == std::numeric_limits<float>::lowest( ) )
                             return false;
 
                         return asyncCallback( renderDevice, *importerContext );
-                    } ).get( ) )
+                    }, vaAsyncCallbackPriority::High ).get( ) )
                     {
                         Abort( ); return false;
                     }
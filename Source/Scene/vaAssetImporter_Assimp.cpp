@@ -44,6 +44,11 @@ using namespace Vanilla;
 
 namespace 
 { 
+    // overall import progress: Assimp parsing, then materials (with their textures), then mesh conversion and mesh creation
+    static const float c_progressParsingEnd         = 0.667f;
+    static const float c_progressMaterialsEnd       = 0.8f;
+    static const float c_progressMeshConversionEnd  = 0.9f;
+
     class myLogInfoStream : public Assimp::LogStream
     {
         vaAssetImporter::ImporterContext & importerContext;
@@ -97,7 +102,7 @@ namespace
         {
             if( percentage != -1.f )
             {
-                importerContext.SetProgress( 0.667f * percentage );
+                importerContext.SetProgress( c_progressParsingEnd * percentage );
             }
 
             return !importerContext.IsAborted();
@@ -157,54 +162,40 @@ namespace
             { }
         };
 
-        struct LoadedMaterial
-        {
-            const aiMaterial *                  AssimpMaterial;
-            shared_ptr<vaAssetRenderMaterial>   Material;
-
-            LoadedMaterial( const aiMaterial * assimpMaterial, const shared_ptr<vaAssetRenderMaterial> & material )
-                : AssimpMaterial( assimpMaterial ), Material( material ) 
-            { }
-        };
-
-        struct LoadedMesh
-        {
-            const aiMesh *                      AssimpMesh;
-            shared_ptr<vaAssetRenderMesh>       Mesh;
-
-            LoadedMesh( const aiMesh * assimpMesh, const shared_ptr<vaAssetRenderMesh> & mesh )
-                : AssimpMesh( assimpMesh ), Mesh( mesh ) 
-            { }
-        };
-
         wstring                                     ImportDirectory;
         wstring                                     ImportFileName;
         wstring                                     ImportExt;
 
-        vector<LoadedTexture>                       LoadedTextures;
-        vector<LoadedMaterial>                      LoadedMaterials;
-        vector<LoadedMesh>                          LoadedMeshes;
+        // keyed by the (lowercase) original path; the same path can be loaded with different flags / contents type
+        std::unordered_multimap<string, LoadedTexture>                      LoadedTextures;
+        std::unordered_map<const aiMaterial *, shared_ptr<vaAssetRenderMaterial>>  LoadedMaterials;
+        std::unordered_map<const aiMesh *, shared_ptr<vaAssetRenderMesh>>   LoadedMeshes;
 
         shared_ptr<vaAssetRenderMaterial>           FindMaterial( const aiMaterial * assimpMaterial )
         {
-            for( int i = 0; i < LoadedMaterials.size(); i++ )
-            {
-                if( LoadedMaterials[i].AssimpMaterial == assimpMaterial )
-                    return LoadedMaterials[i].Material;
-            }
-            return nullptr;
+            auto it = LoadedMaterials.find( assimpMaterial );
+            return ( it != LoadedMaterials.end( ) ) ? ( it->second ) : ( nullptr );
         }
 
         shared_ptr<vaAssetRenderMesh>               FindMesh( const aiMesh * assimpMesh )
         {
-            for( int i = 0; i < LoadedMeshes.size(); i++ )
-            {
-                if( LoadedMeshes[i].AssimpMesh == assimpMesh )
-                    return LoadedMeshes[i].Mesh;
-            }
-            return nullptr;
+            auto it = LoadedMeshes.find( assimpMesh );
+            return ( it != LoadedMeshes.end( ) ) ? ( it->second ) : ( nullptr );
         }
     };
+
+    // CPU-side mesh data converted from Assimp, ready for vaRenderMesh::Create
+    struct ConvertedMesh
+    {
+        bool                                        Valid       = false;
+        vector<vaVector3>                           Vertices;
+        vector<vaVector3>                           Normals;
+        vector<vaVector2>                           Texcoords0;
+        vector<vaVector2>                           Texcoords1;
+        vector<uint32>                              Indices;            // LOD 0 followed by the LODs, if any
+        int                                         LOD0IndexCount  = 0;
+        vector<vaTriangleMeshTools::LODRange>       LODs;
+    };
 }
 
 #pragma warning ( suppress: 4505 ) // unreferenced local function has been removed
@@ -216,12 +207,13 @@ static shared_ptr<vaAssetTexture> FindOrLoadTexture( aiTexture * assimpTexture,
 
     wstring filePath = vaStringTools::SimpleWiden( originalPath );
 
-    for( int i = 0; i < tempStorage.LoadedTextures.size(); i++ )
+    auto range = tempStorage.LoadedTextures.equal_range( originalPath );
+    for( auto it = range.first; it != range.second; it++ )
     {
-        if( (originalPath == tempStorage.LoadedTextures[i].OriginalPath) && (textureLoadFlags == tempStorage.LoadedTextures[i].TextureLoadFlags) && (textureContentsType == tempStorage.LoadedTextures[i].TextureContentsType) )
+        if( (textureLoadFlags == it->second.TextureLoadFlags) && (textureContentsType == it->second.TextureContentsType) )
         {
-            assert( assimpTexture == tempStorage.LoadedTextures[i].AssimpTexture );
-            return tempStorage.LoadedTextures[i].Texture;
+            assert( assimpTexture == it->second.AssimpTexture );
+            return it->second.Texture;
         }
     }
 
@@ -314,7 +306,7 @@ static shared_ptr<vaAssetTexture> FindOrLoadTexture( aiTexture * assimpTexture,
         assert( vaThreading::IsMainThread( ) ); // remember to lock asset global mutex and switch these to 'false'
         textureAssetOut = importerContext.AssetPack->Add( textureOut, importerContext.AssetPack->FindSuitableAssetName( importerContext.Settings.AssetNamePrefix + vaStringTools::SimpleNarrow( outName ), true ), true );
 
-        tempStorage.LoadedTextures.push_back( LoadingTempStorage::LoadedTexture( assimpTexture, textureAssetOut, originalPath, textureLoadFlags, textureContentsType ) );
+        tempStorage.LoadedTextures.emplace( originalPath, LoadingTempStorage::LoadedTexture( assimpTexture, textureAssetOut, originalPath, textureLoadFlags, textureContentsType ) );
 
         return true;
     } ) )
@@ -883,11 +875,11 @@ static bool ProcessMaterials( const aiScene* loadedScene, LoadingTempStorage & t
                                     if( shouldRemoveOpacityAssetIfMerged )
                                     {
                                         bool foundOK = false;
-                                        for( int i = 0; i < tempStorage.LoadedTextures.size( ); i++ )
+                                        for( auto it = tempStorage.LoadedTextures.begin( ); it != tempStorage.LoadedTextures.end( ); it++ )
                                         {
-                                            if( tempStorage.LoadedTextures[i].Texture.get( ) == opacityTextureAsset )
+                                            if( it->second.Texture.get( ) == opacityTextureAsset )
                                             {
-                                                tempStorage.LoadedTextures.erase( tempStorage.LoadedTextures.begin() + i );
+                                                tempStorage.LoadedTextures.erase( it );
                                                 foundOK = true;
                                                 break;
                                             }
@@ -991,7 +983,7 @@ static bool ProcessMaterials( const aiScene* loadedScene, LoadingTempStorage & t
 
             VA_LOG_SUCCESS( "    material '%s' added", materialName.c_str() );
 
-            tempStorage.LoadedMaterials.push_back( LoadingTempStorage::LoadedMaterial( assimpMaterial, materialAsset ) );
+            tempStorage.LoadedMaterials[assimpMaterial] = materialAsset;
 
             return true;
         } ) )
@@ -1005,179 +997,174 @@ static bool ProcessMaterials( const aiScene* loadedScene, LoadingTempStorage & t
         //     } ) )
         //     { assert( false ); return false; }
 
+        importerContext.SetProgress( vaMath::Lerp( c_progressParsingEnd, c_progressMaterialsEnd, (float)(mi+1) / (float)loadedScene->mNumMaterials ) );
 	}
 
     return true;
 }
 
-static bool ProcessMeshes( const aiScene* loadedScene, LoadingTempStorage & tempStorage, vaAssetImporter::ImporterContext & importerContext )
+// Pure CPU conversion from Assimp to Vanilla mesh data; doesn't touch the device, asset pack or the temp storage so it
+// can run on any thread.
+static void ConvertMesh( const aiMesh * assimpMesh, ConvertedMesh & out, bool generateLODs )
 {
-	for( unsigned int mi = 0; mi < loadedScene->mNumMeshes; mi++ )
-	{
-        aiMesh * assimpMesh = loadedScene->mMeshes[mi];
+    out.Valid = false;
 
-        bool hasTangentBitangents = assimpMesh->HasTangentsAndBitangents();
+    VA_LOG( "Assimp processing mesh '%s'", assimpMesh->mName.data );
 
-        VA_LOG( "Assimp processing mesh '%s'", assimpMesh->mName.data );
+    if( !assimpMesh->HasFaces() )
+    { 
+        assert( false );
+        VA_LOG_ERROR( "Assimp error: mesh '%s' has no faces, skipping.", assimpMesh->mName.data );
+        return;
+    }
 
-        if( !assimpMesh->HasFaces() )
-        { 
-            assert( false );
-            VA_LOG_ERROR( "Assimp error: mesh '%s' has no faces, skipping.", assimpMesh->mName.data );
-            continue;
-        }
+    if( assimpMesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE )
+    { 
+        VA_LOG_WARNING( "Assimp warning: mesh '%s' reports non-triangle primitive types - those will be skipped during import.", assimpMesh->mName.data );
+    }
 
-        if( assimpMesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE )
-        { 
-            VA_LOG_WARNING( "Assimp warning: mesh '%s' reports non-triangle primitive types - those will be skipped during import.", assimpMesh->mName.data );
-        }
+    if( !assimpMesh->HasPositions() )
+    { 
+        assert( false );
+        VA_LOG_ERROR( "Assimp error: mesh '%s' does not have positions, skipping.", assimpMesh->mName.data );
+        return;
+    }
+    if( !assimpMesh->HasNormals() )
+    { 
+        //assert( false );
+        VA_LOG_ERROR( "Assimp error: mesh '%s' does not have normals, skipping.", assimpMesh->mName.data );
+        return;
+    }
 
-        if( !assimpMesh->HasPositions() )
-        { 
-            assert( false );
-            VA_LOG_ERROR( "Assimp error: mesh '%s' does not have positions, skipping.", assimpMesh->mName.data );
-            continue;
-        }
-        if( !assimpMesh->HasNormals() )
-        { 
-            //assert( false );
-            VA_LOG_ERROR( "Assimp error: mesh '%s' does not have normals, skipping.", assimpMesh->mName.data );
-            continue;
-        }
+    if( assimpMesh->HasTangentsAndBitangents() )
+        VA_LOG_WARNING( "Assimp importer warning: mesh '%s' has (co)tangent space in the vertices but these are not supported by VA (generated in the pixel shader)", assimpMesh->mName.data );
 
-        vector<vaVector3>   vertices;
-        vector<uint32>      colors;
-        vector<vaVector3>   normals;
-        //vector<vaVector4>   tangents;  // .w holds handedness
-        vector<vaVector2>   texcoords0;
-        vector<vaVector2>   texcoords1;
+    const int vertexCount = (int)assimpMesh->mNumVertices;
 
-        vertices.resize( assimpMesh->mNumVertices );
-        colors.resize( vertices.size( ) );
-        normals.resize( vertices.size( ) );
-        //tangents.resize( vertices.size( ) );
-        texcoords0.resize( vertices.size( ) );
-        texcoords1.resize( vertices.size( ) );
+    out.Vertices.resize( vertexCount );
+    out.Normals.resize( vertexCount );
+    out.Texcoords0.resize( vertexCount );
+    out.Texcoords1.resize( vertexCount );
 
+    // (vertex colors are not used by vaRenderMesh so they're not converted)
+    for( int i = 0; i < vertexCount; i++ )
+    {
+        out.Vertices[i] = vaVector3( assimpMesh->mVertices[i].x, assimpMesh->mVertices[i].y, assimpMesh->mVertices[i].z );
+        out.Normals[i]  = vaVector3( assimpMesh->mNormals[i].x, assimpMesh->mNormals[i].y, assimpMesh->mNormals[i].z );
+    }
 
-        for( int i = 0; i < (int)vertices.size(); i++ )
-            vertices[i] = vaVector3( assimpMesh->mVertices[i].x, assimpMesh->mVertices[i].y, assimpMesh->mVertices[i].z );
+    vector<vaVector2> * uvsOut[] = { &out.Texcoords0, &out.Texcoords1 };
+    for( int uvi = 0; uvi < 2; uvi++ )
+    {
+        vector<vaVector2> & texcoords = *uvsOut[uvi];
 
-        if( assimpMesh->HasVertexColors( 0 ) )
+        if( assimpMesh->HasTextureCoords( uvi ) )
         {
-            for( int i = 0; i < (int)colors.size(); i++ )
-                colors[i] = vaVector4::ToRGBA( vaVector4( assimpMesh->mColors[0][i].r, assimpMesh->mColors[0][i].g, assimpMesh->mColors[0][i].b, assimpMesh->mColors[0][i].a ) );
+            for( int i = 0; i < vertexCount; i++ )
+                texcoords[i] = vaVector2( assimpMesh->mTextureCoords[uvi][i].x, assimpMesh->mTextureCoords[uvi][i].y );
         }
         else
         {
-            for( int i = 0; i < (int)colors.size(); i++ )
-                colors[i] = vaVector4::ToRGBA( vaVector4( 1.0f, 1.0f, 1.0f, 1.0f ) );
+            for( int i = 0; i < vertexCount; i++ )
+                texcoords[i] = vaVector2( 0.0f, 0.0f );
         }
+    }
 
-        for( int i = 0; i < (int)vertices.size(); i++ )
-            normals[i] = vaVector3( assimpMesh->mNormals[i].x, assimpMesh->mNormals[i].y, assimpMesh->mNormals[i].z );
-
-        if( hasTangentBitangents )
-        {
-            VA_LOG_WARNING( "Assimp importer warning: mesh '%s' has (co)tangent space in the vertices but these are not supported by VA (generated in the pixel shader)", assimpMesh->mName.data );
-            // for( int i = 0; i < (int)tangents.size(); i++ )
-            // {
-            //     vaVector3 tangent   = vaVector3( assimpMesh->mTangents[i].x, assimpMesh->mTangents[i].y, assimpMesh->mTangents[i].z );
-            //     vaVector3 bitangent = vaVector3( assimpMesh->mBitangents[i].x, assimpMesh->mBitangents[i].y, assimpMesh->mBitangents[i].z );
-            //     float handedness = vaVector3::Dot( bitangent, vaVector3::Cross( normals[i], tangent ).Normalized() );
-            //     tangents[i] = vaVector4( tangent, handedness );
-            // }
-        }
-        else
-        {
-            // // VA_LOG_WARNING( "Assimp importer warning: mesh '%s' has no tangent space - ok if no normal maps used", assimpMesh->mName.data );
-            // 
-            // for( size_t i = 0; i < tangents.size( ); i++ )
-            // {
-            //     vaVector3 bitangent = ( vertices[i] + vaVector3( 0.0f, 0.0f, -5.0f ) ).Normalized( );
-            //     if( vaMath::Abs( vaVector3::Dot( bitangent, normals[i] ) ) > 0.9f )
-            //         bitangent = ( vertices[i] + vaVector3( -5.0f, 0.0f, 0.0f ) ).Normalized( );
-            //     tangents[i] = vaVector4( vaVector3::Cross( bitangent, normals[i] ).Normalized( ), 1.0f );
-            // }
-        }
+    out.Indices.reserve( assimpMesh->mNumFaces * 3 );
+    for( int i = 0; i < (int)assimpMesh->mNumFaces; i ++ )
+    {
+        // non-triangles (lines & points, split out by aiProcess_SortByPType) are skipped
+        if( assimpMesh->mFaces[i].mNumIndices != 3 )
+            continue;
+        out.Indices.push_back( assimpMesh->mFaces[i].mIndices[0] );
+        out.Indices.push_back( assimpMesh->mFaces[i].mIndices[1] );
+        out.Indices.push_back( assimpMesh->mFaces[i].mIndices[2] );
+    }
+    out.LOD0IndexCount = (int)out.Indices.size( );
 
-        vector<vaVector2> * uvsOut[] = { &texcoords0, &texcoords1 };
+    if( generateLODs && out.Indices.size( ) > 0 )
+        vaTriangleMeshTools::GenerateLODChain( out.Indices, 0, out.LOD0IndexCount, out.LODs, out.Vertices.data( ), sizeof( vaVector3 ), vertexCount, vaTriangleMeshTools::LODChainSettings( ) );
 
-        for( int uvi = 0; uvi < 2; uvi++ )
-        {
-            vector<vaVector2> & texcoords = *uvsOut[uvi];
+    out.Valid = true;
+}
 
-            if( assimpMesh->HasTextureCoords( uvi ) )
-            {
-                for( int i = 0; i < (int)texcoords0.size(); i++ )
-                    texcoords[i] = vaVector2( assimpMesh->mTextureCoords[uvi][i].x, assimpMesh->mTextureCoords[uvi][i].y );
-            }
-            else
-            {
-                for( int i = 0; i < (int)texcoords0.size(); i++ )
-                    texcoords[i] = vaVector2( 0.0f, 0.0f );
-            }
-        }
+static bool ProcessMeshes( const aiScene* loadedScene, LoadingTempStorage & tempStorage, vaAssetImporter::ImporterContext & importerContext )
+{
+    const int meshCount = (int)loadedScene->mNumMeshes;
+    if( meshCount == 0 )
+        return true;
 
-        bool indicesOk = true;
-        vector<uint32>      indices;
-        indices.reserve( assimpMesh->mNumFaces * 3 );
-        for( int i = 0; i < (int)assimpMesh->mNumFaces; i ++ )
+    // Conversion is independent per mesh, so fan it out across worker threads; meshes are then created & added to the
+    // asset pack in the original order so asset names stay deterministic.
+    vector<ConvertedMesh> convertedMeshes( meshCount );
+    {
+        std::atomic_int convertedCount = 0;
+        vaThreading::ParallelFor( meshCount, 1, [&]( int begin, int end )
         {
-            if( assimpMesh->mFaces[i].mNumIndices != 3 )
+            for( int mi = begin; mi < end; mi++ )
             {
-                continue;
-                //assert( false );
-                //VA_LOG_ERROR( "Assimp error: mesh '%s' face has incorrect number of indices (3), skipping.", assimpMesh->mName.data );
-                //indicesOk = false;
-                //break;
+                if( importerContext.IsAborted( ) )
+                    return;
+                ConvertMesh( loadedScene->mMeshes[mi], convertedMeshes[mi], importerContext.Settings.GenerateLODs );
+                importerContext.SetProgress( vaMath::Lerp( c_progressMaterialsEnd, c_progressMeshConversionEnd, (float)( ++convertedCount ) / (float)meshCount ) );
             }
-            indices.push_back( assimpMesh->mFaces[i].mIndices[0] );
-            indices.push_back( assimpMesh->mFaces[i].mIndices[1] );
-            indices.push_back( assimpMesh->mFaces[i].mIndices[2] );
-        }
-        if( !indicesOk )
-            continue;
+        } );
+    }
+    if( importerContext.IsAborted( ) )
+        return false;
 
-        auto materialAsset = tempStorage.FindMaterial( loadedScene->mMaterials[assimpMesh->mMaterialIndex] );
-        auto material = materialAsset->GetRenderMaterial();
-
-        // vector<vaRenderMesh::SubPart> parts;
-        //parts.resize( 1 );
-        //vaRenderMesh::SubPart & part = parts[0];
-        vaRenderMesh::SubPart part;
-        part.CachedMaterialRef = material;
-        part.MaterialID = material->UIDObject_GetUID();
-        part.IndexStart = 0;
-        part.IndexCount = (int)indices.size();
-        
-        shared_ptr<vaAssetRenderMesh> newAsset;
+    // Each AsyncInvokeAtBeginFrame costs a frame so create as many meshes per frame as fit in the time budget.
+    const double c_meshCreationTimeBudget = 0.010;
+    int mi = 0;
+    while( mi < meshCount )
+    {
         if( !importerContext.AsyncInvokeAtBeginFrame( [ & ]( vaRenderDevice& renderDevice, vaAssetImporter::ImporterContext& importerContext )
         {
-            //shared_ptr<vaRenderMesh> newMesh = vaRenderMesh::Create( importerContext.BaseTransform, vertices, normals, tangents, texcoords0, texcoords1, indices, vaWindingOrder::Clockwise );
-            shared_ptr<vaRenderMesh> newMesh = vaRenderMesh::Create( renderDevice, vaMatrix4x4::Identity, vertices, normals, texcoords0, texcoords1, indices, vaWindingOrder::Clockwise );
-            newMesh->SetPart( part );
-            //newMesh->SetTangentBitangentValid( hasTangentBitangents );
-
-            string newMeshName = assimpMesh->mName.data;
-            if( newMeshName == "" )
-                newMeshName = materialAsset->Name() + "_mesh";  // empty name? just used $materialname$_mesh - but don't add AssetNamePrefix because it was already added to material
-            else
-                newMeshName = importerContext.Settings.AssetNamePrefix + newMeshName;
+            const double startTime = vaCore::TimeFromAppStart( );
+            do 
+            {
+                const aiMesh * assimpMesh = loadedScene->mMeshes[mi];
+                ConvertedMesh & converted = convertedMeshes[mi];
+                mi++;
+                if( !converted.Valid )
+                    continue;
+
+                auto materialAsset = tempStorage.FindMaterial( loadedScene->mMaterials[assimpMesh->mMaterialIndex] );
+                auto material = materialAsset->GetRenderMaterial();
+
+                vaRenderMesh::SubPart part;
+                part.CachedMaterialRef = material;
+                part.MaterialID = material->UIDObject_GetUID();
+                part.IndexStart = 0;
+                part.IndexCount = converted.LOD0IndexCount;
+
+                shared_ptr<vaRenderMesh> newMesh = vaRenderMesh::Create( renderDevice, vaMatrix4x4::Identity, converted.Vertices, converted.Normals, converted.Texcoords0, converted.Texcoords1, converted.Indices, vaWindingOrder::Clockwise );
+                newMesh->SetPart( part );
+                newMesh->SetLODs( converted.LODs );
+
+                string newMeshName = assimpMesh->mName.data;
+                if( newMeshName == "" )
+                    newMeshName = materialAsset->Name() + "_mesh";  // empty name? just used $materialname$_mesh - but don't add AssetNamePrefix because it was already added to material
+                else
+                    newMeshName = importerContext.Settings.AssetNamePrefix + newMeshName;
 
-            newMeshName = importerContext.AssetPack->FindSuitableAssetName( newMeshName, true );
+                assert( vaThreading::IsMainThread() ); // remember to lock asset global mutex and switch these to 'false'
+                newMeshName = importerContext.AssetPack->FindSuitableAssetName( newMeshName, true );
 
-            assert( vaThreading::IsMainThread() ); // remember to lock asset global mutex and switch these to 'false'
+                assert( vaThreading::IsMainThread() ); // remember to lock asset global mutex and switch these to 'false'
+                tempStorage.LoadedMeshes[assimpMesh] = importerContext.AssetPack->Add( newMesh, newMeshName, true );
 
-            assert( vaThreading::IsMainThread() ); // remember to lock asset global mutex and switch these to 'false'
-            newAsset = importerContext.AssetPack->Add( newMesh, newMeshName, true );
+                VA_LOG_SUCCESS( "    mesh '%s' added", newMeshName.c_str() );
+
+                // converted data no longer needed
+                converted = ConvertedMesh( );
 
-            VA_LOG_SUCCESS( "    mesh '%s' added", newMeshName.c_str() );
+                importerContext.SetProgress( vaMath::Lerp( c_progressMeshConversionEnd, 1.0f, (float)mi / (float)meshCount ) );
+
+            } while( mi < meshCount && ( vaCore::TimeFromAppStart( ) - startTime ) < c_meshCreationTimeBudget );
             return true;
         } ) )
             return false;
-
-        tempStorage.LoadedMeshes.push_back( LoadingTempStorage::LoadedMesh( assimpMesh, newAsset ) );
     }
 
     return true;
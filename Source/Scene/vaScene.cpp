@@ -24,6 +24,7 @@
 #include "Rendering/vaDebugCanvas.h"
 
 #include "Core/System/vaFileTools.h"
+#include "Core/System/vaMemoryStream.h"
 
 #include "IntegratedExternals/vaImguiIntegration.h"
 
@@ -53,7 +54,7 @@ vaMatrix4x4 vaSceneObject::GetWorldTransform( ) const
 #ifdef _DEBUG
     shared_ptr<vaScene> scene = GetScene();
     assert( scene != nullptr );
-    assert( m_lastSceneTickIndex == scene->GetTickIndex( ) );   // for whatever reason, you're getting stale data
+    assert( m_lastSceneTickIndex != -1 );   // not yet updated by the scene (added to it after the last Tick?) - you're getting stale data
 #endif
     return m_computedWorldTransform;
 }
@@ -78,38 +79,55 @@ void vaSceneObject::FindClosestRecursive( const vaVector3 & worldLocation, share
     }
 }
 
-void vaSceneObject::TickRecursive( vaScene & scene, float deltaTime )
+void vaSceneObject::SetLocalTransform( const vaMatrix4x4 & newTransform )
 {
-    assert( m_scene.lock() == scene.shared_from_this() );
+    m_localTransform = newTransform;
 
-    assert( !m_destroyedButNotYetRemovedFromScene );
-    assert( !m_createdButNotYetAddedToScene );
+    // objects not yet in the scene's hierarchy get fully updated when it's rebuilt
+    if( m_transformDirty || m_hierarchyIndex == -1 )
+        return;
 
-    // Update transforms (OK to rely on parent's transforms, they've already been updated)
-    if( m_parent == nullptr )
-        m_computedWorldTransform = GetLocalTransform();
-    else
-        m_computedWorldTransform = GetLocalTransform() * m_parent->GetWorldTransform();
+    shared_ptr<vaScene> scene = GetScene( );
+    if( scene == nullptr )
+        return;
+    m_transformDirty = true;
+    scene->m_hierarchy.DirtyTransforms.push_back( m_hierarchyIndex );
+}
 
-    if( (m_computedLocalBoundingBox == vaBoundingBox::Degenerate || m_computedLocalBoundingBoxIncomplete ) && m_renderMeshes.size( ) > 0 )
-    {
-        UpdateLocalBoundingBox();
-    }
+void vaSceneObject::InvalidateLocalBoundingBox( )
+{
+    m_computedLocalBoundingBox = vaBoundingBox::Degenerate;
 
-    // Update tick index (transforms ok, but beware, bounding boxes not yet)
-    m_lastSceneTickIndex = scene.GetTickIndex();
+    if( m_localBoundsQueued || m_hierarchyIndex == -1 )
+        return;
+
+    shared_ptr<vaScene> scene = GetScene( );
+    if( scene == nullptr )
+        return;
+    m_localBoundsQueued = true;
+    scene->m_hierarchy.PendingBounds.push_back( m_hierarchyIndex );
+}
 
-    // Our bounding box, oriented in world space
-    vaOrientedBoundingBox oobb = vaOrientedBoundingBox( m_computedLocalBoundingBox, m_computedWorldTransform );
-    //vaDebugCanvas3D::GetInstance().DrawBox( oobb, 0xFF000000, 0x20FF8080 );
-    m_computedGlobalBoundingBox = oobb.ComputeEnclosingAABB();
-    //vaDebugCanvas3D::GetInstance().DrawBox( m_computedGlobalBoundingBox, 0xFF000000, 0x20FF8080 );
+void vaSceneObject::UpdateShadowCasterState( vaScene & scene, const vaBoundingBox & ownBounds )
+{
+    const bool hasCasters   = m_renderMeshes.size( ) > 0;
+    const bool isStatic     = hasCasters && !IsDynamic( );
 
-    for( int i = 0; i < m_children.size( ); i++ )
+    if( isStatic != m_reportedAsStaticCaster || ( isStatic && !( ownBounds == m_reportedStaticCasterBounds ) ) )
     {
-        m_children[i]->TickRecursive( scene, deltaTime );
-        m_computedGlobalBoundingBox = vaBoundingBox::Combine( m_computedGlobalBoundingBox, m_children[i]->GetGlobalAABB() );
+        vaShadowCasterChange change;
+        change.WasStatic    = m_reportedAsStaticCaster;
+        change.BoundsBefore = m_reportedStaticCasterBounds;
+        change.IsStatic     = isStatic;
+        change.BoundsAfter  = ( isStatic ) ? ( ownBounds ) : ( vaBoundingBox::Degenerate );
+        scene.m_shadowCasterChanges.push_back( change );
+
+        m_reportedAsStaticCaster        = isStatic;
+        m_reportedStaticCasterBounds    = change.BoundsAfter;
     }
+
+    if( hasCasters && !isStatic )
+        scene.m_dynamicShadowCasterBounds.push_back( ownBounds );
 }
 
 shared_ptr<vaRenderMesh> vaSceneObject::GetRenderMesh( int index ) const
@@ -129,7 +147,7 @@ void vaSceneObject::AddRenderMeshRef( const shared_ptr<vaRenderMesh> & renderMes
     m_renderMeshes.push_back( uid ); 
     m_cachedRenderMeshes.push_back( renderMesh );
     assert( m_cachedRenderMeshes.size() == m_renderMeshes.size() );
-    m_computedLocalBoundingBox = vaBoundingBox::Degenerate;
+    InvalidateLocalBoundingBox( );
 }
 
 bool vaSceneObject::RemoveRenderMeshRef( int index )
@@ -145,7 +163,7 @@ bool vaSceneObject::RemoveRenderMeshRef( int index )
     m_renderMeshes.pop_back();
     m_cachedRenderMeshes[index] = m_cachedRenderMeshes.back( );
     m_cachedRenderMeshes.pop_back( );
-    m_computedLocalBoundingBox = vaBoundingBox::Degenerate;
+    InvalidateLocalBoundingBox( );
     return true;
 }
 
@@ -162,7 +180,7 @@ bool vaSceneObject::RemoveRenderMeshRef( const shared_ptr<vaRenderMesh> & render
     if( indexRemoved < (m_cachedRenderMeshes.size()-1) )
         m_cachedRenderMeshes[indexRemoved] = m_cachedRenderMeshes.back();
     m_cachedRenderMeshes.pop_back();
-    m_computedLocalBoundingBox = vaBoundingBox::Degenerate;
+    InvalidateLocalBoundingBox( );
     return true;
 }
 
@@ -189,22 +207,25 @@ bool vaSceneObject::Serialize( vaXMLSerializer & serializer )
     VERIFY_TRUE_RETURN_ON_FALSE( scene->SerializeObjectsRecursive( serializer, "ChildObjects", m_children, this->shared_from_this() ) );
 
     if( serializer.IsReading( ) )
-    {
-        m_lastSceneTickIndex = -1;
-        m_computedWorldTransform = vaMatrix4x4::Identity;
-        m_computedLocalBoundingBox = vaBoundingBox::Degenerate;
-        m_computedGlobalBoundingBox = vaBoundingBox::Degenerate;
-        m_cachedRenderMeshes.resize( m_renderMeshes.size() );
+        InitAfterLoad( );
 
-        m_localTransform.Row(0).w = 0.0f;
-        m_localTransform.Row(1).w = 0.0f;
-        m_localTransform.Row(2).w = 0.0f;
-        m_localTransform.Row(3).w = 1.0f;
+    return true;
+}
 
-        SetLocalTransform( m_localTransform );
-    }
+void vaSceneObject::InitAfterLoad( )
+{
+    m_lastSceneTickIndex = -1;
+    m_computedWorldTransform = vaMatrix4x4::Identity;
+    m_computedLocalBoundingBox = vaBoundingBox::Degenerate;
+    m_computedGlobalBoundingBox = vaBoundingBox::Degenerate;
+    m_cachedRenderMeshes.resize( m_renderMeshes.size() );
 
-    return true;
+    m_localTransform.Row(0).w = 0.0f;
+    m_localTransform.Row(1).w = 0.0f;
+    m_localTransform.Row(2).w = 0.0f;
+    m_localTransform.Row(3).w = 1.0f;
+
+    SetLocalTransform( m_localTransform );
 }
 
 void vaSceneObject::MarkAsDestroyed( bool markChildrenAsWell )
@@ -246,6 +267,9 @@ void vaSceneObject::SetParent( const shared_ptr<vaSceneObject> & parent )
     if( scene == nullptr )
         return;
 
+    // same as add/remove in ApplyDeferredObjectActions: the flattened hierarchy order depends on the parent links
+    scene->m_hierarchy.StructureDirty = true;
+
     // changing parent? then unregister us from previous (either root or another object)
     if( m_parent != nullptr )
         m_parent->RegisterChildRemoved( this->shared_from_this() );
@@ -300,10 +324,21 @@ vaDrawResultFlags vaSceneObject::SelectForRendering( vaRenderSelection * opaqueL
 
     // first and easy one, global filter by frustum planes
     if( filter.FrustumPlanes.size() > 0 )
-        if( m_computedGlobalBoundingBox.IntersectFrustum( filter.FrustumPlanes ) == vaIntersectType::Outside )
+        if( m_computedGlobalBoundingBox.IntersectFrustum( filter.FrustumPlanes.data( ), (int)filter.FrustumPlanes.size( ) ) == vaIntersectType::Outside )
+            return vaDrawResultFlags::None;
+
+    // then by bounding sphere (if any)
+    const bool sphereCull = filter.BoundingSphereTo.Radius >= 0.0f;
+    if( sphereCull )
+        if( m_computedGlobalBoundingBox.NearestDistanceToPoint( filter.BoundingSphereTo.Center ) > filter.BoundingSphereTo.Radius )
             return vaDrawResultFlags::None;
 
     vaMatrix4x4 worldTransform = GetWorldTransform( );
+
+    // LOD errors are in mesh (object) space so scale them by the largest axis scale
+    const bool lodSelect = filter.LODPixelScale > 0.0f;
+    const float worldScale = ( !lodSelect ) ? ( 1.0f ) : ( vaMath::Max( worldTransform.GetAxisX( ).Length( ), vaMath::Max( worldTransform.GetAxisY( ).Length( ), worldTransform.GetAxisZ( ).Length( ) ) ) );
+
     for( int i = 0; i < m_renderMeshes.size(); i++ )
     {
         auto renderMesh = GetRenderMesh(i);
@@ -323,7 +358,11 @@ vaDrawResultFlags vaSceneObject::SelectForRendering( vaRenderSelection * opaqueL
         vaOrientedBoundingBox obb = vaOrientedBoundingBox::FromAABBAndTransform( renderMesh->GetAABB(), worldTransform );
 
         if( filter.FrustumPlanes.size() > 0 )
-            if( obb.IntersectFrustum( filter.FrustumPlanes ) == vaIntersectType::Outside )
+            if( obb.IntersectFrustum( filter.FrustumPlanes.data( ), (int)filter.FrustumPlanes.size( ) ) == vaIntersectType::Outside )
+                continue;
+
+        if( sphereCull )
+            if( obb.NearestDistanceToPoint( filter.BoundingSphereTo.Center ) > filter.BoundingSphereTo.Radius )
                 continue;
 
         int baseShadingRate = 0;
@@ -334,15 +373,24 @@ vaDrawResultFlags vaSceneObject::SelectForRendering( vaRenderSelection * opaqueL
 
         vaShadingRate finalShadingRate = renderMaterial->ComputeShadingRate( baseShadingRate );
 
+        // pick LOD by the projected error at the nearest point of the mesh bounds (always LOD 0 if the reference point is inside)
+        int lodLevel = 0;
+        if( lodSelect && renderMesh->GetLODCount( ) > 1 )
+        {
+            float distance = obb.NearestDistanceToPoint( filter.LODReferencePoint );
+            if( distance > 0.0f )
+                lodLevel = renderMesh->SelectLOD( filter.LODPixelScale * worldScale / distance, filter.LODErrorThreshold );
+        }
+
         if( renderMaterial->IsTransparent() )
         {
             if( transparentList != nullptr ) 
-                transparentList->MeshList->Insert( renderMesh, renderMaterial, worldTransform, finalShadingRate, customColor );
+                transparentList->MeshList->Insert( renderMesh, renderMaterial, worldTransform, finalShadingRate, customColor, lodLevel );
         }
         else
         {
             if( opaqueList != nullptr )
-                opaqueList->MeshList->Insert( renderMesh, renderMaterial, worldTransform, finalShadingRate, customColor );
+                opaqueList->MeshList->Insert( renderMesh, renderMaterial, worldTransform, finalShadingRate, customColor, lodLevel );
         }
     }
     return drawResults;
@@ -810,6 +858,10 @@ void vaScene::ApplyDeferredObjectActions( )
         return;
     }
 
+    // any of these change the object hierarchy
+    if( m_deferredObjectActions.size( ) > 0 )
+        m_hierarchy.StructureDirty = true;
+
     for( int i = 0; i < m_deferredObjectActions.size( ); i++ )
     {
         const DeferredObjectAction & mod = m_deferredObjectActions[i];
@@ -870,8 +922,23 @@ void vaScene::DestroyObjectImmediate( const shared_ptr<vaSceneObject> & obj, boo
     //assert( obj->GetScene() == nullptr );   // it must have been already set to null
     obj->SetParent( nullptr );
 
+    // static shadow layers that include it need to go
+    if( obj->m_reportedAsStaticCaster )
+    {
+        vaShadowCasterChange change;
+        change.WasStatic    = true;
+        change.BoundsBefore = obj->m_reportedStaticCasterBounds;
+        m_shadowCasterChanges.push_back( change );
+        obj->m_reportedAsStaticCaster = false;
+    }
+
     obj->SetScene( nullptr );
 
+    obj->m_hierarchyIndex       = -1;
+    obj->m_transformDirty       = false;
+    obj->m_localBoundsQueued    = false;
+    obj->m_inDynamicList        = false;
+
     bool allOk = vector_find_and_remove( m_rootObjects, obj ) != -1;
     assert( allOk );
     allOk = vector_find_and_remove( m_allObjects, obj ) != -1;
@@ -897,6 +964,9 @@ void vaScene::DestroyObjectImmediate( const shared_ptr<vaSceneObject> & obj, boo
 void vaScene::Tick( float deltaTime )
 {
     VA_TRACE_CPU_SCOPE( vaScene_Tick );
+    // m_shadowCasterChanges is not cleared here - objects can be destroyed outside of Tick (for ex. in Clear) and those changes must
+    // reach the consumer too; it calls ClearShadowCasterChanges once it's done with them
+    m_dynamicShadowCasterBounds.clear();
     ApplyDeferredObjectActions();
 
     if( deltaTime > 0 )
@@ -906,10 +976,7 @@ void vaScene::Tick( float deltaTime )
         assert( !m_isInTick );
         m_isInTick = true;
         m_tickIndex++;
-        for( int i = 0; i < m_rootObjects.size( ); i++ )
-        {
-            m_rootObjects[i]->TickRecursive( *this, deltaTime );
-        }
+        UpdateTransformHierarchy( deltaTime );
         assert( m_isInTick );
         m_isInTick = false;
 
@@ -919,6 +986,238 @@ void vaScene::Tick( float deltaTime )
     }
 }
 
+void vaScene::RebuildTransformHierarchy( )
+{
+    VA_TRACE_CPU_SCOPE( vaScene_RebuildTransformHierarchy );
+
+    TransformHierarchy & h = m_hierarchy;
+
+    h.Objects.clear( );
+    h.Parents.clear( );
+    h.Levels.clear( );
+    h.FirstChild.clear( );
+    h.ChildCount.clear( );
+    h.DirtyTransforms.clear( );
+    h.PendingBounds.clear( );
+    h.Dynamic.clear( );
+
+    for( const auto & rootObject : m_rootObjects )
+    {
+        h.Objects.push_back( rootObject.get( ) );
+        h.Parents.push_back( -1 );
+        h.Levels.push_back( 0 );
+    }
+
+    // breadth first, so that each level is contiguous and so are the children of any object
+    int maxLevel = 0;
+    for( int i = 0; i < (int)h.Objects.size( ); i++ )
+    {
+        const vector<shared_ptr<vaSceneObject>> & children = h.Objects[i]->GetChildren( );
+        const int childLevel = h.Levels[i] + 1;
+
+        h.FirstChild.push_back( (int)h.Objects.size( ) );
+        h.ChildCount.push_back( (int)children.size( ) );
+        for( const auto & child : children )
+        {
+            h.Objects.push_back( child.get( ) );
+            h.Parents.push_back( i );
+            h.Levels.push_back( childLevel );
+            maxLevel = vaMath::Max( maxLevel, childLevel );
+        }
+    }
+    assert( h.Objects.size( ) == m_allObjects.size( ) );
+
+    const int count = (int)h.Objects.size( );
+    h.LocalTransforms.resize( count );
+    h.WorldTransforms.resize( count );
+    h.OwnBounds.resize( count );
+    h.GlobalBounds.resize( count );
+    h.Flags.assign( count, 0 );
+    h.LevelWork.resize( maxLevel + 1 );
+    for( auto & work : h.LevelWork )
+        work.clear( );
+
+    // everything gets updated on the next UpdateTransformHierarchy
+    for( int i = 0; i < count; i++ )
+    {
+        vaSceneObject & obj = *h.Objects[i];
+        obj.m_hierarchyIndex    = i;
+        obj.m_transformDirty    = true;
+        h.DirtyTransforms.push_back( i );
+
+        obj.m_localBoundsQueued = ( obj.m_computedLocalBoundingBox == vaBoundingBox::Degenerate || obj.m_computedLocalBoundingBoxIncomplete ) && obj.m_renderMeshes.size( ) > 0;
+        if( obj.m_localBoundsQueued )
+            h.PendingBounds.push_back( i );
+
+        obj.m_inDynamicList     = obj.IsDynamic( );
+        if( obj.m_inDynamicList )
+            h.Dynamic.push_back( i );
+    }
+
+    h.StructureDirty = false;
+}
+
+void vaScene::UpdateTransformHierarchy( float deltaTime )
+{
+    VA_TRACE_CPU_SCOPE( vaScene_UpdateTransformHierarchy );
+
+    if( m_hierarchy.StructureDirty )
+        RebuildTransformHierarchy( );
+
+    TransformHierarchy & h = m_hierarchy;
+
+    enum : uint8
+    {
+        FlagTransform   = ( 1 << 0 ),       // world transform (and own bounds) need updating; implies FlagBounds
+        FlagBounds      = ( 1 << 1 ),       // global bounds need updating
+        FlagMoved       = ( 1 << 2 ),       // world transform changed
+    };
+    const int c_minChunkSize = 256;
+
+    // adds to the per-level work list if not already in
+    auto enqueue = [&h]( int index, uint8 flags )
+    {
+        if( h.Flags[index] == 0 )
+            h.LevelWork[h.Levels[index]].push_back( index );
+        h.Flags[index] |= flags;
+    };
+
+    // local bounds that were invalidated or still wait for assets to load
+    for( int k = 0; k < (int)h.PendingBounds.size( ); )
+    {
+        const int i = h.PendingBounds[k];
+        vaSceneObject & obj = *h.Objects[i];
+        obj.UpdateLocalBoundingBox( );
+        enqueue( i, FlagTransform );
+        if( obj.m_computedLocalBoundingBoxIncomplete )
+            k++;
+        else
+        {
+            obj.m_localBoundsQueued = false;
+            h.PendingBounds[k] = h.PendingBounds.back( );
+            h.PendingBounds.pop_back( );
+        }
+    }
+
+    for( const int i : h.DirtyTransforms )
+    {
+        vaSceneObject & obj = *h.Objects[i];
+        obj.m_transformDirty = false;
+        h.LocalTransforms[i] = obj.m_localTransform;
+        enqueue( i, FlagTransform );
+    }
+    h.DirtyTransforms.clear( );
+
+    const int levelCount = (int)h.LevelWork.size( );
+    const int64 tickIndex = m_tickIndex;
+
+    // world transforms and own bounds, top-down: each level only depends on the one above
+    for( int level = 0; level < levelCount; level++ )
+    {
+        const vector<int> & work = h.LevelWork[level];
+        if( work.size( ) == 0 )
+            continue;
+
+        // whole subtrees of anything that changed need updating
+        if( level + 1 < levelCount )
+            for( const int i : work )
+                for( int c = h.FirstChild[i]; c < h.FirstChild[i] + h.ChildCount[i]; c++ )
+                    enqueue( c, FlagTransform );
+
+        vaThreading::ParallelFor( (int)work.size( ), c_minChunkSize, [&h, &work, tickIndex]( int begin, int end )
+        {
+            for( int k = begin; k < end; k++ )
+            {
+                const int i = work[k];
+                const int parent = h.Parents[i];
+                vaSceneObject & obj = *h.Objects[i];
+
+                const vaMatrix4x4 worldTransform = ( parent == -1 ) ? ( h.LocalTransforms[i] ) : ( h.LocalTransforms[i] * h.WorldTransforms[parent] );
+
+                // the first update (or the first after loading) only initializes the transform, that's not a change
+                if( obj.m_lastSceneTickIndex != -1 && !( obj.m_computedWorldTransform == worldTransform ) )
+                    h.Flags[i] |= FlagMoved;
+
+                h.WorldTransforms[i]            = worldTransform;
+                h.OwnBounds[i]                  = vaOrientedBoundingBox( obj.m_computedLocalBoundingBox, worldTransform ).ComputeEnclosingAABB( );
+                obj.m_computedWorldTransform    = worldTransform;
+                obj.m_lastSceneTickIndex        = tickIndex;
+            }
+        } );
+    }
+
+    // global bounds, bottom-up: everything updated above plus all of their ancestors
+    for( int level = levelCount - 1; level >= 0; level-- )
+    {
+        const vector<int> & work = h.LevelWork[level];
+        if( work.size( ) == 0 )
+            continue;
+
+        vaThreading::ParallelFor( (int)work.size( ), c_minChunkSize, [&h, &work]( int begin, int end )
+        {
+            for( int k = begin; k < end; k++ )
+            {
+                const int i = work[k];
+                vaBoundingBox globalBounds = h.OwnBounds[i];
+                for( int c = h.FirstChild[i]; c < h.FirstChild[i] + h.ChildCount[i]; c++ )
+                    globalBounds = vaBoundingBox::Combine( globalBounds, h.GlobalBounds[c] );
+                h.GlobalBounds[i] = globalBounds;
+                h.Objects[i]->m_computedGlobalBoundingBox = globalBounds;
+            }
+        } );
+
+        if( level > 0 )
+            for( const int i : work )
+                enqueue( h.Parents[i], FlagBounds );
+    }
+
+    // objects that moved become (or stay) dynamic; dynamic ones keep their rest timer running until they become static again
+    for( const auto & work : h.LevelWork )
+        for( const int i : work )
+        {
+            if( ( h.Flags[i] & FlagMoved ) == 0 )
+                continue;
+            vaSceneObject & obj = *h.Objects[i];
+            obj.m_timeSinceTransformChange = 0.0f;
+            if( !obj.m_inDynamicList )
+            {
+                obj.m_inDynamicList = true;
+                h.Dynamic.push_back( i );
+            }
+        }
+    for( int k = 0; k < (int)h.Dynamic.size( ); )
+    {
+        const int i = h.Dynamic[k];
+        vaSceneObject & obj = *h.Objects[i];
+        if( ( h.Flags[i] & FlagMoved ) == 0 )
+            obj.m_timeSinceTransformChange += deltaTime;
+
+        obj.UpdateShadowCasterState( *this, h.OwnBounds[i] );
+
+        if( obj.IsDynamic( ) )
+            k++;
+        else
+        {
+            obj.m_inDynamicList = false;
+            h.Dynamic[k] = h.Dynamic.back( );
+            h.Dynamic.pop_back( );
+        }
+    }
+
+    // static objects whose own bounds were recomputed (first update, assets finished loading) and then clean up
+    for( auto & work : h.LevelWork )
+    {
+        for( const int i : work )
+        {
+            vaSceneObject & obj = *h.Objects[i];
+            if( ( h.Flags[i] & FlagTransform ) != 0 && !obj.m_inDynamicList )
+                obj.UpdateShadowCasterState( *this, h.OwnBounds[i] );
+            h.Flags[i] = 0;
+        }
+        work.clear( );
+    }
+}
+
 void vaScene::ApplyToLighting( vaLighting & lighting )
 {
     VA_TRACE_CPU_SCOPE( vaScene_ApplyToLighting );
@@ -974,6 +1273,55 @@ bool vaScene::SerializeObjectsRecursive( vaXMLSerializer & serializer, const str
     return true;
 }
 
+// name, UID and lights (when merging only lights are added, name and UID of the scene are kept)
+bool vaScene::SerializeSettings( vaXMLSerializer & serializer, bool mergeToExistingIfLoading )
+{
+    string mergingName;
+    if( mergeToExistingIfLoading )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<string>( "Name", mergingName ) );
+        //vaVector3 mergingAmbientLight;
+        //VERIFY_TRUE_RETURN_ON_FALSE( serializer.OldSerializeValue( "AmbientLight", mergingAmbientLight ) );
+        vector<shared_ptr<vaLight>> mergingLights;
+        
+        if( serializer.GetVersion() > 0 )
+            VERIFY_TRUE_RETURN_ON_FALSE( serializer.SerializeArray( "Lights", mergingLights ) );
+        else
+            { assert( false ); } 
+        
+        m_lights.insert( m_lights.end(), mergingLights.begin(), mergingLights.end() );
+
+        //serializer.Serialize<string>( "DistantIBLPath", m_IBLProbeDistantImagePath );
+    }
+    else
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<string>( "Name", m_name ) );
+        /*VERIFY_TRUE_RETURN_ON_FALSE(*/ serializer.Serialize<vaGUID>( "UID", m_UID, vaGUID::Create( ) );// );
+        //VERIFY_TRUE_RETURN_ON_FALSE( serializer.OldSerializeValue( "AmbientLight", m_lightAmbient ) );
+        if( serializer.GetVersion() > 0 )
+            VERIFY_TRUE_RETURN_ON_FALSE( serializer.SerializeArray( "Lights", m_lights ) );
+        else
+            { assert( false ); } 
+        //serializer.SerializeArray( "Inputs", "Item", m_lights );
+
+        //serializer.Serialize<string>( "DistantIBLPath", m_IBLProbeDistantImagePath );
+    }
+
+    return true;
+}
+
+bool vaScene::SerializeEnvironment( vaXMLSerializer & serializer )
+{
+    VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<vaXMLSerializable>( "FogSphere", m_fog ) );
+    ///*VERIFY_TRUE_RETURN_ON_FALSE(*/ m_fog.Serialize( serializer );
+
+    /*VERIFY_TRUE_RETURN_ON_FALSE*/( serializer.Serialize( "IBLProbeLocal", m_IBLProbeLocal ) );
+    /*VERIFY_TRUE_RETURN_ON_FALSE*/( serializer.Serialize( "IBLProbeDistant", m_IBLProbeDistant ) );
+    // serializer.Serialize<string>( "IBLProbeDistantImagePath", m_IBLProbeDistantImagePath );
+
+    return true;
+}
+
 bool vaScene::Serialize( vaXMLSerializer & serializer, bool mergeToExistingIfLoading )
 {
     if( m_isInTick )
@@ -998,45 +1346,11 @@ bool vaScene::Serialize( vaXMLSerializer & serializer, bool mergeToExistingIfLoa
         if( serializer.IsReading() && !mergeToExistingIfLoading )
             Clear();
 
-        string mergingName;
-        if( mergeToExistingIfLoading )
-        {
-            VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<string>( "Name", mergingName ) );
-            //vaVector3 mergingAmbientLight;
-            //VERIFY_TRUE_RETURN_ON_FALSE( serializer.OldSerializeValue( "AmbientLight", mergingAmbientLight ) );
-            vector<shared_ptr<vaLight>> mergingLights;
-            
-            if( serializer.GetVersion() > 0 )
-                VERIFY_TRUE_RETURN_ON_FALSE( serializer.SerializeArray( "Lights", mergingLights ) );
-            else
-                { assert( false ); } 
-            
-            m_lights.insert( m_lights.end(), mergingLights.begin(), mergingLights.end() );
-
-            //serializer.Serialize<string>( "DistantIBLPath", m_IBLProbeDistantImagePath );
-        }
-        else
-        {
-            VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<string>( "Name", m_name ) );
-            /*VERIFY_TRUE_RETURN_ON_FALSE(*/ serializer.Serialize<vaGUID>( "UID", m_UID, vaGUID::Create( ) );// );
-            //VERIFY_TRUE_RETURN_ON_FALSE( serializer.OldSerializeValue( "AmbientLight", m_lightAmbient ) );
-            if( serializer.GetVersion() > 0 )
-                VERIFY_TRUE_RETURN_ON_FALSE( serializer.SerializeArray( "Lights", m_lights ) );
-            else
-                { assert( false ); } 
-            //serializer.SerializeArray( "Inputs", "Item", m_lights );
-
-            //serializer.Serialize<string>( "DistantIBLPath", m_IBLProbeDistantImagePath );
-        }
+        VERIFY_TRUE_RETURN_ON_FALSE( SerializeSettings( serializer, mergeToExistingIfLoading ) );
 
         VERIFY_TRUE_RETURN_ON_FALSE( SerializeObjectsRecursive( serializer, "RootObjects", m_rootObjects, nullptr ) );
 
-        VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<vaXMLSerializable>( "FogSphere", m_fog ) );
-        ///*VERIFY_TRUE_RETURN_ON_FALSE(*/ m_fog.Serialize( serializer );
-
-        /*VERIFY_TRUE_RETURN_ON_FALSE*/( serializer.Serialize( "IBLProbeLocal", m_IBLProbeLocal ) );
-        /*VERIFY_TRUE_RETURN_ON_FALSE*/( serializer.Serialize( "IBLProbeDistant", m_IBLProbeDistant ) );
-        // serializer.Serialize<string>( "IBLProbeDistantImagePath", m_IBLProbeDistantImagePath );
+        VERIFY_TRUE_RETURN_ON_FALSE( SerializeEnvironment( serializer ) );
 
         bool ok = serializer.SerializePopToParentElement( "VanillaScene" );
         assert( ok ); 
@@ -1151,6 +1465,248 @@ static shared_ptr<vaSceneObject> ImGuiDisplaySceneObjectTreeRecursive( const vec
 }
 #endif
 
+namespace
+{
+    // binary scene format
+    //
+    // uint32       magic ('VASB')
+    // int32        version
+    // string       settings & environment (lights, fog, IBL) as XML - small, and these already have XML serialization
+    // int32        object count, followed by arrays (each as int32 count + raw contents), objects in depth-first order
+    //              (same as the XML) so every parent comes before its children:
+    //                  int32           parent index (-1 for root objects)
+    //                  vaMatrix4x4     local transform
+    //                  uint32          name length  + all names in one string
+    //                  uint32          render mesh count + all render mesh IDs in one array
+    static const uint32 c_binarySceneMagic      = 0x42534156;   // 'VASB'
+    static const int32  c_binarySceneVersion    = 1;
+
+    template< typename ElementType >
+    static bool WriteBulk( vaStream & stream, const vector<ElementType> & elements )
+    {
+        if( !stream.WriteValue<int32>( (int32)elements.size( ) ) )
+            return false;
+        return elements.size( ) == 0 || stream.Write( elements.data( ), sizeof( ElementType ) * elements.size( ) );
+    }
+
+    // counts come straight from the file - never allocate more than what is actually left in the stream
+    static bool FitsInStream( vaStream & stream, int64 sizeInBytes )
+    {
+        return sizeInBytes >= 0 && sizeInBytes <= stream.GetLength( ) - stream.GetPosition( );
+    }
+
+    template< typename ElementType >
+    static bool ReadBulk( vaStream & stream, vector<ElementType> & elements, int32 expectedCount = -1 )
+    {
+        int32 count = -1;
+        if( !stream.ReadValue<int32>( count ) || count < 0 || ( expectedCount != -1 && count != expectedCount ) )
+            return false;
+        if( !FitsInStream( stream, (int64)sizeof( ElementType ) * count ) )
+            return false;
+        elements.resize( count );
+        return count == 0 || stream.Read( elements.data( ), sizeof( ElementType ) * count );
+    }
+
+    // same layout as vaStream::WriteString( const string & )
+    static bool ReadString( vaStream & stream, string & outStr )
+    {
+        uint32 lengthInBytes = 0;
+        if( !stream.ReadValue<uint32>( lengthInBytes ) || ( lengthInBytes & ( 1u << 31 ) ) != 0 || !FitsInStream( stream, (int64)lengthInBytes ) )
+            return false;
+        outStr.resize( lengthInBytes );
+        return lengthInBytes == 0 || stream.Read( outStr.data( ), lengthInBytes );
+    }
+}
+
+bool vaScene::SaveBinary( vaStream & outStream )
+{
+    // calling Save with non-applied changes? probably a bug somewhere (if not, just call ApplyDeferredObjectActions() before getting here)
+    assert( m_deferredObjectActions.size() == 0 );
+    if( m_isInTick || m_deferredObjectActions.size( ) != 0 )
+    {
+        assert( false );
+        return false;
+    }
+
+    vaXMLSerializer settings;
+    VERIFY_TRUE_RETURN_ON_FALSE( settings.SerializeOpenChildElement( "VanillaSceneSettings" ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( SerializeSettings( settings, false ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( SerializeEnvironment( settings ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( settings.SerializePopToParentElement( "VanillaSceneSettings" ) );
+
+    vector<int32>           parents;
+    vector<vaMatrix4x4>     transforms;
+    vector<uint32>          nameLengths;
+    string                  names;
+    vector<uint32>          meshCounts;
+    vector<vaGUID>          meshes;
+    parents.reserve( m_allObjects.size( ) );
+    transforms.reserve( m_allObjects.size( ) );
+    nameLengths.reserve( m_allObjects.size( ) );
+    meshCounts.reserve( m_allObjects.size( ) );
+
+    std::function<void( const vector<shared_ptr<vaSceneObject>> &, int32 )> addObjects = [&]( const vector<shared_ptr<vaSceneObject>> & objects, int32 parentIndex )
+    {
+        for( const auto & object : objects )
+        {
+            int32 index = (int32)parents.size( );
+            parents.push_back( parentIndex );
+            transforms.push_back( object->m_localTransform );
+            nameLengths.push_back( (uint32)object->m_name.size( ) );
+            names += object->m_name;
+            meshCounts.push_back( (uint32)object->m_renderMeshes.size( ) );
+            meshes.insert( meshes.end( ), object->m_renderMeshes.begin( ), object->m_renderMeshes.end( ) );
+            addObjects( object->m_children, index );
+        }
+    };
+    addObjects( m_rootObjects, -1 );
+    assert( parents.size( ) == m_allObjects.size( ) );
+
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<uint32>( c_binarySceneMagic ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( c_binarySceneVersion ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteString( string( settings.GetWritePrinter( ).CStr( ), settings.GetWritePrinter( ).CStrSize( ) - 1 ) ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( (int32)parents.size( ) ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( WriteBulk( outStream, parents ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( WriteBulk( outStream, transforms ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( WriteBulk( outStream, nameLengths ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteString( names ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( WriteBulk( outStream, meshCounts ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( WriteBulk( outStream, meshes ) );
+
+    return true;
+}
+
+bool vaScene::SaveBinary( const wstring & fileName )
+{
+    vaFileStream fileOut;
+    if( !fileOut.Open( fileName, FileCreationMode::OpenOrCreate, FileAccessMode::Write ) )
+    {
+        VA_LOG_WARNING( L"Unable to save scene to '%s', file error.", fileName.c_str() );
+        return false;
+    }
+
+    VA_LOG( L"Writing '%s'.", fileName.c_str() );
+    if( !SaveBinary( fileOut ) )
+    {
+        VA_LOG_WARNING( L"Error while serializing the scene" );
+        fileOut.Close();
+        return false;
+    }
+    fileOut.Truncate( );
+    fileOut.Close();
+    VA_LOG( L"Scene successfully saved to '%s'.", fileName.c_str() );
+    return true;
+}
+
+bool vaScene::LoadBinary( vaStream & inStream, bool mergeToExisting )
+{
+    // calling Load with non-applied changes? probably a bug somewhere (if not, just call ApplyDeferredObjectActions() before getting here)
+    assert( m_deferredObjectActions.size() == 0 );
+    if( m_isInTick || m_deferredObjectActions.size( ) != 0 )
+    {
+        assert( false );
+        return false;
+    }
+
+    uint32 magic = 0;
+    int32 version = 0;
+    if( !inStream.ReadValue<uint32>( magic ) || magic != c_binarySceneMagic || !inStream.ReadValue<int32>( version ) )
+    {
+        VA_LOG_WARNING( L"Unable to load scene, not a binary scene." );
+        return false;
+    }
+    if( version < 1 || version > c_binarySceneVersion )
+    {
+        VA_LOG_WARNING( L"Unable to load scene, unsupported binary scene version %d.", version );
+        return false;
+    }
+
+    string                  settingsXML;
+    int32                   count = 0;
+    vector<int32>           parents;
+    vector<vaMatrix4x4>     transforms;
+    vector<uint32>          nameLengths;
+    string                  names;
+    vector<uint32>          meshCounts;
+    vector<vaGUID>          meshes;
+    bool ok = ReadString( inStream, settingsXML );
+    ok = ok && inStream.ReadValue<int32>( count ) && count >= 0;
+    ok = ok && ReadBulk( inStream, parents, count );
+    ok = ok && ReadBulk( inStream, transforms, count );
+    ok = ok && ReadBulk( inStream, nameLengths, count );
+    ok = ok && ReadString( inStream, names );
+    ok = ok && ReadBulk( inStream, meshCounts, count );
+    ok = ok && ReadBulk( inStream, meshes );
+
+    // validate everything before touching the scene
+    size_t totalNameLength = 0, totalMeshCount = 0;
+    for( int32 i = 0; ok && i < count; i++ )
+    {
+        ok = parents[i] >= -1 && parents[i] < i;
+        totalNameLength += nameLengths[i];
+        totalMeshCount  += meshCounts[i];
+    }
+    ok = ok && totalNameLength == names.size( ) && totalMeshCount == meshes.size( );
+    if( !ok )
+    {
+        VA_LOG_WARNING( L"Unable to load scene, binary contents corrupted." );
+        return false;
+    }
+
+    vaXMLSerializer settings( settingsXML.c_str( ), settingsXML.size( ) );
+    if( !settings.IsReading( ) || !settings.SerializeOpenChildElement( "VanillaSceneSettings" ) )
+    {
+        VA_LOG_WARNING( L"Unable to load scene, unexpected contents." );
+        return false;
+    }
+
+    if( !mergeToExisting )
+        Clear();
+
+    VERIFY_TRUE_RETURN_ON_FALSE( SerializeSettings( settings, mergeToExisting ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( SerializeEnvironment( settings ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( settings.SerializePopToParentElement( "VanillaSceneSettings" ) );
+
+    vector<shared_ptr<vaSceneObject>> objects( count );
+    size_t nameOffset = 0, meshOffset = 0;
+    for( int32 i = 0; i < count; i++ )
+    {
+        shared_ptr<vaSceneObject> obj = CreateObject( names.substr( nameOffset, nameLengths[i] ), transforms[i], ( parents[i] == -1 ) ? ( nullptr ) : ( objects[parents[i]] ) );
+        obj->m_renderMeshes.assign( meshes.begin( ) + meshOffset, meshes.begin( ) + meshOffset + meshCounts[i] );
+        obj->InitAfterLoad( );
+        nameOffset += nameLengths[i];
+        meshOffset += meshCounts[i];
+        objects[i] = std::move( obj );
+    }
+
+    return PostLoadInit( );
+}
+
+bool vaScene::VerifyBinaryRoundTrip( )
+{
+    vaMemoryStream binary( 0, 64 * 1024 );
+    if( !SaveBinary( binary ) )
+        return false;
+
+    binary.Seek( 0 );
+    shared_ptr<vaScene> copy = std::make_shared<vaScene>( );
+    if( !copy->LoadBinary( binary, false ) )
+        return false;
+
+    vaXMLSerializer original, roundTripped;
+    if( !Serialize( original, false ) || !copy->Serialize( roundTripped, false ) )
+        return false;
+
+    const tinyxml2::XMLPrinter & a = original.GetWritePrinter( );
+    const tinyxml2::XMLPrinter & b = roundTripped.GetWritePrinter( );
+    bool identical = a.CStrSize( ) == b.CStrSize( ) && memcmp( a.CStr( ), b.CStr( ), a.CStrSize( ) ) == 0;
+    if( identical )
+        VA_LOG_SUCCESS( "Binary scene round-trip OK ('%s', %d objects, %d bytes binary vs %d bytes XML)", m_name.c_str( ), (int)m_allObjects.size( ), (int)binary.GetLength( ), (int)a.CStrSize( ) );
+    else
+        VA_LOG_ERROR( "Binary scene round-trip mismatch ('%s')", m_name.c_str( ) );
+    return identical;
+}
+
 bool vaScene::Save( const wstring & fileName )
 {
     // calling Save with non-applied changes? probably a bug somewhere (if not, just call ApplyDeferredObjectActions() before getting here)
@@ -1196,8 +1752,24 @@ bool vaScene::Load( const wstring & fileName, bool mergeToExisting )
     vaFileStream fileIn;
     if( vaFileTools::FileExists( fileName ) && fileIn.Open( fileName, FileCreationMode::Open ) )
     {
+        uint32 magic = 0;
+        if( fileIn.ReadValue<uint32>( magic ) && magic == c_binarySceneMagic )
+        {
+            fileIn.Seek( 0 );
+            VA_LOG( L"Reading '%s'.", fileName.c_str() );
+            double loadStart = vaCore::TimeFromAppStart( );
+            if( !LoadBinary( fileIn, mergeToExisting ) )
+            {
+                VA_LOG_WARNING( L"Error while loading the binary scene" );
+                fileIn.Close();
+                return false;
+            }
+            fileIn.Close();
+            VA_LOG( L"Scene successfully loaded from '%s' in %.3fms", fileName.c_str(), ( vaCore::TimeFromAppStart( ) - loadStart ) * 1000.0 );
+            return true;
+        }
+
         vaXMLSerializer serializer( fileIn );
-        fileIn.Close();
 
         if( serializer.IsReading( ) )
         {
@@ -1260,17 +1832,31 @@ void vaScene::UIPanelTick( vaApplicationBase & application )
     }
 
     ImGui::SameLine();
+    if( ImGui::Button( " Save binary as... " ) )
+    {
+        wstring fileName = vaFileTools::SaveFileDialog( L"", vaCore::GetExecutableDirectory(), L".bin binary scene files\0*.bin\0\0" );
+        if( fileName != L"" )
+        {
+            if( vaFileTools::SplitPathExt( fileName ) == L"" ) // if no extension, add .bin
+                fileName += L".bin";
+            SaveBinary( fileName );
+        }
+    }
+
     if( ImGui::Button( " Load... " ) )
     {
-        wstring fileName = vaFileTools::OpenFileDialog( L"", vaCore::GetExecutableDirectory(), L".xml scene files\0*.xml\0\0" );
+        wstring fileName = vaFileTools::OpenFileDialog( L"", vaCore::GetExecutableDirectory(), L"scene files\0*.xml;*.bin\0\0" );
         Load( fileName, false );
     }
     ImGui::SameLine();
     if( ImGui::Button( " Load and merge... " ) )
     {
-        wstring fileName = vaFileTools::OpenFileDialog( L"", vaCore::GetExecutableDirectory(), L".xml scene files\0*.xml\0\0" );
+        wstring fileName = vaFileTools::OpenFileDialog( L"", vaCore::GetExecutableDirectory(), L"scene files\0*.xml;*.bin\0\0" );
         Load( fileName, true );
     }
+    ImGui::SameLine();
+    if( ImGui::Button( " Verify binary round-trip " ) )
+        VerifyBinaryRoundTrip( );
 
     ImGui::Separator();
 
@@ -1709,7 +2295,7 @@ vaDrawResultFlags vaScene::SelectForRendering( vaRenderSelection * opaqueList, v
     vaDrawResultFlags drawResults = vaDrawResultFlags::None;
 
 
-    for( auto object : m_allObjects )
+    for( const auto & object : m_allObjects )
         drawResults |= object->SelectForRendering( opaqueList, transparentList, filter, customFilter );
     //renderSelection.MeshList.Insert()
 
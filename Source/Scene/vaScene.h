@@ -54,15 +54,28 @@ namespace Vanilla
         bool                                        m_destroyedButNotYetRemovedFromScene    = false;
 
         // derived/computed variable cache
-        mutable int64                               m_lastSceneTickIndex                    = -1;                           // Updated each frame in TickRecursive - this way you can know if an object was already updated
-        mutable vaMatrix4x4                         m_computedWorldTransform                = vaMatrix4x4::Identity;        // Updated each frame in TickRecursive
+        mutable int64                               m_lastSceneTickIndex                    = -1;                           // Scene tick index of the last world transform update (-1 if never updated); see vaScene::UpdateTransformHierarchy
+        mutable vaMatrix4x4                         m_computedWorldTransform                = vaMatrix4x4::Identity;        // Updated in vaScene::UpdateTransformHierarchy when this or any parent's transform changed
         mutable vaBoundingBox                       m_computedLocalBoundingBox              = vaBoundingBox::Degenerate;    // Updated in UpdateLocalBoundingBox from RenderMesh-es and other stuff
         mutable bool                                m_computedLocalBoundingBoxIncomplete    = true;
-        mutable vaBoundingBox                       m_computedGlobalBoundingBox             = vaBoundingBox::Degenerate;    // Updated each frame in TickRecursive
+        mutable vaBoundingBox                       m_computedGlobalBoundingBox             = vaBoundingBox::Degenerate;    // Updated in vaScene::UpdateTransformHierarchy when this or any child's bounds changed
+
+        // position in the scene's flattened transform hierarchy (vaScene::m_hierarchy) and the update queues this object is in
+        int                                         m_hierarchyIndex                        = -1;
+        bool                                        m_transformDirty                        = false;
+        bool                                        m_localBoundsQueued                     = false;
+        bool                                        m_inDynamicList                         = false;
 
         mutable vector<weak_ptr<vaRenderMesh>>      m_cachedRenderMeshes;
+
+        // transform change tracking: an object counts as dynamic while its world transform changed in the last c_dynamicRestTime seconds
+        float                                       m_timeSinceTransformChange              = VA_FLOAT_HIGHEST;
+        bool                                        m_reportedAsStaticCaster                = false;                        // last state reported to the scene (see vaScene::GetShadowCasterChanges)
+        vaBoundingBox                               m_reportedStaticCasterBounds            = vaBoundingBox::Degenerate;
     
     public:
+        static constexpr float                      c_dynamicRestTime                       = 1.0f;
+
         vaSceneObject( );
         virtual ~vaSceneObject( );
 
@@ -80,6 +93,9 @@ namespace Vanilla
         void                                        RegisterChildRemoved( const shared_ptr<vaSceneObject> & child );
         void                                        RegisterUsedAssetPacks( std::function<void( const vaAssetPack & )> registerFunction );
 
+        // resets computed state and sanitizes the transform after m_localTransform/m_renderMeshes were loaded
+        void                                        InitAfterLoad( );
+
         // can't be changed except at creation/destruction time (although it could be added as additional 'ObjectModifier' action)
         void                                        SetParent( const shared_ptr<vaSceneObject> & parent );
 
@@ -94,7 +110,8 @@ namespace Vanilla
         const vector<shared_ptr<vaSceneObject>> &   GetChildren( ) const                                        { return m_children; }
     
         const vaMatrix4x4 &                         GetLocalTransform( ) const                                  { return m_localTransform; }
-        void                                        SetLocalTransform( const vaMatrix4x4 & newTransform )       { m_localTransform = newTransform; }
+        // world transform (and bounds) of this object and its children get updated in the next vaScene::Tick
+        void                                        SetLocalTransform( const vaMatrix4x4 & newTransform );
 
         vaMatrix4x4                                 GetWorldTransform( ) const;
         
@@ -115,7 +132,8 @@ namespace Vanilla
 
         void                                        FindClosestRecursive( const vaVector3 & worldLocation, shared_ptr<vaSceneObject> & currentClosest, float & currentDistance );
 
-        void                                        TickRecursive( vaScene & scene, float deltaTime );
+        // true if the world transform (including through parents) changed recently; objects start as static
+        bool                                        IsDynamic( ) const                                          { return m_timeSinceTransformChange < c_dynamicRestTime; }
 
         bool                                        IsDestroyed( ) const                                        { return m_destroyedButNotYetRemovedFromScene; }
         bool                                        IsBeingCreated( ) const                                     { return m_createdButNotYetAddedToScene; }
@@ -134,6 +152,12 @@ namespace Vanilla
 
         void                                        UpdateLocalBoundingBox( );
 
+        // local bounds get recomputed in the next vaScene::Tick
+        void                                        InvalidateLocalBoundingBox( );
+
+        // reports static <-> dynamic transitions and static bounds changes of this object's own meshes to the scene
+        void                                        UpdateShadowCasterState( vaScene & scene, const vaBoundingBox & ownBounds );
+
     protected:
         virtual string                              UIPropertiesItemGetDisplayName( ) const override                       { return m_name; }
         virtual void                                UIPropertiesItemTick( vaApplicationBase & application ) override;
@@ -197,6 +221,34 @@ namespace Vanilla
 
         vaFogSphere                                 m_fog;
 
+        // accumulated until ClearShadowCasterChanges, see GetShadowCasterChanges
+        vector<vaShadowCasterChange>                m_shadowCasterChanges;
+        vector<vaBoundingBox>                       m_dynamicShadowCasterBounds;
+
+        // Flattened copy of the object hierarchy for transform and bounds updates: objects are ordered by depth (parents always
+        // before children) and children of any object are contiguous. Rebuilt on structural changes (see ApplyDeferredObjectActions);
+        // between those only objects whose transforms or local bounds changed, their subtrees and their ancestors' bounds are updated.
+        struct TransformHierarchy
+        {
+            vector<vaSceneObject *>                 Objects;
+            vector<int>                             Parents;                // -1 for root objects
+            vector<int>                             Levels;                 // depth in the tree, 0 for root objects
+            vector<int>                             FirstChild;
+            vector<int>                             ChildCount;
+            vector<vaMatrix4x4>                     LocalTransforms;
+            vector<vaMatrix4x4>                     WorldTransforms;
+            vector<vaBoundingBox>                   OwnBounds;              // world space AABB of the object's own meshes
+            vector<vaBoundingBox>                   GlobalBounds;           // OwnBounds combined with GlobalBounds of all children
+            vector<uint8>                           Flags;                  // per-update scratch, see UpdateTransformHierarchy
+
+            vector<int>                             DirtyTransforms;        // added to by vaSceneObject::SetLocalTransform
+            vector<int>                             PendingBounds;          // local bounds invalidated or incomplete (assets still loading)
+            vector<int>                             Dynamic;                // objects that moved in the last vaSceneObject::c_dynamicRestTime seconds
+            vector<vector<int>>                     LevelWork;              // per-level list of objects to update (per-update scratch)
+
+            bool                                    StructureDirty          = true;
+        }                                           m_hierarchy;
+
 
     protected:
         // debug UI stuff
@@ -227,9 +279,18 @@ namespace Vanilla
 
         // Save to file
         bool                                        Save( const wstring & fileName );
-        // Load from file
+        // Load from file (either XML or binary, detected from contents)
         bool                                        Load( const wstring & fileName, bool mergeToExisting = false );
 
+        // Versioned binary format: scene settings plus a flat, depth-first object table (parent indices, raw transforms,
+        // names and render mesh IDs) stored as a handful of arrays so loading is a few bulk reads.
+        bool                                        SaveBinary( vaStream & outStream );
+        bool                                        SaveBinary( const wstring & fileName );
+        bool                                        LoadBinary( vaStream & inStream, bool mergeToExisting = false );
+
+        // saves to binary in memory, loads that into a new scene and checks that both give identical XML output
+        bool                                        VerifyBinaryRoundTrip( );
+
         shared_ptr<vaSceneObject>                   CreateObject( const shared_ptr<vaSceneObject> & parent = nullptr );
         shared_ptr<vaSceneObject>                   CreateObject( const string & name, const vaMatrix4x4 & localTransform, const shared_ptr<vaSceneObject> & parent = nullptr );
         shared_ptr<vaSceneObject>                   CreateObject( const string & name, const vaVector3 & localScale, const vaQuaternion & localRot, const vaVector3 & localPos, const shared_ptr<vaSceneObject> & parent = nullptr );
@@ -268,6 +329,11 @@ namespace Vanilla
         void                                        Tick( float deltaTime );
         bool                                        IsInTick( ) const           { return m_isInTick; }
 
+        // static shadow caster changes since the last ClearShadowCasterChanges and the world bounds of all currently dynamic casters (from the last Tick) - for vaLighting::UpdateShadowCasters
+        const vector<vaShadowCasterChange> &        GetShadowCasterChanges( ) const                 { return m_shadowCasterChanges; }
+        void                                        ClearShadowCasterChanges( )                     { m_shadowCasterChanges.clear(); }
+        const vector<vaBoundingBox> &               GetDynamicShadowCasterBounds( ) const           { return m_dynamicShadowCasterBounds; }
+
         vaDrawResultFlags                           SelectForRendering( vaRenderSelection * opaqueList, vaRenderSelection * transparentList, const vaRenderSelection::FilterSettings & filter = vaRenderSelection::FilterSettings(), const SelectionFilterCallback & customFilter = nullptr );
 
         vector<shared_ptr<vaSceneObject>>           FindObjects( std::function<bool(vaSceneObject&obj)> searchCriteria );
@@ -297,9 +363,14 @@ namespace Vanilla
         void                                        RegisterRootObjectRemoved( const shared_ptr<vaSceneObject> & object );
 
         bool                                        SerializeObjectsRecursive( vaXMLSerializer & serializer, const string & name, vector<shared_ptr<vaSceneObject>> & objectList, const shared_ptr<vaSceneObject> & parent );
+        bool                                        SerializeSettings( vaXMLSerializer & serializer, bool mergeToExistingIfLoading );
+        bool                                        SerializeEnvironment( vaXMLSerializer & serializer );
 
         void                                        DestroyObjectImmediate( const shared_ptr<vaSceneObject> & obj, bool recursive );
 
+        void                                        RebuildTransformHierarchy( );
+        void                                        UpdateTransformHierarchy( float deltaTime );
+
         void                                        DrawUI( const vaCameraBase& camera, vaDebugCanvas2D& canvas2D, vaDebugCanvas3D& canvas3D );
 
 
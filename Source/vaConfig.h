@@ -35,4 +35,8 @@
 
 //#define VA_USE_PIX3
 
-//#define VA_INTEL_GRADFILTER_ENABLED
\ No newline at end of file
+//#define VA_INTEL_GRADFILTER_ENABLED
+
+// count global operator new calls (vaMemory::GetAllocationCount) - for checking that steady-state frames don't hit the heap;
+// the per-frame count is shown in the window title / basic frame info and traced as the 'FrameHeapAllocations' counter
+#define VA_MEMORY_ALLOCATION_COUNTING_ENABLED
\ No newline at end of file